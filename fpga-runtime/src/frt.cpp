@@ -4,10 +4,21 @@
 
 #include "frt.h"
 
-#include <fstream>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <glog/logging.h>
 #include <CL/cl2.hpp>
@@ -18,27 +29,39 @@
 
 namespace fpga {
 
-Instance::Instance(const std::string& bitstream) {
+Instance::Instance(const std::string& bitstream, int device_index) {
   LOG(INFO) << "Loading " << bitstream;
   cl::Program::Binaries binaries;
   {
-    std::ifstream stream(bitstream, std::ios::binary);
-    binaries = {{std::istreambuf_iterator<char>(stream),
-                 std::istreambuf_iterator<char>()}};
-  }
+    // Maps the file so that it is copied in bulk rather than by character.
+    int fd = open(bitstream.c_str(), O_RDONLY);
+    PLOG_IF(FATAL, fd < 0) << "Cannot open " << bitstream;
+    struct stat st;
+    PLOG_IF(FATAL, fstat(fd, &st) != 0) << "Cannot stat " << bitstream;
+    const size_t size = st.st_size;
+    const unsigned char* data = nullptr;
+    void* addr = nullptr;
+    if (size > 0) {
+      addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, /*offset=*/0);
+      PLOG_IF(FATAL, addr == MAP_FAILED) << "Cannot map " << bitstream;
+      data = static_cast<const unsigned char*>(addr);
+    }
+    close(fd);
 
-  if ((device_ = internal::XilinxOpenclDevice::New(binaries))) {
-    return;
+    // XOs are read entry by entry from the file, so do not copy them.
+    device_ = internal::TapaFastCosimDevice::New(
+        bitstream,
+        std::string_view(reinterpret_cast<const char*>(data), size));
+    if (device_ == nullptr) binaries = {{data, data + size}};
+    if (addr != nullptr) munmap(addr, size);
+    if (device_ != nullptr) return;
   }
 
-  if ((device_ = internal::IntelOpenclDevice::New(binaries))) {
+  if ((device_ = internal::XilinxOpenclDevice::New(binaries, device_index))) {
     return;
   }
 
-  if ((device_ = internal::TapaFastCosimDevice::New(
-           bitstream,
-           std::string_view(reinterpret_cast<char*>(binaries.begin()->data()),
-                            binaries.begin()->size())))) {
+  if ((device_ = internal::IntelOpenclDevice::New(binaries, device_index))) {
     return;
   }
 
@@ -47,16 +70,58 @@ Instance::Instance(const std::string& bitstream) {
 
 size_t Instance::SuspendBuf(int index) { return device_->SuspendBuffer(index); }
 
+void Instance::MarkDirty(int index, size_t offset, size_t size) {
+  device_->MarkDirty(index, offset, size);
+}
+
+size_t Instance::PeekBuffer(int index, size_t offset, size_t size) {
+  return device_->PeekBuffer(index, offset, size);
+}
+
+void Instance::SetPipelineDepth(size_t depth) {
+  device_->SetPipelineDepth(depth);
+}
+
 void Instance::WriteToDevice() { device_->WriteToDevice(); }
 
 void Instance::ReadFromDevice() { device_->ReadFromDevice(); }
 
 void Instance::Exec() { device_->Exec(); }
 
-void Instance::Finish() { device_->Finish(); }
+void Instance::BeginInvocation() { device_->BeginInvocation(); }
+
+size_t Instance::ComputeUnitCount() const {
+  return device_->GetComputeUnitCount();
+}
+
+void Instance::SetComputeUnit(size_t index) { device_->SetComputeUnit(index); }
+
+Instance& Instance::Relaunch() {
+  BeginInvocation();
+  WriteToDevice();
+  Exec();
+  ReadFromDevice();
+  Finish();
+  return *this;
+}
+
+void Instance::Finish() {
+  device_->Finish();
+  device_->RecordLatencies();
+}
 
 bool Instance::IsFinished() const { return device_->IsFinished(); }
 
+std::future<void> Instance::FinishAsync(std::function<void()> callback) {
+  // Captures the device rather than `this` so the instance may be moved.
+  return std::async(std::launch::async,
+                    [device = device_.get(), callback = std::move(callback)] {
+                      device->Finish();
+                      device->RecordLatencies();
+                      if (callback) callback();
+                    });
+}
+
 std::vector<ArgInfo> Instance::GetArgsInfo() const {
   return device_->GetArgsInfo();
 }
@@ -95,6 +160,18 @@ double Instance::StoreThroughputGbps() const {
          static_cast<double>(StoreTimeNanoSeconds());
 }
 
+std::vector<TransferStats> Instance::GetTransferStats() const {
+  return device_->GetTransferStats();
+}
+
+std::vector<PortStats> Instance::GetPortStats() const {
+  return device_->GetPortStats();
+}
+
+std::vector<HardwareCounters> Instance::GetHardwareCounters() const {
+  return device_->GetHardwareCounters();
+}
+
 void Instance::ConditionallyFinish(bool has_stream) {
   if (!has_stream) {
     VLOG(1) << "no stream found; waiting for command to finish";
@@ -102,4 +179,175 @@ void Instance::ConditionallyFinish(bool has_stream) {
   }
 }
 
+void WriteEventLog(std::ostream& os) { internal::EventLog::Get().Write(os); }
+
+void WriteLatencyMetrics(std::ostream& os) {
+  internal::LatencyStats::Get().WritePrometheus(os);
+}
+
+DevicePool::DevicePool(const std::string& bitstream, int device_count)
+    : in_flight_count_(device_count), invocation_count_(device_count) {
+  CHECK_GT(device_count, 0);
+  instances_.reserve(device_count);
+  for (int i = 0; i < device_count; ++i) {
+    instances_.emplace_back(bitstream, i);
+  }
+}
+
+void DevicePool::SetPipelineDepth(size_t depth) {
+  for (auto& instance : instances_) {
+    instance.SetPipelineDepth(depth);
+  }
+}
+
+void DevicePool::Finish() {
+  for (int i = 0; i < size(); ++i) {
+    if (in_flight_count_[i] > 0) {
+      instances_[i].Finish();
+      in_flight_count_[i] = 0;
+    }
+  }
+}
+
+void DevicePool::Reload(const std::string& bitstream) {
+  FinishReload();
+  LOG(INFO) << "Reloading " << size() << " device(s) with " << bitstream;
+  reload_bitstream_ = bitstream;
+  reload_index_ = 0;
+  AdvanceReload(/*wait=*/false);
+}
+
+void DevicePool::FinishReload() { AdvanceReload(/*wait=*/true); }
+
+void DevicePool::AdvanceReload(bool wait) {
+  while (reload_index_ >= 0) {
+    const int i = reload_index_;
+    if (!reloading_.valid()) {
+      // Invocations in flight run to completion on the old bitstream.
+      if (in_flight_count_[i] > 0) {
+        if (!wait && !instances_[i].IsFinished()) return;
+        instances_[i].Finish();
+        in_flight_count_[i] = 0;
+      }
+      // The old instance releases the device before it is programmed again.
+      reloading_ = std::async(
+          std::launch::async,
+          [old = std::make_unique<Instance>(std::move(instances_[i])),
+           bitstream = reload_bitstream_, i]() mutable {
+            old.reset();
+            return Instance(bitstream, i);
+          });
+    }
+    if (!wait && reloading_.wait_for(std::chrono::seconds(0)) !=
+                     std::future_status::ready) {
+      return;
+    }
+    instances_[i] = reloading_.get();
+    LOG(INFO) << "Reloaded device " << i;
+    reload_index_ = i + 1 < size() ? i + 1 : -1;
+  }
+}
+
+int DevicePool::GetLeastLoadedDevice() {
+  // The only device cannot serve until it is reloaded.
+  AdvanceReload(/*wait=*/size() == 1);
+  int least_loaded = 0;
+  int64_t least_load = -1;
+  for (int i = 0; i < size(); ++i) {
+    if (i == reload_index_) continue;
+    // Devices that are done are idle, but they are still finished by `Finish`
+    // because simulation reads back results there.
+    const int64_t load = in_flight_count_[i] > 0 && instances_[i].IsFinished()
+                             ? 0
+                             : in_flight_count_[i];
+    if (least_load < 0 || load < least_load) {
+      least_loaded = i;
+      least_load = load;
+    }
+  }
+  return least_loaded;
+}
+
+InvocationQueue::InvocationQueue(const std::string& bitstream,
+                                 int device_count, size_t pipeline_depth,
+                                 size_t capacity)
+    : pool_(bitstream, device_count),
+      pipeline_depth_(pipeline_depth),
+      capacity_(capacity) {
+  CHECK_GT(pipeline_depth, 0);
+  CHECK_GT(capacity, 0);
+  pool_.SetPipelineDepth(pipeline_depth);
+  workers_.reserve(device_count);
+  for (int i = 0; i < device_count; ++i) {
+    workers_.emplace_back(&InvocationQueue::Serve, this, i);
+  }
+}
+
+InvocationQueue::~InvocationQueue() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stopping_ = true;
+  }
+  not_empty_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+size_t InvocationQueue::size() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return requests_.size();
+}
+
+std::future<void> InvocationQueue::Enqueue(Invocation invocation, bool wait) {
+  std::future<void> future;
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    const auto has_room = [this] { return requests_.size() < capacity_; };
+    if (wait) {
+      not_full_.wait(lock, has_room);
+    } else if (!has_room()) {
+      return future;
+    }
+    Request& request = requests_.emplace_back();
+    request.invocation = std::move(invocation);
+    future = request.promise.get_future();
+  }
+  not_empty_.notify_one();
+  return future;
+}
+
+void InvocationQueue::Serve(int index) {
+  Instance& instance = pool_[index];
+  std::vector<Request> batch;
+  batch.reserve(pipeline_depth_);
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      not_empty_.wait(lock, [this] { return stopping_ || !requests_.empty(); });
+      if (requests_.empty()) return;
+      while (!requests_.empty() && batch.size() < pipeline_depth_) {
+        batch.push_back(std::move(requests_.front()));
+        requests_.pop_front();
+      }
+    }
+    not_full_.notify_all();
+
+    try {
+      for (auto& request : batch) {
+        request.invocation(instance);
+      }
+      instance.Finish();
+      for (auto& request : batch) {
+        request.promise.set_value();
+      }
+    } catch (...) {
+      for (auto& request : batch) {
+        request.promise.set_exception(std::current_exception());
+      }
+    }
+    batch.clear();
+  }
+}
+
 }  // namespace fpga
@@ -9,10 +9,17 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <ratio>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -20,10 +27,16 @@
 #include "frt/arg_info.h"
 #include "frt/buffer.h"
 #include "frt/device.h"
+#include "frt/event_log.h"
+#include "frt/hw_counters.h"
+#include "frt/latency_stats.h"
+#include "frt/port_stats.h"
 #include "frt/stream.h"
 #include "frt/stream_arg.h"
+#include "frt/stream_pump.h"
 #include "frt/stringify.h"  // IWYU pragma: export
 #include "frt/tag.h"
+#include "frt/transfer_stats.h"
 
 namespace fpga {
 
@@ -35,6 +48,14 @@ template <typename T>
 using ReadWriteBuffer = internal::Buffer<T, internal::Tag::kReadWrite>;
 template <typename T>
 using PlaceholderBuffer = internal::Buffer<T, internal::Tag::kPlaceHolder>;
+template <typename T>
+using ScratchBuffer = internal::Buffer<T, internal::Tag::kScratch>;
+template <typename T>
+using InitOnceBuffer = internal::Buffer<T, internal::Tag::kInitOnce>;
+template <typename T>
+using ReadBackLastBuffer = internal::Buffer<T, internal::Tag::kReadBackLast>;
+template <typename T>
+using HostOnlyBuffer = internal::Buffer<T, internal::Tag::kHostOnly>;
 
 template <typename T>
 ReadOnlyBuffer<T> ReadOnly(T* ptr, size_t n) {
@@ -52,6 +73,22 @@ template <typename T>
 PlaceholderBuffer<T> Placeholder(T* ptr, size_t n) {
   return PlaceholderBuffer<T>(ptr, n);
 }
+template <typename T>
+ScratchBuffer<T> Scratch(T* ptr, size_t n) {
+  return ScratchBuffer<T>(ptr, n);
+}
+template <typename T>
+InitOnceBuffer<T> InitOnce(T* ptr, size_t n) {
+  return InitOnceBuffer<T>(ptr, n);
+}
+template <typename T>
+ReadBackLastBuffer<T> ReadBackLast(T* ptr, size_t n) {
+  return ReadBackLastBuffer<T>(ptr, n);
+}
+template <typename T>
+HostOnlyBuffer<T> HostOnly(T* ptr, size_t n) {
+  return HostOnlyBuffer<T>(ptr, n);
+}
 
 template <typename T>
 using ReadStream = internal::Stream<T, internal::Tag::kReadOnly>;
@@ -60,7 +97,9 @@ using WriteStream = internal::Stream<T, internal::Tag::kWriteOnly>;
 
 class Instance {
  public:
-  Instance(const std::string& bitstream);
+  // Loads `bitstream` onto the `device_index`-th device that matches it.
+  // Simulation ignores `device_index`; each instance simulates on its own.
+  Instance(const std::string& bitstream, int device_index = 0);
 
   // Move-only.
   Instance(Instance&&) = default;
@@ -78,6 +117,21 @@ class Instance {
     device_->SetBufferArg(index, tag, arg);
   }
 
+  // Registers a buffer so that it is allocated and pinned on the device once,
+  // and reused whenever a buffer argument with the same host memory and tag
+  // is set, until it is unregistered. A buffer argument that is set again
+  // with unchanged host memory and tag is reused even if not registered.
+  template <typename T, internal::Tag tag>
+  void RegisterBuffer(internal::Buffer<T, tag> buf) {
+    device_->RegisterBuffer(tag, buf);
+  }
+
+  // Unregisters a buffer registered by `RegisterBuffer`.
+  template <typename T, internal::Tag tag>
+  void UnregisterBuffer(internal::Buffer<T, tag> buf) {
+    device_->UnregisterBuffer(tag, buf);
+  }
+
   // Sets a stream argument.
   template <typename T, internal::Tag tag>
   void SetArg(int index, internal::Stream<T, tag>& arg) {
@@ -94,6 +148,23 @@ class Instance {
   // returns the number of transfer operations suspended.
   size_t SuspendBuf(int index);
 
+  // Marks `size` bytes of buffer `index` starting at `offset` as modified.
+  // Once a buffer is marked, `WriteToDevice` and the following
+  // `ReadFromDevice` only transfer the ranges marked since the previous
+  // `WriteToDevice`, so that a buffer reused across invocations is not
+  // transferred as a whole each time. Setting the buffer argument again
+  // transfers the whole buffer, or its `Range` if set.
+  void MarkDirty(int index, size_t offset, size_t size);
+
+  // Copies `size` bytes of buffer `index` starting at `offset` from the
+  // device to the host while the program may still be running, and returns
+  // the number of bytes the program has written to the buffer so far. A
+  // program writing its output once and in order has thus completed the
+  // first that many bytes, so the host can check them early and give up on a
+  // failing run. Only TAPA fast cosim with buffers in shared memory supports
+  // this.
+  size_t PeekBuffer(int index, size_t offset, size_t size);
+
   // Writes buffers to the device.
   void WriteToDevice();
 
@@ -103,21 +174,67 @@ class Instance {
   // Executes the program on the device.
   void Exec();
 
+  // Runs the program again with the arguments already set, and waits for it
+  // to finish. Arguments keep their bindings, so only scalars changed by
+  // `SetArg` since the last run are set again. Suspend buffers or mark dirty
+  // ranges to avoid transferring buffers the run does not change.
+  Instance& Relaunch();
+
   // Waits for the program to finish.
   void Finish();
 
   // Returns whether the program has finished.
   bool IsFinished() const;
 
-  // Invokes the program on the device. This is a shortcut for `SetArgs`,
-  // `WriteToDevice`, `Exec`, `ReadFromDevice`, and if there is no stream
-  // arguments, `Finish` as well.
+  // Waits for the program to finish on a separate thread and returns a future
+  // that becomes ready afterwards, so that the host can do other work in the
+  // meantime. If `callback` is set, it is called on that thread once the
+  // program finishes, before the future becomes ready. The instance must not
+  // be otherwise used or destroyed until the future is ready.
+  std::future<void> FinishAsync(std::function<void()> callback = nullptr);
+
+  // Sets the maximum number of invocations in flight via `InvokeAsync`.
+  // Defaults to 1. With a depth of 2 or 3, the transfer of one batch overlaps
+  // the computation of the previous one.
+  void SetPipelineDepth(size_t depth);
+
+  // Waits until fewer than the pipeline depth invocations are in flight, so
+  // that the arguments of the next invocation may be set, e.g., one by one,
+  // before `WriteToDevice`, `Exec`, and `ReadFromDevice`.
+  void BeginInvocation();
+
+  // Returns the number of compute units of the program, i.e., the number of
+  // instances of each kernel placed on the device. Simulation has only one.
+  size_t ComputeUnitCount() const;
+
+  // Runs the following invocations on the `index`-th compute unit, so that
+  // invocations in flight on different compute units run concurrently and
+  // each is timed by itself. Each compute unit keeps its own arguments, so
+  // set all of them again, e.g., with `InvokeAsync`, after switching. By
+  // default, invocations run on the first compute unit.
+  void SetComputeUnit(size_t index);
+
+  // Invokes the program on the device without waiting for it to finish. This
+  // first waits until fewer than the pipeline depth invocations are in flight,
+  // and then is a shortcut for `SetArgs`, `WriteToDevice`, `Exec`, and
+  // `ReadFromDevice`. Invocations in flight must not share host buffers; the
+  // usual pattern is to rotate among as many buffer sets as the pipeline
+  // depth. Call `Finish` to wait for all invocations.
   template <typename... Args>
-  Instance& Invoke(Args&&... args) {
+  Instance& InvokeAsync(Args&&... args) {
+    BeginInvocation();
     SetArgs(std::forward<Args>(args)...);
     WriteToDevice();
     Exec();
     ReadFromDevice();
+    return *this;
+  }
+
+  // Invokes the program on the device. This is a shortcut for `InvokeAsync`
+  // and, if there is no stream arguments, `Finish` as well.
+  template <typename... Args>
+  Instance& Invoke(Args&&... args) {
+    InvokeAsync(std::forward<Args>(args)...);
     bool has_stream = false;
     bool _[sizeof...(Args)] = {(
         has_stream |=
@@ -154,6 +271,23 @@ class Instance {
   // Returns the store throughput in GB/s.
   double StoreThroughputGbps() const;
 
+  // Returns the transfer statistics of each buffer argument in the last
+  // invocation, sorted by the index, to find which buffers limit the
+  // host-device throughput.
+  std::vector<TransferStats> GetTransferStats() const;
+
+  // Returns the simulated traffic on the port of each mmap and stream
+  // argument in the last invocation, sorted by the index, to find which
+  // ports limit the kernel. Only TAPA fast cosim reports these; other devices
+  // return an empty vector.
+  std::vector<PortStats> GetPortStats() const;
+
+  // Returns the hardware counters of each monitored stream and mmap of the
+  // top-level task in the last invocation. Only kernels synthesized with
+  // `tapa synth --hw-counter` and running on Xilinx boards report these;
+  // other devices return an empty vector.
+  std::vector<HardwareCounters> GetHardwareCounters() const;
+
  private:
   template <typename T, typename... Args>
   void SetArg(int index, T&& arg, Args&&... other_args) {
@@ -166,6 +300,170 @@ class Instance {
   std::unique_ptr<internal::Device> device_;
 };
 
+// Loads the same bitstream onto several devices and dispatches each invocation
+// to the device with the fewest invocations in flight, so that independent
+// batches scale with the number of devices.
+class DevicePool {
+ public:
+  // Loads `bitstream` onto the first `device_count` matching devices.
+  DevicePool(const std::string& bitstream, int device_count);
+
+  // Move-only.
+  DevicePool(DevicePool&&) = default;
+  DevicePool& operator=(DevicePool&&) = default;
+
+  // Sets the pipeline depth of each device; see `Instance::SetPipelineDepth`.
+  void SetPipelineDepth(size_t depth);
+
+  // Invokes the program on the least-loaded device without waiting for it to
+  // finish, and returns the index of that device. Invocations in flight must
+  // not share host buffers.
+  template <typename... Args>
+  int InvokeAsync(Args&&... args) {
+    const int index = GetLeastLoadedDevice();
+    instances_[index].InvokeAsync(std::forward<Args>(args)...);
+    ++in_flight_count_[index];
+    ++invocation_count_[index];
+    return index;
+  }
+
+  // Waits for the invocations on all devices to finish.
+  void Finish();
+
+  // Replaces the bitstream of all devices with `bitstream` without stopping
+  // the pool, e.g., to upgrade the kernel while serving. Devices are reloaded
+  // one at a time: a device stops taking new invocations, finishes those in
+  // flight, and is reprogrammed on a separate thread while the others keep
+  // serving. This returns immediately; the reload makes progress whenever
+  // invocations are dispatched, and each invocation runs entirely on either
+  // the old or the new bitstream. A pool of one device cannot serve during
+  // its reload, so invocations wait for it.
+  void Reload(const std::string& bitstream);
+
+  // Returns whether a reload started by `Reload` is in progress.
+  bool IsReloading() const { return reload_index_ >= 0; }
+
+  // Waits for the reload started by `Reload` to complete.
+  void FinishReload();
+
+  // Returns the number of devices.
+  int size() const { return instances_.size(); }
+
+  // Returns the instance of the `index`-th device, e.g., for its statistics
+  // of the last invocation on it. The instance of a device being reloaded
+  // must not be used.
+  Instance& operator[](int index) { return instances_[index]; }
+  const Instance& operator[](int index) const { return instances_[index]; }
+
+  // Returns the number of invocations dispatched to the `index`-th device.
+  int64_t InvocationCount(int index) const { return invocation_count_[index]; }
+
+ private:
+  int GetLeastLoadedDevice();
+
+  // Moves the reload forward as far as possible, waiting for the device
+  // being reloaded if `wait`.
+  void AdvanceReload(bool wait);
+
+  std::vector<Instance> instances_;
+  // Invocations dispatched to each device since the last `Finish`.
+  std::vector<int64_t> in_flight_count_;
+  std::vector<int64_t> invocation_count_;
+
+  // Bitstream of the reload in progress, the index of the device being
+  // reloaded, or -1 if none, and the instance it is being reloaded into,
+  // which is invalid while the device is still finishing invocations.
+  std::string reload_bitstream_;
+  int reload_index_ = -1;
+  std::future<Instance> reloading_;
+};
+
+// Accepts invocations from many threads, e.g., request handlers of a server,
+// and runs them on the devices of a pool. Each device is served by its own
+// thread, which takes up to the pipeline depth of waiting invocations at a
+// time and keeps them in flight together, so that the transfers of one
+// overlap the computation of another. Up to `capacity` invocations may wait
+// for a device; more are not admitted until some are taken.
+class InvocationQueue {
+ public:
+  // Loads `bitstream` onto the first `device_count` matching devices.
+  InvocationQueue(const std::string& bitstream, int device_count = 1,
+                  size_t pipeline_depth = 2, size_t capacity = 64);
+
+  // Waits for the admitted invocations to finish.
+  ~InvocationQueue();
+
+  // Not copyable or movable.
+  InvocationQueue(const InvocationQueue&) = delete;
+  InvocationQueue& operator=(const InvocationQueue&) = delete;
+
+  // Admits an invocation with `args`, waiting while the queue is at capacity,
+  // and returns a future that becomes ready once it finishes and its buffers
+  // are read back, or holds the exception it failed with. Arguments are
+  // copied, so buffers refer to host memory that must stay valid until then,
+  // and must not be shared with other invocations in flight. Stream
+  // arguments are not supported.
+  template <typename... Args>
+  std::future<void> Submit(Args&&... args) {
+    return Enqueue(MakeInvocation(std::forward<Args>(args)...), /*wait=*/true);
+  }
+
+  // Same as `Submit`, but returns an invalid future instead of waiting if the
+  // queue is at capacity, so that a server can reject the request.
+  template <typename... Args>
+  std::future<void> TrySubmit(Args&&... args) {
+    return Enqueue(MakeInvocation(std::forward<Args>(args)...), /*wait=*/false);
+  }
+
+  // Returns the number of invocations waiting for a device.
+  size_t size() const;
+
+ private:
+  using Invocation = std::function<void(Instance&)>;
+
+  struct Request {
+    Invocation invocation;
+    std::promise<void> promise;
+  };
+
+  template <typename... Args>
+  static Invocation MakeInvocation(Args&&... args) {
+    return [args = std::make_tuple(std::forward<Args>(args)...)](
+               Instance& instance) mutable {
+      std::apply([&instance](auto&... args) { instance.InvokeAsync(args...); },
+                 args);
+    };
+  }
+
+  std::future<void> Enqueue(Invocation invocation, bool wait);
+
+  // Runs waiting invocations on the `index`-th device until destruction.
+  void Serve(int index);
+
+  DevicePool pool_;
+  const size_t pipeline_depth_;
+  const size_t capacity_;
+
+  mutable std::mutex mtx_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<Request> requests_;
+  bool stopping_ = false;
+
+  std::vector<std::thread> workers_;
+};
+
+// Writes the latest runtime events of all instances in this process, e.g.,
+// buffers transferred and kernels run, as JSON lines with nanosecond
+// timestamps. Set `TAPA_EVENT_LOG` to the path to write them to at exit.
+void WriteEventLog(std::ostream& os);
+
+// Writes the latency distributions of the load, compute, and store phases of
+// all invocations finished on each device in this process, e.g., their p99,
+// as Prometheus summaries in the text exposition format, so that a server can
+// serve them to be scraped and alerted on.
+void WriteLatencyMetrics(std::ostream& os);
+
 template <typename Arg, typename... Args>
 Instance Invoke(const std::string& bitstream, Arg&& arg, Args&&... args) {
   return std::move(Instance(bitstream).Invoke(std::forward<Arg>(arg),
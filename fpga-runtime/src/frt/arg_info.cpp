@@ -4,10 +4,70 @@
 
 #include "frt/arg_info.h"
 
+#include <cstdint>
+#include <cstdlib>
+
+#include <istream>
+#include <optional>
 #include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
 
 namespace fpga {
 
+namespace {
+
+// First line of the metadata, followed by the size of the xo file.
+constexpr char kArgsFileMagic[] = "tapa-args-v1";
+
+}  // namespace
+
+ArgInfo::Cat GetArgCat(int address_qualifier) {
+  switch (address_qualifier) {
+    case 0:
+      return ArgInfo::kScalar;
+    case 1:
+      return ArgInfo::kMmap;
+    case 4:
+      return ArgInfo::kStream;
+  }
+  LOG(WARNING) << "Unknown argument category: " << address_qualifier;
+  return ArgInfo::kScalar;
+}
+
+// Each argument is on its own line as tab-separated `id`, `addressQualifier`,
+// `name`, and `type`, the same as in `kernel.xml`.
+std::optional<std::vector<ArgInfo>> ParseArgsFile(std::istream& is,
+                                                  uint64_t xo_size) {
+  std::string magic;
+  uint64_t size;
+  if (!(is >> magic >> size) || magic != kArgsFileMagic || size != xo_size) {
+    return std::nullopt;
+  }
+  is.ignore(1);  // The newline after the header.
+
+  std::vector<ArgInfo> args;
+  for (std::string line; std::getline(is, line);) {
+    std::istringstream fields(line);
+    std::string index, address_qualifier;
+    ArgInfo arg;
+    if (!std::getline(fields, index, '\t') ||
+        !std::getline(fields, address_qualifier, '\t') ||
+        !std::getline(fields, arg.name, '\t') ||
+        !std::getline(fields, arg.type)) {
+      return std::nullopt;
+    }
+    arg.index = std::atoi(index.c_str());
+    if (arg.index != static_cast<int>(args.size())) return std::nullopt;
+    arg.cat = GetArgCat(std::atoi(address_qualifier.c_str()));
+    args.push_back(arg);
+  }
+  return args;
+}
+
 std::ostream& operator<<(std::ostream& os, const ArgInfo::Cat& cat) {
   switch (cat) {
     case ArgInfo::kScalar:
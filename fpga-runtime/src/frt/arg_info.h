@@ -5,8 +5,13 @@
 #ifndef FPGA_RUNTIME_ARG_INFO_H_
 #define FPGA_RUNTIME_ARG_INFO_H_
 
+#include <cstdint>
+
+#include <istream>
+#include <optional>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace fpga {
 
@@ -22,6 +27,16 @@ struct ArgInfo {
   Cat cat;
 };
 
+// Returns the category of an argument with `addressQualifier` in `kernel.xml`.
+ArgInfo::Cat GetArgCat(int address_qualifier);
+
+// Parses the argument metadata that `tapa pack` writes next to an xo file of
+// `xo_size` bytes, which saves extracting and parsing `kernel.xml` from it.
+// Returns `std::nullopt` if the metadata is malformed or written for another
+// xo file.
+std::optional<std::vector<ArgInfo>> ParseArgsFile(std::istream& is,
+                                                  uint64_t xo_size);
+
 std::ostream& operator<<(std::ostream& os, const ArgInfo::Cat& cat);
 std::ostream& operator<<(std::ostream& os, const ArgInfo& arg);
 
@@ -0,0 +1,55 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/arg_info.h"
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+namespace fpga {
+namespace {
+
+TEST(ArgInfoTest, ParseArgsFile) {
+  std::istringstream is(
+      "tapa-args-v1 1234\n"
+      "0\t1\ta\tfloat*\n"
+      "1\t4\tb\tstream<ap_uint<512>, 2>\n"
+      "2\t0\tn\tuint64_t\n");
+  auto args = ParseArgsFile(is, 1234);
+  ASSERT_TRUE(args.has_value());
+  ASSERT_EQ(args->size(), 3);
+  EXPECT_EQ((*args)[0].index, 0);
+  EXPECT_EQ((*args)[0].name, "a");
+  EXPECT_EQ((*args)[0].type, "float*");
+  EXPECT_EQ((*args)[0].cat, ArgInfo::kMmap);
+  EXPECT_EQ((*args)[1].type, "stream<ap_uint<512>, 2>");
+  EXPECT_EQ((*args)[1].cat, ArgInfo::kStream);
+  EXPECT_EQ((*args)[2].name, "n");
+  EXPECT_EQ((*args)[2].cat, ArgInfo::kScalar);
+}
+
+TEST(ArgInfoTest, ParseArgsFileWithoutArgs) {
+  std::istringstream is("tapa-args-v1 1234\n");
+  auto args = ParseArgsFile(is, 1234);
+  ASSERT_TRUE(args.has_value());
+  EXPECT_TRUE(args->empty());
+}
+
+TEST(ArgInfoTest, ParseArgsFileForAnotherXo) {
+  std::istringstream is("tapa-args-v1 1234\n0\t1\ta\tfloat*\n");
+  EXPECT_FALSE(ParseArgsFile(is, 4321).has_value());
+}
+
+TEST(ArgInfoTest, ParseMalformedArgsFile) {
+  std::istringstream wrong_magic("tapa-args-v0 1234\n");
+  EXPECT_FALSE(ParseArgsFile(wrong_magic, 1234).has_value());
+  std::istringstream missing_field("tapa-args-v1 1234\n0\t1\ta\n");
+  EXPECT_FALSE(ParseArgsFile(missing_field, 1234).has_value());
+  std::istringstream wrong_index("tapa-args-v1 1234\n1\t1\ta\tfloat*\n");
+  EXPECT_FALSE(ParseArgsFile(wrong_index, 1234).has_value());
+}
+
+}  // namespace
+}  // namespace fpga
@@ -19,11 +19,27 @@ namespace internal {
 template <typename T, Tag tag>
 class Buffer {
  public:
-  Buffer(T* ptr, size_t n) : ptr_(ptr), n_(n) {}
+  Buffer(T* ptr, size_t n)
+      : ptr_(ptr), n_(n), range_offset_(0), range_size_(n * sizeof(T)) {}
   T* Get() const { return ptr_; }
   size_t Size() const { return n_; }
   size_t SizeInBytes() const { return n_ * sizeof(T); }
 
+  // Returns the byte range transferred between host and device, which is the
+  // whole buffer unless set by `Range`.
+  size_t RangeOffsetInBytes() const { return range_offset_; }
+  size_t RangeSizeInBytes() const { return range_size_; }
+
+  // Returns the buffer with only the `len` elements starting at `off`
+  // transferred between host and device, e.g., when a kernel only updates a
+  // window of a large array. The kernel still sees the whole buffer. Xilinx
+  // devices widen the range to their sub-buffer alignment.
+  Buffer Range(size_t off, size_t len) const {
+    CHECK_LE(off, n_);
+    CHECK_LE(len, n_ - off);
+    return Buffer(ptr_, n_, off * sizeof(T), len * sizeof(T));
+  }
+
   template <typename U>
   Buffer<U, tag> Reinterpret() const {
     static_assert(std::is_standard_layout<T>::value,
@@ -57,12 +73,24 @@ class Buffer {
            "`Reinterpret<U>()`) because alignof(U) = "
         << alignof(U);
     return Buffer<U, tag>(reinterpret_cast<U*>(Get()),
-                          Size() * sizeof(T) / sizeof(U));
+                          Size() * sizeof(T) / sizeof(U), range_offset_,
+                          range_size_);
   }
 
  private:
+  template <typename U, Tag>
+  friend class Buffer;
+
+  Buffer(T* ptr, size_t n, size_t range_offset, size_t range_size)
+      : ptr_(ptr),
+        n_(n),
+        range_offset_(range_offset),
+        range_size_(range_size) {}
+
   T* const ptr_;
   const size_t n_;
+  const size_t range_offset_;
+  const size_t range_size_;
 };
 
 }  // namespace internal
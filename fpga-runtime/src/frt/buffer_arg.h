@@ -19,7 +19,9 @@ class BufferArg {
   BufferArg(Buffer<T, tag> buffer)
       : ptr_(const_cast<char*>(reinterpret_cast<const char*>(buffer.Get()))),
         size_(sizeof(T)),
-        n_(buffer.SizeInBytes() / sizeof(T)) {}
+        n_(buffer.SizeInBytes() / sizeof(T)),
+        range_offset_(buffer.RangeOffsetInBytes()),
+        range_size_(buffer.RangeSizeInBytes()) {}
 
   BufferArg() = default;
   BufferArg(const BufferArg&) = default;
@@ -30,11 +32,15 @@ class BufferArg {
   char* Get() const { return ptr_; }
   size_t SizeInCount() const { return n_; }
   size_t SizeInBytes() const { return size_ * n_; }
+  size_t RangeOffsetInBytes() const { return range_offset_; }
+  size_t RangeSizeInBytes() const { return range_size_; }
 
  private:
   char* ptr_;
   size_t size_;
   size_t n_;
+  size_t range_offset_;
+  size_t range_size_;
 };
 
 }  // namespace internal
@@ -113,5 +113,36 @@ TEST_F(BufferTest, ReinterpretAsWiderTypeWithUnalignedDataFails) {
                "data of Buffer<T> must be 8-byte aligned");
 }
 
+TEST_F(BufferTest, RangeDefaultsToWholeBuffer) {
+  auto buf = fpga::ReadOnly(elements_.data(), elements_.size());
+
+  EXPECT_EQ(buf.RangeOffsetInBytes(), 0);
+  EXPECT_EQ(buf.RangeSizeInBytes(), buf.SizeInBytes());
+}
+
+TEST_F(BufferTest, RangeKeepsWholeBufferAndSetsTransferRange) {
+  auto buf = fpga::WriteOnly(elements_.data(), elements_.size()).Range(2, 5);
+
+  EXPECT_EQ(buf.Get(), elements_.data());
+  EXPECT_EQ(buf.Size(), elements_.size());
+  EXPECT_EQ(buf.RangeOffsetInBytes(), 2 * sizeof(float));
+  EXPECT_EQ(buf.RangeSizeInBytes(), 5 * sizeof(float));
+}
+
+TEST_F(BufferTest, RangeIsKeptByReinterpret) {
+  auto buf = fpga::ReadWrite(elements_.data(), elements_.size())
+                 .Range(1, 3)
+                 .Reinterpret<uint16_t>();
+
+  EXPECT_EQ(buf.RangeOffsetInBytes(), 1 * sizeof(float));
+  EXPECT_EQ(buf.RangeSizeInBytes(), 3 * sizeof(float));
+}
+
+TEST_F(BufferTest, RangeBeyondBufferFails) {
+  auto buf = fpga::ReadOnly(elements_.data(), elements_.size());
+
+  EXPECT_DEATH(buf.Range(8, 3), "");
+}
+
 }  // namespace
 }  // namespace fpga::internal
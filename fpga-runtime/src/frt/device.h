@@ -12,8 +12,13 @@
 
 #include "frt/arg_info.h"
 #include "frt/buffer_arg.h"
+#include "frt/event_log.h"
+#include "frt/hw_counters.h"
+#include "frt/latency_stats.h"
+#include "frt/port_stats.h"
 #include "frt/stream_arg.h"
 #include "frt/tag.h"
+#include "frt/transfer_stats.h"
 
 namespace fpga {
 namespace internal {
@@ -24,8 +29,16 @@ class Device {
 
   virtual void SetScalarArg(int index, const void* arg, int size) = 0;
   virtual void SetBufferArg(int index, Tag tag, const BufferArg& arg) = 0;
+  virtual void RegisterBuffer(Tag tag, const BufferArg& arg) = 0;
+  virtual void UnregisterBuffer(Tag tag, const BufferArg& arg) = 0;
   virtual void SetStreamArg(int index, Tag tag, StreamArg& arg) = 0;
   virtual size_t SuspendBuffer(int index) = 0;
+  virtual void MarkDirty(int index, size_t offset, size_t size) = 0;
+  virtual size_t PeekBuffer(int index, size_t offset, size_t size) = 0;
+  virtual void SetPipelineDepth(size_t depth) = 0;
+  virtual void BeginInvocation() = 0;
+  virtual size_t GetComputeUnitCount() const = 0;
+  virtual void SetComputeUnit(size_t index) = 0;
 
   virtual void WriteToDevice() = 0;
   virtual void ReadFromDevice() = 0;
@@ -39,6 +52,30 @@ class Device {
   virtual int64_t StoreTimeNanoSeconds() const = 0;
   virtual size_t LoadBytes() const = 0;
   virtual size_t StoreBytes() const = 0;
+  virtual std::vector<TransferStats> GetTransferStats() const = 0;
+  virtual std::vector<PortStats> GetPortStats() const = 0;
+  virtual std::vector<HardwareCounters> GetHardwareCounters() const = 0;
+
+  // Records the latencies of the invocation that just finished in
+  // `LatencyStats::Get()`. Phases that took no time, e.g., without buffers to
+  // transfer, are not recorded.
+  void RecordLatencies() const {
+    const auto record = [this](LatencyStats::Phase phase, int64_t ns) {
+      if (ns > 0) LatencyStats::Get().Record(device_id_, phase, ns);
+    };
+    record(LatencyStats::kLoad, LoadTimeNanoSeconds());
+    record(LatencyStats::kCompute, ComputeTimeNanoSeconds());
+    record(LatencyStats::kStore, StoreTimeNanoSeconds());
+  }
+
+ protected:
+  // Records an event of this device in `EventLog::Get()`.
+  void LogEvent(EventLog::Kind kind, int index = -1, uint64_t bytes = 0) {
+    EventLog::Get().Record(device_id_, kind, index, bytes);
+  }
+
+ private:
+  const int device_id_ = EventLog::Get().AddDevice();
 };
 
 }  // namespace internal
@@ -7,9 +7,11 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <elf.h>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <tinyxml2.h>
 #include <CL/cl2.hpp>
@@ -19,6 +21,11 @@
 #include "frt/stream_arg.h"
 #include "frt/tag.h"
 
+DEFINE_bool(iocl_use_host_ptr, false,
+            "if true, create buffers on host memory and migrate them like "
+            "Xilinx devices instead of copying; host memory should be "
+            "64-byte aligned");
+
 namespace fpga {
 namespace internal {
 
@@ -50,7 +57,8 @@ class DeviceMatcher : public OpenclDeviceMatcher {
 
 }  // namespace
 
-IntelOpenclDevice::IntelOpenclDevice(const cl::Program::Binaries& binaries) {
+IntelOpenclDevice::IntelOpenclDevice(
+    const cl::Program::Binaries& binaries, int device_index) {
   std::string target_device_name;
   std::string vendor_name;
   std::vector<std::string> kernel_names;
@@ -134,16 +142,16 @@ IntelOpenclDevice::IntelOpenclDevice(const cl::Program::Binaries& binaries) {
   }
 
   Initialize(binaries, vendor_name, DeviceMatcher(target_device_name),
-             kernel_names, kernel_arg_counts);
+             device_index, kernel_names, kernel_arg_counts);
 }
 
 std::unique_ptr<Device> IntelOpenclDevice::New(
-    const cl::Program::Binaries& binaries) {
+    const cl::Program::Binaries& binaries, int device_index) {
   if (binaries.size() != 1 || binaries.begin()->size() < SELFMAG ||
       memcmp(binaries.begin()->data(), ELFMAG, SELFMAG) != 0) {
     return nullptr;
   }
-  return std::make_unique<IntelOpenclDevice>(binaries);
+  return std::make_unique<IntelOpenclDevice>(binaries, device_index);
 }
 
 void IntelOpenclDevice::SetStreamArg(int index, Tag tag, StreamArg& arg) {
@@ -151,37 +159,83 @@ void IntelOpenclDevice::SetStreamArg(int index, Tag tag, StreamArg& arg) {
 };
 
 void IntelOpenclDevice::WriteToDevice() {
-  load_event_.resize(load_indices_.size());
-  int i = 0;
+  BeginTransfer();
+  load_event_.clear();
+  load_transfers_.clear();
+  AllocateScratchBuffers();
   for (auto index : load_indices_) {
+    auto& transfer = load_transfers_[index];
+    for (const auto& region : GetTransferRegions(index)) {
+      transfer.bytes += region.size;
+    }
+    if (FLAGS_iocl_use_host_ptr) {
+      std::vector<cl::Memory> buffers;
+      for (auto& buffer : GetTransferBuffers(index)) {
+        buffers.push_back(std::move(buffer));
+      }
+      if (buffers.empty()) continue;
+      CL_CHECK(cmd_.enqueueMigrateMemObjects(buffers, /* flags = */ 0,
+                                             /* events = */ nullptr,
+                                             &load_event_.emplace_back()));
+      transfer.events.push_back(load_event_.back());
+      continue;
+    }
     auto buffer = buffer_table_[index];
-    CL_CHECK(cmd_.enqueueWriteBuffer(
-        buffer, /* blocking = */ CL_FALSE, /* offset = */ 0,
-        buffer.getInfo<CL_MEM_SIZE>(), host_ptr_table_[index],
-        /* events = */ nullptr, &load_event_[i]));
-    ++i;
+    auto host_ptr = static_cast<char*>(buffer_key_table_.at(index).host_ptr);
+    for (const auto& region : GetTransferRegions(index)) {
+      CL_CHECK(cmd_.enqueueWriteBuffer(
+          buffer, /* blocking = */ CL_FALSE, region.origin, region.size,
+          host_ptr + region.origin,
+          /* events = */ nullptr, &load_event_.emplace_back()));
+      transfer.events.push_back(load_event_.back());
+    }
   }
+  LogTransfers(EventLog::kLoad, load_transfers_);
 }
 
 void IntelOpenclDevice::ReadFromDevice() {
-  store_event_.resize(store_indices_.size());
-  int i = 0;
+  store_event_.clear();
+  store_transfers_.clear();
   for (auto index : store_indices_) {
+    auto& transfer = store_transfers_[index];
+    for (const auto& region : GetTransferRegions(index)) {
+      transfer.bytes += region.size;
+    }
+    if (FLAGS_iocl_use_host_ptr) {
+      std::vector<cl::Memory> buffers;
+      for (auto& buffer : GetTransferBuffers(index)) {
+        buffers.push_back(std::move(buffer));
+      }
+      if (buffers.empty()) continue;
+      CL_CHECK(cmd_.enqueueMigrateMemObjects(
+          buffers, CL_MIGRATE_MEM_OBJECT_HOST, &compute_event_,
+          &store_event_.emplace_back()));
+      transfer.events.push_back(store_event_.back());
+      continue;
+    }
     auto buffer = buffer_table_[index];
-    cmd_.enqueueReadBuffer(buffer, /* blocking = */ CL_FALSE,
-                           /* offset = */ 0, buffer.getInfo<CL_MEM_SIZE>(),
-                           host_ptr_table_[index], &compute_event_,
-                           &store_event_[i]);
-    ++i;
+    auto host_ptr = static_cast<char*>(buffer_key_table_.at(index).host_ptr);
+    for (const auto& region : GetTransferRegions(index)) {
+      CL_CHECK(cmd_.enqueueReadBuffer(
+          buffer, /* blocking = */ CL_FALSE, region.origin, region.size,
+          host_ptr + region.origin, &compute_event_,
+          &store_event_.emplace_back()));
+      transfer.events.push_back(store_event_.back());
+    }
   }
+  LogTransfers(EventLog::kStore, store_transfers_);
 }
 
-cl::Buffer IntelOpenclDevice::CreateBuffer(int index, cl_mem_flags flags,
-                                           void* host_ptr, size_t size) {
+cl::Buffer IntelOpenclDevice::CreateBuffer(cl_mem_flags flags, void* host_ptr,
+                                           size_t size) {
   flags |= /* CL_MEM_HETEROGENEOUS_INTELFPGA = */ 1 << 19;
-  host_ptr_table_[index] = host_ptr;
-  host_ptr = nullptr;
-  return OpenclDevice::CreateBuffer(index, flags, host_ptr, size);
+  if (FLAGS_iocl_use_host_ptr) {
+    flags |= CL_MEM_USE_HOST_PTR;
+  } else {
+    // Data are copied from and to the host pointers in the argument keys.
+    host_ptr = nullptr;
+  }
+  return OpenclDevice::CreateBuffer(flags, host_ptr, size);
 }
 
 }  // namespace internal
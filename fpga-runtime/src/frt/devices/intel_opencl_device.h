@@ -19,19 +19,18 @@ namespace internal {
 
 class IntelOpenclDevice : public OpenclDevice {
  public:
-  IntelOpenclDevice(const cl::Program::Binaries& binaries);
+  IntelOpenclDevice(const cl::Program::Binaries& binaries, int device_index);
 
-  static std::unique_ptr<Device> New(const cl::Program::Binaries& binaries);
+  static std::unique_ptr<Device> New(const cl::Program::Binaries& binaries,
+                                     int device_index);
 
   void SetStreamArg(int index, Tag tag, StreamArg& arg) override;
   void WriteToDevice() override;
   void ReadFromDevice() override;
 
  private:
-  cl::Buffer CreateBuffer(int index, cl_mem_flags flags, void* host_ptr,
+  cl::Buffer CreateBuffer(cl_mem_flags flags, void* host_ptr,
                           size_t size) override;
-
-  std::unordered_map<int, void*> host_ptr_table_;
 };
 
 }  // namespace internal
@@ -5,9 +5,15 @@
 #include "frt/devices/opencl_device.h"
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <iterator>
+#include <map>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
@@ -15,6 +21,7 @@
 
 #include "frt/devices/opencl_device_matcher.h"
 #include "frt/devices/opencl_util.h"
+#include "frt/trace.h"
 
 namespace fpga {
 namespace internal {
@@ -53,60 +60,387 @@ int64_t Latest(const std::vector<cl::Event>& events,
   return default_value;
 }
 
+// OpenCL objects of a device programmed with a bitstream. They are shared by
+// all instances created from the same bitstream in this process, while each
+// instance has its own command queue and kernels.
+struct ProgramCacheEntry {
+  cl::Device device;
+  cl::Context context;
+  cl::Program program;
+};
+
+std::mutex program_cache_mutex;
+
+std::unordered_map<std::string, ProgramCacheEntry>& GetProgramCache() {
+  // Never destroyed, because the OpenCL runtime may be torn down before
+  // static destructors run.
+  static auto* cache = new std::unordered_map<std::string, ProgramCacheEntry>;
+  return *cache;
+}
+
+std::string GetProgramCacheKey(const std::string& vendor_name,
+                               int device_index,
+                               const cl::Program::Binaries& binaries) {
+  std::string key = vendor_name + '#' + std::to_string(device_index);
+  for (const auto& binary : binaries) {
+    const std::string_view content(reinterpret_cast<const char*>(binary.data()),
+                                   binary.size());
+    key += ':' + std::to_string(binary.size()) + ':' +
+           std::to_string(std::hash<std::string_view>()(content));
+  }
+  return key;
+}
+
+// Programs the `device_index`-th available device that matches.
+ProgramCacheEntry LoadProgram(const cl::Program::Binaries& binaries,
+                              const std::string& vendor_name,
+                              const OpenclDeviceMatcher& device_matcher,
+                              int device_index) {
+  std::vector<cl::Platform> platforms;
+  CL_CHECK(cl::Platform::get(&platforms));
+  cl_int err;
+  for (const auto& platform : platforms) {
+    std::string platformName = platform.getInfo<CL_PLATFORM_NAME>(&err);
+    CL_CHECK(err);
+    LOG(INFO) << "Found platform: " << platformName.c_str();
+    if (platformName == vendor_name) {
+      std::vector<cl::Device> devices;
+      CL_CHECK(platform.getDevices(CL_DEVICE_TYPE_ACCELERATOR, &devices));
+      for (const auto& device : devices) {
+        if (std::string device_name = device_matcher.Match(device);
+            !device_name.empty()) {
+          ProgramCacheEntry entry;
+          entry.device = device;
+          entry.context = cl::Context(device, nullptr, nullptr, nullptr, &err);
+          if (err == CL_DEVICE_NOT_AVAILABLE) {
+            LOG(WARNING) << "Device '" << device_name << "' not available";
+            continue;
+          }
+          CL_CHECK(err);
+          if (device_index-- > 0) continue;
+          LOG(INFO) << "Using " << device_name;
+          std::vector<int> binary_status;
+          entry.program = cl::Program(entry.context, {device}, binaries,
+                                      &binary_status, &err);
+          for (auto status : binary_status) {
+            CL_CHECK(status);
+          }
+          CL_CHECK(err);
+          CL_CHECK(entry.program.build());
+          return entry;
+        }
+      }
+      LOG(FATAL) << "Target device '" << device_matcher.GetTargetName()
+                 << "' not found";
+    }
+  }
+  LOG(FATAL) << "Target platform '" + vendor_name + "' not found";
+}
+
+cl_mem_flags GetMemFlags(Tag tag) {
+  switch (tag) {
+    case Tag::kPlaceHolder:
+      break;
+    case Tag::kReadOnly:
+      return CL_MEM_READ_ONLY;
+    case Tag::kWriteOnly:
+      return CL_MEM_WRITE_ONLY;
+    case Tag::kReadWrite:
+    case Tag::kScratch:
+    case Tag::kInitOnce:
+    case Tag::kReadBackLast:
+      return CL_MEM_READ_WRITE;
+    case Tag::kHostOnly:
+      return CL_MEM_READ_WRITE | kHostOnlyMemFlag;
+  }
+  return 0;
+}
+
 }  // namespace
 
 void OpenclDevice::SetScalarArg(int index, const void* arg, int size) {
+  // Kernels keep their arguments, so unchanged scalars are not set again.
+  auto& scalars = compute_units_[compute_unit_].scalars;
+  std::string value(static_cast<const char*>(arg), size);
+  if (auto it = scalars.find(index);
+      it != scalars.end() && it->second == value) {
+    return;
+  }
   auto pair = GetKernel(index);
   pair.second.setArg(pair.first, size, arg);
+  scalars[index] = std::move(value);
 }
 
 void OpenclDevice::SetBufferArg(int index, Tag tag, const BufferArg& arg) {
-  cl_mem_flags flags = 0;
+  // Reuses the buffer if it is registered or is already set to this argument,
+  // so that it is neither allocated nor pinned again.
+  const BufferKey key = {arg.Get(), arg.SizeInBytes(), GetMemFlags(tag)};
+  cl::Buffer buffer;
+  if (auto it = registered_buffers_.find(key);
+      it != registered_buffers_.end()) {
+    buffer = it->second;
+  } else if (auto it = buffer_key_table_.find(index);
+             it != buffer_key_table_.end() && it->second == key) {
+    buffer = buffer_table_.at(index);
+  } else {
+    buffer = CreateBuffer(key.flags, key.host_ptr, key.size);
+    LogEvent(EventLog::kBufferCreate, index, key.size);
+  }
+  // Whether the content of a buffer already bound stays on the device.
+  const auto bound = buffer_table_.find(index);
+  const bool is_bound =
+      bound != buffer_table_.end() && bound->second() == buffer();
+  buffer_table_[index] = buffer;
+  buffer_key_table_[index] = key;
+  dirty_regions_.erase(index);
+  transfer_regions_.erase(index);
+  if (arg.RangeSizeInBytes() != arg.SizeInBytes()) {
+    MarkDirty(index, arg.RangeOffsetInBytes(), arg.RangeSizeInBytes());
+  }
+  load_indices_.erase(index);
+  store_indices_.erase(index);
+  read_back_last_indices_.erase(index);
   switch (tag) {
     case Tag::kPlaceHolder:
       break;
     case Tag::kReadOnly:
-      flags = CL_MEM_READ_ONLY;
+      store_indices_.insert(index);
       break;
     case Tag::kWriteOnly:
-      flags = CL_MEM_WRITE_ONLY;
+      load_indices_.insert(index);
       break;
     case Tag::kReadWrite:
-      flags = CL_MEM_READ_WRITE;
+      store_indices_.insert(index);
+      load_indices_.insert(index);
+      break;
+    case Tag::kScratch:
+      if (!is_bound) scratch_indices_.insert(index);
+      break;
+    case Tag::kReadBackLast:
+      read_back_last_indices_.insert(index);
+      [[fallthrough]];
+    case Tag::kInitOnce:
+      // A buffer already bound keeps its content on the device from the
+      // previous invocation.
+      if (!is_bound) load_indices_.insert(index);
+      break;
+    case Tag::kHostOnly:
+      // The kernel accesses host memory directly.
       break;
   }
-  cl::Buffer buffer = CreateBuffer(index, flags, arg.Get(), arg.SizeInBytes());
-  if (tag == Tag::kReadOnly || tag == Tag::kReadWrite) {
-    store_indices_.insert(index);
-  }
-  if (tag == Tag::kWriteOnly || tag == Tag::kReadWrite) {
-    load_indices_.insert(index);
+  // Kernels keep their arguments, so a buffer already set is not set again.
+  auto& buffers = compute_units_[compute_unit_].buffers;
+  if (auto it = buffers.find(index);
+      it != buffers.end() && it->second() == buffer()) {
+    return;
   }
+  buffers[index] = buffer;
   auto pair = GetKernel(index);
   pair.second.setArg(pair.first, buffer);
 }
 
+void OpenclDevice::RegisterBuffer(Tag tag, const BufferArg& arg) {
+  const BufferKey key = {arg.Get(), arg.SizeInBytes(), GetMemFlags(tag)};
+  if (registered_buffers_.count(key) == 0) {
+    registered_buffers_[key] = CreateBuffer(key.flags, key.host_ptr, key.size);
+    LogEvent(EventLog::kBufferCreate, /*index=*/-1, key.size);
+  }
+}
+
+void OpenclDevice::UnregisterBuffer(Tag tag, const BufferArg& arg) {
+  if (registered_buffers_.erase(
+          {arg.Get(), arg.SizeInBytes(), GetMemFlags(tag)}) != 0) {
+    LogEvent(EventLog::kBufferRelease, /*index=*/-1, arg.SizeInBytes());
+  }
+}
+
 size_t OpenclDevice::SuspendBuffer(int index) {
-  return load_indices_.erase(index) + store_indices_.erase(index);
+  return load_indices_.erase(index) + store_indices_.erase(index) +
+         read_back_last_indices_.erase(index);
+}
+
+void OpenclDevice::MarkDirty(int index, size_t offset, size_t size) {
+  auto it = buffer_table_.find(index);
+  LOG_IF(FATAL, it == buffer_table_.end())
+      << "Cannot mark argument #" << index << " dirty; it is not a buffer";
+  cl_int err;
+  const size_t buffer_size = it->second.getInfo<CL_MEM_SIZE>(&err);
+  CL_CHECK(err);
+  CHECK_LE(offset, buffer_size);
+  CHECK_LE(size, buffer_size - offset);
+
+  // Sub-buffers must start at multiples of the base address alignment.
+  const size_t alignment =
+      device_.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>(&err) / 8;
+  CL_CHECK(err);
+  auto& regions = dirty_regions_[index];
+  if (size == 0) return;
+  const size_t begin = offset / alignment * alignment;
+  regions.push_back({begin, offset + size - begin});
+}
+
+size_t OpenclDevice::PeekBuffer(int index, size_t offset, size_t size) {
+  // Device memory written by a running kernel is not coherent with reads.
+  LOG(FATAL) << "Cannot peek at argument #" << index
+             << " on an OpenCL device; use ReadFromDevice after Finish";
+  return 0;
+}
+
+void OpenclDevice::SetPipelineDepth(size_t depth) {
+  CHECK_GT(depth, 0);
+  pipeline_depth_ = depth;
+}
+
+void OpenclDevice::BeginInvocation() {
+  CollectTraceEvents();
+  if (!compute_event_.empty()) {
+    // The previous invocation ends when its buffers are read back, or when
+    // its kernels finish if nothing is read back.
+    in_flight_.push_back(store_event_.empty() ? compute_event_ : store_event_);
+  }
+  load_event_.clear();
+  compute_event_.clear();
+  store_event_.clear();
+  while (in_flight_.size() >= pipeline_depth_) {
+    CL_CHECK(cl::Event::waitForEvents(in_flight_.front()));
+    in_flight_.pop_front();
+  }
+}
+
+size_t OpenclDevice::GetComputeUnitCount() const {
+  return compute_units_.size();
+}
+
+void OpenclDevice::SetComputeUnit(size_t index) {
+  CHECK_LT(index, compute_units_.size());
+  compute_unit_ = index;
 }
 
 void OpenclDevice::Exec() {
-  compute_event_.resize(kernels_.size());
+  const std::vector<cl::Event> wait_event(
+      load_event_.begin(),
+      load_event_.begin() + std::min(exec_wait_count_, load_event_.size()));
+  const auto& kernels = compute_units_[compute_unit_].kernels;
+  compute_event_.resize(kernels.size());
+  exec_compute_unit_ = compute_unit_;
+  is_trace_collected_ = false;
+  LogEvent(EventLog::kKernelStart);
   int i = 0;
-  for (auto& pair : kernels_) {
+  for (auto& pair : kernels) {
     CL_CHECK(cmd_.enqueueNDRangeKernel(pair.second, cl::NullRange,
                                        cl::NDRange(1), cl::NDRange(1),
-                                       &load_event_, &compute_event_[i]));
+                                       &wait_event, &compute_event_[i]));
     ++i;
   }
+  is_read_back_last_pending_ = !read_back_last_indices_.empty();
 }
 
 void OpenclDevice::Finish() {
+  if (is_read_back_last_pending_) {
+    // Buffers read back only after the final invocation are read back after
+    // its kernels, together with the buffers it already reads back.
+    is_read_back_last_pending_ = false;
+    auto store_indices =
+        std::exchange(store_indices_, read_back_last_indices_);
+    auto store_event = std::move(store_event_);
+    auto store_transfers = std::move(store_transfers_);
+    ReadFromDevice();
+    store_indices_ = std::move(store_indices);
+    store_event_.insert(store_event_.begin(), store_event.begin(),
+                        store_event.end());
+    for (auto& [index, transfer] : store_transfers) {
+      store_transfers_[index] = std::move(transfer);
+    }
+  }
   CL_CHECK(cmd_.flush());
   CL_CHECK(cmd_.finish());
+  LogEvent(EventLog::kKernelEnd);
+  in_flight_.clear();
+  CollectTraceEvents();
+  WriteTraceEvents();
+}
+
+bool OpenclDevice::IsFinished() const {
+  // Commands must be submitted to the device to make progress.
+  CL_CHECK(cmd_.flush());
+  std::vector<const std::vector<cl::Event>*> event_lists = {
+      &load_event_, &compute_event_, &store_event_};
+  for (const auto& events : in_flight_) event_lists.push_back(&events);
+  for (const auto* events : event_lists) {
+    for (const auto& event : *events) {
+      cl_int err;
+      const cl_int status =
+          event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>(&err);
+      CL_CHECK(err);
+      LOG_IF(FATAL, status < 0)
+          << "OpenCL command failed: " << OpenclErrToString(status);
+      if (status != CL_COMPLETE) return false;
+    }
+  }
+  return true;
+}
+
+void OpenclDevice::CollectTraceEvents() {
+  if (is_trace_collected_) return;
+  is_trace_collected_ = true;
+  if (Trace::Get() == nullptr) return;
+
+  auto collect = [this](const char* action, const std::string& name,
+                        const std::vector<cl::Event>& events) {
+    for (const auto& event : events) {
+      trace_events_.emplace_back(std::string(action) + " " + name, event);
+    }
+  };
+  auto arg_name = [this](int index) {
+    auto it = arg_table_.find(index);
+    return it == arg_table_.end() ? std::to_string(index) : it->second.name;
+  };
+  if (!load_event_.empty()) {
+    for (const auto& [index, transfer] : load_transfers_) {
+      collect("load", arg_name(index), transfer.events);
+    }
+  }
+  // Kernels of each compute unit are named after their instances.
+  const ComputeUnit& compute_unit = compute_units_[exec_compute_unit_];
+  size_t i = 0;
+  for (const auto& [_, kernel] : compute_unit.kernels) {
+    if (i >= compute_event_.size()) break;
+    collect("compute",
+            compute_unit.names.empty()
+                ? kernel.getInfo<CL_KERNEL_FUNCTION_NAME>()
+                : compute_unit.names[i],
+            {compute_event_[i]});
+    ++i;
+  }
+  // Without reads in this invocation, the transfers are of an earlier one.
+  if (!store_event_.empty()) {
+    for (const auto& [index, transfer] : store_transfers_) {
+      collect("store", arg_name(index), transfer.events);
+    }
+  }
 }
 
-bool OpenclDevice::IsFinished() const { LOG(FATAL) << "Not implemented"; }
+void OpenclDevice::WriteTraceEvents() {
+  Trace* trace = Trace::Get();
+  if (trace == nullptr || trace_events_.empty()) return;
+
+  // Device timestamps are on a clock of their own; align them so that the
+  // last command ends now, which is when `Finish` observes it.
+  int64_t last_end_ns = 0;
+  for (const auto& [_, event] : trace_events_) {
+    last_end_ns =
+        std::max(last_end_ns, GetTime<CL_PROFILING_COMMAND_END>(event));
+  }
+  const int64_t offset_ns = Trace::NowNs() - last_end_ns;
+  for (const auto& [name, event] : trace_events_) {
+    auto [it, is_new] = trace_tracks_.try_emplace(name, 0);
+    if (is_new) it->second = trace->AddTrack("device", name);
+    trace->AddSpan(it->second, name,
+                   GetTime<CL_PROFILING_COMMAND_START>(event) + offset_ns,
+                   GetTime<CL_PROFILING_COMMAND_END>(event) + offset_ns);
+  }
+  trace_events_.clear();
+}
 
 std::vector<ArgInfo> OpenclDevice::GetArgsInfo() const {
   std::vector<ArgInfo> args;
@@ -152,89 +486,217 @@ size_t OpenclDevice::StoreBytes() const {
   return total_size;
 }
 
-void OpenclDevice::Initialize(const cl::Program::Binaries& binaries,
-                              const std::string& vendor_name,
-                              const OpenclDeviceMatcher& device_matcher,
-                              const std::vector<std::string>& kernel_names,
-                              const std::vector<int>& kernel_arg_counts) {
-  std::vector<cl::Platform> platforms;
-  CL_CHECK(cl::Platform::get(&platforms));
+std::vector<TransferStats> OpenclDevice::GetTransferStats() const {
+  std::map<int, TransferStats> stats;
+  auto get_stats = [&](int index) -> TransferStats& {
+    auto [it, is_new] = stats.try_emplace(index);
+    if (is_new) {
+      if (auto arg = arg_table_.find(index); arg != arg_table_.end()) {
+        it->second.arg = arg->second;
+      } else {
+        it->second.arg.index = index;
+      }
+    }
+    return it->second;
+  };
+  for (const auto& [index, transfer] : load_transfers_) {
+    auto& arg_stats = get_stats(index);
+    arg_stats.load_bytes = transfer.bytes;
+    arg_stats.load_time_ns =
+        Latest<CL_PROFILING_COMMAND_END>(transfer.events) -
+        Earliest<CL_PROFILING_COMMAND_START>(transfer.events);
+  }
+  for (const auto& [index, transfer] : store_transfers_) {
+    auto& arg_stats = get_stats(index);
+    arg_stats.store_bytes = transfer.bytes;
+    arg_stats.store_time_ns =
+        Latest<CL_PROFILING_COMMAND_END>(transfer.events) -
+        Earliest<CL_PROFILING_COMMAND_START>(transfer.events);
+  }
+  std::vector<TransferStats> result;
+  result.reserve(stats.size());
+  for (auto& [index, arg_stats] : stats) {
+    result.push_back(std::move(arg_stats));
+  }
+  return result;
+}
+
+std::vector<PortStats> OpenclDevice::GetPortStats() const {
+  // Ports of a kernel running on the device are not observable.
+  return {};
+}
+
+std::vector<HardwareCounters> OpenclDevice::GetHardwareCounters() const {
+  // OpenCL cannot read the control registers of a kernel.
+  return {};
+}
+
+void OpenclDevice::Initialize(
+    const cl::Program::Binaries& binaries, const std::string& vendor_name,
+    const OpenclDeviceMatcher& device_matcher, int device_index,
+    const std::vector<std::string>& kernel_names,
+    const std::vector<int>& kernel_arg_counts,
+    const std::vector<std::vector<std::string>>& kernel_instances) {
+  {
+    // Loading is serialized so that a bitstream is programmed only once.
+    std::lock_guard<std::mutex> lock(program_cache_mutex);
+    auto& cache = GetProgramCache();
+    const std::string key =
+        GetProgramCacheKey(vendor_name, device_index, binaries);
+    auto it = cache.find(key);
+    if (it == cache.end()) {
+      it = cache.emplace(key, LoadProgram(binaries, vendor_name,
+                                          device_matcher, device_index))
+               .first;
+    } else {
+      LOG(INFO) << "Reusing the device programmed with the same bitstream";
+    }
+    device_ = it->second.device;
+    context_ = it->second.context;
+    program_ = it->second.program;
+  }
+
   cl_int err;
-  for (const auto& platform : platforms) {
-    std::string platformName = platform.getInfo<CL_PLATFORM_NAME>(&err);
-    CL_CHECK(err);
-    LOG(INFO) << "Found platform: " << platformName.c_str();
-    if (platformName == vendor_name) {
-      std::vector<cl::Device> devices;
-      CL_CHECK(platform.getDevices(CL_DEVICE_TYPE_ACCELERATOR, &devices));
-      for (const auto& device : devices) {
-        if (std::string device_name = device_matcher.Match(device);
-            !device_name.empty()) {
-          LOG(INFO) << "Using " << device_name;
-          device_ = device;
-          context_ = cl::Context(device, nullptr, nullptr, nullptr, &err);
-          if (err == CL_DEVICE_NOT_AVAILABLE) {
-            LOG(WARNING) << "Device '" << device_name << "' not available";
-            continue;
-          }
-          CL_CHECK(err);
-          cmd_ = cl::CommandQueue(context_, device,
-                                  CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE |
-                                      CL_QUEUE_PROFILING_ENABLE,
-                                  &err);
-          CL_CHECK(err);
-          std::vector<int> binary_status;
-          program_ =
-              cl::Program(context_, {device}, binaries, &binary_status, &err);
-          for (auto status : binary_status) {
-            CL_CHECK(status);
-          }
-          CL_CHECK(err);
-          CL_CHECK(program_.build());
-          for (int i = 0; i < kernel_names.size(); ++i) {
-            kernels_[kernel_arg_counts[i]] =
-                cl::Kernel(program_, kernel_names[i].c_str(), &err);
-            CL_CHECK(err);
-          }
-          return;
-        }
+  cmd_ = cl::CommandQueue(
+      context_, device_,
+      CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE,
+      &err);
+  CL_CHECK(err);
+
+  // Every kernel must have an instance in each compute unit.
+  size_t compute_unit_count = 1;
+  if (!kernel_instances.empty()) {
+    compute_unit_count = kernel_instances[0].size();
+    for (const auto& instances : kernel_instances) {
+      compute_unit_count = std::min(compute_unit_count, instances.size());
+    }
+  }
+  compute_units_.resize(std::max<size_t>(compute_unit_count, 1));
+  for (size_t cu = 0; cu < compute_units_.size(); ++cu) {
+    auto& compute_unit = compute_units_[cu];
+    for (int i = 0; i < kernel_names.size(); ++i) {
+      // A kernel not bound to an instance runs on any available instance.
+      std::string name = kernel_names[i];
+      if (compute_unit_count > 1) {
+        compute_unit.names.push_back(kernel_instances[i][cu]);
+        name += ":{" + kernel_instances[i][cu] + "}";
       }
-      LOG(FATAL) << "Target device '" << device_matcher.GetTargetName()
-                 << "' not found";
+      compute_unit.kernels[kernel_arg_counts[i]] =
+          cl::Kernel(program_, name.c_str(), &err);
+      CL_CHECK(err);
     }
   }
-  LOG(FATAL) << "Target platform '" + vendor_name + "' not found";
+  LOG_IF(INFO, compute_units_.size() > 1)
+      << "Found " << compute_units_.size() << " compute units";
 }
 
-cl::Buffer OpenclDevice::CreateBuffer(int index, cl_mem_flags flags,
-                                      void* host_ptr, size_t size) {
+cl::Buffer OpenclDevice::CreateBuffer(cl_mem_flags flags, void* host_ptr,
+                                      size_t size) {
+  LOG_IF(FATAL, flags & kHostOnlyMemFlag)
+      << "Host-only buffers are not supported on this device";
   cl_int err;
   auto buffer = cl::Buffer(context_, flags, size, host_ptr, &err);
   CL_CHECK(err);
-  buffer_table_[index] = buffer;
   return buffer;
 }
 
+void OpenclDevice::BeginTransfer() {
+  transfer_regions_.clear();
+  for (auto& [index, regions] : dirty_regions_) {
+    // Overlapping sub-buffers must not be migrated together, so ranges are
+    // sorted and merged.
+    std::sort(regions.begin(), regions.end(),
+              [](const cl_buffer_region& lhs, const cl_buffer_region& rhs) {
+                return lhs.origin < rhs.origin;
+              });
+    auto& merged = transfer_regions_[index];
+    for (const auto& region : regions) {
+      if (!merged.empty() &&
+          region.origin <= merged.back().origin + merged.back().size) {
+        merged.back().size =
+            std::max(merged.back().size,
+                     region.origin + region.size - merged.back().origin);
+      } else {
+        merged.push_back(region);
+      }
+    }
+    regions.clear();
+  }
+}
+
+std::vector<cl_buffer_region> OpenclDevice::GetTransferRegions(
+    int index) const {
+  auto it = transfer_regions_.find(index);
+  if (it != transfer_regions_.end()) {
+    return it->second;
+  }
+  cl_int err;
+  const size_t size = buffer_table_.at(index).getInfo<CL_MEM_SIZE>(&err);
+  CL_CHECK(err);
+  return {{0, size}};
+}
+
+std::vector<cl::Buffer> OpenclDevice::GetTransferBuffers(int index) const {
+  cl::Buffer buffer = buffer_table_.at(index);
+  if (transfer_regions_.count(index) == 0) {
+    return {buffer};
+  }
+  std::vector<cl::Buffer> buffers;
+  for (const auto& region : transfer_regions_.at(index)) {
+    cl_int err;
+    buffers.push_back(buffer.createSubBuffer(
+        /*flags=*/0, CL_BUFFER_CREATE_TYPE_REGION, &region, &err));
+    CL_CHECK(err);
+  }
+  return buffers;
+}
+
 std::vector<cl::Memory> OpenclDevice::GetLoadBuffers() const {
   std::vector<cl::Memory> buffers;
   buffers.reserve(load_indices_.size());
   for (auto index : load_indices_) {
-    buffers.push_back(buffer_table_.at(index));
+    for (auto& buffer : GetTransferBuffers(index)) {
+      buffers.push_back(std::move(buffer));
+    }
   }
   return buffers;
 }
 
+void OpenclDevice::AllocateScratchBuffers() {
+  std::vector<cl::Memory> buffers;
+  buffers.reserve(scratch_indices_.size());
+  for (auto index : scratch_indices_) {
+    buffers.push_back(buffer_table_.at(index));
+  }
+  scratch_indices_.clear();
+  if (buffers.empty()) return;
+  CL_CHECK(cmd_.enqueueMigrateMemObjects(
+      buffers, CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED,
+      /* events = */ nullptr, &load_event_.emplace_back()));
+}
+
+void OpenclDevice::LogTransfers(
+    EventLog::Kind kind,
+    const std::unordered_map<int, ArgTransfer>& transfers) {
+  for (const auto& [index, transfer] : transfers) {
+    if (!transfer.events.empty()) LogEvent(kind, index, transfer.bytes);
+  }
+}
+
 std::vector<cl::Memory> OpenclDevice::GetStoreBuffers() const {
   std::vector<cl::Memory> buffers;
   buffers.reserve(store_indices_.size());
   for (auto index : store_indices_) {
-    buffers.push_back(buffer_table_.at(index));
+    for (auto& buffer : GetTransferBuffers(index)) {
+      buffers.push_back(std::move(buffer));
+    }
   }
   return buffers;
 }
 
 std::pair<int, cl::Kernel> OpenclDevice::GetKernel(int index) const {
-  auto it = std::prev(kernels_.upper_bound(index));
+  const auto& kernels = compute_units_[compute_unit_].kernels;
+  auto it = std::prev(kernels.upper_bound(index));
   return {index - it->first, it->second};
 }
 
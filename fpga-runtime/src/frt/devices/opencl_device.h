@@ -8,9 +8,12 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <deque>
 #include <map>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <unordered_set>
 #include <vector>
 
@@ -19,16 +22,29 @@
 #include "frt/arg_info.h"
 #include "frt/device.h"
 #include "frt/devices/opencl_device_matcher.h"
+#include "frt/event_log.h"
 #include "frt/tag.h"
 
 namespace fpga {
 namespace internal {
 
+// Not an OpenCL flag; marks the flags of host-only buffers, which devices must
+// clear in `CreateBuffer` if they support them.
+inline constexpr cl_mem_flags kHostOnlyMemFlag = cl_mem_flags{1} << 63;
+
 class OpenclDevice : public Device {
  public:
   void SetScalarArg(int index, const void* arg, int size) override;
   void SetBufferArg(int index, Tag tag, const BufferArg& arg) override;
+  void RegisterBuffer(Tag tag, const BufferArg& arg) override;
+  void UnregisterBuffer(Tag tag, const BufferArg& arg) override;
   size_t SuspendBuffer(int index) override;
+  void MarkDirty(int index, size_t offset, size_t size) override;
+  size_t PeekBuffer(int index, size_t offset, size_t size) override;
+  void SetPipelineDepth(size_t depth) override;
+  void BeginInvocation() override;
+  size_t GetComputeUnitCount() const override;
+  void SetComputeUnit(size_t index) override;
 
   void Exec() override;
   void Finish() override;
@@ -40,33 +56,117 @@ class OpenclDevice : public Device {
   int64_t StoreTimeNanoSeconds() const override;
   size_t LoadBytes() const override;
   size_t StoreBytes() const override;
+  std::vector<TransferStats> GetTransferStats() const override;
+  std::vector<PortStats> GetPortStats() const override;
+  std::vector<HardwareCounters> GetHardwareCounters() const override;
 
  protected:
-  void Initialize(const cl::Program::Binaries& binaries,
-                  const std::string& vendor_name,
-                  const OpenclDeviceMatcher& device_matcher,
-                  const std::vector<std::string>& kernel_names,
-                  const std::vector<int>& kernel_arg_counts);
-  virtual cl::Buffer CreateBuffer(int index, cl_mem_flags flags, void* host_ptr,
+  // If `kernel_instances` is not empty, it lists the compute units of each
+  // kernel, and the `i`-th compute unit of the device runs the `i`-th one of
+  // each kernel.
+  void Initialize(
+      const cl::Program::Binaries& binaries, const std::string& vendor_name,
+      const OpenclDeviceMatcher& device_matcher, int device_index,
+      const std::vector<std::string>& kernel_names,
+      const std::vector<int>& kernel_arg_counts,
+      const std::vector<std::vector<std::string>>& kernel_instances = {});
+  virtual cl::Buffer CreateBuffer(cl_mem_flags flags, void* host_ptr,
                                   size_t size);
 
+  // Makes ranges marked dirty take effect; called by `WriteToDevice`.
+  void BeginTransfer();
+  // Returns the byte ranges of buffer `index` to transfer: its dirty ranges if
+  // it is tracked, or the whole buffer otherwise.
+  std::vector<cl_buffer_region> GetTransferRegions(int index) const;
+  // Returns the buffer, or sub-buffers of its dirty ranges if it is tracked.
+  std::vector<cl::Buffer> GetTransferBuffers(int index) const;
   std::vector<cl::Memory> GetLoadBuffers() const;
   std::vector<cl::Memory> GetStoreBuffers() const;
+  // Allocates device memory of scratch buffers newly bound, without
+  // transferring their content; called by `WriteToDevice`.
+  void AllocateScratchBuffers();
   std::pair<int, cl::Kernel> GetKernel(int index) const;
+  // Keeps the commands of the current invocation for the timeline trace, if
+  // tracing is enabled; called before the events are cleared.
+  void CollectTraceEvents();
+  // Writes the kept commands to the timeline trace once they are complete.
+  void WriteTraceEvents();
 
   cl::Device device_;
   cl::Context context_;
   cl::CommandQueue cmd_;
   cl::Program program_;
-  // Maps prefix sum of arg count to kernels.
-  std::map<int, cl::Kernel> kernels_;
+  // Kernels of a compute unit, each of which keeps its own arguments.
+  struct ComputeUnit {
+    // Maps prefix sum of arg count to kernels.
+    std::map<int, cl::Kernel> kernels;
+    // Names of the kernel instances, in the same order; empty if the kernels
+    // are not bound to instances.
+    std::vector<std::string> names;
+    // Buffers and bytes of the scalar arguments set to the kernels.
+    std::unordered_map<int, cl::Buffer> buffers;
+    std::unordered_map<int, std::string> scalars;
+  };
+  std::vector<ComputeUnit> compute_units_;
+  // Compute unit that the following invocations run on, and that of the
+  // current invocation.
+  size_t compute_unit_ = 0;
+  size_t exec_compute_unit_ = 0;
+  // Identifies a buffer by its host memory and memory flags.
+  struct BufferKey {
+    void* host_ptr;
+    size_t size;
+    cl_mem_flags flags;
+    bool operator==(const BufferKey& other) const {
+      return host_ptr == other.host_ptr && size == other.size &&
+             flags == other.flags;
+    }
+    bool operator<(const BufferKey& other) const {
+      return std::tie(host_ptr, size, flags) <
+             std::tie(other.host_ptr, other.size, other.flags);
+    }
+  };
+  std::map<BufferKey, cl::Buffer> registered_buffers_;
+  std::unordered_map<int, BufferKey> buffer_key_table_;
   std::unordered_map<int, cl::Buffer> buffer_table_;
   std::unordered_map<int, ArgInfo> arg_table_;
   std::unordered_set<int> load_indices_;
   std::unordered_set<int> store_indices_;
+  // Scratch buffers newly bound, whose device memory is not yet allocated.
+  std::unordered_set<int> scratch_indices_;
+  // Buffers read back by `Finish` instead of by each invocation, and whether
+  // an invocation has run since they were last read back.
+  std::unordered_set<int> read_back_last_indices_;
+  bool is_read_back_last_pending_ = false;
+  // Maps tracked buffers to ranges marked dirty since the last transfer, and
+  // to ranges of the current transfer, respectively.
+  std::unordered_map<int, std::vector<cl_buffer_region>> dirty_regions_;
+  std::unordered_map<int, std::vector<cl_buffer_region>> transfer_regions_;
   std::vector<cl::Event> load_event_;
+  // Events and sizes of the transfers of each argument, used for per-argument
+  // statistics.
+  struct ArgTransfer {
+    std::vector<cl::Event> events;
+    size_t bytes = 0;
+  };
+  std::unordered_map<int, ArgTransfer> load_transfers_;
+  std::unordered_map<int, ArgTransfer> store_transfers_;
+  // Records `transfers` as enqueued in the event log.
+  void LogTransfers(EventLog::Kind kind,
+                    const std::unordered_map<int, ArgTransfer>& transfers);
+  // Kernels wait for the first `exec_wait_count_` events in `load_event_`.
+  size_t exec_wait_count_ = -1;
   std::vector<cl::Event> compute_event_;
   std::vector<cl::Event> store_event_;
+  // Events that mark the end of each earlier invocation still in flight,
+  // oldest first.
+  std::deque<std::vector<cl::Event>> in_flight_;
+  size_t pipeline_depth_ = 1;
+  // Named commands not yet written to the timeline trace, whether the current
+  // invocation is among them, and the trace track of each name.
+  std::vector<std::pair<std::string, cl::Event>> trace_events_;
+  bool is_trace_collected_ = true;
+  std::unordered_map<std::string, int> trace_tracks_;
 };
 
 }  // namespace internal
@@ -4,14 +4,22 @@
 
 #include "frt/devices/shared_memory_queue.h"
 
+#include <cerrno>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
 #include <string>
+#include <thread>
 
 #include <fcntl.h>
+#include <linux/futex.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -23,82 +31,322 @@ namespace internal {
 namespace {
 
 constexpr char kMagic[] = "tapa";
-constexpr int32_t kVersion = 1;
+constexpr size_t kCacheLineSize = 64;
+
+// Minimum alignment of elements in version 3 queues.
+constexpr int64_t kElementAlignment = 8;
+
+// Fields at the beginning of the shared memory object in all versions.
+struct Header {
+  char magic[4];
+  int32_t version;
+  int32_t depth;
+  int32_t width;
+};
+static_assert(sizeof(Header) == 16);
+static_assert(sizeof(Header::magic) + 1 == sizeof(kMagic));  // +1 for '\0'
+static_assert(std::atomic<int64_t>::is_always_lock_free);
+
+struct LayoutV1 {
+  Header header;
+  std::atomic<int64_t> tail;
+  std::atomic<int64_t> head;
+};
+static_assert(sizeof(LayoutV1) == 32);
+
+// Also used by version 3, which only differs in the stride of elements.
+struct LayoutV2 {
+  alignas(kCacheLineSize) Header header;
+
+  // Written by the producer.
+  alignas(kCacheLineSize) std::atomic<int64_t> head;
+  std::atomic<uint32_t> not_empty_seq;
+  std::atomic<uint32_t> consumer_waiting;
+
+  // Written by the consumer.
+  alignas(kCacheLineSize) std::atomic<int64_t> tail;
+  std::atomic<uint32_t> not_full_seq;
+  std::atomic<uint32_t> producer_waiting;
+};
+static_assert(sizeof(LayoutV2) == kCacheLineSize * 3);
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+bool IsKnownVersion(int32_t version) {
+  return version == SharedMemoryQueue::kVersion1 ||
+         version == SharedMemoryQueue::kVersion2 ||
+         version == SharedMemoryQueue::kVersion3;
+}
+
+// Polling interval of version 1 queues, which cannot sleep on a futex.
+constexpr std::chrono::microseconds kPollInterval(100);
+
+uint32_t* AsFutex(std::atomic<uint32_t>* word) {
+  return reinterpret_cast<uint32_t*>(word);
+}
+
+// Sleeps until `word` is woken, unless it no longer holds `val`. Spurious
+// wake-ups are possible. The futex is not private because the other side lives
+// in another process.
+void FutexWait(std::atomic<uint32_t>* word, uint32_t val,
+               std::chrono::nanoseconds timeout) {
+  timespec ts;
+  timespec* ts_ptr = nullptr;
+  if (timeout != std::chrono::nanoseconds::max()) {
+    const auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    ts.tv_sec = secs.count();
+    ts.tv_nsec = (timeout - secs).count();
+    ts_ptr = &ts;
+  }
+  const long rc =  // NOLINT(runtime/int)
+      syscall(SYS_futex, AsFutex(word), FUTEX_WAIT, val, ts_ptr, nullptr, 0);
+  if (rc != 0 && errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT) {
+    PLOG(ERROR) << "futex wait";
+  }
+}
+
+// Wakes the other side if it is waiting on `seq`.
+void Notify(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* waiting) {
+  if (seq == nullptr) {
+    return;
+  }
+  // Pairs with the fence in `Wait`, so that either the waiter sees the update
+  // made before calling this function, or this function sees the waiter.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting->load(std::memory_order_relaxed) != 0) {
+    seq->fetch_add(1, std::memory_order_release);
+    PLOG_IF(ERROR, syscall(SYS_futex, AsFutex(seq), FUTEX_WAKE, INT_MAX,
+                           nullptr, nullptr, 0) < 0)
+        << "futex wake";
+  }
+}
+
+// Blocks until `is_ready()` returns true or `timeout` passes. `seq` and
+// `waiting` are nullptr for version 1 queues, which poll instead.
+template <typename IsReady>
+bool Wait(IsReady is_ready, std::atomic<uint32_t>* seq,
+          std::atomic<uint32_t>* waiting, std::chrono::nanoseconds timeout) {
+  using clock = std::chrono::steady_clock;
+  const bool is_forever = timeout == std::chrono::nanoseconds::max();
+  const auto deadline = is_forever ? clock::time_point::max()
+                                   : clock::now() + timeout;
+  while (!is_ready()) {
+    std::chrono::nanoseconds remaining = std::chrono::nanoseconds::max();
+    if (!is_forever) {
+      remaining = deadline - clock::now();
+      if (remaining <= std::chrono::nanoseconds::zero()) {
+        return false;
+      }
+    }
+
+    if (seq == nullptr) {
+      std::this_thread::sleep_for(
+          std::min<std::chrono::nanoseconds>(remaining, kPollInterval));
+      continue;
+    }
+
+    const uint32_t val = seq->load(std::memory_order_acquire);
+    waiting->store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!is_ready()) {
+      FutexWait(seq, val, remaining);
+    }
+    waiting->store(0, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+int64_t GetSlotCount(int32_t version, int64_t depth) {
+  if (version == SharedMemoryQueue::kVersion1) {
+    return depth;
+  }
+  int64_t slot_count = 1;
+  while (slot_count < depth) {
+    slot_count *= 2;
+  }
+  return slot_count;
+}
+
+int64_t GetStride(int32_t version, int64_t width) {
+  if (version != SharedMemoryQueue::kVersion3) {
+    return width;
+  }
+  const int64_t alignment = width >= static_cast<int64_t>(kCacheLineSize)
+                                ? kCacheLineSize
+                                : kElementAlignment;
+  return (width + alignment - 1) / alignment * alignment;
+}
+
+size_t GetMmapLen(int32_t version, int64_t depth, int64_t width) {
+  const size_t header_size = version == SharedMemoryQueue::kVersion1
+                                 ? sizeof(LayoutV1)
+                                 : sizeof(LayoutV2);
+  return header_size +
+         GetSlotCount(version, depth) * GetStride(version, width);
+}
+
+// Returns whether `header` describes a queue, with logging if not.
+bool IsValidHeader(const Header& header) {
+  const std::string magic(header.magic, sizeof(header.magic));
+  if (magic != kMagic) {
+    LOG(ERROR) << "unexpected magic '" << magic << "'; want '" << kMagic << "'"
+               << "; size: " << magic.size();
+    return false;
+  }
+
+  if (!IsKnownVersion(header.version)) {
+    LOG(ERROR) << "unexpected version " << header.version << "; want "
+               << SharedMemoryQueue::kVersion1 << ", "
+               << SharedMemoryQueue::kVersion2 << ", or "
+               << SharedMemoryQueue::kVersion3;
+    return false;
+  }
+
+  if (header.depth <= 0) {
+    LOG(ERROR) << "unexpected non-positive depth " << header.depth;
+    return false;
+  }
+
+  if (header.width <= 0) {
+    LOG(ERROR) << "unexpected non-positive width " << header.width;
+    return false;
+  }
+  return true;
+}
+
+Header MakeHeader(int32_t depth, int32_t width, int32_t version) {
+  Header header;
+  memcpy(header.magic, kMagic, sizeof(header.magic));
+  header.version = version;
+  header.depth = depth;
+  header.width = width;
+  return header;
+}
 
 }  // namespace
 
 void SharedMemoryQueue::Deleter::operator()(SharedMemoryQueue* ptr) {
-  if (munmap(ptr, ptr->mmap_len()) != 0) {
+  if (ptr->mmap_len_ != 0 && munmap(ptr->addr_, ptr->mmap_len_) != 0) {
     PLOG(ERROR) << "munmap";
   }
+  delete ptr;
 }
 
 SharedMemoryQueue::UniquePtr SharedMemoryQueue::New(int fd) {
-  auto* ptr = static_cast<SharedMemoryQueue*>(
-      mmap(nullptr, sizeof(SharedMemoryQueue), PROT_READ | PROT_WRITE,
-           MAP_SHARED, fd, /*offset=*/0));
-  if (ptr == MAP_FAILED) {
+  void* addr = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, /*offset=*/0);
+  if (addr == MAP_FAILED) {
     PLOG(ERROR) << "mmap";
     return nullptr;
   }
+  const Header header = *static_cast<const Header*>(addr);
+  auto unmap_header = [addr] {
+    PLOG_IF(ERROR, munmap(addr, sizeof(Header)) != 0) << "munmap";
+  };
 
-  const std::string magic(ptr->magic_, sizeof(ptr->magic_));
-  if (magic != kMagic) {
-    LOG(ERROR) << "unexpected magic '" << magic << "'; want '" << kMagic << "'"
-               << "; size: " << magic.size();
+  if (!IsValidHeader(header)) {
+    unmap_header();
     return nullptr;
   }
 
-  if (ptr->version_ != kVersion) {
-    LOG(ERROR) << "unexpected version " << ptr->version_ << "; want "
-               << kVersion;
+  const size_t mmap_len =
+      GetMmapLen(header.version, header.depth, header.width);
+  void* new_addr = mremap(addr, sizeof(Header), mmap_len, MREMAP_MAYMOVE);
+  if (new_addr == MAP_FAILED) {
+    PLOG(ERROR) << "mremap";
+    unmap_header();
     return nullptr;
   }
 
-  if (ptr->depth_ <= 0) {
-    LOG(ERROR) << "unexpected non-positive depth " << ptr->depth_;
+  UniquePtr queue = Attach(static_cast<char*>(new_addr), &header);
+  queue->mmap_len_ = mmap_len;
+  return queue;
+}
+
+SharedMemoryQueue::UniquePtr SharedMemoryQueue::New(void* addr, size_t size) {
+  if (size < sizeof(Header)) {
+    LOG(ERROR) << "unexpected size " << size << " smaller than the header";
     return nullptr;
   }
-
-  if (ptr->width_ <= 0) {
-    LOG(ERROR) << "unexpected non-positive width " << ptr->width_;
+  const Header header = *static_cast<const Header*>(addr);
+  if (!IsValidHeader(header)) {
     return nullptr;
   }
-
-  ptr = static_cast<SharedMemoryQueue*>(
-      mremap(ptr, sizeof(SharedMemoryQueue), ptr->mmap_len(), MREMAP_MAYMOVE));
-  if (ptr == MAP_FAILED) {
-    PLOG(ERROR) << "mremap";
-    PLOG_IF(ERROR, munmap(ptr, sizeof(SharedMemoryQueue)) != 0) << "munmap";
+  const size_t len = GetMmapLen(header.version, header.depth, header.width);
+  if (size < len) {
+    LOG(ERROR) << "unexpected size " << size << "; want at least " << len;
     return nullptr;
   }
+  return Attach(static_cast<char*>(addr), &header);
+}
 
-  return UniquePtr(ptr);
+size_t SharedMemoryQueue::GetSize(int32_t depth, int32_t width,
+                                  int32_t version) {
+  CHECK(IsKnownVersion(version)) << "unexpected version " << version;
+  return GetMmapLen(version, depth, width);
+}
+
+void SharedMemoryQueue::Init(void* addr, int32_t depth, int32_t width,
+                             int32_t version) {
+  CHECK(IsKnownVersion(version)) << "unexpected version " << version;
+  CHECK_EQ(reinterpret_cast<uintptr_t>(addr) % kCacheLineSize, 0);
+  // Zero-filling the fixed part initializes `head`, `tail`, and the futexes.
+  memset(addr, 0,
+         version == kVersion1 ? sizeof(LayoutV1) : sizeof(LayoutV2));
+  const Header header = MakeHeader(depth, width, version);
+  memcpy(addr, &header, sizeof(header));
+}
+
+SharedMemoryQueue::UniquePtr SharedMemoryQueue::Attach(char* addr,
+                                                       const void* header_ptr) {
+  const Header& header = *static_cast<const Header*>(header_ptr);
+  UniquePtr queue(new SharedMemoryQueue);
+  queue->addr_ = addr;
+  queue->version_ = header.version;
+  queue->depth_ = header.depth;
+  queue->width_ = header.width;
+  queue->stride_ = GetStride(header.version, header.width);
+  if (header.version == kVersion1) {
+    auto* layout = reinterpret_cast<LayoutV1*>(addr);
+    queue->head_ = &layout->head;
+    queue->tail_ = &layout->tail;
+    queue->data_ = queue->addr_ + sizeof(LayoutV1);
+  } else {
+    auto* layout = reinterpret_cast<LayoutV2*>(addr);
+    queue->head_ = &layout->head;
+    queue->tail_ = &layout->tail;
+    queue->data_ = queue->addr_ + sizeof(LayoutV2);
+    queue->slot_mask_ = GetSlotCount(header.version, header.depth) - 1;
+    queue->not_empty_seq_ = &layout->not_empty_seq;
+    queue->consumer_waiting_ = &layout->consumer_waiting;
+    queue->not_full_seq_ = &layout->not_full_seq;
+    queue->producer_waiting_ = &layout->producer_waiting;
+  }
+  queue->cached_tail_ = queue->tail_->load(std::memory_order_acquire);
+  queue->cached_head_ = queue->head_->load(std::memory_order_acquire);
+  return queue;
 }
 
 int SharedMemoryQueue::CreateFile(std::string& path, int32_t depth,
-                                  int32_t width) {
+                                  int32_t width, int32_t version) {
+  CHECK(IsKnownVersion(version)) << "unexpected version " << version;
   int fd = shm_open(mktemp(&path[0]), O_RDWR | O_CREAT | O_EXCL, 0600);
   if (fd < 0) {
     PLOG(ERROR) << "shm_open";
     return fd;
   }
 
-  SharedMemoryQueue queue;
-  static_assert(sizeof(queue.magic_) + 1 == sizeof(kMagic));  // +1 for '\0'
-  memcpy(queue.magic_, kMagic, sizeof(queue.magic_));
-  queue.version_ = kVersion;
-  queue.depth_ = depth;
-  queue.width_ = width;
-  int rc = ftruncate(fd, sizeof(queue) + depth * width);
+  const Header header = MakeHeader(depth, width, version);
+  // `ftruncate` zero-fills the object, which initializes `head` and `tail`.
+  int rc = ftruncate(fd, GetMmapLen(version, depth, width));
   if (rc == 0) {
-    rc = write(fd, &queue, sizeof(queue));
-    if (rc == sizeof(queue)) {
+    rc = write(fd, &header, sizeof(header));
+    if (rc == sizeof(header)) {
       return fd;
     }
     if (rc >= 0) {
       LOG(ERROR) << "partial write: wrote " << rc << " bytes, want "
-                 << sizeof(queue);
+                 << sizeof(header);
     } else {
       PLOG(ERROR) << "write";
     }
@@ -110,36 +358,95 @@ int SharedMemoryQueue::CreateFile(std::string& path, int32_t depth,
   return rc;
 }
 
-int64_t SharedMemoryQueue::size() const { return head_ - tail_; }
+int32_t SharedMemoryQueue::version() const { return version_; }
+
+int64_t SharedMemoryQueue::size() const {
+  return head_->load(std::memory_order_acquire) -
+         tail_->load(std::memory_order_acquire);
+}
 
 int64_t SharedMemoryQueue::capacity() const { return depth_; }
 
 int64_t SharedMemoryQueue::width() const { return width_; }
 
-bool SharedMemoryQueue::empty() const { return size() <= 0; }
+int64_t SharedMemoryQueue::stride() const { return stride_; }
+
+bool SharedMemoryQueue::empty() const {
+  return ConsumerSize(tail_->load(std::memory_order_relaxed)) <= 0;
+}
 
-bool SharedMemoryQueue::full() const { return size() >= capacity(); }
+bool SharedMemoryQueue::full() const {
+  return ProducerSize(head_->load(std::memory_order_relaxed)) >= capacity();
+}
 
 std::string SharedMemoryQueue::front() const {
-  return std::string(&data_[(tail_ % depth_) * width_], width_);
+  std::string val(width_, '\0');
+  front_into(val.data());
+  return val;
 }
 
 std::string SharedMemoryQueue::pop() {
-  CHECK_GT(size(), 0) << "pop called on an empty queue";
-  std::string val = front();
-  ++tail_;
+  std::string val(width_, '\0');
+  pop_into(val.data());
   return val;
 }
 
 void SharedMemoryQueue::push(const std::string& val) {
-  CHECK_LT(size(), capacity()) << "push called on a full queue";
   CHECK_EQ(val.size(), width_) << "unexpected input: " << val;
-  memcpy(&data_[(head_ % depth_) * width_], val.data(), val.size());
-  ++head_;
+  push(val.data(), val.size());
+}
+
+void SharedMemoryQueue::front_into(void* data) const {
+  const int64_t tail = tail_->load(std::memory_order_relaxed);
+  ConsumerSize(tail);  // Acquires the element if it was just pushed.
+  memcpy(data, slot(tail), width_);
+}
+
+void SharedMemoryQueue::pop_into(void* data) {
+  const int64_t tail = tail_->load(std::memory_order_relaxed);
+  CHECK_GT(ConsumerSize(tail), 0) << "pop called on an empty queue";
+  memcpy(data, slot(tail), width_);
+  tail_->store(tail + 1, std::memory_order_release);
+  Notify(not_full_seq_, producer_waiting_);
+}
+
+void SharedMemoryQueue::push(const void* data, size_t size) {
+  const int64_t head = head_->load(std::memory_order_relaxed);
+  CHECK_LT(ProducerSize(head), capacity()) << "push called on a full queue";
+  CHECK_EQ(size, width_) << "unexpected input size";
+  memcpy(slot(head), data, size);
+  head_->store(head + 1, std::memory_order_release);
+  Notify(not_empty_seq_, consumer_waiting_);
+}
+
+bool SharedMemoryQueue::wait_not_empty(std::chrono::nanoseconds timeout) const {
+  return Wait([this] { return !empty(); }, not_empty_seq_, consumer_waiting_,
+              timeout);
 }
 
-size_t SharedMemoryQueue::mmap_len() const {
-  return sizeof(*this) + depth_ * width_;
+bool SharedMemoryQueue::wait_not_full(std::chrono::nanoseconds timeout) const {
+  return Wait([this] { return !full(); }, not_full_seq_, producer_waiting_,
+              timeout);
+}
+
+char* SharedMemoryQueue::slot(int64_t index) const {
+  const int64_t slot_index =
+      version_ == kVersion1 ? index % depth_ : index & slot_mask_;
+  return data_ + slot_index * stride_;
+}
+
+int64_t SharedMemoryQueue::ProducerSize(int64_t head) const {
+  if (head - cached_tail_ >= depth_) {
+    cached_tail_ = tail_->load(std::memory_order_acquire);
+  }
+  return head - cached_tail_;
+}
+
+int64_t SharedMemoryQueue::ConsumerSize(int64_t tail) const {
+  if (cached_head_ - tail <= 0) {
+    cached_head_ = head_->load(std::memory_order_acquire);
+  }
+  return cached_head_ - tail;
 }
 
 }  // namespace internal
@@ -9,6 +9,7 @@
 #include <cstring>
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
 
@@ -16,6 +17,27 @@ namespace fpga {
 namespace internal {
 
 // Shared-memory lock-free SPSC queue with fixed depth and width.
+//
+// Two layouts of the shared memory object are supported. Version 1 packs the
+// header, `tail`, and `head` into 32 bytes followed by the elements. Version 2
+// places the header, `head` (written by the producer), and `tail` (written by
+// the consumer) on separate cache lines and rounds the number of slots up to a
+// power of two. Each side caches the index written by the other side, so the
+// shared cache lines are only touched when the queue looks full or empty.
+// Version 3 has the layout of version 2, but pads each element to a multiple of
+// 8 bytes, or of a cache line if the element is at least that wide, so that
+// wide elements (e.g., a 512-bit token plus its EoT bit) do not straddle cache
+// lines unevenly and are copied with aligned accesses. `CreateFile` creates
+// version 3 by default; `New` accepts all versions, so the consumer follows
+// whatever layout the producer picked.
+//
+// Either side may sleep until the other side makes progress with
+// `wait_not_empty` and `wait_not_full`. Version 2 and 3 queues use futexes in
+// the shared memory object, which are only signaled while someone is waiting;
+// version 1 queues fall back to polling.
+//
+// `empty`, `front*`, and `pop*` belong to the consumer, while `full` and `push`
+// belong to the producer. Each role must stay on one thread per queue object.
 class SharedMemoryQueue {
   struct Deleter {
     void operator()(SharedMemoryQueue* ptr);
@@ -24,45 +46,118 @@ class SharedMemoryQueue {
  public:
   using UniquePtr = std::unique_ptr<SharedMemoryQueue, Deleter>;
 
+  static constexpr int32_t kVersion1 = 1;
+  static constexpr int32_t kVersion2 = 2;
+  static constexpr int32_t kVersion3 = 3;
+
   // Returns `nullptr` on failure with logging.
   static UniquePtr New(int fd);
 
+  // Same as `New(int)`, but uses `size` bytes at `addr` that the caller has
+  // mapped, e.g., a part of a larger shared memory object, which must stay
+  // mapped while the returned queue is alive.
+  static UniquePtr New(void* addr, size_t size);
+
+  // Returns the size in bytes of the shared memory backing a queue.
+  static size_t GetSize(int32_t depth, int32_t width,
+                        int32_t version = kVersion3);
+
+  // Initializes an empty queue in `GetSize(depth, width, version)` bytes at
+  // `addr`, which must be aligned to a cache line. The memory may have held
+  // another queue before.
+  static void Init(void* addr, int32_t depth, int32_t width,
+                   int32_t version = kVersion3);
+
   // Creates (using `shm_open`) a shared memory object suitable for backing a
   // `SharedMemoryQueue` and returns the corresponding file descriptor, with
   // `path_template` modified to the path of the created shared memory object.
   // Returns a negative fd on failure with the corresponding errno and logging.
   static int CreateFile(std::string& path_template, int32_t depth,
-                        int32_t width);
+                        int32_t width, int32_t version = kVersion3);
 
   // Not copyable or movable.
   SharedMemoryQueue(const SharedMemoryQueue&) = delete;
   SharedMemoryQueue* operator=(const SharedMemoryQueue&) = delete;
 
+  int32_t version() const;
   int64_t size() const;
   int64_t capacity() const;
   int64_t width() const;
+
+  // Distance in bytes between consecutive elements in the shared memory
+  // object, which is `width()` rounded up to the alignment of the layout.
+  int64_t stride() const;
+
   bool empty() const;
   bool full() const;
   std::string front() const;
   std::string pop();
   void push(const std::string& val);
 
+  // Copies the front element to `data`, which must have room for `width()`
+  // bytes, without allocation.
+  void front_into(void* data) const;
+
+  // Same as `front_into`, but also removes the front element.
+  void pop_into(void* data);
+
+  // Copies `size` bytes from `data` into the queue as a new element without
+  // allocation. `size` must equal `width()`.
+  void push(const void* data, size_t size);
+
+  // Blocks the consumer until the queue is not empty or `timeout` passes.
+  // Returns whether the queue is not empty.
+  bool wait_not_empty(
+      std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) const;
+
+  // Blocks the producer until the queue is not full or `timeout` passes.
+  // Returns whether the queue is not full.
+  bool wait_not_full(
+      std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) const;
+
  private:
   explicit SharedMemoryQueue() = default;
 
-  size_t mmap_len() const;
+  char* slot(int64_t index) const;
+
+  // Returns the number of elements, reloading `tail_` only if the queue looks
+  // full with the cached value.
+  int64_t ProducerSize(int64_t head) const;
+
+  // Returns the number of elements, reloading `head_` only if the queue looks
+  // empty with the cached value.
+  int64_t ConsumerSize(int64_t tail) const;
+
+  // Initializes the fields from the valid layout at `addr`.
+  static UniquePtr Attach(char* addr, const void* header);
+
+  // Mapped shared memory object. `mmap_len_` is 0 if the memory is mapped by
+  // the caller of `New(void*, size_t)`.
+  char* addr_ = nullptr;
+  size_t mmap_len_ = 0;
 
-  char magic_[4] = {};
   int32_t version_ = 0;
-  int32_t depth_ = 0;
-  int32_t width_ = 0;
-  std::atomic<int64_t> tail_{};
-  std::atomic<int64_t> head_{};
-  char data_[];
+  int64_t depth_ = 0;
+  int64_t width_ = 0;
+  int64_t stride_ = 0;
+  int64_t slot_mask_ = 0;  // Version 2 and 3 only.
+  std::atomic<int64_t>* head_ = nullptr;
+  std::atomic<int64_t>* tail_ = nullptr;
+  char* data_ = nullptr;
+
+  // Futex words bumped when a waiting consumer or producer must wake up, and
+  // flags telling whether one is waiting. Version 2 and 3 only.
+  std::atomic<uint32_t>* not_empty_seq_ = nullptr;
+  std::atomic<uint32_t>* consumer_waiting_ = nullptr;
+  std::atomic<uint32_t>* not_full_seq_ = nullptr;
+  std::atomic<uint32_t>* producer_waiting_ = nullptr;
+
+  // Local copies of the indices written by the other side. They never run
+  // ahead of the shared indices, so stale values are merely conservative.
+  mutable int64_t cached_tail_ = 0;  // Used by the producer.
+  mutable int64_t cached_head_ = 0;  // Used by the consumer.
 };
 
-static_assert(sizeof(SharedMemoryQueue) == 32);
-
 }  // namespace internal
 }  // namespace fpga
 
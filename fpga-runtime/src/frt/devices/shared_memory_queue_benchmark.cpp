@@ -0,0 +1,95 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/devices/shared_memory_queue.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+#include <glog/logging.h>
+
+namespace fpga::internal {
+namespace {
+
+// A shared memory queue that is unlinked when destroyed.
+class TempQueue {
+ public:
+  TempQueue(int32_t depth, int32_t width)
+      : fd_(SharedMemoryQueue::CreateFile(path_, depth, width)),
+        queue_(SharedMemoryQueue::New(fd_)) {}
+  ~TempQueue() {
+    queue_.reset();
+    PLOG_IF(WARNING, close(fd_) != 0) << "close";
+    PLOG_IF(ERROR, shm_unlink(path_.c_str()) != 0) << "shm_unlink";
+  }
+
+  SharedMemoryQueue* operator->() const { return queue_.get(); }
+
+ private:
+  std::string path_ = "/shared_memory_queue_benchmark.XXXXXX";
+  const int fd_;
+  SharedMemoryQueue::UniquePtr queue_;
+};
+
+void QueueArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"width", "depth"});
+  for (int64_t width : {4, 64, 512}) {
+    for (int64_t depth : {2, 64, 1024}) b->Args({width, depth});
+  }
+}
+
+// Pushes and then pops `depth` tokens in a single process, which measures the
+// cost of the operations without contention.
+void BM_SharedMemoryQueuePushPop(benchmark::State& state) {
+  const int64_t width = state.range(0);
+  const int64_t depth = state.range(1);
+  TempQueue queue(depth, width);
+  std::vector<char> val(width);
+  for (auto _ : state) {
+    for (int64_t i = 0; i < depth; ++i) queue->push(val.data(), width);
+    for (int64_t i = 0; i < depth; ++i) queue->pop_into(val.data());
+  }
+  state.SetItemsProcessed(state.iterations() * depth);
+  state.SetBytesProcessed(state.iterations() * depth * width);
+}
+BENCHMARK(BM_SharedMemoryQueuePushPop)->Apply(QueueArgs);
+
+// Streams tokens to a child process, like the host does to the simulator.
+void BM_SharedMemoryQueueCrossProcess(benchmark::State& state) {
+  const int64_t width = state.range(0);
+  const int64_t depth = state.range(1);
+  TempQueue queue(depth, width);
+  std::vector<char> val(width);
+  const int64_t n = state.max_iterations;
+  const pid_t pid = fork();
+  PCHECK(pid >= 0) << "fork";
+  if (pid == 0) {
+    for (int64_t i = 0; i < n; ++i) {
+      queue->wait_not_empty();
+      queue->pop_into(val.data());
+    }
+    _exit(0);
+  }
+  for (auto _ : state) {
+    queue->wait_not_full();
+    queue->push(val.data(), width);
+  }
+  int status;
+  PCHECK(waitpid(pid, &status, 0) == pid) << "waitpid";
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    state.SkipWithError("consumer failed");
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * width);
+}
+BENCHMARK(BM_SharedMemoryQueueCrossProcess)->Apply(QueueArgs)->UseRealTime();
+
+}  // namespace
+}  // namespace fpga::internal
@@ -4,6 +4,9 @@
 
 #include "frt/devices/shared_memory_queue.h"
 
+#include <chrono>
+#include <thread>
+
 #include <sys/mman.h>
 
 #include <glog/logging.h>
@@ -39,6 +42,24 @@ TEST_F(SharedMemoryQueueTest, PushAndPopSucceeds) {
   EXPECT_EQ(queue_->pop(), val);
 }
 
+TEST_F(SharedMemoryQueueTest, PushAndPopIntoSucceeds) {
+  const char val[kWidth] = {'v', 'a', 'l'};
+  char front[kWidth] = {};
+  char popped[kWidth] = {};
+
+  queue_->push(val, sizeof(val));
+  queue_->front_into(front);
+  queue_->pop_into(popped);
+  EXPECT_EQ(std::string(front, kWidth), "val");
+  EXPECT_EQ(std::string(popped, kWidth), "val");
+  EXPECT_TRUE(queue_->empty());
+}
+
+TEST_F(SharedMemoryQueueTest, PushFailsWithInvalidSize) {
+  const char val[] = "too long";
+  EXPECT_DEATH(queue_->push(val, sizeof(val)), "unexpected input size");
+}
+
 TEST_F(SharedMemoryQueueTest, PushFailsWithInvalidInput) {
   EXPECT_DEATH(queue_->push("too long"), "unexpected input");
 }
@@ -57,7 +78,9 @@ TEST_F(SharedMemoryQueueTest, PopFailsWhenEmpty) {
 }
 
 TEST_F(SharedMemoryQueueTest, GettersSucceed) {
+  EXPECT_EQ(queue_->version(), SharedMemoryQueue::kVersion3);
   EXPECT_EQ(queue_->width(), kWidth);
+  EXPECT_EQ(queue_->stride(), 8);
   EXPECT_EQ(queue_->capacity(), kDepth);
   EXPECT_EQ(queue_->size(), 0);
 
@@ -65,5 +88,119 @@ TEST_F(SharedMemoryQueueTest, GettersSucceed) {
   EXPECT_EQ(queue_->size(), 1);
 }
 
+TEST_F(SharedMemoryQueueTest, WaitNotEmptyTimesOut) {
+  EXPECT_FALSE(queue_->wait_not_empty(std::chrono::milliseconds(1)));
+}
+
+TEST_F(SharedMemoryQueueTest, WaitNotEmptyWakesUpOnPush) {
+  std::thread producer([this] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    queue_->push("val");
+  });
+  EXPECT_TRUE(queue_->wait_not_empty());
+  EXPECT_EQ(queue_->pop(), "val");
+  producer.join();
+}
+
+TEST_F(SharedMemoryQueueTest, WaitNotFullWakesUpOnPop) {
+  queue_->push("val");
+  queue_->push("val");
+  std::thread consumer([this] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    queue_->pop();
+  });
+  EXPECT_TRUE(queue_->wait_not_full());
+  EXPECT_FALSE(queue_->full());
+  consumer.join();
+}
+
+TEST(SharedMemoryQueueVersionTest, Version1RemainsSupported) {
+  std::string temp_file = "/shared_memory_queue.XXXXXX";
+  int fd = SharedMemoryQueue::CreateFile(temp_file, kDepth, kWidth,
+                                         SharedMemoryQueue::kVersion1);
+  ASSERT_GE(fd, 0);
+  {
+    SharedMemoryQueue::UniquePtr queue = SharedMemoryQueue::New(fd);
+    ASSERT_NE(queue, nullptr);
+    EXPECT_EQ(queue->version(), SharedMemoryQueue::kVersion1);
+
+    for (int i = 0; i < kDepth * 3; ++i) {
+      const std::string val = "v" + std::to_string(i % 10) + "l";
+      queue->push(val);
+      EXPECT_EQ(queue->pop(), val);
+    }
+  }
+  PLOG_IF(WARNING, close(fd) != 0) << "close";
+  PLOG_IF(ERROR, shm_unlink(temp_file.c_str())) << "shm_unlink";
+}
+
+TEST(SharedMemoryQueueVersionTest, Version2RemainsSupported) {
+  std::string temp_file = "/shared_memory_queue.XXXXXX";
+  int fd = SharedMemoryQueue::CreateFile(temp_file, kDepth, kWidth,
+                                         SharedMemoryQueue::kVersion2);
+  ASSERT_GE(fd, 0);
+  {
+    SharedMemoryQueue::UniquePtr queue = SharedMemoryQueue::New(fd);
+    ASSERT_NE(queue, nullptr);
+    EXPECT_EQ(queue->version(), SharedMemoryQueue::kVersion2);
+    EXPECT_EQ(queue->stride(), kWidth);
+
+    for (int i = 0; i < kDepth * 3; ++i) {
+      const std::string val = "v" + std::to_string(i % 10) + "l";
+      queue->push(val);
+      EXPECT_EQ(queue->pop(), val);
+    }
+  }
+  PLOG_IF(WARNING, close(fd) != 0) << "close";
+  PLOG_IF(ERROR, shm_unlink(temp_file.c_str())) << "shm_unlink";
+}
+
+TEST(SharedMemoryQueueVersionTest, Version3AlignsWideElements) {
+  constexpr int kWideWidth = 513;  // A 512-bit token plus its EoT bit.
+  std::string temp_file = "/shared_memory_queue.XXXXXX";
+  int fd = SharedMemoryQueue::CreateFile(temp_file, kDepth, kWideWidth);
+  ASSERT_GE(fd, 0);
+  {
+    SharedMemoryQueue::UniquePtr queue = SharedMemoryQueue::New(fd);
+    ASSERT_NE(queue, nullptr);
+    EXPECT_EQ(queue->width(), kWideWidth);
+    EXPECT_EQ(queue->stride(), 576);
+
+    for (int i = 0; i < kDepth * 3; ++i) {
+      const std::string val(kWideWidth, '0' + i % 2);
+      queue->push(val);
+      EXPECT_EQ(queue->pop(), val);
+    }
+  }
+  PLOG_IF(WARNING, close(fd) != 0) << "close";
+  PLOG_IF(ERROR, shm_unlink(temp_file.c_str())) << "shm_unlink";
+}
+
+TEST(SharedMemoryQueueVersionTest, Version2KeepsNonPowerOfTwoCapacity) {
+  constexpr int kOddDepth = 3;
+  std::string temp_file = "/shared_memory_queue.XXXXXX";
+  int fd = SharedMemoryQueue::CreateFile(temp_file, kOddDepth, kWidth);
+  ASSERT_GE(fd, 0);
+  {
+    SharedMemoryQueue::UniquePtr queue = SharedMemoryQueue::New(fd);
+    ASSERT_NE(queue, nullptr);
+    EXPECT_EQ(queue->capacity(), kOddDepth);
+
+    // Wrap around the power-of-two ring a few times.
+    for (int round = 0; round < 4; ++round) {
+      for (int i = 0; i < kOddDepth; ++i) {
+        queue->push("v" + std::to_string(i) + "l");
+      }
+      EXPECT_TRUE(queue->full());
+      for (int i = 0; i < kOddDepth; ++i) {
+        EXPECT_EQ(queue->pop(), "v" + std::to_string(i) + "l");
+      }
+      EXPECT_TRUE(queue->empty());
+    }
+  }
+  PLOG_IF(WARNING, close(fd) != 0) << "close";
+  PLOG_IF(ERROR, shm_unlink(temp_file.c_str())) << "shm_unlink";
+}
+
 }  // namespace
 }  // namespace fpga::internal
@@ -4,8 +4,15 @@
 
 #include "frt/devices/shared_memory_stream.h"
 
+#include <cstdlib>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <utility>
 
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -16,12 +23,146 @@
 namespace fpga {
 namespace internal {
 
-SharedMemoryStream::SharedMemoryStream(Options options)
-    : path_(std::move(options.path_template)),
-      fd_(SharedMemoryQueue::CreateFile(path_, options.depth, options.width)),
-      queue_(SharedMemoryQueue::New(fd_)) {}
+namespace {
+
+// Arenas are sized in huge pages so that they may be backed by them.
+constexpr size_t kHugePageSize = 2 << 20;
+constexpr size_t kMinArenaSize = kHugePageSize * 8;
+
+// Queues start on separate cache lines.
+constexpr size_t kSlotAlignment = 64;
+
+size_t RoundUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+std::shared_ptr<SharedMemoryQueuePool> SharedMemoryQueuePool::Get() {
+  // Kept until exit so that arenas are reused across invocations. Streams
+  // that outlive this reference keep the pool until they are destroyed.
+  static const std::shared_ptr<SharedMemoryQueuePool> instance =
+      std::make_shared<SharedMemoryQueuePool>();
+  return instance;
+}
+
+SharedMemoryQueuePool::~SharedMemoryQueuePool() {
+  for (const Arena& arena : arenas_) {
+    PLOG_IF(WARNING, munmap(arena.addr, arena.size)) << __func__ << ": munmap";
+    PLOG_IF(WARNING, shm_unlink(arena.path.c_str()))
+        << __func__ << ": shm_unlink";
+  }
+}
+
+SharedMemoryQueuePool::Slot SharedMemoryQueuePool::Allocate(int32_t depth,
+                                                            int32_t width) {
+  const size_t size =
+      RoundUp(SharedMemoryQueue::GetSize(depth, width), kSlotAlignment);
+  Slot slot;
+  char* addr;
+  {
+    std::unique_lock lock(mtx_);
+    if (auto it = free_slots_.find(size);
+        it != free_slots_.end() && !it->second.empty()) {
+      slot = it->second.back();
+      it->second.pop_back();
+    } else {
+      int arena = arenas_.empty() ? -1 : int(arenas_.size()) - 1;
+      if (arena < 0 || arenas_[arena].size - arenas_[arena].used < size) {
+        arena = NewArena(size);
+        if (arena < 0) {
+          return slot;
+        }
+      }
+      slot = {
+          .arena = arena,
+          .offset = arenas_[arena].used,
+          .size = size,
+      };
+      arenas_[arena].used += size;
+    }
+    addr = arenas_[slot.arena].addr + slot.offset;
+  }
+  SharedMemoryQueue::Init(addr, depth, width);
+  return slot;
+}
+
+void SharedMemoryQueuePool::Release(const Slot& slot) {
+  std::unique_lock lock(mtx_);
+  free_slots_[slot.size].push_back(slot);
+}
+
+SharedMemoryQueue::UniquePtr SharedMemoryQueuePool::GetQueue(
+    const Slot& slot) const {
+  std::unique_lock lock(mtx_);
+  return SharedMemoryQueue::New(arenas_[slot.arena].addr + slot.offset,
+                                slot.size);
+}
+
+std::string SharedMemoryQueuePool::GetDescriptor(const Slot& slot) const {
+  std::unique_lock lock(mtx_);
+  return arenas_[slot.arena].path + "@" + std::to_string(slot.offset);
+}
+
+int SharedMemoryQueuePool::NewArena(size_t size) {
+  size = RoundUp(std::max(size, kMinArenaSize), kHugePageSize);
+  std::string path = "/tapa_queue_pool.XXXXXX";
+  const int fd = shm_open(mktemp(&path[0]), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    PLOG(ERROR) << "shm_open";
+    return -1;
+  }
+
+  void* addr = MAP_FAILED;
+  if (ftruncate(fd, size) == 0) {
+    addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                /*offset=*/0);
+    PLOG_IF(ERROR, addr == MAP_FAILED) << "mmap";
+  } else {
+    PLOG(ERROR) << "ftruncate";
+  }
+  PLOG_IF(ERROR, close(fd)) << "close";
+  if (addr == MAP_FAILED) {
+    PLOG_IF(ERROR, shm_unlink(path.c_str())) << "shm_unlink";
+    return -1;
+  }
+
+  // Huge pages are only used if `shmem_enabled` of transparent huge pages
+  // allows; queues work the same either way.
+  PLOG_IF(INFO, madvise(addr, size, MADV_HUGEPAGE)) << "madvise";
+
+  VLOG(1) << "created shared memory arena " << path << " of " << size
+          << " bytes";
+  arenas_.push_back({
+      .path = std::move(path),
+      .addr = static_cast<char*>(addr),
+      .size = size,
+      .used = 0,
+  });
+  return arenas_.size() - 1;
+}
+
+SharedMemoryStream::SharedMemoryStream(Options options) {
+  if (options.path_template.empty()) {
+    pool_ = SharedMemoryQueuePool::Get();
+    slot_ = pool_->Allocate(options.depth, options.width);
+    if (slot_.arena >= 0) {
+      path_ = pool_->GetDescriptor(slot_);
+      queue_ = pool_->GetQueue(slot_);
+    }
+    return;
+  }
+
+  path_ = std::move(options.path_template);
+  fd_ = SharedMemoryQueue::CreateFile(path_, options.depth, options.width);
+  queue_ = SharedMemoryQueue::New(fd_);
+}
 
 SharedMemoryStream::~SharedMemoryStream() {
+  queue_.reset();
+  if (pool_ != nullptr && slot_.arena >= 0) {
+    pool_->Release(slot_);
+  }
   if (fd_ >= 0) {
     PLOG_IF(WARNING, shm_unlink(path_.c_str())) << __func__ << ": shm_unlink";
     PLOG_IF(WARNING, close(fd_)) << __func__ << ": close";
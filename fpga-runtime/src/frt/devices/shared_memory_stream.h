@@ -5,15 +5,78 @@
 #ifndef FPGA_RUNTIME_SHARED_MEMORY_STREAM_H_
 #define FPGA_RUNTIME_SHARED_MEMORY_STREAM_H_
 
+#include <cstddef>
 #include <cstdint>
 
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "frt/devices/shared_memory_queue.h"
 
 namespace fpga {
 namespace internal {
 
+// Carves `SharedMemoryQueue`s out of a few large shared memory objects
+// (arenas), so that creating a queue does not create and map a shared memory
+// object of its own. Arenas are backed by huge pages where the system allows.
+// Memory of released queues is reused by later queues of the same size, e.g.,
+// in later invocations of a kernel.
+//
+// A queue is located by the descriptor `<arena path>@<offset>`, which the
+// simulator resolves by mapping each arena once.
+class SharedMemoryQueuePool {
+ public:
+  struct Slot {
+    int arena = -1;
+    size_t offset = 0;
+    size_t size = 0;
+  };
+
+  // Returns the process-wide pool, which lives as long as any of its users.
+  static std::shared_ptr<SharedMemoryQueuePool> Get();
+
+  SharedMemoryQueuePool() = default;
+
+  // Not copyable or movable.
+  SharedMemoryQueuePool(const SharedMemoryQueuePool&) = delete;
+  SharedMemoryQueuePool& operator=(const SharedMemoryQueuePool&) = delete;
+
+  ~SharedMemoryQueuePool();
+
+  // Initializes an empty queue in the pool and returns its slot, or a slot
+  // with a negative `arena` on failure with logging.
+  Slot Allocate(int32_t depth, int32_t width);
+
+  // Returns the memory of `slot` to the pool. Queues in the slot must have
+  // been destroyed.
+  void Release(const Slot& slot);
+
+  // Returns the queue in `slot`, which must be released after it.
+  SharedMemoryQueue::UniquePtr GetQueue(const Slot& slot) const;
+
+  // Returns the descriptor of `slot` for the simulator.
+  std::string GetDescriptor(const Slot& slot) const;
+
+ private:
+  struct Arena {
+    std::string path;
+    char* addr = nullptr;
+    size_t size = 0;
+    size_t used = 0;
+  };
+
+  // Maps a new arena of at least `size` bytes and returns its index, or -1 on
+  // failure.
+  int NewArena(size_t size);
+
+  mutable std::mutex mtx_;
+  std::vector<Arena> arenas_;
+  std::unordered_map<size_t, std::vector<Slot>> free_slots_;  // By size.
+};
+
 // Wrapper of `SharedMemoryQueue` that manages the backing file's path and fd.
 class SharedMemoryStream {
  public:
@@ -21,8 +84,10 @@ class SharedMemoryStream {
     int64_t depth = 0;
     int64_t width = 0;
 
-    // This will be consumed by `shm_open`.
-    std::string path_template = "/shared_memory_queue.XXXXXX";
+    // If set, the queue is backed by a shared memory object of its own,
+    // created by `shm_open` with this template. Otherwise, the queue is carved
+    // out of `SharedMemoryQueuePool`.
+    std::string path_template;
   };
 
   explicit SharedMemoryStream(Options options);
@@ -33,12 +98,16 @@ class SharedMemoryStream {
 
   ~SharedMemoryStream();
 
+  // Path of the shared memory object, or the descriptor of the queue in the
+  // pool; see `SharedMemoryQueuePool`.
   const std::string& path() const;
   SharedMemoryQueue* queue() const;
 
  private:
   std::string path_;
   int fd_ = -1;
+  std::shared_ptr<SharedMemoryQueuePool> pool_;
+  SharedMemoryQueuePool::Slot slot_;
   SharedMemoryQueue::UniquePtr queue_;
 };
 
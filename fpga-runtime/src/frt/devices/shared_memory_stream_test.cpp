@@ -6,6 +6,11 @@
 
 #include <string>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 
 #include "frt/devices/shared_memory_queue.h"
@@ -30,6 +35,57 @@ TEST(SharedMemoryStreamTest, CreateStreamSucceeds) {
   EXPECT_EQ(queue->pop(), val);
 }
 
+TEST(SharedMemoryStreamTest, PooledStreamIsSharedThroughDescriptor) {
+  SharedMemoryStream stream({
+      .depth = kDepth,
+      .width = kWidth,
+  });
+  const std::string& path = stream.path();
+  const std::string::size_type pos = path.find('@');
+  ASSERT_NE(pos, std::string::npos) << path;
+
+  // Maps the arena as the simulator does.
+  const int fd = shm_open(path.substr(0, pos).c_str(), O_RDWR, 0600);
+  ASSERT_GE(fd, 0);
+  struct stat st;
+  ASSERT_EQ(fstat(fd, &st), 0);
+  void* addr =
+      mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ASSERT_NE(addr, MAP_FAILED);
+  close(fd);
+  const size_t offset = std::stoull(path.substr(pos + 1));
+  {
+    SharedMemoryQueue::UniquePtr peer = SharedMemoryQueue::New(
+        static_cast<char*>(addr) + offset, st.st_size - offset);
+    ASSERT_NE(peer, nullptr);
+    EXPECT_EQ(peer->capacity(), kDepth);
+    EXPECT_EQ(peer->width(), kWidth);
+
+    stream.queue()->push("foo");
+    EXPECT_EQ(peer->pop(), "foo");
+  }
+  munmap(addr, st.st_size);
+}
+
+TEST(SharedMemoryStreamTest, PooledStreamReusesReleasedQueue) {
+  std::string path;
+  {
+    SharedMemoryStream stream({
+        .depth = kDepth,
+        .width = kWidth,
+    });
+    path = stream.path();
+    stream.queue()->push("foo");
+  }
+
+  SharedMemoryStream stream({
+      .depth = kDepth,
+      .width = kWidth,
+  });
+  EXPECT_EQ(stream.path(), path);
+  EXPECT_TRUE(stream.queue()->empty());
+}
+
 TEST(SharedMemoryStreamTest, CreateStreamFailsWithInvalidPathTemplate) {
   SharedMemoryStream stream({
       .depth = kDepth,
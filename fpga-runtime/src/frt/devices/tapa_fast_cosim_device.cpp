@@ -5,19 +5,26 @@
 #include "frt/devices/tapa_fast_cosim_device.h"
 
 #include <cstdlib>
+#include <cstring>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <ios>
 #include <iostream>
 #include <memory>
+#include <new>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <tinyxml2.h>
 #include <unistd.h>
 
@@ -28,10 +35,12 @@
 #include "frt/arg_info.h"
 #include "frt/devices/filesystem.h"
 #include "frt/devices/shared_memory_stream.h"
+#include "frt/devices/tapa_fast_cosim_shm.h"
 #include "frt/devices/xilinx_environ.h"
 #include "frt/stream_arg.h"
 #include "frt/subprocess.h"
-#include "frt/zip_file.h"
+#include "frt/trace.h"
+#include "frt/zip_reader.h"
 
 DEFINE_bool(xosim_start_gui, false, "start Vivado GUI for simulation");
 DEFINE_bool(xosim_save_waveform, false, "save waveform in the work directory");
@@ -46,6 +55,28 @@ DEFINE_string(xosim_part_num, "",
 DEFINE_bool(xosim_setup_only, false, "only setup the simulation");
 DEFINE_bool(xosim_resume_from_post_sim, false,
             "skip simulation and do post-sim checking");
+DEFINE_int32(xosim_stream_batch_size, 64,
+             "maximum number of stream tokens the simulator exchanges with "
+             "the host per DPI call; 1 exchanges tokens one by one");
+DEFINE_string(xosim_snapshot_cache_dir, "",
+              "if not empty, compile the simulation snapshot once per xo in "
+              "the specified directory and reuse it for later runs with "
+              "different data");
+DEFINE_string(xosim_simulator, "xsim",
+              "simulator running the cosimulation; `xsim` or `verilator`");
+DEFINE_int32(xosim_verilator_threads, 1,
+             "number of threads the Verilator model evaluates with");
+DEFINE_bool(xosim_force_rebuild, false,
+            "rerun every simulation stage in --xosim_work_dir even if its "
+            "inputs are unchanged since the last run");
+DEFINE_string(xosim_axi_ram_timing, "",
+              "latency, bandwidth, and row buffer model of the memory behind "
+              "AXI RAMs, e.g., `ddr4` or `hbm,a:read_latency=200`; ideal if "
+              "empty");
+DEFINE_bool(xosim_use_data_files, false,
+            "exchange buffers with the simulator via data files in the work "
+            "directory instead of shared memory; implied by "
+            "--xosim_resume_from_post_sim");
 
 namespace fpga {
 namespace internal {
@@ -79,28 +110,48 @@ std::string GetConfigPath(const std::string& work_dir) {
   return work_dir + "/config.json";
 }
 
-}  // namespace
+std::string GetTbOutputDir(const std::string& work_dir) {
+  return work_dir + "/output";
+}
 
-struct TapaFastCosimDevice::Context {
-  std::chrono::time_point<std::chrono::steady_clock> start_timestamp;
-  subprocess::Popen proc;
-};
+// Written by the testbench; see `get_port_stats` in `tapa/cosim/templates.py`.
+std::string GetPortStatsPath(const std::string& work_dir) {
+  return GetTbOutputDir(work_dir) + "/port_stats.json";
+}
 
-TapaFastCosimDevice::TapaFastCosimDevice(std::string_view xo_path)
-    : xo_path(fs::absolute(xo_path)), work_dir(GetWorkDirectory()) {
-  miniz_cpp::zip_file xo_file = this->xo_path;
-  std::string kernel_xml;
-  for (auto& info : xo_file.infolist()) {
-    constexpr std::string_view kSuffix = "/kernel.xml";
-    if (info.filename.size() >= kSuffix.size() &&
-        std::equal(kSuffix.rbegin(), kSuffix.rend(), info.filename.rbegin())) {
-      kernel_xml = xo_file.read(info);
-      break;
-    }
+// Written by the testbench; see `get_port_stats` in `tapa/cosim/templates.py`.
+std::string GetPortTracePath(const std::string& work_dir) {
+  return GetTbOutputDir(work_dir) + "/port_trace.csv";
+}
+
+std::string GetArgName(const std::vector<ArgInfo>& args, int index) {
+  for (const ArgInfo& arg : args) {
+    if (arg.index == index) return arg.name;
   }
-  LOG_IF(FATAL, kernel_xml.empty())
+  return std::to_string(index);
+}
+
+// Reads the argument metadata written by `tapa pack` next to the xo file.
+std::optional<std::vector<ArgInfo>> ReadArgsFile(const std::string& xo_path) {
+  const std::string path = xo_path + ".args";
+  std::ifstream file(path);
+  if (!file) return std::nullopt;
+  std::optional<std::vector<ArgInfo>> args =
+      ParseArgsFile(file, fs::file_size(xo_path));
+  LOG_IF(INFO, !args.has_value())
+      << "ignoring '" << path << "' written for another xo";
+  return args;
+}
+
+std::vector<ArgInfo> ReadKernelXml(const std::string& xo_path) {
+  // Only extract the metadata; XOs of large designs are hundreds of MiB.
+  ZipReader xo_file(xo_path);
+  const ZipReader::Entry* entry = xo_file.FindBySuffix("/kernel.xml");
+  LOG_IF(FATAL, entry == nullptr)
       << "Missing 'kernel.xml' in '" << xo_path << "'";
+  const std::string kernel_xml = xo_file.Read(*entry);
 
+  std::vector<ArgInfo> args;
   tinyxml2::XMLDocument doc;
   doc.Parse(kernel_xml.data());
   for (const tinyxml2::XMLElement* xml_arg = doc.FirstChildElement("root")
@@ -110,25 +161,85 @@ TapaFastCosimDevice::TapaFastCosimDevice(std::string_view xo_path)
        xml_arg != nullptr; xml_arg = xml_arg->NextSiblingElement("arg")) {
     ArgInfo arg;
     arg.index = atoi(xml_arg->Attribute("id"));
-    LOG_IF(FATAL, arg.index != args_.size())
-        << "Expecting argument #" << args_.size() << ", got argument #"
+    LOG_IF(FATAL, arg.index != args.size())
+        << "Expecting argument #" << args.size() << ", got argument #"
         << arg.index << " in the metadata";
     arg.name = xml_arg->Attribute("name");
     arg.type = xml_arg->Attribute("type");
-    switch (int cat = atoi(xml_arg->Attribute("addressQualifier")); cat) {
-      case 0:
-        arg.cat = ArgInfo::kScalar;
-        break;
-      case 1:
-        arg.cat = ArgInfo::kMmap;
-        break;
-      case 4:
-        arg.cat = ArgInfo::kStream;
-        break;
-      default:
-        LOG(WARNING) << "Unknown argument category: " << cat;
+    arg.cat = GetArgCat(atoi(xml_arg->Attribute("addressQualifier")));
+    args.push_back(arg);
+  }
+  return args;
+}
+
+int64_t ToNs(clock::time_point time) {
+  return std::chrono::nanoseconds(time.time_since_epoch()).count();
+}
+
+// Creates a POSIX shared memory object of `size` bytes at `path` and maps it.
+void* CreateSharedMemory(const std::string& path, size_t size) {
+  int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  PLOG_IF(FATAL, fd < 0) << "shm_open: " << path;
+  PLOG_IF(FATAL, ftruncate(fd, size) != 0) << "ftruncate";
+  void* addr = nullptr;
+  if (size > 0) {
+    addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                /*offset=*/0);
+    PLOG_IF(FATAL, addr == MAP_FAILED) << "mmap";
+  }
+  PLOG_IF(ERROR, close(fd)) << "close";
+  return addr;
+}
+
+bool UseDataFiles() {
+  // Data files outlive the simulator so that post-sim checking can resume.
+  return FLAGS_xosim_use_data_files || FLAGS_xosim_resume_from_post_sim;
+}
+
+}  // namespace
+
+struct TapaFastCosimDevice::Context {
+  std::chrono::time_point<std::chrono::steady_clock> start_timestamp;
+  subprocess::Popen proc;
+};
+
+// A POSIX shared memory object holding the content of one AXI RAM. The
+// simulator maps the same object and reads and writes it in place, so buffers
+// never round-trip through the file system.
+struct TapaFastCosimDevice::SharedMemoryBuffer {
+  explicit SharedMemoryBuffer(size_t size) : size(size) {
+    data = static_cast<char*>(CreateSharedMemory(mktemp(&path[0]), size));
+    written_bytes = new (CreateSharedMemory(GetAxiRamProgressPath(path),
+                                            sizeof(std::atomic<uint64_t>)))
+        std::atomic<uint64_t>(0);
+  }
+  SharedMemoryBuffer(const SharedMemoryBuffer&) = delete;
+  SharedMemoryBuffer& operator=(const SharedMemoryBuffer&) = delete;
+
+  ~SharedMemoryBuffer() {
+    if (data != nullptr) {
+      PLOG_IF(ERROR, munmap(data, size)) << "munmap";
     }
-    args_.push_back(arg);
+    PLOG_IF(ERROR, munmap(written_bytes, sizeof(*written_bytes))) << "munmap";
+    PLOG_IF(ERROR, shm_unlink(path.c_str())) << "shm_unlink";
+    PLOG_IF(ERROR, shm_unlink(GetAxiRamProgressPath(path).c_str()))
+        << "shm_unlink";
+  }
+
+  std::string path = "/tapa-fast-cosim-axi.XXXXXX";
+  char* data = nullptr;
+  const size_t size;
+
+  // Bytes the simulator has written to `data` since the invocation started.
+  std::atomic<uint64_t>* written_bytes = nullptr;
+};
+
+TapaFastCosimDevice::TapaFastCosimDevice(std::string_view xo_path)
+    : xo_path(fs::absolute(xo_path)), work_dir(GetWorkDirectory()) {
+  if (std::optional<std::vector<ArgInfo>> args = ReadArgsFile(this->xo_path)) {
+    args_ = *std::move(args);
+  } else {
+    args_ = ReadKernelXml(this->xo_path);
   }
 
   LOG(INFO) << "Running hardware simulation with TAPA fast cosim";
@@ -176,23 +287,95 @@ void TapaFastCosimDevice::SetBufferArg(int index, Tag tag,
   LOG_IF(FATAL, args_[index].cat != ArgInfo::kMmap)
       << "Cannot set argument '" << args_[index].name
       << "' as an mmap; it is a " << args_[index].cat;
-  buffer_table_.insert({index, arg});
-  if (tag == Tag::kReadOnly || tag == Tag::kReadWrite) {
+  // Later invocations may bind other host memory to the same argument.
+  buffer_table_[index] = arg;
+  load_indices_.erase(index);
+  store_indices_.erase(index);
+  // Each simulation starts from host memory, so buffers whose content stays on
+  // the device are read back after every invocation to keep their state.
+  if (tag == Tag::kReadOnly || tag == Tag::kReadWrite ||
+      tag == Tag::kInitOnce || tag == Tag::kReadBackLast ||
+      tag == Tag::kHostOnly) {
     store_indices_.insert(index);
   }
-  if (tag == Tag::kWriteOnly || tag == Tag::kReadWrite) {
+  if (tag == Tag::kWriteOnly || tag == Tag::kReadWrite ||
+      tag == Tag::kInitOnce || tag == Tag::kReadBackLast ||
+      tag == Tag::kHostOnly) {
     load_indices_.insert(index);
   }
 }
 
+void TapaFastCosimDevice::RegisterBuffer(Tag tag, const BufferArg& arg) {
+  // Simulation copies buffers through data files, so there is nothing to keep.
+}
+
+void TapaFastCosimDevice::UnregisterBuffer(Tag tag, const BufferArg& arg) {}
+
 void TapaFastCosimDevice::SetStreamArg(int index, Tag tag, StreamArg& arg) {
-  stream_table_[index] = arg.get<std::shared_ptr<SharedMemoryStream>>();
+  auto stream = arg.get<std::shared_ptr<SharedMemoryStream>>();
+  // The testbench moves up to a batch of tokens per DPI call, so a shallower
+  // queue makes it call the host more often and stall the kernel meanwhile.
+  const int64_t capacity = CHECK_NOTNULL(stream->queue())->capacity();
+  LOG_IF(WARNING, capacity < FLAGS_xosim_stream_batch_size &&
+                      stream_table_.count(index) == 0)
+      << "stream argument #" << index << " holds " << capacity
+      << " tokens, fewer than --xosim_stream_batch_size="
+      << FLAGS_xosim_stream_batch_size
+      << "; create it with a depth of at least that for faster simulation";
+  stream_table_[index] = std::move(stream);
 }
 
 size_t TapaFastCosimDevice::SuspendBuffer(int index) {
   return load_indices_.erase(index) + store_indices_.erase(index);
 }
 
+void TapaFastCosimDevice::MarkDirty(int index, size_t offset, size_t size) {
+  // Simulation reads and writes whole data files, so ranges are not tracked.
+}
+
+size_t TapaFastCosimDevice::PeekBuffer(int index, size_t offset,
+                                       size_t size) {
+  LOG_IF(FATAL, UseDataFiles())
+      << "Cannot peek at argument #" << index
+      << " with --xosim_use_data_files; buffers must be in shared memory";
+  auto it = shm_buffers_.find(index);
+  LOG_IF(FATAL, it == shm_buffers_.end())
+      << "Cannot peek at argument #" << index
+      << "; it is not a buffer written to the device";
+  const SharedMemoryBuffer& shm_buffer = *it->second;
+  CHECK_LE(offset, shm_buffer.size);
+  CHECK_LE(size, shm_buffer.size - offset);
+
+  // Acquiring the count first guarantees that at least the counted bytes
+  // are copied.
+  const uint64_t written_bytes =
+      shm_buffer.written_bytes->load(std::memory_order_acquire);
+  memcpy(buffer_table_.at(index).Get() + offset, shm_buffer.data + offset,
+         size);
+  return written_bytes;
+}
+
+void TapaFastCosimDevice::SetPipelineDepth(size_t depth) {
+  CHECK_GT(depth, 0);
+  LOG_IF(WARNING, depth > 1)
+      << "TAPA fast cosim runs one invocation at a time; ignoring pipeline "
+         "depth "
+      << depth;
+}
+
+void TapaFastCosimDevice::BeginInvocation() {
+  // The simulator reads arguments when it is launched and writes outputs to
+  // the current buffers, so the previous invocation must finish first.
+  if (context_ != nullptr && !is_finished_) {
+    Finish();
+  }
+}
+
+// The xo is simulated as a single compute unit.
+size_t TapaFastCosimDevice::GetComputeUnitCount() const { return 1; }
+
+void TapaFastCosimDevice::SetComputeUnit(size_t index) { CHECK_EQ(index, 0); }
+
 void TapaFastCosimDevice::WriteToDevice() {
   is_write_to_device_scheduled_ = true;
 }
@@ -201,9 +384,31 @@ void TapaFastCosimDevice::WriteToDeviceImpl() {
   // All buffers must have a data file.
   auto tic = clock::now();
   for (const auto& [index, buffer_arg] : buffer_table_) {
-    std::ofstream(GetInputDataPath(work_dir, index),
-                  std::ios::out | std::ios::binary)
-        .write(buffer_arg.Get(), buffer_arg.SizeInBytes());
+    auto arg_tic = clock::now();
+    if (UseDataFiles()) {
+      std::ofstream(GetInputDataPath(work_dir, index),
+                    std::ios::out | std::ios::binary)
+          .write(buffer_arg.Get(), buffer_arg.SizeInBytes());
+    } else {
+      auto& shm_buffer = shm_buffers_[index];
+      if (shm_buffer == nullptr ||
+          shm_buffer->size != buffer_arg.SizeInBytes()) {
+        if (shm_buffer != nullptr) {
+          LogEvent(EventLog::kBufferRelease, index, shm_buffer->size);
+        }
+        shm_buffer =
+            std::make_unique<SharedMemoryBuffer>(buffer_arg.SizeInBytes());
+        LogEvent(EventLog::kBufferCreate, index, shm_buffer->size);
+      }
+      memcpy(shm_buffer->data, buffer_arg.Get(), buffer_arg.SizeInBytes());
+      shm_buffer->written_bytes->store(0, std::memory_order_relaxed);
+    }
+    const auto arg_toc = clock::now();
+    auto& stats = transfer_stats_[index];
+    stats.load_bytes = buffer_arg.SizeInBytes();
+    stats.load_time_ns = std::chrono::nanoseconds(arg_toc - arg_tic).count();
+    LogEvent(EventLog::kLoad, index, stats.load_bytes);
+    TraceSpan("load", GetArgName(args_, index), arg_tic, arg_toc);
   }
   load_time_ = clock::now() - tic;
 }
@@ -215,15 +420,28 @@ void TapaFastCosimDevice::ReadFromDevice() {
 void TapaFastCosimDevice::ReadFromDeviceImpl() {
   auto tic = clock::now();
   for (int index : store_indices_) {
+    auto arg_tic = clock::now();
     auto buffer_arg = buffer_table_.at(index);
-    std::ifstream(GetOutputDataPath(work_dir, index),
-                  std::ios::in | std::ios::binary)
-        .read(buffer_arg.Get(), buffer_arg.SizeInBytes());
+    if (UseDataFiles()) {
+      std::ifstream(GetOutputDataPath(work_dir, index),
+                    std::ios::in | std::ios::binary)
+          .read(buffer_arg.Get(), buffer_arg.SizeInBytes());
+    } else {
+      memcpy(buffer_arg.Get(), shm_buffers_.at(index)->data,
+             buffer_arg.SizeInBytes());
+    }
+    const auto arg_toc = clock::now();
+    auto& stats = transfer_stats_[index];
+    stats.store_bytes = buffer_arg.SizeInBytes();
+    stats.store_time_ns = std::chrono::nanoseconds(arg_toc - arg_tic).count();
+    LogEvent(EventLog::kStore, index, stats.store_bytes);
+    TraceSpan("store", GetArgName(args_, index), arg_tic, arg_toc);
   }
   store_time_ = clock::now() - tic;
 }
 
 void TapaFastCosimDevice::Exec() {
+  transfer_stats_.clear();
   if (is_write_to_device_scheduled_) {
     WriteToDeviceImpl();
   }
@@ -241,12 +459,19 @@ void TapaFastCosimDevice::Exec() {
 
   nlohmann::json axi_to_c_array_size = nlohmann::json::object();
   nlohmann::json axi_to_data_file = nlohmann::json::object();
+  nlohmann::json axi_to_shm_file = nlohmann::json::object();
   for (const auto& [index, content] : buffer_table_) {
     axi_to_c_array_size[std::to_string(index)] = content.SizeInCount();
-    axi_to_data_file[std::to_string(index)] = GetInputDataPath(work_dir, index);
+    if (UseDataFiles()) {
+      axi_to_data_file[std::to_string(index)] =
+          GetInputDataPath(work_dir, index);
+    } else {
+      axi_to_shm_file[std::to_string(index)] = shm_buffers_.at(index)->path;
+    }
   }
   json["axi_to_c_array_size"] = std::move(axi_to_c_array_size);
   json["axi_to_data_file"] = std::move(axi_to_data_file);
+  json["axi_to_shm_file"] = std::move(axi_to_shm_file);
 
   nlohmann::json axis_to_data_file = nlohmann::json::object();
   for (const auto& [index, stream] : stream_table_) {
@@ -265,7 +490,7 @@ void TapaFastCosimDevice::Exec() {
   }
   argv.insert(argv.end(), {
                               "--config_path=" + GetConfigPath(work_dir),
-                              "--tb_output_dir=" + work_dir + "/output",
+                              "--tb_output_dir=" + GetTbOutputDir(work_dir),
                               "--launch_simulation",
                           });
   if (FLAGS_xosim_start_gui) {
@@ -280,12 +505,36 @@ void TapaFastCosimDevice::Exec() {
   if (!FLAGS_xosim_part_num.empty()) {
     argv.push_back("--part_num=" + FLAGS_xosim_part_num);
   }
+  argv.push_back("--stream_batch_size=" +
+                 std::to_string(FLAGS_xosim_stream_batch_size));
+  if (FLAGS_xosim_force_rebuild) {
+    argv.push_back("--force_rebuild");
+  }
+  if (!FLAGS_xosim_axi_ram_timing.empty()) {
+    argv.push_back("--axi_ram_timing=" + FLAGS_xosim_axi_ram_timing);
+  }
+  if (FLAGS_xosim_simulator != "xsim") {
+    LOG_IF(FATAL, UseDataFiles())
+        << "--xosim_simulator=" << FLAGS_xosim_simulator
+        << " requires buffers in shared memory";
+    argv.push_back("--simulator=" + FLAGS_xosim_simulator);
+    argv.push_back("--verilator_threads=" +
+                   std::to_string(FLAGS_xosim_verilator_threads));
+  }
+  if (!FLAGS_xosim_snapshot_cache_dir.empty()) {
+    LOG_IF(FATAL, UseDataFiles())
+        << "--xosim_snapshot_cache_dir requires buffers in shared memory";
+    argv.push_back("--snapshot_cache_dir=" +
+                   fs::absolute(FLAGS_xosim_snapshot_cache_dir).string());
+  }
 
   // launch simulation as a noop if resume from post sim
   if (FLAGS_xosim_resume_from_post_sim) {
     argv = {"/bin/sh", "-c", ":"};
   }
 
+  is_finished_ = false;
+  LogEvent(EventLog::kKernelStart);
   context_ = std::make_unique<Context>(Context{
       .start_timestamp = tic,
       .proc = subprocess::Popen(argv,
@@ -304,11 +553,103 @@ void TapaFastCosimDevice::Finish() {
     exit(0);
   }
 
-  compute_time_ = clock::now() - context_->start_timestamp;
+  const auto toc = clock::now();
+  LogEvent(EventLog::kKernelEnd);
+  compute_time_ = toc - context_->start_timestamp;
+  TraceSpan("compute", "simulation", context_->start_timestamp, toc);
+  LoadPortStats();
+  TracePorts();
 
   if (is_read_from_device_scheduled_) {
     ReadFromDeviceImpl();
   }
+  is_finished_ = true;
+}
+
+void TapaFastCosimDevice::LoadPortStats() {
+  port_stats_.clear();
+  std::ifstream ifs(GetPortStatsPath(work_dir));
+  if (!ifs) {
+    LOG(WARNING) << "missing port statistics in '" << GetPortStatsPath(work_dir)
+                 << "'";
+    return;
+  }
+  const auto json = nlohmann::json::parse(ifs, /*cb=*/nullptr,
+                                          /*allow_exceptions=*/false);
+  if (json.is_discarded() || !json.contains("ports")) {
+    LOG(WARNING) << "malformed port statistics in '"
+                 << GetPortStatsPath(work_dir) << "'";
+    return;
+  }
+  for (const ArgInfo& arg : args_) {
+    auto it = json["ports"].find(arg.name);
+    if (it == json["ports"].end()) continue;
+    PortStats& stats = port_stats_.emplace_back();
+    stats.arg = arg;
+    stats.cycles = json.value("cycles", int64_t{0});
+    stats.read_bursts = it->value("read_bursts", int64_t{0});
+    stats.write_bursts = it->value("write_bursts", int64_t{0});
+    stats.read_beats = it->value("read_beats", int64_t{0});
+    stats.write_beats = it->value("write_beats", int64_t{0});
+    stats.read_request_stall_cycles =
+        it->value("read_request_stall_cycles", int64_t{0});
+    stats.write_request_stall_cycles =
+        it->value("write_request_stall_cycles", int64_t{0});
+    stats.read_data_stall_cycles =
+        it->value("read_data_stall_cycles", int64_t{0});
+    stats.write_data_stall_cycles =
+        it->value("write_data_stall_cycles", int64_t{0});
+    stats.max_outstanding_reads =
+        it->value("max_outstanding_reads", int64_t{0});
+    stats.max_outstanding_writes =
+        it->value("max_outstanding_writes", int64_t{0});
+    stats.host_empty_cycles = it->value("host_empty_cycles", int64_t{0});
+    stats.host_full_cycles = it->value("host_full_cycles", int64_t{0});
+    LOG_IF(INFO, stats.host_full_cycles * 10 > stats.cycles)
+        << "stream '" << arg.name << "' was full on the host for "
+        << stats.host_full_cycles << " of " << stats.cycles
+        << " cycles; a deeper stream may speed up the simulation";
+  }
+}
+
+void TapaFastCosimDevice::TraceSpan(const std::string& track,
+                                    std::string_view name,
+                                    clock::time_point begin,
+                                    clock::time_point end) {
+  Trace* trace = Trace::Get();
+  if (trace == nullptr) return;
+  auto [it, is_new] = trace_tracks_.try_emplace(track, 0);
+  if (is_new) it->second = trace->AddTrack("xosim", track);
+  trace->AddSpan(it->second, name, ToNs(begin), ToNs(end));
+}
+
+void TapaFastCosimDevice::TracePorts() {
+  Trace* trace = Trace::Get();
+  if (trace == nullptr) return;
+  std::ifstream ifs(GetPortTracePath(work_dir));
+  if (!ifs) return;
+
+  // Each line is `time_ns,port,read_beats,write_beats`, sampled periodically
+  // in simulated time. Samples are placed from the start of the simulation
+  // on, so their spacing is that of simulated rather than wall-clock time.
+  const int64_t start_ns = ToNs(context_->start_timestamp);
+  int64_t first_ns = -1;
+  for (std::string line; std::getline(ifs, line);) {
+    std::istringstream is(line);
+    std::string time, port, read_beats, write_beats;
+    if (!std::getline(is, time, ',') || !std::getline(is, port, ',') ||
+        !std::getline(is, read_beats, ',') || !std::getline(is, write_beats)) {
+      LOG(WARNING) << "malformed port trace line '" << line << "'";
+      continue;
+    }
+    const int64_t time_ns = std::stoll(time);
+    if (first_ns < 0) first_ns = time_ns;
+    const int64_t trace_ns = start_ns + time_ns - first_ns;
+    trace->AddCounter("ports (simulated time)", port + " read beats", trace_ns,
+                      std::stod(read_beats));
+    trace->AddCounter("ports (simulated time)", port + " write beats",
+                      trace_ns, std::stod(write_beats));
+  }
 }
 
 bool TapaFastCosimDevice::IsFinished() const {
@@ -346,5 +687,28 @@ size_t TapaFastCosimDevice::StoreBytes() const {
   return total_size;
 }
 
+std::vector<PortStats> TapaFastCosimDevice::GetPortStats() const {
+  return port_stats_;
+}
+
+std::vector<HardwareCounters> TapaFastCosimDevice::GetHardwareCounters()
+    const {
+  // Cosim reports the traffic of each port in `GetPortStats` instead.
+  return {};
+}
+
+std::vector<TransferStats> TapaFastCosimDevice::GetTransferStats() const {
+  std::vector<TransferStats> result;
+  result.reserve(transfer_stats_.size());
+  for (const auto& [index, stats] : transfer_stats_) {
+    auto& arg_stats = result.emplace_back(stats);
+    arg_stats.arg.index = index;
+    for (const auto& arg : args_) {
+      if (arg.index == index) arg_stats.arg = arg;
+    }
+  }
+  return result;
+}
+
 }  // namespace internal
 }  // namespace fpga
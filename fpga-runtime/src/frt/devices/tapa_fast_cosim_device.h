@@ -6,6 +6,7 @@
 #define FPGA_RUNTIME_TAPA_FAST_COSIM_
 
 #include <chrono>
+#include <map>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -35,8 +36,16 @@ class TapaFastCosimDevice : public Device {
 
   void SetScalarArg(int index, const void* arg, int size) override;
   void SetBufferArg(int index, Tag tag, const BufferArg& arg) override;
+  void RegisterBuffer(Tag tag, const BufferArg& arg) override;
+  void UnregisterBuffer(Tag tag, const BufferArg& arg) override;
   void SetStreamArg(int index, Tag tag, StreamArg& arg) override;
   size_t SuspendBuffer(int index) override;
+  void MarkDirty(int index, size_t offset, size_t size) override;
+  size_t PeekBuffer(int index, size_t offset, size_t size) override;
+  void SetPipelineDepth(size_t depth) override;
+  void BeginInvocation() override;
+  size_t GetComputeUnitCount() const override;
+  void SetComputeUnit(size_t index) override;
 
   void WriteToDevice() override;
   void ReadFromDevice() override;
@@ -50,6 +59,9 @@ class TapaFastCosimDevice : public Device {
   int64_t StoreTimeNanoSeconds() const override;
   size_t LoadBytes() const override;
   size_t StoreBytes() const override;
+  std::vector<TransferStats> GetTransferStats() const override;
+  std::vector<PortStats> GetPortStats() const override;
+  std::vector<HardwareCounters> GetHardwareCounters() const override;
 
   const std::string xo_path;
   const std::string work_dir;
@@ -57,6 +69,13 @@ class TapaFastCosimDevice : public Device {
  private:
   void WriteToDeviceImpl();
   void ReadFromDeviceImpl();
+  void LoadPortStats();
+  // Records a span on the timeline trace track `track`, if tracing is enabled.
+  void TraceSpan(const std::string& track, std::string_view name,
+                 std::chrono::steady_clock::time_point begin,
+                 std::chrono::steady_clock::time_point end);
+  // Records the traffic of each port over simulated time on the timeline trace.
+  void TracePorts();
 
   std::unordered_map<int, std::string> scalars_;
   std::unordered_map<int, BufferArg> buffer_table_;
@@ -67,13 +86,21 @@ class TapaFastCosimDevice : public Device {
 
   bool is_write_to_device_scheduled_ = false;
   bool is_read_from_device_scheduled_ = false;
+  bool is_finished_ = false;
 
   std::chrono::nanoseconds load_time_;
   std::chrono::nanoseconds compute_time_;
   std::chrono::nanoseconds store_time_;
+  std::map<int, TransferStats> transfer_stats_;
+  std::vector<PortStats> port_stats_;
+  std::unordered_map<std::string, int> trace_tracks_;
 
   struct Context;
   std::unique_ptr<Context> context_;  // For asynchronous execution.
+
+  // Buffers shared with the simulator, which accesses them via DPI.
+  struct SharedMemoryBuffer;
+  std::unordered_map<int, std::unique_ptr<SharedMemoryBuffer>> shm_buffers_;
 };
 
 }  // namespace internal
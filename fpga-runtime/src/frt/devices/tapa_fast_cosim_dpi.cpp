@@ -2,24 +2,53 @@
 // All rights reserved. The contributor(s) of this file has/have agreed to the
 // RapidStream Contributor License Agreement.
 
+#include <cstdint>
+#include <cstring>
+
+#include <atomic>
 #include <sstream>
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <glog/logging.h>
 #include <svdpi.h>
 
 #include "frt/devices/shared_memory_queue.h"
+#include "frt/devices/tapa_fast_cosim_shm.h"
 
 namespace {
 
 using ::fpga::internal::SharedMemoryQueue;
 
+// Maps the shared memory arena at `path` once, and returns its address and
+// size. Arenas stay mapped until the simulator exits.
+std::pair<char*, size_t> MapArena(const std::string& path) {
+  static std::unordered_map<std::string, std::pair<char*, size_t>> arenas;
+  auto [it, is_new] = arenas.try_emplace(path);
+  if (is_new) {
+    int fd = shm_open(path.c_str(), O_RDWR, 0600);
+    PCHECK(fd >= 0) << "shm_open: " << path;
+    struct stat st;
+    PCHECK(fstat(fd, &st) == 0) << "fstat: " << path;
+    void* addr =
+        mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    PCHECK(addr != MAP_FAILED) << "mmap: " << path;
+    PCHECK(close(fd) == 0) << "close: " << path;
+    VLOG(1) << "mapped " << st.st_size << " bytes of queues from " << path;
+    it->second = {static_cast<char*>(addr), static_cast<size_t>(st.st_size)};
+  }
+  return it->second;
+}
+
 std::unordered_map<std::string, SharedMemoryQueue::UniquePtr> InitStreamMap() {
   const char* env = std::getenv("TAPA_FAST_COSIM_DPI_ARGS");
   CHECK(env != nullptr) << "Please set `TAPA_FAST_COSIM_DPI_ARGS`";
@@ -43,6 +72,18 @@ std::unordered_map<std::string, SharedMemoryQueue::UniquePtr> InitStreamMap() {
   for (const std::tuple<std::string, std::string>& entry : stream_id_and_path) {
     const std::string& stream_id = std::get<0>(entry);
     const std::string& stream_path = std::get<1>(entry);
+
+    // Queues carved out of a pool are described by `arena@offset`.
+    if (const std::string::size_type pos = stream_path.find('@');
+        pos != std::string::npos) {
+      const auto [addr, size] = MapArena(stream_path.substr(0, pos));
+      const size_t offset = std::stoull(stream_path.substr(pos + 1));
+      CHECK_LT(offset, size) << stream_path;
+      VLOG(2) << "queue " << stream_path << " <=> arg: " << stream_id;
+      streams[stream_id] = SharedMemoryQueue::New(addr + offset, size - offset);
+      continue;
+    }
+
     int fd = shm_open(stream_path.c_str(), O_RDWR, 0600);
     VLOG(2) << "fd: " << fd << " <=> arg: " << stream_id;
     streams[stream_id] = SharedMemoryQueue::New(fd);
@@ -64,66 +105,198 @@ SharedMemoryQueue* GetStream(const char* id) {
   return it->second.get();
 }
 
+// AXI RAM content mapped from a POSIX shared memory object created by the host,
+// or from a data file mapped by `axi_ram_map_file`. Either way, only the pages
+// accessed by the simulation are brought into memory.
+struct SharedMemoryRam {
+  uint8_t* data = nullptr;
+  size_t size = 0;
+
+  // Progress counter shared with the host, if it created one.
+  std::atomic<uint64_t>* written_bytes = nullptr;
+};
+
+std::unordered_map<std::string, SharedMemoryRam>& GetRams() {
+  static std::unordered_map<std::string, SharedMemoryRam> rams;
+  return rams;
+}
+
+const SharedMemoryRam& GetRam(const char* path) {
+  CHECK(path != nullptr) << "AXI RAM path is nullptr";
+  auto [it, is_new] = GetRams().try_emplace(path);
+  if (is_new) {
+    int fd = shm_open(path, O_RDWR, 0600);
+    PCHECK(fd >= 0) << "shm_open: " << path;
+    struct stat st;
+    PCHECK(fstat(fd, &st) == 0) << "fstat: " << path;
+    SharedMemoryRam& ram = it->second;
+    ram.size = st.st_size;
+    if (ram.size > 0) {
+      void* addr =
+          mmap(nullptr, ram.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      PCHECK(addr != MAP_FAILED) << "mmap: " << path;
+      ram.data = static_cast<uint8_t*>(addr);
+    }
+    PCHECK(close(fd) == 0) << "close: " << path;
+    VLOG(1) << "mapped " << ram.size << " bytes of AXI RAM from " << path;
+
+    const std::string progress_path =
+        ::fpga::internal::GetAxiRamProgressPath(path);
+    fd = shm_open(progress_path.c_str(), O_RDWR, 0600);
+    if (fd >= 0) {
+      void* addr = mmap(nullptr, sizeof(*ram.written_bytes),
+                        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      PCHECK(addr != MAP_FAILED) << "mmap: " << progress_path;
+      ram.written_bytes = static_cast<std::atomic<uint64_t>*>(addr);
+      PCHECK(close(fd) == 0) << "close: " << progress_path;
+    }
+  }
+  return it->second;
+}
+
+// Returns the elements of `handle` as a C array indexed from its lower bound,
+// or nullptr if the simulator does not store them contiguously. This saves a
+// DPI call per element.
+template <typename T>
+T* GetElems(svOpenArrayHandle handle) {
+  const int size = svSize(handle, 1);
+  if (size <= 0) return nullptr;
+  auto* low = static_cast<T*>(svGetArrElemPtr1(handle, svLow(handle, 1)));
+  auto* high = static_cast<T*>(svGetArrElemPtr1(handle, svHigh(handle, 1)));
+  return low != nullptr && high == low + (size - 1) ? low : nullptr;
+}
+
+// Returns the logic value of a bit character, or -1 for separators.
+int CharToLogic(char c) {
+  switch (c) {
+    case '0':
+      return sv_0;
+    case '1':
+      return sv_1;
+    case 'z':
+    case 'Z':
+      return sv_z;
+    case 'x':
+    case 'X':
+      return sv_x;
+    case '\'':
+    case '_':
+      return -1;
+    default:
+      LOG(FATAL) << "unexpected bit character: " << c << " (" << int(c) << ")";
+      return -1;
+  }
+}
+
+char LogicToChar(svLogic bit) {
+  switch (bit) {
+    case sv_0:
+      return '0';
+    case sv_1:
+      return '1';
+    case sv_x:
+      return 'x';
+    case sv_z:
+      return 'z';
+    default:
+      LOG(FATAL) << "unexpected bit enum: " << int(bit);
+      return 'x';
+  }
+}
+
 void StringToOpenArrayHandle(const std::string& bits,
                              svOpenArrayHandle handle) {
   const int increment = svIncrement(handle, 1);
+  const int low = svLow(handle, 1);
+  const int end = svRight(handle, 1) - increment;
+  svLogic* const elems = GetElems<svLogic>(handle);
   int index = svLeft(handle, 1);
   for (const char c : bits) {
-    svLogic bit = sv_x;
-    switch (c) {
-      case '0':
-        bit = sv_0;
-        break;
-      case '1':
-        bit = sv_1;
-        break;
-      case 'z':
-      case 'Z':
-        bit = sv_z;
-        break;
-      case 'x':
-      case 'X':
-        bit = sv_x;
-        break;
-      case '\'':
-      case '_':
-        continue;
-      default:
-        LOG(FATAL) << "unexpected bit character: " << c << " (" << int(c)
-                   << ")";
+    const int bit = CharToLogic(c);
+    if (bit < 0) continue;
+    CHECK_NE(index, end) << "too many bits: " << bits;
+    if (elems != nullptr) {
+      elems[index - low] = bit;
+    } else {
+      svPutLogicArrElem(handle, bit, index);
     }
-    svPutLogicArrElem(handle, bit, index);
     index -= increment;
   }
-  CHECK_EQ(index, svRight(handle, 1) - increment);
+  CHECK_EQ(index, end);
 }
 
 std::string OpenArrayHandleToString(svOpenArrayHandle handle) {
   std::string bits;
   bits.reserve(svSize(handle, 1));
   const int increment = svIncrement(handle, 1);
-  for (int index = svLeft(handle, 1); index != svRight(handle, 1) - increment;
-       index -= increment) {
-    bits.push_back([&] {
-      const svLogic bit = svGetLogicArrElem(handle, index);
-      switch (bit) {
-        case sv_0:
-          return '0';
-        case sv_1:
-          return '1';
-        case sv_x:
-          return 'x';
-        case sv_z:
-          return 'z';
-        default:
-          LOG(FATAL) << "unexpected bit enum: " << int(bit);
-          return 'x';
-      }
-    }());
+  const int low = svLow(handle, 1);
+  const int end = svRight(handle, 1) - increment;
+  const svLogic* const elems = GetElems<svLogic>(handle);
+  for (int index = svLeft(handle, 1); index != end; index -= increment) {
+    bits.push_back(LogicToChar(elems != nullptr
+                                   ? elems[index - low]
+                                   : svGetLogicArrElem(handle, index)));
   }
   return bits;
 }
 
+int GetWordCount(int width) { return (width + 31) / 32; }
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "bits are packed into bytes of little-endian words");
+
+// Packs 8 characters of an MSB-first binary string, i.e., bits 7 to 0, into a
+// byte. Characters other than '1' (including 'x' and 'z') become 0.
+uint8_t PackByte(const char* bits) {
+  uint64_t chars;
+  std::memcpy(&chars, bits, sizeof(chars));
+  // '1' is the only bit character with an odd code.
+  chars &= 0x0101010101010101;
+  // Gathers the low bit of each character to the top byte, first one highest.
+  return (chars * 0x8040201008040201) >> 56;
+}
+
+// Unpacks a byte into 8 characters of an MSB-first binary string.
+void UnpackByte(uint8_t byte, char* bits) {
+  static const auto* const kTable = [] {
+    auto* table = new uint64_t[256];
+    for (int i = 0; i < 256; ++i) {
+      char chars[8];
+      for (int j = 0; j < 8; ++j) chars[j] = (i >> (7 - j)) & 1 ? '1' : '0';
+      std::memcpy(&table[i], chars, sizeof(chars));
+    }
+    return table;
+  }();
+  std::memcpy(bits, &kTable[byte], sizeof(kTable[byte]));
+}
+
+// Converts an MSB-first binary string to LSB-first 32-bit words, 8 bits at a
+// time. Bits other than '1' (including 'x' and 'z') become 0.
+void BitsToWords(const char* bits, int width, uint32_t* words) {
+  std::memset(words, 0, GetWordCount(width) * sizeof(*words));
+  auto* bytes = reinterpret_cast<uint8_t*>(words);
+  const int byte_count = width / 8;
+  for (int i = 0; i < byte_count; ++i) {
+    bytes[i] = PackByte(bits + width - 8 * (i + 1));
+  }
+  for (int i = byte_count * 8; i < width; ++i) {
+    if (bits[width - 1 - i] == '1') bytes[i / 8] |= 1 << (i % 8);
+  }
+}
+
+// Converts LSB-first 32-bit words to an MSB-first binary string, 8 bits at a
+// time.
+void WordsToBits(const uint32_t* words, int width, char* bits) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(words);
+  const int byte_count = width / 8;
+  for (int i = 0; i < byte_count; ++i) {
+    UnpackByte(bytes[i], bits + width - 8 * (i + 1));
+  }
+  for (int i = byte_count * 8; i < width; ++i) {
+    bits[width - 1 - i] = (bytes[i / 8] >> (i % 8)) & 1 ? '1' : '0';
+  }
+}
+
 }  // namespace
 
 extern "C" {
@@ -193,4 +366,156 @@ DPI_DLLESPEC void ostream(
   }
 }
 
+DPI_DLLESPEC int istream_batch(
+    /* output */ svOpenArrayHandle words,
+    /* input */ int width,
+    /* input */ const char* id) {
+  SharedMemoryQueue* istream = GetStream(id);
+  CHECK(istream != nullptr);
+  CHECK_EQ(istream->width(), width);
+
+  const int word_count = GetWordCount(width);
+  const int max_count = svSize(words, 1) / word_count;
+  static thread_local std::string bits;
+  static thread_local std::vector<uint32_t> buffer;
+  bits.resize(width);
+  uint32_t* elems = GetElems<uint32_t>(words);
+  if (elems == nullptr) {
+    buffer.resize(max_count * word_count);
+    elems = buffer.data();
+  }
+  int count = 0;
+  for (; count < max_count && !istream->empty(); ++count) {
+    istream->pop_into(bits.data());
+    BitsToWords(bits.data(), width, elems + count * word_count);
+  }
+  if (elems == buffer.data()) {
+    for (int i = 0; i < count * word_count; ++i) {
+      *static_cast<uint32_t*>(svGetArrElemPtr1(words, svLow(words, 1) + i)) =
+          buffer[i];
+    }
+  }
+  return count;
+}
+
+DPI_DLLESPEC int ostream_batch(
+    /* input */ svOpenArrayHandle words,
+    /* input */ int count,
+    /* input */ int width,
+    /* input */ const char* id) {
+  SharedMemoryQueue* ostream = GetStream(id);
+  CHECK(ostream != nullptr);
+  CHECK_EQ(ostream->width(), width);
+
+  const int word_count = GetWordCount(width);
+  CHECK_LE(count * word_count, svSize(words, 1));
+  static thread_local std::string bits;
+  static thread_local std::vector<uint32_t> buffer;
+  bits.resize(width);
+  const uint32_t* elems = GetElems<const uint32_t>(words);
+  if (elems == nullptr) {
+    buffer.resize(count * word_count);
+    for (int i = 0; i < count * word_count; ++i) {
+      buffer[i] = *static_cast<const uint32_t*>(
+          svGetArrElemPtr1(words, svLow(words, 1) + i));
+    }
+    elems = buffer.data();
+  }
+  int pushed = 0;
+  for (; pushed < count && !ostream->full(); ++pushed) {
+    WordsToBits(elems + pushed * word_count, width, bits.data());
+    ostream->push(bits.data(), bits.size());
+  }
+  return pushed;
+}
+
+DPI_DLLESPEC void axi_ram_map_file(
+    /* input */ const char* path,
+    /* input */ const char* data_path,
+    /* input */ uint64_t size) {
+  CHECK(path != nullptr) << "AXI RAM path is nullptr";
+  auto [it, is_new] = GetRams().try_emplace(path);
+  if (!is_new) return;
+
+  // Copies the initial content to `path`, which the host reads back after the
+  // simulation, and maps it so that writes land in the file directly.
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  PCHECK(fd >= 0) << "open: " << path;
+  if (data_path != nullptr && *data_path != '\0') {
+    int data_fd = open(data_path, O_RDONLY);
+    PCHECK(data_fd >= 0) << "open: " << data_path;
+    struct stat st;
+    PCHECK(fstat(data_fd, &st) == 0) << "fstat: " << data_path;
+    size = st.st_size;
+    for (off_t offset = 0; offset < st.st_size;) {
+      const ssize_t copied =
+          sendfile(fd, data_fd, &offset, st.st_size - offset);
+      PCHECK(copied > 0) << "sendfile: " << data_path << " => " << path;
+    }
+    PCHECK(close(data_fd) == 0) << "close: " << data_path;
+  }
+  PCHECK(ftruncate(fd, size) == 0) << "ftruncate: " << path;
+
+  SharedMemoryRam& ram = it->second;
+  ram.size = size;
+  if (ram.size > 0) {
+    void* addr =
+        mmap(nullptr, ram.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    PCHECK(addr != MAP_FAILED) << "mmap: " << path;
+    ram.data = static_cast<uint8_t*>(addr);
+  }
+  PCHECK(close(fd) == 0) << "close: " << path;
+  VLOG(1) << "mapped " << ram.size << " bytes of AXI RAM from " << path;
+}
+
+DPI_DLLESPEC void axi_ram_flush(/* input */ const char* path) {
+  const SharedMemoryRam& ram = GetRam(path);
+  if (ram.size > 0) {
+    PCHECK(msync(ram.data, ram.size, MS_SYNC) == 0) << "msync: " << path;
+  }
+}
+
+DPI_DLLESPEC void axi_ram_read(
+    /* input */ const char* path,
+    /* input */ uint64_t offset,
+    /* output */ svOpenArrayHandle data) {
+  const SharedMemoryRam& ram = GetRam(path);
+  const int size = svSize(data, 1);
+  for (int i = 0; i < size; ++i) {
+    // Reads beyond the host buffer return zeros, like an uninitialized RAM.
+    const uint64_t addr = offset + i;
+    *static_cast<uint8_t*>(svGetArrElemPtr1(data, svLow(data, 1) + i)) =
+        addr < ram.size ? ram.data[addr] : 0;
+  }
+}
+
+DPI_DLLESPEC void axi_ram_write(
+    /* input */ const char* path,
+    /* input */ uint64_t offset,
+    /* input */ svOpenArrayHandle data,
+    /* input */ svOpenArrayHandle strb) {
+  const SharedMemoryRam& ram = GetRam(path);
+  const int size = svSize(data, 1);
+  CHECK_EQ(size, svSize(strb, 1));
+  uint64_t written_bytes = 0;
+  for (int i = 0; i < size; ++i) {
+    if (svGetBitArrElem1(strb, svLow(strb, 1) + i) != sv_1) {
+      continue;
+    }
+    const uint64_t addr = offset + i;
+    LOG_IF(WARNING, addr >= ram.size)
+        << "dropping AXI RAM write beyond the buffer: " << path << "[" << addr
+        << "]";
+    if (addr < ram.size) {
+      const void* elem = svGetArrElemPtr1(data, svLow(data, 1) + i);
+      ram.data[addr] = *static_cast<const uint8_t*>(elem);
+      ++written_bytes;
+    }
+  }
+  // Publishes the data written above to a host peeking at the buffer.
+  if (ram.written_bytes != nullptr && written_bytes > 0) {
+    ram.written_bytes->fetch_add(written_bytes, std::memory_order_release);
+  }
+}
+
 }  // extern "C"
@@ -0,0 +1,24 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef FPGA_RUNTIME_TAPA_FAST_COSIM_SHM_H_
+#define FPGA_RUNTIME_TAPA_FAST_COSIM_SHM_H_
+
+#include <string>
+
+namespace fpga {
+namespace internal {
+
+// An AXI RAM held in the POSIX shared memory object at `path` may come with a
+// second object at `GetAxiRamProgressPath(path)` holding a single
+// `std::atomic<uint64_t>`. The simulator adds to it the number of bytes
+// written to the RAM, so the host can tell how far output has progressed.
+inline std::string GetAxiRamProgressPath(const std::string& path) {
+  return path + ".progress";
+}
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_TAPA_FAST_COSIM_SHM_H_
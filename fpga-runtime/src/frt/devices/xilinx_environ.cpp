@@ -4,16 +4,37 @@
 
 #include "xilinx_environ.h"
 
+#include <cstdlib>
+
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "frt/devices/filesystem.h"
 #include "frt/subprocess.h"
 
+DEFINE_bool(xilinx_environ_cache, true,
+            "cache the environment set up by Xilinx tool scripts in "
+            "$XDG_CACHE_HOME/tapa, so that later runs do not source them");
+
 namespace fpga::xilinx {
 
 namespace {
 
+namespace fs = ::fpga::internal::fs;
+
 void UpdateEnviron(std::string_view script, Environ& environ) {
   subprocess::OutBuffer output = subprocess::check_output(
       {
@@ -33,52 +54,249 @@ void UpdateEnviron(std::string_view script, Environ& environ) {
   }
 }
 
-}  // namespace
-
-Environ GetEnviron() {
-  std::string xilinx_tool;
+// Returns the Xilinx tool directory set by the environment, if any.
+std::string GetToolFromEnviron() {
   for (const char* env : {
            "XILINX_VITIS",
            "XILINX_SDX",
            "XILINX_HLS",
            "XILINX_VIVADO",
        }) {
-    if (const char* value = getenv(env)) {
-      xilinx_tool = value;
-      break;
+    if (const char* value = getenv(env)) return value;
+  }
+  return "";
+}
+
+// Returns the Xilinx tool directory by asking HLS where its scripts are, which
+// takes a few seconds.
+std::string FindTool() {
+  for (std::string hls : {"vitis_hls", "vivado_hls"}) {
+    subprocess::OutBuffer buf = subprocess::check_output({
+        "bash",
+        "-c",
+        "\"$0\" -version -help -l /dev/null 2>/dev/null",
+        hls,
+    });
+    std::istringstream lines(std::string(buf.buf.data(), buf.length));
+    for (std::string line; getline(lines, line);) {
+      std::string_view prefix = "source ";
+      std::string suffix = "/scripts/" + hls + "/hls.tcl -notrace";
+      if (line.size() > prefix.size() + suffix.size() &&
+          line.compare(0, prefix.size(), prefix) == 0 &&
+          line.compare(line.size() - suffix.size(), suffix.size(), suffix) ==
+              0) {
+        return line.substr(prefix.size(),
+                           line.size() - prefix.size() - suffix.size());
+      }
     }
   }
+  return "";
+}
 
-  if (xilinx_tool.empty()) {
-    for (std::string hls : {"vitis_hls", "vivado_hls"}) {
-      subprocess::OutBuffer buf = subprocess::check_output({
-          "bash",
-          "-c",
-          "\"$0\" -version -help -l /dev/null 2>/dev/null",
-          hls,
-      });
-      std::istringstream lines(std::string(buf.buf.data(), buf.length));
-      for (std::string line; getline(lines, line);) {
-        std::string_view prefix = "source ";
-        std::string suffix = "/scripts/" + hls + "/hls.tcl -notrace";
-        if (line.size() > prefix.size() + suffix.size() &&
-            line.compare(0, prefix.size(), prefix) == 0 &&
-            line.compare(line.size() - suffix.size(), suffix.size(), suffix) ==
-                0) {
-          xilinx_tool = line.substr(
-              prefix.size(), line.size() - prefix.size() - suffix.size());
-          break;
-        }
+// Returns the first executable named `name` in `PATH`, or an empty string.
+std::string FindInPath(std::string_view name) {
+  std::string_view path = getenv("PATH") ?: "";
+  while (!path.empty()) {
+    const size_t pos = std::min(path.find(':'), path.size());
+    const std::string file =
+        std::string(path.substr(0, pos)) + "/" + std::string(name);
+    if (access(file.c_str(), X_OK) == 0) return file;
+    path.remove_prefix(std::min(pos + 1, path.size()));
+  }
+  return "";
+}
+
+// Appends the path and modification time of `file` to `stamp`.
+void AppendStamp(const std::string& file, std::string& stamp) {
+  struct stat st;
+  stamp += file;
+  if (stat(file.c_str(), &st) == 0) {
+    stamp += '@' + std::to_string(st.st_mtim.tv_sec) + '.' +
+             std::to_string(st.st_mtim.tv_nsec);
+  }
+  stamp += ';';
+}
+
+// Returns the files whose changes invalidate a cached environment of `tool`.
+std::string GetStamp(const std::string& tool, const std::string& hls) {
+  std::string stamp;
+  if (!hls.empty()) AppendStamp(hls, stamp);
+  AppendStamp(tool + "/settings64.sh", stamp);
+  if (const char* xrt = getenv("XILINX_XRT")) {
+    AppendStamp(std::string(xrt) + "/setup.sh", stamp);
+  }
+  return stamp;
+}
+
+// Environment variables changed by the Xilinx tool scripts, together with
+// their values before the scripts ran. Cached on disk with the tool directory
+// and the stamp of the scripts.
+struct Record {
+  std::string tool;
+  std::string stamp;
+  struct Variable {
+    std::string name;
+    std::optional<std::string> before;
+    std::string after;
+  };
+  std::vector<Variable> variables;
+
+  std::string Serialize() const {
+    std::string str = tool + '\0' + stamp + '\0';
+    for (const auto& var : variables) {
+      str += var.name + '\0';
+      str += var.before.has_value() ? '1' + *var.before : "0";
+      str += '\0' + var.after + '\0';
+    }
+    return str;
+  }
+
+  static std::optional<Record> Deserialize(std::string_view str) {
+    std::vector<std::string_view> fields;
+    while (!str.empty()) {
+      const size_t pos = str.find('\0');
+      if (pos == std::string_view::npos) return std::nullopt;
+      fields.push_back(str.substr(0, pos));
+      str.remove_prefix(pos + 1);
+    }
+    if (fields.size() < 2 || fields.size() % 3 != 2) return std::nullopt;
+    Record record{std::string(fields[0]), std::string(fields[1]), {}};
+    for (size_t i = 2; i < fields.size(); i += 3) {
+      auto& var = record.variables.emplace_back();
+      var.name = fields[i];
+      if (fields[i + 1].empty()) return std::nullopt;
+      if (fields[i + 1][0] == '1') var.before = fields[i + 1].substr(1);
+      var.after = fields[i + 2];
+    }
+    return record;
+  }
+
+  // Whether the variables have the same values as when the scripts ran, so
+  // that the scripts would change them the same way.
+  bool MatchesEnviron() const {
+    for (const auto& var : variables) {
+      const char* value = getenv(var.name.c_str());
+      if (value == nullptr ? var.before.has_value()
+                           : !var.before.has_value() || *var.before != value) {
+        return false;
       }
     }
+    return true;
+  }
+};
+
+// Returns where the environment looked up by `key` is cached, or an empty path
+// if there is no cache directory.
+fs::path GetCachePath(const std::string& key) {
+  fs::path dir;
+  if (const char* xdg = getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg) {
+    dir = xdg;
+  } else if (const char* home = getenv("HOME"); home != nullptr && *home) {
+    dir = fs::path(home) / ".cache";
+  } else {
+    return {};
+  }
+  return dir / "tapa" / "xilinx-environ" /
+         std::to_string(std::hash<std::string>()(key));
+}
+
+std::optional<Record> ReadCache(const fs::path& path) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs) return std::nullopt;
+  return Record::Deserialize(std::string(std::istreambuf_iterator<char>(ifs),
+                                         std::istreambuf_iterator<char>()));
+}
+
+// Writes `record` to `path` atomically, so that concurrent runs read either
+// the old or the new record.
+void WriteCache(const fs::path& path, const Record& record) {
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+  const fs::path tmp = path.string() + ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream ofs(tmp, std::ios::binary);
+    ofs << record.Serialize();
+    if (!ofs) {
+      LOG(WARNING) << "cannot cache Xilinx tool environment in " << path;
+      fs::remove(tmp, ec);
+      return;
+    }
   }
+  fs::rename(tmp, path, ec);
+  if (ec) fs::remove(tmp, ec);
+}
+
+// Sources the Xilinx tool scripts and returns the variables they change.
+Record SourceScripts(std::string tool, const std::string& hls) {
+  if (tool.empty()) tool = FindTool();
 
   Environ environ;
-  UpdateEnviron(xilinx_tool + "/settings64.sh", environ);
+  UpdateEnviron(tool + "/settings64.sh", environ);
   if (const char* xrt = getenv("XILINX_XRT")) {
     UpdateEnviron(std::string(xrt) + "/setup.sh", environ);
   }
+
+  Record record{tool, GetStamp(tool, hls), {}};
+  for (auto& [name, value] : environ) {
+    // Set by bash itself rather than the scripts.
+    if (name == "_" || name == "SHLVL" || name == "PWD" || name == "OLDPWD") {
+      continue;
+    }
+    const char* before = getenv(name.c_str());
+    if (before != nullptr && value == before) continue;
+    auto& var = record.variables.emplace_back();
+    var.name = name;
+    if (before != nullptr) var.before = before;
+    var.after = std::move(value);
+  }
+  return record;
+}
+
+Environ LoadEnviron() {
+  // Without a tool in the environment, HLS found in `PATH` determines the
+  // tool, so its path keys the cache instead.
+  std::string tool = GetToolFromEnviron();
+  std::string hls;
+  if (tool.empty()) {
+    for (const char* name : {"vitis_hls", "vivado_hls"}) {
+      if (hls = FindInPath(name); !hls.empty()) break;
+    }
+  }
+
+  fs::path cache_path;
+  if (FLAGS_xilinx_environ_cache && (!tool.empty() || !hls.empty())) {
+    cache_path = GetCachePath(tool + '\0' + hls + '\0' +
+                              (getenv("XILINX_XRT") ?: ""));
+  }
+
+  std::optional<Record> record;
+  if (!cache_path.empty()) {
+    record = ReadCache(cache_path);
+    if (record.has_value() &&
+        (record->stamp != GetStamp(record->tool, hls) ||
+         !record->MatchesEnviron())) {
+      record.reset();
+    }
+  }
+  if (!record.has_value()) {
+    record = SourceScripts(tool, hls);
+    if (!cache_path.empty()) WriteCache(cache_path, *record);
+  }
+
+  Environ environ;
+  for (auto& var : record->variables) environ[var.name] = var.after;
   return environ;
 }
 
+}  // namespace
+
+Environ GetEnviron() {
+  // The environment is looked up at most once per process.
+  static std::mutex mtx;
+  static std::optional<Environ> environ;
+  std::unique_lock lock(mtx);
+  if (!environ.has_value()) environ = LoadEnviron();
+  return *environ;
+}
+
 }  // namespace fpga::xilinx
@@ -9,6 +9,9 @@ namespace fpga::xilinx {
 
 using Environ = std::unordered_map<std::string, std::string>;
 
+// Returns the environment variables that the Xilinx tool and XRT setup scripts
+// set. The result is cached in the process, and on disk until the scripts or
+// the variables they change are modified; see `--xilinx_environ_cache`.
 Environ GetEnviron();
 
 }  // namespace fpga::xilinx
@@ -4,30 +4,45 @@
 
 #include "frt/devices/xilinx_opencl_device.h"
 
+#include <climits>
 #include <cstdlib>
+#include <cstring>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <fstream>
 #include <initializer_list>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <CL/cl.h>
+#include <CL/cl_ext_xilinx.h>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <tinyxml2.h>
 #include <xclbin.h>
 #include <CL/cl2.hpp>
 #include <nlohmann/json.hpp>
+#include <xrt/xrt_device.h>
+#include <xrt/xrt_kernel.h>
+#include <xrt/xrt_uuid.h>
 
 #include "frt/devices/filesystem.h"
 #include "frt/devices/opencl_device_matcher.h"
 #include "frt/devices/opencl_util.h"
+#include "frt/devices/shared_memory_queue.h"
+#include "frt/devices/shared_memory_stream.h"
 #include "frt/devices/xilinx_environ.h"
+#include "frt/hw_counters.h"
 #include "frt/stream_arg.h"
 #include "frt/subprocess.h"
 #include "frt/tag.h"
@@ -35,6 +50,13 @@
 DEFINE_string(xocl_bdf, "",
               "if not empty, use the specified PCIe Bus:Device:Function "
               "instead of trying to match device name");
+DEFINE_uint64(xocl_tile_bytes, 0,
+              "if positive, migrate buffers larger than this to the device in "
+              "tiles of this many bytes, one after another");
+DEFINE_bool(xocl_overlap_tiles, false,
+            "if true, start kernels once the first tile of each tiled buffer "
+            "is migrated; kernels must read tiled buffers sequentially and "
+            "no faster than the tiles are migrated");
 
 namespace fpga {
 namespace internal {
@@ -144,10 +166,12 @@ class DeviceMatcher : public OpenclDeviceMatcher {
 
 }  // namespace
 
-XilinxOpenclDevice::XilinxOpenclDevice(const cl::Program::Binaries& binaries) {
+XilinxOpenclDevice::XilinxOpenclDevice(
+    const cl::Program::Binaries& binaries, int device_index) {
   std::string target_device_name;
   std::vector<std::string> kernel_names;
   std::vector<int> kernel_arg_counts;
+  std::vector<std::vector<std::string>> kernel_instances;
   int arg_count = 0;
   const auto axlf_top = reinterpret_cast<const axlf*>(binaries.begin()->data());
   switch (axlf_top->m_header.m_mode) {
@@ -185,6 +209,12 @@ XilinxOpenclDevice::XilinxOpenclDevice(const cl::Program::Binaries& binaries) {
          xml_kernel = xml_kernel->NextSiblingElement("kernel")) {
       kernel_names.push_back(xml_kernel->Attribute("name"));
       kernel_arg_counts.push_back(arg_count);
+      auto& instances = kernel_instances.emplace_back();
+      for (auto xml_instance = xml_kernel->FirstChildElement("instance");
+           xml_instance != nullptr;
+           xml_instance = xml_instance->NextSiblingElement("instance")) {
+        instances.push_back(xml_instance->Attribute("name"));
+      }
       for (auto xml_arg = xml_kernel->FirstChildElement("arg");
            xml_arg != nullptr; xml_arg = xml_arg->NextSiblingElement("arg")) {
         auto& arg = arg_table_[arg_count];
@@ -303,50 +333,326 @@ XilinxOpenclDevice::XilinxOpenclDevice(const cl::Program::Binaries& binaries) {
     LOG(INFO) << "Running on-board execution with Xilinx OpenCL";
   }
 
+  memcpy(xclbin_uuid_.data(), axlf_top->m_header.uuid, xclbin_uuid_.size());
+  kernel_names_ = kernel_names;
+
   Initialize(binaries, /*vendor_name=*/"Xilinx",
-             DeviceMatcher(target_device_name), kernel_names,
-             kernel_arg_counts);
+             DeviceMatcher(target_device_name), device_index, kernel_names,
+             kernel_arg_counts, kernel_instances);
 }
 
 std::unique_ptr<Device> XilinxOpenclDevice::New(
-    const cl::Program::Binaries& binaries) {
+    const cl::Program::Binaries& binaries, int device_index) {
   if (binaries.size() != 1 || binaries.begin()->size() < 8 ||
       memcmp(binaries.begin()->data(), "xclbin2", 8) != 0) {
     return nullptr;
   }
-  return std::make_unique<XilinxOpenclDevice>(binaries);
+  return std::make_unique<XilinxOpenclDevice>(binaries, device_index);
 }
 
+class XilinxOpenclDevice::StreamBridge {
+ public:
+  StreamBridge(const cl::Device& device, const cl::Kernel& kernel,
+               int arg_index, Tag tag,
+               std::shared_ptr<SharedMemoryStream> host_stream)
+      : host_stream_(std::move(host_stream)),
+        queue_(*CHECK_NOTNULL(host_stream_->queue())),
+        width_(queue_.width()),
+        bytes_((width_ + CHAR_BIT - 1) / CHAR_BIT) {
+    cl_mem_ext_ptr_t ext;
+    ext.flags = arg_index;
+    ext.obj = nullptr;
+    ext.param = kernel.get();
+    cl_int err;
+    // Stream flags are from the kernel's perspective, while tags are from the
+    // host's perspective.
+    stream_ = clCreateStream(
+        device.get(),
+        tag == Tag::kReadOnly ? CL_STREAM_WRITE_ONLY : CL_STREAM_READ_ONLY,
+        CL_STREAM, &ext, &err);
+    CL_CHECK(err);
+    thread_ = std::thread(tag == Tag::kReadOnly ? &StreamBridge::ReadFromKernel
+                                                : &StreamBridge::WriteToKernel,
+                          this);
+  }
+
+  // Not copyable or movable, because the thread refers to `this`.
+  StreamBridge(const StreamBridge&) = delete;
+  StreamBridge& operator=(const StreamBridge&) = delete;
+
+  ~StreamBridge() {
+    Stop();
+    CL_CHECK(clReleaseStream(stream_));
+  }
+
+  // Stops moving elements after those already available are moved.
+  void Stop() {
+    if (thread_.joinable()) {
+      is_stopping_ = true;
+      thread_.join();
+    }
+  }
+
+ private:
+  // Pushes elements written by the host to the kernel. Elements available at
+  // once are pushed in one transfer of up to `kMaxBatchBytes`, because each
+  // transfer has a fixed cost far larger than that of a few bytes.
+  void WriteToKernel() {
+    const size_t max_count = std::max<size_t>(kMaxBatchBytes / bytes_, 1);
+    std::string bytes;
+    bytes.reserve(max_count * bytes_);
+    for (;;) {
+      const bool was_stopping = is_stopping_;
+      if (!queue_.wait_not_empty(std::chrono::milliseconds(kPollTimeoutMs))) {
+        if (was_stopping) return;
+        continue;
+      }
+      bytes.clear();
+      for (size_t count = 0; count < max_count && !queue_.empty(); ++count) {
+        bytes.resize(bytes.size() + bytes_);
+        ToBytes(queue_.pop(), bytes.data() + bytes.size() - bytes_);
+      }
+      cl_stream_xfer_req req{};
+      cl_int err;
+      clWriteStream(stream_, bytes.data(), bytes.size(), &req, &err);
+      CL_CHECK(err);
+    }
+  }
+
+  // Pushes elements written by the kernel to the host.
+  void ReadFromKernel() {
+    std::string bytes(bytes_, '\0');
+    bool is_pending = false;
+    for (;;) {
+      cl_int err;
+      if (!is_pending) {
+        cl_stream_xfer_req req{};
+        req.flags = CL_STREAM_NONBLOCKING;
+        clReadStream(stream_, bytes.data(), bytes.size(), &req, &err);
+        CL_CHECK(err);
+        is_pending = true;
+      }
+
+      // Polls with a timeout so that stopping is noticed.
+      const bool was_stopping = is_stopping_;
+      cl_streams_poll_req_completions completion{};
+      cl_int completion_count = 0;
+      clPollStream(stream_, &completion, /*min_num_completion=*/1,
+                   /*max_num_completion=*/1, &completion_count,
+                   /*timeout=*/kPollTimeoutMs, &err);
+      if (completion_count == 0) {
+        if (was_stopping) return;
+        continue;
+      }
+      CL_CHECK(completion.err_code);
+      CHECK_EQ(completion.nbytes, bytes.size());
+      is_pending = false;
+      queue_.wait_not_full();
+      queue_.push(FromBytes(bytes));
+    }
+  }
+
+  // Converts between the MSB-first binary strings of `SharedMemoryQueue` and
+  // the little-endian bytes of kernel streams.
+  void ToBytes(std::string_view bits, char* bytes) const {
+    CHECK_EQ(bits.size(), width_);
+    std::fill(bytes, bytes + bytes_, 0);
+    for (int64_t i = 0; i < width_; ++i) {
+      if (bits[width_ - 1 - i] == '1') {
+        bytes[i / CHAR_BIT] |= 1 << (i % CHAR_BIT);
+      }
+    }
+  }
+  std::string FromBytes(const std::string& bytes) const {
+    std::string bits(width_, '0');
+    for (int64_t i = 0; i < width_; ++i) {
+      if ((bytes[i / CHAR_BIT] >> (i % CHAR_BIT)) & 1) {
+        bits[width_ - 1 - i] = '1';
+      }
+    }
+    return bits;
+  }
+
+  static constexpr cl_int kPollTimeoutMs = 100;
+  static constexpr size_t kMaxBatchBytes = 64 << 10;
+
+  const std::shared_ptr<SharedMemoryStream> host_stream_;
+  SharedMemoryQueue& queue_;
+  const int64_t width_;
+  const size_t bytes_;
+  cl_stream stream_;
+  std::atomic<bool> is_stopping_{false};
+  std::thread thread_;
+};
+
+XilinxOpenclDevice::~XilinxOpenclDevice() = default;
+
 void XilinxOpenclDevice::SetStreamArg(int index, Tag tag, StreamArg& arg) {
-  LOG(FATAL) << "Xilinx OpenCL streaming is disabled";
+  auto [arg_index, kernel] = GetKernel(index);
+  stream_table_[index] = std::make_unique<StreamBridge>(
+      device_, kernel, arg_index, tag,
+      arg.get<std::shared_ptr<SharedMemoryStream>>());
 }
 
 void XilinxOpenclDevice::WriteToDevice() {
-  if (!load_indices_.empty()) {
-    load_event_.resize(1);
-    CL_CHECK(cmd_.enqueueMigrateMemObjects(GetLoadBuffers(), /* flags = */ 0,
+  load_event_.clear();
+  load_transfers_.clear();
+  exec_wait_count_ = -1;
+  tiles_.clear();
+  BeginTransfer();
+  AllocateScratchBuffers();
+  if (load_indices_.empty()) return;
+
+  // Sub-buffers must start at multiples of the base address alignment.
+  cl_int err;
+  const size_t alignment =
+      device_.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>(&err) / 8;
+  CL_CHECK(err);
+  const size_t tile_bytes =
+      (FLAGS_xocl_tile_bytes + alignment - 1) / alignment * alignment;
+
+  // Each buffer that is not tiled is migrated by itself, so that its transfer
+  // is timed separately. Events that kernels must wait for come first.
+  std::vector<int> tiled_indices;
+  std::vector<std::vector<cl::Buffer>> tiled_buffers;
+  for (auto index : load_indices_) {
+    auto& transfer = load_transfers_[index];
+    std::vector<cl::Memory> buffers;
+    if (transfer_regions_.count(index)) {
+      // Buffers with tracked dirty ranges migrate only those ranges.
+      for (auto& buffer : GetTransferBuffers(index)) {
+        buffers.push_back(std::move(buffer));
+      }
+      for (const auto& region : transfer_regions_.at(index)) {
+        transfer.bytes += region.size;
+      }
+    } else {
+      cl::Buffer buffer = buffer_table_.at(index);
+      const size_t size = buffer.getInfo<CL_MEM_SIZE>(&err);
+      CL_CHECK(err);
+      transfer.bytes = size;
+      if (tile_bytes != 0 && size > tile_bytes) {
+        tiled_indices.push_back(index);
+        auto& tiles = tiled_buffers.emplace_back();
+        for (size_t offset = 0; offset < size; offset += tile_bytes) {
+          const cl_buffer_region region = {
+              offset, std::min(tile_bytes, size - offset)};
+          tiles.push_back(buffer.createSubBuffer(
+              /*flags=*/0, CL_BUFFER_CREATE_TYPE_REGION, &region, &err));
+          CL_CHECK(err);
+        }
+        continue;
+      }
+      buffers.push_back(buffer);
+    }
+    if (buffers.empty()) continue;
+    CL_CHECK(cmd_.enqueueMigrateMemObjects(buffers, /* flags = */ 0,
                                            /* events = */ nullptr,
-                                           load_event_.data()));
-  } else {
-    load_event_.clear();
+                                           &load_event_.emplace_back()));
+    transfer.events.push_back(load_event_.back());
+  }
+
+  // Tiles of each buffer are migrated in order.
+  std::vector<cl::Event> tile_event;
+  for (size_t i = 0; i < tiled_buffers.size(); ++i) {
+    CL_CHECK(cmd_.enqueueMigrateMemObjects(
+        {tiled_buffers[i].front()}, /* flags = */ 0,
+        /* events = */ nullptr, &load_event_.emplace_back()));
+    tile_event.push_back(load_event_.back());
+    load_transfers_[tiled_indices[i]].events.push_back(tile_event.back());
+  }
+  if (FLAGS_xocl_overlap_tiles) exec_wait_count_ = load_event_.size();
+  for (size_t i = 0; i < tiled_buffers.size(); ++i) {
+    const auto& tiles = tiled_buffers[i];
+    for (size_t j = 1; j < tiles.size(); ++j) {
+      const std::vector<cl::Event> wait_event = {tile_event[i]};
+      CL_CHECK(cmd_.enqueueMigrateMemObjects({tiles[j]}, /* flags = */ 0,
+                                             &wait_event, &tile_event[i]));
+      load_event_.push_back(tile_event[i]);
+      load_transfers_[tiled_indices[i]].events.push_back(tile_event[i]);
+    }
+    tiles_.insert(tiles_.end(), tiles.begin(), tiles.end());
   }
+  LogTransfers(EventLog::kLoad, load_transfers_);
 }
 
 void XilinxOpenclDevice::ReadFromDevice() {
-  if (!store_indices_.empty()) {
-    store_event_.resize(1);
+  store_event_.clear();
+  store_transfers_.clear();
+  for (auto index : store_indices_) {
+    std::vector<cl::Memory> buffers;
+    auto& transfer = store_transfers_[index];
+    for (auto& buffer : GetTransferBuffers(index)) {
+      buffers.push_back(std::move(buffer));
+    }
+    for (const auto& region : GetTransferRegions(index)) {
+      transfer.bytes += region.size;
+    }
+    if (buffers.empty()) continue;
     CL_CHECK(cmd_.enqueueMigrateMemObjects(
-        GetStoreBuffers(), CL_MIGRATE_MEM_OBJECT_HOST, &compute_event_,
-        store_event_.data()));
-  } else {
-    store_event_.clear();
+        buffers, CL_MIGRATE_MEM_OBJECT_HOST, &compute_event_,
+        &store_event_.emplace_back()));
+    transfer.events.push_back(store_event_.back());
   }
+  LogTransfers(EventLog::kStore, store_transfers_);
 }
 
-cl::Buffer XilinxOpenclDevice::CreateBuffer(int index, cl_mem_flags flags,
-                                            void* host_ptr, size_t size) {
+void XilinxOpenclDevice::Finish() {
+  OpenclDevice::Finish();
+  // Kernels have finished, so streams carry no more elements than those
+  // already produced.
+  for (auto& [index, stream] : stream_table_) {
+    stream->Stop();
+  }
+}
+
+std::vector<HardwareCounters> XilinxOpenclDevice::GetHardwareCounters() const {
+  if (getenv("XCL_EMULATION_MODE") != nullptr) {
+    // Counters are only read from boards.
+    return {};
+  }
+
+  char bdf[32];
+  CL_CHECK(clGetDeviceInfo(device_.get(), CL_DEVICE_PCIE_BDF, sizeof(bdf), bdf,
+                           nullptr));
+  std::vector<HardwareCounters> result;
+  try {
+    // OpenCL cannot read control registers, so use the native XRT API, which
+    // requires exclusive access to the compute units of each kernel.
+    xrt::device device(bdf);
+    xrt::uuid uuid(xclbin_uuid_.data());
+    for (const auto& name : kernel_names_) {
+      xrt::kernel kernel(device, uuid, name,
+                         xrt::kernel::cu_access_mode::exclusive);
+      for (auto& counters : ReadHardwareCounters([&](uint32_t offset) {
+             return kernel.read_register(offset);
+           })) {
+        result.push_back(std::move(counters));
+      }
+    }
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "cannot read hardware counters from device (bdf=" << bdf
+                 << "): " << e.what();
+  }
+  return result;
+}
+
+cl::Buffer XilinxOpenclDevice::CreateBuffer(cl_mem_flags flags, void* host_ptr,
+                                            size_t size) {
   flags |= CL_MEM_USE_HOST_PTR;
-  return OpenclDevice::CreateBuffer(index, flags, host_ptr, size);
+  if (flags & kHostOnlyMemFlag) {
+    // Allocated in host memory that the kernel accesses over PCIe, so that it
+    // is never migrated. The host memory is used only if it is page-aligned;
+    // otherwise, XRT copies it once to host memory of its own.
+    cl_mem_ext_ptr_t ext;
+    ext.flags = XCL_MEM_EXT_HOST_ONLY;
+    ext.obj = host_ptr;
+    ext.param = nullptr;
+    flags &= ~kHostOnlyMemFlag;
+    flags |= CL_MEM_EXT_PTR_XILINX;
+    return OpenclDevice::CreateBuffer(flags, &ext, size);
+  }
+  return OpenclDevice::CreateBuffer(flags, host_ptr, size);
 }
 
 }  // namespace internal
@@ -7,9 +7,11 @@
 
 #include <cstddef>
 
+#include <array>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <CL/cl2.hpp>
 
@@ -20,17 +22,33 @@ namespace internal {
 
 class XilinxOpenclDevice : public OpenclDevice {
  public:
-  XilinxOpenclDevice(const cl::Program::Binaries& binaries);
+  XilinxOpenclDevice(const cl::Program::Binaries& binaries, int device_index);
 
-  static std::unique_ptr<Device> New(const cl::Program::Binaries& binaries);
+  ~XilinxOpenclDevice() override;
+
+  static std::unique_ptr<Device> New(const cl::Program::Binaries& binaries,
+                                     int device_index);
 
   void SetStreamArg(int index, Tag tag, StreamArg& arg) override;
   void WriteToDevice() override;
   void ReadFromDevice() override;
+  void Finish() override;
+  std::vector<HardwareCounters> GetHardwareCounters() const override;
 
  private:
-  cl::Buffer CreateBuffer(int index, cl_mem_flags flags, void* host_ptr,
+  cl::Buffer CreateBuffer(cl_mem_flags flags, void* host_ptr,
                           size_t size) override;
+
+  // Identifies the xclbin and its kernels to read their control registers.
+  std::array<unsigned char, 16> xclbin_uuid_;
+  std::vector<std::string> kernel_names_;
+
+  // Sub-buffers of the tiles being migrated to the device.
+  std::vector<cl::Buffer> tiles_;
+
+  // Moves elements between a host stream and a kernel stream.
+  class StreamBridge;
+  std::unordered_map<int, std::unique_ptr<StreamBridge>> stream_table_;
 };
 
 }  // namespace internal
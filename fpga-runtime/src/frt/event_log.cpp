@@ -0,0 +1,109 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/event_log.h"
+
+#include <unistd.h>
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "frt/trace.h"
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+pid_t event_log_pid;  // Forked children do not write the log.
+
+void WriteEventLogAtExit() {
+  const char* path = getenv("TAPA_EVENT_LOG");
+  if (getpid() != event_log_pid) return;
+  std::ofstream ofs(path);
+  EventLog::Get().Write(ofs);
+  if (ofs.fail()) {
+    LOG(ERROR) << "failed to write event log to '" << path << "'";
+  }
+}
+
+}  // namespace
+
+EventLog& EventLog::Get() {
+  static EventLog* const log = [] {
+    if (const char* path = getenv("TAPA_EVENT_LOG");
+        path != nullptr && *path != '\0') {
+      event_log_pid = getpid();
+      std::atexit(WriteEventLogAtExit);
+    }
+    return new EventLog;
+  }();
+  return *log;
+}
+
+EventLog::EventLog(size_t capacity) : events_(capacity) {}
+
+int EventLog::AddDevice() { return device_count_++; }
+
+void EventLog::Record(int device, Kind kind, int index, uint64_t bytes) {
+  const int64_t time_ns = Trace::NowNs();
+  std::unique_lock lock(mtx_);
+  events_[event_count_ % events_.size()] = {
+      .time_ns = time_ns,
+      .device = device,
+      .kind = kind,
+      .index = index,
+      .bytes = bytes,
+  };
+  ++event_count_;
+}
+
+std::vector<EventLog::Event> EventLog::GetEvents() const {
+  std::unique_lock lock(mtx_);
+  const uint64_t capacity = events_.size();
+  std::vector<Event> events;
+  events.reserve(std::min(event_count_, capacity));
+  for (uint64_t i = event_count_ < capacity ? 0 : event_count_ - capacity;
+       i < event_count_; ++i) {
+    events.push_back(events_[i % capacity]);
+  }
+  return events;
+}
+
+void EventLog::Write(std::ostream& os) const {
+  for (const Event& event : GetEvents()) {
+    os << R"({"time_ns": )" << event.time_ns << R"(, "device": )"
+       << event.device << R"(, "event": ")" << event.kind << R"(", "arg": )"
+       << event.index << R"(, "bytes": )" << event.bytes << "}\n";
+  }
+}
+
+std::ostream& operator<<(std::ostream& os, EventLog::Kind kind) {
+  switch (kind) {
+    case EventLog::kBufferCreate:
+      return os << "buffer_create";
+    case EventLog::kBufferRelease:
+      return os << "buffer_release";
+    case EventLog::kLoad:
+      return os << "load";
+    case EventLog::kStore:
+      return os << "store";
+    case EventLog::kKernelStart:
+      return os << "kernel_start";
+    case EventLog::kKernelEnd:
+      return os << "kernel_end";
+  }
+  return os << "unknown";
+}
+
+}  // namespace internal
+}  // namespace fpga
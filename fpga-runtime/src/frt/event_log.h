@@ -0,0 +1,81 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef FPGA_RUNTIME_EVENT_LOG_H_
+#define FPGA_RUNTIME_EVENT_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace fpga {
+namespace internal {
+
+// Latest runtime events of all devices in this process, e.g., buffers being
+// created, transferred, and released, and kernels being started and observed
+// finished, to diagnose latency spikes after the fact. Unlike `Trace`, it is
+// always on: recording an event costs an uncontended lock and a copy of a few
+// words into a ring buffer, which overwrites the oldest events once full.
+// The events are written as JSON lines by `Write`, and to the path in
+// `TAPA_EVENT_LOG`, if set, when the process exits.
+class EventLog {
+ public:
+  enum Kind : uint8_t {
+    kBufferCreate,
+    kBufferRelease,
+    kLoad,   // Host to device.
+    kStore,  // Device to host.
+    kKernelStart,
+    kKernelEnd,
+  };
+
+  struct Event {
+    int64_t time_ns;  // On the steady clock, the same as `Trace::NowNs`.
+    int device;
+    Kind kind;
+    int index;  // Argument index, or -1 if not bound to an argument.
+    uint64_t bytes;
+  };
+
+  static constexpr size_t kDefaultCapacity = size_t{1} << 16;
+
+  // Returns the log of this process, which is never destroyed so that devices
+  // may record events until the process exits.
+  static EventLog& Get();
+
+  explicit EventLog(size_t capacity = kDefaultCapacity);
+
+  // Not copyable or movable.
+  EventLog(const EventLog&) = delete;
+  EventLog& operator=(const EventLog&) = delete;
+
+  // Returns a new ID for a device to record its events with.
+  int AddDevice();
+
+  void Record(int device, Kind kind, int index = -1, uint64_t bytes = 0);
+
+  // Returns the events recorded and not yet overwritten, oldest first.
+  std::vector<Event> GetEvents() const;
+
+  // Writes the events as JSON lines, oldest first.
+  void Write(std::ostream& os) const;
+
+ private:
+  std::atomic<int> device_count_ = 0;
+
+  mutable std::mutex mtx_;
+  std::vector<Event> events_;  // Ring buffer.
+  uint64_t event_count_ = 0;   // Total number of events recorded.
+};
+
+std::ostream& operator<<(std::ostream& os, EventLog::Kind kind);
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_EVENT_LOG_H_
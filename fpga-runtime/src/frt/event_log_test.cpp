@@ -0,0 +1,86 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/event_log.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace fpga {
+namespace internal {
+namespace {
+
+TEST(EventLogTest, RecordsEventsInOrder) {
+  EventLog log;
+  const int device = log.AddDevice();
+  log.Record(device, EventLog::kBufferCreate, 1, 4096);
+  log.Record(device, EventLog::kLoad, 1, 4096);
+  log.Record(device, EventLog::kKernelStart);
+
+  const auto events = log.GetEvents();
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(events[0].kind, EventLog::kBufferCreate);
+  EXPECT_EQ(events[1].kind, EventLog::kLoad);
+  EXPECT_EQ(events[1].index, 1);
+  EXPECT_EQ(events[1].bytes, 4096);
+  EXPECT_EQ(events[2].kind, EventLog::kKernelStart);
+  EXPECT_EQ(events[2].index, -1);
+  EXPECT_LE(events[0].time_ns, events[1].time_ns);
+  EXPECT_LE(events[1].time_ns, events[2].time_ns);
+}
+
+TEST(EventLogTest, OverwritesOldestEventsOnceFull) {
+  EventLog log(/*capacity=*/4);
+  for (int i = 0; i < 10; ++i) {
+    log.Record(/*device=*/0, EventLog::kStore, i);
+  }
+
+  const auto events = log.GetEvents();
+  ASSERT_EQ(events.size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(events[i].index, 6 + i);
+  }
+}
+
+TEST(EventLogTest, AssignsDistinctDeviceIds) {
+  EventLog log;
+  EXPECT_NE(log.AddDevice(), log.AddDevice());
+}
+
+TEST(EventLogTest, RecordsFromManyThreads) {
+  constexpr int kThreadCount = 4;
+  constexpr int kEventCount = 1000;
+  EventLog log;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&log, i] {
+      for (int j = 0; j < kEventCount; ++j) {
+        log.Record(i, EventLog::kKernelEnd);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(log.GetEvents().size(), kThreadCount * kEventCount);
+}
+
+TEST(EventLogTest, WritesJsonLines) {
+  EventLog log;
+  log.Record(/*device=*/2, EventLog::kBufferRelease, 3, 64);
+  std::ostringstream os;
+  log.Write(os);
+  const std::string line = os.str();
+  EXPECT_EQ(line.find(R"({"time_ns": )"), 0);
+  EXPECT_NE(line.find(R"(, "device": 2, "event": "buffer_release", )"
+                      R"("arg": 3, "bytes": 64}
+)"),
+            std::string::npos);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace fpga
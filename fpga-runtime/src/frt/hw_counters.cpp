@@ -0,0 +1,116 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/hw_counters.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace fpga {
+
+std::ostream& operator<<(std::ostream& os, const HardwareCounters& counters) {
+  os << "HardwareCounters: {" << (counters.is_mmap ? "mmap" : "stream")
+     << ": '" << counters.name << "', cycles: " << counters.cycles;
+  if (counters.is_mmap) {
+    os << ", read: " << counters.read_beats << " beats, "
+       << counters.read_stall_cycles
+       << " stall cycles, write: " << counters.write_beats << " beats, "
+       << counters.write_stall_cycles << " stall cycles}";
+  } else {
+    os << ", full: " << counters.full_cycles
+       << " cycles, empty: " << counters.empty_cycles
+       << " cycles, transfers: " << counters.transfers << "}";
+  }
+  return os;
+}
+
+namespace internal {
+
+namespace {
+
+// Keep in sync with `tapa/common/hw_counters.py`.
+constexpr uint32_t kBaseAddr = 0x800;
+constexpr uint32_t kWindowSize = 0x800;
+constexpr uint32_t kHeaderSize = 0x10;
+constexpr uint32_t kMagic = 0x54415041;
+
+}  // namespace
+
+std::vector<HardwareCounters> ReadHardwareCounters(
+    const RegisterReader& read_register) {
+  auto read = [&](uint32_t offset) {
+    return read_register(kBaseAddr + offset);
+  };
+  if (read(0x0) != kMagic) {
+    return {};
+  }
+
+  const uint32_t counter_count = read(0x4);
+  const uint32_t name_size = read(0x8);
+  if (counter_count == 0 ||
+      kHeaderSize + 8 * counter_count + name_size > kWindowSize) {
+    LOG(WARNING) << "ignoring malformed hardware counters of "
+                 << counter_count << " counters and " << name_size
+                 << " bytes of names";
+    return {};
+  }
+
+  std::vector<int64_t> values(counter_count);
+  for (uint32_t i = 0; i < counter_count; ++i) {
+    const uint32_t offset = kHeaderSize + 8 * i;
+    values[i] = static_cast<int64_t>(read(offset)) |
+                static_cast<int64_t>(read(offset + 4)) << 32;
+  }
+
+  std::string names;
+  names.reserve(name_size);
+  for (uint32_t i = 0; i < name_size; i += 4) {
+    const uint32_t word = read(kHeaderSize + 8 * counter_count + i);
+    for (int j = 0; j < 4; ++j) {
+      names.push_back(static_cast<char>(word >> (8 * j)));
+    }
+  }
+
+  std::vector<HardwareCounters> result;
+  uint32_t next = 1;  // Counter 0 counts cycles.
+  for (std::string_view remaining = names; !remaining.empty();) {
+    const std::string_view entry = remaining.substr(0, remaining.find('\0'));
+    remaining.remove_prefix(std::min(entry.size() + 1, remaining.size()));
+    if (entry.empty()) break;  // Padding.
+
+    HardwareCounters& counters = result.emplace_back();
+    counters.cycles = values[0];
+    const size_t colon = entry.find(':');
+    counters.name = std::string(entry.substr(colon + 1));
+    counters.is_mmap = entry.substr(0, colon) == "mmap";
+    std::vector<int64_t*> fields;
+    if (counters.is_mmap) {
+      fields = {&counters.read_beats, &counters.write_beats,
+                &counters.read_stall_cycles, &counters.write_stall_cycles};
+    } else {
+      fields = {&counters.full_cycles, &counters.empty_cycles,
+                &counters.transfers};
+    }
+    for (int64_t* field : fields) {
+      if (next >= counter_count) {
+        LOG(WARNING) << "missing hardware counters of '" << counters.name
+                     << "'";
+        return result;
+      }
+      *field = values[next++];
+    }
+  }
+  return result;
+}
+
+}  // namespace internal
+
+}  // namespace fpga
@@ -0,0 +1,59 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef FPGA_RUNTIME_HW_COUNTERS_H_
+#define FPGA_RUNTIME_HW_COUNTERS_H_
+
+#include <cstdint>
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace fpga {
+
+// Events on a stream or mmap of the top-level task in the last invocation,
+// counted in hardware by the counters that `tapa synth --hw-counter` inserts.
+// Streams only set the stream counters and mmaps only set the mmap counters.
+struct HardwareCounters {
+  std::string name;
+  bool is_mmap = false;
+
+  // Cycles from the start of the kernel until it is idle.
+  int64_t cycles = 0;
+
+  // Cycles a stream was full or empty, and tokens transferred on it.
+  int64_t full_cycles = 0;
+  int64_t empty_cycles = 0;
+  int64_t transfers = 0;
+
+  // Data transferred on the R and W channels of an mmap.
+  int64_t read_beats = 0;
+  int64_t write_beats = 0;
+
+  // Cycles the AR or AW channel of an mmap was valid but not ready, i.e., the
+  // memory stalled the kernel.
+  int64_t read_stall_cycles = 0;
+  int64_t write_stall_cycles = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const HardwareCounters& counters);
+
+namespace internal {
+
+// Reads 32-bit control registers of a kernel at byte offsets.
+using RegisterReader = std::function<uint32_t(uint32_t offset)>;
+
+// Decodes the hardware counters from the control registers of a kernel, as
+// laid out by `tapa/common/hw_counters.py`. Returns an empty vector if the
+// kernel has no hardware counters.
+std::vector<HardwareCounters> ReadHardwareCounters(
+    const RegisterReader& read_register);
+
+}  // namespace internal
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_HW_COUNTERS_H_
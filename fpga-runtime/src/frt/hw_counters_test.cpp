@@ -0,0 +1,68 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/hw_counters.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace fpga {
+namespace internal {
+namespace {
+
+// Control registers of a kernel with hardware counters on stream `q` and mmap
+// `mem`, as served by `tapa/assets/verilog/hw_counters.v`.
+std::map<uint32_t, uint32_t> MakeRegisters() {
+  std::map<uint32_t, uint32_t> registers = {
+      {0x800, 0x54415041},  // magic
+      {0x804, 8},           // counters
+      {0x808, 20},          // bytes of names
+  };
+  const uint64_t values[] = {100, 3, 4, 5, 6, 7, 8, uint64_t{9} << 32};
+  for (uint32_t i = 0; i < 8; ++i) {
+    registers[0x810 + 8 * i] = static_cast<uint32_t>(values[i]);
+    registers[0x814 + 8 * i] = static_cast<uint32_t>(values[i] >> 32);
+  }
+  const char names[20] = "stream:q\0mmap:mem";
+  for (uint32_t i = 0; i < 20; i += 4) {
+    uint32_t word;
+    memcpy(&word, names + i, 4);
+    registers[0x850 + i] = word;
+  }
+  return registers;
+}
+
+TEST(HardwareCountersTest, DecodesCounters) {
+  auto registers = MakeRegisters();
+  auto counters = ReadHardwareCounters(
+      [&](uint32_t offset) { return registers[offset]; });
+
+  ASSERT_EQ(counters.size(), 2);
+  EXPECT_EQ(counters[0].name, "q");
+  EXPECT_FALSE(counters[0].is_mmap);
+  EXPECT_EQ(counters[0].cycles, 100);
+  EXPECT_EQ(counters[0].full_cycles, 3);
+  EXPECT_EQ(counters[0].empty_cycles, 4);
+  EXPECT_EQ(counters[0].transfers, 5);
+  EXPECT_EQ(counters[1].name, "mem");
+  EXPECT_TRUE(counters[1].is_mmap);
+  EXPECT_EQ(counters[1].cycles, 100);
+  EXPECT_EQ(counters[1].read_beats, 6);
+  EXPECT_EQ(counters[1].write_beats, 7);
+  EXPECT_EQ(counters[1].read_stall_cycles, 8);
+  EXPECT_EQ(counters[1].write_stall_cycles, int64_t{9} << 32);
+}
+
+TEST(HardwareCountersTest, IgnoresKernelsWithoutCounters) {
+  EXPECT_TRUE(ReadHardwareCounters([](uint32_t) { return 0; }).empty());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,133 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/latency_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+constexpr size_t kSubBucketCount = size_t{1}
+                                   << LatencyHistogram::kSubBucketBits;
+
+const char* GetMetricName(LatencyStats::Phase phase) {
+  switch (phase) {
+    case LatencyStats::kLoad:
+      return "frt_load_latency_seconds";
+    case LatencyStats::kCompute:
+      return "frt_compute_latency_seconds";
+    case LatencyStats::kStore:
+      return "frt_store_latency_seconds";
+    case LatencyStats::kPhaseCount:
+      break;
+  }
+  return "frt_unknown_latency_seconds";
+}
+
+const char* GetMetricHelp(LatencyStats::Phase phase) {
+  switch (phase) {
+    case LatencyStats::kLoad:
+      return "Time to transfer buffers from the host to the device.";
+    case LatencyStats::kCompute:
+      return "Time to run the kernels.";
+    case LatencyStats::kStore:
+      return "Time to transfer buffers from the device to the host.";
+    case LatencyStats::kPhaseCount:
+      break;
+  }
+  return "";
+}
+
+}  // namespace
+
+void LatencyHistogram::Record(int64_t ns) {
+  ns = std::max<int64_t>(ns, 0);
+  ++buckets_[BucketOf(ns)];
+  ++count_;
+  sum_ += ns;
+  max_ = std::max(max_, ns);
+}
+
+int64_t LatencyHistogram::Quantile(double q) const {
+  if (count_ == 0) return 0;
+  const uint64_t rank = std::clamp<uint64_t>(
+      static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_))), 1,
+      count_);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::min<int64_t>(UpperBoundOf(i), max_);
+    }
+  }
+  return max_;
+}
+
+size_t LatencyHistogram::BucketOf(uint64_t ns) {
+  if (ns < 2 * kSubBucketCount) return ns;
+  // Keeps the `kSubBucketBits + 1` most significant bits.
+  const int shift = 63 - __builtin_clzll(ns) - kSubBucketBits;
+  return shift * kSubBucketCount + (ns >> shift);
+}
+
+uint64_t LatencyHistogram::UpperBoundOf(size_t bucket) {
+  if (bucket < 2 * kSubBucketCount) return bucket;
+  const int shift = bucket / kSubBucketCount - 1;
+  const uint64_t mantissa = bucket % kSubBucketCount + kSubBucketCount;
+  return ((mantissa + 1) << shift) - 1;
+}
+
+LatencyStats& LatencyStats::Get() {
+  static LatencyStats* const stats = new LatencyStats;
+  return *stats;
+}
+
+void LatencyStats::Record(int device, Phase phase, int64_t ns) {
+  std::unique_lock lock(mtx_);
+  devices_[device][phase].Record(ns);
+}
+
+LatencyHistogram LatencyStats::GetHistogram(int device, Phase phase) const {
+  std::unique_lock lock(mtx_);
+  auto it = devices_.find(device);
+  return it == devices_.end() ? LatencyHistogram() : it->second[phase];
+}
+
+void LatencyStats::WritePrometheus(std::ostream& os) const {
+  // Formats to a buffer so that the precision of `os` is left unchanged.
+  std::ostringstream oss;
+  oss.precision(9);
+  {
+    std::unique_lock lock(mtx_);
+    for (int i = 0; i < kPhaseCount; ++i) {
+      const auto phase = static_cast<Phase>(i);
+      const char* name = GetMetricName(phase);
+      oss << "# HELP " << name << " " << GetMetricHelp(phase) << "\n"
+          << "# TYPE " << name << " summary\n";
+      for (const auto& [device, histograms] : devices_) {
+        const LatencyHistogram& histogram = histograms[phase];
+        if (histogram.Count() == 0) continue;
+        for (double q : kQuantiles) {
+          oss << name << "{device=\"" << device << "\",quantile=\"" << q
+              << "\"} " << histogram.Quantile(q) * 1e-9 << "\n";
+        }
+        oss << name << "_sum{device=\"" << device << "\"} "
+            << histogram.Sum() * 1e-9 << "\n"
+            << name << "_count{device=\"" << device << "\"} "
+            << histogram.Count() << "\n";
+      }
+    }
+  }
+  os << oss.str();
+}
+
+}  // namespace internal
+}  // namespace fpga
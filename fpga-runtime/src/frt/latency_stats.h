@@ -0,0 +1,95 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef FPGA_RUNTIME_LATENCY_STATS_H_
+#define FPGA_RUNTIME_LATENCY_STATS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <ostream>
+
+namespace fpga {
+namespace internal {
+
+// Distribution of latencies in nanoseconds, in buckets of constant relative
+// width as in HDR histograms: values below 64 have buckets of their own, and
+// each larger power-of-two range is split into 32 buckets, so quantiles are
+// within about 3% of the recorded values at any scale, in constant space.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr size_t kBucketCount = (64 - kSubBucketBits)
+                                         << kSubBucketBits;
+
+  // Records a latency; negative values are recorded as 0.
+  void Record(int64_t ns);
+
+  // Returns the number of latencies recorded.
+  uint64_t Count() const { return count_; }
+
+  // Returns the sum of the latencies recorded.
+  int64_t Sum() const { return sum_; }
+
+  // Returns the latency at quantile `q` in [0, 1], i.e., the upper bound of
+  // the bucket that holds it, or 0 if nothing is recorded.
+  int64_t Quantile(double q) const;
+
+  // Returns the index of the bucket of `ns` and the largest value in it.
+  static size_t BucketOf(uint64_t ns);
+  static uint64_t UpperBoundOf(size_t bucket);
+
+ private:
+  std::array<uint64_t, kBucketCount> buckets_ = {};
+  uint64_t count_ = 0;
+  int64_t sum_ = 0;
+  int64_t max_ = 0;
+};
+
+// Latency histograms of each phase of invocations on all devices in this
+// process, for service-level tracking of tail latencies. Devices record the
+// latencies of each invocation that finishes; `WritePrometheus` exports them
+// as summaries in the Prometheus text format.
+class LatencyStats {
+ public:
+  enum Phase : uint8_t {
+    kLoad,     // Host to device.
+    kCompute,  // Kernels.
+    kStore,    // Device to host.
+    kPhaseCount,
+  };
+
+  // Quantiles that `WritePrometheus` exports.
+  static constexpr std::array<double, 4> kQuantiles = {0.5, 0.9, 0.99, 0.999};
+
+  // Returns the stats of this process, which are never destroyed.
+  static LatencyStats& Get();
+
+  LatencyStats() = default;
+
+  // Not copyable or movable.
+  LatencyStats(const LatencyStats&) = delete;
+  LatencyStats& operator=(const LatencyStats&) = delete;
+
+  // Records `ns` as a latency of `phase` on `device`.
+  void Record(int device, Phase phase, int64_t ns);
+
+  // Returns a copy of the histogram of `phase` on `device`.
+  LatencyHistogram GetHistogram(int device, Phase phase) const;
+
+  // Writes a summary in seconds of each phase, labeled by device.
+  void WritePrometheus(std::ostream& os) const;
+
+ private:
+  mutable std::mutex mtx_;
+  std::map<int, std::array<LatencyHistogram, kPhaseCount>> devices_;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_LATENCY_STATS_H_
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/latency_stats.h"
+
+#include <cstdint>
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace fpga {
+namespace internal {
+namespace {
+
+TEST(LatencyHistogramTest, BucketsCoverValuesWithBoundedRelativeError) {
+  for (uint64_t ns : {uint64_t{0}, uint64_t{63}, uint64_t{64}, uint64_t{1000},
+                      uint64_t{123456789}, uint64_t{INT64_MAX}}) {
+    const size_t bucket = LatencyHistogram::BucketOf(ns);
+    ASSERT_LT(bucket, LatencyHistogram::kBucketCount);
+    const uint64_t upper = LatencyHistogram::UpperBoundOf(bucket);
+    EXPECT_GE(upper, ns);
+    EXPECT_LE(upper - ns, ns / 32);
+    if (bucket > 0) {
+      EXPECT_LT(LatencyHistogram::UpperBoundOf(bucket - 1), ns);
+    }
+  }
+}
+
+TEST(LatencyHistogramTest, ReturnsQuantilesOfRecordedLatencies) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.Quantile(0.5), 0);
+  for (int64_t ns = 1; ns <= 1000; ++ns) {
+    histogram.Record(ns * 1000);
+  }
+  EXPECT_EQ(histogram.Count(), 1000);
+  EXPECT_EQ(histogram.Sum(), 500500 * 1000);
+  EXPECT_NEAR(histogram.Quantile(0.5), 500000, 500000 / 32);
+  EXPECT_NEAR(histogram.Quantile(0.99), 990000, 990000 / 32);
+  EXPECT_EQ(histogram.Quantile(1), 1000000);
+  EXPECT_EQ(histogram.Quantile(0), histogram.Quantile(0.001));
+}
+
+TEST(LatencyStatsTest, WritesPrometheusSummariesPerDevice) {
+  LatencyStats stats;
+  stats.Record(/*device=*/0, LatencyStats::kCompute, 2000000000);
+  stats.Record(/*device=*/1, LatencyStats::kLoad, 1000);
+  EXPECT_EQ(stats.GetHistogram(0, LatencyStats::kCompute).Count(), 1);
+  EXPECT_EQ(stats.GetHistogram(1, LatencyStats::kCompute).Count(), 0);
+
+  std::ostringstream os;
+  stats.WritePrometheus(os);
+  const std::string text = os.str();
+  EXPECT_NE(text.find("# TYPE frt_compute_latency_seconds summary\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("frt_compute_latency_seconds{device=\"0\","
+                      "quantile=\"0.999\"} 2\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("frt_compute_latency_seconds_count{device=\"0\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("frt_load_latency_seconds_sum{device=\"1\"} 1e-06\n"),
+            std::string::npos);
+  EXPECT_EQ(text.find("frt_load_latency_seconds_count{device=\"0\"}"),
+            std::string::npos);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,27 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/port_stats.h"
+
+#include <ostream>
+
+namespace fpga {
+
+std::ostream& operator<<(std::ostream& os, const PortStats& stats) {
+  os << "PortStats: {arg: " << stats.arg.index << " '" << stats.arg.name
+     << "', cycles: " << stats.cycles << ", read: " << stats.read_bursts
+     << " bursts, " << stats.read_beats << " beats, "
+     << stats.read_request_stall_cycles << " request stall cycles, "
+     << stats.read_data_stall_cycles << " data stall cycles, "
+     << stats.max_outstanding_reads
+     << " max outstanding, write: " << stats.write_bursts << " bursts, "
+     << stats.write_beats << " beats, " << stats.write_request_stall_cycles
+     << " request stall cycles, " << stats.write_data_stall_cycles
+     << " data stall cycles, " << stats.max_outstanding_writes
+     << " max outstanding, host: " << stats.host_empty_cycles
+     << " empty cycles, " << stats.host_full_cycles << " full cycles}";
+  return os;
+}
+
+}  // namespace fpga
@@ -0,0 +1,59 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef FPGA_RUNTIME_PORT_STATS_H_
+#define FPGA_RUNTIME_PORT_STATS_H_
+
+#include <cstdint>
+
+#include <ostream>
+
+#include "frt/arg_info.h"
+
+namespace fpga {
+
+// Simulated traffic on the port of an mmap or stream argument in the last
+// invocation, counted in kernel clock cycles. Mmaps count both directions;
+// input streams only count reads and output streams only count writes.
+struct PortStats {
+  ArgInfo arg;
+
+  // Cycles from the start of the kernel until it is done.
+  int64_t cycles = 0;
+
+  // Bursts requested on the AR and AW channels of an mmap.
+  int64_t read_bursts = 0;
+  int64_t write_bursts = 0;
+
+  // Data transferred on the R and W channels of an mmap, or tokens
+  // transferred on a stream.
+  int64_t read_beats = 0;
+  int64_t write_beats = 0;
+
+  // Cycles the AR or AW channel of an mmap was valid but not ready, i.e., the
+  // memory stalled the kernel.
+  int64_t read_request_stall_cycles = 0;
+  int64_t write_request_stall_cycles = 0;
+
+  // Cycles the R or W channel of an mmap, or a stream, was valid but not
+  // ready, i.e., the receiver stalled the sender.
+  int64_t read_data_stall_cycles = 0;
+  int64_t write_data_stall_cycles = 0;
+
+  // Maximum number of bursts of an mmap in flight at the same time.
+  int64_t max_outstanding_reads = 0;
+  int64_t max_outstanding_writes = 0;
+
+  // Cycles the host queue of a stream read by the kernel was empty, or of a
+  // stream written by the kernel was full, so that the testbench stalled the
+  // kernel; see `--xosim_stream_batch_size`.
+  int64_t host_empty_cycles = 0;
+  int64_t host_full_cycles = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const PortStats& stats);
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_PORT_STATS_H_
@@ -7,7 +7,12 @@
 
 #include "frt/devices/shared_memory_queue.h"
 
+#include <cstddef>
+
+#include <array>
+#include <chrono>
 #include <memory>
+#include <utility>
 
 #include <glog/logging.h>
 
@@ -19,6 +24,20 @@
 namespace fpga {
 namespace internal {
 
+// Tokens of types whose binary string is written to a caller-provided buffer
+// are encoded straight into the shared memory queue without `std::string`.
+template <typename T>
+inline constexpr bool kIsInPlaceStreamable = kHasPackedBinaryString<T>;
+
+template <typename T>
+size_t GetBinaryStringWidth() {
+  if constexpr (kIsInPlaceStreamable<T>) {
+    return BinaryStringWidth<T>();
+  } else {
+    return ToBinaryString(T()).size();
+  }
+}
+
 template <typename T>
 class StreamBase : public StreamArg {
  public:
@@ -26,12 +45,21 @@ class StreamBase : public StreamArg {
       : StreamArg(
             std::make_shared<SharedMemoryStream>(SharedMemoryStream::Options{
                 .depth = depth,
-                .width = ToBinaryString(T()).size(),
+                .width = GetBinaryStringWidth<T>(),
             })) {}
 
+  // Shares `stream` with another stream, e.g., the opposite end of a stream
+  // connecting two kernels, which exchange tokens without involving the host.
+  explicit StreamBase(std::shared_ptr<SharedMemoryStream> stream)
+      : StreamArg(std::move(stream)) {}
+
+  std::shared_ptr<SharedMemoryStream> stream() const {
+    return get<std::shared_ptr<SharedMemoryStream>>();
+  }
+
  protected:
   SharedMemoryQueue& queue() const {
-    return *CHECK_NOTNULL(get<std::shared_ptr<SharedMemoryStream>>()->queue());
+    return *CHECK_NOTNULL(stream()->queue());
   }
 };
 
@@ -44,8 +72,37 @@ class Stream<T, Tag::kReadOnly> : public StreamBase<T> {
   using StreamBase<T>::StreamBase;
 
   bool empty() const { return this->queue().empty(); }
-  T pop() { return FromBinaryString<T>(this->queue().pop()); };
-  T front() const { return FromBinaryString<T>(this->queue().front()); }
+
+  // Sleeps until a token is available or `timeout` passes, instead of spinning
+  // on `empty()`. Returns whether a token is available.
+  bool wait(std::chrono::nanoseconds timeout =
+                std::chrono::nanoseconds::max()) const {
+    return this->queue().wait_not_empty(timeout);
+  }
+
+  T pop() {
+    if constexpr (kIsInPlaceStreamable<T>) {
+      std::array<char, BinaryStringWidth<T>()> str;
+      this->queue().pop_into(str.data());
+      T val;
+      ReadBinaryString(str.data(), val);
+      return val;
+    } else {
+      return FromBinaryString<T>(this->queue().pop());
+    }
+  }
+
+  T front() const {
+    if constexpr (kIsInPlaceStreamable<T>) {
+      std::array<char, BinaryStringWidth<T>()> str;
+      this->queue().front_into(str.data());
+      T val;
+      ReadBinaryString(str.data(), val);
+      return val;
+    } else {
+      return FromBinaryString<T>(this->queue().front());
+    }
+  }
 };
 
 template <typename T>
@@ -54,7 +111,22 @@ class Stream<T, Tag::kWriteOnly> : public StreamBase<T> {
   using StreamBase<T>::StreamBase;
 
   bool full() const { return this->queue().full(); }
-  void push(const T& val) { this->queue().push(ToBinaryString(val)); }
+
+  // Sleeps until a token can be pushed or `timeout` passes, instead of spinning
+  // on `full()`. Returns whether a token can be pushed.
+  bool wait(std::chrono::nanoseconds timeout =
+                std::chrono::nanoseconds::max()) const {
+    return this->queue().wait_not_full(timeout);
+  }
+  void push(const T& val) {
+    if constexpr (kIsInPlaceStreamable<T>) {
+      std::array<char, BinaryStringWidth<T>()> str;
+      WriteBinaryString(val, str.data());
+      this->queue().push(str.data(), str.size());
+    } else {
+      this->queue().push(ToBinaryString(val));
+    }
+  }
 };
 
 }  // namespace internal
@@ -0,0 +1,45 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/stream_pump.h"
+
+#include <ostream>
+#include <utility>
+
+namespace fpga {
+
+double StreamPumpStats::TokensPerSecond() const {
+  if (tokens == 0 || elapsed_ns <= 0) return 0;
+  return static_cast<double>(tokens) * 1e9 / static_cast<double>(elapsed_ns);
+}
+
+std::ostream& operator<<(std::ostream& os, const StreamPumpStats& stats) {
+  return os << stats.tokens << " tokens in " << stats.elapsed_ns * 1e-9
+            << " s (" << stats.TokensPerSecond() << " tokens/s)";
+}
+
+StreamPump& StreamPump::operator=(StreamPump&& other) {
+  if (this != &other) {
+    if (thread_.joinable()) Stop();
+    state_ = std::move(other.state_);
+    thread_ = std::move(other.thread_);
+  }
+  return *this;
+}
+
+StreamPump::~StreamPump() {
+  if (thread_.joinable()) Stop();
+}
+
+StreamPumpStats StreamPump::Join() {
+  if (thread_.joinable()) thread_.join();
+  return state_->stats;
+}
+
+StreamPumpStats StreamPump::Stop() {
+  state_->stopped.store(true, std::memory_order_relaxed);
+  return Join();
+}
+
+}  // namespace fpga
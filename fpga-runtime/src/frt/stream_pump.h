@@ -0,0 +1,129 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef FPGA_RUNTIME_STREAM_PUMP_H_
+#define FPGA_RUNTIME_STREAM_PUMP_H_
+
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <thread>
+#include <utility>
+
+#include "frt/stream.h"
+#include "frt/tag.h"
+
+namespace fpga {
+
+// Tokens moved by a `StreamPump` and the time it took.
+struct StreamPumpStats {
+  uint64_t tokens = 0;
+  int64_t elapsed_ns = 0;  // From the start of the pump to its last token.
+
+  // Returns the achieved throughput, or 0 if nothing was moved.
+  double TokensPerSecond() const;
+};
+
+std::ostream& operator<<(std::ostream& os, const StreamPumpStats& stats);
+
+// Moves tokens between the host and a stream of a running kernel on a thread
+// of its own, e.g., between `Instance::Exec` and `Instance::Finish`. The
+// thread sleeps while the stream is full or empty instead of spinning on it,
+// so that the host keeps up with the kernel without burning a core. The
+// stream must outlive the pump, and must not be used by others meanwhile.
+class StreamPump {
+ public:
+  // Pushes the tokens that `source` returns to `stream`, until it returns
+  // `std::nullopt`.
+  template <typename T, typename Source>
+  static StreamPump Feed(internal::Stream<T, internal::Tag::kWriteOnly>& stream,
+                         Source source) {
+    return StreamPump([&stream, source = std::move(source)](
+                          const std::atomic<bool>& stopped) mutable {
+      uint64_t tokens = 0;
+      for (std::optional<T> val; (val = source());) {
+        while (!stream.wait(kPollInterval)) {
+          if (stopped.load(std::memory_order_relaxed)) return tokens;
+        }
+        stream.push(*val);
+        ++tokens;
+      }
+      return tokens;
+    });
+  }
+
+  // Pushes the tokens in [`begin`, `end`) to `stream`.
+  template <typename T, typename Iterator>
+  static StreamPump Feed(internal::Stream<T, internal::Tag::kWriteOnly>& stream,
+                         Iterator begin, Iterator end) {
+    return Feed(stream, [begin, end]() mutable -> std::optional<T> {
+      if (begin == end) return std::nullopt;
+      return *begin++;
+    });
+  }
+
+  // Pops `count` tokens from `stream` and passes each to `sink`.
+  template <typename T, typename Sink>
+  static StreamPump Drain(internal::Stream<T, internal::Tag::kReadOnly>& stream,
+                          uint64_t count, Sink sink) {
+    return StreamPump([&stream, count, sink = std::move(sink)](
+                          const std::atomic<bool>& stopped) mutable {
+      uint64_t tokens = 0;
+      for (; tokens < count; ++tokens) {
+        while (!stream.wait(kPollInterval)) {
+          if (stopped.load(std::memory_order_relaxed)) return tokens;
+        }
+        sink(stream.pop());
+      }
+      return tokens;
+    });
+  }
+
+  // Move-only. Assigning to a pump stops it first.
+  StreamPump(StreamPump&&) = default;
+  StreamPump& operator=(StreamPump&& other);
+
+  // Stops the pump, if not yet joined, and waits for its thread.
+  ~StreamPump();
+
+  // Waits until all tokens are moved and returns the stats.
+  StreamPumpStats Join();
+
+  // Stops moving tokens, e.g., after the kernel failed, and returns the stats
+  // of the tokens moved so far.
+  StreamPumpStats Stop();
+
+ private:
+  // Interval to check whether the pump is stopped while the stream is blocked.
+  static constexpr std::chrono::milliseconds kPollInterval{100};
+
+  struct State {
+    std::atomic<bool> stopped = false;
+    StreamPumpStats stats;
+  };
+
+  // Runs `pump` with a flag that is set when the pump is stopped. `pump`
+  // returns the number of tokens it moved.
+  template <typename Pump>
+  explicit StreamPump(Pump pump)
+      : state_(std::make_unique<State>()),
+        thread_([state = state_.get(), pump = std::move(pump)]() mutable {
+          const auto start = std::chrono::steady_clock::now();
+          state->stats.tokens = pump(state->stopped);
+          state->stats.elapsed_ns =
+              std::chrono::nanoseconds(std::chrono::steady_clock::now() - start)
+                  .count();
+        }) {}
+
+  std::unique_ptr<State> state_;
+  std::thread thread_;
+};
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_STREAM_PUMP_H_
@@ -0,0 +1,72 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/stream_pump.h"
+
+#include <cstdint>
+
+#include <optional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "frt/stream.h"
+#include "frt/tag.h"
+
+namespace fpga {
+namespace {
+
+using internal::Stream;
+using internal::Tag;
+
+TEST(StreamPumpTest, FeedsAndDrainsStreamConcurrently) {
+  constexpr uint64_t kCount = 10000;
+  Stream<int64_t, Tag::kWriteOnly> write_stream(/*depth=*/4);
+  Stream<int64_t, Tag::kReadOnly> read_stream(write_stream.stream());
+
+  std::vector<int64_t> values;
+  StreamPump drain = StreamPump::Drain(
+      read_stream, kCount, [&values](int64_t val) { values.push_back(val); });
+  int64_t next = 0;
+  StreamPump feed =
+      StreamPump::Feed(write_stream, [&next]() -> std::optional<int64_t> {
+        if (next == kCount) return std::nullopt;
+        return next++;
+      });
+
+  EXPECT_EQ(feed.Join().tokens, kCount);
+  const StreamPumpStats stats = drain.Join();
+  EXPECT_EQ(stats.tokens, kCount);
+  EXPECT_GT(stats.TokensPerSecond(), 0);
+  ASSERT_EQ(values.size(), kCount);
+  for (uint64_t i = 0; i < kCount; ++i) {
+    EXPECT_EQ(values[i], i);
+  }
+}
+
+TEST(StreamPumpTest, FeedsIteratorRange) {
+  const std::vector<int> input = {1, 2, 3};
+  Stream<int, Tag::kWriteOnly> write_stream(/*depth=*/4);
+  Stream<int, Tag::kReadOnly> read_stream(write_stream.stream());
+
+  EXPECT_EQ(StreamPump::Feed(write_stream, input.begin(), input.end())
+                .Join()
+                .tokens,
+            input.size());
+  for (int val : input) {
+    EXPECT_EQ(read_stream.pop(), val);
+  }
+}
+
+TEST(StreamPumpTest, StopsWhileStreamIsBlocked) {
+  Stream<int, Tag::kWriteOnly> write_stream(/*depth=*/2);
+  StreamPump feed = StreamPump::Feed(
+      write_stream, [] { return std::optional<int>(0); });
+  Stream<int, Tag::kReadOnly> read_stream(write_stream.stream());
+  read_stream.wait();
+  EXPECT_EQ(feed.Stop().tokens, 2);
+}
+
+}  // namespace
+}  // namespace fpga
@@ -9,6 +9,7 @@
 // IWYU pragma: private, include "frt.h"
 
 #include <climits>
+#include <cstddef>
 #include <cstring>
 
 #include <algorithm>
@@ -16,6 +17,7 @@
 #include <bitset>
 #include <string>
 #include <string_view>
+#include <type_traits>
 
 #include <glog/logging.h>
 
@@ -50,6 +52,47 @@ struct HasFromBinaryString<
            std::declval<std::string_view>(), std::declval<T&>()))>>>
     : std::true_type {};
 
+// `HasPackedBinaryStringImpl<T>::value` is `true` if and only if overloads of
+// `BinaryStringWidthImpl<T>`, `WriteBinaryStringImpl<T>`, and
+// `ReadBinaryStringImpl<T>` are defined. Unlike `ToBinaryStringImpl<T>` and
+// `FromBinaryStringImpl<T>`, these encode into and decode from a buffer
+// provided by the caller, so streaming `T` does not allocate:
+//
+//   constexpr size_t BinaryStringWidthImpl(const T*);  // Argument is nullptr.
+//   void WriteBinaryStringImpl(const T* val, char* str);
+//   void ReadBinaryStringImpl(const char* str, T& val);
+template <typename T, typename = void>
+struct HasPackedBinaryStringImpl : std::false_type {};
+template <typename T>
+struct HasPackedBinaryStringImpl<
+    T, std::enable_if_t<
+           std::is_same_v<size_t, decltype(BinaryStringWidthImpl(
+                                      std::declval<const T*>()))> &&
+           std::is_void_v<decltype(WriteBinaryStringImpl(
+               std::declval<const T*>(), std::declval<char*>()))> &&
+           std::is_void_v<decltype(ReadBinaryStringImpl(
+               std::declval<const char*>(), std::declval<T&>()))>>>
+    : std::true_type {};
+
+// `kHasPackedBinaryString<T>` is `true` if the binary string of `T` can be
+// written to and read from a caller-provided buffer of
+// `BinaryStringWidth<T>()` characters, i.e., unless `T` customizes the
+// `std::string` based `ToBinaryStringImpl` or `FromBinaryStringImpl`.
+template <typename T>
+inline constexpr bool kHasPackedBinaryString =
+    !HasToBinaryString<T>::value && !HasFromBinaryString<T>::value;
+
+// Returns the number of characters in the binary string of `T`, which is
+// `sizeof(T) * CHAR_BIT` unless `BinaryStringWidthImpl<T>` is defined.
+template <typename T>
+constexpr size_t BinaryStringWidth() {
+  if constexpr (HasPackedBinaryStringImpl<T>::value) {
+    return BinaryStringWidthImpl(static_cast<const T*>(nullptr));
+  } else {
+    return sizeof(T) * CHAR_BIT;
+  }
+}
+
 // `ToBinaryStringImpl<T>` is used if it is defined.
 template <typename T,
           typename std::enable_if_t<HasToBinaryString<T>::value, int> = 0>
@@ -57,23 +100,35 @@ std::string ToBinaryString(const T& val) {
   return ToBinaryStringImpl(&val);
 }
 
-// Default implementation of if `ToBinaryStringImpl<T>` is not defined.
-template <typename T,
-          typename std::enable_if_t<!HasToBinaryString<T>::value, int> = 0>
-std::string ToBinaryString(const T& val) {
-  std::array<char, sizeof(val)> bytes;
+// Writes the binary string of `val` to `str`, which must have room for
+// `BinaryStringWidth<T>()` characters. Unlike `ToBinaryString`, this does not
+// allocate. `WriteBinaryStringImpl<T>` is used if it is defined; otherwise,
+// the bytes of `val` are written MSB first.
+template <typename T>
+void WriteBinaryString(const T& val, char* str) {
+  static_assert(kHasPackedBinaryString<T>);
+  if constexpr (HasPackedBinaryStringImpl<T>::value) {
+    WriteBinaryStringImpl(&val, str);
+    return;
+  }
+  std::array<unsigned char, sizeof(val)> bytes;
   memcpy(bytes.data(), &val, sizeof(val));
   if (internal::IsLittleEndian()) {
     std::reverse(bytes.begin(), bytes.end());
   }
-
-  const int expected_size = sizeof(val) * CHAR_BIT;
-  std::string str;
-  str.reserve(expected_size);
-  for (std::bitset<CHAR_BIT> bits : bytes) {
-    str += bits.to_string();
+  for (unsigned char byte : bytes) {
+    for (int i = CHAR_BIT - 1; i >= 0; --i) {
+      *str++ = (byte >> i) & 1 ? '1' : '0';
+    }
   }
-  CHECK_EQ(str.size(), expected_size) << str;
+}
+
+// Default implementation of if `ToBinaryStringImpl<T>` is not defined.
+template <typename T,
+          typename std::enable_if_t<!HasToBinaryString<T>::value, int> = 0>
+std::string ToBinaryString(const T& val) {
+  std::string str(BinaryStringWidth<T>(), '\0');
+  WriteBinaryString(val, str.data());
   return str;
 }
 
@@ -86,22 +141,35 @@ T FromBinaryString(std::string_view str) {
   return val;
 }
 
-// Default implementation of if `FromBinaryStringImpl<T>` is not defined.
-template <typename T,
-          typename std::enable_if_t<!HasFromBinaryString<T>::value, int> = 0>
-T FromBinaryString(std::string_view str) {
-  T val;
+// Reads `val` from the `BinaryStringWidth<T>()` characters of the binary string
+// at `str`. Unlike `FromBinaryString`, this does not allocate.
+// `ReadBinaryStringImpl<T>` is used if it is defined.
+template <typename T>
+void ReadBinaryString(const char* str, T& val) {
+  static_assert(kHasPackedBinaryString<T>);
+  if constexpr (HasPackedBinaryStringImpl<T>::value) {
+    ReadBinaryStringImpl(str, val);
+    return;
+  }
   std::array<char, sizeof(val)> bytes;
-  CHECK_EQ(str.size(), bytes.size() * CHAR_BIT) << str;
   for (char& byte : bytes) {
-    std::bitset<CHAR_BIT> bits(str.data(), CHAR_BIT);
-    str.remove_prefix(CHAR_BIT);
+    std::bitset<CHAR_BIT> bits(str, CHAR_BIT);
+    str += CHAR_BIT;
     byte = bits.to_ulong();
   }
   if (internal::IsLittleEndian()) {
     std::reverse(bytes.begin(), bytes.end());
   }
   memcpy(&val, bytes.data(), sizeof(val));
+}
+
+// Default implementation of if `FromBinaryStringImpl<T>` is not defined.
+template <typename T,
+          typename std::enable_if_t<!HasFromBinaryString<T>::value, int> = 0>
+T FromBinaryString(std::string_view str) {
+  T val;
+  CHECK_EQ(str.size(), BinaryStringWidth<T>()) << str;
+  ReadBinaryString(str.data(), val);
   return val;
 }
 
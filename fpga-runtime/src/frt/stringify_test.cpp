@@ -4,7 +4,10 @@
 
 #include "frt/stringify.h"
 
+#include <cstdint>
+
 #include <exception>
+#include <type_traits>
 
 #include <gtest/gtest.h>
 
@@ -25,6 +28,35 @@ void FromBinaryStringImpl(std::string_view str, Struct& val) {
   val.bar = fpga::FromBinaryString<float>(str.substr(1));
 }
 
+// Packed customization writes 4 bits per nibble without allocation.
+struct Nibble {
+  unsigned char val;
+};
+
+constexpr size_t BinaryStringWidthImpl(const Nibble*) { return 4; }
+void WriteBinaryStringImpl(const Nibble* val, char* str) {
+  for (int i = 3; i >= 0; --i) {
+    *str++ = (val->val >> i) & 1 ? '1' : '0';
+  }
+}
+void ReadBinaryStringImpl(const char* str, Nibble& val) {
+  val.val = 0;
+  for (int i = 0; i < 4; ++i) {
+    val.val = val.val << 1 | (str[i] == '1');
+  }
+}
+
+// Not trivially copyable, like `ap_uint`, but using the default binary string.
+struct Word {
+  Word() = default;
+  Word(const Word& other) : val(other.val) {}
+  Word& operator=(const Word& other) {
+    val = other.val;
+    return *this;
+  }
+  uint16_t val = 0;
+};
+
 }  // namespace custom
 
 namespace {
@@ -55,12 +87,46 @@ TEST(StringifyTest, FloatFromBinaryString) {
       std::exception);
 }
 
+TEST(StringifyTest, FloatWriteAndReadBinaryString) {
+  char str[32];
+  fpga::WriteBinaryString(1.f, str);
+  EXPECT_EQ(std::string(str, sizeof(str)), "00111111100000000000000000000000");
+
+  float val = 0.f;
+  fpga::ReadBinaryString(str, val);
+  EXPECT_EQ(val, 1.f);
+}
+
 TEST(StringifyTest, CustomStructToBinaryString) {
   static_assert(fpga::HasToBinaryString<custom::Struct>::value);
+  static_assert(!fpga::kHasPackedBinaryString<custom::Struct>);
   const custom::Struct val = {.foo = true, .bar = 1.f};
   EXPECT_EQ(fpga::ToBinaryString(val), "100111111100000000000000000000000");
 }
 
+TEST(StringifyTest, CustomPackedToAndFromBinaryString) {
+  static_assert(fpga::HasPackedBinaryStringImpl<custom::Nibble>::value);
+  static_assert(fpga::kHasPackedBinaryString<custom::Nibble>);
+  static_assert(fpga::BinaryStringWidth<custom::Nibble>() == 4);
+  EXPECT_EQ(fpga::ToBinaryString(custom::Nibble{.val = 5}), "0101");
+  EXPECT_EQ(fpga::FromBinaryString<custom::Nibble>("1010").val, 10);
+  EXPECT_DEATH(fpga::FromBinaryString<custom::Nibble>("10100"), "size()");
+}
+
+TEST(StringifyTest, NonTriviallyCopyableWriteAndReadBinaryString) {
+  static_assert(!std::is_trivially_copyable_v<custom::Word>);
+  static_assert(fpga::kHasPackedBinaryString<custom::Word>);
+  custom::Word word;
+  word.val = 0x1234;
+  char str[16];
+  fpga::WriteBinaryString(word, str);
+  EXPECT_EQ(std::string(str, sizeof(str)), "0001001000110100");
+
+  custom::Word val;
+  fpga::ReadBinaryString(str, val);
+  EXPECT_EQ(val.val, 0x1234);
+}
+
 TEST(StringifyTest, CustomStructFromBinaryString) {
   static_assert(fpga::HasFromBinaryString<custom::Struct>::value);
   const custom::Struct val = fpga::FromBinaryString<custom::Struct>(
@@ -65,6 +65,8 @@ extern "C" {
 #include <Windows.h>
 #include <io.h>
 #else
+#include <spawn.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #endif
@@ -73,6 +75,20 @@ extern "C" {
 #include <sys/types.h>
 }
 
+// File actions of `posix_spawn` that are glibc extensions.
+#if defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 29)
+#define SUBPROCESS_HAS_SPAWN_CHDIR 1
+#endif
+#if __GLIBC_PREREQ(2, 34)
+#define SUBPROCESS_HAS_SPAWN_CLOSEFROM 1
+#endif
+#endif
+
+#ifndef _MSC_VER
+extern char** environ;
+#endif
+
 /*!
  * Getting started with reading this source code.
  * The source is mainly divided into four parts:
@@ -350,6 +366,34 @@ static inline std::pair<int, int> pipe_cloexec() noexcept(false) {
 
   return std::make_pair(pipe_fds[0], pipe_fds[1]);
 }
+
+/*!
+ * Function: find_in_path
+ * Finds an executable like `execvp` does.
+ * Parameters:
+ * [in] name : Name of the executable.
+ * [in] path : Colon-separated directories to search, e.g., $PATH.
+ * [out] string : Path of the first executable named `name` in `path`, or
+ *                `name` itself if it has a slash or is not found.
+ */
+static inline std::string find_in_path(const std::string& name,
+                                       const std::string& path) {
+  if (name.empty() || name.find('/') != std::string::npos) return name;
+  for (size_t begin = 0; begin <= path.size();) {
+    size_t end = path.find(':', begin);
+    if (end == std::string::npos) end = path.size();
+    // An empty entry means the current directory.
+    std::string dir = path.substr(begin, end - begin);
+    std::string file = (dir.empty() ? "." : dir) + "/" + name;
+    struct stat st;
+    if (stat(file.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+        access(file.c_str(), X_OK) == 0) {
+      return file;
+    }
+    begin = end + 1;
+  }
+  return name;
+}
 #endif
 
 /*!
@@ -1137,6 +1181,14 @@ class Popen {
   void init_args();
   void populate_c_argv();
   void execute_process() noexcept(false);
+#ifndef _MSC_VER
+  // Whether the child can be started by `spawn_process`, i.e., it needs no
+  // setup that `posix_spawn` cannot do.
+  bool can_spawn() const;
+  // Starts the child with `posix_spawn`, which does not copy the page tables
+  // of this process as `fork` does, so its cost does not grow with the heap.
+  void spawn_process() noexcept(false);
+#endif
 
  private:
   detail::Streams stream_;
@@ -1368,9 +1420,6 @@ inline void Popen::execute_process() noexcept(false) {
 
 #else
 
-  int err_rd_pipe, err_wr_pipe;
-  std::tie(err_rd_pipe, err_wr_pipe) = util::pipe_cloexec();
-
   if (shell_) {
     auto new_cmd = util::join(vargs_);
     vargs_.clear();
@@ -1385,6 +1434,14 @@ inline void Popen::execute_process() noexcept(false) {
   }
   exe_name_ = vargs_[0];
 
+  if (can_spawn()) {
+    spawn_process();
+    return;
+  }
+
+  int err_rd_pipe, err_wr_pipe;
+  std::tie(err_rd_pipe, err_wr_pipe) = util::pipe_cloexec();
+
   child_pid_ = fork();
 
   if (child_pid_ < 0) {
@@ -1436,6 +1493,118 @@ inline void Popen::execute_process() noexcept(false) {
 #endif
 }
 
+#ifndef _MSC_VER
+inline bool Popen::can_spawn() const {
+  if (has_preexec_fn_) return false;
+  // The standard streams of the child are set up in order, so none may be
+  // replaced before it is duplicated.
+  if (stream_.write_to_parent_ == 0 || stream_.err_write_ == 0 ||
+      stream_.err_write_ == 1) {
+    return false;
+  }
+#ifndef SUBPROCESS_HAS_SPAWN_CHDIR
+  if (cwd_.length()) return false;
+#endif
+#ifndef SUBPROCESS_HAS_SPAWN_CLOSEFROM
+  if (close_fds_) return false;
+#endif
+#ifndef POSIX_SPAWN_SETSID
+  if (session_leader_) return false;
+#endif
+  return true;
+}
+
+inline void Popen::spawn_process() noexcept(false) {
+  posix_spawn_file_actions_t actions;
+  posix_spawnattr_t attr;
+  int ret = posix_spawn_file_actions_init(&actions);
+  if (ret != 0) throw OSError("posix_spawn_file_actions_init failed", ret);
+  ret = posix_spawnattr_init(&attr);
+  if (ret != 0) {
+    posix_spawn_file_actions_destroy(&actions);
+    throw OSError("posix_spawnattr_init failed", ret);
+  }
+
+  // Same as `Child::execute_child`: makes the child owned descriptors the
+  // standard streams of the child, and closes them. Parent owned descriptors
+  // are pipes closed on exec.
+  std::vector<int> child_fds;
+  for (auto [fd, to_fd] : {std::make_pair(stream_.read_from_parent_, 0),
+                           std::make_pair(stream_.write_to_parent_, 1),
+                           std::make_pair(stream_.err_write_, 2)}) {
+    if (ret == 0 && fd != -1 && fd != to_fd) {
+      ret = posix_spawn_file_actions_adddup2(&actions, fd, to_fd);
+    }
+    if (fd > 2 &&
+        std::find(child_fds.begin(), child_fds.end(), fd) == child_fds.end()) {
+      child_fds.push_back(fd);
+    }
+  }
+  for (int fd : child_fds) {
+    if (ret == 0) ret = posix_spawn_file_actions_addclose(&actions, fd);
+  }
+#ifdef SUBPROCESS_HAS_SPAWN_CLOSEFROM
+  if (ret == 0 && close_fds_) {
+    ret = posix_spawn_file_actions_addclosefrom_np(&actions, 3);
+  }
+#endif
+#ifdef SUBPROCESS_HAS_SPAWN_CHDIR
+  if (ret == 0 && cwd_.length()) {
+    ret = posix_spawn_file_actions_addchdir_np(&actions, cwd_.c_str());
+  }
+#endif
+#ifdef POSIX_SPAWN_SETSID
+  if (ret == 0 && session_leader_) {
+    ret = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+  }
+#endif
+
+  // The environment of this process, with `env_` taking precedence.
+  std::vector<std::string> env_strings;
+  std::vector<char*> envp;
+  for (char** env = environ; *env != nullptr; ++env) {
+    const char* eq = strchr(*env, '=');
+    if (eq == nullptr || env_.count(std::string(*env, eq - *env)) == 0) {
+      envp.push_back(*env);
+    }
+  }
+  env_strings.reserve(env_.size());
+  for (const auto& kv : env_) {
+    env_strings.push_back(kv.first + "=" + kv.second);
+    envp.push_back(&env_strings.back()[0]);
+  }
+  envp.push_back(nullptr);
+
+  // The executable is searched in the `PATH` of the child, as `execvp` in the
+  // child would do.
+  std::string path;
+  if (auto it = env_.find("PATH"); it != env_.end()) {
+    path = it->second;
+  } else if (const char* value = getenv("PATH")) {
+    path = value;
+  } else {
+    path = "/bin:/usr/bin";
+  }
+  const std::string exe_path = util::find_in_path(exe_name_, path);
+
+  pid_t pid = -1;
+  if (ret == 0) {
+    ret = posix_spawn(&pid, exe_path.c_str(), &actions, &attr, cargv_.data(),
+                      envp.data());
+  }
+  posix_spawnattr_destroy(&attr);
+  posix_spawn_file_actions_destroy(&actions);
+
+  stream_.close_child_fds();
+  if (ret != 0) {
+    stream_.cleanup_fds();
+    throw CalledProcessError(OSError("execve failed", ret).what());
+  }
+  child_pid_ = pid;
+  child_created_ = true;
+}
+#endif
+
 namespace detail {
 
 inline void ArgumentDeducer::set_option(executable&& exe) {
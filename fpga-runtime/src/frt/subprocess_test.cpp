@@ -0,0 +1,60 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/subprocess.h"
+
+#include <string>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+using Environ = std::unordered_map<std::string, std::string>;
+
+std::string ToString(const subprocess::Buffer& buf) {
+  return std::string(buf.buf.data(), buf.length);
+}
+
+TEST(SubprocessTest, CapturesOutput) {
+  EXPECT_EQ(ToString(subprocess::check_output({"echo", "hello"})), "hello\n");
+}
+
+TEST(SubprocessTest, OverridesEnvironment) {
+  EXPECT_EQ(ToString(subprocess::check_output(
+                {"sh", "-c", "echo \"$FRT_SUBPROCESS_TEST\""},
+                subprocess::environment(Environ{{"FRT_SUBPROCESS_TEST", "value"}}))),
+            "value\n");
+}
+
+TEST(SubprocessTest, SearchesPathOfChild) {
+  EXPECT_THROW(subprocess::check_output(
+                   {"echo", "hello"},
+                   subprocess::environment(Environ{{"PATH", "/nonexistent"}})),
+               subprocess::CalledProcessError);
+}
+
+TEST(SubprocessTest, ChangesWorkingDirectory) {
+  EXPECT_EQ(ToString(subprocess::check_output({"pwd"}, subprocess::cwd{"/"})),
+            "/\n");
+}
+
+TEST(SubprocessTest, CommunicatesThroughPipes) {
+  subprocess::Popen proc({"cat"}, subprocess::input{subprocess::PIPE},
+                         subprocess::output{subprocess::PIPE});
+  auto [out, err] = proc.communicate("data", 4);
+  EXPECT_EQ(ToString(out), "data");
+  EXPECT_EQ(proc.wait(), 0);
+}
+
+TEST(SubprocessTest, ThrowsIfExecutableIsMissing) {
+  EXPECT_THROW(subprocess::Popen({"/nonexistent/executable"}),
+               subprocess::CalledProcessError);
+}
+
+TEST(SubprocessTest, ReturnsExitCode) {
+  EXPECT_EQ(subprocess::call({"sh", "-c", "exit 3"}), 3);
+}
+
+}  // namespace
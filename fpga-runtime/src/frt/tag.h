@@ -13,6 +13,18 @@ enum class Tag {
   kReadOnly = 1,
   kWriteOnly = 2,
   kReadWrite = 3,
+  // Allocated on the device and never transferred; for data that only the
+  // kernel uses, e.g., intermediate results.
+  kScratch = 4,
+  // Written to the device only when bound to an argument; later invocations
+  // that pass the same host memory reuse the device copy.
+  kInitOnce = 5,
+  // Same as `kInitOnce`, and read back only when the instance finishes, i.e.,
+  // after the final invocation.
+  kReadBackLast = 6,
+  // Stays in host memory, which the kernel accesses directly over PCIe; never
+  // transferred. Only supported on Xilinx platforms with host memory access.
+  kHostOnly = 7,
 };
 
 }  // namespace internal
@@ -0,0 +1,189 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/trace.h"
+
+#include <unistd.h>
+
+#include <cstdlib>
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <glog/logging.h>
+#include <nlohmann/json.hpp>
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+std::unique_ptr<Trace> NewTrace() {
+  const char* path = getenv("TAPA_TRACE");
+  if (path == nullptr || *path == '\0') return nullptr;
+  return std::make_unique<Trace>(path);
+}
+
+void WriteString(std::ostream& os, const std::string& str) {
+  os << nlohmann::json(str).dump(-1, ' ', /*ensure_ascii=*/false,
+                                 nlohmann::json::error_handler_t::replace);
+}
+
+// Writes `ns` in microseconds, the time unit of the trace event format.
+void WriteMicroseconds(std::ostream& os, int64_t ns) {
+  if (ns < 0) {
+    os << '-';
+    ns = -ns;
+  }
+  const int64_t fraction = ns % 1000;
+  os << ns / 1000 << '.' << fraction / 100 << fraction / 10 % 10
+     << fraction % 10;
+}
+
+}  // namespace
+
+Trace* Trace::Get() {
+  // Destroyed, and thus written, when the process exits.
+  static const std::unique_ptr<Trace> trace = NewTrace();
+  return trace.get();
+}
+
+int64_t Trace::NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+Trace::Trace(std::string path)
+    : path_(std::move(path)), start_ns_(NowNs()), pid_(getpid()) {}
+
+Trace::~Trace() {
+  if (path_.empty() || getpid() != pid_) return;
+  std::ofstream ofs(path_);
+  Write(ofs);
+  if (ofs.fail()) {
+    LOG(ERROR) << "failed to write trace to '" << path_ << "'";
+  } else {
+    LOG(INFO) << "trace is written to '" << path_ << "'";
+  }
+}
+
+int Trace::AddTrack(std::string_view group, std::string_view name) {
+  std::unique_lock lock(mtx_);
+  tracks_.push_back({GetGroup(group), Intern(name)});
+  return tracks_.size() - 1;
+}
+
+void Trace::AddSpan(int track, std::string_view name, int64_t begin_ns,
+                    int64_t end_ns, std::string_view detail) {
+  std::unique_lock lock(mtx_);
+  if (!Reserve()) return;
+  events_.push_back({
+      .phase = 'X',
+      .group = tracks_.at(track).group,
+      .track = track,
+      .name = Intern(name),
+      .detail = detail.empty() ? -1 : Intern(detail),
+      .time_ns = begin_ns,
+      .duration_ns = end_ns - begin_ns,
+      .value = 0,
+  });
+}
+
+void Trace::AddCounter(std::string_view group, std::string_view name,
+                       int64_t time_ns, double value) {
+  std::unique_lock lock(mtx_);
+  if (!Reserve()) return;
+  events_.push_back({
+      .phase = 'C',
+      .group = GetGroup(group),
+      .track = -1,
+      .name = Intern(name),
+      .detail = -1,
+      .time_ns = time_ns,
+      .duration_ns = 0,
+      .value = value,
+  });
+}
+
+void Trace::Write(std::ostream& os) const {
+  std::unique_lock lock(mtx_);
+  os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  const char* sep = "\n";
+  auto next = [&]() -> std::ostream& {
+    os << sep;
+    sep = ",\n";
+    return os;
+  };
+
+  // Groups are shown as processes and tracks as threads.
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    next() << R"({"ph": "M", "name": "process_name", "pid": )" << i + 1
+           << R"(, "args": {"name": )";
+    WriteString(os, strings_[groups_[i]]);
+    os << "}}";
+  }
+  for (size_t i = 0; i < tracks_.size(); ++i) {
+    next() << R"({"ph": "M", "name": "thread_name", "pid": )"
+           << tracks_[i].group + 1 << R"(, "tid": )" << i + 1
+           << R"(, "args": {"name": )";
+    WriteString(os, strings_[tracks_[i].name]);
+    os << "}}";
+  }
+
+  for (const auto& event : events_) {
+    next() << R"({"ph": ")" << event.phase << R"(", "name": )";
+    WriteString(os, strings_[event.name]);
+    os << R"(, "pid": )" << event.group + 1 << R"(, "ts": )";
+    WriteMicroseconds(os, event.time_ns - start_ns_);
+    if (event.phase == 'C') {
+      os << R"(, "args": {"value": )" << event.value << "}}";
+      continue;
+    }
+    os << R"(, "tid": )" << event.track + 1 << R"(, "dur": )";
+    WriteMicroseconds(os, event.duration_ns);
+    if (event.detail >= 0) {
+      os << R"(, "args": {"detail": )";
+      WriteString(os, strings_[event.detail]);
+      os << "}";
+    }
+    os << "}";
+  }
+  os << "\n]}\n";
+}
+
+int Trace::Intern(std::string_view str) {
+  auto [it, is_new] = string_ids_.try_emplace(std::string(str), 0);
+  if (is_new) {
+    it->second = strings_.size();
+    strings_.push_back(it->first);
+  }
+  return it->second;
+}
+
+int Trace::GetGroup(std::string_view group) {
+  const int name = Intern(group);
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    if (groups_[i] == name) return i;
+  }
+  groups_.push_back(name);
+  return groups_.size() - 1;
+}
+
+bool Trace::Reserve() {
+  if (events_.size() < kMaxEvents) return true;
+  LOG_IF(WARNING, !dropped_) << "trace has more than " << kMaxEvents
+                             << " events; later events are dropped";
+  dropped_ = true;
+  return false;
+}
+
+}  // namespace internal
+}  // namespace fpga
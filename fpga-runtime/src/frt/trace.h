@@ -0,0 +1,103 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef FPGA_RUNTIME_TRACE_H_
+#define FPGA_RUNTIME_TRACE_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fpga {
+namespace internal {
+
+// Timeline of the process in the Chrome trace event format, which
+// https://ui.perfetto.dev and chrome://tracing load. Enabled by setting
+// `TAPA_TRACE` to the path of the trace, which is written when the process
+// exits. Software simulation, TAPA fast cosim, and OpenCL devices record
+// into the same trace, so that their activities show up in one timeline.
+class Trace {
+ public:
+  // Returns the trace of this process, or `nullptr` unless tracing is enabled.
+  static Trace* Get();
+
+  // Returns the current time in nanoseconds on the steady clock, which all
+  // timestamps of the trace are on.
+  static int64_t NowNs();
+
+  // Events beyond this many are dropped to bound memory usage.
+  static constexpr size_t kMaxEvents = size_t{1} << 22;
+
+  explicit Trace(std::string path);
+  ~Trace();
+
+  // Not copyable or movable.
+  Trace(const Trace&) = delete;
+  Trace& operator=(const Trace&) = delete;
+
+  // Returns a new track named `name`, shown in the group named `group`.
+  int AddTrack(std::string_view group, std::string_view name);
+
+  // Records a span named `name` on `track` from `begin_ns` until `end_ns`.
+  // `detail`, if not empty, is shown when the span is selected.
+  void AddSpan(int track, std::string_view name, int64_t begin_ns,
+               int64_t end_ns, std::string_view detail = {});
+
+  // Records that counter `name` in the group named `group` is `value` from
+  // `time_ns` on.
+  void AddCounter(std::string_view group, std::string_view name,
+                  int64_t time_ns, double value);
+
+  // Writes the trace as JSON.
+  void Write(std::ostream& os) const;
+
+ private:
+  struct Event {
+    char phase;  // 'X' for spans and 'C' for counters.
+    int group;
+    int track;  // Unused by counters.
+    int name;
+    int detail;  // -1 if none; unused by counters.
+    int64_t time_ns;
+    int64_t duration_ns;  // Unused by counters.
+    double value;         // Unused by spans.
+  };
+  struct Track {
+    int group;
+    int name;
+  };
+
+  // Returns the index of `str` in `strings_`. Requires holding `mtx_`.
+  int Intern(std::string_view str);
+
+  // Returns the index of `group` in `groups_`. Requires holding `mtx_`.
+  int GetGroup(std::string_view group);
+
+  // Returns whether another event can be recorded. Requires holding `mtx_`.
+  bool Reserve();
+
+  const std::string path_;
+  const int64_t start_ns_;
+  const pid_t pid_;  // Forked children do not write the trace.
+
+  mutable std::mutex mtx_;
+  std::vector<std::string> strings_;
+  std::unordered_map<std::string, int> string_ids_;
+  std::vector<int> groups_;  // Names of groups.
+  std::vector<Track> tracks_;
+  std::vector<Event> events_;
+  bool dropped_ = false;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_TRACE_H_
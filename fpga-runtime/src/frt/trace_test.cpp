@@ -0,0 +1,74 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/trace.h"
+
+#include <cstdint>
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace fpga {
+namespace internal {
+namespace {
+
+std::string Write(const Trace& trace) {
+  std::ostringstream os;
+  trace.Write(os);
+  return os.str();
+}
+
+bool Contains(const std::string& str, const std::string& substr) {
+  return str.find(substr) != std::string::npos;
+}
+
+TEST(TraceTest, WritesTracksAsThreadsOfGroups) {
+  Trace trace(/*path=*/"");
+  trace.AddTrack("tasks", "Add/0");
+  trace.AddTrack("device", "load a");
+
+  const std::string json = Write(trace);
+  EXPECT_TRUE(Contains(json, R"({"ph": "M", "name": "process_name", )"
+                             R"("pid": 2, "args": {"name": "device"}})"));
+  EXPECT_TRUE(Contains(json, R"({"ph": "M", "name": "thread_name", )"
+                             R"("pid": 1, "tid": 1, )"
+                             R"("args": {"name": "Add/0"}})"));
+}
+
+TEST(TraceTest, WritesSpansInMicroseconds) {
+  Trace trace(/*path=*/"");
+  const int track = trace.AddTrack("tasks", "Add/0");
+  const int64_t now = Trace::NowNs();
+  trace.AddSpan(track, "run until empty", now, now + 1500, "channel 'q'");
+  trace.AddSpan(track, "run until done", now, now + 2000000);
+
+  const std::string json = Write(trace);
+  EXPECT_TRUE(Contains(json, R"("dur": 1.500, "args": )"
+                             R"({"detail": "channel 'q'"}})"));
+  EXPECT_TRUE(Contains(json, R"("dur": 2000.000})"));
+}
+
+TEST(TraceTest, WritesCounters) {
+  Trace trace(/*path=*/"");
+  trace.AddCounter("ports", "a read beats", Trace::NowNs(), 42);
+
+  const std::string json = Write(trace);
+  EXPECT_TRUE(Contains(json, R"({"ph": "C", "name": "a read beats", )"));
+  EXPECT_TRUE(Contains(json, R"("args": {"value": 42}})"));
+}
+
+TEST(TraceTest, EscapesNames) {
+  Trace trace(/*path=*/"");
+  trace.AddTrack("tasks", "say \"hi\"");
+
+  const std::string json = Write(trace);
+  EXPECT_TRUE(Contains(json, R"("say \"hi\"")"));
+  EXPECT_FALSE(Contains(json, R"("say "hi"")"));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace fpga
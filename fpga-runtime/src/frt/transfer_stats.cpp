@@ -0,0 +1,38 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/transfer_stats.h"
+
+#include <ostream>
+
+namespace fpga {
+
+namespace {
+
+double ThroughputGbps(size_t bytes, int64_t time_ns) {
+  if (time_ns <= 0) return 0;
+  return static_cast<double>(bytes) / static_cast<double>(time_ns);
+}
+
+}  // namespace
+
+double TransferStats::LoadThroughputGbps() const {
+  return ThroughputGbps(load_bytes, load_time_ns);
+}
+
+double TransferStats::StoreThroughputGbps() const {
+  return ThroughputGbps(store_bytes, store_time_ns);
+}
+
+std::ostream& operator<<(std::ostream& os, const TransferStats& stats) {
+  os << "TransferStats: {arg: " << stats.arg.index << " '" << stats.arg.name
+     << "', load: " << stats.load_bytes << " bytes in " << stats.load_time_ns
+     << " ns (" << stats.LoadThroughputGbps()
+     << " GB/s), store: " << stats.store_bytes << " bytes in "
+     << stats.store_time_ns << " ns (" << stats.StoreThroughputGbps()
+     << " GB/s)}";
+  return os;
+}
+
+}  // namespace fpga
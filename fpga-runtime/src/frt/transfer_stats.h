@@ -0,0 +1,37 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef FPGA_RUNTIME_TRANSFER_STATS_H_
+#define FPGA_RUNTIME_TRANSFER_STATS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <ostream>
+
+#include "frt/arg_info.h"
+
+namespace fpga {
+
+// Host-device transfer statistics of a buffer argument in the last
+// invocation.
+struct TransferStats {
+  ArgInfo arg;
+  size_t load_bytes = 0;
+  int64_t load_time_ns = 0;
+  size_t store_bytes = 0;
+  int64_t store_time_ns = 0;
+
+  // Returns the load throughput in GB/s, or 0 if nothing was loaded.
+  double LoadThroughputGbps() const;
+
+  // Returns the store throughput in GB/s, or 0 if nothing was stored.
+  double StoreThroughputGbps() const;
+};
+
+std::ostream& operator<<(std::ostream& os, const TransferStats& stats);
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_TRANSFER_STATS_H_
@@ -0,0 +1,205 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/zip_reader.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+// Only the raw deflate decompressor and CRC-32 of miniz are used.
+#include "frt/zip_file.h"
+
+namespace fpga::internal {
+
+namespace {
+
+constexpr uint32_t kLocalHeaderSignature = 0x04034b50;
+constexpr uint32_t kCentralHeaderSignature = 0x02014b50;
+constexpr uint32_t kEndOfCentralDirSignature = 0x06054b50;
+constexpr uint32_t kZip64EndOfCentralDirSignature = 0x06064b50;
+constexpr uint32_t kZip64LocatorSignature = 0x07064b50;
+constexpr uint16_t kZip64ExtraFieldId = 0x0001;
+
+constexpr size_t kLocalHeaderSize = 30;
+constexpr size_t kCentralHeaderSize = 46;
+constexpr size_t kEndOfCentralDirSize = 22;
+constexpr size_t kZip64EndOfCentralDirSize = 56;
+constexpr size_t kZip64LocatorSize = 20;
+constexpr size_t kMaxCommentSize = 0xffff;
+
+constexpr uint16_t kMethodStored = 0;
+constexpr uint16_t kMethodDeflated = 8;
+
+uint16_t Load16(const uint8_t* p) { return p[0] | p[1] << 8; }
+
+uint32_t Load32(const uint8_t* p) {
+  return uint32_t{Load16(p)} | uint32_t{Load16(p + 2)} << 16;
+}
+
+uint64_t Load64(const uint8_t* p) {
+  return uint64_t{Load32(p)} | uint64_t{Load32(p + 4)} << 32;
+}
+
+}  // namespace
+
+ZipReader::ZipReader(const std::string& path) : path_(path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  PLOG_IF(FATAL, fd < 0) << "Cannot open " << path;
+  struct stat st;
+  PLOG_IF(FATAL, fstat(fd, &st) != 0) << "Cannot stat " << path;
+  size_ = st.st_size;
+  if (size_ > 0) {
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd,
+                      /*offset=*/0);
+    PLOG_IF(FATAL, addr == MAP_FAILED) << "Cannot map " << path;
+    data_ = static_cast<const uint8_t*>(addr);
+  }
+  close(fd);
+  ParseCentralDirectory();
+}
+
+ZipReader::~ZipReader() {
+  if (data_ != nullptr) {
+    PLOG_IF(ERROR, munmap(const_cast<uint8_t*>(data_), size_) != 0)
+        << "munmap";
+  }
+}
+
+const ZipReader::Entry* ZipReader::FindBySuffix(std::string_view suffix) const {
+  for (const Entry& entry : entries_) {
+    if (entry.name.size() >= suffix.size() &&
+        std::equal(suffix.rbegin(), suffix.rend(), entry.name.rbegin())) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+std::string ZipReader::Read(const Entry& entry) const {
+  const uint8_t* header = At(entry.local_header_offset, kLocalHeaderSize);
+  LOG_IF(FATAL, Load32(header) != kLocalHeaderSignature)
+      << "Invalid local header of '" << entry.name << "' in " << path_;
+  const uint64_t data_offset = entry.local_header_offset + kLocalHeaderSize +
+                               Load16(header + 26) + Load16(header + 28);
+  const uint8_t* data = At(data_offset, entry.compressed_size);
+
+  std::string content(entry.size, '\0');
+  switch (entry.method) {
+    case kMethodStored:
+      LOG_IF(FATAL, entry.compressed_size != entry.size)
+          << "Inconsistent sizes of '" << entry.name << "' in " << path_;
+      std::memcpy(content.data(), data, entry.size);
+      break;
+    case kMethodDeflated:
+      LOG_IF(FATAL, tinfl_decompress_mem_to_mem(
+                        content.data(), content.size(), data,
+                        entry.compressed_size, /*flags=*/0) != entry.size)
+          << "Cannot inflate '" << entry.name << "' in " << path_;
+      break;
+    default:
+      LOG(FATAL) << "Unsupported compression method " << entry.method
+                 << " of '" << entry.name << "' in " << path_;
+  }
+
+  LOG_IF(FATAL, mz_crc32(
+                    MZ_CRC32_INIT,
+                    reinterpret_cast<const unsigned char*>(content.data()),
+                    content.size()) != entry.checksum)
+      << "CRC mismatch of '" << entry.name << "' in " << path_;
+  return content;
+}
+
+const uint8_t* ZipReader::At(uint64_t offset, uint64_t size) const {
+  LOG_IF(FATAL, offset > size_ || size > size_ - offset)
+      << "Truncated zip file " << path_;
+  return data_ + offset;
+}
+
+void ZipReader::ParseCentralDirectory() {
+  // The end of central directory record is at the end of the file, followed
+  // by a comment of up to 64 KiB; scan backward for its signature.
+  LOG_IF(FATAL, size_ < kEndOfCentralDirSize) << "Not a zip file: " << path_;
+  uint64_t eocd_offset = size_ - kEndOfCentralDirSize;
+  const uint64_t min_offset =
+      eocd_offset > kMaxCommentSize ? eocd_offset - kMaxCommentSize : 0;
+  while (Load32(data_ + eocd_offset) != kEndOfCentralDirSignature) {
+    LOG_IF(FATAL, eocd_offset == min_offset) << "Not a zip file: " << path_;
+    --eocd_offset;
+  }
+  const uint8_t* eocd = data_ + eocd_offset;
+  uint64_t entry_count = Load16(eocd + 10);
+  uint64_t cd_offset = Load32(eocd + 16);
+
+  // Zip64 archives store the real values in the zip64 end of central
+  // directory record, located by the record right before the regular one.
+  if (entry_count == 0xffff || cd_offset == 0xffffffff) {
+    LOG_IF(FATAL, eocd_offset < kZip64LocatorSize)
+        << "Missing zip64 locator in " << path_;
+    const uint8_t* locator = At(eocd_offset - kZip64LocatorSize,
+                                kZip64LocatorSize);
+    LOG_IF(FATAL, Load32(locator) != kZip64LocatorSignature)
+        << "Missing zip64 locator in " << path_;
+    const uint8_t* eocd64 = At(Load64(locator + 8), kZip64EndOfCentralDirSize);
+    LOG_IF(FATAL, Load32(eocd64) != kZip64EndOfCentralDirSignature)
+        << "Invalid zip64 end of central directory in " << path_;
+    entry_count = Load64(eocd64 + 32);
+    cd_offset = Load64(eocd64 + 48);
+  }
+
+  entries_.reserve(entry_count);
+  uint64_t offset = cd_offset;
+  for (uint64_t i = 0; i < entry_count; ++i) {
+    const uint8_t* header = At(offset, kCentralHeaderSize);
+    LOG_IF(FATAL, Load32(header) != kCentralHeaderSignature)
+        << "Invalid central directory header in " << path_;
+    const uint16_t name_size = Load16(header + 28);
+    const uint16_t extra_size = Load16(header + 30);
+    const uint16_t comment_size = Load16(header + 32);
+    const uint8_t* name = At(offset + kCentralHeaderSize, name_size);
+
+    Entry& entry = entries_.emplace_back();
+    entry.name.assign(reinterpret_cast<const char*>(name), name_size);
+    entry.method = Load16(header + 10);
+    entry.checksum = Load32(header + 16);
+    entry.compressed_size = Load32(header + 20);
+    entry.size = Load32(header + 24);
+    entry.local_header_offset = Load32(header + 42);
+
+    // The zip64 extra field has the 64-bit value of each field above that
+    // overflowed, in this order.
+    const uint8_t* extra = name + name_size;
+    const uint8_t* extra_end = At(offset + kCentralHeaderSize + name_size,
+                                  extra_size) +
+                               extra_size;
+    while (extra + 4 <= extra_end) {
+      const uint16_t id = Load16(extra);
+      const uint16_t size = Load16(extra + 2);
+      const uint8_t* field = extra + 4;
+      extra = field + size;
+      if (id != kZip64ExtraFieldId || extra > extra_end) continue;
+      for (uint64_t* value :
+           {&entry.size, &entry.compressed_size, &entry.local_header_offset}) {
+        if (*value == 0xffffffff && field + 8 <= extra) {
+          *value = Load64(field);
+          field += 8;
+        }
+      }
+    }
+
+    offset += kCentralHeaderSize + name_size + extra_size + comment_size;
+  }
+}
+
+}  // namespace fpga::internal
@@ -0,0 +1,57 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef FPGA_RUNTIME_ZIP_READER_H_
+#define FPGA_RUNTIME_ZIP_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fpga::internal {
+
+// Read-only access to a zip file that does not load the whole file. The file
+// is memory-mapped; constructing a reader only parses the central directory,
+// and `Read` only touches the pages of the entry it extracts.
+class ZipReader {
+ public:
+  struct Entry {
+    std::string name;
+    uint16_t method;
+    uint32_t checksum;  // CRC-32 of the uncompressed content.
+    uint64_t compressed_size;
+    uint64_t size;
+    uint64_t local_header_offset;
+  };
+
+  explicit ZipReader(const std::string& path);
+  ZipReader(const ZipReader&) = delete;
+  ZipReader& operator=(const ZipReader&) = delete;
+  ~ZipReader();
+
+  const std::vector<Entry>& entries() const { return entries_; }
+
+  // Returns the first entry whose name ends with `suffix`, or nullptr.
+  const Entry* FindBySuffix(std::string_view suffix) const;
+
+  // Returns the uncompressed content of `entry`.
+  std::string Read(const Entry& entry) const;
+
+ private:
+  // Returns `size` bytes at `offset`, dying if they are out of the file.
+  const uint8_t* At(uint64_t offset, uint64_t size) const;
+  void ParseCentralDirectory();
+
+  const std::string path_;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  std::vector<Entry> entries_;
+};
+
+}  // namespace fpga::internal
+
+#endif  // FPGA_RUNTIME_ZIP_READER_H_
@@ -0,0 +1,79 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "frt/zip_reader.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+namespace fpga::internal {
+namespace {
+
+// A zip file with a stored entry `foo/stored.txt` and a deflated entry
+// `foo/kernel.xml`, as created by Python's `zipfile`.
+constexpr char kZip[] =
+    "\x50\x4b\x03\x04\x14\x00\x00\x00\x00\x00\x00\x00\x21\x00\x0b\xf9"
+    "\x43\x56\x06\x00\x00\x00\x06\x00\x00\x00\x0e\x00\x00\x00\x66\x6f"
+    "\x6f\x2f\x73\x74\x6f\x72\x65\x64\x2e\x74\x78\x74\x73\x74\x6f\x72"
+    "\x65\x64\x50\x4b\x03\x04\x14\x00\x00\x00\x08\x00\x00\x00\x21\x00"
+    "\x06\x1b\xfa\xea\x0e\x00\x00\x00\x24\x00\x00\x00\x0e\x00\x00\x00"
+    "\x66\x6f\x6f\x2f\x6b\x65\x72\x6e\x65\x6c\x2e\x78\x6d\x6c\x4b\x49"
+    "\x4d\xcb\x49\x2c\x49\x4d\x51\x48\xc1\xcd\x00\x00\x50\x4b\x01\x02"
+    "\x14\x03\x14\x00\x00\x00\x00\x00\x00\x00\x21\x00\x0b\xf9\x43\x56"
+    "\x06\x00\x00\x00\x06\x00\x00\x00\x0e\x00\x00\x00\x00\x00\x00\x00"
+    "\x00\x00\x00\x00\x80\x01\x00\x00\x00\x00\x66\x6f\x6f\x2f\x73\x74"
+    "\x6f\x72\x65\x64\x2e\x74\x78\x74\x50\x4b\x01\x02\x14\x03\x14\x00"
+    "\x00\x00\x08\x00\x00\x00\x21\x00\x06\x1b\xfa\xea\x0e\x00\x00\x00"
+    "\x24\x00\x00\x00\x0e\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+    "\x80\x01\x32\x00\x00\x00\x66\x6f\x6f\x2f\x6b\x65\x72\x6e\x65\x6c"
+    "\x2e\x78\x6d\x6c\x50\x4b\x05\x06\x00\x00\x00\x00\x02\x00\x02\x00"
+    "\x78\x00\x00\x00\x6c\x00\x00\x00\x00\x00";
+
+class ZipReaderTest : public testing::Test {
+ protected:
+  ZipReaderTest() {
+    int fd = mkstemp(path_.data());
+    std::ofstream(path_, std::ios::binary).write(kZip, sizeof(kZip) - 1);
+    close(fd);
+  }
+  ~ZipReaderTest() override { std::remove(path_.c_str()); }
+
+  std::string path_ = testing::TempDir() + "zip_reader_test.XXXXXX";
+};
+
+TEST_F(ZipReaderTest, ListsEntries) {
+  ZipReader reader(path_);
+  ASSERT_EQ(reader.entries().size(), 2);
+  EXPECT_EQ(reader.entries()[0].name, "foo/stored.txt");
+  EXPECT_EQ(reader.entries()[1].name, "foo/kernel.xml");
+}
+
+TEST_F(ZipReaderTest, ReadsStoredEntry) {
+  ZipReader reader(path_);
+  const ZipReader::Entry* entry = reader.FindBySuffix("/stored.txt");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(reader.Read(*entry), "stored");
+}
+
+TEST_F(ZipReaderTest, ReadsDeflatedEntry) {
+  ZipReader reader(path_);
+  const ZipReader::Entry* entry = reader.FindBySuffix("/kernel.xml");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(reader.Read(*entry), "deflated deflated deflated deflated ");
+}
+
+TEST_F(ZipReaderTest, FindBySuffixReturnsNullForMissingEntry) {
+  ZipReader reader(path_);
+  EXPECT_EQ(reader.FindBySuffix("/missing.xml"), nullptr);
+}
+
+}  // namespace
+}  // namespace fpga::internal
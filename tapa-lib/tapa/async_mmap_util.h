@@ -0,0 +1,382 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+//
+// Synthesizable front-ends of `tapa::async_mmap`. Each function is meant to be
+// the whole body of a leaf task, e.g.,
+//
+//   void Load(tapa::async_mmap<float>& mem, int64_t n,
+//             tapa::ostream<float>& data_out) {
+//     tapa::read_sequential(mem, 0, n, data_out);
+//   }
+
+#ifndef TAPA_ASYNC_MMAP_UTIL_H_
+#define TAPA_ASYNC_MMAP_UTIL_H_
+
+#include <cstdint>
+
+#include "tapa.h"
+
+namespace tapa {
+
+/// Reads elements @c offset to `offset + n - 1` of @c mem to @c data_out.
+///
+/// Addresses are issued back to back, so that they are merged into bursts.
+template <typename T, typename Config>
+inline void read_sequential(async_mmap<T, Config>& mem, int64_t offset,
+                            int64_t n, ostream<T>& data_out) {
+  for (int64_t i_req = 0, i_resp = 0; i_resp < n;) {
+#pragma HLS pipeline II = 1
+    if (i_req < n && mem.read_addr.try_write(offset + i_req)) ++i_req;
+    T data;
+    if (!data_out.full() && mem.read_data.try_read(data)) {
+      data_out.try_write(data);
+      ++i_resp;
+    }
+  }
+}
+
+/// Writes @c n elements from @c data_in to elements @c offset to
+/// `offset + n - 1` of @c mem, and waits until all writes are done.
+///
+/// Addresses are issued back to back, so that they are merged into bursts.
+template <typename T, typename Config>
+inline void write_sequential(async_mmap<T, Config>& mem, int64_t offset,
+                             int64_t n, istream<T>& data_in) {
+  for (int64_t i_req = 0, i_resp = 0; i_resp < n;) {
+#pragma HLS pipeline II = 1
+    T data;
+    if (i_req < n && !mem.write_addr.full() && !mem.write_data.full() &&
+        data_in.try_read(data)) {
+      mem.write_addr.try_write(offset + i_req);
+      mem.write_data.try_write(data);
+      ++i_req;
+    }
+    typename async_mmap<T, Config>::resp_t resp;
+    if (mem.write_resp.try_read(resp)) i_resp += int64_t(resp) + 1;
+  }
+}
+
+/// Reads the element of @c mem at each address from @c addr_in until EoT, and
+/// writes them to @c data_out in order, followed by EoT.
+///
+/// Consecutive requests of the same address are read from @c mem only once,
+/// e.g., requests of neighboring elements packed in the same word. Up to
+/// @c kMaxOutstanding reads are in flight.
+template <int kMaxOutstanding = 64, typename T, typename Config>
+inline void gather(async_mmap<T, Config>& mem, istream<int64_t>& addr_in,
+                   ostream<T>& data_out) {
+  // Number of times the data of each read in flight is written to `data_out`.
+  // The count of the latest read is kept in `run` while later requests of the
+  // same address may still increase it.
+  int repeats[kMaxOutstanding];
+  int64_t head = 0;  // Oldest read whose data are not all written out.
+  int64_t tail = 0;  // Number of reads issued.
+  int64_t last_addr = 0;
+  int run = 0;
+  bool is_open = false;  // Whether `run` counts the latest read.
+  bool is_done = false;  // Whether EoT of `addr_in` is consumed.
+
+  T data;
+  bool has_data = false;
+  int written = 0;
+
+  while (!is_done || head < tail) {
+#pragma HLS pipeline II = 1
+    // Writes out the data of the oldest read.
+    const bool is_latest = head == tail - 1;
+    const int count =
+        is_open && is_latest ? run : repeats[head % kMaxOutstanding];
+    if (!has_data && head < tail && mem.read_data.try_read(data)) {
+      has_data = true;
+      written = 0;
+    } else if (has_data && written < count) {
+      if (data_out.try_write(data)) ++written;
+    } else if (has_data && !(is_open && is_latest)) {
+      has_data = false;
+      ++head;
+    }
+
+    // Issues the next read unless it repeats the latest one.
+    bool is_valid, is_eot;
+    const int64_t addr = addr_in.peek(is_valid, is_eot);
+    if (is_valid && is_eot) {
+      addr_in.try_open();
+      if (is_open) repeats[(tail - 1) % kMaxOutstanding] = run;
+      is_open = false;
+      is_done = true;
+    } else if (is_valid && is_open && addr == last_addr) {
+      addr_in.try_read(last_addr);
+      ++run;
+    } else if (is_valid && tail - head < kMaxOutstanding &&
+               mem.read_addr.try_write(addr)) {
+      addr_in.try_read(last_addr);
+      if (is_open) repeats[(tail - 1) % kMaxOutstanding] = run;
+      ++tail;
+      run = 1;
+      is_open = true;
+    }
+  }
+  data_out.close();
+}
+
+/// Writes each element from @c req_in to its address of @c mem until EoT, and
+/// waits until all writes are done.
+///
+/// Consecutive writes to the same address are combined into the last one,
+/// which is issued once a write to another address or EoT arrives.
+template <typename T, typename Config>
+inline void scatter(async_mmap<T, Config>& mem,
+                    istream<packet<int64_t, T>>& req_in) {
+  packet<int64_t, T> pending;
+  bool has_pending = false;
+  bool is_done = false;  // Whether EoT of `req_in` is consumed.
+  int64_t issued = 0;
+  int64_t acked = 0;
+
+  while (!is_done || acked < issued) {
+#pragma HLS pipeline II = 1
+    bool is_valid, is_eot;
+    const packet<int64_t, T> req = req_in.peek(is_valid, is_eot);
+    const bool is_combined = has_pending && is_valid && !is_eot &&
+                             req.addr == pending.addr;
+    if (has_pending && is_valid && !is_combined && !mem.write_addr.full() &&
+        !mem.write_data.full()) {
+      mem.write_addr.try_write(pending.addr);
+      mem.write_data.try_write(pending.payload);
+      has_pending = false;
+      ++issued;
+    }
+    if (is_valid && is_eot && !has_pending) {
+      req_in.try_open();
+      is_done = true;
+    } else if (is_valid && !is_eot && (is_combined || !has_pending)) {
+      req_in.try_read(pending);
+      has_pending = true;
+    }
+
+    typename async_mmap<T, Config>::resp_t resp;
+    if (mem.write_resp.try_read(resp)) acked += int64_t(resp) + 1;
+  }
+}
+
+/// Forwards elements of @c in to @c out in order until EoT, spilling them to a
+/// ring of @c capacity elements at the beginning of @c mem while @c out is
+/// full, so that the two ends are decoupled by more elements than on-chip
+/// memory holds. The depths of @c in and @c out are the on-chip tail and head
+/// of the queue.
+///
+/// Elements bypass @c mem while none is spilled. Spilled elements are read
+/// back once their writes are done, with up to @c kMaxOutstanding reads in
+/// flight.
+template <int kMaxOutstanding = 64, typename T, typename Config>
+inline void spill(async_mmap<T, Config>& mem, int64_t capacity, istream<T>& in,
+                  ostream<T>& out) {
+  int64_t issued = 0;     // Elements written to `mem`.
+  int64_t acked = 0;      // Elements whose writes are done.
+  int64_t requested = 0;  // Elements whose reads are issued.
+  int64_t received = 0;   // Elements read back and written to `out`.
+  int64_t write_pos = 0;  // Ring positions of the next write and read.
+  int64_t read_pos = 0;
+
+  for (bool is_done = false; !is_done;) {
+#pragma HLS pipeline II = 1
+    bool is_valid, is_eot;
+    const T elem = in.peek(is_valid, is_eot);
+    bool has_data;
+    const T data = mem.read_data.peek(has_data);
+
+    // Writes out the oldest spilled element, or the next input if none is.
+    bool is_taken = false;
+    if (received < issued) {
+      if (has_data && out.try_write(data)) {
+        mem.read_data.read(nullptr);
+        ++received;
+      }
+    } else if (is_valid && !is_eot && out.try_write(elem)) {
+      is_taken = true;
+    }
+
+    // Spills the next input that cannot be written out.
+    if (is_valid && !is_eot && !is_taken && issued - received < capacity &&
+        !mem.write_addr.full() && !mem.write_data.full()) {
+      mem.write_addr.try_write(write_pos);
+      mem.write_data.try_write(elem);
+      write_pos = write_pos + 1 < capacity ? write_pos + 1 : 0;
+      ++issued;
+      is_taken = true;
+    }
+    if (is_taken) in.read(nullptr);
+
+    if (requested < acked && requested - received < kMaxOutstanding &&
+        mem.read_addr.try_write(read_pos)) {
+      read_pos = read_pos + 1 < capacity ? read_pos + 1 : 0;
+      ++requested;
+    }
+
+    typename async_mmap<T, Config>::resp_t resp;
+    if (mem.write_resp.try_read(resp)) acked += int64_t(resp) + 1;
+
+    if (is_valid && is_eot && received == issued) {
+      in.try_open();
+      is_done = true;
+    }
+  }
+  out.close();
+}
+
+/// Hit and miss counts of @c cache_read.
+struct cache_stats {
+  int64_t hits;
+  int64_t misses;
+};
+
+/// Memory that holds the lines of @c cache_read.
+enum class cache_storage { bram, uram };
+
+namespace internal {
+
+// Reads the element of `mem` at each address from `addr_in` until EoT through
+// a set-associative cache with `tags` and `lines`, and writes them to
+// `data_out` in order, followed by EoT. Each set replaces its ways in
+// round-robin order.
+template <int kSets, int kWays, int kMaxOutstanding, typename T,
+          typename Config>
+inline void cached_gather(async_mmap<T, Config>& mem,
+                          istream<int64_t>& addr_in, ostream<T>& data_out,
+                          int64_t (&tags)[kSets][kWays],
+                          T (&lines)[kSets][kWays], cache_stats& stats) {
+#pragma HLS inline
+  int victims[kSets];  // Way that the next fill of each set replaces.
+  for (int i = 0; i < kSets; ++i) {
+#pragma HLS pipeline II = 1
+    for (int j = 0; j < kWays; ++j) tags[i][j] = -1;  // Address or -1.
+    victims[i] = 0;
+  }
+  stats = {0, 0};
+
+  // Requests in flight in order, and the slots of those waiting for `mem`.
+  T slots[kMaxOutstanding];
+  bool is_ready[kMaxOutstanding];
+  int64_t slot_addrs[kMaxOutstanding];
+  int64_t head = 0;  // Oldest request whose data is not written out.
+  int64_t tail = 0;  // Number of requests accepted.
+  int64_t misses[kMaxOutstanding];
+  int64_t miss_head = 0;
+  int64_t miss_tail = 0;
+  bool is_done = false;  // Whether EoT of `addr_in` is consumed.
+
+  while (!is_done || head < tail) {
+#pragma HLS pipeline II = 1
+#pragma HLS dependence variable = tags inter false
+#pragma HLS dependence variable = lines inter false
+    // Writes out the oldest request once its data is available.
+    if (head < tail && is_ready[head % kMaxOutstanding] &&
+        data_out.try_write(slots[head % kMaxOutstanding])) {
+      ++head;
+    }
+
+    // Fills the oldest miss and its cache line, unless another miss of the
+    // same address filled it.
+    T data;
+    if (miss_head < miss_tail && mem.read_data.try_read(data)) {
+      const int64_t slot =
+          misses[miss_head % kMaxOutstanding] % kMaxOutstanding;
+      const int64_t addr = slot_addrs[slot];
+      const int set = addr % kSets;
+      slots[slot] = data;
+      is_ready[slot] = true;
+      int way = victims[set];
+      bool is_cached = false;
+      for (int i = 0; i < kWays; ++i) {
+        if (tags[set][i] == addr) {
+          way = i;
+          is_cached = true;
+        }
+      }
+      tags[set][way] = addr;
+      lines[set][way] = data;
+      if (!is_cached) victims[set] = (way + 1) % kWays;
+      ++miss_head;
+    }
+
+    // Accepts the next request, reading `mem` on a miss.
+    bool is_valid, is_eot;
+    const int64_t addr = addr_in.peek(is_valid, is_eot);
+    if (is_valid && is_eot) {
+      addr_in.try_open();
+      is_done = true;
+    } else if (is_valid && tail - head < kMaxOutstanding) {
+      const int64_t slot = tail % kMaxOutstanding;
+      const int set = addr % kSets;
+      int way = -1;
+      for (int i = 0; i < kWays; ++i) {
+        if (tags[set][i] == addr) way = i;
+      }
+      if (way >= 0) {
+        addr_in.try_read(slot_addrs[slot]);
+        slots[slot] = lines[set][way];
+        is_ready[slot] = true;
+        ++tail;
+        ++stats.hits;
+      } else if (mem.read_addr.try_write(addr)) {
+        addr_in.try_read(slot_addrs[slot]);
+        is_ready[slot] = false;
+        misses[miss_tail % kMaxOutstanding] = tail;
+        ++miss_tail;
+        ++tail;
+        ++stats.misses;
+      }
+    }
+  }
+  data_out.close();
+}
+
+}  // namespace internal
+
+/// Like @c gather, but keeps the elements read from @c mem in a direct-mapped
+/// cache of @c kLines elements, so that requests of recently read addresses
+/// do not read @c mem again. @c mem must not change while this runs.
+template <int kLines = 1024, int kMaxOutstanding = 64, typename T,
+          typename Config>
+inline void gather_cached(async_mmap<T, Config>& mem,
+                          istream<int64_t>& addr_in, ostream<T>& data_out) {
+  int64_t tags[kLines][1];
+  T lines[kLines][1];
+  cache_stats stats;
+  internal::cached_gather<kLines, 1, kMaxOutstanding>(mem, addr_in, data_out,
+                                                      tags, lines, stats);
+}
+
+/// Serves reads of @c mem through a @c kWays -way set-associative cache of
+/// `kSets * kWays` elements stored in @c kStorage. The consumer writes
+/// addresses to @c addr_in and reads data from @c data_out in order, like
+/// @c gather. After EoT of @c addr_in, the hit and miss counts are written to
+/// @c stats_out. @c mem must not change while this runs.
+template <int kSets = 256, int kWays = 4,
+          cache_storage kStorage = cache_storage::bram,
+          int kMaxOutstanding = 64, typename T, typename Config>
+inline void cache_read(async_mmap<T, Config>& mem, istream<int64_t>& addr_in,
+                       ostream<T>& data_out, ostream<cache_stats>& stats_out) {
+  int64_t tags[kSets][kWays];
+#pragma HLS array_partition variable = tags dim = 2 complete
+  cache_stats stats;
+  if constexpr (kStorage == cache_storage::uram) {
+    T lines[kSets][kWays];
+#pragma HLS array_partition variable = lines dim = 2 complete
+#pragma HLS bind_storage variable = lines type = ram_2p impl = uram
+    internal::cached_gather<kSets, kWays, kMaxOutstanding>(
+        mem, addr_in, data_out, tags, lines, stats);
+  } else {
+    T lines[kSets][kWays];
+#pragma HLS array_partition variable = lines dim = 2 complete
+#pragma HLS bind_storage variable = lines type = ram_2p impl = bram
+    internal::cached_gather<kSets, kWays, kMaxOutstanding>(
+        mem, addr_in, data_out, tags, lines, stats);
+  }
+  stats_out.write(stats);
+}
+
+}  // namespace tapa
+
+#endif  // TAPA_ASYNC_MMAP_UTIL_H_
@@ -5,6 +5,28 @@
 #ifndef TAPA_BASE_MMAP_H_
 #define TAPA_BASE_MMAP_H_
 
-namespace tapa {}  // namespace tapa
+namespace tapa {
+
+/// Tunables of the hardware that implements a @c tapa::async_mmap port, used
+/// as its second template argument, e.g.,
+/// `tapa::async_mmap<float, tapa::async_mmap_config<16, 64>>& mem`.
+/// Zero keeps the default of a tunable. Software simulation ignores them,
+/// except that write responses acknowledge up to @c max_burst_len writes.
+///
+/// @tparam max_outstanding     Read bursts that may be in flight at the same
+///                             time. If greater than 1, read bursts are issued
+///                             with distinct AXI IDs so that memory may
+///                             respond out of order, and a reorder buffer
+///                             restores the request order. Rounded up to a
+///                             power of 2.
+/// @tparam max_burst_len       Beats in an inferred burst, up to 256.
+/// @tparam buffer_size         Depth of the request and response buffers.
+/// @tparam reorder_buffer_size Beats of read data the reorder buffer holds;
+///                             defaults to enough for all outstanding bursts.
+template <int max_outstanding = 0, int max_burst_len = 0, int buffer_size = 0,
+          int reorder_buffer_size = 0>
+struct async_mmap_config {};
+
+}  // namespace tapa
 
 #endif  // TAPA_BASE_MMAP_H_
@@ -5,6 +5,7 @@
 #ifndef TAPA_BASE_STREAM_H_
 #define TAPA_BASE_STREAM_H_
 
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 
@@ -16,6 +17,22 @@ inline constexpr uint64_t kStreamDefaultDepth = 2;
 inline constexpr uint64_t kStreamInfiniteDepth =
     std::numeric_limits<uint64_t>::max();
 
+/// Element type of a stream that is never closed, e.g.,
+/// `tapa::stream<tapa::no_eot<float>>`. Such a stream carries no EoT flag, so
+/// its FIFO is one bit narrower in hardware and its tokens are smaller in
+/// software simulation, but it cannot be closed, opened, or used in
+/// transactions. Tokens convert implicitly from and to @c T.
+template <typename T>
+struct no_eot {
+  no_eot() = default;
+  no_eot(const T& val) : val(val) {}
+
+  operator const T&() const { return val; }
+  operator T&() { return val; }
+
+  T val;
+};
+
 namespace internal {
 
 template <typename T>
@@ -24,6 +41,23 @@ struct elem_t {
   bool eot;
 };
 
+// Tokens of streams that are never closed have no EoT flag. `eot` is a
+// constant, so that checks of it are optimized away.
+template <typename T>
+struct elem_t<no_eot<T>> {
+  elem_t() = default;
+  elem_t(const no_eot<T>& val, bool is_eot) : val(val) { assert(!is_eot); }
+
+  no_eot<T> val;
+  static constexpr bool eot = false;
+};
+
+// Whether streams of `T` carry EoT tokens.
+template <typename T>
+inline constexpr bool has_eot_v = true;
+template <typename T>
+inline constexpr bool has_eot_v<no_eot<T>> = false;
+
 }  // namespace internal
 
 }  // namespace tapa
@@ -0,0 +1,145 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/allocator.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+#include "tapa/host/fork_server.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif  // MAP_HUGE_SHIFT
+
+namespace tapa::internal {
+
+namespace {
+
+// Same as `MPOL_PREFERRED` in <numaif.h>, which needs libnuma.
+constexpr int kMpolPreferred = 1;
+
+// Vendor ID of Xilinx (AMD) FPGAs.
+constexpr char kFpgaVendor[] = "0x10ee";
+
+// Returns log2 of the size of the pages.
+int get_page_shift(alloc_policy::page_size_t page_size) {
+  switch (page_size) {
+    case alloc_policy::k2MiBPages:
+      return 21;
+    case alloc_policy::k1GiBPages:
+      return 30;
+    default:
+      return 12;
+  }
+}
+
+// Rounds `length` up to whole pages, so that `allocate` and `deallocate` agree
+// on the length of the mapping.
+size_t get_mapping_length(size_t length, const alloc_policy& policy) {
+  const size_t page = size_t{1} << get_page_shift(policy.page_size);
+  return (length + page - 1) / page * page;
+}
+
+// Returns the NUMA node of the first FPGA in the PCIe bus, or -1 if unknown.
+int get_fpga_numa_node() {
+  static const int node = [] {
+    const std::string root = "/sys/bus/pci/devices/";
+    std::vector<std::string> devices;
+    if (DIR* dir = opendir(root.c_str())) {
+      while (const dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') devices.push_back(entry->d_name);
+      }
+      closedir(dir);
+    }
+    std::sort(devices.begin(), devices.end());  // Order by bus address.
+    for (const std::string& device : devices) {
+      std::ifstream vendor_ifs(root + device + "/vendor");
+      std::string vendor;
+      if (!(vendor_ifs >> vendor) || vendor != kFpgaVendor) continue;
+      std::ifstream node_ifs(root + device + "/numa_node");
+      int node = -1;
+      node_ifs >> node;
+      LOG(INFO) << "FPGA " << device << " is on NUMA node " << node;
+      return node;
+    }
+    LOG(WARNING) << "cannot find the NUMA node of any FPGA";
+    return -1;
+  }();
+  return node;
+}
+
+}  // namespace
+
+void* allocate(size_t length, const alloc_policy& policy) {
+  if (policy == alloc_policy()) return allocate(length);
+
+  length = get_mapping_length(length, policy);
+  void* addr = MAP_FAILED;
+  if (policy.page_size != alloc_policy::kDefaultPages) {
+    const int page_shift = get_page_shift(policy.page_size);
+    addr = map_shared_memory(length,
+                             MAP_HUGETLB | (page_shift << MAP_HUGE_SHIFT));
+    if (addr == MAP_FAILED) {
+      LOG_FIRST_N(WARNING, 1)
+          << "failed to allocate " << (size_t{1} << page_shift)
+          << "-byte huge pages (" << std::strerror(errno)
+          << "); using transparent huge pages if available";
+    }
+  }
+  if (addr == MAP_FAILED) {
+    addr = map_shared_memory(length, /*flags=*/0);
+    if (addr == MAP_FAILED) throw std::bad_alloc();
+    if (policy.page_size != alloc_policy::kDefaultPages) {
+      madvise(addr, length, MADV_HUGEPAGE);
+    }
+  }
+
+  // Set the policy before any page is faulted in.
+  const int node = policy.numa_node == alloc_policy::kFpgaNode
+                       ? get_fpga_numa_node()
+                       : policy.numa_node;
+  if (node >= 0) {
+    constexpr int kBitsPerWord = sizeof(unsigned long) * 8;
+    std::vector<unsigned long> mask(node / kBitsPerWord + 1);
+    mask[node / kBitsPerWord] = 1UL << (node % kBitsPerWord);
+    if (syscall(SYS_mbind, addr, length, kMpolPreferred, mask.data(),
+                mask.size() * kBitsPerWord + 1, /*flags=*/0) != 0) {
+      LOG_FIRST_N(WARNING, 1) << "failed to bind memory to NUMA node " << node
+                              << ": " << std::strerror(errno);
+    }
+  }
+
+  if (policy.prefault) {
+    const size_t page = sysconf(_SC_PAGESIZE);
+    for (size_t offset = 0; offset < length; offset += page) {
+      static_cast<volatile char*>(addr)[offset] = 0;
+    }
+  }
+  return addr;
+}
+
+void deallocate(void* addr, size_t length, const alloc_policy& policy) {
+  if (policy == alloc_policy()) return deallocate(addr, length);
+  if (!unmap_shared_memory(addr, get_mapping_length(length, policy))) {
+    throw std::bad_alloc();
+  }
+}
+
+}  // namespace tapa::internal
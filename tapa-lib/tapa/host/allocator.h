@@ -0,0 +1,121 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef TAPA_HOST_ALLOCATOR_H_
+#define TAPA_HOST_ALLOCATOR_H_
+
+#include <cstddef>
+
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "tapa/host/task.h"
+
+namespace tapa {
+
+/// Defines how @c tapa::aligned_allocator allocates host memory.
+///
+/// Memory is always aligned to at least 4 KiB, so that buffers can be used by
+/// the FPGA runtime without being copied to a bounce buffer.
+struct alloc_policy {
+  /// Pages backing the allocated memory.
+  enum page_size_t {
+    kDefaultPages,  ///< Default pages of the operating system.
+    k2MiBPages,     ///< 2 MiB huge pages.
+    k1GiBPages,     ///< 1 GiB huge pages.
+  };
+
+  /// Allocates memory on any NUMA node.
+  static constexpr int kAnyNode = -1;
+
+  /// Allocates memory on the NUMA node of the first FPGA in the PCIe bus.
+  static constexpr int kFpgaNode = -2;
+
+  /// Size of the pages.
+  ///
+  /// Huge pages must be reserved in the operating system, e.g., via
+  /// @c /proc/sys/vm/nr_hugepages. Otherwise, transparent huge pages are
+  /// requested instead, which may or may not be used.
+  page_size_t page_size = kDefaultPages;
+
+  /// NUMA node preferred to allocate memory on, or @c kAnyNode, or
+  /// @c kFpgaNode.
+  int numa_node = kAnyNode;
+
+  /// Whether to fault in all pages when the memory is allocated, so that the
+  /// first accesses do not pay for page faults.
+  bool prefault = false;
+
+  bool operator==(const alloc_policy& other) const {
+    return page_size == other.page_size && numa_node == other.numa_node &&
+           prefault == other.prefault;
+  }
+  bool operator!=(const alloc_policy& other) const { return !(*this == other); }
+};
+
+namespace internal {
+
+void* allocate(size_t length, const alloc_policy& policy);
+void deallocate(void* addr, size_t length, const alloc_policy& policy);
+
+}  // namespace internal
+
+/// Allocates host memory that is page-aligned and shared with child
+/// processes, e.g., for @c tapa::invoke_in_new_process.
+///
+/// @code{.cpp}
+///  tapa::alloc_policy policy;
+///  policy.page_size = tapa::alloc_policy::k2MiBPages;
+///  policy.numa_node = tapa::alloc_policy::kFpgaNode;
+///  tapa::aligned_vector<float> data(n, tapa::aligned_allocator<float>(policy));
+/// @endcode
+template <typename T>
+struct aligned_allocator {
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  aligned_allocator() = default;
+  explicit aligned_allocator(const alloc_policy& policy) : policy(policy) {}
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U>& other) : policy(other.policy) {}
+
+  template <typename U>
+  void construct(U* ptr) {
+    ::new (static_cast<void*>(ptr)) U;
+  }
+  template <class U, class... Args>
+  void construct(U* ptr, Args&&... args) {
+    ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+  }
+  T* allocate(size_t count) {
+    return reinterpret_cast<T*>(
+        internal::allocate(count * sizeof(T), this->policy));
+  }
+  void deallocate(T* ptr, std::size_t count) {
+    internal::deallocate(ptr, count * sizeof(T), this->policy);
+  }
+
+  alloc_policy policy;
+};
+
+template <typename T, typename U>
+bool operator==(const aligned_allocator<T>& lhs,
+                const aligned_allocator<U>& rhs) {
+  return lhs.policy == rhs.policy;
+}
+template <typename T, typename U>
+bool operator!=(const aligned_allocator<T>& lhs,
+                const aligned_allocator<U>& rhs) {
+  return lhs.policy != rhs.policy;
+}
+
+/// Vector whose data are allocated by @c tapa::aligned_allocator.
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+}  // namespace tapa
+
+#endif  // TAPA_HOST_ALLOCATOR_H_
@@ -0,0 +1,48 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/allocator.h"
+
+#include <cstdint>
+#include <numeric>
+
+#include <gtest/gtest.h>
+
+namespace tapa {
+namespace {
+
+constexpr uintptr_t kAlignment = 4096;
+
+TEST(AlignedAllocatorTest, AllocatingWithDefaultPolicyIsAligned) {
+  aligned_vector<int> data(1000);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(data.data()) % kAlignment, 0);
+}
+
+// Huge pages are usually not reserved in tests, in which case the allocation
+// falls back to default pages.
+TEST(AlignedAllocatorTest, AllocatingWithHugePagesIsAligned) {
+  alloc_policy policy;
+  policy.page_size = alloc_policy::k2MiBPages;
+  policy.numa_node = 0;
+  policy.prefault = true;
+  aligned_vector<int> data(1000, aligned_allocator<int>(policy));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(data.data()) % kAlignment, 0);
+  std::iota(data.begin(), data.end(), 0);
+  EXPECT_EQ(data.back(), 999);
+
+  // Reallocation uses the same policy.
+  data.resize(1 << 20);
+  EXPECT_EQ(data.get_allocator().policy, policy);
+  EXPECT_EQ(data[999], 999);
+}
+
+TEST(AlignedAllocatorTest, AllocatorsWithDifferentPoliciesAreNotEqual) {
+  alloc_policy policy;
+  policy.prefault = true;
+  EXPECT_EQ(aligned_allocator<int>(), aligned_allocator<float>());
+  EXPECT_NE(aligned_allocator<int>(), aligned_allocator<int>(policy));
+}
+
+}  // namespace
+}  // namespace tapa
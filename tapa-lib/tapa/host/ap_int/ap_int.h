@@ -0,0 +1,952 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+// Host implementation of `ap_int<W>` and `ap_uint<W>` for software simulation.
+//
+// This header replaces the vendor `ap_int.h` when its directory precedes the
+// vendor include path, e.g., with `tapa g++ --fast-ap-int`. Values of up to
+// 64 bits are native integers, sign-extended or masked after each operation.
+// Wider values are arrays of 64-bit words whose bitwise operations are
+// vectorized by the compiler and whose arithmetic uses 128-bit intermediates.
+// The object layout and the width and signedness of results follow the vendor
+// types, so buffers exchanged with the device keep their layout.
+//
+// Fixed-point types (`ap_fixed.h`) are not provided; designs using them must
+// keep the vendor headers.
+
+#ifndef __AP_INT_H__
+#define __AP_INT_H__
+
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+typedef signed long long ap_slong;
+typedef unsigned long long ap_ulong;
+
+template <int W, bool S>
+class ap_int_base;
+template <int W>
+class ap_int;
+template <int W>
+class ap_uint;
+template <int W, bool S>
+class ap_range_ref;
+template <int W, bool S>
+class ap_bit_ref;
+
+namespace tapa {
+namespace internal {
+namespace ap {
+
+// Integer type of `bytes` bytes that the vendor types store narrow values in.
+template <int bytes, bool S>
+using narrow_t = std::conditional_t<
+    bytes == 1, std::conditional_t<S, int8_t, uint8_t>,
+    std::conditional_t<
+        bytes == 2, std::conditional_t<S, int16_t, uint16_t>,
+        std::conditional_t<bytes <= 4, std::conditional_t<S, int32_t, uint32_t>,
+                           std::conditional_t<S, int64_t, uint64_t>>>>;
+
+// Type that values of `W` bits convert to implicitly, as in the vendor types.
+template <int W, bool S>
+using ret_t =
+    std::conditional_t<(W > 64), std::conditional_t<S, ap_slong, ap_ulong>,
+                       narrow_t<(W + 7) / 8, S>>;
+
+// Operations on little-endian arrays of `N` 64-bit words.
+
+template <int N>
+inline void add(uint64_t* dst, const uint64_t* lhs, const uint64_t* rhs) {
+  unsigned __int128 carry = 0;
+  for (int i = 0; i < N; ++i) {
+    carry += static_cast<unsigned __int128>(lhs[i]) + rhs[i];
+    dst[i] = static_cast<uint64_t>(carry);
+    carry >>= 64;
+  }
+}
+
+template <int N>
+inline void sub(uint64_t* dst, const uint64_t* lhs, const uint64_t* rhs) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < N; ++i) {
+    const uint64_t diff = lhs[i] - rhs[i];
+    const uint64_t next_borrow = (lhs[i] < rhs[i]) | (diff < borrow);
+    dst[i] = diff - borrow;
+    borrow = next_borrow;
+  }
+}
+
+template <int N>
+inline void mul(uint64_t* dst, const uint64_t* lhs, const uint64_t* rhs) {
+  uint64_t result[N] = {};
+  for (int i = 0; i < N; ++i) {
+    unsigned __int128 carry = 0;
+    for (int j = 0; i + j < N; ++j) {
+      carry += static_cast<unsigned __int128>(lhs[i]) * rhs[j] + result[i + j];
+      result[i + j] = static_cast<uint64_t>(carry);
+      carry >>= 64;
+    }
+  }
+  std::memcpy(dst, result, sizeof(result));
+}
+
+template <int N>
+inline void shl(uint64_t* dst, const uint64_t* src, int n) {
+  const int words = n / 64;
+  const int bits = n % 64;
+  for (int i = N - 1; i >= 0; --i) {
+    const int j = i - words;
+    uint64_t word = j >= 0 ? src[j] << bits : 0;
+    if (bits != 0 && j >= 1) word |= src[j - 1] >> (64 - bits);
+    dst[i] = word;
+  }
+}
+
+// Shifts right, filling with ones if `fill` is set.
+template <int N>
+inline void shr(uint64_t* dst, const uint64_t* src, int n, bool fill) {
+  const uint64_t ext = fill ? ~uint64_t{0} : 0;
+  const int words = n / 64;
+  const int bits = n % 64;
+  for (int i = 0; i < N; ++i) {
+    const int j = i + words;
+    const uint64_t lo = j < N ? src[j] : ext;
+    const uint64_t hi = j + 1 < N ? src[j + 1] : ext;
+    dst[i] = bits == 0 ? lo : (lo >> bits) | (hi << (64 - bits));
+  }
+}
+
+template <int N>
+inline int compare(const uint64_t* lhs, const uint64_t* rhs) {
+  for (int i = N - 1; i >= 0; --i) {
+    if (lhs[i] != rhs[i]) return lhs[i] < rhs[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+// Divides `num` by `den` as unsigned values by long division.
+template <int N>
+inline void divmod(const uint64_t* num, const uint64_t* den, uint64_t* quo,
+                   uint64_t* rem) {
+  uint64_t q[N] = {};
+  uint64_t r[N] = {};
+  for (int i = N * 64 - 1; i >= 0; --i) {
+    shl<N>(r, r, 1);
+    r[0] |= (num[i / 64] >> (i % 64)) & 1;
+    if (compare<N>(r, den) >= 0) {
+      sub<N>(r, r, den);
+      q[i / 64] |= uint64_t{1} << (i % 64);
+    }
+  }
+  if (quo != nullptr) std::memcpy(quo, q, sizeof(q));
+  if (rem != nullptr) std::memcpy(rem, r, sizeof(r));
+}
+
+// Divides `words` by `den` in place and returns the remainder.
+template <int N>
+inline uint64_t divmod_small(uint64_t* words, uint64_t den) {
+  unsigned __int128 rem = 0;
+  for (int i = N - 1; i >= 0; --i) {
+    rem = (rem << 64) | words[i];
+    words[i] = static_cast<uint64_t>(rem / den);
+    rem %= den;
+  }
+  return static_cast<uint64_t>(rem);
+}
+
+// Computes `words = words * mul + add` in place.
+template <int N>
+inline void mul_add_small(uint64_t* words, uint64_t mul, uint64_t add) {
+  unsigned __int128 carry = add;
+  for (int i = 0; i < N; ++i) {
+    carry += static_cast<unsigned __int128>(words[i]) * mul;
+    words[i] = static_cast<uint64_t>(carry);
+    carry >>= 64;
+  }
+}
+
+// Operands of `ap_int_base` operators: integers, vendor types, and references
+// to their bits.
+template <typename T, typename = void>
+struct operand {
+  static constexpr bool value = false;
+  static constexpr bool is_ap = false;
+};
+
+template <typename T>
+struct operand<T, std::enable_if_t<std::is_integral_v<T>>> {
+  static constexpr bool value = true;
+  static constexpr bool is_ap = false;
+  static constexpr int width =
+      std::is_same_v<T, bool> ? 1 : int(sizeof(T) * CHAR_BIT);
+  static constexpr bool sign = std::is_signed_v<T>;
+};
+
+template <int W, bool S>
+struct operand<ap_int_base<W, S>> {
+  static constexpr bool value = true;
+  static constexpr bool is_ap = true;
+  static constexpr int width = W;
+  static constexpr bool sign = S;
+};
+
+template <int W>
+struct operand<ap_int<W>> : operand<ap_int_base<W, true>> {};
+template <int W>
+struct operand<ap_uint<W>> : operand<ap_int_base<W, false>> {};
+
+// Ranges are as wide as the value they refer to, as in the vendor types.
+template <int W, bool S>
+struct operand<ap_range_ref<W, S>> : operand<ap_int_base<W, false>> {};
+template <int W, bool S>
+struct operand<ap_bit_ref<W, S>> : operand<ap_int_base<1, false>> {};
+
+template <typename T>
+inline constexpr bool is_operand_v = operand<T>::value;
+
+template <typename L, typename R>
+inline constexpr bool is_operand_pair_v =
+    is_operand_v<L> && is_operand_v<R> &&
+    (operand<L>::is_ap || operand<R>::is_ap);
+
+template <typename L, typename R>
+inline constexpr bool is_ap_pair_v = operand<L>::is_ap && operand<R>::is_ap;
+
+// Width that holds all values of `L` and `R`.
+template <typename L, typename R>
+inline constexpr int common_width =
+    std::max(operand<L>::width + (!operand<L>::sign && operand<R>::sign),
+             operand<R>::width + (!operand<R>::sign && operand<L>::sign));
+
+template <typename L, typename R>
+inline constexpr bool common_sign = operand<L>::sign || operand<R>::sign;
+
+}  // namespace ap
+}  // namespace internal
+}  // namespace tapa
+
+/// Arbitrary-precision integer of `W` bits, signed if `S` is set.
+template <int W, bool S>
+class ap_int_base {
+  static_assert(W > 0, "width must be positive");
+
+ public:
+  static constexpr int width = W;
+  static constexpr bool sign_flag = S;
+
+  ap_int_base() : words_{} {}
+
+  template <typename T, typename = std::enable_if_t<
+                            tapa::internal::ap::is_operand_v<T>>>
+  ap_int_base(const T& value) {  // NOLINT(runtime/explicit)
+    assign(value);
+  }
+
+  ap_int_base(double value) { assign_double(value); }  // NOLINT
+  ap_int_base(float value) { assign_double(value); }   // NOLINT
+
+  ap_int_base(const char* str,  // NOLINT(runtime/explicit)
+              signed char radix = 10) {
+    assign_string(str, radix);
+  }
+
+  template <typename T, typename = std::enable_if_t<
+                            tapa::internal::ap::is_operand_v<T>>>
+  ap_int_base& operator=(const T& value) {
+    assign(value);
+    return *this;
+  }
+
+  // Conversions to native types.
+  operator tapa::internal::ap::ret_t<W, S>() const {
+    return static_cast<tapa::internal::ap::ret_t<W, S>>(to_int64());
+  }
+  bool to_bool() const { return !iszero(); }
+  char to_char() const { return static_cast<char>(to_int64()); }
+  int to_int() const { return static_cast<int>(to_int64()); }
+  unsigned to_uint() const { return static_cast<unsigned>(to_int64()); }
+  long to_long() const { return static_cast<long>(to_int64()); }
+  unsigned long to_ulong() const {
+    return static_cast<unsigned long>(to_int64());
+  }
+  ap_slong to_int64() const { return static_cast<ap_slong>(words_[0]); }
+  ap_ulong to_uint64() const { return static_cast<ap_ulong>(to_int64()); }
+  double to_double() const {
+    if constexpr (kWords == 1) {
+      return S ? double(to_int64()) : double(to_uint64());
+    } else {
+      uint64_t buffer[kWords];
+      load(buffer);
+      if (is_neg()) negate(buffer);
+      double result = 0;
+      for (int i = kWords - 1; i >= 0; --i) {
+        result = std::ldexp(result, 64) + double(buffer[i]);
+      }
+      return is_neg() ? -result : result;
+    }
+  }
+  float to_float() const { return static_cast<float>(to_double()); }
+
+  int length() const { return W; }
+  bool iszero() const {
+    for (int i = 0; i < kWords; ++i) {
+      if (words_[i] != 0) return false;
+    }
+    return true;
+  }
+  bool is_zero() const { return iszero(); }
+  bool sign() const { return is_neg(); }
+  bool is_neg() const {
+    return S && static_cast<ap_slong>(words_[kWords - 1]) < 0;
+  }
+
+  // Bit access.
+  bool get_bit(int index) const {
+    return (word(index / 64) >> (index % 64)) & 1;
+  }
+  bool test(int index) const { return get_bit(index); }
+  void set_bit(int index, bool value) {
+    uint64_t buffer[kWords];
+    load(buffer);
+    const uint64_t mask = uint64_t{1} << (index % 64);
+    buffer[index / 64] =
+        value ? buffer[index / 64] | mask : buffer[index / 64] & ~mask;
+    store(buffer);
+  }
+  void set(int index) { set_bit(index, true); }
+  void clear(int index) { set_bit(index, false); }
+  void invert(int index) { set_bit(index, !get_bit(index)); }
+  ap_bit_ref<W, S> operator[](int index) { return {*this, index}; }
+  bool operator[](int index) const { return get_bit(index); }
+  ap_bit_ref<W, S> bit(int index) { return {*this, index}; }
+  bool bit(int index) const { return get_bit(index); }
+
+  // Range access, with bits reversed if `hi < lo`.
+  ap_range_ref<W, S> range(int hi, int lo) { return {*this, hi, lo}; }
+  ap_range_ref<W, S> range(int hi, int lo) const {
+    return {const_cast<ap_int_base&>(*this), hi, lo};
+  }
+  ap_range_ref<W, S> range() { return {*this, W - 1, 0}; }
+  ap_range_ref<W, S> range() const { return range(W - 1, 0); }
+  ap_range_ref<W, S> operator()(int hi, int lo) { return range(hi, lo); }
+  ap_range_ref<W, S> operator()(int hi, int lo) const { return range(hi, lo); }
+
+  ap_int_base<W, false> get_range(int hi, int lo) const {
+    if (hi < lo) return get_range(lo, hi).reversed_low(lo - hi + 1);
+    ap_int_base<W, false> result;
+    uint64_t buffer[kWords];
+    load(buffer);
+    tapa::internal::ap::shr<kWords>(buffer, buffer, lo, false);
+    mask_low(buffer, hi - lo + 1);
+    result.store(buffer);
+    return result;
+  }
+
+  template <typename T, typename = std::enable_if_t<
+                            tapa::internal::ap::is_operand_v<T>>>
+  void set_range(int hi, int lo, const T& value) {
+    if (hi < lo) {
+      set_range(lo, hi, ap_int_base<W, false>(value).reversed_low(lo - hi + 1));
+      return;
+    }
+    uint64_t buffer[kWords];
+    uint64_t field[kWords];
+    uint64_t mask[kWords] = {};
+    load(buffer);
+    ap_int_base<W, false>(value).load(field);
+    for (int i = 0; i < kWords; ++i) mask[i] = ~uint64_t{0};
+    mask_low(mask, hi - lo + 1);
+    mask_low(field, hi - lo + 1);
+    tapa::internal::ap::shl<kWords>(mask, mask, lo);
+    tapa::internal::ap::shl<kWords>(field, field, lo);
+    for (int i = 0; i < kWords; ++i) {
+      buffer[i] = (buffer[i] & ~mask[i]) | field[i];
+    }
+    store(buffer);
+  }
+
+  // Reductions.
+  bool and_reduce() const { return (~ap_int_base<W, false>(*this)).iszero(); }
+  bool or_reduce() const { return !iszero(); }
+  bool xor_reduce() const {
+    uint64_t buffer[kWords];
+    ap_int_base<W, false>(*this).load(buffer);
+    int parity = 0;
+    for (int i = 0; i < kWords; ++i) {
+      parity ^= __builtin_parityll(buffer[i]);
+    }
+    return parity;
+  }
+  bool nand_reduce() const { return !and_reduce(); }
+  bool nor_reduce() const { return !or_reduce(); }
+  bool xnor_reduce() const { return !xor_reduce(); }
+
+  int countLeadingZeros() const {
+    uint64_t buffer[kWords];
+    ap_int_base<W, false>(*this).load(buffer);
+    for (int i = kWords - 1; i >= 0; --i) {
+      if (buffer[i] != 0) return W - 64 * i - 64 + __builtin_clzll(buffer[i]);
+    }
+    return W;
+  }
+
+  void reverse() { *this = ap_int_base(get_range(0, W - 1)); }
+  void lrotate(int n) {
+    n %= W;
+    const ap_int_base<W, false> bits(*this);
+    *this = ap_int_base((bits << n) | (bits >> (W - n)));
+  }
+  void rrotate(int n) { lrotate(W - n % W); }
+  void b_not() { *this = ~*this; }
+
+  // Shifts keep the type of the shifted value. Shifting a signed value by a
+  // negative amount shifts it in the other direction.
+  template <typename T, typename = std::enable_if_t<
+                            tapa::internal::ap::is_operand_v<T>>>
+  ap_int_base operator<<(const T& amount) const {
+    const ap_slong n = ap_int_base<64, true>(amount).to_int64();
+    if (tapa::internal::ap::operand<T>::sign && n < 0) return shift_right(-n);
+    return shift_left(n);
+  }
+  template <typename T, typename = std::enable_if_t<
+                            tapa::internal::ap::is_operand_v<T>>>
+  ap_int_base operator>>(const T& amount) const {
+    const ap_slong n = ap_int_base<64, true>(amount).to_int64();
+    if (tapa::internal::ap::operand<T>::sign && n < 0) return shift_left(-n);
+    return shift_right(n);
+  }
+
+  ap_int_base operator~() const {
+    uint64_t buffer[kWords];
+    load(buffer);
+    for (int i = 0; i < kWords; ++i) buffer[i] = ~buffer[i];
+    ap_int_base result;
+    result.store(buffer);
+    return result;
+  }
+  ap_int_base operator+() const { return *this; }
+  ap_int_base<W + 1, true> operator-() const {
+    return ap_int_base<W + 1, true>(0) - *this;
+  }
+  bool operator!() const { return iszero(); }
+
+  ap_int_base& operator++() { return *this += 1; }
+  ap_int_base& operator--() { return *this -= 1; }
+  const ap_int_base operator++(int) {
+    const ap_int_base old = *this;
+    ++*this;
+    return old;
+  }
+  const ap_int_base operator--(int) {
+    const ap_int_base old = *this;
+    --*this;
+    return old;
+  }
+
+#define TAPA_AP_INT_ASSIGN_OP(op)                                          \
+  template <typename T, typename = std::enable_if_t<                       \
+                            tapa::internal::ap::is_operand_v<T>>>          \
+  ap_int_base& operator op##=(const T& rhs) {                              \
+    return *this = ap_int_base(*this op rhs);                              \
+  }
+  TAPA_AP_INT_ASSIGN_OP(+)
+  TAPA_AP_INT_ASSIGN_OP(-)
+  TAPA_AP_INT_ASSIGN_OP(*)
+  TAPA_AP_INT_ASSIGN_OP(/)
+  TAPA_AP_INT_ASSIGN_OP(%)
+  TAPA_AP_INT_ASSIGN_OP(&)
+  TAPA_AP_INT_ASSIGN_OP(|)
+  TAPA_AP_INT_ASSIGN_OP(^)
+  TAPA_AP_INT_ASSIGN_OP(<<)
+  TAPA_AP_INT_ASSIGN_OP(>>)
+#undef TAPA_AP_INT_ASSIGN_OP
+
+  /// Returns the digits in `radix`, with a `0b`, `0o`, or `0x` prefix unless
+  /// `radix` is 10. Values are negative only if `sign` is set.
+  std::string to_string(signed char radix = 2, bool sign = S) const {
+    uint64_t buffer[kWords];
+    ap_int_base<W, false>(*this).load(buffer);
+    const bool negative = sign && is_neg();
+    if (negative) {
+      load(buffer);
+      negate(buffer);
+    }
+    std::string digits;
+    do {
+      const uint64_t digit =
+          tapa::internal::ap::divmod_small<kWords>(buffer, radix);
+      digits += "0123456789abcdefghijklmnopqrstuvwxyz"[digit];
+    } while (!std::all_of(buffer, buffer + kWords,
+                          [](uint64_t x) { return x == 0; }));
+    switch (radix) {
+      case 2:
+        digits += "b0";
+        break;
+      case 8:
+        digits += "o0";
+        break;
+      case 16:
+        digits += "x0";
+        break;
+    }
+    if (negative) digits += '-';
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+  }
+
+  // Copies the value into `kWords` words, extended to all of them.
+  void load(uint64_t* buffer) const {
+    if constexpr (kWords == 1) {
+      buffer[0] = static_cast<uint64_t>(words_[0]);
+    } else {
+      std::memcpy(buffer, words_, sizeof(words_));
+    }
+  }
+
+  // Truncates `kWords` words to `W` bits and stores them.
+  void store(const uint64_t* buffer) {
+    if constexpr (kWords == 1) {
+      constexpr int shift = 64 - W;
+      const uint64_t value = buffer[0] << shift;
+      words_[0] = static_cast<word_t>(
+          S ? ap_slong(value) >> shift : ap_slong(value >> shift));
+    } else {
+      std::memcpy(words_, buffer, sizeof(words_));
+      constexpr int shift = kWords * 64 - W;
+      if constexpr (shift != 0) {
+        const uint64_t value = words_[kWords - 1] << shift;
+        words_[kWords - 1] = S ? uint64_t(ap_slong(value) >> shift)
+                               : value >> shift;
+      }
+    }
+  }
+
+ private:
+  template <int W2, bool S2>
+  friend class ap_int_base;
+
+  // Values of up to 64 bits are a single narrow integer, wider values are
+  // arrays of 64-bit words. Both are sign-extended or zero-extended to fill
+  // the storage.
+  static constexpr int kWords = (W + 63) / 64;
+  using word_t = std::conditional_t<
+      (W > 64), uint64_t, tapa::internal::ap::narrow_t<(W + 7) / 8, S>>;
+
+  uint64_t word(int index) const {
+    return static_cast<uint64_t>(words_[index]);
+  }
+
+  // Negates `kWords` words in place.
+  static void negate(uint64_t* buffer) {
+    const uint64_t zero[kWords] = {};
+    tapa::internal::ap::sub<kWords>(buffer, zero, buffer);
+  }
+
+  static void mask_low(uint64_t* buffer, int bits) {
+    for (int i = 0; i < kWords; ++i) {
+      const int low = bits - i * 64;
+      if (low <= 0) {
+        buffer[i] = 0;
+      } else if (low < 64) {
+        buffer[i] &= (uint64_t{1} << low) - 1;
+      }
+    }
+  }
+
+  ap_int_base<W, false> reversed_low(int bits) const {
+    ap_int_base<W, false> result;
+    for (int i = 0; i < bits; ++i) result.set_bit(i, get_bit(bits - 1 - i));
+    return result;
+  }
+
+  ap_int_base shift_left(ap_ulong n) const {
+    if (n >= ap_ulong(W)) return ap_int_base();
+    uint64_t buffer[kWords];
+    load(buffer);
+    tapa::internal::ap::shl<kWords>(buffer, buffer, int(n));
+    ap_int_base result;
+    result.store(buffer);
+    return result;
+  }
+
+  ap_int_base shift_right(ap_ulong n) const {
+    uint64_t buffer[kWords];
+    load(buffer);
+    tapa::internal::ap::shr<kWords>(
+        buffer, buffer, int(std::min<ap_ulong>(n, kWords * 64)),
+        is_neg());
+    ap_int_base result;
+    result.store(buffer);
+    return result;
+  }
+
+  template <typename T>
+  void assign(const T& value) {
+    using operand = tapa::internal::ap::operand<T>;
+    if constexpr (std::is_integral_v<T>) {
+      uint64_t buffer[kWords];
+      uint64_t ext = 0;
+      if constexpr (operand::sign) ext = value < 0 ? ~uint64_t{0} : 0;
+      buffer[0] = static_cast<uint64_t>(value);
+      for (int i = 1; i < kWords; ++i) buffer[i] = ext;
+      store(buffer);
+    } else if constexpr (std::is_base_of_v<ap_int_base<operand::width,
+                                                       operand::sign>,
+                                           T>) {
+      constexpr int kSrcWords = (operand::width + 63) / 64;
+      uint64_t src[kSrcWords];
+      static_cast<const ap_int_base<operand::width, operand::sign>&>(value)
+          .load(src);
+      uint64_t buffer[kWords];
+      const uint64_t ext =
+          operand::sign && ap_slong(src[kSrcWords - 1]) < 0 ? ~uint64_t{0} : 0;
+      for (int i = 0; i < kWords; ++i) {
+        buffer[i] = i < kSrcWords ? src[i] : ext;
+      }
+      store(buffer);
+    } else {
+      assign(value.get());
+    }
+  }
+
+  void assign_double(double value) {
+    uint64_t buffer[kWords] = {};
+    int exponent;
+    const double mantissa = std::frexp(std::fabs(value), &exponent);
+    buffer[0] = static_cast<uint64_t>(std::ldexp(mantissa, 64));
+    if (exponent > 64) {
+      tapa::internal::ap::shl<kWords>(buffer, buffer,
+                                            std::min(exponent - 64, W));
+    } else {
+      tapa::internal::ap::shr<kWords>(buffer, buffer, 64 - exponent,
+                                            false);
+    }
+    store(buffer);
+    if (value < 0) *this = ap_int_base(-*this);
+  }
+
+  void assign_string(const char* str, int radix) {
+    bool negative = false;
+    if (*str == '-' || *str == '+') negative = *str++ == '-';
+    if (str[0] == '0' && str[1] != '\0') {
+      switch (str[1]) {
+        case 'b':
+        case 'B':
+          radix = 2, str += 2;
+          break;
+        case 'o':
+        case 'O':
+          radix = 8, str += 2;
+          break;
+        case 'x':
+        case 'X':
+          radix = 16, str += 2;
+          break;
+      }
+    }
+    uint64_t buffer[kWords] = {};
+    for (; *str != '\0'; ++str) {
+      const char c = *str;
+      int digit;
+      if (c >= '0' && c <= '9') {
+        digit = c - '0';
+      } else if (c >= 'a' && c <= 'z') {
+        digit = c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'Z') {
+        digit = c - 'A' + 10;
+      } else {
+        continue;  // Skips separators like `'` and `_`.
+      }
+      if (digit >= radix) break;
+      tapa::internal::ap::mul_add_small<kWords>(buffer, radix, digit);
+    }
+    store(buffer);
+    if (negative) *this = ap_int_base(-*this);
+  }
+
+  word_t words_[kWords];
+};
+
+/// Signed arbitrary-precision integer of `W` bits.
+template <int W>
+class ap_int : public ap_int_base<W, true> {
+  using base_type = ap_int_base<W, true>;
+
+ public:
+  ap_int() = default;
+  template <typename T, typename = std::enable_if_t<
+                            tapa::internal::ap::is_operand_v<T>>>
+  ap_int(const T& value) : base_type(value) {}  // NOLINT(runtime/explicit)
+  ap_int(double value) : base_type(value) {}   // NOLINT(runtime/explicit)
+  ap_int(float value) : base_type(value) {}    // NOLINT(runtime/explicit)
+  explicit ap_int(const char* str, signed char radix = 10)
+      : base_type(str, radix) {}
+  using base_type::operator=;
+};
+
+/// Unsigned arbitrary-precision integer of `W` bits.
+template <int W>
+class ap_uint : public ap_int_base<W, false> {
+  using base_type = ap_int_base<W, false>;
+
+ public:
+  ap_uint() = default;
+  template <typename T, typename = std::enable_if_t<
+                            tapa::internal::ap::is_operand_v<T>>>
+  ap_uint(const T& value) : base_type(value) {}  // NOLINT(runtime/explicit)
+  ap_uint(double value) : base_type(value) {}   // NOLINT(runtime/explicit)
+  ap_uint(float value) : base_type(value) {}    // NOLINT(runtime/explicit)
+  explicit ap_uint(const char* str, signed char radix = 10)
+      : base_type(str, radix) {}
+  using base_type::operator=;
+};
+
+/// Bits `hi` down to `lo` of an `ap_int_base<W, S>`.
+template <int W, bool S>
+class ap_range_ref {
+ public:
+  ap_range_ref(ap_int_base<W, S>& parent, int hi, int lo)
+      : parent_(parent), hi_(hi), lo_(lo) {}
+  ap_range_ref(const ap_range_ref&) = default;
+
+  ap_int_base<W, false> get() const { return parent_.get_range(hi_, lo_); }
+  operator ap_ulong() const { return get().to_uint64(); }
+
+  template <typename T, typename = std::enable_if_t<
+                            tapa::internal::ap::is_operand_v<T>>>
+  ap_range_ref& operator=(const T& value) {
+    parent_.set_range(hi_, lo_, value);
+    return *this;
+  }
+  ap_range_ref& operator=(const ap_range_ref& other) {
+    return *this = other.get();
+  }
+
+  int length() const { return (hi_ > lo_ ? hi_ - lo_ : lo_ - hi_) + 1; }
+  bool to_bool() const { return get().to_bool(); }
+  int to_int() const { return get().to_int(); }
+  unsigned to_uint() const { return get().to_uint(); }
+  long to_long() const { return get().to_long(); }
+  unsigned long to_ulong() const { return get().to_ulong(); }
+  ap_slong to_int64() const { return get().to_int64(); }
+  ap_ulong to_uint64() const { return get().to_uint64(); }
+  bool and_reduce() const {
+    return get() == ap_int_base<W, false>(~ap_int_base<W, false>(0))
+                        .get_range(length() - 1, 0);
+  }
+  bool or_reduce() const { return get().or_reduce(); }
+  bool xor_reduce() const { return get().xor_reduce(); }
+  std::string to_string(signed char radix = 2) const {
+    return get().to_string(radix, false);
+  }
+
+ private:
+  ap_int_base<W, S>& parent_;
+  const int hi_;
+  const int lo_;
+};
+
+/// Bit `index` of an `ap_int_base<W, S>`.
+template <int W, bool S>
+class ap_bit_ref {
+ public:
+  ap_bit_ref(ap_int_base<W, S>& parent, int index)
+      : parent_(parent), index_(index) {}
+  ap_bit_ref(const ap_bit_ref&) = default;
+
+  ap_int_base<1, false> get() const { return parent_.get_bit(index_); }
+  operator bool() const { return parent_.get_bit(index_); }
+
+  template <typename T, typename = std::enable_if_t<
+                            tapa::internal::ap::is_operand_v<T>>>
+  ap_bit_ref& operator=(const T& value) {
+    parent_.set_bit(index_, ap_int_base<tapa::internal::ap::operand<T>::width,
+                                        false>(value)
+                                .to_bool());
+    return *this;
+  }
+  ap_bit_ref& operator=(const ap_bit_ref& other) {
+    return *this = bool(other);
+  }
+
+  bool operator~() const { return !bool(*this); }
+  int length() const { return 1; }
+  bool to_bool() const { return bool(*this); }
+
+ private:
+  ap_int_base<W, S>& parent_;
+  const int index_;
+};
+
+// Binary operators convert both operands to the type of the result, whose
+// width and signedness follow the vendor types.
+
+#define TAPA_AP_INT_BINARY_OP(op, result_width, body)                        \
+  template <typename L, typename R,                                         \
+            typename = std::enable_if_t<                                    \
+                tapa::internal::ap::is_operand_pair_v<L, R>>>               \
+  inline auto operator op(const L& lhs, const R& rhs) {                     \
+    using tapa::internal::ap::operand;                                      \
+    constexpr int kWidth = (result_width);                                  \
+    constexpr bool kSign = tapa::internal::ap::common_sign<L, R>;           \
+    using result_t = ap_int_base<kWidth, kSign>;                            \
+    constexpr int kWords = (kWidth + 63) / 64;                              \
+    uint64_t lhs_words[kWords];                                             \
+    uint64_t rhs_words[kWords];                                             \
+    uint64_t result_words[kWords];                                          \
+    result_t(lhs).load(lhs_words);                                          \
+    result_t(rhs).load(rhs_words);                                          \
+    body;                                                                   \
+    result_t result;                                                        \
+    result.store(result_words);                                             \
+    return result;                                                          \
+  }
+
+TAPA_AP_INT_BINARY_OP(
+    +, (tapa::internal::ap::common_width<L, R> + 1),
+    (tapa::internal::ap::add<kWords>(result_words, lhs_words, rhs_words)))
+TAPA_AP_INT_BINARY_OP(
+    -, (tapa::internal::ap::common_width<L, R> + 1),
+    (tapa::internal::ap::sub<kWords>(result_words, lhs_words, rhs_words)))
+TAPA_AP_INT_BINARY_OP(
+    *, (operand<L>::width + operand<R>::width),
+    (tapa::internal::ap::mul<kWords>(result_words, lhs_words, rhs_words)))
+TAPA_AP_INT_BINARY_OP(&, (tapa::internal::ap::common_width<L, R>),
+                      for (int i = 0; i < kWords; ++i) result_words[i] =
+                          lhs_words[i] & rhs_words[i])
+TAPA_AP_INT_BINARY_OP(|, (tapa::internal::ap::common_width<L, R>),
+                      for (int i = 0; i < kWords; ++i) result_words[i] =
+                          lhs_words[i] | rhs_words[i])
+TAPA_AP_INT_BINARY_OP(^, (tapa::internal::ap::common_width<L, R>),
+                      for (int i = 0; i < kWords; ++i) result_words[i] =
+                          lhs_words[i] ^ rhs_words[i])
+
+#undef TAPA_AP_INT_BINARY_OP
+
+namespace tapa {
+namespace internal {
+namespace ap {
+
+// Divides `lhs` by `rhs` at the width of both and returns the quotient if
+// `is_quotient`, or the remainder otherwise. Both truncate toward zero.
+template <typename L, typename R, bool is_quotient>
+inline auto divide(const L& lhs, const R& rhs) {
+  constexpr int kWidth = common_width<L, R> + 1;
+  constexpr int kWords = (kWidth + 63) / 64;
+  using value_t = ap_int_base<kWidth, true>;
+  const value_t num(lhs);
+  const value_t den(rhs);
+  uint64_t num_words[kWords];
+  uint64_t den_words[kWords];
+  uint64_t result_words[kWords];
+  (num.is_neg() ? value_t(-num) : num).load(num_words);
+  (den.is_neg() ? value_t(-den) : den).load(den_words);
+  if constexpr (kWords == 1) {
+    result_words[0] = is_quotient ? num_words[0] / den_words[0]
+                                  : num_words[0] % den_words[0];
+  } else {
+    divmod<kWords>(num_words, den_words, is_quotient ? result_words : nullptr,
+                   is_quotient ? nullptr : result_words);
+  }
+  value_t result;
+  result.store(result_words);
+  const bool negative = is_quotient ? num.is_neg() != den.is_neg()
+                                    : num.is_neg();
+  return negative ? value_t(-result) : result;
+}
+
+}  // namespace ap
+}  // namespace internal
+}  // namespace tapa
+
+template <typename L, typename R,
+          typename = std::enable_if_t<
+              tapa::internal::ap::is_operand_pair_v<L, R>>>
+inline auto operator/(const L& lhs, const R& rhs) {
+  using tapa::internal::ap::operand;
+  return ap_int_base<operand<L>::width + operand<R>::sign,
+                     tapa::internal::ap::common_sign<L, R>>(
+      tapa::internal::ap::divide<L, R, true>(lhs, rhs));
+}
+
+template <typename L, typename R,
+          typename = std::enable_if_t<
+              tapa::internal::ap::is_operand_pair_v<L, R>>>
+inline auto operator%(const L& lhs, const R& rhs) {
+  using tapa::internal::ap::operand;
+  return ap_int_base<std::min(operand<L>::width, operand<R>::width),
+                     operand<L>::sign>(
+      tapa::internal::ap::divide<L, R, false>(lhs, rhs));
+}
+
+#define TAPA_AP_INT_COMPARE_OP(op)                                          \
+  template <typename L, typename R,                                         \
+            typename = std::enable_if_t<                                    \
+                tapa::internal::ap::is_operand_pair_v<L, R>>>               \
+  inline bool operator op(const L& lhs, const R& rhs) {                     \
+    constexpr int kWidth = tapa::internal::ap::common_width<L, R>;          \
+    constexpr int kWords = (kWidth + 63) / 64;                              \
+    using value_t =                                                         \
+        ap_int_base<kWidth, tapa::internal::ap::common_sign<L, R>>;         \
+    const value_t lhs_value(lhs);                                           \
+    const value_t rhs_value(rhs);                                           \
+    if (lhs_value.is_neg() != rhs_value.is_neg()) {                         \
+      return (rhs_value.is_neg() ? 1 : -1) op 0;                            \
+    }                                                                       \
+    uint64_t lhs_words[kWords];                                             \
+    uint64_t rhs_words[kWords];                                             \
+    lhs_value.load(lhs_words);                                              \
+    rhs_value.load(rhs_words);                                              \
+    return tapa::internal::ap::compare<kWords>(lhs_words, rhs_words) op 0;  \
+  }
+
+TAPA_AP_INT_COMPARE_OP(==)
+TAPA_AP_INT_COMPARE_OP(!=)
+TAPA_AP_INT_COMPARE_OP(<)
+TAPA_AP_INT_COMPARE_OP(<=)
+TAPA_AP_INT_COMPARE_OP(>)
+TAPA_AP_INT_COMPARE_OP(>=)
+
+#undef TAPA_AP_INT_COMPARE_OP
+
+/// Concatenates `hi` and `lo`, e.g., `(hi, lo)`, into an unsigned value.
+template <typename L, typename R,
+          typename =
+              std::enable_if_t<tapa::internal::ap::is_ap_pair_v<L, R>>>
+inline auto operator,(const L& hi, const R& lo) {
+  using tapa::internal::ap::operand;
+  constexpr int kWidth = operand<L>::width + operand<R>::width;
+  ap_int_base<kWidth, false> result = ap_int_base<operand<L>::width, false>(hi);
+  result <<= operand<R>::width;
+  result |= ap_int_base<operand<R>::width, false>(lo);
+  return result;
+}
+
+template <int W, bool S>
+inline std::ostream& operator<<(std::ostream& os,
+                                const ap_int_base<W, S>& value) {
+  const auto base = os.flags() & std::ios::basefield;
+  if (base == std::ios::hex) {
+    return os << value.to_string(16, false).substr(2);
+  }
+  if (base == std::ios::oct) {
+    return os << value.to_string(8, false).substr(2);
+  }
+  return os << value.to_string(10);
+}
+
+template <int W, bool S>
+inline std::ostream& operator<<(std::ostream& os,
+                                const ap_range_ref<W, S>& value) {
+  return os << value.get();
+}
+
+#endif  // __AP_INT_H__
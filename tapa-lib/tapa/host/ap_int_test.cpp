@@ -0,0 +1,157 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/ap_int/ap_int.h"
+
+#include <cstdint>
+
+#include <sstream>
+#include <type_traits>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// Buffers of these types are exchanged with the device as is.
+static_assert(sizeof(ap_uint<1>) == 1);
+static_assert(sizeof(ap_int<12>) == 2);
+static_assert(sizeof(ap_uint<24>) == 4);
+static_assert(sizeof(ap_int<33>) == 8);
+static_assert(sizeof(ap_uint<96>) == 16);
+static_assert(sizeof(ap_uint<512>) == 64);
+
+// Results are wide enough to hold all values, as with the vendor types.
+static_assert(std::is_same_v<decltype(ap_uint<8>() + ap_uint<8>()),
+                             ap_int_base<9, false>>);
+static_assert(std::is_same_v<decltype(ap_uint<8>() * ap_int<4>()),
+                             ap_int_base<12, true>>);
+static_assert(
+    std::is_same_v<decltype(ap_uint<4>() & 1), ap_int_base<32, true>>);
+static_assert(std::is_same_v<decltype((ap_uint<3>(), ap_int<5>())),
+                             ap_int_base<8, false>>);
+
+TEST(ApIntTest, NarrowValuesWrapAroundAtTheirWidth) {
+  ap_uint<4> u = 15;
+  ++u;
+  EXPECT_EQ(u, 0);
+  ap_int<4> s = 7;
+  ++s;
+  EXPECT_EQ(s, -8);
+  EXPECT_EQ(s.to_int(), -8);
+  EXPECT_TRUE(s.is_neg());
+  EXPECT_EQ(ap_uint<4>(s), 8);
+
+  const ap_uint<8> a = 200;
+  const ap_uint<8> b = 100;
+  const ap_uint<16> sum = a + b;
+  EXPECT_EQ(sum, 300);
+  EXPECT_EQ(ap_uint<8>(a + b), 44);
+  EXPECT_EQ(ap_int<8>(a) * 2, -112);
+  EXPECT_LT(ap_int<8>(-1), ap_uint<8>(0));
+  EXPECT_GT(ap_uint<64>(~uint64_t{0}), -1);
+}
+
+TEST(ApIntTest, WideArithmeticCarriesAcrossWords) {
+  ap_uint<128> x = ~uint64_t{0};
+  x += 1;
+  EXPECT_EQ(x.to_uint64(), 0);
+  EXPECT_EQ((x >> 64).to_uint64(), 1);
+  x -= 1;
+  EXPECT_EQ(x, ~uint64_t{0});
+
+  const ap_uint<256> y = ap_uint<256>(x) * x;
+  EXPECT_EQ(y.to_string(16), "0xfffffffffffffffe0000000000000001");
+  EXPECT_EQ(ap_uint<256>(y / x), x);
+  EXPECT_EQ(ap_uint<256>(y % x), 0);
+  EXPECT_EQ(ap_uint<256>((y + 5) % x), 5);
+
+  const ap_int<200> negative = -ap_int<200>(x);
+  EXPECT_TRUE(negative.is_neg());
+  EXPECT_EQ(ap_int<200>(negative / 3).to_string(10),
+            "-6148914691236517205");
+  EXPECT_EQ(ap_int<200>(negative % 7).to_int(), -1);
+  EXPECT_LT(negative, 0);
+  EXPECT_EQ(negative.to_double(), -18446744073709551615.);
+}
+
+TEST(ApIntTest, ShiftsMoveBitsAcrossWords) {
+  ap_uint<512> x = 1;
+  x <<= 300;
+  EXPECT_TRUE(x[300]);
+  EXPECT_EQ(x.countLeadingZeros(), 211);
+  EXPECT_EQ((x >> 299).to_uint(), 2);
+  EXPECT_EQ(x << 212, 0);
+
+  ap_int<100> s = -1;
+  s <<= 70;
+  EXPECT_EQ((s >> 68).to_int(), -4);
+  EXPECT_EQ((s >> 1000).to_int(), -1);
+  EXPECT_EQ((s << -70).to_int(), -1);
+
+  ap_uint<8> r = 0x81;
+  r.lrotate(1);
+  EXPECT_EQ(r, 0x03);
+  r.rrotate(2);
+  EXPECT_EQ(r, 0xc0);
+}
+
+TEST(ApIntTest, RangesAndBitsReadAndWriteInPlace) {
+  ap_uint<512> x;
+  x.range(95, 32) = 0x0123456789abcdefULL;
+  EXPECT_EQ(x.range(63, 32).to_uint(), 0x89abcdefU);
+  EXPECT_EQ(x(95, 64).to_uint(), 0x01234567U);
+  EXPECT_EQ(x.range(95, 32).length(), 64);
+  x.range(511, 448) = x.range(95, 32);
+  EXPECT_EQ((x >> 448).to_uint64(), 0x0123456789abcdefULL);
+
+  x[0] = 1;
+  x.bit(1) = x[0];
+  EXPECT_EQ(x.range(3, 0), 3);
+  x.set_bit(0, false);
+  EXPECT_EQ(x.range(3, 0), 2);
+
+  ap_int<8> s = 0;
+  s.range(7, 4) = 0xf;
+  EXPECT_EQ(s, -16);
+  EXPECT_EQ(s.range(7, 4) + 1, 16);
+
+  ap_uint<8> reversed = 0x01;
+  EXPECT_EQ(reversed.range(0, 7), 0x80);
+  reversed.reverse();
+  EXPECT_EQ(reversed, 0x80);
+}
+
+TEST(ApIntTest, ReductionsAndConcatenationCoverAllBits) {
+  ap_uint<130> x = ~ap_uint<130>(0);
+  EXPECT_TRUE(x.and_reduce());
+  EXPECT_FALSE(x.xor_reduce());
+  x[129] = 0;
+  EXPECT_FALSE(x.and_reduce());
+  EXPECT_TRUE(x.xor_reduce());
+  EXPECT_TRUE(x.or_reduce());
+
+  const ap_uint<64> hi = 0x1234;
+  const ap_uint<64> lo = 0x5678;
+  const ap_uint<128> cat = (hi, lo);
+  EXPECT_EQ(cat.range(127, 64), 0x1234);
+  EXPECT_EQ(cat.range(63, 0), 0x5678);
+}
+
+TEST(ApIntTest, ConvertsFromAndToText) {
+  EXPECT_EQ(ap_uint<8>("0x7f"), 127);
+  EXPECT_EQ(ap_uint<8>("101", 2), 5);
+  EXPECT_EQ(ap_int<8>("-12"), -12);
+  const ap_uint<256> big("0x100000000000000000000000000000000");
+  EXPECT_EQ(big.countLeadingZeros(), 127);
+  EXPECT_EQ(big.to_string(10), "340282366920938463463374607431768211456");
+  EXPECT_EQ(ap_int<8>(-5).to_string(2), "-0b101");
+  EXPECT_EQ(ap_uint<8>(1e3), 232);
+  EXPECT_EQ(ap_uint<128>(0x1p100).countLeadingZeros(), 27);
+
+  std::ostringstream os;
+  os << ap_int<16>(-300) << ' ' << std::hex << ap_uint<96>(255);
+  EXPECT_EQ(os.str(), "-300 ff");
+}
+
+}  // namespace
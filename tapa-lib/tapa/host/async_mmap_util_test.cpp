@@ -0,0 +1,233 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/async_mmap_util.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tapa.h"
+
+namespace tapa {
+namespace {
+
+constexpr int kN = 1000;
+
+void Load(tapa::async_mmap<int>& mem, int64_t n, tapa::ostream<int>& data_out) {
+  tapa::read_sequential(mem, 1, n, data_out);
+}
+
+void Store(tapa::istream<int>& data_in, tapa::async_mmap<int>& mem,
+           int64_t n) {
+  tapa::write_sequential(mem, 1, n, data_in);
+}
+
+void Gather(tapa::async_mmap<int>& mem, tapa::istream<int64_t>& addr_in,
+            tapa::ostream<int>& data_out) {
+  tapa::gather(mem, addr_in, data_out);
+}
+
+void GatherCached(tapa::async_mmap<int>& mem, tapa::istream<int64_t>& addr_in,
+                  tapa::ostream<int>& data_out) {
+  tapa::gather_cached</*kLines=*/16, /*kMaxOutstanding=*/4>(mem, addr_in,
+                                                           data_out);
+}
+
+void CacheRead(tapa::async_mmap<int>& mem, tapa::istream<int64_t>& addr_in,
+               tapa::ostream<int>& data_out,
+               tapa::ostream<tapa::cache_stats>& stats_out) {
+  // A single request in flight makes the hit and miss counts deterministic.
+  tapa::cache_read</*kSets=*/4, /*kWays=*/2, tapa::cache_storage::bram,
+                   /*kMaxOutstanding=*/1>(mem, addr_in, data_out, stats_out);
+}
+
+void Scatter(tapa::async_mmap<int>& mem,
+             tapa::istream<tapa::packet<int64_t, int>>& req_in) {
+  tapa::scatter(mem, req_in);
+}
+
+void Spill(tapa::async_mmap<int>& mem, int64_t capacity, tapa::istream<int>& in,
+           tapa::ostream<int>& out) {
+  tapa::spill</*kMaxOutstanding=*/4>(mem, capacity, in, out);
+}
+
+void Send(const std::vector<int64_t>& addrs, tapa::ostream<int64_t>& addr_out) {
+  for (int64_t addr : addrs) addr_out.write(addr);
+  addr_out.close();
+}
+
+void Receive(tapa::istream<int>& data_in, std::vector<int>* values) {
+  TAPA_WHILE_NOT_EOT(data_in) { values->push_back(data_in.read(nullptr)); }
+  data_in.open();
+}
+
+// Writes `n` elements, and signals `ahead_out` once the first `ahead` are
+// written.
+void ProduceAhead(int ahead, int n, tapa::ostream<int>& out,
+                  tapa::ostream<bool>& ahead_out) {
+  for (int i = 0; i < n; ++i) {
+    if (i == ahead) ahead_out.write(true);
+    out.write(i);
+  }
+  out.close();
+}
+
+// Starts reading `data_in` once its producer has run ahead.
+void ReceiveBehind(tapa::istream<bool>& ahead_in, tapa::istream<int>& data_in,
+                   std::vector<int>* values) {
+  ahead_in.read();
+  Receive(data_in, values);
+}
+
+void ReceiveStats(tapa::istream<tapa::cache_stats>& stats_in,
+                  tapa::cache_stats* stats) {
+  *stats = stats_in.read();
+}
+
+void SendPackets(const std::vector<int64_t>& addrs,
+                 tapa::ostream<tapa::packet<int64_t, int>>& req_out) {
+  for (int i = 0; i < int(addrs.size()); ++i) req_out.write({addrs[i], i});
+  req_out.close();
+}
+
+// Returns requests with runs of the same address and addresses read again
+// later.
+std::vector<int64_t> GetAddrs() {
+  std::vector<int64_t> addrs;
+  for (int64_t i = 0; i < kN; ++i) {
+    for (int64_t j = 0; j <= i % 3; ++j) addrs.push_back(i * 7 % 50);
+  }
+  return addrs;
+}
+
+TEST(AsyncMmapUtilTest, SequentialCopyKeepsOrder) {
+  std::vector<int> src(kN + 1), dst(kN + 1, -1);
+  for (int i = 0; i <= kN; ++i) src[i] = i * 3;
+  tapa::mmap<int> src_mmap(src), dst_mmap(dst);
+  tapa::stream<int, 2> data_q("data");
+  tapa::task()
+      .invoke(Load, src_mmap, kN, data_q)
+      .invoke(Store, data_q, dst_mmap, kN);
+  EXPECT_EQ(dst[0], -1);
+  for (int i = 1; i <= kN; ++i) EXPECT_EQ(dst[i], i * 3) << i;
+}
+
+TEST(AsyncMmapUtilTest, GatherReadsEachAddressInOrder) {
+  std::vector<int> src(50);
+  for (int i = 0; i < 50; ++i) src[i] = i * 3;
+  const std::vector<int64_t> addrs = GetAddrs();
+  std::vector<int> values;
+  tapa::mmap<int> src_mmap(src);
+  tapa::stream<int64_t, 2> addr_q("addr");
+  tapa::stream<int, 2> data_q("data");
+  tapa::task()
+      .invoke(Send, addrs, addr_q)
+      .invoke(Gather, src_mmap, addr_q, data_q)
+      .invoke(Receive, data_q, &values);
+  ASSERT_EQ(values.size(), addrs.size());
+  for (size_t i = 0; i < addrs.size(); ++i) {
+    EXPECT_EQ(values[i], addrs[i] * 3) << i;
+  }
+}
+
+TEST(AsyncMmapUtilTest, CachedGatherReadsEachAddressInOrder) {
+  std::vector<int> src(50);
+  for (int i = 0; i < 50; ++i) src[i] = i * 3;
+  const std::vector<int64_t> addrs = GetAddrs();
+  std::vector<int> values;
+  tapa::mmap<int> src_mmap(src);
+  tapa::stream<int64_t, 2> addr_q("addr");
+  tapa::stream<int, 2> data_q("data");
+  tapa::task()
+      .invoke(Send, addrs, addr_q)
+      .invoke(GatherCached, src_mmap, addr_q, data_q)
+      .invoke(Receive, data_q, &values);
+  ASSERT_EQ(values.size(), addrs.size());
+  for (size_t i = 0; i < addrs.size(); ++i) {
+    EXPECT_EQ(values[i], addrs[i] * 3) << i;
+  }
+}
+
+// Returns the hit and miss counts of reading `addrs` through `CacheRead`.
+tapa::cache_stats ReadThroughCache(const std::vector<int64_t>& addrs) {
+  std::vector<int> src(50);
+  for (int i = 0; i < 50; ++i) src[i] = i * 3;
+  std::vector<int> values;
+  tapa::cache_stats stats{-1, -1};
+  tapa::mmap<int> src_mmap(src);
+  tapa::stream<int64_t, 2> addr_q("addr");
+  tapa::stream<int, 2> data_q("data");
+  tapa::stream<tapa::cache_stats, 2> stats_q("stats");
+  tapa::task()
+      .invoke(Send, addrs, addr_q)
+      .invoke(CacheRead, src_mmap, addr_q, data_q, stats_q)
+      .invoke(Receive, data_q, &values)
+      .invoke(ReceiveStats, stats_q, &stats);
+  EXPECT_EQ(values.size(), addrs.size());
+  for (size_t i = 0; i < addrs.size() && i < values.size(); ++i) {
+    EXPECT_EQ(values[i], addrs[i] * 3) << i;
+  }
+  return stats;
+}
+
+TEST(AsyncMmapUtilTest, CacheReadMissesOncePerAddressThatFits) {
+  std::vector<int64_t> addrs;
+  for (int i = 0; i < kN; ++i) addrs.push_back(i % 8);
+  const tapa::cache_stats stats = ReadThroughCache(addrs);
+  EXPECT_EQ(stats.misses, 8);
+  EXPECT_EQ(stats.hits, kN - 8);
+}
+
+TEST(AsyncMmapUtilTest, CacheReadKeepsConflictingAddressesInWays) {
+  std::vector<int64_t> addrs;
+  for (int i = 0; i < kN; ++i) addrs.push_back(i % 2 * 4);  // Same set.
+  const tapa::cache_stats stats = ReadThroughCache(addrs);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.hits, kN - 2);
+}
+
+TEST(AsyncMmapUtilTest, CacheReadEvictsWaysInRoundRobin) {
+  std::vector<int64_t> addrs;
+  for (int i = 0; i < kN; ++i) addrs.push_back(i % 3 * 4);  // Same set.
+  const tapa::cache_stats stats = ReadThroughCache(addrs);
+  EXPECT_EQ(stats.misses, kN);
+  EXPECT_EQ(stats.hits, 0);
+}
+
+TEST(AsyncMmapUtilTest, ScatterKeepsLastWriteToEachAddress) {
+  const std::vector<int64_t> addrs = GetAddrs();
+  std::vector<int> dst(50, -1);
+  tapa::mmap<int> dst_mmap(dst);
+  tapa::stream<tapa::packet<int64_t, int>, 2> req_q("req");
+  tapa::task()
+      .invoke(SendPackets, addrs, req_q)
+      .invoke(Scatter, dst_mmap, req_q);
+  std::vector<int> expected(50, -1);
+  for (int i = 0; i < int(addrs.size()); ++i) expected[addrs[i]] = i;
+  EXPECT_EQ(dst, expected);
+}
+
+TEST(AsyncMmapUtilTest, SpillKeepsOrderThroughMemory) {
+  std::vector<int> ring(100, -1);
+  tapa::mmap<int> ring_mmap(ring);
+  tapa::stream<int, 2> in_q("in");
+  tapa::stream<int, 2> out_q("out");
+  tapa::stream<bool, 1> ahead_q("ahead");
+  std::vector<int> values;
+  // The consumer waits until the ring is almost full, and the rest of the
+  // elements wrap around it.
+  tapa::task()
+      .invoke(ProduceAhead, ring.size(), kN, in_q, ahead_q)
+      .invoke(Spill, ring_mmap, ring.size(), in_q, out_q)
+      .invoke(ReceiveBehind, ahead_q, out_q, &values);
+  std::vector<int> expected(kN);
+  for (int i = 0; i < kN; ++i) expected[i] = i;
+  EXPECT_EQ(values, expected);
+  EXPECT_NE(ring.back(), -1);
+}
+
+}  // namespace
+}  // namespace tapa
@@ -0,0 +1,147 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/channel_stats.h"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "tapa/host/internal_util.h"
+
+namespace tapa::internal {
+
+namespace {
+
+uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+const char* get_report_path() {
+  const char* path = getenv("TAPA_STREAM_STATS");
+  return path == nullptr || *path == '\0' ? nullptr : path;
+}
+
+bool is_depth_check_enabled() {
+  const char* env = getenv("TAPA_STREAM_DEPTH_CHECK");
+  return env != nullptr && std::string_view(env) != "0";
+}
+
+// Statistics created since the last report.
+std::mutex registry_mtx;
+std::vector<std::shared_ptr<channel_stats>> registry;
+
+}  // namespace
+
+std::shared_ptr<channel_stats> channel_stats::New(const std::string& name) {
+  const bool is_reported = get_report_path() != nullptr;
+  if (!is_reported && !is_depth_check_enabled()) return nullptr;
+  auto stats = std::make_shared<channel_stats>(name);
+  if (is_reported) {
+    std::unique_lock lock(registry_mtx);
+    registry.push_back(stats);
+  }
+  return stats;
+}
+
+void channel_stats::WriteReport() {
+  const char* path = get_report_path();
+  if (path == nullptr) return;
+
+  std::vector<std::shared_ptr<channel_stats>> stats;
+  {
+    std::unique_lock lock(registry_mtx);
+    stats.swap(registry);
+  }
+
+  const uint64_t end_ns = now_ns();
+  std::ofstream ofs(path);
+  ofs << "{\n  \"channels\": [";
+  for (size_t i = 0; i < stats.size(); ++i) {
+    ofs << (i == 0 ? "\n    " : ",\n    ");
+    stats[i]->write(ofs, end_ns);
+  }
+  ofs << "\n  ]\n}\n";
+  if (ofs.fail()) {
+    LOG(ERROR) << "failed to write channel statistics to '" << path << "'";
+  } else {
+    LOG(INFO) << "channel statistics are written to '" << path << "'";
+  }
+}
+
+channel_stats::channel_stats(const std::string& name)
+    : name_(name),
+      start_ns_(now_ns()),
+      last_push_ns_(start_ns_),
+      last_pop_ns_(start_ns_) {}
+
+void channel_stats::set_synthesis_depth(uint64_t depth) {
+  if (is_depth_check_enabled()) this->checked_depth_ = depth;
+}
+
+void channel_stats::count_push(uint64_t n) {
+  const uint64_t now = now_ns();
+  this->push_area_ += double(this->pushes_) * (now - this->last_push_ns_);
+  this->last_push_ns_ = now;
+  this->pushes_ += n;
+  // `pops_` may be stale, which only overestimates the occupancy, but never
+  // beyond what the queue can hold.
+  const uint64_t occupancy = std::min(
+      this->pushes_ - this->pops_.load(std::memory_order_relaxed),
+      this->depth_);
+  if (occupancy > this->checked_depth_ &&
+      this->max_occupancy_ <= this->checked_depth_) {
+    LOG(WARNING) << "channel '" << this->name_ << "' holds " << occupancy
+                 << " tokens, more than its depth " << this->checked_depth_
+                 << " in hardware, where its producer would block and may "
+                    "deadlock the design";
+  }
+  this->max_occupancy_ = std::max(this->max_occupancy_, occupancy);
+}
+
+void channel_stats::count_pop(uint64_t n) {
+  const uint64_t now = now_ns();
+  const uint64_t pops = this->pops_.load(std::memory_order_relaxed);
+  this->pop_area_ += double(pops) * (now - this->last_pop_ns_);
+  this->last_pop_ns_ = now;
+  this->pops_.store(pops + n, std::memory_order_relaxed);
+}
+
+void channel_stats::write(std::ostream& os, uint64_t end_ns) const {
+  const uint64_t pops = this->pops_.load(std::memory_order_relaxed);
+  const double push_area =
+      this->push_area_ + double(this->pushes_) * (end_ns - this->last_push_ns_);
+  const double pop_area =
+      this->pop_area_ + double(pops) * (end_ns - this->last_pop_ns_);
+  const uint64_t duration_ns = std::max<uint64_t>(end_ns - this->start_ns_, 1);
+
+  // Counters of the peers are updated after the queue operations, so the
+  // occupancy may be overestimated if both run in parallel, but never beyond
+  // what the queue can hold.
+  const uint64_t max_occupancy = std::min(this->max_occupancy_, this->depth_);
+  const double avg_occupancy =
+      std::min((push_area - pop_area) / duration_ns, double(this->depth_));
+
+  os << "{\"name\": ";
+  WriteJsonString(os, this->name_);
+  os << ", \"depth\": " << this->depth_ << ", \"pushes\": " << this->pushes_
+     << ", \"pops\": " << pops << ", \"max_occupancy\": " << max_occupancy
+     << ", \"avg_occupancy\": " << avg_occupancy
+     << ", \"full_stalls\": " << this->full_stalls_
+     << ", \"empty_stalls\": " << this->empty_stalls_ << "}";
+}
+
+}  // namespace tapa::internal
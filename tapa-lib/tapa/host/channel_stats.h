@@ -0,0 +1,92 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef TAPA_HOST_CHANNEL_STATS_H_
+#define TAPA_HOST_CHANNEL_STATS_H_
+
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "tapa/base/stream.h"
+
+namespace tapa::internal {
+
+// Runtime statistics of a channel in software simulation. Enabled by
+// `TAPA_STREAM_STATS=<path>`, in which case statistics of all channels are
+// written to `path` as a JSON report when the top-level task finishes.
+//
+// Also enabled by `TAPA_STREAM_DEPTH_CHECK=1`, in which case a warning is
+// logged once for each channel that holds more tokens than its synthesis
+// depth, which is possible if its simulation depth is larger, e.g., scaled by
+// `TAPA_STREAM_DEPTH_SCALE`. In hardware, its producer would block instead,
+// which may deadlock the design.
+//
+// Each counter is updated only by either the producer or the consumer, so
+// that no synchronization is needed beyond reading `pops` when pushing.
+class channel_stats {
+ public:
+  // Returns `nullptr` unless statistics are enabled. Otherwise, returns new
+  // statistics that are included in the next report.
+  static std::shared_ptr<channel_stats> New(const std::string& name);
+
+  // Writes the report of statistics created since the last report, if
+  // enabled. The report lists the following keys of each channel:
+  //
+  // - `max_occupancy` is the number of tokens in the channel after a push at
+  //   most, which is the minimum depth that never blocks the producer.
+  // - `avg_occupancy` is the number of tokens in the channel averaged over
+  //   time since the channel is created.
+  // - `full_stalls` and `empty_stalls` are the number of times the producer
+  //   and the consumer find the channel full or empty, respectively.
+  static void WriteReport();
+
+  explicit channel_stats(const std::string& name);
+
+  // Not copyable or movable.
+  channel_stats(const channel_stats&) = delete;
+  channel_stats& operator=(const channel_stats&) = delete;
+
+  void set_name(const std::string& name) { this->name_ = name; }
+  void set_depth(uint64_t depth) { this->depth_ = depth; }
+  void set_synthesis_depth(uint64_t depth);
+
+  // Called by the producer.
+  void count_push(uint64_t n);
+  void count_full_stall() { ++this->full_stalls_; }
+
+  // Called by the consumer.
+  void count_pop(uint64_t n);
+  void count_empty_stall() { ++this->empty_stalls_; }
+
+  // Writes the statistics as a JSON object, when neither peer is active.
+  void write(std::ostream& os, uint64_t end_ns) const;
+
+ private:
+  std::string name_;
+  const uint64_t start_ns_;
+  uint64_t depth_ = kStreamInfiniteDepth;
+  uint64_t checked_depth_ = kStreamInfiniteDepth;  // Unchecked by default.
+
+  // Updated by the producer. `push_area_` is the integral of `pushes_` over
+  // time till `last_push_ns_`, in token-nanoseconds.
+  uint64_t pushes_ = 0;
+  uint64_t max_occupancy_ = 0;
+  uint64_t full_stalls_ = 0;
+  double push_area_ = 0;
+  uint64_t last_push_ns_;
+
+  // Updated by the consumer, similarly.
+  std::atomic<uint64_t> pops_{0};
+  uint64_t empty_stalls_ = 0;
+  double pop_area_ = 0;
+  uint64_t last_pop_ns_;
+};
+
+}  // namespace tapa::internal
+
+#endif  // TAPA_HOST_CHANNEL_STATS_H_
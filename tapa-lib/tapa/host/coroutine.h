@@ -5,13 +5,229 @@
 #ifndef TAPA_HOST_COROUTINE_H_
 #define TAPA_HOST_COROUTINE_H_
 
+#include <cstddef>
+
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <new>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace tapa {
 namespace internal {
-void schedule(bool detach, const std::function<void()>&);
-void yield(const std::string& msg);
+
+// Identifies the channels a task argument refers to. The scheduler places
+// tasks that share channels close to each other. Specialized by channel types.
+template <typename T, typename = void>
+struct channel_traits {
+  static void collect(const T& arg, std::vector<const void*>& channels) {}
+};
+
+// A move-only `void()` callable. Unlike `std::function`, it never copies the
+// callable, so that scheduling a task does not copy its arguments. Callables
+// of up to `kInlineSize` bytes are stored inline without allocation.
+class unique_function {
+ public:
+  static constexpr size_t kInlineSize = 128;
+
+  unique_function() = default;
+
+  template <typename F, typename Func = std::decay_t<F>,
+            typename = std::enable_if_t<!std::is_same_v<Func, unique_function>>>
+  unique_function(F&& f) {
+    if constexpr (is_inline<Func>) {
+      new (storage_) Func(std::forward<F>(f));
+    } else {
+      *reinterpret_cast<Func**>(storage_) = new Func(std::forward<F>(f));
+    }
+    ops_ = &ops_for<Func>;
+  }
+
+  unique_function(unique_function&& other) noexcept {
+    *this = std::move(other);
+  }
+
+  unique_function& operator=(unique_function&& other) noexcept {
+    if (this != &other) {
+      reset();
+      if (other.ops_ != nullptr) {
+        other.ops_->move(storage_, other.storage_);
+        ops_ = std::exchange(other.ops_, nullptr);
+      }
+    }
+    return *this;
+  }
+
+  // Not copyable.
+  unique_function(const unique_function&) = delete;
+  unique_function& operator=(const unique_function&) = delete;
+
+  ~unique_function() { reset(); }
+
+  void operator()() { ops_->call(storage_); }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+ private:
+  struct ops_t {
+    void (*call)(void* storage);
+    // Move-constructs into `dst` and destroys the callable in `src`.
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void* storage);
+  };
+
+  template <typename Func>
+  static constexpr bool is_inline =
+      sizeof(Func) <= kInlineSize &&
+      alignof(Func) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<Func>;
+
+  template <typename Func>
+  static Func& get(void* storage) {
+    if constexpr (is_inline<Func>) {
+      return *std::launder(reinterpret_cast<Func*>(storage));
+    } else {
+      return **reinterpret_cast<Func**>(storage);
+    }
+  }
+
+  template <typename Func>
+  static void call(void* storage) {
+    get<Func>(storage)();
+  }
+
+  template <typename Func>
+  static void move(void* dst, void* src) {
+    if constexpr (is_inline<Func>) {
+      new (dst) Func(std::move(get<Func>(src)));
+      get<Func>(src).~Func();
+    } else {
+      *reinterpret_cast<Func**>(dst) = *reinterpret_cast<Func**>(src);
+    }
+  }
+
+  template <typename Func>
+  static void destroy(void* storage) {
+    if constexpr (is_inline<Func>) {
+      get<Func>(storage).~Func();
+    } else {
+      delete &get<Func>(storage);
+    }
+  }
+
+  template <typename Func>
+  static constexpr ops_t ops_for = {call<Func>, move<Func>, destroy<Func>};
+
+  void reset() {
+    if (ops_ != nullptr) std::exchange(ops_, nullptr)->destroy(storage_);
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+  const ops_t* ops_ = nullptr;
+};
+
+// Describes a task to schedule.
+struct task_info {
+  // Channels used by the task; see `channel_traits`.
+  std::vector<const void*> channels;
+
+  // Address of the task function, or `nullptr` if the task is not a function.
+  const void* func = nullptr;
+
+  // Name passed to `tapa::task::invoke`, if any.
+  std::string_view label;
+};
+
+// Runs `f` as a task. `f` is moved along until it runs, and is never copied.
+void schedule(bool detach, unique_function f, const task_info& info = {});
+
+// Whether the calling detached task is cancelled, i.e., no joined task is
+// connected to it through channels any more. A cancelled task may return once
+// it has nothing left to do, instead of polling until the top-level task
+// finishes. Cancellation is withdrawn if a joined task connects to it again.
+bool is_cancelled();
+
+// Whether all tasks run on one thread in a deterministic order, which is
+// enabled by `TAPA_ENGINE=deterministic` or `TAPA_ENGINE=static`. Channels need
+// no synchronization if so.
+bool is_deterministic();
+
+// Whether joined tasks run to completion as soon as they are invoked, which is
+// enabled by `TAPA_ENGINE=static`. Channels must be unbounded if so.
+bool is_statically_scheduled();
+
+// Returns the name of the calling task instance, `<task>/<instance>`, if it
+// runs as a coroutine, or null otherwise.
+const std::string* get_coroutine_name();
+
+// Why a task yields. The message is only built if needed, e.g., when
+// debugging, so that yielding does not allocate.
+class yield_reason {
+ public:
+  enum kind_t { kOther, kChannelEmpty, kChannelFull };
+
+  // `msg` or `name` must outlive this object.
+  yield_reason(const char* msg) : msg_(msg) {}
+  yield_reason(const std::string& msg) : msg_(msg.c_str()) {}
+  yield_reason(kind_t kind, const void* channel, const std::string& name)
+      : kind_(kind), channel_(channel), name_(&name) {}
+
+  kind_t kind() const { return kind_; }
+
+  // Channel the task waits on, as identified by `channel_traits`, if any.
+  const void* channel() const { return channel_; }
+
+  std::string str() const {
+    if (name_ == nullptr) return msg_;
+    return "channel '" + *name_ +
+           (kind_ == kChannelEmpty ? "' is empty" : "' is full");
+  }
+
+ private:
+  kind_t kind_ = kOther;
+  const char* msg_ = nullptr;
+  const void* channel_ = nullptr;
+  const std::string* name_ = nullptr;
+};
+
+void yield(const yield_reason& reason);
+
+// Coroutines and threads blocked until some state (e.g., whether a channel is
+// empty) changes. Blocked coroutines are parked by the scheduler and are not
+// resumed until `notify` is called.
+class wait_queue {
+ public:
+  wait_queue();
+  ~wait_queue();
+
+  // Not copyable or movable.
+  wait_queue(const wait_queue&) = delete;
+  wait_queue& operator=(const wait_queue&) = delete;
+
+  // Blocks the caller until `ready` returns true. `ready` is re-evaluated
+  // every time `notify` is called. `reason` is logged when debugging.
+  void wait(const std::function<bool()>& ready, const yield_reason& reason);
+
+  // Wakes up all callers blocked in `wait`. Must be called after the state
+  // checked by `ready` may have changed. This is cheap if nobody is blocked.
+  void notify() {
+    if (waiter_count_ > 0) notify_all();
+  }
+
+  // Defined by the scheduler.
+  struct impl;
+
+ private:
+  void notify_all();
+
+  const std::unique_ptr<impl> impl_;
+  std::atomic<int> waiter_count_{0};
+};
+
 }  // namespace internal
 }  // namespace tapa
 
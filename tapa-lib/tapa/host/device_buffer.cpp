@@ -0,0 +1,67 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/device_buffer.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include <frt.h>
+
+namespace tapa {
+namespace internal {
+
+namespace {
+
+struct resident_instance {
+  explicit resident_instance(const std::string& bitstream)
+      : instance(bitstream) {}
+
+  std::mutex mtx;  // Held by the running invocation.
+  fpga::Instance instance;
+  // Host memory of device buffers bound to each argument.
+  std::unordered_map<int, std::shared_ptr<const void>> storages;
+};
+
+std::mutex resident_mtx;
+std::map<std::string, std::unique_ptr<resident_instance>> resident_instances;
+
+}  // namespace
+
+fpga::Instance& get_resident_instance(const std::string& bitstream,
+                                      std::unique_lock<std::mutex>& lock) {
+  resident_instance* resident;
+  {
+    std::unique_lock resident_lock(resident_mtx);
+    auto& ptr = resident_instances[bitstream];
+    if (ptr == nullptr) {
+      LOG(INFO) << "keeping '" << bitstream
+                << "' loaded for device buffers until exit";
+      ptr = std::make_unique<resident_instance>(bitstream);
+    }
+    resident = ptr.get();
+  }
+  lock = std::unique_lock(resident->mtx);
+  return resident->instance;
+}
+
+void bind_device_buffer(fpga::Instance& instance, int index,
+                        std::shared_ptr<const void> storage) {
+  std::unique_lock lock(resident_mtx);
+  for (auto& [bitstream, resident] : resident_instances) {
+    if (&resident->instance == &instance) {
+      resident->storages[index] = std::move(storage);
+      return;
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace tapa
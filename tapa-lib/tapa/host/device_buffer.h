@@ -0,0 +1,109 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef TAPA_HOST_DEVICE_BUFFER_H_
+#define TAPA_HOST_DEVICE_BUFFER_H_
+
+#include <cstdint>
+
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <frt.h>
+
+#include "tapa/host/allocator.h"
+#include "tapa/host/mmap.h"
+#include "tapa/host/task.h"
+
+namespace tapa {
+
+/// Memory that stays on the device across @c tapa::invoke calls.
+///
+/// A @c tapa::device_buffer is passed to @c tapa::invoke in place of an
+/// @c tapa::mmap. The first invocation copies its content to the device, and
+/// later invocations of the same bitstream reuse the device copy, including
+/// what the kernel wrote to it, without transferring it again. To keep the
+/// device memory, the bitstream stays loaded until the process exits once it
+/// is invoked with a device buffer. This suits data that seldom change, e.g.,
+/// the weights of a model served by many invocations:
+///
+/// @code{.cpp}
+///  tapa::device_buffer<const float> weights(host_weights);
+///  for (const auto& request : requests) {
+///    tapa::invoke(Infer, bitstream, weights,
+///                 tapa::read_only_mmap<const float>(request.input),
+///                 tapa::write_only_mmap<float>(request.output));
+///  }
+/// @endcode
+///
+/// Copies of a @c tapa::device_buffer refer to the same memory. Software
+/// simulation and cosimulation keep the content in host memory, so they
+/// behave the same. @c tapa::invoke_in_new_process does not keep the device
+/// memory for later invocations.
+template <typename T>
+class device_buffer : public mmap<T> {
+  using storage_type = aligned_vector<std::remove_const_t<T>>;
+
+ public:
+  /// Constructs a device buffer of @c size value-initialized elements.
+  explicit device_buffer(uint64_t size)
+      : device_buffer(std::make_shared<storage_type>(size)) {}
+
+  /// Constructs a device buffer holding a copy of @c container.
+  ///
+  /// @param container Container of the initial content. Must implement
+  ///                  @c begin() and @c end().
+  template <typename Container,
+            typename = decltype(std::begin(std::declval<const Container&>()))>
+  explicit device_buffer(const Container& container)
+      : device_buffer(std::make_shared<storage_type>(std::begin(container),
+                                                     std::end(container))) {}
+
+  /// Returns the host memory that the device copy is initialized from.
+  std::shared_ptr<const void> storage() const { return storage_; }
+
+ private:
+  explicit device_buffer(std::shared_ptr<storage_type> storage)
+      : mmap<T>(storage->data(), storage->size()),
+        storage_(std::move(storage)) {}
+
+  std::shared_ptr<storage_type> storage_;
+};
+
+namespace internal {
+
+template <typename T>
+inline constexpr bool is_device_buffer_v<device_buffer<T>> = true;
+
+template <typename T>
+struct device_buffer_accessor {
+  static mmap<T> access(const device_buffer<T>& arg) { return arg; }
+  static void access(fpga::Instance& instance, int& idx,
+                     const device_buffer<T>& arg) {
+    bind_device_buffer(instance, idx, arg.storage());
+    instance.SetArg(idx++, fpga::InitOnce(arg.get(), arg.size()));
+  }
+  static void collect(const device_buffer<T>& arg,
+                      std::vector<memory_region>& regions) {
+    regions.push_back({arg.get(), arg.size() * sizeof(T)});
+  }
+};
+
+// Device buffers are usually passed by reference to be reused.
+template <typename T>
+struct accessor<mmap<T>, device_buffer<T>> : device_buffer_accessor<T> {};
+template <typename T>
+struct accessor<mmap<T>, device_buffer<T>&> : device_buffer_accessor<T> {};
+template <typename T>
+struct accessor<mmap<T>, const device_buffer<T>&>
+    : device_buffer_accessor<T> {};
+
+}  // namespace internal
+
+}  // namespace tapa
+
+#endif  // TAPA_HOST_DEVICE_BUFFER_H_
@@ -0,0 +1,51 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/device_buffer.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tapa.h"
+
+namespace tapa {
+namespace {
+
+constexpr int kN = 100;
+
+// Adds `weights` to `state`, and writes the result to `out`.
+void Step(tapa::mmap<const int> weights, tapa::mmap<int> state,
+          tapa::mmap<int> out) {
+  for (int i = 0; i < kN; ++i) {
+    state[i] += weights[i];
+    out[i] = state[i];
+  }
+}
+
+TEST(DeviceBufferTest, KeepsContentAcrossInvocations) {
+  std::vector<int> host_weights(kN);
+  for (int i = 0; i < kN; ++i) host_weights[i] = i;
+  device_buffer<const int> weights(host_weights);
+  device_buffer<int> state(kN);
+  host_weights.assign(kN, 0);  // The device buffer holds its own copy.
+
+  std::vector<int> out(kN);
+  for (int n = 1; n <= 3; ++n) {
+    tapa::invoke(Step, "", weights, state, tapa::write_only_mmap<int>(out));
+    for (int i = 0; i < kN; ++i) ASSERT_EQ(out[i], i * n) << i;
+  }
+}
+
+TEST(DeviceBufferTest, CopiesShareMemory) {
+  device_buffer<int> buffer(kN);
+  device_buffer<int> copy = buffer;
+  EXPECT_EQ(copy.get(), buffer.get());
+  EXPECT_EQ(copy.size(), kN);
+  static_assert(internal::is_device_buffer_v<device_buffer<int>>);
+  static_assert(!internal::is_device_buffer_v<mmap<int>>);
+}
+
+}  // namespace
+}  // namespace tapa
@@ -0,0 +1,392 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/fork_server.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif  // MAP_HUGE_SHIFT
+
+#ifndef MAP_HUGE_MASK
+#define MAP_HUGE_MASK 0x3f
+#endif  // MAP_HUGE_MASK
+
+#ifndef MFD_HUGE_SHIFT
+#define MFD_HUGE_SHIFT 26
+#endif  // MFD_HUGE_SHIFT
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif  // MAP_FIXED_NOREPLACE
+
+namespace tapa {
+namespace internal {
+
+namespace {
+
+constexpr int kProt = PROT_READ | PROT_WRITE;
+
+// Maximum number of file descriptors in one message, i.e., `SCM_MAX_FD`.
+constexpr size_t kMaxFds = 253;
+
+// Size of each message carrying the payload.
+constexpr size_t kChunkSize = 64 << 10;
+
+// Exit status of a child process that cannot map the shared memory.
+constexpr int kMapFailedStatus = 125;
+
+// Memory mapped by `map_shared_memory`.
+struct shared_region {
+  size_t length;
+  int fd;  // Backing memfd, or -1 if mapped before the fork server starts.
+};
+
+// Request of running `entry`, followed by the payload in chunks and the
+// regions in batches, each with the file descriptors of its regions.
+struct request {
+  fork_entry entry;
+  uint64_t payload_size;
+  uint64_t region_count;
+};
+
+// Memory region mapped by the child process from a file descriptor.
+struct region_request {
+  uintptr_t addr;
+  uint64_t length;
+  bool replace;  // Replaces a mapping inherited from the fork server.
+};
+
+struct response {
+  bool forked;
+  int status;
+  int64_t result;
+};
+
+// Serializes runs and guards `server_fd` and `owner_pid`.
+std::mutex run_mtx;
+int server_fd = -1;
+pid_t owner_pid = -1;
+
+// Whether new memory is backed by memfds to be passed to the fork server.
+std::atomic_bool started{false};
+
+// Guards `regions` and `inherited`.
+std::mutex mtx;
+std::map<uintptr_t, shared_region> regions;  // By start address.
+std::map<uintptr_t, shared_region> inherited;  // Mapped in the fork server.
+
+// Returns the region of `map` that contains `[addr, addr + size)`.
+std::map<uintptr_t, shared_region>::const_iterator find_region(
+    const std::map<uintptr_t, shared_region>& map, uintptr_t addr,
+    size_t size) {
+  auto it = map.upper_bound(addr);
+  if (it == map.begin()) return map.end();
+  --it;
+  if (addr + size > it->first + it->second.length) return map.end();
+  return it;
+}
+
+bool send_all(int fd, const void* data, size_t size) {
+  return send(fd, data, size, MSG_NOSIGNAL) == ssize_t(size);
+}
+
+bool recv_all(int fd, void* data, size_t size) {
+  return recv(fd, data, size, 0) == ssize_t(size);
+}
+
+// Sends `regions` and their file descriptors `fds` in one message.
+bool send_regions(int fd, const region_request* regions, const int* fds,
+                  size_t count) {
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * count));
+  iovec iov = {const_cast<region_request*>(regions),
+               sizeof(region_request) * count};
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.data();
+  msg.msg_controllen = control.size();
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+  std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+  return sendmsg(fd, &msg, MSG_NOSIGNAL) == ssize_t(iov.iov_len);
+}
+
+// Receives at most `kMaxFds` regions and appends them to `regions` and their
+// file descriptors to `fds`.
+bool recv_regions(int fd, std::vector<region_request>& regions,
+                  std::vector<int>& fds) {
+  std::vector<region_request> batch(kMaxFds);
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * kMaxFds));
+  iovec iov = {batch.data(), sizeof(region_request) * batch.size()};
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.data();
+  msg.msg_controllen = control.size();
+  const ssize_t size = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+  if (size <= 0 || size % sizeof(region_request) != 0) return false;
+  const size_t count = size / sizeof(region_request);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS ||
+      cmsg->cmsg_len != CMSG_LEN(sizeof(int) * count)) {
+    return false;
+  }
+  regions.insert(regions.end(), batch.begin(), batch.begin() + count);
+  const int* data = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+  fds.insert(fds.end(), data, data + count);
+  return true;
+}
+
+// Maps `regions` from `fds` in a child process of the fork server.
+bool map_regions(const std::vector<region_request>& regions,
+                 const std::vector<int>& fds) {
+  for (size_t i = 0; i < regions.size(); ++i) {
+    void* addr = reinterpret_cast<void*>(regions[i].addr);
+    const int flags =
+        MAP_SHARED | (regions[i].replace ? MAP_FIXED : MAP_FIXED_NOREPLACE);
+    // Kernels older than 4.17 take `addr` as a hint without
+    // `MAP_FIXED_NOREPLACE`, and may map somewhere else.
+    void* mapped = ::mmap(addr, regions[i].length, kProt, flags, fds[i], 0);
+    if (mapped != addr) return false;
+    close(fds[i]);
+  }
+  return true;
+}
+
+// Runs requests from `fd` until the connection is closed. The child processes
+// write what the entry returns to `result`.
+[[noreturn]] void serve(int fd, int64_t* result) {
+  for (request req; recv_all(fd, &req, sizeof(req));) {
+    std::string payload(req.payload_size, '\0');
+    bool ok = true;
+    for (size_t offset = 0; ok && offset < payload.size();
+         offset += kChunkSize) {
+      ok = recv_all(fd, payload.data() + offset,
+                    std::min(kChunkSize, payload.size() - offset));
+    }
+    std::vector<region_request> regions;
+    std::vector<int> fds;
+    while (ok && regions.size() < req.region_count) {
+      ok = recv_regions(fd, regions, fds);
+    }
+    if (!ok) break;
+
+    response resp = {};
+    if (const pid_t pid = fork(); pid == 0) {
+      // Child.
+      close(fd);
+      if (!map_regions(regions, fds)) _exit(kMapFailedStatus);
+      *result = req.entry(payload.data());
+      exit(EXIT_SUCCESS);
+    } else if (pid != -1) {
+      resp.forked = waitpid(pid, &resp.status, 0) == pid;
+      resp.result = *result;
+    }
+    for (int region_fd : fds) close(region_fd);
+    if (!send_all(fd, &resp, sizeof(resp))) break;
+  }
+  _exit(EXIT_SUCCESS);
+}
+
+// Stops using the fork server. Requires holding `run_mtx`.
+void stop_fork_server() {
+  close(server_fd);
+  server_fd = -1;
+  started = false;
+}
+
+}  // namespace
+
+void* map_shared_memory(size_t length, int flags) {
+  std::unique_lock lock(mtx);
+  if (!started) {
+    void* addr = ::mmap(nullptr, length, kProt,
+                        MAP_SHARED | MAP_ANONYMOUS | flags, /*fd=*/-1, 0);
+    if (addr != MAP_FAILED) {
+      regions[reinterpret_cast<uintptr_t>(addr)] = {length, /*fd=*/-1};
+    }
+    return addr;
+  }
+
+  // A file descriptor is needed to map the memory in the child processes.
+  unsigned int memfd_flags = MFD_CLOEXEC;
+  if (flags & MAP_HUGETLB) {
+    memfd_flags |= MFD_HUGETLB | (flags >> MAP_HUGE_SHIFT & MAP_HUGE_MASK)
+                                     << MFD_HUGE_SHIFT;
+    flags &= ~(MAP_HUGETLB | MAP_HUGE_MASK << MAP_HUGE_SHIFT);
+  }
+  const int fd = memfd_create("tapa", memfd_flags);
+  if (fd == -1) {
+    if (errno == EMFILE || errno == ENFILE) {
+      LOG_FIRST_N(WARNING, 1) << "too many open files; memory allocated from "
+                                 "now on is not shared with the fork server";
+      return ::mmap(nullptr, length, kProt, MAP_SHARED | MAP_ANONYMOUS | flags,
+                    /*fd=*/-1, 0);
+    }
+    return MAP_FAILED;
+  }
+  void* addr = MAP_FAILED;
+  if (ftruncate(fd, length) == 0) {
+    addr = ::mmap(nullptr, length, kProt, MAP_SHARED | flags, fd, 0);
+  }
+  if (addr == MAP_FAILED) {
+    const int error = errno;
+    close(fd);
+    errno = error;
+    return MAP_FAILED;
+  }
+  regions[reinterpret_cast<uintptr_t>(addr)] = {length, fd};
+  return addr;
+}
+
+bool unmap_shared_memory(void* addr, size_t length) {
+  std::unique_lock lock(mtx);
+  if (auto it = regions.find(reinterpret_cast<uintptr_t>(addr));
+      it != regions.end()) {
+    if (it->second.fd != -1) close(it->second.fd);
+    regions.erase(it);
+  }
+  return ::munmap(addr, length) == 0;
+}
+
+bool run_in_fork_server(fork_entry entry, const std::string& payload,
+                        const std::vector<memory_region>& memory,
+                        int64_t& result) {
+  std::unique_lock run_lock(run_mtx);
+  if (server_fd == -1 || owner_pid != getpid()) return false;
+
+  // Look up the regions to send with duplicated file descriptors, which stay
+  // open even if the memory is deallocated meanwhile.
+  std::vector<region_request> requests;
+  std::vector<int> fds;
+  {
+    std::unique_lock lock(mtx);
+    std::vector<uintptr_t> found;
+    for (const auto& [ptr, size] : memory) {
+      if (ptr == nullptr) continue;
+      const auto addr = reinterpret_cast<uintptr_t>(ptr);
+      auto it = find_region(regions, addr, std::max<size_t>(size, 1));
+      if (it == regions.end()) {
+        for (int fd : fds) close(fd);
+        LOG_FIRST_N(WARNING, 1)
+            << "memory at " << ptr << " is not allocated by "
+            << "tapa::aligned_allocator; forking this process instead of the "
+               "fork server";
+        return false;
+      }
+      if (it->second.fd == -1 ||
+          std::find(found.begin(), found.end(), it->first) != found.end()) {
+        continue;
+      }
+      found.push_back(it->first);
+      const bool replace = find_region(inherited, it->first,
+                                       it->second.length) != inherited.end();
+      requests.push_back({it->first, it->second.length, replace});
+      fds.push_back(dup(it->second.fd));
+      PCHECK(fds.back() != -1) << "dup";
+    }
+  }
+
+  const request req = {entry, payload.size(), requests.size()};
+  bool ok = send_all(server_fd, &req, sizeof(req));
+  for (size_t offset = 0; ok && offset < payload.size(); offset += kChunkSize) {
+    ok = send_all(server_fd, payload.data() + offset,
+                  std::min(kChunkSize, payload.size() - offset));
+  }
+  for (size_t i = 0; ok && i < requests.size(); i += kMaxFds) {
+    ok = send_regions(server_fd, &requests[i], &fds[i],
+                      std::min(kMaxFds, requests.size() - i));
+  }
+  for (int fd : fds) close(fd);
+  response resp;
+  if (!ok || !recv_all(server_fd, &resp, sizeof(resp))) {
+    PLOG(WARNING) << "fork server is gone; forking this process from now on";
+    stop_fork_server();
+    return false;
+  }
+  if (!resp.forked) {
+    LOG(WARNING) << "fork server cannot fork; forking this process instead";
+    return false;
+  }
+  if (WIFEXITED(resp.status) &&
+      WEXITSTATUS(resp.status) == kMapFailedStatus) {
+    LOG_FIRST_N(WARNING, 1) << "cannot map memory in the child process of the "
+                               "fork server; forking this process instead";
+    return false;
+  }
+  CHECK(WIFEXITED(resp.status));
+  CHECK_EQ(WEXITSTATUS(resp.status), EXIT_SUCCESS);
+  result = resp.result;
+  return true;
+}
+
+}  // namespace internal
+
+void start_fork_server() {
+  using namespace internal;
+  std::unique_lock run_lock(run_mtx);
+  if (server_fd != -1) {
+    if (owner_pid == getpid()) return;
+    close(server_fd);  // Inherited from the parent process.
+  }
+
+  int fds[2];
+  PCHECK(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) == 0)
+      << "socketpair";
+
+  // Mapped before `fork`, so that this process never maps memory at the same
+  // address, which the child processes would fail to map.
+  auto* result = static_cast<int64_t*>(::mmap(
+      nullptr, sizeof(int64_t), kProt, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+  PCHECK(result != MAP_FAILED) << "mmap";
+
+  // Hold `mtx` so that no memory is mapped during `fork`, and all of
+  // `regions` is inherited by the fork server.
+  std::unique_lock lock(mtx);
+  const pid_t parent = getpid();
+  const pid_t pid = fork();
+  PCHECK(pid != -1) << "fork";
+  if (pid == 0) {
+    lock.unlock();
+    run_lock.unlock();
+    close(fds[0]);
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != parent) _exit(EXIT_SUCCESS);
+    server_fd = -1;
+    started = false;
+    serve(fds[1], result);
+  }
+  close(fds[1]);
+  server_fd = fds[0];
+  owner_pid = parent;
+  inherited = regions;
+  started = true;
+  LOG(INFO) << "fork server started as process " << pid;
+}
+
+}  // namespace tapa
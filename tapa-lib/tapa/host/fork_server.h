@@ -0,0 +1,57 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef TAPA_HOST_FORK_SERVER_H_
+#define TAPA_HOST_FORK_SERVER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+namespace tapa {
+
+// Forks a helper process, from which `invoke_in_new_process` forks its child
+// processes instead of forking this process. Forking a process copies its page
+// tables, which is slow once the process holds a large heap, so call this early
+// in `main`, before allocating the data. Memory allocated by
+// `tapa::aligned_allocator` afterwards is mapped into the child processes at
+// the same addresses, and other memory is not; `invoke_in_new_process` forks
+// this process as before if any argument refers to other memory.
+void start_fork_server();
+
+namespace internal {
+
+// Host memory referred to by an argument of a kernel.
+struct memory_region {
+  const void* addr;
+  size_t size;
+};
+
+// Maps `length` bytes of memory shared with child processes. `flags` are
+// additional flags of `mmap`, e.g., `MAP_HUGETLB`. Returns `MAP_FAILED` on
+// failure.
+void* map_shared_memory(size_t length, int flags);
+
+// Unmaps memory returned by `map_shared_memory`. Returns whether it succeeds.
+bool unmap_shared_memory(void* addr, size_t length);
+
+// Entry of a child process of the fork server, which runs a kernel with
+// arguments serialized in `payload` and returns the kernel time.
+using fork_entry = int64_t (*)(const char* payload);
+
+// Runs `entry(payload.data())` in a child process of the fork server and sets
+// `result` to what it returns. `regions` must be shared with the child. Returns
+// false without running anything if the fork server is not started, or if it
+// cannot share `regions` with the child.
+bool run_in_fork_server(fork_entry entry, const std::string& payload,
+                        const std::vector<memory_region>& regions,
+                        int64_t& result);
+
+}  // namespace internal
+
+}  // namespace tapa
+
+#endif  // TAPA_HOST_FORK_SERVER_H_
@@ -0,0 +1,85 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/fork_server.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tapa/host/task.h"
+
+namespace tapa {
+namespace {
+
+using internal::allocate;
+using internal::deallocate;
+using internal::memory_region;
+using internal::run_in_fork_server;
+
+constexpr size_t kLength = 1 << 20;
+
+// Fills the memory at the pointers in `payload` with their indices, and
+// returns the number of pointers.
+int64_t Fill(const char* payload) {
+  int64_t count;
+  std::memcpy(&count, payload, sizeof(count));
+  for (int64_t i = 0; i < count; ++i) {
+    int64_t* ptr;
+    std::memcpy(&ptr, payload + sizeof(count) + sizeof(ptr) * i, sizeof(ptr));
+    ptr[0] = ptr[kLength / sizeof(int64_t) - 1] = i;
+  }
+  return count;
+}
+
+std::string Serialize(const std::vector<int64_t*>& ptrs) {
+  const int64_t count = ptrs.size();
+  std::string payload(reinterpret_cast<const char*>(&count), sizeof(count));
+  payload.append(reinterpret_cast<const char*>(ptrs.data()),
+                 sizeof(int64_t*) * ptrs.size());
+  return payload;
+}
+
+TEST(ForkServerTest, ChildProcessesShareAllocatedMemory) {
+  // Inherited by the fork server.
+  auto* before = static_cast<int64_t*>(allocate(kLength));
+  start_fork_server();
+
+  // Passed to the child processes, more than what fits in one message.
+  std::vector<int64_t*> ptrs = {before};
+  std::vector<memory_region> regions = {{before, kLength}};
+  for (int i = 0; i < 300; ++i) {
+    ptrs.push_back(static_cast<int64_t*>(allocate(kLength)));
+    regions.push_back({ptrs.back(), kLength});
+  }
+
+  for (int run = 0; run < 2; ++run) {
+    int64_t result = 0;
+    ASSERT_TRUE(run_in_fork_server(&Fill, Serialize(ptrs), regions, result));
+    EXPECT_EQ(result, int64_t(ptrs.size()));
+    for (int64_t i = 0; i < int64_t(ptrs.size()); ++i) {
+      EXPECT_EQ(ptrs[i][0], i);
+      EXPECT_EQ(ptrs[i][kLength / sizeof(int64_t) - 1], i);
+      ptrs[i][0] = -1;
+    }
+  }
+
+  for (int64_t* ptr : ptrs) deallocate(ptr, kLength);
+}
+
+TEST(ForkServerTest, UnsharedMemoryIsRejected) {
+  start_fork_server();
+  std::vector<int64_t> data(kLength / sizeof(int64_t));
+  int64_t result = 0;
+  EXPECT_FALSE(run_in_fork_server(&Fill, Serialize({data.data()}),
+                                  {{data.data(), kLength}}, result));
+  EXPECT_EQ(data[0], 0);
+}
+
+}  // namespace
+}  // namespace tapa
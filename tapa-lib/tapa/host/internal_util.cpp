@@ -2,9 +2,15 @@
 // All rights reserved. The contributor(s) of this file has/have agreed to the
 // RapidStream Contributor License Agreement.
 
+#include <iomanip>
+#include <ostream>
 #include <string>
 #include <string_view>
 
+#include <dlfcn.h>
+
+#include <boost/core/demangle.hpp>
+
 namespace tapa::internal {
 
 std::string StrCat(std::initializer_list<std::string_view> pieces) {
@@ -16,4 +22,39 @@ std::string StrCat(std::initializer_list<std::string_view> pieces) {
   return text;
 }
 
+std::string GetFunctionName(const void* func) {
+  Dl_info info;
+  if (func == nullptr || dladdr(func, &info) == 0 ||
+      info.dli_sname == nullptr) {
+    return "";
+  }
+  std::string name = boost::core::demangle(info.dli_sname);
+  return name.substr(0, name.find('('));
+}
+
+void WriteJsonString(std::ostream& os, std::string_view str) {
+  os << '"';
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        os << "\\\"";
+        break;
+      case '\\':
+        os << "\\\\";
+        break;
+      case '\n':
+        os << "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+             << static_cast<int>(c) << std::dec << std::setfill(' ');
+        } else {
+          os << c;
+        }
+    }
+  }
+  os << '"';
+}
+
 }  // namespace tapa::internal
@@ -2,6 +2,7 @@
 // All rights reserved. The contributor(s) of this file has/have agreed to the
 // RapidStream Contributor License Agreement.
 
+#include <ostream>
 #include <string>
 #include <string_view>
 
@@ -9,6 +10,14 @@ namespace tapa::internal {
 
 std::string StrCat(std::initializer_list<std::string_view> pieces);
 
+// Returns the unqualified name of the function at `func`, or an empty string
+// if the symbol is not exported (e.g., the executable is not linked with
+// `-rdynamic`).
+std::string GetFunctionName(const void* func);
+
+// Writes `str` as a JSON string.
+void WriteJsonString(std::ostream& os, std::string_view str);
+
 // Utilities to obtain function traits.
 template <typename T>
 struct function_traits : public function_traits<decltype(&T::operator())> {};
@@ -0,0 +1,142 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/logging.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tapa/host/coroutine.h"
+
+namespace tapa {
+namespace internal {
+
+namespace {
+
+using log_clock = std::chrono::system_clock;
+
+// The buffer of a worker thread is flushed once it holds this many bytes, or
+// once its oldest message is this old.
+constexpr size_t kFlushBytes = 16 << 10;
+constexpr auto kFlushDelay = std::chrono::milliseconds(10);
+
+// glog truncates longer messages, so batches are kept shorter than this.
+constexpr size_t kMaxBatchBytes = 16 << 10;
+
+// Buffering is disabled by `TAPA_LOG_BUFFER=0`, e.g., to see the messages of
+// tasks right before a crash.
+bool is_buffer_enabled() {
+  static const bool enabled = [] {
+    const char* env = getenv("TAPA_LOG_BUFFER");
+    return env == nullptr || std::strcmp(env, "0") != 0;
+  }();
+  return enabled;
+}
+
+struct buffered_message {
+  const char* file;
+  int line;
+  google::LogSeverity severity;
+  log_clock::time_point time;
+  std::string text;
+};
+
+struct log_buffer {
+  std::vector<buffered_message> messages;
+  size_t bytes = 0;
+};
+
+thread_local log_buffer buffer;
+
+// Appends the prefix glog writes before a message, e.g.,
+// `I0102 03:04:05.678901  1234 file.cpp:56] `.
+void append_prefix(std::string& out, const buffered_message& message) {
+  const time_t seconds = log_clock::to_time_t(message.time);
+  const auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+                         message.time.time_since_epoch())
+                         .count() %
+                     1000000;
+  tm local;
+  localtime_r(&seconds, &local);
+  const char* basename = std::strrchr(message.file, '/');
+  basename = basename == nullptr ? message.file : basename + 1;
+  static thread_local const long tid = syscall(SYS_gettid);
+  char prefix[64];
+  snprintf(prefix, sizeof(prefix), "%c%02d%02d %02d:%02d:%02d.%06ld %5ld ",
+           "IWEF"[message.severity], local.tm_mon + 1, local.tm_mday,
+           local.tm_hour, local.tm_min, local.tm_sec, long(usecs), tid);
+  out += prefix;
+  out += basename;
+  out += ':';
+  out += std::to_string(message.line);
+  out += "] ";
+}
+
+}  // namespace
+
+log_message::log_message(const char* file, int line,
+                         google::LogSeverity severity)
+    : file_(file), line_(line), severity_(severity) {
+  if (is_buffer_enabled() && get_coroutine_name() != nullptr) {
+    this->buffer_.emplace();
+  } else {
+    this->glog_.emplace(file, line, severity);
+  }
+}
+
+log_message::~log_message() {
+  if (this->glog_ || this->severity_ < FLAGS_minloglevel) return;
+
+  // The task may have moved to another worker thread while the message was
+  // being built, which buffers the message instead.
+  const std::string* name = get_coroutine_name();
+  if (name == nullptr) {
+    google::LogMessage(this->file_, this->line_, this->severity_).stream()
+        << this->buffer_->str();
+    return;
+  }
+  std::string text = "[" + *name + "] " + this->buffer_->str();
+  buffer.bytes += text.size();
+  buffer.messages.push_back({this->file_, this->line_, this->severity_,
+                             log_clock::now(), std::move(text)});
+}
+
+void flush_log_buffer(bool force) {
+  auto& messages = buffer.messages;
+  if (messages.empty()) return;
+  if (!force && buffer.bytes < kFlushBytes &&
+      log_clock::now() - messages.front().time < kFlushDelay) {
+    return;
+  }
+
+  // Consecutive messages of the same severity are passed to glog as one
+  // message, the first line of which is prefixed by glog.
+  for (size_t i = 0; i < messages.size();) {
+    const buffered_message& first = messages[i];
+    google::LogMessage batch(first.file, first.line, first.severity);
+    std::string text = first.text;
+    for (++i; i < messages.size() && messages[i].severity == first.severity &&
+              text.size() + messages[i].text.size() < kMaxBatchBytes;
+         ++i) {
+      text += '\n';
+      append_prefix(text, messages[i]);
+      text += messages[i].text;
+    }
+    batch.stream() << text;
+  }
+  messages.clear();
+  buffer.bytes = 0;
+}
+
+}  // namespace internal
+}  // namespace tapa
@@ -5,7 +5,67 @@
 #ifndef TAPA_HOST_LOGGING_H_
 #define TAPA_HOST_LOGGING_H_
 
+#include <optional>
+#include <sstream>
+
 #include <glog/logging.h>
 #include "tapa/base/logging.h"
 
+namespace tapa {
+namespace internal {
+
+// A message logged by `LOG(INFO)`, `LOG(WARNING)`, or `LOG(ERROR)`. Messages
+// of tasks running as coroutines are tagged with the task instance and kept
+// in a buffer of the worker thread, which passes them to glog in batches, so
+// that workers do not serialize on the lock glog takes for every message.
+// Other messages are passed to glog as usual.
+class log_message {
+ public:
+  log_message(const char* file, int line, google::LogSeverity severity);
+  log_message(const log_message&) = delete;
+  log_message& operator=(const log_message&) = delete;
+  ~log_message();
+
+  std::ostream& stream() {
+    return this->glog_ ? this->glog_->stream() : *this->buffer_;
+  }
+
+ private:
+  const char* const file_;
+  const int line_;
+  const google::LogSeverity severity_;
+
+  // Exactly one of them is set. The message is buffered even if the task
+  // moves to another worker thread while the message is being built.
+  std::optional<google::LogMessage> glog_;
+  std::optional<std::ostringstream> buffer_;
+};
+
+// Passes the messages buffered by the calling worker thread to glog, if
+// `force` is set, or if there are many of them or they have been buffered for
+// a while. Called by the scheduler when a coroutine yields or returns.
+void flush_log_buffer(bool force);
+
+}  // namespace internal
+}  // namespace tapa
+
+// Fatal messages are not buffered, so that glog aborts right away.
+#ifndef TAPA_DISABLE_LOG_BUFFER
+#if GOOGLE_STRIP_LOG == 0
+#undef COMPACT_GOOGLE_LOG_INFO
+#define COMPACT_GOOGLE_LOG_INFO \
+  ::tapa::internal::log_message(__FILE__, __LINE__, google::GLOG_INFO)
+#endif  // GOOGLE_STRIP_LOG == 0
+#if GOOGLE_STRIP_LOG <= 1
+#undef COMPACT_GOOGLE_LOG_WARNING
+#define COMPACT_GOOGLE_LOG_WARNING \
+  ::tapa::internal::log_message(__FILE__, __LINE__, google::GLOG_WARNING)
+#endif  // GOOGLE_STRIP_LOG <= 1
+#if GOOGLE_STRIP_LOG <= 2
+#undef COMPACT_GOOGLE_LOG_ERROR
+#define COMPACT_GOOGLE_LOG_ERROR \
+  ::tapa::internal::log_message(__FILE__, __LINE__, google::GLOG_ERROR)
+#endif  // GOOGLE_STRIP_LOG <= 2
+#endif  // TAPA_DISABLE_LOG_BUFFER
+
 #endif  // TAPA_HOST_LOGGING_H_
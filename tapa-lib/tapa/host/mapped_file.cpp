@@ -0,0 +1,166 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/mapped_file.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+namespace tapa::internal {
+
+namespace {
+
+constexpr uint64_t kDefaultPageWindowBytes = uint64_t{64} << 20;
+
+// Mappings that are alive, as {begin, {end, mode}}.
+std::mutex registry_mtx;
+std::map<uintptr_t, std::pair<uintptr_t, file_mode>> registry;
+
+uint64_t get_page_window_bytes() {
+  const char* env = getenv("TAPA_MMAP_PAGE_WINDOW");
+  if (env == nullptr || *env == '\0') return kDefaultPageWindowBytes;
+  char* end;
+  const uint64_t bytes = strtoull(env, &end, 10);
+  if (*end != '\0') {
+    LOG(WARNING) << "ignoring invalid TAPA_MMAP_PAGE_WINDOW '" << env << "'";
+    return kDefaultPageWindowBytes;
+  }
+  return bytes;
+}
+
+}  // namespace
+
+file_mapping::file_mapping(const std::string& path, file_mode mode) {
+  const bool is_writable = mode == file_mode::kReadWrite;
+  const int fd = open(path.c_str(), is_writable ? O_RDWR : O_RDONLY);
+  PCHECK(fd >= 0) << "cannot open '" << path << "'";
+
+  struct stat st;
+  PCHECK(fstat(fd, &st) == 0) << "cannot stat '" << path << "'";
+  this->length_ = st.st_size;
+
+  // Empty files cannot be mapped, and are represented by `nullptr`.
+  if (this->length_ > 0) {
+    const int prot =
+        mode == file_mode::kReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+    const int flags =
+        mode == file_mode::kCopyOnWrite ? MAP_PRIVATE : MAP_SHARED;
+    this->addr_ = ::mmap(nullptr, this->length_, prot, flags, fd, /*offset=*/0);
+    PCHECK(this->addr_ != MAP_FAILED) << "cannot map '" << path << "'";
+
+    const auto begin = reinterpret_cast<uintptr_t>(this->addr_);
+    std::unique_lock lock(registry_mtx);
+    registry[begin] = {begin + this->length_, mode};
+  }
+
+  // The mapping keeps a reference to the file.
+  close(fd);
+}
+
+file_mapping::~file_mapping() {
+  if (this->addr_ != nullptr) {
+    {
+      std::unique_lock lock(registry_mtx);
+      registry.erase(reinterpret_cast<uintptr_t>(this->addr_));
+    }
+    PCHECK(::munmap(this->addr_, this->length_) == 0);
+  }
+}
+
+std::shared_ptr<file_pager> file_pager::Find(const void* base, uint64_t size) {
+  const auto addr = reinterpret_cast<uintptr_t>(base);
+  uintptr_t begin;
+  uintptr_t end;
+  file_mode mode;
+  {
+    std::unique_lock lock(registry_mtx);
+    auto it = registry.upper_bound(addr);
+    if (it == registry.begin()) return nullptr;
+    --it;
+    begin = it->first;
+    std::tie(end, mode) = it->second;
+  }
+  if (addr + size > end) return nullptr;
+
+  uint64_t window_bytes = get_page_window_bytes();
+  if (window_bytes == 0) return nullptr;  // Disabled.
+  const uint64_t page_size = sysconf(_SC_PAGESIZE);
+  window_bytes = (window_bytes + page_size - 1) / page_size * page_size;
+  return std::make_shared<file_pager>(
+      reinterpret_cast<const void*>(begin), reinterpret_cast<const void*>(end),
+      /*is_shared=*/mode != file_mode::kCopyOnWrite, window_bytes);
+}
+
+file_pager::file_pager(const void* begin, const void* end, bool is_shared,
+                       uint64_t window_bytes)
+    : begin_(reinterpret_cast<uintptr_t>(begin)),
+      end_(reinterpret_cast<uintptr_t>(end)),
+      is_shared_(is_shared),
+      window_bytes_(window_bytes) {}
+
+void file_pager::record_read(const void* addr, uint64_t size) {
+  if (size == 0) return;
+  const auto begin = reinterpret_cast<uintptr_t>(addr);
+  const bool is_sequential = begin == this->next_addr_;
+  this->next_addr_ = begin + size;
+
+  // Window of the last byte read. Windows before it are being or have been
+  // loaded by the reads themselves.
+  const uint64_t window =
+      (begin + size - 1 - this->begin_) / this->window_bytes_;
+  if (!is_sequential) {
+    // Starts over without loading or releasing anything.
+    this->next_window_ = window + 1;
+    this->released_window_ = (begin - this->begin_) / this->window_bytes_;
+    return;
+  }
+
+  // Loads the window after the one being read.
+  const uint64_t window_count =
+      (this->end_ - this->begin_ + this->window_bytes_ - 1) /
+      this->window_bytes_;
+  for (; this->next_window_ <= window + 1 && this->next_window_ < window_count;
+       ++this->next_window_) {
+    advise(this->next_window_, MADV_WILLNEED);
+    ++this->prefetched_windows_;
+  }
+
+  // Releases the windows before the previous one, which is kept for reads
+  // that restart a little behind.
+  if (this->is_shared_) {
+    for (; this->released_window_ + 1 < window; ++this->released_window_) {
+      advise(this->released_window_, MADV_DONTNEED);
+      ++this->released_windows_;
+    }
+  }
+}
+
+void file_pager::advise(uint64_t index, int advice) {
+  const uintptr_t begin = this->begin_ + index * this->window_bytes_;
+  const uintptr_t end = std::min(begin + this->window_bytes_, this->end_);
+  // Failing to advise only affects performance.
+  if (madvise(reinterpret_cast<void*>(begin), end - begin, advice) != 0) {
+    LOG_FIRST_N(WARNING, 1) << "cannot advise the kernel of mapped pages ("
+                            << std::strerror(errno) << ")";
+  }
+}
+
+}  // namespace tapa::internal
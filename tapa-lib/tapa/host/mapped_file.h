@@ -0,0 +1,156 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef TAPA_HOST_MAPPED_FILE_H_
+#define TAPA_HOST_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <glog/logging.h>
+
+namespace tapa {
+
+/// Defines how @c tapa::mapped_file maps a file into memory.
+enum class file_mode {
+  /// Pages are shared with the file and must not be written. Suitable for
+  /// inputs, e.g., @c tapa::read_only_mmap and @c tapa::immap.
+  kReadOnly,
+
+  /// Pages start with the content of the file, but writes are private to the
+  /// process and never reach the file.
+  kCopyOnWrite,
+
+  /// Pages are shared with the file, and writes reach the file.
+  kReadWrite,
+};
+
+namespace internal {
+
+// Non-template part of `tapa::mapped_file`.
+class file_mapping {
+ public:
+  file_mapping(const std::string& path, file_mode mode);
+  ~file_mapping();
+
+  file_mapping(file_mapping&& other) noexcept
+      : addr_(std::exchange(other.addr_, nullptr)),
+        length_(std::exchange(other.length_, 0)) {}
+  file_mapping& operator=(file_mapping&& other) noexcept {
+    std::swap(this->addr_, other.addr_);
+    std::swap(this->length_, other.length_);
+    return *this;
+  }
+
+  // Not copyable.
+  file_mapping(const file_mapping&) = delete;
+  file_mapping& operator=(const file_mapping&) = delete;
+
+  void* addr() const { return this->addr_; }
+  size_t length() const { return this->length_; }
+
+ private:
+  void* addr_ = nullptr;
+  size_t length_ = 0;
+};
+
+// Pages the memory of a `file_mapping` for an `async_mmap` in software
+// simulation. Once reads of the port become sequential, the next window of
+// `TAPA_MMAP_PAGE_WINDOW` bytes (64 MiB by default) is loaded from the file in
+// the background before the reads reach it. Windows that the reads have left
+// behind are released if the mapping is shared with the file, so that
+// streaming through a file larger than the physical memory does not evict
+// other data. Pages of `kCopyOnWrite` mappings are never released, because
+// private writes would be lost.
+class file_pager {
+ public:
+  // Returns `nullptr` unless memory of `size` bytes at `base` lies in a
+  // `file_mapping`. Otherwise, returns a new pager for the port.
+  static std::shared_ptr<file_pager> Find(const void* base, uint64_t size);
+
+  file_pager(const void* begin, const void* end, bool is_shared,
+             uint64_t window_bytes);
+
+  // Not copyable or movable.
+  file_pager(const file_pager&) = delete;
+  file_pager& operator=(const file_pager&) = delete;
+
+  // Records a read of `size` bytes starting at `addr`. Must not be called in
+  // parallel.
+  void record_read(const void* addr, uint64_t size);
+
+  // Returns the numbers of windows loaded and released so far.
+  uint64_t prefetched_windows() const { return prefetched_windows_; }
+  uint64_t released_windows() const { return released_windows_; }
+
+ private:
+  // Advises the kernel of the pages in window `index` as `advice`.
+  void advise(uint64_t index, int advice);
+
+  const uintptr_t begin_;
+  const uintptr_t end_;
+  const bool is_shared_;
+  const uint64_t window_bytes_;
+
+  uintptr_t next_addr_ = 0;       // Where a sequential read would start.
+  uint64_t next_window_ = 0;      // First window not yet loaded.
+  uint64_t released_window_ = 0;  // First window not yet released.
+  uint64_t prefetched_windows_ = 0;
+  uint64_t released_windows_ = 0;
+};
+
+}  // namespace internal
+
+/// Maps a file of @c T into memory, so that it can be used as a
+/// @c tapa::mmap without reading it first.
+///
+/// Pages are loaded from the file on demand, so datasets larger than the
+/// physical memory can be used. In software simulation, sequential reads by
+/// @c tapa::async_mmap also load the pages ahead of time and, unless the mode
+/// is @c file_mode::kCopyOnWrite, release the pages that they have passed.
+/// The memory is page-aligned and can be used by the FPGA runtime without
+/// being copied.
+///
+/// @code{.cpp}
+///  tapa::mapped_file<Edge> edges("edges.bin", tapa::file_mode::kReadOnly);
+///  tapa::invoke(Kernel, bitstream, tapa::read_only_mmap<Edge>(edges));
+/// @endcode
+template <typename T>
+class mapped_file {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "T must be trivially copyable to be mapped from a file");
+
+ public:
+  /// Maps the file at @c path into memory.
+  ///
+  /// @param path Path to the file. Its size must be a multiple of @c sizeof(T).
+  /// @param mode How the file is mapped.
+  explicit mapped_file(const std::string& path,
+                       file_mode mode = file_mode::kReadOnly)
+      : mapping_(path, mode) {
+    CHECK_EQ(mapping_.length() % sizeof(T), 0)
+        << "size of '" << path << "' must be a multiple of sizeof(T) = "
+        << sizeof(T) << ", got " << mapping_.length();
+  }
+
+  /// Retrieves the start of the mapped memory.
+  T* data() const { return static_cast<T*>(mapping_.addr()); }
+
+  /// Retrieves the size of the mapped memory (in unit of element count).
+  uint64_t size() const { return mapping_.length() / sizeof(T); }
+
+  T& operator[](size_t idx) const { return data()[idx]; }
+
+ private:
+  internal::file_mapping mapping_;
+};
+
+}  // namespace tapa
+
+#endif  // TAPA_HOST_MAPPED_FILE_H_
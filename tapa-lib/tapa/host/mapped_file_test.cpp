@@ -0,0 +1,157 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/mapped_file.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tapa.h"
+
+namespace tapa {
+namespace {
+
+constexpr int kN = 1000;
+
+std::string WriteFile(const std::string& name, int n = kN) {
+  const std::string path = testing::TempDir() + name;
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 0);
+  std::ofstream(path, std::ios::binary)
+      .write(reinterpret_cast<const char*>(data.data()),
+             data.size() * sizeof(int));
+  return path;
+}
+
+std::vector<int> ReadFile(const std::string& path) {
+  std::vector<int> data(kN);
+  std::ifstream(path, std::ios::binary)
+      .read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(int));
+  return data;
+}
+
+void Double(tapa::mmap<int> mem) {
+  for (uint64_t i = 0; i < mem.size(); ++i) mem[i] *= 2;
+}
+
+void Sum(tapa::async_mmap<int>& mem, uint64_t n, tapa::ostream<int64_t>& sum) {
+  int64_t result = 0;
+  for (uint64_t i_req = 0, i_resp = 0; i_resp < n;) {
+    if (i_req < n && mem.read_addr.try_write(i_req)) ++i_req;
+    int value;
+    if (mem.read_data.try_read(value)) {
+      result += value;
+      ++i_resp;
+    }
+  }
+  sum.write(result);
+}
+
+void SumTop(tapa::mmap<int> mem, tapa::ostream<int64_t>& sum) {
+  tapa::task().invoke(Sum, mem, mem.size(), sum);
+}
+
+// Number of `int` in a window of 4 KiB.
+constexpr int kWindowSize = 1024;
+
+TEST(MappedFileTest, ReadingFileSucceeds) {
+  mapped_file<int> file(WriteFile("read_only.bin"));
+  ASSERT_EQ(file.size(), kN);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(file.data()) % 4096, 0);
+  tapa::mmap<int> mem(file);
+  for (int i = 0; i < kN; ++i) EXPECT_EQ(mem[i], i);
+}
+
+TEST(MappedFileTest, CopyOnWriteDoesNotModifyFile) {
+  const std::string path = WriteFile("copy_on_write.bin");
+  mapped_file<int> file(path, file_mode::kCopyOnWrite);
+  tapa::mmap<int> mem(file);
+  tapa::task().invoke(Double, mem);
+  EXPECT_EQ(file[kN - 1], (kN - 1) * 2);
+  EXPECT_EQ(ReadFile(path)[kN - 1], kN - 1);
+}
+
+TEST(MappedFileTest, ReadWriteModifiesFile) {
+  const std::string path = WriteFile("read_write.bin");
+  {
+    mapped_file<int> file(path, file_mode::kReadWrite);
+    tapa::mmap<int> mem(file);
+    tapa::task().invoke(Double, mem);
+  }
+  EXPECT_EQ(ReadFile(path)[kN - 1], (kN - 1) * 2);
+}
+
+TEST(MappedFileTest, PagerLoadsAheadAndReleasesBehind) {
+  ASSERT_EQ(setenv("TAPA_MMAP_PAGE_WINDOW", "4096", /*replace=*/1), 0);
+  mapped_file<int> file(WriteFile("pager.bin", kWindowSize * 4));
+  auto pager = internal::file_pager::Find(file.data(), file.size() * 4);
+  EXPECT_EQ(unsetenv("TAPA_MMAP_PAGE_WINDOW"), 0);
+  ASSERT_NE(pager, nullptr);
+
+  for (int i = 0; i < kWindowSize * 4; i += 256) {
+    pager->record_read(file.data() + i, 256 * sizeof(int));
+  }
+  EXPECT_EQ(pager->prefetched_windows(), 3);
+  EXPECT_EQ(pager->released_windows(), 2);
+}
+
+TEST(MappedFileTest, PagerIgnoresRandomReads) {
+  ASSERT_EQ(setenv("TAPA_MMAP_PAGE_WINDOW", "4096", /*replace=*/1), 0);
+  mapped_file<int> file(WriteFile("pager_random.bin", kWindowSize * 4));
+  auto pager = internal::file_pager::Find(file.data(), file.size() * 4);
+  EXPECT_EQ(unsetenv("TAPA_MMAP_PAGE_WINDOW"), 0);
+  ASSERT_NE(pager, nullptr);
+
+  for (int i : {3, 0, 2, 1}) {
+    pager->record_read(file.data() + i * kWindowSize, sizeof(int));
+  }
+  EXPECT_EQ(pager->prefetched_windows(), 0);
+  EXPECT_EQ(pager->released_windows(), 0);
+}
+
+TEST(MappedFileTest, PagerDoesNotReleaseCopyOnWritePages) {
+  ASSERT_EQ(setenv("TAPA_MMAP_PAGE_WINDOW", "4096", /*replace=*/1), 0);
+  mapped_file<int> file(WriteFile("pager_cow.bin", kWindowSize * 4),
+                        file_mode::kCopyOnWrite);
+  auto pager = internal::file_pager::Find(file.data(), file.size() * 4);
+  EXPECT_EQ(unsetenv("TAPA_MMAP_PAGE_WINDOW"), 0);
+  ASSERT_NE(pager, nullptr);
+
+  for (int i = 0; i < kWindowSize * 4; i += 256) {
+    pager->record_read(file.data() + i, 256 * sizeof(int));
+  }
+  EXPECT_EQ(pager->prefetched_windows(), 3);
+  EXPECT_EQ(pager->released_windows(), 0);
+}
+
+TEST(MappedFileTest, PagerIsOnlyFoundForMappedFiles) {
+  std::vector<int> vec(kN);
+  EXPECT_EQ(internal::file_pager::Find(vec.data(), kN * sizeof(int)), nullptr);
+
+  mapped_file<int> file(WriteFile("pager_disabled.bin"));
+  ASSERT_EQ(setenv("TAPA_MMAP_PAGE_WINDOW", "0", /*replace=*/1), 0);
+  EXPECT_EQ(internal::file_pager::Find(file.data(), kN * sizeof(int)),
+            nullptr);
+  EXPECT_EQ(unsetenv("TAPA_MMAP_PAGE_WINDOW"), 0);
+}
+
+TEST(MappedFileTest, ReadingPagedFileViaAsyncMmapSucceeds) {
+  constexpr int n = kWindowSize * 16;
+  ASSERT_EQ(setenv("TAPA_MMAP_PAGE_WINDOW", "4096", /*replace=*/1), 0);
+  mapped_file<int> file(WriteFile("pager_async.bin", n));
+  tapa::mmap<int> mem(file);
+  tapa::stream<int64_t> sum;
+  tapa::task().invoke(SumTop, mem, sum);
+  EXPECT_EQ(unsetenv("TAPA_MMAP_PAGE_WINDOW"), 0);
+  EXPECT_EQ(sum.read(), int64_t{n} * (n - 1) / 2);
+}
+
+}  // namespace
+}  // namespace tapa
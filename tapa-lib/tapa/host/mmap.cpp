@@ -0,0 +1,98 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/mmap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <glog/logging.h>
+
+namespace tapa::internal {
+
+namespace {
+
+uint64_t get_env(const char* name, uint64_t default_value) {
+  const char* env = getenv(name);
+  return env == nullptr ? default_value : strtoull(env, nullptr, 10);
+}
+
+// Returns the widest word size, up to 8 bytes, in which `size` bytes at `ptr`
+// can be accessed with aligned atomic operations.
+size_t get_word_size(const void* ptr, size_t size) {
+  const uintptr_t bits = reinterpret_cast<uintptr_t>(ptr) | size | 8;
+  return bits & -bits;
+}
+
+template <typename Word>
+void load_words(const void* shared, void* local, size_t count) {
+  const Word* src = static_cast<const Word*>(shared);
+  char* dst = static_cast<char*>(local);
+  for (size_t i = 0; i < count; ++i) {
+    const Word word = __atomic_load_n(src + i, __ATOMIC_ACQUIRE);
+    std::memcpy(dst + i * sizeof(Word), &word, sizeof(Word));
+  }
+}
+
+template <typename Word>
+void store_words(const void* local, void* shared, size_t count) {
+  const char* src = static_cast<const char*>(local);
+  Word* dst = static_cast<Word*>(shared);
+  for (size_t i = 0; i < count; ++i) {
+    Word word;
+    std::memcpy(&word, src + i * sizeof(Word), sizeof(Word));
+    __atomic_store_n(dst + i, word, __ATOMIC_RELEASE);
+  }
+}
+
+}  // namespace
+
+const async_mmap_options& get_async_mmap_options() {
+  static const async_mmap_options options = [] {
+    async_mmap_options options;
+    options.max_outstanding =
+        get_env("TAPA_MMAP_MAX_OUTSTANDING", options.max_outstanding);
+    options.latency_ns = get_env("TAPA_MMAP_LATENCY", options.latency_ns);
+    options.write_burst_bytes =
+        get_env("TAPA_MMAP_WRITE_BURST", options.write_burst_bytes);
+    if (options.max_outstanding == 0) {
+      LOG(WARNING) << "TAPA_MMAP_MAX_OUTSTANDING must be positive; using 1";
+      options.max_outstanding = 1;
+    }
+    return options;
+  }();
+  return options;
+}
+
+bool is_mmap_shared() { return get_env("TAPA_SHARED_MMAP", 0) != 0; }
+
+void load_shared(const void* shared, void* local, size_t size) {
+  switch (get_word_size(shared, size)) {
+    case 8:
+      return load_words<uint64_t>(shared, local, size / 8);
+    case 4:
+      return load_words<uint32_t>(shared, local, size / 4);
+    case 2:
+      return load_words<uint16_t>(shared, local, size / 2);
+    default:
+      return load_words<uint8_t>(shared, local, size);
+  }
+}
+
+void store_shared(const void* local, void* shared, size_t size) {
+  switch (get_word_size(shared, size)) {
+    case 8:
+      return store_words<uint64_t>(local, shared, size / 8);
+    case 4:
+      return store_words<uint32_t>(local, shared, size / 4);
+    case 2:
+      return store_words<uint16_t>(local, shared, size / 2);
+    default:
+      return store_words<uint8_t>(local, shared, size);
+  }
+}
+
+}  // namespace tapa::internal
@@ -8,13 +8,25 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <memory>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <frt.h>
 
+#include "tapa/base/mmap.h"
 #include "tapa/host/coroutine.h"
+#include "tapa/host/fork_server.h"
+#include "tapa/host/mapped_file.h"
+#include "tapa/host/mmap_stats.h"
+#include "tapa/host/mmap_timing.h"
 #include "tapa/host/stream.h"
+#include "tapa/host/task_graph.h"
 #include "tapa/host/vec.h"
 
 namespace tapa {
@@ -24,9 +36,51 @@ namespace internal {
 template <typename Param, typename Arg>
 struct accessor;
 
+// Options of the software simulation model of `async_mmap`.
+struct async_mmap_options {
+  // Maximum number of read requests whose data are not yet read by the task.
+  // Set by `TAPA_MMAP_MAX_OUTSTANDING`.
+  uint64_t max_outstanding = 64;
+
+  // Minimum delay between receiving a request and responding to it, in
+  // nanoseconds. Set by `TAPA_MMAP_LATENCY`.
+  uint64_t latency_ns = 0;
+
+  // Maximum bytes of sequential writes acknowledged by one write response,
+  // unless `max_burst_len` is set in the `async_mmap_config` of the port.
+  // Defaults to the burst size of the hardware. Set by
+  // `TAPA_MMAP_WRITE_BURST`.
+  uint64_t write_burst_bytes = 1024;
+};
+
+// Returns the `max_burst_len` of an `async_mmap_config`, or 0 if unset.
+template <typename Config>
+struct max_burst_len_of {
+  static constexpr int value = 0;
+};
+template <int max_outstanding, int max_burst_len, int buffer_size,
+          int reorder_buffer_size>
+struct max_burst_len_of<async_mmap_config<max_outstanding, max_burst_len,
+                                          buffer_size, reorder_buffer_size>> {
+  static constexpr int value = max_burst_len;
+};
+
+const async_mmap_options& get_async_mmap_options();
+
+// Whether `async_mmap` accesses memory atomically, so that ports sharing memory
+// do not race with each other. Set by `TAPA_SHARED_MMAP`.
+bool is_mmap_shared();
+
+// Copies `size` bytes between memory shared with other ports and memory that
+// is private to a port. The shared memory is accessed in the widest aligned
+// words, which are loaded with acquire semantics and stored with release
+// semantics.
+void load_shared(const void* shared, void* local, size_t size);
+void store_shared(const void* local, void* shared, size_t size);
+
 }  // namespace internal
 
-template <typename T>
+template <typename T, typename Config = async_mmap_config<>>
 class async_mmap;
 
 /// Defines a view of a piece of consecutive memory with synchronous random
@@ -143,25 +197,21 @@ class mmap {
     static_assert(std::is_standard_layout<U>::value,
                   "U must have standard layout");
 
-    if (sizeof(U) > sizeof(T)) {
+    if constexpr (sizeof(U) > sizeof(T)) {
+      static_assert(sizeof(U) % sizeof(T) == 0,
+                    "sizeof(U) must be a multiple of sizeof(T) when mmap<T> is "
+                    "reinterpreted as mmap<U> (i.e., `reinterpret<U>()`)");
       constexpr auto N = sizeof(U) / sizeof(T);
-      CHECK_EQ(sizeof(U) % sizeof(T), 0)
-          << "sizeof(U) must be a multiple of sizeof(T) when mmap<T> is "
-             "reinterpreted as mmap<U> (i.e., `reinterpret<U>()`); got "
-             "sizeof(U) = "
-          << sizeof(U) << ", sizeof(T) = " << sizeof(T);
       CHECK_EQ(size() % N, 0)
           << "size of mmap<T> must be a multiple of N (= sizeof(U)/sizeof(T)) "
              "when reinterpreted as mmap<U> (i.e., `reinterpret<U>()`); got "
              "size = "
           << size() << ", N = " << sizeof(U) << " / " << sizeof(T) << " = " << N
           << ", but " << size() << " % " << N << " != 0";
-    } else if (sizeof(U) < sizeof(T)) {
-      CHECK_EQ(sizeof(T) % sizeof(U), 0)
-          << "sizeof(T) must be a multiple of sizeof(U) when mmap<T> is "
-             "reinterpreted as mmap<U> (i.e., `reinterpret<U>()`); got "
-             "sizeof(T) = "
-          << sizeof(T) << ", sizeof(U) = " << sizeof(U);
+    } else if constexpr (sizeof(U) < sizeof(T)) {
+      static_assert(sizeof(T) % sizeof(U) == 0,
+                    "sizeof(T) must be a multiple of sizeof(U) when mmap<T> is "
+                    "reinterpreted as mmap<U> (i.e., `reinterpret<U>()`)");
     }
     CHECK_EQ(reinterpret_cast<std::size_t>(get()) % alignof(U), 0)
         << "data of mmap<T> must be " << alignof(U)
@@ -190,9 +240,30 @@ class ommap : public mmap<T> {
   using mmap<T>::mmap;
 };
 
+/// Copies elements @c offset to `offset + n - 1` of @c mem to @c dst.
+///
+/// Synthesized as a `memcpy`, which Vitis HLS turns into a burst.
+template <typename T>
+inline void load(const mmap<T>& mem, int64_t offset,
+                 std::remove_const_t<T>* dst, int64_t n) {
+  std::copy_n(mem.get() + offset, n, dst);
+}
+
+/// Copies @c n elements from @c src to elements @c offset to
+/// `offset + n - 1` of @c mem.
+///
+/// Synthesized as a `memcpy`, which Vitis HLS turns into a burst.
+template <typename T>
+inline void store(const mmap<T>& mem, int64_t offset, const T* src,
+                  int64_t n) {
+  std::copy_n(src, n, mem.get() + offset);
+}
+
 /// Defines a view of a piece of consecutive memory with asynchronous random
 /// accesses.
-template <typename T>
+///
+/// @tparam Config @c tapa::async_mmap_config of the hardware implementation.
+template <typename T, typename Config>
 class async_mmap : public mmap<T> {
  public:
   /// Type of the addresses.
@@ -235,9 +306,9 @@ class async_mmap : public mmap<T> {
   T operator--(int) { return *super::ptr_--; }
 
   // Arithmetic not permitted.
-  async_mmap<T> operator+(std::ptrdiff_t diff) { return super::ptr_ + diff; }
-  async_mmap<T> operator-(std::ptrdiff_t diff) { return super::ptr_ - diff; }
-  std::ptrdiff_t operator-(async_mmap<T> ptr) { return super::ptr_ - ptr; }
+  async_mmap operator+(std::ptrdiff_t diff) { return super::ptr_ + diff; }
+  async_mmap operator-(std::ptrdiff_t diff) { return super::ptr_ - diff; }
+  std::ptrdiff_t operator-(async_mmap ptr) { return super::ptr_ - ptr; }
 
  public:
   /// Provides access to the <i>read address</i> channel.
@@ -270,47 +341,253 @@ class async_mmap : public mmap<T> {
   /// by the underlying memory system.
   istream<resp_t> write_resp;
 
+  // Simulates the memory system. Requests are received and served in batches,
+  // and runs of sequential addresses are copied in bulk.
   void operator()() {
-    int16_t write_count = 0;
+    const internal::async_mmap_options& options =
+        internal::get_async_mmap_options();
+    const uint64_t capacity = options.max_outstanding;
+    const uint64_t latency_ns = options.latency_ns;
+    constexpr size_t kMaxWriteCount = 256;  // Acknowledged by one response.
+    constexpr size_t kConfigBurstLen =
+        internal::max_burst_len_of<Config>::value;
+    // Writes acknowledged by one response, i.e., beats of a write burst.
+    const size_t max_burst_len = std::clamp<uint64_t>(
+        kConfigBurstLen > 0 ? kConfigBurstLen
+                            : options.write_burst_bytes / sizeof(T),
+        1, kMaxWriteCount);
+    // Bursts do not cross 4 KB boundaries, i.e., elements whose addresses are
+    // multiples of this.
+    constexpr addr_t kBoundaryLen =
+        4096 % sizeof(T) == 0 ? 4096 / sizeof(T) : 0;
+    const std::shared_ptr<internal::mmap_timing> timing =
+        internal::mmap_timing::New(this->ptr_, this->size_ * sizeof(T));
+    const std::shared_ptr<internal::mmap_stats> stats =
+        internal::mmap_stats::Find(this->ptr_, this->size_ * sizeof(T));
+    const std::shared_ptr<internal::file_pager> pager =
+        internal::file_pager::Find(this->ptr_, this->size_ * sizeof(T));
+    const bool is_shared =
+        std::is_trivially_copyable_v<T> && internal::is_mmap_shared();
+
+    // Data of read requests are loaded into a ring buffer of `capacity`. Data
+    // in [read_head, read_ready) are ready to be read by the task, and data in
+    // [read_ready, read_tail) become ready when their latency expires.
+    std::vector<addr_t> read_addrs(capacity);
+    std::vector<T> read_buf(capacity);
+    uint64_t read_head = 0;
+    uint64_t read_ready = 0;
+    uint64_t read_tail = 0;
+    std::deque<std::pair<uint64_t, uint64_t>> read_batches;  // {tail, time}
+
+    // Write addresses and data that are received but not yet paired.
+    std::vector<addr_t> write_addrs(kMaxWriteCount);
+    std::vector<T> write_buf(kMaxWriteCount);
+    size_t write_addr_count = 0;
+    size_t write_data_count = 0;
+
+    // Writes are acknowledged by one response per burst of sequential
+    // addresses, as in hardware. The last burst stays open while more writes
+    // may extend it.
+    size_t burst_len = 0;  // Writes in the open burst.
+    addr_t burst_end = 0;  // Address of the write that extends the burst.
+
+    // Responses of closed bursts are kept in a ring buffer of `capacity`, and
+    // writes are held back while it is full. Responses in [resp_head,
+    // resp_ready) can be sent, and those in [resp_ready, resp_tail) can be sent
+    // when their latency expires.
+    std::vector<resp_t> resps(capacity);
+    uint64_t resp_head = 0;
+    uint64_t resp_ready = 0;
+    uint64_t resp_tail = 0;
+    std::deque<std::pair<uint64_t, uint64_t>> resp_batches;  // {tail, time}
+
+    // Closes the open burst, unless the ring buffer of responses is full.
+    const auto close_burst = [&] {
+      if (resp_tail - resp_head == capacity) return false;
+      resps[resp_tail++ % capacity] = resp_t(burst_len - 1);
+      burst_len = 0;
+      return true;
+    };
+
     for (;;) {
-      if (!read_addr_q_.empty() && !read_data_q_.full()) {
-        const auto addr = read_addr_q_.read();
-        CHECK_GE(addr, 0);
-        if (addr != 0) {
-          CHECK_LT(addr, this->size_);
+      // Checked before polling so that requests sent right before the last
+      // joined task using this memory finished are not lost.
+      const bool is_cancelled = internal::is_cancelled();
+      const uint64_t now = latency_ns == 0 ? 0 : now_ns();
+      bool is_waiting = false;  // Whether progress waits for the latency.
+
+      // Receive read requests, loading runs of sequential addresses that are
+      // contiguous in the ring buffer at once.
+      const size_t read_n = read_addr_q_.try_read_up_to(
+          read_addrs.data(), capacity - (read_tail - read_head));
+      for (size_t i = 0; i < read_n;) {
+        const uint64_t pos = read_tail % capacity;
+        const size_t len =
+            run_length(read_addrs.data() + i,
+                       std::min<uint64_t>(read_n - i, capacity - pos));
+        if (pager != nullptr) {
+          pager->record_read(this->ptr_ + read_addrs[i], len * sizeof(T));
+        }
+        if (is_shared) {
+          internal::load_shared(this->ptr_ + read_addrs[i],
+                                read_buf.data() + pos, len * sizeof(T));
+        } else {
+          std::copy_n(this->ptr_ + read_addrs[i], len, read_buf.begin() + pos);
         }
-        read_data_q_.write(this->ptr_[addr]);
+        if (timing != nullptr) {
+          timing->record_read(read_addrs[i] * sizeof(T), len * sizeof(T));
+        }
+        if (stats != nullptr) {
+          stats->record_read(this->ptr_ + read_addrs[i], len * sizeof(T), len);
+        }
+        read_tail += len;
+        i += len;
+      }
+      if (read_n > 0 && latency_ns == 0) {
+        read_ready = read_tail;
+      } else if (read_n > 0) {
+        read_batches.emplace_back(read_tail, now + latency_ns);
+      }
+
+      // Respond to read requests whose latency has expired.
+      while (!read_batches.empty() && read_batches.front().second <= now) {
+        read_ready = read_batches.front().first;
+        read_batches.pop_front();
       }
-      if (write_count != 256 && !write_addr_q_.empty() &&
-          !write_data_q_.empty()) {
-        const auto addr = write_addr_q_.read();
-        CHECK_GE(addr, 0);
-        if (addr != 0) {
-          CHECK_LT(addr, this->size_);
+      is_waiting |= !read_batches.empty();
+      while (read_head < read_ready) {
+        const uint64_t pos = read_head % capacity;
+        const size_t len = std::min<uint64_t>(read_ready - read_head,
+                                              capacity - pos);
+        const size_t written =
+            read_data_q_.try_write_up_to(read_buf.data() + pos, len);
+        read_head += written;
+        if (written < len) break;
+      }
+
+      // Receive write requests, and write data to their addresses as soon as
+      // both are available, copying runs of sequential addresses at once.
+      write_addr_count += write_addr_q_.try_read_up_to(
+          write_addrs.data() + write_addr_count,
+          kMaxWriteCount - write_addr_count);
+      write_data_count += write_data_q_.try_read_up_to(
+          write_buf.data() + write_data_count,
+          kMaxWriteCount - write_data_count);
+      const uint64_t last_resp_tail = resp_tail;
+      const size_t write_pairs = std::min(write_addr_count, write_data_count);
+      size_t write_n = 0;
+      while (write_n < write_pairs) {
+        const addr_t addr = write_addrs[write_n];
+        if (burst_len > 0 &&
+            (addr != burst_end || burst_len == max_burst_len ||
+             (kBoundaryLen > 0 && addr % kBoundaryLen == 0)) &&
+            !close_burst()) {
+          break;
+        }
+        size_t len = run_length(
+            write_addrs.data() + write_n,
+            std::min(write_pairs - write_n, max_burst_len - burst_len));
+        if (kBoundaryLen > 0) {
+          len = std::min<size_t>(len, kBoundaryLen - addr % kBoundaryLen);
+        }
+        if (is_shared) {
+          internal::store_shared(write_buf.data() + write_n, this->ptr_ + addr,
+                                 len * sizeof(T));
+        } else {
+          std::move(write_buf.begin() + write_n,
+                    write_buf.begin() + write_n + len, this->ptr_ + addr);
+        }
+        if (timing != nullptr) {
+          timing->record_write(addr * sizeof(T), len * sizeof(T));
+        }
+        if (stats != nullptr) {
+          stats->record_write(this->ptr_ + addr, len * sizeof(T), len);
         }
-        this->ptr_[addr] = write_data_q_.read();
-        ++write_count;
-      } else if (write_count > 0 &&
-                 this->write_resp_q_.try_write(resp_t(write_count - 1))) {
-        CHECK_LE(write_count, 256);
-        write_count = 0;
+        burst_len += len;
+        burst_end = addr + len;
+        write_n += len;
+      }
+      if (write_n > 0) {
+        std::move(write_addrs.begin() + write_n,
+                  write_addrs.begin() + write_addr_count, write_addrs.begin());
+        std::move(write_buf.begin() + write_n,
+                  write_buf.begin() + write_data_count, write_buf.begin());
+        write_addr_count -= write_n;
+        write_data_count -= write_n;
+      } else if (burst_len > 0) {
+        // Acknowledge the open burst when there are no more writes to extend
+        // it.
+        close_burst();
+      }
+
+      // Send the responses whose latency has expired, all at once.
+      if (resp_tail > last_resp_tail && latency_ns == 0) {
+        resp_ready = resp_tail;
+      } else if (resp_tail > last_resp_tail) {
+        resp_batches.emplace_back(resp_tail, now + latency_ns);
+      }
+      while (!resp_batches.empty() && resp_batches.front().second <= now) {
+        resp_ready = resp_batches.front().first;
+        resp_batches.pop_front();
+      }
+      is_waiting |= !resp_batches.empty();
+      while (resp_head < resp_ready) {
+        const uint64_t pos = resp_head % capacity;
+        const size_t len =
+            std::min<uint64_t>(resp_ready - resp_head, capacity - pos);
+        const size_t written =
+            write_resp_q_.try_write_up_to(resps.data() + pos, len);
+        resp_head += written;
+        if (written < len) break;
       }
+
+      // Nobody can send more requests or take more responses once cancelled.
+      // Writes received are applied already, so stop polling.
+      if (is_cancelled && read_n == 0 && write_n == 0 && !is_waiting) return;
+
+      // Let other tasks run while the latency expires.
+      if (is_waiting) internal::yield("async_mmap waits for memory latency");
+    }
+  }
+
+ private:
+  // Returns the length of the run of sequential addresses at `addrs`, which is
+  // no more than `n`. Checks that the addresses in the run are in bounds.
+  size_t run_length(const addr_t* addrs, size_t n) const {
+    size_t len = 1;
+    while (len < n && addrs[len] == addrs[0] + addr_t(len)) ++len;
+    CHECK_GE(addrs[0], 0);
+    if (addrs[0] + len > 1) {
+      CHECK_LE(addrs[0] + len, this->size_);
     }
+    return len;
   }
 
+  static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+ public:
   static async_mmap schedule(super mem) {
-    // a copy of async_mem is stored in std::function<void()>
+    // a copy of async_mem is stored in the scheduled task
     async_mmap async_mem(mem);
-    internal::schedule(/*detach=*/true, async_mem);
+    internal::task_info info;
+    internal::channel_traits<async_mmap>::collect(async_mem, info.channels);
+    internal::schedule(/*detach=*/true, async_mem, info);
     return async_mem;
   }
 };
 
 /// Defines an array of @c tapa::mmap.
+///
+/// The array is stored in place, so constructing, copying, slicing, and
+/// reinterpreting @c tapa::mmaps never allocates memory.
 template <typename T, uint64_t S>
 class mmaps {
  protected:
-  std::vector<mmap<T>> mmaps_;
+  std::array<mmap<T>, S> mmaps_;
 
  public:
   /// Constructs a @c tapa::mmap array from the given @c pointers and @c sizes.
@@ -318,11 +595,10 @@ class mmaps {
   /// @param ptrs  Pointers to the start of the array of mapped memory.
   /// @param sizes Sizes of each mapped memory (in unit of element count).
   template <typename PtrContainer, typename SizeContainer>
-  mmaps(const PtrContainer& pointers, const SizeContainer& sizes) {
-    for (uint64_t i = 0; i < S; ++i) {
-      mmaps_.emplace_back(pointers[i], sizes[i]);
-    }
-  }
+  mmaps(const PtrContainer& pointers, const SizeContainer& sizes)
+      : mmaps(make_array([&](uint64_t i) {
+          return mmap<T>(pointers[i], sizes[i]);
+        })) {}
 
   /// Constructs a @c tapa::mmap array from the given @c container.
   ///
@@ -330,11 +606,8 @@ class mmaps {
   ///                  must implement @c operator[] that returns a container
   ///                  suitable for constructing a @c tapa::mmap.
   template <typename Container>
-  explicit mmaps(Container& container) {
-    for (uint64_t i = 0; i < S; ++i) {
-      mmaps_.emplace_back(container[i]);
-    }
-  }
+  explicit mmaps(Container& container)
+      : mmaps(make_array([&](uint64_t i) { return mmap<T>(container[i]); })) {}
 
   // defaultd copy constructor
   mmaps(const mmaps&) = default;
@@ -347,15 +620,14 @@ class mmaps {
 
   /// References a @c tapa::mmap in the array.
   mmap<T>& operator[](int idx) { return mmaps_[idx]; };
+  const mmap<T>& operator[](int idx) const { return mmaps_[idx]; };
 
+  /// Returns a view of <tt>mmaps[offset : offset + length]</tt>.
   template <uint64_t offset, uint64_t length>
-  mmaps<T, length> slice() {
-    static_assert(offset + length < S, "invalid slice");
-    mmaps<T, length> result;
-    for (uint64_t i = 0; i < length; ++i) {
-      result.mmaps_[i] = this->mmaps_[offset + i];
-    }
-    return result;
+  mmaps<T, length> slice() const {
+    static_assert(offset + length <= S, "invalid slice");
+    return mmaps<T, length>(mmaps<T, length>::make_array(
+        [&](uint64_t i) { return mmaps_[offset + i]; }));
   }
 
   /// Reinterprets the element type of each mapped memory as
@@ -369,18 +641,8 @@ class mmaps {
   ///         <tt>tapa::vec_t<T, N></tt>.
   template <uint64_t N>
   mmaps<vec_t<T, N>, S> vectorized() const {
-    std::array<vec_t<T, N>*, S> ptrs;
-    std::array<uint64_t, S> sizes;
-    for (uint64_t i = 0; i < S; ++i) {
-      CHECK_EQ(mmaps_[i].size() % N, 0)
-          << "size of mmap<T> must be a multiple of N when vectorized as a "
-             "mmap<vec_t<T, N>> (i.e., `vectorized<N>()`); got size = "
-          << mmaps_[i].size() << ", N = " << N << ", but " << mmaps_[i].size()
-          << " % " << N << " != 0";
-      ptrs[i] = reinterpret_cast<vec_t<T, N>*>(mmaps_[i].get());
-      sizes[i] = mmaps_[i].size() / N;
-    }
-    return mmaps<vec_t<T, N>, S>(ptrs, sizes);
+    return mmaps<vec_t<T, N>, S>(mmaps<vec_t<T, N>, S>::make_array(
+        [&](uint64_t i) { return mmaps_[i].template vectorized<N>(); }));
   }
 
   /// Reinterprets the element type of each mapped memory as @c U.
@@ -397,46 +659,27 @@ class mmaps {
   /// @return <tt>tapa::mmaps<U, S></tt> of the same pieces of memory.
   template <typename U>
   mmaps<U, S> reinterpret() const {
-    static_assert(std::is_standard_layout<T>::value,
-                  "T must have standard layout");
-    static_assert(std::is_standard_layout<U>::value,
-                  "U must have standard layout");
+    return mmaps<U, S>(mmaps<U, S>::make_array(
+        [&](uint64_t i) { return mmaps_[i].template reinterpret<U>(); }));
+  }
 
-    std::array<U*, S> ptrs;
-    std::array<uint64_t, S> sizes;
-    for (uint64_t i = 0; i < S; ++i) {
-      if (sizeof(U) > sizeof(T)) {
-        CHECK_EQ(sizeof(U) % sizeof(T), 0)
-            << "sizeof(U) must be a multiple of sizeof(T) when mmap<T> is "
-               "reinterpreted as mmap<U> (i.e., `reinterpret<U>()`); got "
-               "sizeof(U) = "
-            << sizeof(U) << ", sizeof(T) = " << sizeof(T);
-        constexpr auto N = sizeof(U) / sizeof(T);
-        CHECK_EQ(mmaps_[i].size() % N, 0)
-            << "size of mmap<T> must be a multiple of N (= "
-               "sizeof(U)/sizeof(T)) when reinterpreted as mmap<U> (i.e., "
-               "`reinterpret<U>()`); got size = "
-            << mmaps_[i].size() << ", N = " << sizeof(U) << " / " << sizeof(T)
-            << " = " << N << ", but " << mmaps_[i].size() << " % " << N
-            << " != 0";
-      } else if (sizeof(U) < sizeof(T)) {
-        CHECK_EQ(sizeof(T) % sizeof(U), 0)
-            << "sizeof(T) must be a multiple of sizeof(U) when mmap<T> is "
-               "reinterpreted as mmap<U> (i.e., `reinterpret<U>()`); got "
-               "sizeof(T) = "
-            << sizeof(T) << ", sizeof(U) = " << sizeof(U);
-      }
-      CHECK_EQ(reinterpret_cast<std::size_t>(mmaps_[i].get()) % alignof(U), 0)
-          << "data of mmap<T> must be " << alignof(U)
-          << "-byte aligned when reinterpreted as mmap<U> (i.e., "
-             "`reinterpret<U>()`) because alignof(U) = "
-          << alignof(U);
-      ptrs[i] = reinterpret_cast<U*>(mmaps_[i].get());
-      sizes[i] = mmaps_[i].size() * sizeof(T) / sizeof(U);
-    }
-    return mmaps<U, S>(ptrs, sizes);
+ protected:
+  explicit mmaps(std::array<mmap<T>, S>&& mmaps) : mmaps_(std::move(mmaps)) {}
+
+  // Returns `{make_mmap(0), make_mmap(1), ..., make_mmap(S - 1)}`.
+  template <typename MakeMmap>
+  static std::array<mmap<T>, S> make_array(const MakeMmap& make_mmap) {
+    return make_array(make_mmap, std::make_index_sequence<S>());
+  }
+  template <typename MakeMmap, size_t... i>
+  static std::array<mmap<T>, S> make_array(const MakeMmap& make_mmap,
+                                           std::index_sequence<i...>) {
+    return {make_mmap(i)...};
   }
 
+  template <typename U, uint64_t S2>
+  friend class mmaps;
+
  private:
   template <typename Param, typename Arg>
   friend struct internal::accessor;
@@ -444,6 +687,13 @@ class mmaps {
   int access_pos_ = 0;
 
   mmap<T> access() {
+    if (access_pos_ == 0) {
+      std::vector<internal::mmap_stats::channel_t> channels;
+      for (const mmap<T>& mem : mmaps_) {
+        channels.emplace_back(mem.get(), mem.size() * sizeof(T));
+      }
+      internal::mmap_stats::Register("mmaps", channels);
+    }
     LOG_IF(WARNING, access_pos_ >= S)
         << "invocation #" << access_pos_ << " accesses mmaps["
         << access_pos_ % S << "]";
@@ -462,6 +712,12 @@ class hmap : public mmap<T> {
         << "hmap<T, " << chan_count << ", " << chan_size
         << "> must have size = " << chan_size * chan_count << ", got "
         << this->size();
+    std::vector<internal::mmap_stats::channel_t> channels;
+    for (int i = 0; i < chan_count; ++i) {
+      channels.emplace_back(this->get() + i * chan_size,
+                            chan_size * sizeof(T));
+    }
+    internal::mmap_stats::Register("hmap", channels);
   }
 };
 
@@ -488,6 +744,10 @@ TAPA_DEFINE_MMAP(placeholder);
 TAPA_DEFINE_MMAP(read_only);
 TAPA_DEFINE_MMAP(write_only);
 TAPA_DEFINE_MMAP(read_write);
+TAPA_DEFINE_MMAP(scratch);
+TAPA_DEFINE_MMAP(init_once);
+TAPA_DEFINE_MMAP(read_back_last);
+TAPA_DEFINE_MMAP(host_only);
 #undef TAPA_DEFINE_MMAP
 
 // Host-only immap types that must have correct size.
@@ -562,24 +822,74 @@ TAPA_DEFINE_MMAPS(placeholder);
 TAPA_DEFINE_MMAPS(read_only);
 TAPA_DEFINE_MMAPS(write_only);
 TAPA_DEFINE_MMAPS(read_write);
+TAPA_DEFINE_MMAPS(scratch);
+TAPA_DEFINE_MMAPS(init_once);
+TAPA_DEFINE_MMAPS(read_back_last);
+TAPA_DEFINE_MMAPS(host_only);
 #undef TAPA_DEFINE_MMAPS
 
 namespace internal {
 
+template <typename T, typename Config>
+struct channel_traits<async_mmap<T, Config>> {
+  static void collect(const async_mmap<T, Config>& arg,
+                      std::vector<const void*>& channels) {
+    using addr_t = typename async_mmap<T, Config>::addr_t;
+    using resp_t = typename async_mmap<T, Config>::resp_t;
+    channel_traits<ostream<addr_t>>::collect(arg.read_addr, channels);
+    channel_traits<istream<T>>::collect(arg.read_data, channels);
+    channel_traits<ostream<addr_t>>::collect(arg.write_addr, channels);
+    channel_traits<ostream<T>>::collect(arg.write_data, channels);
+    channel_traits<istream<resp_t>>::collect(arg.write_resp, channels);
+  }
+};
+
+// Records the memory of `arg`, which may be of a class derived from `mmap<T>`,
+// e.g., `async_mmap<T>`.
+template <typename T>
+void record_mmap(const mmap<T>& arg, graph_ports& ports) {
+  ports.add_mmap(arg.get(), arg.size() * sizeof(T));
+}
+
+// Records the memory of each element of `arg`, which may be of a class derived
+// from `mmaps<T, S>`, e.g., `read_only_mmaps<T, S>`.
+template <typename T, uint64_t S>
+void record_mmaps(const mmaps<T, S>& arg, graph_ports& ports) {
+  for (int i = 0; i < int(S); ++i) record_mmap(arg[i], ports);
+}
+
 template <typename T>
-struct accessor<async_mmap<T>, mmap<T>&> {
+struct graph_traits<T, std::void_t<decltype(record_mmap(
+                           std::declval<const T&>(),
+                           std::declval<graph_ports&>()))>> {
+  static void record(const T& arg, graph_ports& ports) {
+    record_mmap(arg, ports);
+  }
+};
+
+template <typename T>
+struct graph_traits<T, std::void_t<decltype(record_mmaps(
+                           std::declval<const T&>(),
+                           std::declval<graph_ports&>()))>> {
+  static void record(const T& arg, graph_ports& ports) {
+    record_mmaps(arg, ports);
+  }
+};
+
+template <typename T, typename Config>
+struct accessor<async_mmap<T, Config>, mmap<T>&> {
   [[deprecated("please use async_mmap<T>& in formal parameters")]]  //
-  static async_mmap<T>
+  static async_mmap<T, Config>
   access(mmap<T>& arg) {
     LOG_FIRST_N(ERROR, 1) << "please use async_mmap<T>& in formal parameters";
-    return async_mmap<T>::schedule(arg);
+    return async_mmap<T, Config>::schedule(arg);
   }
 };
 
-template <typename T>
-struct accessor<async_mmap<T>&, mmap<T>&> {
-  static async_mmap<T> access(mmap<T>& arg) {
-    return async_mmap<T>::schedule(arg);
+template <typename T, typename Config>
+struct accessor<async_mmap<T, Config>&, mmap<T>&> {
+  static async_mmap<T, Config> access(mmap<T>& arg) {
+    return async_mmap<T, Config>::schedule(arg);
   }
 };
 
@@ -588,58 +898,77 @@ struct accessor<mmap<T>, mmaps<T, S>&> {
   static mmap<T> access(mmaps<T, S>& arg) { return arg.access(); }
 };
 
-template <typename T, uint64_t S>
-struct accessor<async_mmap<T>, mmaps<T, S>&> {
+template <typename T, typename Config, uint64_t S>
+struct accessor<async_mmap<T, Config>, mmaps<T, S>&> {
   [[deprecated("please use async_mmap<T>& in formal parameters")]]  //
-  static async_mmap<T>
+  static async_mmap<T, Config>
   access(mmaps<T, S>& arg) {
     LOG_FIRST_N(ERROR, 1) << "please use async_mmap<T>& in formal parameters";
-    return async_mmap<T>::schedule(arg.access());
+    return async_mmap<T, Config>::schedule(arg.access());
   }
 };
 
-template <typename T, uint64_t S>
-struct accessor<async_mmap<T>&, mmaps<T, S>&> {
-  static async_mmap<T> access(mmaps<T, S>& arg) {
-    return async_mmap<T>::schedule(arg.access());
+template <typename T, typename Config, uint64_t S>
+struct accessor<async_mmap<T, Config>&, mmaps<T, S>&> {
+  static async_mmap<T, Config> access(mmaps<T, S>& arg) {
+    return async_mmap<T, Config>::schedule(arg.access());
   }
 };
 
-#define TAPA_DEFINE_ACCESSER(tag, frt_tag)                         \
-  template <typename T>                                            \
-  struct accessor<mmap<T>, tag##_mmap<T>> {                        \
-    static mmap<T> access(tag##_mmap<T> arg) { return arg; }       \
-    static void access(fpga::Instance& instance, int& idx,         \
-                       tag##_mmap<T> arg) {                        \
-      auto buf = fpga::frt_tag(arg.get(), arg.size());             \
-      instance.SetArg(idx++, buf);                                 \
-    }                                                              \
-  };                                                               \
-  template <typename T, uint64_t S>                                \
-  struct accessor<mmaps<T, S>, tag##_mmaps<T, S>> {                \
-    static void access(fpga::Instance& instance, int& idx,         \
-                       tag##_mmaps<T, S> arg) {                    \
-      for (uint64_t i = 0; i < S; ++i) {                           \
-        auto buf = fpga::frt_tag(arg[i].get(), arg[i].size());     \
-        instance.SetArg(idx++, buf);                               \
-      }                                                            \
-    }                                                              \
-  };                                                               \
-  template <typename T, int chan_count, int64_t chan_size>         \
-  struct accessor<hmap<T, chan_count, chan_size>, tag##_mmap<T>> { \
-    static void access(fpga::Instance& instance, int& idx,         \
-                       tag##_mmap<T> arg) {                        \
-      for (int i = 0; i < chan_count; ++i) {                       \
-        auto buf = fpga::frt_tag(&arg[i * chan_size], chan_size);  \
-        instance.SetArg(idx++, buf);                               \
-      }                                                            \
-    }                                                              \
+#define TAPA_DEFINE_ACCESSER(tag, frt_tag)                            \
+  template <typename T>                                               \
+  struct accessor<mmap<T>, tag##_mmap<T>> {                           \
+    static mmap<T> access(tag##_mmap<T> arg) { return arg; }          \
+    static void access(fpga::Instance& instance, int& idx,            \
+                       tag##_mmap<T> arg) {                           \
+      auto buf = fpga::frt_tag(arg.get(), arg.size());                \
+      instance.SetArg(idx++, buf);                                    \
+    }                                                                 \
+    static void collect(const tag##_mmap<T>& arg,                     \
+                        std::vector<memory_region>& regions) {        \
+      regions.push_back({arg.get(), arg.size() * sizeof(T)});         \
+    }                                                                 \
+  };                                                                  \
+  template <typename T, uint64_t S>                                   \
+  struct accessor<mmaps<T, S>, tag##_mmaps<T, S>> {                   \
+    static void access(fpga::Instance& instance, int& idx,            \
+                       tag##_mmaps<T, S> arg) {                       \
+      for (uint64_t i = 0; i < S; ++i) {                              \
+        auto buf = fpga::frt_tag(arg[i].get(), arg[i].size());        \
+        instance.SetArg(idx++, buf);                                  \
+      }                                                               \
+    }                                                                 \
+    static void collect(tag##_mmaps<T, S> arg,                        \
+                        std::vector<memory_region>& regions) {        \
+      for (uint64_t i = 0; i < S; ++i) {                              \
+        regions.push_back({arg[i].get(), arg[i].size() * sizeof(T)}); \
+      }                                                               \
+    }                                                                 \
+  };                                                                  \
+  template <typename T, int chan_count, int64_t chan_size>            \
+  struct accessor<hmap<T, chan_count, chan_size>, tag##_mmap<T>> {    \
+    static void access(fpga::Instance& instance, int& idx,            \
+                       tag##_mmap<T> arg) {                           \
+      for (int i = 0; i < chan_count; ++i) {                          \
+        auto buf = fpga::frt_tag(&arg[i * chan_size], chan_size);     \
+        instance.SetArg(idx++, buf);                                  \
+      }                                                               \
+    }                                                                 \
+    static void collect(const tag##_mmap<T>& arg,                     \
+                        std::vector<memory_region>& regions) {        \
+      const size_t size = chan_count * chan_size * sizeof(T);         \
+      regions.push_back({arg.get(), size});                           \
+    }                                                                 \
   }
 TAPA_DEFINE_ACCESSER(placeholder, Placeholder);
 // read/write are with respect to the kernel in tapa but host in frt
 TAPA_DEFINE_ACCESSER(read_only, WriteOnly);
 TAPA_DEFINE_ACCESSER(write_only, ReadOnly);
 TAPA_DEFINE_ACCESSER(read_write, ReadWrite);
+TAPA_DEFINE_ACCESSER(scratch, Scratch);
+TAPA_DEFINE_ACCESSER(init_once, InitOnce);
+TAPA_DEFINE_ACCESSER(read_back_last, ReadBackLast);
+TAPA_DEFINE_ACCESSER(host_only, HostOnly);
 #undef TAPA_DEFINE_ACCESSER
 
 // If the user uses mmap/mmaps directly in tapa::invoke, it should be an error.
@@ -656,14 +985,16 @@ struct accessor<mmap<T>, mmap<T>> {
   static_assert(!std::is_same<T, T>::value,
                 "must use one of "
                 "placeholder_mmap/read_only_mmap/write_only_mmap/"
-                "read_write_mmap in tapa::invoke");
+                "read_write_mmap/scratch_mmap/init_once_mmap/"
+                "read_back_last_mmap/host_only_mmap in tapa::invoke");
 };
 template <typename T, int64_t S>
 struct accessor<mmaps<T, S>, mmaps<T, S>> {
   static_assert(!std::is_same<T, T>::value,
                 "must use one of "
                 "placeholder_mmaps/read_only_mmaps/write_only_mmaps/"
-                "read_write_mmaps in tapa::invoke");
+                "read_write_mmaps/scratch_mmaps/init_once_mmaps/"
+                "read_back_last_mmaps/host_only_mmaps in tapa::invoke");
 };
 
 }  // namespace internal
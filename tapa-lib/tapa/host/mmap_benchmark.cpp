@@ -0,0 +1,56 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/mmap.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "tapa/host/task.h"
+
+namespace tapa {
+namespace {
+
+// Copies `n` elements sequentially with as many outstanding requests as the
+// channels of `async_mmap` allow.
+void Copy(async_mmap<int>& src, async_mmap<int>& dst, int64_t n) {
+  for (int64_t read_req = 0, read_resp = 0, write_req = 0, write_resp = 0;
+       write_resp < n;) {
+    if (read_req < n && src.read_addr.try_write(read_req)) ++read_req;
+    int val;
+    if (write_req == read_resp && read_resp < n &&
+        src.read_data.try_read(val)) {
+      ++read_resp;
+    }
+    if (write_req < read_resp && !dst.write_addr.full() &&
+        !dst.write_data.full()) {
+      dst.write_addr.write(write_req);
+      dst.write_data.write(val);
+      ++write_req;
+    }
+    uint8_t resp;
+    if (dst.write_resp.try_read(resp)) write_resp += int64_t(resp) + 1;
+  }
+}
+
+void BM_AsyncMmapCopy(benchmark::State& state) {
+  const int64_t n = state.range(0);
+  std::vector<int> src(n, 1);
+  std::vector<int> dst(n);
+  mmap<int> src_mmap(src);
+  mmap<int> dst_mmap(dst);
+  for (auto _ : state) task().invoke(Copy, src_mmap, dst_mmap, n);
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetBytesProcessed(state.iterations() * n * 2 * sizeof(int));
+}
+BENCHMARK(BM_AsyncMmapCopy)
+    ->ArgName("n")
+    ->RangeMultiplier(16)
+    ->Range(1 << 10, 1 << 18)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace tapa
@@ -0,0 +1,194 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/mmap_stats.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "tapa/host/internal_util.h"
+
+namespace tapa::internal {
+
+namespace {
+
+const char* get_report_path() {
+  const char* path = getenv("TAPA_MMAP_STATS");
+  return path == nullptr || *path == '\0' ? nullptr : path;
+}
+
+uintptr_t to_int(const void* ptr) { return reinterpret_cast<uintptr_t>(ptr); }
+
+// Arrays registered since the last report.
+std::mutex registry_mtx;
+std::vector<std::shared_ptr<mmap_stats>> registry;
+std::vector<std::vector<mmap_stats::channel_t>> registered_channels;
+
+}  // namespace
+
+void mmap_stats::Register(const std::string& kind,
+                          const std::vector<channel_t>& channels) {
+  if (get_report_path() == nullptr) return;
+  std::unique_lock lock(registry_mtx);
+  if (std::find(registered_channels.begin(), registered_channels.end(),
+                channels) != registered_channels.end()) {
+    return;
+  }
+  registry.push_back(std::make_shared<mmap_stats>(kind, channels));
+  registered_channels.push_back(channels);
+}
+
+std::shared_ptr<mmap_stats> mmap_stats::Find(const void* base, uint64_t size) {
+  if (get_report_path() == nullptr) return nullptr;
+  std::unique_lock lock(registry_mtx);
+  for (const auto& stats : registry) {
+    if (stats->overlaps(base, size)) return stats;
+  }
+  return nullptr;
+}
+
+void mmap_stats::WriteReport() {
+  const char* path = get_report_path();
+  if (path == nullptr) return;
+
+  std::vector<std::shared_ptr<mmap_stats>> stats;
+  {
+    std::unique_lock lock(registry_mtx);
+    stats.swap(registry);
+    registered_channels.clear();
+  }
+  if (stats.empty()) return;
+
+  std::ofstream ofs(path);
+  ofs << "{\n  \"arrays\": [";
+  for (size_t i = 0; i < stats.size(); ++i) {
+    ofs << (i == 0 ? "\n    " : ",\n    ");
+    stats[i]->write(ofs);
+  }
+  ofs << "\n  ]\n}\n";
+  if (ofs.fail()) {
+    LOG(ERROR) << "failed to write memory statistics to '" << path << "'";
+  } else {
+    LOG(INFO) << "memory statistics are written to '" << path << "'";
+  }
+}
+
+mmap_stats::mmap_stats(const std::string& kind,
+                       const std::vector<channel_t>& channels)
+    : kind_(kind),
+      channels_(channels),
+      order_(channels.size()),
+      counters_(std::make_unique<counters_t[]>(channels.size())) {
+  std::iota(this->order_.begin(), this->order_.end(), 0);
+  std::sort(this->order_.begin(), this->order_.end(), [&](size_t a, size_t b) {
+    return to_int(channels[a].first) < to_int(channels[b].first);
+  });
+}
+
+void mmap_stats::record_read(const void* addr, uint64_t size, uint64_t count) {
+  this->split(addr, size, count,
+              [](counters_t& counters, uint64_t bytes, uint64_t requests) {
+                counters.read_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                counters.read_requests.fetch_add(requests,
+                                                 std::memory_order_relaxed);
+              });
+}
+
+void mmap_stats::record_write(const void* addr, uint64_t size, uint64_t count) {
+  this->split(addr, size, count,
+              [](counters_t& counters, uint64_t bytes, uint64_t requests) {
+                counters.write_bytes.fetch_add(bytes,
+                                               std::memory_order_relaxed);
+                counters.write_requests.fetch_add(requests,
+                                                  std::memory_order_relaxed);
+              });
+}
+
+template <typename Record>
+void mmap_stats::split(const void* addr, uint64_t size, uint64_t count,
+                       const Record& record) {
+  if (size == 0 || count == 0) return;
+  const uint64_t request_bytes = size / count;
+  const uintptr_t begin = to_int(addr);
+  const uintptr_t end = begin + size;
+
+  // Find the last channel that starts no later than `begin`.
+  auto it = std::upper_bound(
+      this->order_.begin(), this->order_.end(), begin,
+      [&](uintptr_t value, size_t i) {
+        return value < to_int(this->channels_[i].first);
+      });
+  if (it != this->order_.begin()) --it;
+
+  for (; it != this->order_.end(); ++it) {
+    const auto& [channel_base, channel_size] = this->channels_[*it];
+    const uintptr_t channel_begin = to_int(channel_base);
+    const uintptr_t channel_end = channel_begin + channel_size;
+    if (channel_begin >= end) break;
+    const uintptr_t overlap_begin = std::max(begin, channel_begin);
+    const uintptr_t overlap_end = std::min(end, channel_end);
+    if (overlap_begin >= overlap_end) continue;
+    const uint64_t bytes = overlap_end - overlap_begin;
+    record(this->counters_[*it], bytes, bytes / request_bytes);
+  }
+}
+
+bool mmap_stats::overlaps(const void* base, uint64_t size) const {
+  const uintptr_t begin = to_int(base);
+  const uintptr_t end = begin + std::max<uint64_t>(size, 1);
+  for (const auto& [channel_base, channel_size] : this->channels_) {
+    const uintptr_t channel_begin = to_int(channel_base);
+    if (channel_begin < end && begin < channel_begin + channel_size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void mmap_stats::write(std::ostream& os) const {
+  uint64_t max_bytes = 0;
+  uint64_t total_bytes = 0;
+  for (size_t i = 0; i < this->channels_.size(); ++i) {
+    const uint64_t bytes =
+        this->counters_[i].read_bytes.load(std::memory_order_relaxed) +
+        this->counters_[i].write_bytes.load(std::memory_order_relaxed);
+    max_bytes = std::max(max_bytes, bytes);
+    total_bytes += bytes;
+  }
+  const double imbalance =
+      total_bytes == 0 ? 1
+                       : double(max_bytes) * this->channels_.size() /
+                             double(total_bytes);
+
+  os << "{\"kind\": ";
+  WriteJsonString(os, this->kind_);
+  os << ", \"imbalance\": " << imbalance << ", \"channels\": [";
+  for (size_t i = 0; i < this->channels_.size(); ++i) {
+    const counters_t& counters = this->counters_[i];
+    os << (i == 0 ? "\n      " : ",\n      ") << "{\"index\": " << i
+       << ", \"base\": \"" << this->channels_[i].first
+       << "\", \"size\": " << this->channels_[i].second << ", \"read_bytes\": "
+       << counters.read_bytes.load(std::memory_order_relaxed)
+       << ", \"read_requests\": "
+       << counters.read_requests.load(std::memory_order_relaxed)
+       << ", \"write_bytes\": "
+       << counters.write_bytes.load(std::memory_order_relaxed)
+       << ", \"write_requests\": "
+       << counters.write_requests.load(std::memory_order_relaxed) << "}";
+  }
+  os << "\n    ]}";
+}
+
+}  // namespace tapa::internal
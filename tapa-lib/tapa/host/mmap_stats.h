@@ -0,0 +1,89 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef TAPA_HOST_MMAP_STATS_H_
+#define TAPA_HOST_MMAP_STATS_H_
+
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tapa::internal {
+
+// Per-channel memory traffic of a `tapa::mmaps` or `tapa::hmap` in software
+// simulation. Enabled by `TAPA_MMAP_STATS=<path>`, in which case statistics of
+// all channel arrays are written to `path` as a JSON report when the top-level
+// task finishes.
+//
+// Traffic is counted when `async_mmap` serves the requests, so accesses via
+// `tapa::mmap` are not counted. An `async_mmap` may span several channels,
+// e.g., of a `tapa::hmap`, in which case each access is counted by the channel
+// that it falls in.
+class mmap_stats {
+ public:
+  // Memory of a channel, as {base, size in bytes}.
+  using channel_t = std::pair<const void*, uint64_t>;
+
+  // Registers an array of `channels` to be included in the next report, if
+  // enabled and not yet registered.
+  static void Register(const std::string& kind,
+                       const std::vector<channel_t>& channels);
+
+  // Returns `nullptr` unless memory of `size` bytes at `base` overlaps a
+  // registered channel. Otherwise, returns statistics of its array.
+  static std::shared_ptr<mmap_stats> Find(const void* base, uint64_t size);
+
+  // Writes the report of arrays registered since the last report, if enabled.
+  // The report lists the bytes and requests of each channel in each direction,
+  // and the `imbalance` of each array, which is the traffic of the busiest
+  // channel over the average traffic of all channels.
+  static void WriteReport();
+
+  mmap_stats(const std::string& kind, const std::vector<channel_t>& channels);
+
+  // Not copyable or movable.
+  mmap_stats(const mmap_stats&) = delete;
+  mmap_stats& operator=(const mmap_stats&) = delete;
+
+  // Records `count` requests of `size` bytes in total starting at `addr`. May
+  // be called by multiple `async_mmap` in parallel.
+  void record_read(const void* addr, uint64_t size, uint64_t count);
+  void record_write(const void* addr, uint64_t size, uint64_t count);
+
+  // Writes the statistics as a JSON object.
+  void write(std::ostream& os) const;
+
+ private:
+  struct counters_t {
+    std::atomic<uint64_t> read_bytes{0};
+    std::atomic<uint64_t> read_requests{0};
+    std::atomic<uint64_t> write_bytes{0};
+    std::atomic<uint64_t> write_requests{0};
+  };
+
+  // Calls `record(counters, bytes, requests)` for each channel that the
+  // accesses fall in. Requests are split by their bytes.
+  template <typename Record>
+  void split(const void* addr, uint64_t size, uint64_t count,
+             const Record& record);
+
+  bool overlaps(const void* base, uint64_t size) const;
+
+  const std::string kind_;
+  const std::vector<channel_t> channels_;
+
+  // Indices to `channels_`, ordered by the base addresses.
+  std::vector<size_t> order_;
+
+  std::unique_ptr<counters_t[]> counters_;
+};
+
+}  // namespace tapa::internal
+
+#endif  // TAPA_HOST_MMAP_STATS_H_
@@ -0,0 +1,303 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/mmap.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tapa.h"
+
+namespace tapa {
+namespace {
+
+constexpr int kN = 4096;
+
+// Returns the address of the `i`-th access, which permutes the addresses into
+// runs of 16 sequential addresses separated by jumps.
+int64_t GetAddr(int64_t i) { return i ^ 0x150; }
+
+template <typename SrcMmap>
+void CopyFrom(SrcMmap& src, tapa::async_mmap<int>& dst) {
+  std::vector<int> values(kN);
+  int resp_count = 0;
+  for (int read_req = 0, read_resp = 0, write_req = 0; resp_count < kN;) {
+    if (read_req < kN && src.read_addr.try_write(GetAddr(read_req))) {
+      ++read_req;
+    }
+    if (read_resp < kN && src.read_data.try_read(values[read_resp])) {
+      ++read_resp;
+    }
+    if (read_resp > write_req && !dst.write_addr.full() &&
+        !dst.write_data.full()) {
+      dst.write_addr.write(GetAddr(write_req));
+      dst.write_data.write(values[write_req]);
+      ++write_req;
+    }
+    uint8_t resp;
+    if (dst.write_resp.try_read(resp)) resp_count += int(resp) + 1;
+  }
+}
+
+void Copy(tapa::async_mmap<int>& src, tapa::async_mmap<int>& dst) {
+  CopyFrom(src, dst);
+}
+
+void CopyFromConfigured(
+    tapa::async_mmap<int, tapa::async_mmap_config<16, 64>>& src,
+    tapa::async_mmap<int>& dst) {
+  CopyFrom(src, dst);
+}
+
+// Arrays of mmap are stored in place.
+static_assert(sizeof(mmaps<int, 4>) <= 4 * sizeof(mmap<int>) + sizeof(int64_t));
+
+TEST(MmapsTest, SlicingAndReinterpretingKeepsMemory) {
+  std::vector<std::vector<int>> vecs(4, std::vector<int>(16));
+  tapa::mmaps<int, 4> mems(vecs);
+
+  tapa::mmaps<int, 2> slice = mems.slice<1, 2>();
+  EXPECT_EQ(slice[0].get(), vecs[1].data());
+  EXPECT_EQ(slice[1].get(), vecs[2].data());
+
+  tapa::mmaps<int64_t, 4> reinterpreted = mems.reinterpret<int64_t>();
+  tapa::mmaps<vec_t<int, 4>, 4> vectorized = mems.vectorized<4>();
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(static_cast<void*>(reinterpreted[i].get()), vecs[i].data());
+    EXPECT_EQ(reinterpreted[i].size(), 8);
+    EXPECT_EQ(static_cast<void*>(vectorized[i].get()), vecs[i].data());
+    EXPECT_EQ(vectorized[i].size(), 4);
+  }
+}
+
+// Copies `src` to `dst` in blocks of 100 elements through a local buffer.
+void CopyInBlocks(tapa::mmap<const int> src, tapa::mmap<int> dst, int n) {
+  int buf[100];
+  for (int i = 0; i < n; i += 100) {
+    const int len = std::min(n - i, 100);
+    tapa::load(src, i, buf, len);
+    for (int j = 0; j < len; ++j) buf[j] += 1;
+    tapa::store(dst, i, buf, len);
+  }
+}
+
+TEST(MmapTest, LoadingAndStoringCopiesElements) {
+  std::vector<int> src(kN + 50), dst(kN + 50, -1);
+  for (int i = 0; i < kN + 50; ++i) src[i] = i;
+  tapa::mmap<const int> src_mmap(src);
+  tapa::mmap<int> dst_mmap(dst);
+  tapa::task().invoke(CopyInBlocks, src_mmap, dst_mmap, kN + 30);
+  for (int i = 0; i < kN + 30; ++i) ASSERT_EQ(dst[i], i + 1) << i;
+  for (int i = kN + 30; i < kN + 50; ++i) ASSERT_EQ(dst[i], -1) << i;
+}
+
+TEST(AsyncMmapTest, CopyingWithMixedAccessPatternsSucceeds) {
+  std::vector<int> src(kN);
+  std::vector<int> dst(kN, -1);
+  for (int i = 0; i < kN; ++i) src[i] = i * 3;
+  tapa::mmap<int> src_mmap(src);
+  tapa::mmap<int> dst_mmap(dst);
+  tapa::task().invoke(Copy, src_mmap, dst_mmap);
+  EXPECT_EQ(dst, src);
+}
+
+TEST(AsyncMmapTest, HardwareConfigDoesNotChangeSoftwareSimulation) {
+  std::vector<int> src(kN);
+  std::vector<int> dst(kN, -1);
+  for (int i = 0; i < kN; ++i) src[i] = i * 3;
+  tapa::mmap<int> src_mmap(src);
+  tapa::mmap<int> dst_mmap(dst);
+  tapa::task().invoke(CopyFromConfigured, src_mmap, dst_mmap);
+  EXPECT_EQ(dst, src);
+}
+
+// Writes `n` elements at `stride` apart from `base`, and checks that each
+// write response acknowledges a burst of at most `max_burst_len` writes.
+template <typename Mmap>
+void WriteAndCountResponses(Mmap& mem, int base, int stride, int n,
+                            int max_burst_len, tapa::ostream<int>& resp_q) {
+  int resp_count = 0;
+  for (int i = 0, write_count = 0; write_count < n;) {
+    if (i < n && !mem.write_addr.full() && !mem.write_data.full()) {
+      mem.write_addr.write(base + i * stride);
+      mem.write_data.write(i);
+      ++i;
+    }
+    uint8_t resp;
+    if (mem.write_resp.try_read(resp)) {
+      EXPECT_LE(int(resp) + 1, max_burst_len);
+      write_count += int(resp) + 1;
+      ++resp_count;
+    }
+  }
+  resp_q.write(resp_count);
+}
+
+void WriteWithDefaultConfig(tapa::async_mmap<int>& mem, int base, int stride,
+                            int n, int max_burst_len,
+                            tapa::ostream<int>& resp_q) {
+  WriteAndCountResponses(mem, base, stride, n, max_burst_len, resp_q);
+}
+
+void WriteWithShortBursts(
+    tapa::async_mmap<int, tapa::async_mmap_config<0, 16>>& mem, int base,
+    int stride, int n, int max_burst_len, tapa::ostream<int>& resp_q) {
+  WriteAndCountResponses(mem, base, stride, n, max_burst_len, resp_q);
+}
+
+TEST(AsyncMmapTest, WritesAreAcknowledgedPerBurst) {
+  std::vector<int> mem(kN);
+  tapa::mmap<int> mem_mmap(mem);
+  tapa::streams<int, 3, 1> resp_q;
+
+  tapa::task()
+      // Non-sequential writes are acknowledged one by one.
+      .invoke(WriteWithDefaultConfig, mem_mmap, 0, 2, 100, 1, resp_q[0])
+      // Bursts of 1 KB do not cross the 4 KB boundary at element 1024.
+      .invoke(WriteWithDefaultConfig, mem_mmap, 1000, 1, 100, 256, resp_q[1])
+      // Bursts are limited by the config of the port.
+      .invoke(WriteWithShortBursts, mem_mmap, 2048, 1, 64, 16, resp_q[2]);
+  EXPECT_EQ(resp_q[0].read(), 100);
+  EXPECT_GE(resp_q[1].read(), 2);
+  EXPECT_GE(resp_q[2].read(), 4);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(mem[i * 2], i);
+    EXPECT_EQ(mem[1000 + i], i);
+  }
+  EXPECT_EQ(mem[2048 + 63], 63);
+}
+
+// Writes data at addresses [1, kN], and then sets a flag at address 0.
+void WriteDataThenFlag(tapa::async_mmap<int>& mem) {
+  for (int i = 1, resp_count = 0; resp_count < kN;) {
+    if (i <= kN && !mem.write_addr.full() && !mem.write_data.full()) {
+      mem.write_addr.write(i);
+      mem.write_data.write(i * 3);
+      ++i;
+    }
+    uint8_t resp;
+    if (mem.write_resp.try_read(resp)) resp_count += int(resp) + 1;
+  }
+  mem.write_addr.write(0);
+  mem.write_data.write(1);
+  mem.write_resp.read();
+}
+
+// Waits for the flag at address 0, and then reads data at [1, kN].
+void ReadDataAfterFlag(tapa::async_mmap<int>& mem) {
+  do {
+    mem.read_addr.write(0);
+  } while (mem.read_data.read() == 0);
+  for (int i = 1, read_resp = 1; read_resp <= kN;) {
+    if (i <= kN && mem.read_addr.try_write(i)) ++i;
+    int value;
+    if (mem.read_data.try_read(value)) {
+      EXPECT_EQ(value, read_resp * 3);
+      ++read_resp;
+    }
+  }
+}
+
+TEST(AsyncMmapTest, SharedMemoryIsConsistentAcrossPorts) {
+  ASSERT_EQ(setenv("TAPA_SHARED_MMAP", "1", /*replace=*/1), 0);
+  std::vector<int> mem(kN + 1);
+  tapa::mmap<int> producer_mmap(mem);
+  tapa::mmap<int> consumer_mmap(mem);
+  tapa::task()
+      .invoke(WriteDataThenFlag, producer_mmap)
+      .invoke(ReadDataAfterFlag, consumer_mmap);
+  EXPECT_EQ(unsetenv("TAPA_SHARED_MMAP"), 0);
+  EXPECT_EQ(mem[kN], kN * 3);
+}
+
+TEST(AsyncMmapTest, WritingTimingReportSucceeds) {
+  const std::string path = testing::TempDir() + "mmap_timing.json";
+  ASSERT_EQ(setenv("TAPA_MMAP_TIMING", path.c_str(), /*replace=*/1), 0);
+  std::vector<int> src(kN);
+  std::vector<int> dst(kN);
+  tapa::mmap<int> src_mmap(src);
+  tapa::mmap<int> dst_mmap(dst);
+  tapa::task().invoke(Copy, src_mmap, dst_mmap);
+  EXPECT_EQ(unsetenv("TAPA_MMAP_TIMING"), 0);
+
+  std::ifstream ifs(path);
+  const std::string report((std::istreambuf_iterator<char>(ifs)),
+                           std::istreambuf_iterator<char>());
+  EXPECT_NE(report.find("\"read_bytes\": 16384, \"read_bursts\": 256"),
+            std::string::npos)
+      << report;
+  EXPECT_NE(report.find("\"write_bytes\": 16384, \"write_bursts\": 256"),
+            std::string::npos)
+      << report;
+}
+
+TEST(AsyncMmapTest, WritingChannelStatsReportSucceeds) {
+  const std::string path = testing::TempDir() + "mmap_stats.json";
+  ASSERT_EQ(setenv("TAPA_MMAP_STATS", path.c_str(), /*replace=*/1), 0);
+  std::vector<std::vector<int>> src(2, std::vector<int>(kN));
+  std::vector<std::vector<int>> dst(2, std::vector<int>(kN));
+  tapa::mmaps<int, 2> src_mmaps(src);
+  tapa::mmaps<int, 2> dst_mmaps(dst);
+  tapa::task().invoke<tapa::join, 2>(Copy, src_mmaps, dst_mmaps);
+  EXPECT_EQ(unsetenv("TAPA_MMAP_STATS"), 0);
+
+  std::ifstream ifs(path);
+  const std::string report((std::istreambuf_iterator<char>(ifs)),
+                           std::istreambuf_iterator<char>());
+  EXPECT_NE(report.find("\"read_bytes\": 16384, \"read_requests\": 4096, "
+                        "\"write_bytes\": 0, \"write_requests\": 0}"),
+            std::string::npos)
+      << report;
+  EXPECT_NE(report.find("\"read_bytes\": 0, \"read_requests\": 0, "
+                        "\"write_bytes\": 16384, \"write_requests\": 4096}"),
+            std::string::npos)
+      << report;
+}
+
+TEST(MmapStatsTest, AccessesAreSplitByChannels) {
+  std::vector<int> mem(64);
+  internal::mmap_stats stats("hmap", {{&mem[0], 32 * sizeof(int)},
+                                      {&mem[32], 32 * sizeof(int)}});
+  stats.record_read(&mem[24], 16 * sizeof(int), 16);
+  stats.record_write(&mem[40], 8 * sizeof(int), 8);
+  std::ostringstream oss;
+  stats.write(oss);
+  // Channel 1 has 16 of the 24 words accessed, i.e., 4/3 of the average.
+  EXPECT_NE(oss.str().find("\"imbalance\": 1.33333"), std::string::npos)
+      << oss.str();
+  EXPECT_NE(oss.str().find("\"read_bytes\": 32, \"read_requests\": 8, "
+                           "\"write_bytes\": 32, \"write_requests\": 8}"),
+            std::string::npos)
+      << oss.str();
+}
+
+TEST(MmapTimingTest, SequentialAccessesAreBoundByBandwidth) {
+  internal::mmap_timing timing(nullptr, 1 << 20, {});
+  for (uint64_t offset = 0; offset < (1 << 20); offset += 64) {
+    timing.record_read(offset, 64);
+  }
+  // 256 bursts of 4 KiB take 86 cycles each at 48 bytes per cycle, after the
+  // first one is issued and its latency expires.
+  EXPECT_EQ(timing.cycles(), 1 + 100 + 256 * 86);
+}
+
+TEST(MmapTimingTest, RandomAccessesAreBoundByLatency) {
+  internal::mmap_timing::options_t options;
+  options.max_outstanding_bursts = 1;
+  internal::mmap_timing timing(nullptr, 1 << 20, options);
+  for (uint64_t i = 0; i < 10; ++i) timing.record_write(i * 8192, 64);
+  // Each burst is issued when the previous one finishes, and takes 100 cycles
+  // of latency plus 2 cycles of data.
+  EXPECT_EQ(timing.cycles(), 1 + 10 * (100 + 2));
+}
+
+}  // namespace
+}  // namespace tapa
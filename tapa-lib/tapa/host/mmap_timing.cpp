@@ -0,0 +1,165 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/mmap_timing.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace tapa::internal {
+
+namespace {
+
+const char* get_report_path() {
+  const char* path = getenv("TAPA_MMAP_TIMING");
+  return path == nullptr || *path == '\0' ? nullptr : path;
+}
+
+template <typename T>
+void get_option(const char* name, T& value) {
+  if (const char* env = getenv(name)) {
+    const double parsed = strtod(env, nullptr);
+    if (parsed > 0) {
+      value = T(parsed);
+    } else {
+      LOG(WARNING) << name << " must be positive; using " << value;
+    }
+  }
+}
+
+// Ports created since the last report.
+std::mutex registry_mtx;
+std::vector<std::shared_ptr<mmap_timing>> registry;
+
+}  // namespace
+
+std::shared_ptr<mmap_timing> mmap_timing::New(const void* base,
+                                              uint64_t size) {
+  if (get_report_path() == nullptr) return nullptr;
+  options_t options;
+  get_option("TAPA_MMAP_CLOCK", options.clock_mhz);
+  get_option("TAPA_MMAP_BANDWIDTH", options.bandwidth_gbps);
+  get_option("TAPA_MMAP_LATENCY_CYCLES", options.latency_cycles);
+  get_option("TAPA_MMAP_BURST", options.burst_bytes);
+  get_option("TAPA_MMAP_OUTSTANDING_BURSTS", options.max_outstanding_bursts);
+  auto timing = std::make_shared<mmap_timing>(base, size, options);
+  std::unique_lock lock(registry_mtx);
+  registry.push_back(timing);
+  return timing;
+}
+
+void mmap_timing::WriteReport() {
+  const char* path = get_report_path();
+  if (path == nullptr) return;
+
+  std::vector<std::shared_ptr<mmap_timing>> ports;
+  {
+    std::unique_lock lock(registry_mtx);
+    ports.swap(registry);
+  }
+  if (ports.empty()) return;
+
+  // Ports run in parallel, so the slowest one determines the total.
+  uint64_t cycles = 0;
+  for (const auto& port : ports) cycles = std::max(cycles, port->cycles());
+
+  std::ofstream ofs(path);
+  ofs << "{\n  \"clock_mhz\": " << ports.front()->options_.clock_mhz
+      << ",\n  \"cycles\": " << cycles << ",\n  \"ports\": [";
+  for (size_t i = 0; i < ports.size(); ++i) {
+    ofs << (i == 0 ? "\n    " : ",\n    ");
+    ports[i]->write(ofs);
+  }
+  ofs << "\n  ]\n}\n";
+  if (ofs.fail()) {
+    LOG(ERROR) << "failed to write memory timing to '" << path << "'";
+  } else {
+    LOG(INFO) << "memory timing is written to '" << path << "'";
+  }
+}
+
+mmap_timing::mmap_timing(const void* base, uint64_t size,
+                         const options_t& options)
+    : base_(base),
+      size_(size),
+      options_(options),
+      bytes_per_cycle_(options.bandwidth_gbps * 1e3 / options.clock_mhz) {}
+
+void mmap_timing::record_read(uint64_t offset, uint64_t size) {
+  std::unique_lock lock(this->mtx_);
+  this->record(this->reads_, offset, size);
+}
+
+void mmap_timing::record_write(uint64_t offset, uint64_t size) {
+  std::unique_lock lock(this->mtx_);
+  this->record(this->writes_, offset, size);
+}
+
+uint64_t mmap_timing::cycles() {
+  std::unique_lock lock(this->mtx_);
+  this->close_burst(this->reads_);
+  this->close_burst(this->writes_);
+  return std::max(this->reads_.data_end_cycle, this->writes_.data_end_cycle);
+}
+
+void mmap_timing::write(std::ostream& os) {
+  const uint64_t cycles = this->cycles();
+  std::unique_lock lock(this->mtx_);
+  const uint64_t bytes = this->reads_.bytes + this->writes_.bytes;
+  const double gbps =
+      cycles == 0 ? 0 : bytes * this->options_.clock_mhz / cycles / 1e3;
+  os << "{\"base\": \"" << this->base_ << "\", \"size\": " << this->size_
+     << ", \"read_bytes\": " << this->reads_.bytes
+     << ", \"read_bursts\": " << this->reads_.bursts
+     << ", \"write_bytes\": " << this->writes_.bytes
+     << ", \"write_bursts\": " << this->writes_.bursts
+     << ", \"cycles\": " << cycles << ", \"gbps\": " << gbps << "}";
+}
+
+void mmap_timing::record(channel_t& channel, uint64_t offset, uint64_t size) {
+  const uint64_t burst_bytes = this->options_.burst_bytes;
+  channel.bytes += size;
+  while (size > 0) {
+    if (channel.burst_end != offset || offset % burst_bytes == 0) {
+      this->close_burst(channel);
+      channel.burst_begin = channel.burst_end = offset;
+    }
+    const uint64_t boundary = (offset / burst_bytes + 1) * burst_bytes;
+    const uint64_t n = std::min(size, boundary - offset);
+    channel.burst_end += n;
+    offset += n;
+    size -= n;
+  }
+}
+
+void mmap_timing::close_burst(channel_t& channel) {
+  if (channel.burst_end == channel.burst_begin) return;
+  uint64_t issue_cycle = channel.issue_cycle + 1;
+  if (channel.pending.size() >= this->options_.max_outstanding_bursts) {
+    issue_cycle = std::max(issue_cycle, channel.pending.front());
+    channel.pending.pop_front();
+  }
+  const uint64_t data_cycles = uint64_t(std::ceil(
+      (channel.burst_end - channel.burst_begin) / this->bytes_per_cycle_));
+  channel.issue_cycle = issue_cycle;
+  channel.data_end_cycle =
+      std::max(issue_cycle + this->options_.latency_cycles,
+               channel.data_end_cycle) +
+      data_cycles;
+  channel.pending.push_back(channel.data_end_cycle);
+  ++channel.bursts;
+  channel.burst_begin = channel.burst_end;
+}
+
+}  // namespace tapa::internal
@@ -0,0 +1,91 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef TAPA_HOST_MMAP_TIMING_H_
+#define TAPA_HOST_MMAP_TIMING_H_
+
+#include <cstdint>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+namespace tapa::internal {
+
+// Cycle-approximate timing model of a memory port in software simulation.
+// Enabled by `TAPA_MMAP_TIMING=<path>`, in which case the estimated cycles and
+// bandwidth of all ports are written to `path` as a JSON report when the
+// top-level task finishes.
+//
+// Each port has a virtual clock. Sequential accesses are coalesced into bursts
+// that do not cross `burst_bytes` boundaries. A burst is issued one cycle after
+// the previous one unless `max_outstanding_bursts` are in flight, and its data
+// are transferred at `bandwidth_gbps` after `latency_cycles`. Reads and writes
+// are independent as they are in AXI.
+class mmap_timing {
+ public:
+  struct options_t {
+    double clock_mhz = 300;                // TAPA_MMAP_CLOCK
+    double bandwidth_gbps = 14.4;          // TAPA_MMAP_BANDWIDTH
+    uint64_t latency_cycles = 100;         // TAPA_MMAP_LATENCY_CYCLES
+    uint64_t burst_bytes = 4096;           // TAPA_MMAP_BURST
+    uint64_t max_outstanding_bursts = 16;  // TAPA_MMAP_OUTSTANDING_BURSTS
+  };
+
+  // Returns `nullptr` unless the model is enabled. Otherwise, returns a new
+  // port for memory of `size` bytes at `base`, which is included in the next
+  // report.
+  static std::shared_ptr<mmap_timing> New(const void* base, uint64_t size);
+
+  // Writes the report of ports created since the last report, if enabled.
+  static void WriteReport();
+
+  mmap_timing(const void* base, uint64_t size, const options_t& options);
+
+  // Not copyable or movable.
+  mmap_timing(const mmap_timing&) = delete;
+  mmap_timing& operator=(const mmap_timing&) = delete;
+
+  // Records accesses to `size` bytes starting at byte `offset`.
+  void record_read(uint64_t offset, uint64_t size);
+  void record_write(uint64_t offset, uint64_t size);
+
+  // Returns the estimated cycles to finish all recorded accesses.
+  uint64_t cycles();
+
+  // Writes the estimation as a JSON object.
+  void write(std::ostream& os);
+
+ private:
+  // Accesses in one direction, i.e., reads or writes.
+  struct channel_t {
+    uint64_t bytes = 0;
+    uint64_t bursts = 0;
+
+    // The open burst, which is extended by sequential accesses.
+    uint64_t burst_begin = 0;
+    uint64_t burst_end = 0;
+
+    uint64_t issue_cycle = 0;      // When the last burst is issued.
+    uint64_t data_end_cycle = 0;   // When the data bus becomes free.
+    std::deque<uint64_t> pending;  // End cycles of bursts in flight.
+  };
+
+  void record(channel_t& channel, uint64_t offset, uint64_t size);
+  void close_burst(channel_t& channel);
+
+  const void* const base_;
+  const uint64_t size_;
+  const options_t options_;
+  const double bytes_per_cycle_;
+
+  std::mutex mtx_;  // The memory system and the report may run in parallel.
+  channel_t reads_;
+  channel_t writes_;
+};
+
+}  // namespace tapa::internal
+
+#endif  // TAPA_HOST_MMAP_TIMING_H_
@@ -0,0 +1,273 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "tapa/host/stream.h"
+
+#ifdef __SYNTHESIS__
+#error tapa::mpmc_stream is not synthesizable
+#endif
+
+namespace tapa {
+namespace internal {
+
+// Bounded ring buffer that multiple producers and consumers may access
+// concurrently. Each cell carries a sequence number telling which lap of the
+// ring it is ready for, so that producers and consumers only contend on their
+// own position:
+//
+// - A cell at position `pos` is writable if its sequence is `pos`.
+// - A cell at position `pos` is readable if its sequence is `pos + 1`.
+//
+// The buffer size is rounded up to a power of two.
+template <typename T>
+class mpmc_queue final : public base_queue<T> {
+  struct alignas(kCacheLineSize) cell_t {
+    std::atomic<uint64_t> seq;
+    T elem;
+  };
+  struct alignas(kCacheLineSize) position_t {
+    std::atomic<uint64_t> pos{0};
+  };
+  position_t producer;
+  position_t consumer;
+
+  const bool is_multi_consumer;
+  const uint64_t mask;
+  std::unique_ptr<cell_t[]> cells;
+
+  static uint64_t round_up_to_power_of_two(uint64_t n) {
+    uint64_t size = 1;
+    while (size < n) size <<= 1;
+    return size;
+  }
+
+  // Pushes `elem` unless the queue is full. Returns whether `elem` is pushed.
+  template <typename U>
+  bool try_push(U&& elem) {
+    uint64_t pos = this->producer.pos.load(std::memory_order_relaxed);
+    while (true) {
+      cell_t& cell = this->cells[pos & this->mask];
+      const auto diff = static_cast<int64_t>(
+          cell.seq.load(std::memory_order_acquire) - pos);
+      if (diff < 0) return false;  // Not yet read in the last lap.
+      if (diff > 0) {              // Taken by another producer.
+        pos = this->producer.pos.load(std::memory_order_relaxed);
+      } else if (this->producer.pos.compare_exchange_weak(
+                     pos, pos + 1, std::memory_order_relaxed)) {
+        this->maybe_log(elem);
+        cell.elem = std::forward<U>(elem);
+        cell.seq.store(pos + 1);
+        this->notify();
+        return true;
+      }
+    }
+  }
+
+  // Pops a token into `elem` unless the queue is empty. Returns whether
+  // `elem` is updated.
+  bool try_pop(T& elem) {
+    uint64_t pos = this->consumer.pos.load(std::memory_order_relaxed);
+    while (true) {
+      cell_t& cell = this->cells[pos & this->mask];
+      const auto diff = static_cast<int64_t>(
+          cell.seq.load(std::memory_order_acquire) - (pos + 1));
+      if (diff < 0) return false;  // Not yet written in this lap.
+      if (diff > 0) {              // Taken by another consumer.
+        pos = this->consumer.pos.load(std::memory_order_relaxed);
+      } else if (this->consumer.pos.compare_exchange_weak(
+                     pos, pos + 1, std::memory_order_relaxed)) {
+        elem = std::move(cell.elem);
+        cell.seq.store(pos + this->mask + 1);
+        this->notify();
+        return true;
+      }
+    }
+  }
+
+  template <typename U>
+  void push_impl(U&& elem) {
+    // `wait` may evaluate its predicate more than once, so the predicate must
+    // not push by itself.
+    while (!this->try_push(std::forward<U>(elem))) {
+      this->wait([this] { return !this->full(); },
+                 yield_reason::kChannelFull);
+    }
+  }
+
+ public:
+  // constructors
+  mpmc_queue(size_t depth, const std::string& name, bool is_multi_consumer)
+      : base_queue<T>(name, /*has_stats=*/false),
+        is_multi_consumer(is_multi_consumer),
+        mask(round_up_to_power_of_two(depth) - 1),
+        cells(new cell_t[this->mask + 1]) {
+    CHECK_NE(depth, ::tapa::kStreamInfiniteDepth)
+        << "channel '" << name << "' must have a bounded depth";
+    for (uint64_t i = 0; i <= this->mask; ++i) {
+      this->cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // debug helpers
+  uint64_t get_depth() const { return this->mask + 1; }
+
+  // basic queue operations
+  //
+  // `empty` and `full` may be outdated as soon as they return if there is more
+  // than one consumer or producer, respectively.
+  bool empty() const override {
+    const uint64_t pos = this->consumer.pos.load(std::memory_order_relaxed);
+    return this->cells[pos & this->mask].seq.load(std::memory_order_acquire) !=
+           pos + 1;
+  }
+  bool full() const override {
+    const uint64_t pos = this->producer.pos.load(std::memory_order_relaxed);
+    return this->cells[pos & this->mask].seq.load(std::memory_order_acquire) !=
+           pos;
+  }
+  const T& front() const override {
+    // The next token may be taken by another consumer while being peeked.
+    if (this->is_multi_consumer) {
+      LOG(FATAL) << "channel '" << this->get_name()
+                 << "' peeked with multiple consumers";
+    }
+    return this->cells[this->consumer.pos.load(std::memory_order_relaxed) &
+                       this->mask]
+        .elem;
+  }
+  T pop() override {
+    // Another consumer may pop the token after the caller sees the queue is
+    // not empty, in which case this waits for the next token.
+    T elem;
+    while (!this->try_pop(elem)) {
+      this->wait([this] { return !this->empty(); },
+                 yield_reason::kChannelEmpty);
+    }
+    return elem;
+  }
+  void push(const T& elem) override { this->push_impl(elem); }
+  void push(T&& elem) override { this->push_impl(std::move(elem)); }
+
+  ~mpmc_queue() { this->check_leftover(); }
+};
+
+template <typename T, uint64_t N>
+class basic_mpmc_stream : public unbound_stream<T> {
+ public:
+  /// Depth of the communication channel.
+  constexpr static int depth = N;
+
+ protected:
+  basic_mpmc_stream() : basic_stream<T>(nullptr) {}
+
+  static std::shared_ptr<base_queue<elem_t<T>>> make_queue(
+      const std::string& name, bool is_multi_consumer) {
+    return std::make_shared<mpmc_queue<elem_t<T>>>(N, name, is_multi_consumer);
+  }
+};
+
+}  // namespace internal
+
+/// Defines a communication channel that multiple task instances may write to
+/// and read from concurrently, e.g., to fan in results from worker tasks to a
+/// collector task without a dedicated stream per worker.
+///
+/// Tokens written by the same producer are read in the order they are written,
+/// but tokens of different producers may interleave in any order. Each
+/// producer that calls @c close writes its own EoT token, so consumers should
+/// expect one EoT per closing producer.
+///
+/// Consumers can not peek the stream, which includes @c peek, @c eot, and bulk
+/// reads like @c read_n, because the next token may be taken by another
+/// consumer meanwhile. Consumers should therefore agree on the number of tokens
+/// to read instead of testing for EoT. For the same reason, a non-blocking read
+/// may wait for the next token if another consumer reads first. Use
+/// @c tapa::mpsc_stream if there is only one consumer, e.g.:
+///
+/// @code{.cpp}
+///  ...
+///  #include <tapa.h>
+///  #include <tapa/host/mpmc_stream.h>
+///  ...
+///  tapa::mpsc_stream<int> result_q("result");
+///  tapa::task()
+///      .invoke<tapa::join, kWorkerCount>(Worker, result_q)
+///      .invoke(Collector, result_q);
+/// @endcode
+///
+/// The channel is not included in @c TAPA_STREAM_STATS reports.
+///
+/// Software simulation only; NOT synthesizable.
+template <typename T, uint64_t N = kStreamDefaultDepth>
+class mpmc_stream : public internal::basic_mpmc_stream<T, N> {
+ public:
+  /// Constructs a @c tapa::mpmc_stream.
+  mpmc_stream()
+      : internal::basic_stream<T>(
+            mpmc_stream::make_queue("", /*is_multi_consumer=*/true)) {}
+
+  /// Constructs a @c tapa::mpmc_stream with the given name for debugging.
+  ///
+  /// @param[in] name Name of the communication channel (for debugging only).
+  template <size_t S>
+  mpmc_stream(const char (&name)[S])
+      : internal::basic_stream<T>(
+            mpmc_stream::make_queue(name, /*is_multi_consumer=*/true)) {}
+};
+
+/// Same as @c tapa::mpmc_stream, but with only one consumer, which can use
+/// all consumer-side operations.
+///
+/// Software simulation only; NOT synthesizable.
+template <typename T, uint64_t N = kStreamDefaultDepth>
+class mpsc_stream : public internal::basic_mpmc_stream<T, N> {
+ public:
+  /// Constructs a @c tapa::mpsc_stream.
+  mpsc_stream()
+      : internal::basic_stream<T>(
+            mpsc_stream::make_queue("", /*is_multi_consumer=*/false)) {}
+
+  /// Constructs a @c tapa::mpsc_stream with the given name for debugging.
+  ///
+  /// @param[in] name Name of the communication channel (for debugging only).
+  template <size_t S>
+  mpsc_stream(const char (&name)[S])
+      : internal::basic_stream<T>(
+            mpsc_stream::make_queue(name, /*is_multi_consumer=*/false)) {}
+};
+
+namespace internal {
+
+#define TAPA_DEFINE_MPMC_ACCESSER(io, kind)                                 \
+  template <typename T, uint64_t N, typename U>                             \
+  struct accessor<io##stream<T>&, kind##_stream<U, N>&> {                   \
+    static io##stream<T> access(kind##_stream<U, N>& arg) { return arg; }   \
+    static void access(fpga::Instance& instance, int& idx,                  \
+                       kind##_stream<U, N>& arg) {                          \
+      LOG(FATAL) << "channel '" << arg.get_name()                           \
+                 << "' is not synthesizable; use tapa::stream instead";     \
+    }                                                                       \
+  };
+
+TAPA_DEFINE_MPMC_ACCESSER(i, mpmc)
+TAPA_DEFINE_MPMC_ACCESSER(o, mpmc)
+TAPA_DEFINE_MPMC_ACCESSER(i, mpsc)
+TAPA_DEFINE_MPMC_ACCESSER(o, mpsc)
+
+#undef TAPA_DEFINE_MPMC_ACCESSER
+
+}  // namespace internal
+}  // namespace tapa
@@ -0,0 +1,79 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/mpmc_stream.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tapa.h"
+
+namespace tapa {
+namespace {
+
+constexpr int kProducerCount = 4;
+constexpr int kN = 5000;
+
+void Producer(tapa::ostream<int>& data_out_q, int id, bool close) {
+  for (int i = 0; i < kN; ++i) data_out_q.write(id * kN + i);
+  if (close) data_out_q.close();
+}
+
+void Collector(tapa::istream<int>& data_in_q, std::vector<int>* tokens) {
+  for (int eot_count = 0; eot_count < kProducerCount;) {
+    bool is_eot;
+    if (!data_in_q.try_eot(is_eot)) continue;
+    if (is_eot) {
+      data_in_q.open();
+      ++eot_count;
+    } else {
+      tokens->push_back(data_in_q.read());
+    }
+  }
+}
+
+void Consumer(tapa::istream<int>& data_in_q, int n, std::atomic<int64_t>* sum) {
+  for (int i = 0; i < n; ++i) *sum += data_in_q.read();
+}
+
+TEST(MpmcStreamTest, FanningInWithOneConsumerPreservesOrderOfEachProducer) {
+  tapa::mpsc_stream<int, 2> data_q("data");
+  std::vector<int> tokens;
+  tapa::task()
+      .invoke<tapa::join, kProducerCount>(Producer, data_q, tapa::seq(), true)
+      .invoke(Collector, data_q, &tokens);
+
+  ASSERT_EQ(tokens.size(), kProducerCount * kN);
+  std::vector<int> next(kProducerCount);
+  for (const int token : tokens) {
+    const int id = token / kN;
+    EXPECT_EQ(token, id * kN + next[id]++);
+  }
+}
+
+TEST(MpmcStreamTest, ReadingWithMultipleConsumersReadsEachTokenOnce) {
+  constexpr int kConsumerCount = 2;
+  tapa::mpmc_stream<int, 8> data_q("data");
+  std::atomic<int64_t> sum{0};
+  tapa::task()
+      .invoke<tapa::join, kProducerCount>(Producer, data_q, tapa::seq(), false)
+      .invoke<tapa::join, kConsumerCount>(
+          Consumer, data_q, kProducerCount * kN / kConsumerCount, &sum);
+
+  const int64_t token_count = kProducerCount * kN;
+  EXPECT_EQ(sum, token_count * (token_count - 1) / 2);
+}
+
+TEST(MpmcStreamTest, PeekingWithMultipleConsumersFails) {
+  tapa::mpmc_stream<int, 2> data_q("data");
+  data_q.write(0);
+  EXPECT_DEATH(data_q.peek(nullptr), "peeked with multiple consumers");
+  data_q.read();
+}
+
+}  // namespace
+}  // namespace tapa
@@ -0,0 +1,50 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/pipeline.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+
+#include <glog/logging.h>
+
+#include <frt.h>
+
+namespace tapa {
+
+int64_t invocation::wait() {
+  if (this->instance_ != nullptr) {
+    this->finished_.get();
+    this->kernel_time_ns_ = this->instance_->ComputeTimeNanoSeconds();
+  }
+  return this->kernel_time_ns_;
+}
+
+bool invocation::is_done() const {
+  return this->instance_ == nullptr ||
+         this->finished_.wait_for(std::chrono::seconds(0)) ==
+             std::future_status::ready;
+}
+
+pipeline::pipeline(const std::string& bitstream, int depth) {
+  CHECK_GT(depth, 0);
+  if (bitstream.empty()) {
+    LOG(INFO) << "running software simulation with TAPA library";
+  } else {
+    this->instance_ = std::make_unique<fpga::Instance>(bitstream);
+    this->instance_->SetPipelineDepth(depth);
+  }
+}
+
+pipeline::~pipeline() { this->finish(); }
+
+void pipeline::finish() {
+  if (this->instance_ != nullptr) {
+    this->instance_->Finish();
+  }
+}
+
+}  // namespace tapa
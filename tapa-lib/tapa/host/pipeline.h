@@ -0,0 +1,133 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef TAPA_HOST_PIPELINE_H_
+#define TAPA_HOST_PIPELINE_H_
+
+#include <cstdint>
+
+#include <future>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <frt.h>
+
+#include "tapa/host/task.h"
+
+namespace tapa {
+
+/// Handle of a kernel invocation started by @c tapa::invoke_async.
+class invocation {
+ public:
+  /// Constructs the handle of an invocation that has finished.
+  invocation() = default;
+
+  /// Waits for the kernel to finish and its outputs to be read back, and
+  /// returns the kernel time in nanoseconds. May be called more than once.
+  int64_t wait();
+
+  /// Returns whether the kernel has finished, without waiting.
+  bool is_done() const;
+
+ private:
+  template <typename Func, typename... Args>
+  friend invocation invoke_async(Func&& f, const std::string& bitstream,
+                                 Args&&... args);
+
+  std::shared_ptr<fpga::Instance> instance_;
+  std::shared_future<void> finished_;
+  int64_t kernel_time_ns_ = 0;
+};
+
+/// Same as @c tapa::invoke, but returns once the kernel is started on the
+/// device, so that the host can do other work in the meantime. Host memory
+/// passed as @c args must stay alive and unchanged until the returned
+/// invocation is waited for. Software simulation, i.e., an empty
+/// @c bitstream, finishes before this returns.
+template <typename Func, typename... Args>
+invocation invoke_async(Func&& f, const std::string& bitstream,
+                        Args&&... args) {
+  static_assert(std::is_function_v<typename std::remove_reference_t<Func>>,
+                "the first argument for tapa::invoke_async() must be a "
+                "function");
+  invocation handle;
+  if (bitstream.empty()) {
+    handle.kernel_time_ns_ = internal::invoker<Func>::template invoke<Args...>(
+        /*run_in_new_process*/ false, std::forward<Func>(f), bitstream,
+        std::forward<Args>(args)...);
+    return handle;
+  }
+  handle.instance_ = std::make_shared<fpga::Instance>(bitstream);
+  internal::invoker<Func>::invoke_async(*handle.instance_,
+                                        std::forward<Func>(f),
+                                        std::forward<Args>(args)...);
+  handle.finished_ = handle.instance_->FinishAsync().share();
+  return handle;
+}
+
+/// Runs invocations of the same kernel back to back on one device, keeping up
+/// to @c depth of them in flight, so that the transfers of one invocation
+/// overlap the computation of another. The bitstream is loaded once, and
+/// device buffers are reused by invocations that pass the same host memory.
+///
+/// Invocations in flight must not share host memory that the kernel writes;
+/// the usual pattern is to rotate among @c depth sets of buffers:
+/// @code{.cpp}
+///  tapa::pipeline pipeline(bitstream, /*depth=*/2);
+///  for (int i = 0; i < n; ++i) {
+///    pipeline.invoke(VecAdd, tapa::read_only_mmap<const float>(a[i % 2]),
+///                    tapa::write_only_mmap<float>(c[i % 2]), kSize);
+///  }
+///  pipeline.finish();
+/// @endcode
+///
+/// Software simulation, i.e., an empty @c bitstream, runs each invocation to
+/// completion before @c invoke returns.
+class pipeline {
+ public:
+  explicit pipeline(const std::string& bitstream, int depth = 2);
+
+  // Not copyable or movable.
+  pipeline(const pipeline&) = delete;
+  pipeline& operator=(const pipeline&) = delete;
+
+  /// Waits for all invocations to finish.
+  ~pipeline();
+
+  /// Starts an invocation of @c f with @c args, after waiting for the oldest
+  /// invocation if @c depth of them are in flight.
+  template <typename Func, typename... Args>
+  pipeline& invoke(Func&& f, Args&&... args) {
+    static_assert(std::is_function_v<typename std::remove_reference_t<Func>>,
+                  "the first argument for tapa::pipeline::invoke() must be a "
+                  "function");
+    if (instance_ == nullptr) {
+      internal::invoker<Func>::template invoke<Args...>(
+          /*run_in_new_process*/ false, std::forward<Func>(f), "",
+          std::forward<Args>(args)...);
+    } else {
+      internal::invoker<Func>::invoke_async(
+          *instance_, std::forward<Func>(f), std::forward<Args>(args)...);
+    }
+    ++invocation_count_;
+    return *this;
+  }
+
+  /// Waits for all invocations in flight to finish and their outputs to be
+  /// read back.
+  void finish();
+
+  /// Returns the number of invocations started.
+  int64_t invocation_count() const { return invocation_count_; }
+
+ private:
+  std::unique_ptr<fpga::Instance> instance_;  // Null in software simulation.
+  int64_t invocation_count_ = 0;
+};
+
+}  // namespace tapa
+
+#endif  // TAPA_HOST_PIPELINE_H_
@@ -0,0 +1,91 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/pipeline.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tapa.h"
+
+namespace tapa {
+namespace {
+
+constexpr int kN = 100;
+
+void Scale(tapa::mmap<const int> src, tapa::mmap<int> dst, int factor) {
+  for (int i = 0; i < kN; ++i) dst[i] = src[i] * factor;
+}
+
+TEST(PipelineTest, InvokeAsyncInSoftwareSimulationFinishesOnReturn) {
+  std::vector<int> src(kN), dst(kN);
+  for (int i = 0; i < kN; ++i) src[i] = i;
+
+  invocation handle =
+      tapa::invoke_async(Scale, "", tapa::read_only_mmap<const int>(src),
+                         tapa::write_only_mmap<int>(dst), 2);
+  EXPECT_TRUE(handle.is_done());
+  EXPECT_GE(handle.wait(), 0);
+  for (int i = 0; i < kN; ++i) ASSERT_EQ(dst[i], i * 2) << i;
+}
+
+TEST(PipelineTest, PipelineRunsEachInvocation) {
+  constexpr int kDepth = 2;
+  std::vector<int> src(kN);
+  for (int i = 0; i < kN; ++i) src[i] = i;
+  std::vector<std::vector<int>> dst(kDepth, std::vector<int>(kN));
+
+  tapa::pipeline pipeline("", kDepth);
+  for (int factor = 1; factor <= 4; ++factor) {
+    pipeline.invoke(Scale, tapa::read_only_mmap<const int>(src),
+                    tapa::write_only_mmap<int>(dst[factor % kDepth]), factor);
+    if (factor >= kDepth) {
+      // Software simulation finishes each invocation before returning.
+      for (int i = 0; i < kN; ++i) {
+        ASSERT_EQ(dst[factor % kDepth][i], i * factor) << i;
+      }
+    }
+  }
+  pipeline.finish();
+  EXPECT_EQ(pipeline.invocation_count(), 4);
+}
+
+// Accumulates `src` into `acc` through `tmp`, which only the kernel uses.
+void Accumulate(tapa::mmap<const int> src, tapa::mmap<int> tmp,
+                tapa::mmap<int> acc) {
+  for (int i = 0; i < kN; ++i) tmp[i] = src[i];
+  for (int i = 0; i < kN; ++i) acc[i] += tmp[i];
+}
+
+TEST(PipelineTest, PipelineAcceptsDirectionHints) {
+  std::vector<int> src(kN), tmp(kN), acc(kN);
+  for (int i = 0; i < kN; ++i) src[i] = i;
+
+  tapa::pipeline pipeline("");
+  for (int n = 0; n < 3; ++n) {
+    pipeline.invoke(Accumulate, tapa::init_once_mmap<const int>(src),
+                    tapa::scratch_mmap<int>(tmp),
+                    tapa::read_back_last_mmap<int>(acc));
+  }
+  pipeline.finish();
+  for (int i = 0; i < kN; ++i) ASSERT_EQ(acc[i], i * 3) << i;
+}
+
+TEST(PipelineTest, PipelineAcceptsHostOnlyMmap) {
+  std::vector<int> src(kN), tmp(kN), acc(kN);
+  for (int i = 0; i < kN; ++i) src[i] = i;
+
+  tapa::pipeline pipeline("");
+  for (int n = 0; n < 2; ++n) {
+    pipeline.invoke(Accumulate, tapa::read_only_mmap<const int>(src),
+                    tapa::scratch_mmap<int>(tmp),
+                    tapa::host_only_mmap<int>(acc));
+  }
+  pipeline.finish();
+  for (int i = 0; i < kN; ++i) ASSERT_EQ(acc[i], i * 2) << i;
+}
+
+}  // namespace
+}  // namespace tapa
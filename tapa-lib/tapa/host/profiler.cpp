@@ -0,0 +1,133 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/profiler.h"
+
+#include <cstdlib>
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include <frt/trace.h>
+
+#include "tapa/host/internal_util.h"
+
+namespace tapa::internal {
+
+namespace {
+
+uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+void task_profile::count_yield(yield_reason::kind_t reason) {
+  ++this->yields;
+  switch (reason) {
+    case yield_reason::kChannelEmpty:
+      ++this->empty_yields;
+      break;
+    case yield_reason::kChannelFull:
+      ++this->full_yields;
+      break;
+    case yield_reason::kOther:
+      break;
+  }
+}
+
+void task_profile::trace_run(uint64_t begin_ns, uint64_t end_ns,
+                             const yield_reason* reason) const {
+  if (this->trace_track < 0) return;
+  const char* name = "run until done";
+  if (reason != nullptr) {
+    switch (reason->kind()) {
+      case yield_reason::kChannelEmpty:
+        name = "run until empty";
+        break;
+      case yield_reason::kChannelFull:
+        name = "run until full";
+        break;
+      case yield_reason::kOther:
+        name = "run until yield";
+        break;
+    }
+  }
+  fpga::internal::Trace::Get()->AddSpan(this->trace_track, name, begin_ns,
+                                        end_ns,
+                                        reason == nullptr ? "" : reason->str());
+}
+
+std::unique_ptr<profiler> profiler::New() {
+  const char* path = getenv("TAPA_PROFILE");
+  if (path != nullptr && *path != '\0') return std::make_unique<profiler>(path);
+  if (fpga::internal::Trace::Get() != nullptr) {
+    return std::make_unique<profiler>(/*path=*/"");
+  }
+  return nullptr;
+}
+
+profiler::profiler(std::string path)
+    : path_(std::move(path)), start_ns_(now_ns()) {}
+
+profiler::~profiler() {
+  if (this->path_.empty()) return;
+  std::ofstream ofs(this->path_);
+  this->write(ofs);
+  if (ofs.fail()) {
+    LOG(ERROR) << "failed to write task profile to '" << this->path_ << "'";
+  } else {
+    LOG(INFO) << "task profile is written to '" << this->path_ << "'";
+  }
+}
+
+task_profile* profiler::add(const void* func, std::string_view label) {
+  std::string name = GetFunctionName(func);
+  if (name.empty()) name = label.empty() ? "<anonymous>" : label;
+
+  std::unique_lock lock(this->mtx_);
+  auto& profile = this->profiles_.emplace_back();
+  profile.name = std::move(name);
+  profile.label = label;
+  profile.instance = this->instance_count_[profile.name]++;
+  if (auto* trace = fpga::internal::Trace::Get()) {
+    profile.trace_track = trace->AddTrack(
+        "tasks", profile.name + "/" + std::to_string(profile.instance));
+  }
+  return &profile;
+}
+
+void profiler::write(std::ostream& os) const {
+  std::unique_lock lock(this->mtx_);
+  os << "{\n  \"wall_ns\": " << now_ns() - this->start_ns_
+     << ",\n  \"tasks\": {";
+  bool first = true;
+  for (const auto& profile : this->profiles_) {
+    os << (first ? "\n    " : ",\n    ");
+    first = false;
+    WriteJsonString(os, profile.name + "/" + std::to_string(profile.instance));
+    os << ": {\"task\": ";
+    WriteJsonString(os, profile.name);
+    os << ", \"instance\": " << profile.instance << ", \"label\": ";
+    WriteJsonString(os, profile.label);
+    os << ", \"resumes\": " << profile.resumes
+       << ", \"run_ns\": " << profile.run_ns
+       << ", \"yields\": " << profile.yields
+       << ", \"empty_yields\": " << profile.empty_yields
+       << ", \"full_yields\": " << profile.full_yields << "}";
+  }
+  os << "\n  }\n}\n";
+}
+
+}  // namespace tapa::internal
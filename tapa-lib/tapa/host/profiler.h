@@ -0,0 +1,81 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef TAPA_HOST_PROFILER_H_
+#define TAPA_HOST_PROFILER_H_
+
+#include <cstdint>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "tapa/host/coroutine.h"
+
+namespace tapa::internal {
+
+// Runtime statistics of a task instance in software simulation.
+struct task_profile {
+  std::string name;   // Name of the task function.
+  std::string label;  // Name passed to `tapa::task::invoke`, if any.
+  int instance = 0;   // Index among instances of the same task function.
+
+  uint64_t resumes = 0;       // Number of times the task is resumed.
+  uint64_t run_ns = 0;        // Time spent running after being resumed.
+  uint64_t yields = 0;        // Number of times the task yields.
+  uint64_t empty_yields = 0;  // Yields caused by empty input channels.
+  uint64_t full_yields = 0;   // Yields caused by full output channels.
+
+  // Track of the task instance in the timeline trace, or -1 if not traced.
+  int trace_track = -1;
+
+  // Counts a yield for `reason`.
+  void count_yield(yield_reason::kind_t reason);
+
+  // Records a run from `begin_ns` until `end_ns` in the timeline trace, which
+  // ended by yielding for `reason`, or by finishing if `reason` is null.
+  void trace_run(uint64_t begin_ns, uint64_t end_ns,
+                 const yield_reason* reason) const;
+};
+
+// Collects profiles of task instances and writes them as a JSON report when
+// destroyed. Enabled by `TAPA_PROFILE=<path>`, or by `TAPA_TRACE=<path>` to
+// record the runs of each task instance in the timeline trace.
+class profiler {
+ public:
+  // Returns `nullptr` unless profiling or tracing is enabled.
+  static std::unique_ptr<profiler> New();
+
+  // Writes no report if `path` is empty.
+  explicit profiler(std::string path);
+  ~profiler();
+
+  // Not copyable or movable.
+  profiler(const profiler&) = delete;
+  profiler& operator=(const profiler&) = delete;
+
+  // Adds a task instance. `func` is the address of the task function, if any.
+  // The returned profile is valid until this profiler is destroyed.
+  task_profile* add(const void* func, std::string_view label);
+
+  // Writes the report, which maps `<task>/<instance>` to the statistics of each
+  // task instance. The keys match node IDs of the flat `tapa-visualizer` view.
+  void write(std::ostream& os) const;
+
+ private:
+  const std::string path_;
+  const uint64_t start_ns_;
+
+  mutable std::mutex mtx_;
+  std::deque<task_profile> profiles_;
+  std::unordered_map<std::string, int> instance_count_;
+};
+
+}  // namespace tapa::internal
+
+#endif  // TAPA_HOST_PROFILER_H_
@@ -0,0 +1,45 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/profiler.h"
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace tapa::internal {
+namespace {
+
+TEST(ProfilerTest, CountYieldClassifiesReasons) {
+  task_profile profile;
+  profile.count_yield(yield_reason::kChannelEmpty);
+  profile.count_yield(yield_reason::kChannelEmpty);
+  profile.count_yield(yield_reason::kChannelFull);
+  profile.count_yield(yield_reason::kOther);
+  EXPECT_EQ(profile.yields, 4);
+  EXPECT_EQ(profile.empty_yields, 2);
+  EXPECT_EQ(profile.full_yields, 1);
+}
+
+TEST(ProfilerTest, ReportIsKeyedByTaskInstance) {
+  profiler profiles(/*path=*/"");
+  task_profile* first = profiles.add(nullptr, "Task\"0\"");
+  task_profile* second = profiles.add(nullptr, "Task\"0\"");
+  EXPECT_EQ(first->instance, 0);
+  EXPECT_EQ(second->instance, 1);
+  second->resumes = 3;
+
+  std::ostringstream os;
+  profiles.write(os);
+  const std::string report = os.str();
+  EXPECT_NE(report.find(R"("Task\"0\"/0": {"task": "Task\"0\"")"),
+            std::string::npos)
+      << report;
+  EXPECT_NE(report.find(R"("Task\"0\"/1")"), std::string::npos) << report;
+  EXPECT_NE(report.find(R"("resumes": 3)"), std::string::npos) << report;
+}
+
+}  // namespace
+}  // namespace tapa::internal
@@ -0,0 +1,164 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <glog/logging.h>
+
+#include "tapa/host/stream.h"
+
+#ifdef __SYNTHESIS__
+#error tapa::replay is not synthesizable
+#endif
+
+namespace tapa {
+namespace internal {
+
+// Implementation of `base_queue` backed by a binary stream log. As a source,
+// it provides the recorded tokens to the reader. As a sink, it accepts tokens
+// from the writer and checks them against the recorded tokens.
+template <typename T>
+class replay_queue final : public base_queue<T> {
+  using value_type = typename base_queue<T>::value_type;
+  static_assert(std::is_trivially_copyable_v<value_type>,
+                "only trivially copyable values can be replayed");
+
+ public:
+  enum mode_t { kSource, kSink };
+
+  // The queue is not logged, which could otherwise overwrite `path`.
+  replay_queue(mode_t mode, const std::string& path, const std::string& name)
+      : base_queue<T>(""),
+        mode(mode),
+        path(path),
+        reader(path, sizeof(value_type)) {
+    this->set_name(name);
+  }
+
+  // debug helpers
+  uint64_t get_depth() const { return ::tapa::kStreamInfiniteDepth; }
+
+  // basic queue operations
+  bool empty() const override {
+    return this->mode != kSource || this->reader.peek() == nullptr;
+  }
+  bool full() const override { return false; }
+  const T& front() const override {
+    const char* record = this->reader.peek();
+    this->front_.eot = record[0] != 0;
+    memcpy(&this->front_.val, record + 1, sizeof(this->front_.val));
+    return this->front_;
+  }
+  T pop() override {
+    const T elem = this->front();
+    this->reader.next();
+    this->notify();
+    return elem;
+  }
+  using base_queue<T>::push;
+  void push(const T& elem) override {
+    if (this->mode != kSink) {
+      LOG(FATAL) << "channel '" << this->get_name()
+                 << "' written when replayed from '" << this->path << "'";
+    }
+    const char* record = this->reader.peek();
+    if (record == nullptr) {
+      LOG(FATAL) << "channel '" << this->get_name()
+                 << "' written with more tokens than recorded in '"
+                 << this->path << "'";
+    }
+    if (elem.eot != (record[0] != 0) ||
+        (!elem.eot && memcmp(&elem.val, record + 1, sizeof(elem.val)) != 0)) {
+      T expected;
+      expected.eot = record[0] != 0;
+      memcpy(&expected.val, record + 1, sizeof(expected.val));
+      LOG(FATAL) << "channel '" << this->get_name() << "' token #"
+                 << this->reader.index() << " is '" << elem << "', expecting '"
+                 << expected << "' as recorded in '" << this->path << "'";
+    }
+    this->reader.next();
+  }
+
+  ~replay_queue() {
+    if (this->mode == kSource) {
+      this->check_leftover();
+    } else if (this->reader.peek() != nullptr) {
+      LOG(ERROR) << "channel '" << this->get_name() << "' written with only "
+                 << this->reader.index() << " tokens but more are recorded in '"
+                 << this->path << "'";
+    }
+  }
+
+ private:
+  const mode_t mode;
+  const std::string path;
+  mutable type_erased_queue::LogReader reader;
+  mutable T front_;  // Decoded next token returned by `front`.
+};
+
+struct replay_access {
+  template <typename T>
+  static void reset(basic_stream<T>& channel,
+                    typename replay_queue<elem_t<T>>::mode_t mode,
+                    const std::string& path) {
+    channel.reset(std::make_shared<replay_queue<elem_t<T>>>(
+        mode, path, channel.get_name()));
+  }
+};
+
+}  // namespace internal
+
+/// Replays streams from binary stream logs, so that a task can run in
+/// isolation without the rest of the task graph.
+///
+/// Logs are recorded by running software simulation with
+/// @c TAPA_STREAM_LOG_DIR set and @c TAPA_STREAM_LOG_FORMAT=binary or
+/// @c compressed. The streams must be replayed before they are passed to any
+/// task, e.g.:
+/// @code{.cpp}
+///  ...
+///  #include <tapa.h>
+///  #include <tapa/host/replay.h>
+///  ...
+///  tapa::stream<float> a_q("a"), c_q("c");
+///  tapa::replay::feed(a_q, "logs/a.bin");
+///  tapa::replay::expect(c_q, "logs/c.bin");
+///  tapa::task().invoke(Compute, a_q, c_q);
+/// @endcode
+///
+/// Software simulation only; NOT synthesizable.
+namespace replay {
+
+/// Provides tokens recorded in @c path to the reader of @c channel.
+///
+/// @param channel Stream to replay, which must not be written.
+/// @param path    Path to the binary stream log.
+template <typename T, uint64_t N, uint64_t SimulationDepth>
+void feed(stream<T, N, SimulationDepth>& channel, const std::string& path) {
+  internal::replay_access::reset<T>(
+      channel, internal::replay_queue<internal::elem_t<T>>::kSource, path);
+}
+
+/// Checks tokens written to @c channel against tokens recorded in @c path.
+///
+/// The program aborts at the first token that differs. An error is logged if
+/// fewer tokens than recorded are written.
+///
+/// @param channel Stream to check, which must not be read.
+/// @param path    Path to the binary stream log.
+template <typename T, uint64_t N, uint64_t SimulationDepth>
+void expect(stream<T, N, SimulationDepth>& channel, const std::string& path) {
+  internal::replay_access::reset<T>(
+      channel, internal::replay_queue<internal::elem_t<T>>::kSink, path);
+}
+
+}  // namespace replay
+}  // namespace tapa
@@ -0,0 +1,125 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/replay.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "tapa.h"
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+namespace tapa {
+namespace {
+
+constexpr int kN = 100;
+
+void Source(tapa::ostream<int>& data_out_q, int n) {
+  for (int i = 0; i < n; ++i) data_out_q.write(i);
+  data_out_q.close();
+}
+
+void Double(tapa::istream<int>& data_in_q, tapa::ostream<int>& data_out_q,
+            int factor) {
+  for (bool is_eot = false; !is_eot;) {
+    if (data_in_q.try_eot(is_eot) && !is_eot) {
+      data_out_q.write(data_in_q.read() * factor);
+    }
+  }
+  data_in_q.open();
+  data_out_q.close();
+}
+
+void Sink(tapa::istream<int>& data_in_q) {
+  for (bool is_eot = false; !is_eot;) {
+    if (data_in_q.try_eot(is_eot) && !is_eot) data_in_q.read();
+  }
+  data_in_q.open();
+}
+
+class ReplayTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    fs::create_directory(temp_dir_);
+    ASSERT_EQ(setenv("TAPA_STREAM_LOG_DIR", temp_dir_.c_str(), 1), 0)
+        << std::strerror(errno);
+    ASSERT_EQ(setenv("TAPA_STREAM_LOG_FORMAT", GetLogFormat(), 1), 0)
+        << std::strerror(errno);
+    {
+      tapa::stream<int> in_q("in");
+      tapa::stream<int> out_q("out");
+      tapa::task()
+          .invoke(Source, in_q, GetTokenCount())
+          .invoke(Double, in_q, out_q, 2)
+          .invoke(Sink, out_q);
+    }
+    EXPECT_EQ(unsetenv("TAPA_STREAM_LOG_DIR"), 0) << std::strerror(errno);
+    EXPECT_EQ(unsetenv("TAPA_STREAM_LOG_FORMAT"), 0) << std::strerror(errno);
+  }
+
+  void TearDown() override { fs::remove_all(temp_dir_); }
+
+  virtual const char* GetLogFormat() const { return "binary"; }
+  virtual int GetTokenCount() const { return kN; }
+
+  const testing::TestInfo* const test_info_ =
+      testing::UnitTest::GetInstance()->current_test_info();
+  const fs::path temp_dir_ = fs::temp_directory_path() /
+                             (std::string(test_info_->test_suite_name()) +
+                              "." + test_info_->name());
+};
+
+TEST_F(ReplayTest, ReplayingTaskWithRecordedTokensSucceeds) {
+  tapa::stream<int> in_q("in");
+  tapa::stream<int> out_q("out");
+  replay::feed(in_q, temp_dir_ / "in.bin");
+  replay::expect(out_q, temp_dir_ / "out.bin");
+  tapa::task().invoke(Double, in_q, out_q, 2);
+}
+
+TEST_F(ReplayTest, ReplayingTaskWithDifferentOutputFails) {
+  EXPECT_DEATH(
+      {
+        tapa::stream<int> in_q("in");
+        tapa::stream<int> out_q("out");
+        replay::feed(in_q, temp_dir_ / "in.bin");
+        replay::expect(out_q, temp_dir_ / "out.bin");
+        tapa::task().invoke(Double, in_q, out_q, 3);
+      },
+      "channel 'out' token #1 is '3', expecting '2'");
+}
+
+class CompressedReplayTest : public ReplayTest {
+ protected:
+  const char* GetLogFormat() const override { return "compressed"; }
+
+  // Spans multiple chunks of the compressed logs.
+  int GetTokenCount() const override { return 1 << 19; }
+};
+
+TEST_F(CompressedReplayTest, ReplayingTaskWithRecordedTokensSucceeds) {
+  tapa::stream<int> in_q("in");
+  tapa::stream<int> out_q("out");
+  replay::feed(in_q, temp_dir_ / "in.bin");
+  replay::expect(out_q, temp_dir_ / "out.bin");
+  tapa::task().invoke(Double, in_q, out_q, 2);
+}
+
+TEST_F(CompressedReplayTest, LogsAreCompressed) {
+  // Each record takes 5 bytes in the binary format.
+  EXPECT_LT(fs::file_size(temp_dir_ / "in.bin"), GetTokenCount() * 5 / 2);
+}
+
+}  // namespace
+}  // namespace tapa
@@ -4,8 +4,35 @@
 
 #include "tapa/host/simulate.h"
 
+#include <cstdlib>
+
+#include <string_view>
+
+#include <glog/logging.h>
+
 namespace tapa::hls_simulate {
 
-task::task() { this->mode_override = 1; }
+namespace {
+
+scheduling get_scheduling() {
+  const char* env = getenv("TAPA_HLS_SIMULATE_SCHEDULING");
+  if (env == nullptr || *env == '\0' || std::string_view(env) == "sequential") {
+    return scheduling::kSequential;
+  }
+  if (std::string_view(env) == "dataflow") return scheduling::kDataflow;
+  LOG_FIRST_N(WARNING, 1) << "unknown TAPA_HLS_SIMULATE_SCHEDULING '" << env
+                          << "'; scheduling tasks sequentially";
+  return scheduling::kSequential;
+}
+
+}  // namespace
+
+task::task() : task(get_scheduling()) {}
+
+task::task(scheduling mode) {
+  // Tasks are invoked with their own modes, e.g., `tapa::detach`, unless
+  // scheduled sequentially.
+  if (mode == scheduling::kSequential) this->mode_override = 1;
+}
 
 }  // namespace tapa::hls_simulate
@@ -58,7 +58,22 @@ using stream = ::tapa::stream<T, ::tapa::kStreamInfiniteDepth>;
 template <typename T>
 using stream_interface = ::tapa::internal::unbound_stream<T>;
 
-/// Same as @c tapa::task, except that tasks are scheduled sequentially.
+/// Defines how @c tapa::hls_simulate::task schedules the invoked tasks.
+enum class scheduling {
+  /// Each task runs to completion when it is invoked, as in C simulation of
+  /// an HLS dataflow region.
+  kSequential,
+
+  /// Tasks run concurrently as in @c tapa::task, so tasks that exchange data
+  /// in both directions do not deadlock, and blocking reads wait for the data
+  /// as in hardware. Streams of @c tapa::hls_simulate::stream remain
+  /// unbounded, and their peak occupancy is reported as @c max_occupancy by
+  /// @c TAPA_STREAM_STATS=<path>, which hints the depth for @c tapa::stream.
+  kDataflow,
+};
+
+/// Same as @c tapa::task, except that tasks are scheduled sequentially by
+/// default.
 ///
 /// Intended for debugging code migrated from HLS:
 /// @code{.cpp}
@@ -76,10 +91,19 @@ using stream_interface = ::tapa::internal::unbound_stream<T>;
 ///  }
 /// @endcode
 ///
+/// Once the tasks are correct sequentially, setting
+/// @c TAPA_HLS_SIMULATE_SCHEDULING=dataflow runs them concurrently without
+/// changing the code; see @c tapa::hls_simulate::scheduling.
+///
 /// Software simulation only; NOT synthesizable.
 /// Replace with @c tapa::task for synthesis.
 struct task : public ::tapa::task {
+  /// Schedules tasks as set by @c TAPA_HLS_SIMULATE_SCHEDULING, which is
+  /// either @c sequential (default) or @c dataflow.
   explicit task();
+
+  /// Schedules tasks as @c mode.
+  explicit task(scheduling mode);
 };
 
 }  // namespace hls_simulate
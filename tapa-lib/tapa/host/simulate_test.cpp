@@ -4,6 +4,8 @@
 
 #include "tapa/host/simulate.h"
 
+#include <cstdlib>
+
 #include <gtest/gtest.h>
 
 #include "tapa/host/task.h"
@@ -87,4 +89,39 @@ TEST(SimulateTest, SimulateHlsTasksAreScheduledSequentially) {
       .invoke(DataSinkNonBlocking, data_q, count_q, kN);
 }
 
+// Sends each value and waits for it to come back, which deadlocks unless the
+// tasks run concurrently.
+void PingPongSource(tapa::hls_simulate::stream_interface<int>& ping_q,
+                    tapa::hls_simulate::stream_interface<int>& pong_q, int n) {
+  for (int i = 0; i < n; ++i) {
+    ping_q.write(i);
+    EXPECT_EQ(pong_q.read(), i + 1);
+  }
+}
+
+void PingPongEcho(tapa::hls_simulate::stream_interface<int>& ping_q,
+                  tapa::hls_simulate::stream_interface<int>& pong_q, int n) {
+  for (int i = 0; i < n; ++i) {
+    pong_q.write(ping_q.read() + 1);
+  }
+}
+
+TEST(SimulateTest, SimulateHlsTasksCanBeScheduledAsDataflow) {
+  tapa::hls_simulate::stream<int> ping_q("ping");
+  tapa::hls_simulate::stream<int> pong_q("pong");
+  tapa::hls_simulate::task(tapa::hls_simulate::scheduling::kDataflow)
+      .invoke(PingPongSource, ping_q, pong_q, kN)
+      .invoke(PingPongEcho, ping_q, pong_q, kN);
+}
+
+TEST(SimulateTest, SimulateHlsSchedulingCanBeSetByEnvironment) {
+  ASSERT_EQ(setenv("TAPA_HLS_SIMULATE_SCHEDULING", "dataflow", 1), 0);
+  tapa::hls_simulate::stream<int> ping_q("ping");
+  tapa::hls_simulate::stream<int> pong_q("pong");
+  tapa::hls_simulate::task()
+      .invoke(PingPongSource, ping_q, pong_q, kN)
+      .invoke(PingPongEcho, ping_q, pong_q, kN);
+  EXPECT_EQ(unsetenv("TAPA_HLS_SIMULATE_SCHEDULING"), 0);
+}
+
 }  // namespace
@@ -4,17 +4,93 @@
 
 #include "tapa/host/stream.h"
 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 
 #include <glog/logging.h>
+#include <zlib.h>
 
 #include "tapa/host/internal_util.h"
 
 namespace tapa {
 namespace internal {
 
+namespace {
+
+// The binary log starts with a header of `kBinaryLogMagic`, a 4-byte version,
+// and the 4-byte size of values, followed by one record per token, which is a
+// 1-byte EoT flag and the raw bytes of the value. Integers are in the byte
+// order of the host. `tapa stream-log` decodes and compares the logs.
+constexpr char kBinaryLogMagic[] = "TAPASLOG";
+constexpr uint32_t kBinaryLogVersion = 1;
+
+// A compressed log starts with `kCompressedLogMagic`, followed by chunks of
+// the binary format above. Each chunk is the 4-byte size of its compressed
+// data, the 4-byte size of its decompressed data, and the zlib stream of up to
+// `kBinaryLogBufferSize` bytes. Chunks are located from their sizes without
+// decompressing the data.
+constexpr char kCompressedLogMagic[] = "TAPASLGZ";
+
+// Binary records are written when this many bytes are pending.
+constexpr size_t kBinaryLogBufferSize = 1 << 20;
+
+enum class LogFormat { kText, kBinary, kCompressed };
+
+LogFormat GetLogFormat() {
+  const char* format = getenv("TAPA_STREAM_LOG_FORMAT");
+  if (format == nullptr || std::string_view(format) == "text") {
+    return LogFormat::kText;
+  }
+  if (std::string_view(format) == "binary") return LogFormat::kBinary;
+  if (std::string_view(format) == "compressed") return LogFormat::kCompressed;
+  LOG(WARNING) << "unknown TAPA_STREAM_LOG_FORMAT '" << format
+               << "'; using text";
+  return LogFormat::kText;
+}
+
+// Writes `data` as a chunk of a compressed log.
+void WriteCompressedChunk(std::ofstream& ofs, const std::string& data) {
+  uLongf size = compressBound(data.size());
+  std::string compressed(sizeof(uint32_t) * 2 + size, '\0');
+  const int result = compress2(
+      reinterpret_cast<Bytef*>(&compressed[sizeof(uint32_t) * 2]), &size,
+      reinterpret_cast<const Bytef*>(data.data()), data.size(), Z_BEST_SPEED);
+  CHECK_EQ(result, Z_OK) << "failed to compress stream log";
+  const uint32_t header[] = {uint32_t(size), uint32_t(data.size())};
+  memcpy(&compressed[0], header, sizeof(header));
+  ofs.write(compressed.data(), sizeof(header) + size);
+  ofs.flush();
+}
+
+std::atomic<uint64_t> next_queue_serial{0};
+
+}  // namespace
+
+uint64_t get_scaled_depth(uint64_t depth) {
+  const char* env = getenv("TAPA_STREAM_DEPTH_SCALE");
+  if (env == nullptr || depth == ::tapa::kStreamInfiniteDepth) return depth;
+  const uint64_t scale = strtoull(env, nullptr, /*base=*/10);
+  if (scale == 0) {
+    LOG_FIRST_N(WARNING, 1)
+        << "ignoring invalid TAPA_STREAM_DEPTH_SCALE '" << env << "'";
+    return depth;
+  }
+  // Saturates instead of overflowing into an unbounded depth.
+  return depth > (::tapa::kStreamInfiniteDepth - 1) / scale
+             ? ::tapa::kStreamInfiniteDepth - 1
+             : depth * scale;
+}
+
 std::unique_ptr<type_erased_queue::LogContext>
 type_erased_queue::LogContext::New(std::string_view name) {
   if (name.empty()) return nullptr;
@@ -22,8 +98,11 @@ type_erased_queue::LogContext::New(std::string_view name) {
   const char* debug_stream_dir = getenv("TAPA_STREAM_LOG_DIR");
   if (debug_stream_dir == nullptr) return nullptr;
 
-  const std::string file_path = StrCat({debug_stream_dir, "/", name, ".txt"});
-  std::ofstream ofs(file_path);
+  const LogFormat format = GetLogFormat();
+  const bool is_binary = format != LogFormat::kText;
+  const std::string file_path =
+      StrCat({debug_stream_dir, "/", name, is_binary ? ".bin" : ".txt"});
+  std::ofstream ofs(file_path, is_binary ? std::ios::binary : std::ios::out);
   if (ofs.fail()) {
     LOG(ERROR) << "failed to log channel '" << name << "' in '" << file_path
                << "'";
@@ -33,14 +112,184 @@ type_erased_queue::LogContext::New(std::string_view name) {
   LOG(INFO) << "channel '" << name << "' is logged in '" << file_path << "'";
   auto log_context = std::make_unique<type_erased_queue::LogContext>();
   log_context->ofs = std::move(ofs);
+  log_context->is_binary = is_binary;
+  log_context->is_compressed = format == LogFormat::kCompressed;
+  if (is_binary) log_context->buffer.reserve(kBinaryLogBufferSize);
   return log_context;
 }
 
+type_erased_queue::LogContext::~LogContext() {
+  this->Flush();
+  if (this->pending.valid()) this->pending.get();
+}
+
+void type_erased_queue::LogContext::AppendBinary(bool eot, const void* val,
+                                                 size_t size) {
+  if (this->record_width < 0) {
+    const uint32_t header[] = {kBinaryLogVersion, uint32_t(size)};
+    this->buffer.append(kBinaryLogMagic, sizeof(kBinaryLogMagic) - 1);
+    this->buffer.append(reinterpret_cast<const char*>(header), sizeof(header));
+    this->record_width = size;
+  }
+  CHECK_EQ(this->record_width, size);
+  this->buffer.push_back(eot);
+  this->buffer.append(static_cast<const char*>(val), size);
+  if (this->buffer.size() >= kBinaryLogBufferSize) this->Flush();
+}
+
+void type_erased_queue::LogContext::Flush() {
+  if (!this->is_compressed) {
+    this->ofs.write(this->buffer.data(), this->buffer.size());
+    this->ofs.flush();
+    this->buffer.clear();
+    return;
+  }
+
+  if (this->pending.valid()) {
+    this->pending.get();
+  } else if (!this->buffer.empty()) {
+    // Writes the magic with the first chunk, so that logs without any token
+    // stay empty as in the binary format.
+    this->ofs.write(kCompressedLogMagic, sizeof(kCompressedLogMagic) - 1);
+  }
+  if (this->buffer.empty()) return;
+  this->chunk.swap(this->buffer);
+  this->buffer.clear();
+  this->buffer.reserve(kBinaryLogBufferSize);
+  this->pending = std::async(std::launch::async, [this] {
+    WriteCompressedChunk(this->ofs, this->chunk);
+  });
+}
+
+type_erased_queue::LogReader::LogReader(const std::string& path,
+                                        size_t record_width)
+    : path(path), record_width(record_width), ifs(path, std::ios::binary) {
+  if (this->ifs.fail()) {
+    LOG(FATAL) << "failed to open stream log '" << path << "'";
+  }
+  char magic[sizeof(kBinaryLogMagic) - 1];
+  uint32_t header[2];
+  if (!this->ifs.read(magic, sizeof(magic))) {
+    CHECK_EQ(this->ifs.gcount(), 0) << "truncated stream log '" << path << "'";
+    return;  // No token is ever written.
+  }
+  if (std::string_view(magic, sizeof(magic)) == kCompressedLogMagic) {
+    this->is_compressed = true;
+    this->next_chunk = std::async(std::launch::async,
+                                  &type_erased_queue::LogReader::ReadChunk,
+                                  this);
+    CHECK_EQ(this->Read(magic, sizeof(magic)), sizeof(magic))
+        << "truncated stream log '" << path << "'";
+  }
+  if (this->Read(reinterpret_cast<char*>(header), sizeof(header)) !=
+          sizeof(header) ||
+      std::string_view(magic, sizeof(magic)) != kBinaryLogMagic) {
+    LOG(FATAL) << "'" << path << "' is not a binary stream log";
+  }
+  CHECK_EQ(header[0], kBinaryLogVersion)
+      << "unsupported version of stream log '" << path << "'";
+  CHECK_EQ(header[1], record_width)
+      << "stream log '" << path << "' has values of a different size";
+}
+
+const char* type_erased_queue::LogReader::peek() {
+  const size_t record_size = 1 + this->record_width;
+  if (this->buffer.size() - this->offset < record_size) {
+    this->buffer.erase(0, this->offset);
+    this->offset = 0;
+    const size_t size = this->buffer.size();
+    this->buffer.resize(std::max(kBinaryLogBufferSize, record_size));
+    this->buffer.resize(
+        size + this->Read(&this->buffer[size], this->buffer.size() - size));
+    if (this->buffer.size() < record_size) {
+      CHECK(this->buffer.empty()) << "truncated stream log '" << path << "'";
+      return nullptr;
+    }
+  }
+  return &this->buffer[this->offset];
+}
+
+size_t type_erased_queue::LogReader::Read(char* data, size_t size) {
+  if (!this->is_compressed) {
+    this->ifs.read(data, size);
+    return this->ifs.gcount();
+  }
+
+  size_t total = 0;
+  while (total < size) {
+    if (this->chunk_offset == this->chunk.size()) {
+      if (!this->next_chunk.valid()) break;
+      this->chunk = this->next_chunk.get();
+      this->chunk_offset = 0;
+      if (this->chunk.empty()) break;  // End of the log.
+      this->next_chunk = std::async(std::launch::async,
+                                    &type_erased_queue::LogReader::ReadChunk,
+                                    this);
+    }
+    const size_t n =
+        std::min(size - total, this->chunk.size() - this->chunk_offset);
+    memcpy(data + total, &this->chunk[this->chunk_offset], n);
+    this->chunk_offset += n;
+    total += n;
+  }
+  return total;
+}
+
+std::string type_erased_queue::LogReader::ReadChunk() {
+  uint32_t header[2];
+  if (!this->ifs.read(reinterpret_cast<char*>(header), sizeof(header))) {
+    CHECK_EQ(this->ifs.gcount(), 0) << "truncated stream log '" << path << "'";
+    return "";
+  }
+  std::string compressed(header[0], '\0');
+  CHECK(this->ifs.read(&compressed[0], compressed.size()))
+      << "truncated stream log '" << path << "'";
+  std::string data(header[1], '\0');
+  uLongf size = data.size();
+  CHECK_EQ(uncompress(reinterpret_cast<Bytef*>(&data[0]), &size,
+                      reinterpret_cast<const Bytef*>(compressed.data()),
+                      compressed.size()),
+           Z_OK)
+      << "corrupted stream log '" << path << "'";
+  CHECK_EQ(size, data.size()) << "corrupted stream log '" << path << "'";
+  return data;
+}
+
+void type_erased_queue::LogReader::next() {
+  this->offset += 1 + this->record_width;
+  ++this->record_index;
+}
+
 const std::string& type_erased_queue::get_name() const { return this->name; }
-void type_erased_queue::set_name(const std::string& name) { this->name = name; }
+void type_erased_queue::set_name(const std::string& name) {
+  this->name = name;
+  if (this->stats != nullptr) this->stats->set_name(name);
+}
+
+type_erased_queue::type_erased_queue(const std::string& name, bool has_stats)
+    : name(name),
+      log(LogContext::New(name)),
+      stats(has_stats ? channel_stats::New(name) : nullptr),
+      serial(next_queue_serial.fetch_add(1, std::memory_order_relaxed)) {}
 
-type_erased_queue::type_erased_queue(const std::string& name)
-    : name(name), log(LogContext::New(name)) {}
+void type_erased_queue::wait_slow(const std::function<bool()>& ready,
+                                  yield_reason::kind_t state) const {
+  const yield_reason reason(state, this, this->name);
+  if (this->stats != nullptr) {
+    if (state == yield_reason::kChannelEmpty) {
+      this->stats->count_empty_stall();
+    } else if (state == yield_reason::kChannelFull) {
+      this->stats->count_full_stall();
+    }
+  }
+  if (!this->is_notifying()) {
+    while (!ready()) {
+      yield(reason);
+    }
+    return;
+  }
+  this->waiters.wait(ready, reason);
+}
 
 void type_erased_queue::check_leftover() const {
   if (!this->empty()) {
@@ -9,15 +9,22 @@
 #include <cstdint>
 #include <cstring>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <deque>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iomanip>
 #include <memory>
 #include <mutex>
+#include <new>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -25,8 +32,11 @@
 #include <glog/logging.h>
 
 #include "tapa/base/stream.h"
+#include "tapa/host/channel_stats.h"
 #include "tapa/host/coroutine.h"
+#include "tapa/host/task_graph.h"
 #include "tapa/host/util.h"
+#include "tapa/host/vec.h"
 
 namespace tapa {
 
@@ -44,11 +54,34 @@ class ostreams;
 
 namespace internal {
 
-template <typename T>
+// The binary string of `elem_t<T>` is the EoT bit followed by that of `T`. It
+// is written in place if `T` supports it, so that tokens exchanged with the
+// simulator are not assembled from temporary strings.
+template <typename T,
+          std::enable_if_t<fpga::kHasPackedBinaryString<T>, int> = 0>
+constexpr size_t BinaryStringWidthImpl(const elem_t<T>*) {
+  return 1 + fpga::BinaryStringWidth<T>();
+}
+template <typename T,
+          std::enable_if_t<fpga::kHasPackedBinaryString<T>, int> = 0>
+void WriteBinaryStringImpl(const elem_t<T>* val, char* str) {
+  str[0] = val->eot ? '1' : '0';
+  fpga::WriteBinaryString(val->val, str + 1);
+}
+template <typename T,
+          std::enable_if_t<fpga::kHasPackedBinaryString<T>, int> = 0>
+void ReadBinaryStringImpl(const char* str, elem_t<T>& val) {
+  val.eot = str[0] != '0';
+  fpga::ReadBinaryString(str + 1, val.val);
+}
+
+template <typename T,
+          std::enable_if_t<!fpga::kHasPackedBinaryString<T>, int> = 0>
 std::string ToBinaryStringImpl(const elem_t<T>* val) {
   return fpga::ToBinaryString(val->eot) + fpga::ToBinaryString(val->val);
 }
-template <typename T>
+template <typename T,
+          std::enable_if_t<!fpga::kHasPackedBinaryString<T>, int> = 0>
 void FromBinaryStringImpl(std::string_view str, elem_t<T>& val) {
   CHECK_GE(str.size(), 1);
   val.eot = fpga::FromBinaryString<bool>(str.substr(0, 1));
@@ -59,6 +92,8 @@ void FromBinaryStringImpl(std::string_view str, elem_t<T>& val) {
 template <typename Param, typename Arg>
 struct accessor;
 
+struct replay_access;
+
 class type_erased_queue {
  public:
   virtual ~type_erased_queue() = default;
@@ -70,80 +105,623 @@ class type_erased_queue {
   virtual bool empty() const = 0;
   virtual bool full() const = 0;
 
+  // Returns `nullptr` unless statistics are enabled; see `channel_stats`.
+  channel_stats* get_stats() const { return this->stats.get(); }
+
+  // Depth of the stream in hardware, as opposed to the capacity of the queue.
+  uint64_t get_synthesis_depth() const { return this->synthesis_depth; }
+  void set_synthesis_depth(uint64_t depth) { this->synthesis_depth = depth; }
+
+  // Unique among all queues of the process, unlike their addresses.
+  uint64_t get_serial() const { return this->serial; }
+
+  // Blocks the caller until `ready` returns true. `state` describes why the
+  // caller is blocked, e.g., `yield_reason::kChannelEmpty`.
+  template <typename Ready>
+  void wait(const Ready& ready, yield_reason::kind_t state) const {
+    if (!ready()) this->wait_slow(ready, state);
+  }
+
  protected:
   struct LogContext {
     static std::unique_ptr<LogContext> New(std::string_view name);
+    ~LogContext();
+
+    // Appends a fixed-width record of a token in the binary format, which is
+    // buffered and written in large chunks.
+    void AppendBinary(bool eot, const void* val, size_t size);
+
+    // Writes the pending output. Compressed chunks are written on a
+    // background thread, which the next call waits for.
+    void Flush();
+
     std::ofstream ofs;
     std::mutex mtx;
+    bool is_binary = false;
+    bool is_compressed = false;  // Whether the binary format is compressed.
+    std::string buffer;          // Pending output of the binary format.
+    int64_t record_width = -1;   // Size of values; -1 if no header is written.
+    std::string chunk;           // Output being compressed by `pending`.
+    std::future<void> pending;
+  };
+
+  // Reads records of the binary format written by `LogContext`.
+  class LogReader {
+   public:
+    // Opens the log at `path`, whose values must have `record_width` bytes.
+    // Compressed logs are decompressed a chunk ahead on a background thread.
+    LogReader(const std::string& path, size_t record_width);
+
+    // Not movable, since the background thread refers to this reader.
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    // Returns the next record, which is the EoT flag followed by the value, or
+    // nullptr if all records are read.
+    const char* peek();
+    void next();
+
+    // Index of the next record.
+    int64_t index() const { return this->record_index; }
+
+   private:
+    // Reads up to `size` bytes of the binary format to `data`, and returns
+    // the number of bytes read.
+    size_t Read(char* data, size_t size);
+
+    // Reads and decompresses the next chunk of a compressed log, or returns
+    // an empty string at the end of the log.
+    std::string ReadChunk();
+
+    const std::string path;
+    const size_t record_width;
+    std::ifstream ifs;
+    std::string buffer;  // Records read from `ifs`.
+    size_t offset = 0;   // Offset of the next record in `buffer`.
+    int64_t record_index = 0;
+
+    bool is_compressed = false;
+    std::string chunk;        // Decompressed chunk being read.
+    size_t chunk_offset = 0;  // Offset of the next byte in `chunk`.
+    std::future<std::string> next_chunk;
   };
 
   std::string name;
   const std::unique_ptr<LogContext> log;
+  mutable wait_queue waiters;
+  const std::shared_ptr<channel_stats> stats;
+  const uint64_t serial;
+  uint64_t synthesis_depth = ::tapa::kStreamInfiniteDepth;
 
-  type_erased_queue(const std::string& name);
+  // Statistics are not collected if `has_stats` is false, e.g., if the queue
+  // has more than one producer or consumer; see `channel_stats`.
+  type_erased_queue(const std::string& name, bool has_stats = true);
 
   void check_leftover() const;
 
+  // Wakes up callers blocked in `wait`. Must be called after `empty` or `full`
+  // may have changed.
+  void notify() const { this->waiters.notify(); }
+
+  // Whether `notify` is called whenever `empty` or `full` may have changed.
+  // Otherwise, callers blocked in `wait` poll the state.
+  virtual bool is_notifying() const { return true; }
+
   template <typename T>
   void maybe_log(const T& elem) {
-    if (this->log != nullptr) {
-      std::unique_lock<std::mutex> lock(this->log->mtx);
+    if (this->log == nullptr) return;
+    std::unique_lock<std::mutex> lock(this->log->mtx);
+    if (!this->log->is_binary) {
       this->log->ofs << elem << std::endl;
+    } else if constexpr (std::is_trivially_copyable_v<decltype(elem.val)>) {
+      this->log->AppendBinary(elem.eot, &elem.val, sizeof(elem.val));
+    } else {
+      LOG_FIRST_N(WARNING, 1) << "channel '" << this->name
+                              << "' is not trivially copyable and cannot be "
+                                 "logged in binary format";
     }
   }
+
+ private:
+  void wait_slow(const std::function<bool()>& ready,
+                 yield_reason::kind_t state) const;
 };
 
 template <typename T>
 class base_queue : public type_erased_queue {
  public:
+  using value_type = decltype(T::val);
+
   virtual void push(const T& val) = 0;
   virtual T pop() = 0;
-  virtual T front() const = 0;
+
+  // Returns the next token, which is valid until it is popped.
+  virtual const T& front() const = 0;
+
+  // Same as `push(const T&)`, but may move from `val`.
+  virtual void push(T&& val) { this->push(static_cast<const T&>(val)); }
+
+  // Returns the next token, which is valid until it is popped, or null if the
+  // queue is empty. Same as `empty` followed by `front`, but may check the
+  // indices only once.
+  virtual const T* try_front() const {
+    return this->empty() ? nullptr : &this->front();
+  }
+
+  // Pops the next token into `val` unless the queue is empty. Same as `empty`
+  // followed by `pop`, but may check the indices only once.
+  virtual bool try_pop(T& val) {
+    if (this->empty()) return false;
+    val = this->pop();
+    return true;
+  }
+
+  // Pops up to `n` available tokens into `values`, stopping before EoT.
+  // Returns the number of tokens popped.
+  virtual size_t pop_n(value_type* values, size_t n) {
+    size_t count = 0;
+    while (count < n && !this->empty() && !this->front().eot) {
+      values[count++] = this->pop().val;
+    }
+    return count;
+  }
+
+  // Same as `pop_n`, but then pops EoT as well if it is the next token, in
+  // which case `is_eot` is set. EoT is not counted in the returned number.
+  virtual size_t pop_n(value_type* values, size_t n, bool& is_eot) {
+    const size_t count = this->pop_n(values, n);
+    if (!this->empty() && this->front().eot) {
+      this->pop();
+      is_eot = true;
+    }
+    return count;
+  }
+
+  // Pushes up to `n` tokens from `values` as long as there is space. Returns
+  // the number of tokens pushed.
+  virtual size_t push_n(const value_type* values, size_t n) {
+    size_t count = 0;
+    while (count < n && !this->full()) this->push({values[count++], false});
+    return count;
+  }
+
+  // Same as `push_n`, but then pushes EoT as well if `close`, all `n` tokens
+  // are pushed, and there is space. EoT is counted in the returned number.
+  virtual size_t push_n(const value_type* values, size_t n, bool close) {
+    size_t count = this->push_n(values, n);
+    if (close && count == n && !this->full()) {
+      this->push({{}, true});
+      ++count;
+    }
+    return count;
+  }
 
  protected:
   using type_erased_queue::type_erased_queue;
 };
 
+// Size of cache lines, used to avoid false sharing between producer and
+// consumer.
+inline constexpr size_t kCacheLineSize = 64;
+
+// Single-producer single-consumer ring buffer.
 template <typename T>
-class lock_free_queue : public base_queue<T> {
-  // producer writes to head and consumer reads from tail
-  // okay to keep incrementing because it'll take > 100 yr to overflow uint64_t
-  std::atomic<uint64_t> tail{0};
-  std::atomic<uint64_t> head{0};
+class lock_free_queue final : public base_queue<T> {
+  // Producer writes to head and consumer reads from tail. Okay to keep
+  // incrementing because it'll take > 100 yr to overflow uint64_t.
+  //
+  // Each side keeps a cached copy of the other side's index, and only reloads
+  // it when the cached copy says the queue is empty (consumer) or full
+  // (producer). Indices are published with sequentially consistent stores so
+  // that they are ordered before `notify` checks for parked waiters. Tokens
+  // are handed over only through these atomics, which ThreadSanitizer models
+  // without annotations.
+  struct alignas(kCacheLineSize) consumer_state {
+    std::atomic<uint64_t> tail{0};
+    uint64_t cached_head = 0;
+  };
+  struct alignas(kCacheLineSize) producer_state {
+    std::atomic<uint64_t> head{0};
+    uint64_t cached_tail = 0;
+  };
+  mutable consumer_state consumer;
+  mutable producer_state producer;
 
-  std::vector<T> buffer;
+  // Frees storage allocated by `allocate_buffer`.
+  struct buffer_deleter {
+    void operator()(T* buffer) const {
+      ::operator delete(buffer, std::align_val_t(alignof(T)));
+    }
+  };
+
+  const uint64_t depth;
+  const uint64_t mask;  // Buffer size is a power of two no less than `depth`.
+  std::unique_ptr<T, buffer_deleter> owned_buffer;  // Null if not owned.
+
+  // Slots are raw storage. A token is constructed in its slot when pushed and
+  // destroyed when popped, so only slots in [tail, head) hold objects.
+  T* const buffer;
 
  public:
-  // constructors
-  lock_free_queue(size_t depth, const std::string& name) : base_queue<T>(name) {
-    this->buffer.resize(depth);
+  // Returns the number of tokens in the buffer of a queue of `depth`.
+  static uint64_t buffer_size(uint64_t depth) {
+    uint64_t size = 1;
+    while (size < depth) size <<= 1;
+    return size;
   }
 
+  // constructors
+  lock_free_queue(size_t depth, const std::string& name)
+      : base_queue<T>(name),
+        depth(depth),
+        mask(buffer_size(depth) - 1),
+        owned_buffer(allocate_buffer(this->mask + 1)),
+        buffer(this->owned_buffer.get()) {}
+
+  // Uses `buffer` of `buffer_size(depth)` tokens, which must outlive this.
+  // The storage need not be initialized.
+  lock_free_queue(size_t depth, const std::string& name, T* buffer)
+      : base_queue<T>(name),
+        depth(depth),
+        mask(buffer_size(depth) - 1),
+        buffer(buffer) {}
+
   // debug helpers
-  uint64_t get_depth() const { return this->buffer.size(); }
+  uint64_t get_depth() const { return this->depth; }
 
   // basic queue operations
-  bool empty() const override { return this->head - this->tail <= 0; }
+  bool empty() const override {
+    return !this->available(
+        this->consumer.tail.load(std::memory_order_relaxed));
+  }
   bool full() const override {
-    return this->head - this->tail >= this->buffer.size();
+    const uint64_t head = this->producer.head.load(std::memory_order_relaxed);
+    if (head - this->producer.cached_tail < this->depth) return false;
+    this->producer.cached_tail =
+        this->consumer.tail.load(std::memory_order_acquire);
+    return head - this->producer.cached_tail >= this->depth;
+  }
+  const T& front() const override {
+    return this->buffer[this->consumer.tail.load(std::memory_order_relaxed) &
+                        this->mask];
   }
-  T front() const override { return this->buffer[this->tail % buffer.size()]; }
   T pop() override {
-    auto val = this->front();
-    ++this->tail;
+    const uint64_t tail = this->consumer.tail.load(std::memory_order_relaxed);
+    T* slot = &this->buffer[tail & this->mask];
+    auto val = std::move(*slot);
+    std::destroy_at(slot);
+    this->consumer.tail.store(tail + 1);
+    this->notify();
     return val;
   }
   void push(const T& val) override {
     this->maybe_log(val);
-    this->buffer[this->head % buffer.size()] = val;
-    ++this->head;
+    const uint64_t head = this->producer.head.load(std::memory_order_relaxed);
+    new (&this->buffer[head & this->mask]) T(val);
+    this->producer.head.store(head + 1);
+    this->notify();
+  }
+  void push(T&& val) override {
+    this->maybe_log(val);
+    const uint64_t head = this->producer.head.load(std::memory_order_relaxed);
+    new (&this->buffer[head & this->mask]) T(std::move(val));
+    this->producer.head.store(head + 1);
+    this->notify();
+  }
+
+  // Fused operations load the tail index once, and reload the head index only
+  // if the cached copy says the queue is empty.
+  const T* try_front() const override {
+    const uint64_t tail = this->consumer.tail.load(std::memory_order_relaxed);
+    if (!this->available(tail)) return nullptr;
+    return &this->buffer[tail & this->mask];
+  }
+  bool try_pop(T& val) override {
+    const uint64_t tail = this->consumer.tail.load(std::memory_order_relaxed);
+    if (!this->available(tail)) return false;
+    T* slot = &this->buffer[tail & this->mask];
+    val = std::move(*slot);
+    std::destroy_at(slot);
+    this->consumer.tail.store(tail + 1);
+    this->notify();
+    return true;
   }
 
-  ~lock_free_queue() { this->check_leftover(); }
+  // Bulk operations copy contiguous segments of the ring buffer, and publish
+  // the index and notify waiters only once.
+  using value_type = typename base_queue<T>::value_type;
+  size_t pop_n(value_type* values, size_t n) override {
+    return this->pop_values(values, n, /*is_eot=*/nullptr);
+  }
+  size_t pop_n(value_type* values, size_t n, bool& is_eot) override {
+    return this->pop_values(values, n, &is_eot);
+  }
+  size_t push_n(const value_type* values, size_t n) override {
+    return this->push_values(values, n, /*close=*/false);
+  }
+  size_t push_n(const value_type* values, size_t n, bool close) override {
+    return this->push_values(values, n, close);
+  }
+
+  ~lock_free_queue() {
+    this->check_leftover();
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      const uint64_t head = this->producer.head.load(std::memory_order_relaxed);
+      for (uint64_t i = this->consumer.tail.load(std::memory_order_relaxed);
+           i != head; ++i) {
+        std::destroy_at(&this->buffer[i & this->mask]);
+      }
+    }
+  }
+
+ private:
+  // Allocates uninitialized storage for `size` tokens.
+  static T* allocate_buffer(uint64_t size) {
+    return static_cast<T*>(
+        ::operator new(size * sizeof(T), std::align_val_t(alignof(T))));
+  }
+
+  // Returns whether a token is available at `tail`, the consumer's index.
+  bool available(uint64_t tail) const {
+    if (this->consumer.cached_head != tail) return true;
+    this->consumer.cached_head =
+        this->producer.head.load(std::memory_order_acquire);
+    return this->consumer.cached_head != tail;
+  }
+
+  // Pops up to `n` tokens stopping before EoT, and then EoT if `is_eot` is not
+  // null, in which case `*is_eot` is set. Returns the number of tokens popped
+  // excluding EoT.
+  size_t pop_values(value_type* values, size_t n, bool* is_eot) {
+    const uint64_t tail = this->consumer.tail.load(std::memory_order_relaxed);
+    if (this->consumer.cached_head - tail < n + (is_eot != nullptr)) {
+      this->consumer.cached_head =
+          this->producer.head.load(std::memory_order_acquire);
+    }
+    const uint64_t available = this->consumer.cached_head - tail;
+    n = std::min<uint64_t>(n, available);
+    size_t count = 0;
+    bool found_eot = false;
+    while (count < n && !found_eot) {
+      const uint64_t begin = (tail + count) & this->mask;
+      const uint64_t end = std::min<uint64_t>(begin + n - count, mask + 1);
+      for (uint64_t i = begin; i < end; ++i) {
+        if ((found_eot = this->buffer[i].eot)) break;
+        values[count++] = std::move(this->buffer[i].val);
+        std::destroy_at(&this->buffer[i]);
+      }
+    }
+    if (!found_eot && count < available) {
+      found_eot = this->buffer[(tail + count) & this->mask].eot;
+    }
+    uint64_t popped = count;
+    if (is_eot != nullptr && found_eot) {
+      *is_eot = true;
+      std::destroy_at(&this->buffer[(tail + count) & this->mask]);
+      ++popped;
+    }
+    if (popped > 0) {
+      this->consumer.tail.store(tail + popped);
+      this->notify();
+    }
+    return count;
+  }
+
+  // Pushes up to `n` tokens from `values` as long as there is space, and then
+  // EoT if `close` and there is still space. Returns the number of tokens
+  // pushed including EoT.
+  size_t push_values(const value_type* values, size_t n, bool close) {
+    const uint64_t head = this->producer.head.load(std::memory_order_relaxed);
+    if (head - this->producer.cached_tail + n + close > this->depth) {
+      this->producer.cached_tail =
+          this->consumer.tail.load(std::memory_order_acquire);
+    }
+    const uint64_t space = this->depth - (head - this->producer.cached_tail);
+    const uint64_t count = std::min<uint64_t>(n, space);
+    for (uint64_t i = 0; i < count;) {
+      const uint64_t begin = (head + i) & this->mask;
+      const uint64_t end = std::min<uint64_t>(begin + count - i, mask + 1);
+      for (uint64_t j = begin; j < end; ++j, ++i) {
+        this->maybe_log(*new (&this->buffer[j]) T{values[i], false});
+      }
+    }
+    uint64_t pushed = count;
+    if (close && count == n && space > n) {
+      T* slot = &this->buffer[(head + n) & this->mask];
+      this->maybe_log(*new (slot) T{{}, true});
+      ++pushed;
+    }
+    if (pushed > 0) {
+      this->producer.head.store(head + pushed);
+      this->notify();
+    }
+    return pushed;
+  }
 };
 
+// Single-producer single-consumer queue without a bound depth. Tokens are
+// stored in fixed-size segments linked in FIFO order. Segments that the
+// consumer has left are reused by the producer instead of being freed.
 template <typename T>
-class locked_queue : public base_queue<T> {
+class unbounded_queue final : public base_queue<T> {
+  static constexpr uint64_t kSegmentLength = 1024;
+
+  struct segment {
+    std::array<T, kSegmentLength> buffer;
+    std::atomic<segment*> next{nullptr};
+  };
+
+  // Same as `lock_free_queue`, with the segment that holds the token at
+  // `tail` (consumer) or `head` (producer), and the index of its first slot.
+  struct alignas(kCacheLineSize) consumer_state {
+    std::atomic<uint64_t> tail{0};
+    uint64_t cached_head = 0;
+    segment* seg = nullptr;
+    uint64_t seg_begin = 0;
+
+    // Published so that the producer knows which segments to reuse.
+    std::atomic<segment*> published_seg{nullptr};
+  };
+  struct alignas(kCacheLineSize) producer_state {
+    std::atomic<uint64_t> head{0};
+    segment* seg = nullptr;
+    uint64_t seg_begin = 0;
+
+    // Oldest segment, which is reused if the consumer has left it. All
+    // segments are reachable from it.
+    segment* first = nullptr;
+  };
+  mutable consumer_state consumer;
+  producer_state producer;
+
+  const uint64_t depth;
+
+  // Returns whether a token is available at `tail`, the consumer's index.
+  bool available(uint64_t tail) const {
+    if (this->consumer.cached_head != tail) return true;
+    this->consumer.cached_head =
+        this->producer.head.load(std::memory_order_acquire);
+    return this->consumer.cached_head != tail;
+  }
+
+  // Returns the slot of the token at `tail`, which must be available.
+  T& consumer_slot(uint64_t tail) const {
+    if (tail - this->consumer.seg_begin == kSegmentLength) {
+      this->consumer.seg =
+          this->consumer.seg->next.load(std::memory_order_acquire);
+      this->consumer.seg_begin = tail;
+      this->consumer.published_seg.store(this->consumer.seg,
+                                         std::memory_order_release);
+    }
+    return this->consumer.seg->buffer[tail - this->consumer.seg_begin];
+  }
+
+  // Returns the slot for the token at `head`, linking a new segment if needed.
+  T& producer_slot(uint64_t head) {
+    if (head - this->producer.seg_begin == kSegmentLength) {
+      segment* seg = this->producer.first;
+      if (seg != this->consumer.published_seg.load(std::memory_order_acquire)) {
+        this->producer.first = seg->next.load(std::memory_order_relaxed);
+        seg->next.store(nullptr, std::memory_order_relaxed);
+      } else {
+        seg = new segment;
+      }
+      // Published to the consumer by the release store of `head`.
+      this->producer.seg->next.store(seg, std::memory_order_relaxed);
+      this->producer.seg = seg;
+      this->producer.seg_begin = head;
+    }
+    return this->producer.seg->buffer[head - this->producer.seg_begin];
+  }
+
+ public:
+  // constructors
+  unbounded_queue(size_t depth, const std::string& name)
+      : base_queue<T>(name), depth(depth) {
+    auto* seg = new segment;
+    this->consumer.seg = seg;
+    this->consumer.published_seg.store(seg, std::memory_order_relaxed);
+    this->producer.seg = seg;
+    this->producer.first = seg;
+  }
+  unbounded_queue(const unbounded_queue&) = delete;
+  unbounded_queue& operator=(const unbounded_queue&) = delete;
+
+  // debug helpers
+  uint64_t get_depth() const { return this->depth; }
+
+  // basic queue operations
+  bool empty() const override {
+    return !this->available(
+        this->consumer.tail.load(std::memory_order_relaxed));
+  }
+  bool full() const override { return false; }
+  const T& front() const override {
+    return this->consumer_slot(
+        this->consumer.tail.load(std::memory_order_relaxed));
+  }
+  T pop() override {
+    const uint64_t tail = this->consumer.tail.load(std::memory_order_relaxed);
+    auto val = std::move(this->consumer_slot(tail));
+    this->consumer.tail.store(tail + 1);
+    this->notify();
+    return val;
+  }
+  const T* try_front() const override {
+    const uint64_t tail = this->consumer.tail.load(std::memory_order_relaxed);
+    if (!this->available(tail)) return nullptr;
+    return &this->consumer_slot(tail);
+  }
+  bool try_pop(T& val) override {
+    const uint64_t tail = this->consumer.tail.load(std::memory_order_relaxed);
+    if (!this->available(tail)) return false;
+    val = std::move(this->consumer_slot(tail));
+    this->consumer.tail.store(tail + 1);
+    this->notify();
+    return true;
+  }
+  void push(const T& val) override {
+    this->maybe_log(val);
+    const uint64_t head = this->producer.head.load(std::memory_order_relaxed);
+    this->producer_slot(head) = val;
+    this->producer.head.store(head + 1);
+    this->notify();
+  }
+  void push(T&& val) override {
+    this->maybe_log(val);
+    const uint64_t head = this->producer.head.load(std::memory_order_relaxed);
+    this->producer_slot(head) = std::move(val);
+    this->producer.head.store(head + 1);
+    this->notify();
+  }
+
+  // Bulk operations publish the index and notify waiters only once.
+  using value_type = typename base_queue<T>::value_type;
+  using base_queue<T>::pop_n;
+  using base_queue<T>::push_n;
+  size_t pop_n(value_type* values, size_t n) override {
+    const uint64_t tail = this->consumer.tail.load(std::memory_order_relaxed);
+    if (this->consumer.cached_head - tail < n) {
+      this->consumer.cached_head =
+          this->producer.head.load(std::memory_order_acquire);
+    }
+    n = std::min<uint64_t>(n, this->consumer.cached_head - tail);
+    size_t count = 0;
+    for (; count < n; ++count) {
+      T& elem = this->consumer_slot(tail + count);
+      if (elem.eot) break;
+      values[count] = std::move(elem.val);
+    }
+    if (count > 0) {
+      this->consumer.tail.store(tail + count);
+      this->notify();
+    }
+    return count;
+  }
+  size_t push_n(const value_type* values, size_t n) override {
+    const uint64_t head = this->producer.head.load(std::memory_order_relaxed);
+    for (size_t count = 0; count < n; ++count) {
+      T& elem = this->producer_slot(head + count);
+      elem = {values[count], false};
+      this->maybe_log(elem);
+    }
+    if (n > 0) {
+      this->producer.head.store(head + n);
+      this->notify();
+    }
+    return n;
+  }
+
+  ~unbounded_queue() {
+    this->check_leftover();
+    for (segment* seg = this->producer.first; seg != nullptr;) {
+      delete std::exchange(seg, seg->next.load(std::memory_order_relaxed));
+    }
+  }
+};
+
+template <typename T>
+class locked_queue final : public base_queue<T> {
   size_t depth;
   mutable std::mutex mtx;
   std::deque<T> buffer;
@@ -165,25 +743,76 @@ class locked_queue : public base_queue<T> {
     std::unique_lock<std::mutex> lock(this->mtx);
     return this->buffer.size() >= this->depth;
   }
-  T front() const override {
+  const T& front() const override {
+    // References to elements of `std::deque` are stable when pushing.
     std::unique_lock<std::mutex> lock(this->mtx);
     return this->buffer.front();
   }
   T pop() override {
     std::unique_lock<std::mutex> lock(this->mtx);
-    auto val = this->buffer.front();
+    auto val = std::move(this->buffer.front());
     this->buffer.pop_front();
+    lock.unlock();
+    this->notify();
     return val;
   }
   void push(const T& val) override {
     std::unique_lock<std::mutex> lock(this->mtx);
     this->maybe_log(val);
     this->buffer.push_back(val);
+    lock.unlock();
+    this->notify();
+  }
+  void push(T&& val) override {
+    std::unique_lock<std::mutex> lock(this->mtx);
+    this->maybe_log(val);
+    this->buffer.push_back(std::move(val));
+    lock.unlock();
+    this->notify();
   }
 
   ~locked_queue() { this->check_leftover(); }
 };
 
+// Implementation of `base_queue` without any synchronization, which is only
+// used if all tasks run on one thread; see `is_deterministic`.
+template <typename T>
+class sequential_queue : public base_queue<T> {
+  const size_t depth;
+  std::deque<T> buffer;
+
+ public:
+  // constructors
+  sequential_queue(size_t depth, const std::string& name)
+      : base_queue<T>(name), depth(depth) {}
+
+  // debug helpers
+  uint64_t get_depth() const { return this->depth; }
+
+  // basic queue operations
+  bool empty() const override { return this->buffer.empty(); }
+  bool full() const override { return this->buffer.size() >= this->depth; }
+  const T& front() const override { return this->buffer.front(); }
+  T pop() override {
+    auto val = std::move(this->buffer.front());
+    this->buffer.pop_front();
+    this->notify();
+    return val;
+  }
+  void push(const T& val) override {
+    this->maybe_log(val);
+    this->buffer.push_back(val);
+    this->notify();
+  }
+  void push(T&& val) override {
+    this->maybe_log(val);
+    this->buffer.push_back(std::move(val));
+    this->notify();
+  }
+
+  ~sequential_queue() { this->check_leftover(); }
+};
+
 // Implementation of `base_queue` that is a wrapper of either `fpga::ReadStream`
 // or `fpga::WriteStream`.
 template <typename T>
@@ -198,17 +827,45 @@ class frt_queue : public base_queue<T> {
       : base_queue<T>(name), stream_(in_place_arg, depth) {}
   bool empty() const override { return GetReadStream().empty(); }
   bool full() const override { return GetWriteStream().full(); }
+  using base_queue<T>::push;
   void push(const T& val) override { GetWriteStream().push(val); }
   T pop() override { return GetReadStream().pop(); };
-  T front() const override { return GetReadStream().front(); }
+  const T& front() const override {
+    return this->front_ = GetReadStream().front();
+  }
 
   auto& GetReadStream() { return std::get<ReadStream>(stream_); }
   auto& GetReadStream() const { return std::get<ReadStream>(stream_); }
   auto& GetWriteStream() { return std::get<WriteStream>(stream_); }
   auto& GetWriteStream() const { return std::get<WriteStream>(stream_); }
 
+  // Returns whether `Stream` is the opposite end of this stream.
+  template <typename Stream>
+  bool IsPeer() const {
+    return !std::holds_alternative<Stream>(stream_);
+  }
+
+  // Returns the opposite end of the stream, sharing its queue, for another
+  // device to access directly. The host must not access either end then.
+  template <typename Stream>
+  Stream& GetPeerStream() {
+    CHECK(!peer_.has_value())
+        << "stream '" << this->get_name()
+        << "' already connects two kernels; each end of a stream can be "
+           "passed to only one kernel";
+    auto shared = std::visit([](auto& x) { return x.stream(); }, stream_);
+    return std::get<Stream>(
+        peer_.emplace(std::in_place_type<Stream>, std::move(shared)));
+  }
+
+ protected:
+  // The peer is the device, which does not notify state changes.
+  bool is_notifying() const override { return false; }
+
  private:
   std::variant<fpga::ReadStream<T>, fpga::WriteStream<T>> stream_;
+  std::optional<std::variant<fpga::ReadStream<T>, fpga::WriteStream<T>>> peer_;
+  mutable T front_;  // Copy of the next token returned by `front`.
 };
 
 template <typename T>
@@ -228,14 +885,102 @@ class basic_stream {
   uint64_t get_depth() const { return this->ptr->get_depth(); }
 
   // not protected since we'll use std::vector<basic_stream<T>>
-  basic_stream(const std::shared_ptr<base_queue<elem_t<T>>>& ptr) : ptr(ptr) {}
+  basic_stream(const std::shared_ptr<base_queue<elem_t<T>>>& ptr) {
+    this->reset(ptr);
+  }
   basic_stream(const basic_stream&) = default;
   basic_stream(basic_stream&&) = default;
   basic_stream& operator=(const basic_stream&) = default;
   basic_stream& operator=(basic_stream&&) = delete;  // -Wvirtual-move-assign
 
  protected:
+  template <typename, typename>
+  friend struct channel_traits;
+  friend struct replay_access;
+  template <typename>
+  friend class basic_streams;
+
+  using fast_queue_t = queue<elem_t<T>>;
+
+  void reset(std::shared_ptr<base_queue<elem_t<T>>> ptr) {
+    this->fast_ptr = dynamic_cast<fast_queue_t*>(ptr.get());
+    this->ptr = std::move(ptr);
+  }
+
+  // Queue operations. If the queue is the default `queue`, which is final,
+  // they are called directly instead of through the vtable and get inlined.
+  bool queue_empty() const {
+    return fast_ptr != nullptr ? fast_ptr->empty() : ptr->empty();
+  }
+  bool queue_full() const {
+    return fast_ptr != nullptr ? fast_ptr->full() : ptr->full();
+  }
+  const elem_t<T>& queue_front() const {
+    return fast_ptr != nullptr ? fast_ptr->front() : ptr->front();
+  }
+  const elem_t<T>* queue_try_front() const {
+    return fast_ptr != nullptr ? fast_ptr->try_front() : ptr->try_front();
+  }
+  bool queue_try_pop(elem_t<T>& elem) const {
+    const bool is_popped =
+        fast_ptr != nullptr ? fast_ptr->try_pop(elem) : ptr->try_pop(elem);
+    if (channel_stats* stats = ptr->get_stats(); stats && is_popped) {
+      stats->count_pop(1);
+    }
+    return is_popped;
+  }
+  elem_t<T> queue_pop() const {
+    auto elem = fast_ptr != nullptr ? fast_ptr->pop() : ptr->pop();
+    if (channel_stats* stats = ptr->get_stats()) stats->count_pop(1);
+    return elem;
+  }
+  void queue_push(elem_t<T>&& elem) const {
+    if (fast_ptr != nullptr) {
+      fast_ptr->push(std::move(elem));
+    } else {
+      ptr->push(std::move(elem));
+    }
+    if (channel_stats* stats = ptr->get_stats()) stats->count_push(1);
+  }
+  size_t queue_pop_n(T* values, size_t n) const {
+    const size_t count = fast_ptr != nullptr ? fast_ptr->pop_n(values, n)
+                                             : ptr->pop_n(values, n);
+    if (channel_stats* stats = ptr->get_stats(); stats && count > 0) {
+      stats->count_pop(count);
+    }
+    return count;
+  }
+  size_t queue_push_n(const T* values, size_t n) const {
+    const size_t count = fast_ptr != nullptr ? fast_ptr->push_n(values, n)
+                                             : ptr->push_n(values, n);
+    if (channel_stats* stats = ptr->get_stats(); stats && count > 0) {
+      stats->count_push(count);
+    }
+    return count;
+  }
+  size_t queue_pop_n(T* values, size_t n, bool& is_eot) const {
+    const size_t count = fast_ptr != nullptr
+                             ? fast_ptr->pop_n(values, n, is_eot)
+                             : ptr->pop_n(values, n, is_eot);
+    if (channel_stats* stats = ptr->get_stats(); stats && count + is_eot > 0) {
+      stats->count_pop(count + is_eot);
+    }
+    return count;
+  }
+  size_t queue_push_n(const T* values, size_t n, bool close) const {
+    const size_t count = fast_ptr != nullptr
+                             ? fast_ptr->push_n(values, n, close)
+                             : ptr->push_n(values, n, close);
+    if (channel_stats* stats = ptr->get_stats(); stats && count > 0) {
+      stats->count_push(count);
+    }
+    return count;
+  }
+
   std::shared_ptr<base_queue<elem_t<T>>> ptr;
+
+  // Same as `ptr` if it points to a `fast_queue_t`, or null otherwise.
+  fast_queue_t* fast_ptr = nullptr;
 };
 
 // shared pointer of multiple queues
@@ -267,6 +1012,47 @@ class basic_streams {
            std::to_string(ptr->pos + length) + ")";
   }
 
+  // Returns the first stream that is empty, or null if none is.
+  const basic_stream<T>* find_empty() const {
+    for (const auto& ref : ptr->refs) {
+      if (ref.queue_empty()) return &ref;
+    }
+    return nullptr;
+  }
+
+  // Returns the first stream that is full, or null if none is.
+  const basic_stream<T>* find_full() const {
+    for (const auto& ref : ptr->refs) {
+      if (ref.queue_full()) return &ref;
+    }
+    return nullptr;
+  }
+
+  // Pops a token from each stream into `values`. No stream may be empty, and
+  // none of the tokens may be EoT.
+  template <typename Vec>
+  void pop_each(Vec& values) const {
+    for (size_t i = 0; i < ptr->refs.size(); ++i) {
+      auto elem = ptr->refs[i].queue_pop();
+      if (elem.eot) {
+        LOG(FATAL) << "channel '" << ptr->refs[i].get_name()
+                   << "' read when closed";
+      }
+      values.set(i, std::move(elem.val));
+    }
+  }
+
+  // Pushes a token from `values` to each stream, none of which may be full.
+  template <typename Vec>
+  void push_each(const Vec& values) const {
+    for (size_t i = 0; i < ptr->refs.size(); ++i) {
+      ptr->refs[i].queue_push({values[i], false});
+    }
+  }
+
+  template <typename, typename>
+  friend struct channel_traits;
+
   std::shared_ptr<metadata_t> ptr;
 };
 
@@ -311,17 +1097,170 @@ std::ostream& operator<<(std::ostream& os, const elem_t<T>& elem) {
   return os;
 }
 
+// Returns the depth of queues simulating streams of simulation depth `depth`.
+// Bounded depths are multiplied by `TAPA_STREAM_DEPTH_SCALE`, so that shallow
+// streams do not make their peers switch on every token.
+uint64_t get_scaled_depth(uint64_t depth);
+
+// Returns a queue simulating a stream of simulation depth `depth` and
+// synthesis depth `synthesis_depth`. The latter is only used to warn about
+// channels that hold more tokens than in hardware; see `channel_stats`.
 template <typename T>
-std::shared_ptr<base_queue<T>> make_queue(uint64_t depth,
-                                          const std::string& name = "") {
-  if (depth == ::tapa::kStreamInfiniteDepth) {
-    // It's too expensive to make the lock-free queue have infinite depth.
-    return std::make_shared<locked_queue<T>>(depth, name);
+std::shared_ptr<base_queue<T>> make_queue(
+    uint64_t depth, const std::string& name = "",
+    uint64_t synthesis_depth = ::tapa::kStreamInfiniteDepth) {
+  depth = get_scaled_depth(depth);
+  std::shared_ptr<base_queue<T>> ptr;
+  if (is_deterministic()) {
+    // Statically scheduled producers may run to completion before their
+    // consumers start, so channels must hold all of their tokens.
+    ptr = std::make_shared<sequential_queue<T>>(
+        is_statically_scheduled() ? ::tapa::kStreamInfiniteDepth : depth, name);
+  } else if (depth == ::tapa::kStreamInfiniteDepth) {
+#ifdef TAPA_USE_LOCKED_QUEUE
+    ptr = std::make_shared<locked_queue<T>>(depth, name);
+#else   // TAPA_USE_LOCKED_QUEUE
+    ptr = std::make_shared<unbounded_queue<T>>(depth, name);
+#endif  // TAPA_USE_LOCKED_QUEUE
   } else {
-    return std::make_shared<queue<T>>(depth, name);
+    ptr = std::make_shared<queue<T>>(depth, name);
+  }
+  ptr->set_synthesis_depth(synthesis_depth);
+  if (channel_stats* stats = ptr->get_stats()) {
+    stats->set_depth(depth);
+    stats->set_synthesis_depth(synthesis_depth);
+  }
+  return ptr;
+}
+
+// Queues of a `tapa::streams` array and their buffers, allocated in one block
+// so that neighboring channels are adjacent in memory. Queues and buffers
+// start at cache line boundaries to avoid false sharing between channels.
+// Buffers are not initialized; queues construct tokens only as they are pushed.
+template <typename T>
+class queue_arena {
+  using queue_t = lock_free_queue<T>;
+  static_assert(sizeof(queue_t) % kCacheLineSize == 0);
+
+  static size_t buffer_bytes(uint64_t depth) {
+    const size_t bytes = queue_t::buffer_size(depth) * sizeof(T);
+    return (bytes + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+  }
+
+ public:
+  queue_arena(uint64_t count, uint64_t depth, const std::string& name)
+      : count(count),
+        buffer_offset(sizeof(queue_t) * count),
+        buffer_stride(buffer_bytes(depth)),
+        data(static_cast<char*>(
+            ::operator new(this->buffer_offset + this->buffer_stride * count,
+                           std::align_val_t(kCacheLineSize)))) {
+    for (uint64_t i = 0; i < count; ++i) {
+      new (this->queue(i)) queue_t(
+          depth, name.empty() ? "" : name + "[" + std::to_string(i) + "]",
+          this->buffer(i));
+    }
+  }
+
+  // Not copyable or movable.
+  queue_arena(const queue_arena&) = delete;
+  queue_arena& operator=(const queue_arena&) = delete;
+
+  ~queue_arena() {
+    for (uint64_t i = 0; i < this->count; ++i) {
+      std::destroy_at(this->queue(i));
+    }
+    ::operator delete(this->data, std::align_val_t(kCacheLineSize));
+  }
+
+  queue_t* queue(uint64_t i) const {
+    return reinterpret_cast<queue_t*>(this->data + sizeof(queue_t) * i);
   }
+
+ private:
+  T* buffer(uint64_t i) const {
+    return reinterpret_cast<T*>(this->data + this->buffer_offset +
+                                this->buffer_stride * i);
+  }
+
+  const uint64_t count;
+  const size_t buffer_offset;  // Offset of the first buffer in `data`.
+  const size_t buffer_stride;  // Offset between neighboring buffers.
+  char* const data;
+};
+
+// Returns `count` queues for a `tapa::streams` array named `name`. The queues
+// share one `queue_arena` if they use the default `queue`.
+template <typename T>
+std::vector<std::shared_ptr<base_queue<T>>> make_queues(
+    uint64_t count, uint64_t depth, const std::string& name,
+    uint64_t synthesis_depth = ::tapa::kStreamInfiniteDepth) {
+  std::vector<std::shared_ptr<base_queue<T>>> queues;
+  queues.reserve(count);
+#ifndef TAPA_USE_LOCKED_QUEUE
+  if (const uint64_t scaled_depth = get_scaled_depth(depth);
+      !is_deterministic() && scaled_depth != ::tapa::kStreamInfiniteDepth) {
+    auto arena = std::make_shared<queue_arena<T>>(count, scaled_depth, name);
+    for (uint64_t i = 0; i < count; ++i) {
+      // Each queue shares the ownership of the whole arena.
+      auto& ptr = queues.emplace_back(arena, arena->queue(i));
+      ptr->set_synthesis_depth(synthesis_depth);
+      if (channel_stats* stats = ptr->get_stats()) {
+        stats->set_depth(scaled_depth);
+        stats->set_synthesis_depth(synthesis_depth);
+      }
+    }
+    return queues;
+  }
+#endif  // TAPA_USE_LOCKED_QUEUE
+  for (uint64_t i = 0; i < count; ++i) {
+    queues.push_back(make_queue<T>(
+        depth, name.empty() ? "" : name + "[" + std::to_string(i) + "]",
+        synthesis_depth));
+  }
+  return queues;
 }
 
+// Queue written by the producer of a `tapa::broadcast_stream`, which pushes
+// each token to the queues of all consumers. It is full if any of them is, so
+// the producer is never more than a queue ahead of the slowest consumer.
+template <typename T>
+class broadcast_queue final : public base_queue<T> {
+ public:
+  broadcast_queue(const std::string& name,
+                  std::vector<std::shared_ptr<base_queue<T>>> lanes)
+      : base_queue<T>(name, /*has_stats=*/false), lanes(std::move(lanes)) {}
+
+  bool empty() const override { return true; }
+  bool full() const override {
+    return std::any_of(this->lanes.begin(), this->lanes.end(),
+                       [](const auto& lane) { return lane->full(); });
+  }
+  const T& front() const override {
+    LOG(FATAL) << "broadcast stream '" << this->name
+               << "' is read by its producer";
+    return this->lanes.front()->front();
+  }
+  T pop() override {
+    LOG(FATAL) << "broadcast stream '" << this->name
+               << "' is read by its producer";
+    return {};
+  }
+  void push(const T& val) override {
+    for (const auto& lane : this->lanes) {
+      lane->push(val);
+      if (channel_stats* stats = lane->get_stats()) stats->count_push(1);
+    }
+  }
+
+ protected:
+  // Consumers only notify the producers waiting on their own queues.
+  bool is_notifying() const override { return false; }
+
+ private:
+  const std::vector<std::shared_ptr<base_queue<T>>> lanes;
+};
+
 }  // namespace internal
 
 /// Provides consumer-side operations to a @c tapa::stream where it is used as
@@ -338,10 +1277,8 @@ class istream : virtual public internal::basic_stream<T> {
   ///
   /// @return Whether the stream is empty.
   bool empty() const {
-    bool is_empty = this->ptr->empty();
-    if (is_empty) {
-      internal::yield("channel '" + this->get_name() + "' is empty");
-    }
+    bool is_empty = this->queue_empty();
+    if (is_empty) stall_on_empty();
     return is_empty;
   }
 
@@ -353,10 +1290,11 @@ class istream : virtual public internal::basic_stream<T> {
   ///                    updated to indicate whether the next token is EoT.
   /// @return            Whether @c is_eot is updated.
   bool try_eot(bool& is_eot) const {
-    if (!empty()) {
-      is_eot = this->ptr->front().eot;
+    if (const auto* elem = this->queue_try_front()) {
+      is_eot = elem->eot;
       return true;
     }
+    stall_on_empty();
     return false;
   }
 
@@ -393,14 +1331,14 @@ class istream : virtual public internal::basic_stream<T> {
   ///                   to be the value of the next token.
   /// @return           Whether @c value is updated.
   bool try_peek(T& value) const {
-    if (!empty()) {
-      auto elem = this->ptr->front();
-      if (elem.eot) {
+    if (const auto* elem = this->queue_try_front()) {
+      if (elem->eot) {
         LOG(FATAL) << "channel '" << this->get_name() << "' peeked when closed";
       }
-      value = elem.val;
+      value = elem->val;
       return true;
     }
+    stall_on_empty();
     return false;
   }
 
@@ -445,12 +1383,12 @@ class istream : virtual public internal::basic_stream<T> {
   ///                        available. Otherwise, default-constructed @c T() is
   ///                        returned.
   T peek(bool& is_success, bool& is_eot) const {
-    if (!empty()) {
-      auto elem = this->ptr->front();
+    if (const auto* elem = this->queue_try_front()) {
       is_success = true;
-      is_eot = elem.eot;
-      return elem.val;
+      is_eot = elem->eot;
+      return elem->val;
     }
+    stall_on_empty();
     is_success = false;
     is_eot = false;
     return {};
@@ -466,14 +1404,14 @@ class istream : virtual public internal::basic_stream<T> {
   ///                   to be the value of the next token.
   /// @return           Whether @c value is updated.
   bool try_read(T& value) {
-    if (!empty()) {
-      auto elem = this->ptr->pop();
+    if (internal::elem_t<T> elem; this->queue_try_pop(elem)) {
       if (elem.eot) {
         LOG(FATAL) << "channel '" << this->get_name() << "' read when closed";
       }
-      value = elem.val;
+      value = std::move(elem.val);
       return true;
     }
+    stall_on_empty();
     return false;
   }
 
@@ -485,10 +1423,117 @@ class istream : virtual public internal::basic_stream<T> {
   ///
   /// @return The value of the next token.
   T read() {
-    T val;
-    while (!try_read(val)) {
+    wait_until_not_empty();
+    auto elem = this->queue_pop();
+    if (elem.eot) {
+      LOG(FATAL) << "channel '" << this->get_name() << "' read when closed";
+    }
+    return std::move(elem.val);
+  }
+
+  /// Peeks the stream without copying the next token.
+  ///
+  /// This is a @a blocking and @a non-destructive operation.
+  ///
+  /// The next token must not be EoT.
+  ///
+  /// @return Reference to the value of the next token, which is valid until
+  ///         the token is read.
+  const T& peek_ref() const {
+    wait_until_not_empty();
+    const auto& elem = this->queue_front();
+    if (elem.eot) {
+      LOG(FATAL) << "channel '" << this->get_name() << "' peeked when closed";
+    }
+    return elem.val;
+  }
+
+  /// Reads @c n tokens from the stream.
+  ///
+  /// This is a @a blocking and @a destructive operation.
+  ///
+  /// None of the next @c n tokens may be EoT.
+  ///
+  /// @param[out] values Array of at least @c n elements to store the tokens.
+  /// @param[in]  n      Number of tokens to read.
+  void read_n(T* values, size_t n) {
+    for (size_t count = 0; count < n;) {
+      wait_until_not_empty();
+      const size_t popped = this->queue_pop_n(values + count, n - count);
+      if (popped == 0) {
+        LOG(FATAL) << "channel '" << this->get_name() << "' read when closed";
+      }
+      count += popped;
+    }
+  }
+
+  /// Reads up to @c n tokens that are available in the stream, stopping
+  /// before EoT.
+  ///
+  /// This is a @a non-blocking and @a destructive operation.
+  ///
+  /// @param[out] values Array of at least @c n elements to store the tokens.
+  /// @param[in]  n      Maximum number of tokens to read.
+  /// @return            Number of tokens read, which is less than @c n if the
+  ///                    stream runs empty or the next token is EoT.
+  size_t try_read_up_to(T* values, size_t n) {
+    const size_t count = n == 0 ? 0 : this->queue_pop_n(values, n);
+    if (count == 0) empty();  // Yields if the stream is empty.
+    return count;
+  }
+
+  /// Reads a transaction, i.e., tokens until EoT, and consumes the EoT token.
+  ///
+  /// This is a @a blocking and @a destructive operation.
+  ///
+  /// The transaction must have at most @c n tokens. Tokens that are available
+  /// are read at once, including EoT, so that a transaction written by
+  /// @c tapa::ostream::write_transaction is usually read without waiting more
+  /// than once.
+  ///
+  /// @param[out] values Array of at least @c n elements to store the tokens.
+  /// @param[in]  n      Maximum number of tokens of the transaction.
+  /// @return            Number of tokens read, excluding EoT.
+  size_t read_transaction(T* values, size_t n) {
+    static_assert(internal::has_eot_v<T>,
+                  "streams of tapa::no_eot elements have no EoT tokens");
+    size_t count = 0;
+    for (bool is_eot = false; !is_eot;) {
+      wait_until_not_empty();
+      count += this->queue_pop_n(values + count, n - count, is_eot);
+      if (!is_eot && count == n && !this->queue_empty() &&
+          !this->queue_front().eot) {
+        LOG(FATAL) << "channel '" << this->get_name()
+                   << "' read a transaction of more than " << n << " tokens";
+      }
+    }
+    return count;
+  }
+
+  /// Reads @c n elements packed in vector tokens, e.g., @c tapa::vec_t, each
+  /// of which holds @c T::length elements.
+  ///
+  /// This is a @a blocking and @a destructive operation.
+  ///
+  /// @c n must be a multiple of @c T::length, and none of the next
+  /// @c n / @c T::length tokens may be EoT.
+  ///
+  /// @param[out] values Array of at least @c n elements to store the elements.
+  /// @param[in]  n      Number of elements to read.
+  template <typename U = T, int kLength = U::length>
+  void read_n(typename U::value_type* values, size_t n) {
+    CHECK_EQ(n % kLength, 0) << "channel '" << this->get_name()
+                             << "' read a partial vector";
+    std::array<T, 16> tokens;  // Bounds the stack usage.
+    for (size_t i = 0; i < n / kLength;) {
+      const size_t count = std::min(tokens.size(), n / kLength - i);
+      read_n(tokens.data(), count);
+      for (size_t j = 0; j < count; ++j, ++i) {
+        for (int k = 0; k < kLength; ++k) {
+          values[i * kLength + k] = tokens[j][k];
+        }
+      }
     }
-    return val;
   }
 
   /// Reads the stream.
@@ -561,8 +1606,10 @@ class istream : virtual public internal::basic_stream<T> {
   ///
   /// @return Whether an EoT token is consumed.
   bool try_open() {
+    static_assert(internal::has_eot_v<T>,
+                  "streams of tapa::no_eot elements have no EoT tokens");
     if (!empty()) {
-      auto elem = this->ptr->pop();
+      auto elem = this->queue_pop();
       if (!elem.eot) {
         LOG(FATAL) << "channel '" << this->get_name()
                    << "' opened when not closed";
@@ -578,20 +1625,38 @@ class istream : virtual public internal::basic_stream<T> {
   ///
   /// The next token must be EoT.
   void open() {
-    while (!try_open()) {
-    }
+    do {
+      wait_until_not_empty();
+    } while (!try_open());
   }
 
  protected:
   // allow derived class to omit initialization
   istream() : internal::basic_stream<T>(nullptr) {}
 
+  // Records a stall on the empty stream, and yields.
+  void stall_on_empty() const {
+    if (auto* stats = this->ptr->get_stats()) stats->count_empty_stall();
+    internal::yield(
+        {internal::yield_reason::kChannelEmpty,
+         static_cast<const internal::type_erased_queue*>(this->ptr.get()),
+         this->get_name()});
+  }
+
+  // Blocks until the stream is not empty.
+  void wait_until_not_empty() const {
+    this->ptr->wait([this] { return !this->queue_empty(); },
+                    internal::yield_reason::kChannelEmpty);
+  }
+
  private:
   // allow istreams and streams to return istream
   template <typename U, uint64_t S>
   friend class istreams;
   template <typename U, uint64_t S, uint64_t N, uint64_t SimulationDepth>
   friend class streams;
+  template <typename U, uint64_t S, uint64_t N, uint64_t SimulationDepth>
+  friend class broadcast_stream;
   istream(const internal::basic_stream<T>& base)
       : internal::basic_stream<T>(base) {}
 };
@@ -610,10 +1675,8 @@ class ostream : virtual public internal::basic_stream<T> {
   ///
   /// @return Whether the stream is full.
   bool full() const {
-    bool is_full = this->ptr->full();
-    if (is_full) {
-      internal::yield("channel '" + this->get_name() + "' is full");
-    }
+    bool is_full = this->queue_full();
+    if (is_full) stall_on_full();
     return is_full;
   }
 
@@ -625,7 +1688,7 @@ class ostream : virtual public internal::basic_stream<T> {
   /// @return          Whether @c value has been written successfully.
   bool try_write(const T& value) {
     if (!full()) {
-      this->ptr->push({value, false});
+      this->queue_push({value, false});
       return true;
     }
     return false;
@@ -637,7 +1700,85 @@ class ostream : virtual public internal::basic_stream<T> {
   ///
   /// @param[in] value The value to write.
   void write(const T& value) {
-    while (!try_write(value)) {
+    do {
+      wait_until_not_full();
+    } while (!try_write(value));
+  }
+
+  /// Writes @c value to the stream, moving instead of copying it.
+  ///
+  /// This is a @a blocking and @a destructive operation.
+  ///
+  /// @param[in] value The value to write.
+  void write(T&& value) {
+    wait_until_not_full();
+    this->queue_push({std::move(value), false});
+  }
+
+  /// Writes @c n tokens to the stream.
+  ///
+  /// This is a @a blocking and @a destructive operation.
+  ///
+  /// @param[in] values Array of at least @c n elements to write.
+  /// @param[in] n      Number of tokens to write.
+  void write_n(const T* values, size_t n) {
+    for (size_t count = 0; count < n;) {
+      wait_until_not_full();
+      count += this->queue_push_n(values + count, n - count);
+    }
+  }
+
+  /// Writes up to @c n tokens as long as there is space in the stream.
+  ///
+  /// This is a @a non-blocking and @a destructive operation.
+  ///
+  /// @param[in] values Array of at least @c n tokens to write.
+  /// @param[in] n      Maximum number of tokens to write.
+  /// @return           Number of tokens written, which is less than @c n if
+  ///                   the stream runs full.
+  size_t try_write_up_to(const T* values, size_t n) {
+    const size_t count = n == 0 ? 0 : this->queue_push_n(values, n);
+    if (count == 0) full();  // Yields if the stream is full.
+    return count;
+  }
+
+  /// Writes a transaction, i.e., @c n tokens followed by an EoT token.
+  ///
+  /// This is a @a blocking and @a destructive operation.
+  ///
+  /// The tokens and EoT are made available to the reader at once if there is
+  /// space for all of them.
+  ///
+  /// @param[in] values Array of at least @c n elements to write.
+  /// @param[in] n      Number of tokens to write before EoT.
+  void write_transaction(const T* values, size_t n) {
+    for (size_t count = 0; count <= n;) {
+      wait_until_not_full();
+      count += this->queue_push_n(values + count, n - count, /*close=*/true);
+    }
+  }
+
+  /// Writes @c n elements packed in vector tokens, e.g., @c tapa::vec_t, each
+  /// of which holds @c T::length elements.
+  ///
+  /// This is a @a blocking and @a destructive operation.
+  ///
+  /// @param[in] values Array of at least @c n elements to write.
+  /// @param[in] n      Number of elements to write, which must be a multiple
+  ///                   of @c T::length.
+  template <typename U = T, int kLength = U::length>
+  void write_n(const typename U::value_type* values, size_t n) {
+    CHECK_EQ(n % kLength, 0) << "channel '" << this->get_name()
+                             << "' wrote a partial vector";
+    std::array<T, 16> tokens;  // Bounds the stack usage.
+    for (size_t i = 0; i < n / kLength;) {
+      const size_t count = std::min(tokens.size(), n / kLength - i);
+      for (size_t j = 0; j < count; ++j, ++i) {
+        for (int k = 0; k < kLength; ++k) {
+          tokens[j][k] = values[i * kLength + k];
+        }
+      }
+      write_n(tokens.data(), count);
     }
   }
 
@@ -658,8 +1799,10 @@ class ostream : virtual public internal::basic_stream<T> {
   ///
   /// @return Whether the EoT token has been written successfully.
   bool try_close() {
+    static_assert(internal::has_eot_v<T>,
+                  "streams of tapa::no_eot elements have no EoT tokens");
     if (!full()) {
-      this->ptr->push({{}, true});
+      this->queue_push({{}, true});
       return true;
     }
     return false;
@@ -669,20 +1812,38 @@ class ostream : virtual public internal::basic_stream<T> {
   ///
   /// This is a @a blocking and @a destructive operation.
   void close() {
-    while (!try_close()) {
-    }
+    do {
+      wait_until_not_full();
+    } while (!try_close());
   }
 
  protected:
   // allow derived class to omit initialization
   ostream() : internal::basic_stream<T>(nullptr) {}
 
+  // Records a stall on the full stream, and yields.
+  void stall_on_full() const {
+    if (auto* stats = this->ptr->get_stats()) stats->count_full_stall();
+    internal::yield(
+        {internal::yield_reason::kChannelFull,
+         static_cast<const internal::type_erased_queue*>(this->ptr.get()),
+         this->get_name()});
+  }
+
+  // Blocks until the stream is not full.
+  void wait_until_not_full() const {
+    this->ptr->wait([this] { return !this->queue_full(); },
+                    internal::yield_reason::kChannelFull);
+  }
+
  private:
   // allow ostreams and streams to return ostream
   template <typename U, uint64_t S>
   friend class ostreams;
   template <typename U, uint64_t S, uint64_t N, uint64_t SimulationDepth>
   friend class streams;
+  template <typename U, uint64_t S, uint64_t N, uint64_t SimulationDepth>
+  friend class broadcast_stream;
   ostream(const internal::basic_stream<T>& base)
       : internal::basic_stream<T>(base) {}
 };
@@ -697,16 +1858,16 @@ class stream : public internal::unbound_stream<T> {
 
   /// Constructs a @c tapa::stream.
   stream()
-      : internal::basic_stream<T>(
-            internal::make_queue<internal::elem_t<T>>(SimulationDepth)) {}
+      : internal::basic_stream<T>(internal::make_queue<internal::elem_t<T>>(
+            SimulationDepth, /*name=*/"", /*synthesis_depth=*/N)) {}
 
   /// Constructs a @c tapa::stream with the given name for debugging.
   ///
   /// @param[in] name Name of the communication channel (for debugging only).
   template <size_t S>
   stream(const char (&name)[S])
-      : internal::basic_stream<T>(
-            internal::make_queue<internal::elem_t<T>>(SimulationDepth, name)) {}
+      : internal::basic_stream<T>(internal::make_queue<internal::elem_t<T>>(
+            SimulationDepth, name, /*synthesis_depth=*/N)) {}
 
  private:
   template <typename Param, typename Arg>
@@ -737,6 +1898,41 @@ class istreams : virtual public internal::basic_streams<T> {
     return internal::basic_streams<T>::operator[](pos);
   }
 
+  /// Reads a token from each @c tapa::stream in the array if none is empty.
+  ///
+  /// This is a @a non-blocking and @a destructive operation. Either all or
+  /// none of the streams are read.
+  ///
+  /// None of the next tokens may be EoT.
+  ///
+  /// @param[out] values Updated with the token of each stream if successful.
+  /// @return            Whether the tokens have been read successfully.
+  bool try_read_vec(vec_t<T, S>& values) {
+    if (const auto* lane = this->find_empty()) {
+      istream<T>(*lane).stall_on_empty();
+      return false;
+    }
+    this->pop_each(values);
+    return true;
+  }
+
+  /// Reads a token from each @c tapa::stream in the array.
+  ///
+  /// This is a @a blocking and @a destructive operation. Once all streams
+  /// have a token, they are read at once.
+  ///
+  /// None of the next tokens may be EoT.
+  ///
+  /// @return The token of each stream.
+  vec_t<T, S> read_vec() {
+    while (const auto* lane = this->find_empty()) {
+      istream<T>(*lane).wait_until_not_empty();
+    }
+    vec_t<T, S> values;
+    this->pop_each(values);
+    return values;
+  }
+
  protected:
   // allow derived class to omit initialization
   istreams() : internal::basic_streams<T>(nullptr) {}
@@ -750,6 +1946,11 @@ class istreams : virtual public internal::basic_streams<T> {
   template <typename U, uint64_t friend_length>
   friend class istreams;
 
+  // allow broadcast streams to return istreams of their consumers
+  template <typename U, uint64_t friend_length, uint64_t friend_depth,
+            uint64_t friend_simulation_depth>
+  friend class broadcast_stream;
+
  private:
   template <typename Param, typename Arg>
   friend struct internal::accessor;
@@ -798,6 +1999,35 @@ class ostreams : virtual public internal::basic_streams<T> {
     return internal::basic_streams<T>::operator[](pos);
   }
 
+  /// Writes a token to each @c tapa::stream in the array if none is full.
+  ///
+  /// This is a @a non-blocking and @a destructive operation. Either all or
+  /// none of the streams are written.
+  ///
+  /// @param[in] values The token of each stream.
+  /// @return           Whether the tokens have been written successfully.
+  bool try_write_vec(const vec_t<T, S>& values) {
+    if (const auto* lane = this->find_full()) {
+      ostream<T>(*lane).stall_on_full();
+      return false;
+    }
+    this->push_each(values);
+    return true;
+  }
+
+  /// Writes a token to each @c tapa::stream in the array.
+  ///
+  /// This is a @a blocking and @a destructive operation. Once no stream is
+  /// full, they are written at once.
+  ///
+  /// @param[in] values The token of each stream.
+  void write_vec(const vec_t<T, S>& values) {
+    while (const auto* lane = this->find_full()) {
+      ostream<T>(*lane).wait_until_not_full();
+    }
+    this->push_each(values);
+  }
+
  protected:
   // allow derived class to omit initialization
   ostreams() : internal::basic_streams<T>(nullptr) {}
@@ -856,10 +2086,7 @@ class streams : public internal::unbound_streams<T, S> {
       : internal::basic_streams<T>(
             std::make_shared<typename internal::basic_streams<T>::metadata_t>(
                 "", 0)) {
-    for (int i = 0; i < S; ++i) {
-      this->ptr->refs.emplace_back(
-          internal::make_queue<internal::elem_t<T>>(SimulationDepth));
-    }
+    this->add_queues();
   }
 
   /// Constructs a @c tapa::streams array with the given base name for
@@ -873,10 +2100,7 @@ class streams : public internal::unbound_streams<T, S> {
       : internal::basic_streams<T>(
             std::make_shared<typename internal::basic_streams<T>::metadata_t>(
                 name, 0)) {
-    for (int i = 0; i < S; ++i) {
-      this->ptr->refs.emplace_back(internal::make_queue<internal::elem_t<T>>(
-          SimulationDepth, this->ptr->name + "[" + std::to_string(i) + "]"));
-    }
+    this->add_queues();
   }
 
   /// References a @c tapa::stream in the array.
@@ -894,6 +2118,14 @@ class streams : public internal::unbound_streams<T, S> {
   int istream_access_pos_ = 0;
   int ostream_access_pos_ = 0;
 
+  void add_queues() {
+    this->ptr->refs.reserve(S);
+    for (auto& queue : internal::make_queues<internal::elem_t<T>>(
+             S, SimulationDepth, this->ptr->name, N)) {
+      this->ptr->refs.emplace_back(std::move(queue));
+    }
+  }
+
   istream<T> access_as_istream() {
     CHECK_LT(istream_access_pos_, this->ptr->refs.size())
         << "channels '" << this->ptr->name << "' accessed as istream for "
@@ -936,17 +2168,113 @@ class streams : public internal::unbound_streams<T, S> {
   }
 };
 
+/// Defines a @c tapa::stream whose tokens are received by each of its @c S
+/// consumers, e.g., to send the same data to several workers without a
+/// dedicated task that duplicates it.
+///
+/// The stream is written through a @c tapa::ostream by one producer, and read
+/// through a @c tapa::istream by each consumer, in the order that they are
+/// invoked, or through a @c tapa::istreams by several consumers at once:
+///
+/// @code{.cpp}
+///  tapa::broadcast_stream<float, kWorkerCount> weights("weights");
+///  tapa::task()
+///      .invoke(Load, weights)
+///      .invoke<tapa::join, kWorkerCount>(Worker, weights);
+/// @endcode
+///
+/// In hardware, the consumers share one FIFO of depth @c N with a read pointer
+/// each, which is written once the space is freed by every consumer.
+template <typename T, uint64_t S, uint64_t N = kStreamDefaultDepth,
+          uint64_t SimulationDepth = N>
+class broadcast_stream : public internal::basic_streams<T> {
+ public:
+  /// Count of consumers of the stream.
+  constexpr static int length = S;
+
+  /// Depth of the communication channel.
+  constexpr static int depth = N;
+
+  /// Constructs a @c tapa::broadcast_stream.
+  broadcast_stream() : broadcast_stream("") {}
+
+  /// Constructs a @c tapa::broadcast_stream with the given name for debugging.
+  ///
+  /// The consumers read from <tt>name[i]</tt>.
+  ///
+  /// @param[in] name Name of the communication channel (for debugging only).
+  template <size_t name_length>
+  broadcast_stream(const char (&name)[name_length])
+      : broadcast_stream(name, internal::make_queues<internal::elem_t<T>>(
+                                   S, SimulationDepth, name, N)) {}
+
+ private:
+  template <typename Param, typename Arg>
+  friend struct internal::accessor;
+
+  using queues_t =
+      std::vector<std::shared_ptr<internal::base_queue<internal::elem_t<T>>>>;
+
+  broadcast_stream(const std::string& name, const queues_t& lanes)
+      : internal::basic_streams<T>(
+            std::make_shared<typename internal::basic_streams<T>::metadata_t>(
+                name, 0)),
+        producer(
+            std::make_shared<internal::broadcast_queue<internal::elem_t<T>>>(
+                name, lanes)) {
+    this->ptr->refs.reserve(S);
+    for (const auto& lane : lanes) this->ptr->refs.emplace_back(lane);
+  }
+
+  const internal::basic_stream<T> producer;
+  int istream_access_pos_ = 0;
+  bool is_produced_ = false;
+
+  istream<T> access_as_istream() {
+    CHECK_LT(istream_access_pos_, this->ptr->refs.size())
+        << "broadcast stream '" << this->ptr->name << "' consumed "
+        << istream_access_pos_ + 1 << " times but it only has "
+        << this->ptr->refs.size() << " consumers";
+    return this->ptr->refs[istream_access_pos_++];
+  }
+  ostream<T> access_as_ostream() {
+    CHECK(!is_produced_) << "broadcast stream '" << this->ptr->name
+                         << "' produced more than once";
+    is_produced_ = true;
+    return this->producer;
+  }
+  template <uint64_t length>
+  istreams<T, length> access_as_istreams() {
+    istreams<T, length> result;
+    result.ptr =
+        std::make_shared<typename internal::basic_streams<T>::metadata_t>(
+            this->ptr->name, istream_access_pos_);
+    result.ptr->refs.reserve(length);
+    for (int i = 0; i < length; ++i) {
+      result.ptr->refs.emplace_back(access_as_istream());
+    }
+    return result;
+  }
+};
+
 namespace internal {
 
 template <typename T, uint64_t N, typename U>
 struct accessor<istream<T>&, stream<U, N>&> {
   static istream<T> access(stream<U, N>& arg) { return arg; }
   static void access(fpga::Instance& instance, int& idx, stream<U, N>& arg) {
+    // Connect the kernels directly if another kernel writes to `arg`.
+    using Peer = fpga::WriteStream<elem_t<T>>;
+    if (auto queue = std::dynamic_pointer_cast<frt_queue<elem_t<T>>>(arg.ptr);
+        queue != nullptr && queue->template IsPeer<Peer>()) {
+      instance.SetArg(idx++, queue->template GetPeerStream<Peer>());
+      return;
+    }
     auto ptr = std::make_shared<frt_queue<elem_t<T>>>(
         std::in_place_type_t<fpga::WriteStream<elem_t<T>>>(), arg.get_name(),
         arg.depth);
     instance.SetArg(idx++, ptr->GetWriteStream());
-    arg.ptr = std::move(ptr);
+    arg.reset(std::move(ptr));
   }
 };
 
@@ -954,11 +2282,18 @@ template <typename T, uint64_t N, typename U>
 struct accessor<ostream<T>&, stream<U, N>&> {
   static ostream<T> access(stream<U, N>& arg) { return arg; }
   static void access(fpga::Instance& instance, int& idx, stream<U, N>& arg) {
+    // Connect the kernels directly if another kernel reads from `arg`.
+    using Peer = fpga::ReadStream<elem_t<T>>;
+    if (auto queue = std::dynamic_pointer_cast<frt_queue<elem_t<T>>>(arg.ptr);
+        queue != nullptr && queue->template IsPeer<Peer>()) {
+      instance.SetArg(idx++, queue->template GetPeerStream<Peer>());
+      return;
+    }
     auto ptr = std::make_shared<frt_queue<elem_t<T>>>(
         std::in_place_type_t<fpga::ReadStream<elem_t<T>>>(), arg.get_name(),
         arg.depth);
     instance.SetArg(idx++, ptr->GetReadStream());
-    arg.ptr = std::move(ptr);
+    arg.reset(std::move(ptr));
   }
 };
 
@@ -1009,6 +2344,95 @@ TAPA_DEFINE_ACCESSER(o, &&)
 
 #undef TAPA_DEFINE_ACCESSER
 
+#define TAPA_DEFINE_BROADCAST_ACCESSER(reference)                            \
+  /* param = istream, arg = broadcast_stream */                               \
+  template <typename T, uint64_t length, uint64_t depth>                      \
+  struct accessor<istream<T> reference, broadcast_stream<T, length, depth>&> { \
+    static istream<T> access(broadcast_stream<T, length, depth>& arg) {       \
+      return arg.access_as_istream();                                         \
+    }                                                                         \
+  };                                                                          \
+                                                                              \
+  /* param = ostream, arg = broadcast_stream */                               \
+  template <typename T, uint64_t length, uint64_t depth>                      \
+  struct accessor<ostream<T> reference, broadcast_stream<T, length, depth>&> { \
+    static ostream<T> access(broadcast_stream<T, length, depth>& arg) {       \
+      return arg.access_as_ostream();                                         \
+    }                                                                         \
+  };                                                                          \
+                                                                              \
+  /* param = istreams, arg = broadcast_stream */                              \
+  template <typename T, uint64_t param_length, uint64_t arg_length,           \
+            uint64_t depth>                                                   \
+  struct accessor<istreams<T, param_length> reference,                        \
+                  broadcast_stream<T, arg_length, depth>&> {                  \
+    static istreams<T, param_length> access(                                  \
+        broadcast_stream<T, arg_length, depth>& arg) {                        \
+      return arg.template access_as_istreams<param_length>();                 \
+    }                                                                         \
+  };
+
+TAPA_DEFINE_BROADCAST_ACCESSER()
+TAPA_DEFINE_BROADCAST_ACCESSER(&)
+TAPA_DEFINE_BROADCAST_ACCESSER(&&)
+
+#undef TAPA_DEFINE_BROADCAST_ACCESSER
+
+template <typename T>
+struct channel_traits<basic_stream<T>> {
+  static void collect(const basic_stream<T>& arg,
+                      std::vector<const void*>& channels) {
+    // Same as the channel of `yield_reason`.
+    const type_erased_queue* channel = arg.ptr.get();
+    if (channel != nullptr) channels.push_back(channel);
+  }
+};
+
+template <typename T>
+struct channel_traits<basic_streams<T>> {
+  static void collect(const basic_streams<T>& arg,
+                      std::vector<const void*>& channels) {
+    if (arg.ptr == nullptr) return;
+    for (const auto& ref : arg.ptr->refs) {
+      channel_traits<basic_stream<T>>::collect(ref, channels);
+    }
+  }
+};
+
+template <typename T>
+struct channel_traits<istream<T>> : channel_traits<basic_stream<T>> {};
+template <typename T>
+struct channel_traits<ostream<T>> : channel_traits<basic_stream<T>> {};
+template <typename T, uint64_t S>
+struct channel_traits<istreams<T, S>> : channel_traits<basic_streams<T>> {};
+template <typename T, uint64_t S>
+struct channel_traits<ostreams<T, S>> : channel_traits<basic_streams<T>> {};
+
+// Records each queue that `channel_traits` collects as a `kind` port.
+template <typename Stream, task_graph::port::kind_t kind>
+struct stream_graph_traits {
+  static void record(const Stream& arg, graph_ports& ports) {
+    std::vector<const void*> channels;
+    channel_traits<Stream>::collect(arg, channels);
+    for (const void* channel : channels) {
+      ports.add_stream(static_cast<const type_erased_queue*>(channel), kind);
+    }
+  }
+};
+
+template <typename T>
+struct graph_traits<istream<T>>
+    : stream_graph_traits<istream<T>, task_graph::port::kIstream> {};
+template <typename T>
+struct graph_traits<ostream<T>>
+    : stream_graph_traits<ostream<T>, task_graph::port::kOstream> {};
+template <typename T, uint64_t S>
+struct graph_traits<istreams<T, S>>
+    : stream_graph_traits<istreams<T, S>, task_graph::port::kIstream> {};
+template <typename T, uint64_t S>
+struct graph_traits<ostreams<T, S>>
+    : stream_graph_traits<ostreams<T, S>, task_graph::port::kOstream> {};
+
 }  // namespace internal
 
 }  // namespace tapa
@@ -0,0 +1,173 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/stream.h"
+
+#include <array>
+#include <cstdint>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <benchmark/benchmark.h>
+
+#include "tapa/host/task.h"
+
+namespace tapa {
+namespace {
+
+using ::tapa::internal::elem_t;
+using ::tapa::internal::lock_free_queue;
+using ::tapa::internal::locked_queue;
+
+// Tokens of `kBytes` bytes.
+template <int kBytes>
+using Token = elem_t<std::array<char, kBytes>>;
+
+// Where the producer and consumer threads run.
+enum Placement : int64_t {
+  kUnpinned = 0,
+  kSameCore = 1,
+  kDifferentCores = 2,
+};
+
+// Pins the calling thread to `cpu`.
+bool PinToCpu(int cpu) {
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+}
+
+// Pins the producer (`is_producer`) or consumer thread as `placement` says.
+bool Place(int64_t placement, bool is_producer) {
+  switch (placement) {
+    case kSameCore:
+      return PinToCpu(0);
+    case kDifferentCores:
+      return PinToCpu(is_producer ? 0 : 1);
+    default:
+      return true;
+  }
+}
+
+// Pushes and then pops `depth` tokens in a single thread, which measures the
+// cost of the operations without contention.
+template <typename Queue>
+void BM_QueuePushPop(benchmark::State& state) {
+  const int64_t depth = state.range(0);
+  Queue queue(depth, "queue");
+  typename Queue::value_type val{};
+  for (auto _ : state) {
+    for (int64_t i = 0; i < depth; ++i) queue.push({val, false});
+    for (int64_t i = 0; i < depth; ++i) benchmark::DoNotOptimize(queue.pop());
+  }
+  state.SetItemsProcessed(state.iterations() * depth);
+  state.SetBytesProcessed(state.iterations() * depth * sizeof(val));
+}
+
+// Streams tokens from a producer thread to the benchmark thread, which spin
+// and yield the CPU while the queue is full or empty.
+template <typename Queue>
+void BM_QueueCrossThread(benchmark::State& state) {
+  const int64_t depth = state.range(0);
+  const int64_t placement = state.range(1);
+  if (placement == kDifferentCores && std::thread::hardware_concurrency() < 2) {
+    state.SkipWithError("needs at least 2 CPUs");
+    return;
+  }
+  Queue queue(depth, "queue");
+  typename Queue::value_type val{};
+  const int64_t n = state.max_iterations;
+  std::thread producer([&] {
+    Place(placement, /*is_producer=*/true);
+    for (int64_t i = 0; i < n; ++i) {
+      while (queue.full()) std::this_thread::yield();
+      queue.push({val, false});
+    }
+  });
+  if (!Place(placement, /*is_producer=*/false)) {
+    state.SkipWithError("cannot set CPU affinity");
+  }
+  for (auto _ : state) {
+    while (queue.empty()) std::this_thread::yield();
+    benchmark::DoNotOptimize(queue.pop());
+  }
+  producer.join();
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * sizeof(val));
+}
+
+void QueueArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"depth", "placement"});
+  for (int64_t depth : {2, 64, 1024}) {
+    for (int64_t placement : {kUnpinned, kSameCore, kDifferentCores}) {
+      b->Args({depth, placement});
+    }
+  }
+  b->UseRealTime();
+}
+
+#define TAPA_QUEUE_BENCHMARK(queue, bytes)                            \
+  BENCHMARK_TEMPLATE(BM_QueuePushPop, queue<Token<bytes>>)            \
+      ->ArgName("depth")                                              \
+      ->RangeMultiplier(8)                                            \
+      ->Range(2, 1024);                                               \
+  BENCHMARK_TEMPLATE(BM_QueueCrossThread, queue<Token<bytes>>)->Apply( \
+      QueueArgs)
+
+TAPA_QUEUE_BENCHMARK(lock_free_queue, 4);
+TAPA_QUEUE_BENCHMARK(lock_free_queue, 64);
+TAPA_QUEUE_BENCHMARK(lock_free_queue, 512);
+TAPA_QUEUE_BENCHMARK(locked_queue, 4);
+TAPA_QUEUE_BENCHMARK(locked_queue, 64);
+TAPA_QUEUE_BENCHMARK(locked_queue, 512);
+
+#undef TAPA_QUEUE_BENCHMARK
+
+// Writes and then peeks and reads a stream full of tokens in a single thread,
+// as tasks that decide whether to read a token by its value do.
+void BM_StreamPeekThenRead(benchmark::State& state) {
+  constexpr int kDepth = 1024;
+  stream<int, kDepth> data_q("data");
+  for (auto _ : state) {
+    for (int i = 0; i < kDepth; ++i) data_q.write(i);
+    for (int val; data_q.try_peek(val);) {
+      benchmark::DoNotOptimize(val);
+      data_q.try_read(val);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kDepth);
+}
+BENCHMARK(BM_StreamPeekThenRead);
+
+void Ping(ostream<int>& ping_q, istream<int>& pong_q, int n) {
+  for (int i = 0; i < n; ++i) {
+    ping_q.write(i);
+    pong_q.read();
+  }
+}
+
+void Pong(istream<int>& ping_q, ostream<int>& pong_q, int n) {
+  for (int i = 0; i < n; ++i) pong_q.write(ping_q.read());
+}
+
+// Bounces a token between two tasks through streams of depth 1, so that each
+// task blocks, and thus yields, once per token. With the default engine, the
+// cost is that of switching coroutines; set `TAPA_CONCURRENCY`,
+// `TAPA_ENGINE`, and `TAPA_PIN_WORKERS` to compare engines and placements.
+void BM_TaskPingPong(benchmark::State& state) {
+  const int n = state.range(0);
+  for (auto _ : state) {
+    stream<int, 1> ping_q("ping");
+    stream<int, 1> pong_q("pong");
+    task().invoke(Ping, ping_q, pong_q, n).invoke(Pong, ping_q, pong_q, n);
+  }
+  state.SetItemsProcessed(state.iterations() * n * 2);
+}
+BENCHMARK(BM_TaskPingPong)->ArgName("n")->Arg(1 << 16)->UseRealTime();
+
+}  // namespace
+}  // namespace tapa
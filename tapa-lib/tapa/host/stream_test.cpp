@@ -4,14 +4,18 @@
 
 #include "tapa/host/stream.h"
 
+#include <cstdint>
 #include <cstring>
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include <tapa/host/internal_util.h>
+#include <tapa/host/vec.h>
 
 #ifdef __cpp_lib_filesystem
 #include <filesystem>
@@ -103,6 +107,27 @@ TEST_F(StreamLogTest, LoggingEotSucceeds) {
   EXPECT_EQ(GetLogContent(data_q.get_name()), "233\n\n2333\n");
 }
 
+TEST_F(StreamLogTest, LoggingInBinaryFormatSucceeds) {
+  ASSERT_EQ(setenv("TAPA_STREAM_LOG_FORMAT", "binary", /*replace=*/1), 0)
+      << std::strerror(errno);
+  {
+    tapa::stream<int16_t> data_q("data");
+    data_q.write(0x2333);
+    data_q.read();
+    data_q.close();
+    data_q.open();
+  }
+  EXPECT_EQ(unsetenv("TAPA_STREAM_LOG_FORMAT"), 0) << std::strerror(errno);
+
+  std::ifstream ifs(temp_dir_ / "data.bin", std::ios::binary);
+  const std::string content((std::istreambuf_iterator<char>(ifs)),
+                            std::istreambuf_iterator<char>());
+  EXPECT_EQ(content, std::string("TAPASLOG\1\0\0\0\2\0\0\0"  // Header.
+                                 "\0\x33\x23"                  // 0x2333.
+                                 "\1\0\0",                    // EoT.
+                                 22));
+}
+
 TEST_F(StreamLogTest, LoggingToNonexistentDirFails) {
   ASSERT_EQ(setenv(kEnvVarName, "/nonexistent", /*replace=*/1), 0)
       << std::strerror(errno);
@@ -114,14 +139,215 @@ TEST_F(StreamLogTest, LoggingToNonexistentDirFails) {
   EXPECT_EQ(GetLogContent(data_q.get_name()), "");
 }
 
+// Interleaved reads and writes cross and reuse segments of the unbounded queue.
+TEST(StreamTest, InfiniteDepthStreamPreservesOrder) {
+  constexpr int kBatchSize = 1000;
+  tapa::stream<int, kStreamInfiniteDepth> data_q;
+  int next_write = 0;
+  int next_read = 0;
+  for (int batch = 0; batch < 10; ++batch) {
+    for (int i = 0; i < kBatchSize * 3 / 2; ++i) data_q.write(next_write++);
+    for (int i = 0; i < kBatchSize; ++i) ASSERT_EQ(data_q.read(), next_read++);
+  }
+  data_q.close();
+  while (next_read < next_write) ASSERT_EQ(data_q.read(), next_read++);
+  EXPECT_TRUE(data_q.eot(nullptr));
+  data_q.open();
+}
+
+TEST(StreamTest, WritingRvalueMovesValue) {
+  tapa::stream<std::vector<int>, 2> data_q;
+  std::vector<int> value(1000, 42);
+  const int* data = value.data();
+  data_q.write(std::move(value));
+  EXPECT_TRUE(value.empty());  // NOLINT(bugprone-use-after-move)
+
+  const std::vector<int>& peeked = data_q.peek_ref();
+  EXPECT_EQ(peeked.data(), data);
+  EXPECT_EQ(&data_q.peek_ref(), &peeked);
+
+  const std::vector<int> read = data_q.read();
+  EXPECT_EQ(read.data(), data);
+}
+
+TEST(StreamTest, PackedBulkOperationsPreserveOrder) {
+  constexpr int kLength = 4;
+  constexpr int kCount = kLength * 100;  // More tokens than a single chunk.
+  tapa::stream<vec_t<int, kLength>, kStreamInfiniteDepth> data_q;
+  std::vector<int> values(kCount);
+  for (int i = 0; i < kCount; ++i) values[i] = i;
+  data_q.write_n(values.data(), kCount);
+
+  const vec_t<int, kLength> first = data_q.peek(nullptr);
+  for (int i = 0; i < kLength; ++i) EXPECT_EQ(first[i], i);
+
+  std::vector<int> read(kCount);
+  data_q.read_n(read.data(), kCount);
+  EXPECT_EQ(read, values);
+}
+
+template <typename Stream>
+void TestTransactions(Stream& data_q) {
+  const std::vector<int> values = {1, 2, 3, 4, 5};
+  data_q.write_transaction(values.data(), values.size());
+  data_q.write_transaction(nullptr, 0);
+  data_q.write(6);
+  data_q.close();
+
+  std::vector<int> read(values.size());
+  EXPECT_EQ(data_q.read_transaction(read.data(), read.size()), values.size());
+  EXPECT_EQ(read, values);
+  EXPECT_EQ(data_q.read_transaction(read.data(), read.size()), 0);
+  EXPECT_EQ(data_q.read_transaction(read.data(), read.size()), 1);
+  EXPECT_EQ(read[0], 6);
+  EXPECT_TRUE(data_q.empty());
+}
+
+TEST(StreamTest, TransactionsAreDelimitedByEot) {
+  tapa::stream<int, 9> data_q;  // Fits all tokens, including 3 EoT tokens.
+  TestTransactions(data_q);
+}
+
+TEST(StreamTest, TransactionsOfInfiniteDepthStreamAreDelimitedByEot) {
+  tapa::stream<int, kStreamInfiniteDepth> data_q;
+  TestTransactions(data_q);
+}
+
+TEST(StreamTest, TransactionFillingStreamIsReadWhole) {
+  tapa::stream<int, 4> data_q;
+  const std::vector<int> values = {1, 2, 3};
+  data_q.write_transaction(values.data(), values.size());
+  std::vector<int> read(values.size());
+  EXPECT_EQ(data_q.read_transaction(read.data(), read.size()), values.size());
+  EXPECT_EQ(read, values);
+  EXPECT_TRUE(data_q.empty());
+}
+
+// Tokens of streams that are never closed carry no EoT flag.
+static_assert(sizeof(internal::elem_t<no_eot<int>>) == sizeof(int));
+
+TEST(StreamTest, NoEotStreamPreservesOrder) {
+  tapa::stream<no_eot<int>, 4> data_q;
+  tapa::stream<no_eot<int>, kStreamInfiniteDepth> unbounded_q;
+  for (int i = 0; i < 4; ++i) ASSERT_TRUE(data_q.try_write(i));
+  for (int i = 0; i < 1000; ++i) unbounded_q.write(i);
+
+  EXPECT_FALSE(data_q.eot(nullptr));
+  EXPECT_EQ(data_q.peek(nullptr), 0);
+  std::vector<no_eot<int>> read(4);
+  data_q.read_n(read.data(), 2);
+  EXPECT_EQ(read[1], 1);
+  int value = data_q.read();
+  EXPECT_EQ(value, 2);
+  EXPECT_TRUE(data_q.try_read(read[0]));
+  EXPECT_EQ(read[0], 3);
+  EXPECT_TRUE(data_q.empty());
+  for (int i = 0; i < 1000; ++i) ASSERT_EQ(unbounded_q.read(), i);
+}
+
+// Streams hold as many more tokens as the scale in simulation, but keep the
+// synthesis depth.
+TEST(StreamTest, ScaledStreamHoldsMoreTokens) {
+  ASSERT_EQ(setenv("TAPA_STREAM_DEPTH_SCALE", "4", /*replace=*/1), 0);
+  tapa::stream<int, 2> data_q;
+  tapa::streams<int, 2, 2> data_qs;
+  EXPECT_EQ(unsetenv("TAPA_STREAM_DEPTH_SCALE"), 0);
+  EXPECT_EQ(data_q.depth, 2);
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_TRUE(data_q.try_write(i));
+    ASSERT_TRUE(data_qs[1].try_write(i));
+  }
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_EQ(data_q.read(), i);
+    ASSERT_EQ(data_qs[1].read(), i);
+  }
+}
+
+// Vector operations access either all or none of the streams.
+TEST(StreamTest, VectorOperationsAccessAllStreams) {
+  tapa::streams<int, 3, 3> data_qs;
+  vec_t<int, 3> values;
+  for (int i = 0; i < 3; ++i) values.set(i, i);
+  EXPECT_TRUE(data_qs.try_write_vec(values));
+  data_qs.write_vec(values + 3);
+  ASSERT_TRUE(data_qs[1].try_write(6));
+
+  values = 0;
+  EXPECT_TRUE(data_qs.try_read_vec(values));
+  for (int i = 0; i < 3; ++i) EXPECT_EQ(values[i], i);
+  values = data_qs.read_vec();
+  for (int i = 0; i < 3; ++i) EXPECT_EQ(values[i], i + 3);
+  EXPECT_FALSE(data_qs.try_read_vec(values));
+  EXPECT_EQ(data_qs[1].read(), 6);
+}
+
+#ifndef TAPA_USE_LOCKED_QUEUE
+TEST(StreamTest, StreamsArrayAllocatesQueuesContiguously) {
+  using elem_t = internal::elem_t<int>;
+  constexpr int kLength = 4;
+  const auto queues = internal::make_queues<elem_t>(kLength, 3, "data");
+  ASSERT_EQ(queues.size(), kLength);
+  for (int i = 0; i < kLength; ++i) {
+    const auto addr = reinterpret_cast<uintptr_t>(queues[i].get());
+    EXPECT_EQ(addr % internal::kCacheLineSize, 0);
+    if (i > 0) {
+      EXPECT_EQ(addr - reinterpret_cast<uintptr_t>(queues[i - 1].get()),
+                sizeof(internal::lock_free_queue<elem_t>));
+    }
+    EXPECT_EQ(queues[i]->get_name(), StrCat({"data[", std::to_string(i), "]"}));
+    for (int j = 0; j < 3; ++j) {
+      ASSERT_FALSE(queues[i]->full());
+      queues[i]->push({i * 3 + j, false});
+    }
+    EXPECT_TRUE(queues[i]->full());
+  }
+  for (int i = 0; i < kLength; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      ASSERT_FALSE(queues[i]->empty());
+      EXPECT_EQ(queues[i]->pop().val, i * 3 + j);
+    }
+    EXPECT_TRUE(queues[i]->empty());
+  }
+}
+
+// Counts the live instances of itself.
+struct LiveCounted {
+  static inline int live = 0;
+  LiveCounted() { ++live; }
+  LiveCounted(const LiveCounted&) { ++live; }
+  ~LiveCounted() { --live; }
+  friend std::ostream& operator<<(std::ostream& os, const LiveCounted&) {
+    return os;
+  }
+};
+
+TEST(StreamTest, StreamsArrayConstructsTokensOnlyWhenPushed) {
+  using elem_t = internal::elem_t<LiveCounted>;
+  {
+    const auto queues = internal::make_queues<elem_t>(2, 1024, "data");
+    EXPECT_EQ(LiveCounted::live, 0);
+    queues[0]->push({{}, false});
+    queues[0]->push({{}, false});
+    queues[1]->push({{}, true});
+    EXPECT_EQ(LiveCounted::live, 3);
+    queues[0]->pop();
+    EXPECT_EQ(LiveCounted::live, 2);
+  }
+  // Tokens left in the queues are destroyed with them.
+  EXPECT_EQ(LiveCounted::live, 0);
+}
+#endif  // TAPA_USE_LOCKED_QUEUE
+
 TEST(StringifyTest, TapaInternalElemToBinaryString) {
-  static_assert(fpga::HasToBinaryString<internal::elem_t<float>>::value);
+  static_assert(
+      fpga::HasPackedBinaryStringImpl<internal::elem_t<float>>::value);
   const internal::elem_t<float> val = {.val = 1.f, .eot = true};
   EXPECT_EQ(fpga::ToBinaryString(val), "100111111100000000000000000000000");
 }
 
 TEST(StringifyTest, TapaInternalElemFromBinaryString) {
-  static_assert(fpga::HasFromBinaryString<internal::elem_t<float>>::value);
+  static_assert(
+      fpga::HasPackedBinaryStringImpl<internal::elem_t<float>>::value);
   const internal::elem_t<float> val =
       fpga::FromBinaryString<internal::elem_t<float>>(
           "100111111100000000000000000000000");
@@ -129,5 +355,18 @@ TEST(StringifyTest, TapaInternalElemFromBinaryString) {
   EXPECT_EQ(val.val, 1.f);
 }
 
+TEST(StringifyTest, TapaInternalElemWriteAndReadBinaryString) {
+  static_assert(fpga::BinaryStringWidth<internal::elem_t<float>>() == 33);
+  char str[33];
+  fpga::WriteBinaryString(internal::elem_t<float>{.val = 1.f, .eot = false},
+                          str);
+  EXPECT_EQ(std::string(str, sizeof(str)), "000111111100000000000000000000000");
+
+  internal::elem_t<float> val = {.val = 0.f, .eot = true};
+  fpga::ReadBinaryString(str, val);
+  EXPECT_FALSE(val.eot);
+  EXPECT_EQ(val.val, 1.f);
+}
+
 }  // namespace
 }  // namespace tapa
@@ -0,0 +1,206 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/stream_util.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tapa.h"
+
+namespace tapa {
+namespace {
+
+constexpr int kN = 1000;
+
+int GetKey(int elem) { return elem % 3; }
+
+void Merge(tapa::istreams<int, 4>& in, tapa::ostream<int>& out) {
+  tapa::merge(in, out);
+}
+
+void Demux(tapa::istream<int>& in, tapa::ostreams<int, 3>& out) {
+  tapa::demux(in, out, GetKey);
+}
+
+void Crossbar(tapa::istreams<int, 4>& in, tapa::ostreams<int, 3>& out) {
+  tapa::crossbar(in, out, GetKey);
+}
+
+void Distribute(tapa::istream<int>& in, tapa::ostreams<int, 4>& out) {
+  tapa::distribute(in, out);
+}
+
+void Balance(tapa::istream<int>& in, tapa::ostreams<int, 4>& out) {
+  tapa::balance(in, out);
+}
+
+void Collect(tapa::istreams<int, 4>& in, tapa::ostream<int>& out) {
+  tapa::collect(in, out);
+}
+
+// Forwards each element of `in` to `out`.
+void Forward(tapa::istream<int>& in, tapa::ostream<int>& out) {
+  TAPA_WHILE_NOT_EOT(in) { out.write(in.read(nullptr)); }
+  in.open();
+  out.close();
+}
+
+// Writes `i * n + offset` for each `i` in `[0, kN)`.
+void Source(int offset, int n, tapa::ostream<int>& out) {
+  for (int i = 0; i < kN; ++i) out.write(i * n + offset);
+  out.close();
+}
+
+void Sources(tapa::ostreams<int, 4>& out) {
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < kN; ++j) out[i].write(j * 4 + i);
+    out[i].close();
+  }
+}
+
+void Sink(tapa::istream<int>& in, std::vector<int>* values) {
+  TAPA_WHILE_NOT_EOT(in) { values->push_back(in.read(nullptr)); }
+  in.open();
+}
+
+void Sinks(tapa::istreams<int, 3>& in, std::vector<std::vector<int>>* values) {
+  values->resize(3);
+  for (int i = 0; i < 3; ++i) {
+    tapa::istream<int> in_i = in[i];
+    TAPA_WHILE_NOT_EOT(in_i) { (*values)[i].push_back(in_i.read(nullptr)); }
+    in_i.open();
+  }
+}
+
+void Sinks4(tapa::istreams<int, 4>& in,
+            std::vector<std::vector<int>>* values) {
+  values->resize(4);
+  for (int i = 0; i < 4; ++i) {
+    tapa::istream<int> in_i = in[i];
+    Sink(in_i, &(*values)[i]);
+  }
+}
+
+// Expects `values` to hold each value in `[0, n)` once, and the values from
+// each source, i.e., those of the same remainder modulo 4, in order.
+void ExpectAllInSourceOrder(const std::vector<int>& values, int n) {
+  ASSERT_EQ(values.size(), n);
+  int last[4] = {-1, -1, -1, -1};
+  for (int value : values) {
+    EXPECT_GT(value, last[value % 4]);
+    last[value % 4] = value;
+  }
+  std::vector<int> sorted = values;
+  std::sort(sorted.begin(), sorted.end());
+  for (int i = 0; i < n; ++i) EXPECT_EQ(sorted[i], i);
+}
+
+TEST(StreamUtilTest, MergeForwardsAllInputs) {
+  std::vector<int> values;
+  tapa::streams<int, 4, 2> in_q("in");
+  tapa::stream<int, 2> out_q("out");
+  tapa::task()
+      .invoke(Sources, in_q)
+      .invoke(Merge, in_q, out_q)
+      .invoke(Sink, out_q, &values);
+  ExpectAllInSourceOrder(values, kN * 4);
+}
+
+TEST(StreamUtilTest, DemuxForwardsByKey) {
+  std::vector<std::vector<int>> values;
+  tapa::stream<int, 2> in_q("in");
+  tapa::streams<int, 3, kN> out_q("out");
+  tapa::task()
+      .invoke(Source, 0, 1, in_q)
+      .invoke(Demux, in_q, out_q)
+      .invoke(Sinks, out_q, &values);
+  ASSERT_EQ(values.size(), 3);
+  for (int key = 0; key < 3; ++key) {
+    std::vector<int> expected;
+    for (int i = key; i < kN; i += 3) expected.push_back(i);
+    EXPECT_EQ(values[key], expected) << key;
+  }
+}
+
+TEST(StreamUtilTest, CrossbarForwardsByKey) {
+  std::vector<std::vector<int>> values;
+  tapa::streams<int, 4, 2> in_q("in");
+  tapa::streams<int, 3, kN * 4> out_q("out");
+  tapa::task()
+      .invoke(Sources, in_q)
+      .invoke(Crossbar, in_q, out_q)
+      .invoke(Sinks, out_q, &values);
+  ASSERT_EQ(values.size(), 3);
+  std::vector<int> all;
+  for (int key = 0; key < 3; ++key) {
+    for (int value : values[key]) EXPECT_EQ(GetKey(value), key);
+    all.insert(all.end(), values[key].begin(), values[key].end());
+    // Values of the same key and source stay in order.
+    for (int src = 0; src < 4; ++src) {
+      int last = -1;
+      for (int value : values[key]) {
+        if (value % 4 != src) continue;
+        EXPECT_GT(value, last);
+        last = value;
+      }
+    }
+  }
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(all.size(), kN * 4);
+  for (int i = 0; i < kN * 4; ++i) EXPECT_EQ(all[i], i);
+}
+
+TEST(StreamUtilTest, DistributeAndCollectKeepOrder) {
+  std::vector<int> values;
+  tapa::stream<int, 2> in_q("in");
+  tapa::streams<int, 4, 2> mid_in_q("mid_in");
+  tapa::streams<int, 4, 2> mid_out_q("mid_out");
+  tapa::stream<int, 2> out_q("out");
+  tapa::task()
+      .invoke(Source, 0, 1, in_q)
+      .invoke(Distribute, in_q, mid_in_q)
+      .invoke<tapa::join, 4>(Forward, mid_in_q, mid_out_q)
+      .invoke(Collect, mid_out_q, out_q)
+      .invoke(Sink, out_q, &values);
+  ASSERT_EQ(values.size(), kN);
+  for (int i = 0; i < kN; ++i) EXPECT_EQ(values[i], i);
+}
+
+TEST(StreamUtilTest, DistributeSendsElementsInTurn) {
+  std::vector<std::vector<int>> values;
+  tapa::stream<int, 2> in_q("in");
+  tapa::streams<int, 4, kN> out_q("out");
+  tapa::task()
+      .invoke(Source, 0, 1, in_q)
+      .invoke(Distribute, in_q, out_q)
+      .invoke(Sinks4, out_q, &values);
+  for (int i = 0; i < 4; ++i) {
+    std::vector<int> expected;
+    for (int j = i; j < kN; j += 4) expected.push_back(j);
+    EXPECT_EQ(values[i], expected) << i;
+  }
+}
+
+TEST(StreamUtilTest, BalanceAndMergeForwardAll) {
+  std::vector<int> values;
+  tapa::stream<int, 2> in_q("in");
+  tapa::streams<int, 4, 2> mid_in_q("mid_in");
+  tapa::streams<int, 4, 2> mid_out_q("mid_out");
+  tapa::stream<int, 2> out_q("out");
+  tapa::task()
+      .invoke(Source, 0, 1, in_q)
+      .invoke(Balance, in_q, mid_in_q)
+      .invoke<tapa::join, 4>(Forward, mid_in_q, mid_out_q)
+      .invoke(Merge, mid_out_q, out_q)
+      .invoke(Sink, out_q, &values);
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(values.size(), kN);
+  for (int i = 0; i < kN; ++i) EXPECT_EQ(values[i], i);
+}
+
+}  // namespace
+}  // namespace tapa
@@ -7,11 +7,17 @@
 
 #include "tapa/base/tapa.h"
 
+#include "tapa/host/allocator.h"
 #include "tapa/host/coroutine.h"
+#include "tapa/host/device_buffer.h"
+#include "tapa/host/fork_server.h"
 #include "tapa/host/logging.h"
+#include "tapa/host/mapped_file.h"
 #include "tapa/host/mmap.h"
+#include "tapa/host/pipeline.h"
 #include "tapa/host/stream.h"
 #include "tapa/host/task.h"
+#include "tapa/host/task_graph.h"
 #include "tapa/host/util.h"
 #include "tapa/host/vec.h"
 
@@ -45,7 +51,8 @@ inline int64_t invoke(Func&& f, const std::string& bitstream, Args&&... args) {
 
 // Workaround for the fact that Xilinx's cosim cannot run for more than once in
 // each process. The mmap pointers MUST be allocated via mmap, or the updates
-// won't be seen by the caller process!
+// won't be seen by the caller process! Forks the fork server instead of this
+// process if it is started; see `start_fork_server`.
 template <typename Func, typename... Args>
 inline int64_t invoke_in_new_process(Func&& f, const std::string& bitstream,
                                      Args&&... args) {
@@ -57,26 +64,11 @@ inline int64_t invoke_in_new_process(Func&& f, const std::string& bitstream,
       std::forward<Args>(args)...);
 }
 
-template <typename T>
-struct aligned_allocator {
-  using value_type = T;
-  using size_type = std::size_t;
-  using difference_type = std::ptrdiff_t;
-  template <typename U>
-  void construct(U* ptr) {
-    ::new (static_cast<void*>(ptr)) U;
-  }
-  template <class U, class... Args>
-  void construct(U* ptr, Args&&... args) {
-    ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
-  }
-  T* allocate(size_t count) {
-    return reinterpret_cast<T*>(internal::allocate(count * sizeof(T)));
-  }
-  void deallocate(T* ptr, std::size_t count) {
-    internal::deallocate(ptr, count * sizeof(T));
-  }
-};
+// Stops the worker threads of software simulation. They are created by the
+// first top-level task and kept for later ones until the process exits, unless
+// this is called, after which the next top-level task creates them again. Must
+// not be called while a top-level task is running.
+void shutdown();
 
 }  // namespace tapa
 
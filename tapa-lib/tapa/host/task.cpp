@@ -9,31 +9,41 @@
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <fstream>
 #include <functional>
 #include <list>
 #include <memory>
 #include <mutex>
-#include <queue>
-#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include <pthread.h>
 #include <sched.h>
 #include <sys/mman.h>
 #include <sys/resource.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <frt.h>
 
+#include "tapa/host/fork_server.h"
+#include "tapa/host/profiler.h"
+
 #if TAPA_ENABLE_COROUTINE
 
 #include <boost/coroutine2/coroutine.hpp>
-#include <boost/coroutine2/fixedsize_stack.hpp>
+#include <boost/context/stack_context.hpp>
+#include <boost/chrono.hpp>
 #include <boost/thread/condition_variable.hpp>
 
 #if TAPA_ENABLE_STACKTRACE
@@ -45,10 +55,18 @@ using std::function;
 using std::runtime_error;
 using std::string;
 using std::unordered_map;
+using std::unordered_set;
 
 using boost::condition_variable;
 using boost::mutex;
-using boost::coroutines2::fixedsize_stack;
+
+// ThreadSanitizer fiber API, which is null unless the TSan runtime is linked.
+extern "C" {
+__attribute__((weak)) void* __tsan_get_current_fiber();
+__attribute__((weak)) void* __tsan_create_fiber(unsigned flags);
+__attribute__((weak)) void __tsan_destroy_fiber(void* fiber);
+__attribute__((weak)) void __tsan_switch_to_fiber(void* fiber, unsigned flags);
+}
 
 using pull_type = boost::coroutines2::coroutine<void>::pull_type;
 using push_type = boost::coroutines2::coroutine<void>::push_type;
@@ -60,16 +78,20 @@ namespace internal {
 
 namespace {
 
+struct routine;
+
 thread_local pull_type* current_handle = nullptr;
+thread_local routine* current_routine = nullptr;
 thread_local bool debug = false;
+thread_local const yield_reason* last_yield = nullptr;
 mutex debug_mtx;  // Print stacktrace one-by-one.
 
 }  // namespace
 
-void yield(const string& msg) {
+void yield(const yield_reason& reason) {
   if (debug) {
     unique_lock l(debug_mtx);
-    LOG(INFO) << msg;
+    LOG(INFO) << reason.str();
 #if TAPA_ENABLE_STACKTRACE
     using boost::algorithm::ends_with;
     using boost::algorithm::starts_with;
@@ -95,6 +117,7 @@ void yield(const string& msg) {
   if (current_handle == nullptr) {
     std::this_thread::yield();
   } else {
+    last_yield = &reason;
     (*current_handle)();
   }
 }
@@ -107,195 +130,1354 @@ uint64_t get_time_ns() {
   return static_cast<uint64_t>(tp.tv_sec) * 1000000000 + tp.tv_nsec;
 }
 
-rlim_t get_stack_size() {
+// Stack size used if RLIMIT_STACK is unlimited.
+constexpr size_t kDefaultStackSize = 8 * 1024 * 1024;
+
+// Returns the size of coroutine stacks. Defaults to RLIMIT_STACK and can be
+// overridden by `TAPA_STACK_SIZE`, e.g., `TAPA_STACK_SIZE=512K`.
+size_t get_stack_size() {
+  if (const char* env = getenv("TAPA_STACK_SIZE")) {
+    char* suffix = nullptr;
+    size_t size = strtoull(env, &suffix, /*base=*/10);
+    switch (*suffix) {
+      case 'G':
+      case 'g':
+        size *= 1024;
+        [[fallthrough]];
+      case 'M':
+      case 'm':
+        size *= 1024;
+        [[fallthrough]];
+      case 'K':
+      case 'k':
+        size *= 1024;
+        break;
+    }
+    if (size > 0) return size;
+    LOG(WARNING) << "ignoring invalid TAPA_STACK_SIZE '" << env << "'";
+  }
+
   rlimit rl;
   if (getrlimit(RLIMIT_STACK, &rl) != 0) {
     throw runtime_error(std::strerror(errno));
   }
+  if (rl.rlim_cur == RLIM_INFINITY) return kDefaultStackSize;
   return rl.rlim_cur;
 }
 
-int get_physical_core_count() {
-  std::ifstream cpuinfo("/proc/cpuinfo");
-  std::string line;
-  std::set<int> cores;
+// Returns whether coroutine stacks are protected by guard pages, which is
+// enabled by `TAPA_STACK_GUARD=1`.
+bool is_stack_guard_enabled() {
+  const char* env = getenv("TAPA_STACK_GUARD");
+  return env != nullptr && std::string_view(env) != "0";
+}
 
-  while (std::getline(cpuinfo, line)) {
-    std::istringstream iss(line);
-    std::string token;
-    std::string value;
-    if (std::getline(iss, token, ':') && std::getline(iss, value)) {
-      token.erase(0, token.find_first_not_of(" \t"));
-      token.erase(token.find_last_not_of(" \t") + 1);
-      value.erase(0, value.find_first_not_of(" \t"));
-      value.erase(value.find_last_not_of(" \t") + 1);
-      if (token == "core id") cores.insert(std::stoi(value));
+// Recycles coroutine stacks, so that tasks invoked over and over again do not
+// pay for mmap/munmap and page faults every time.
+class stack_pool {
+ public:
+  // Creates stacks of `size` bytes. If `guard` is set, the lowest page of each
+  // stack is protected so that stack overflows are caught as segfaults.
+  stack_pool(size_t size, bool guard)
+      : page_size(sysconf(_SC_PAGESIZE)),
+        stack_size((size + page_size - 1) / page_size * page_size +
+                   (guard ? page_size : 0)),
+        guard(guard) {}
+
+  // Not copyable or movable.
+  stack_pool(const stack_pool&) = delete;
+  stack_pool& operator=(const stack_pool&) = delete;
+
+  ~stack_pool() {
+    for (void* base : this->free_stacks) {
+      PLOG_IF(ERROR, ::munmap(base, this->stack_size) != 0) << "munmap";
     }
+    VLOG(1) << "coroutine stacks: " << this->mapped_count << " mapped, "
+            << this->peak_count << " in use at peak, "
+            << this->stack_size / 1024 << " KiB each";
   }
 
-  return cores.size();
+  boost::context::stack_context allocate() {
+    void* base = nullptr;
+    {
+      unique_lock lock(this->mtx);
+      if (!this->free_stacks.empty()) {
+        base = this->free_stacks.back();
+        this->free_stacks.pop_back();
+      }
+      this->peak_count = std::max(this->peak_count, ++this->in_use_count);
+    }
+    if (base == nullptr) base = this->map();
+
+    boost::context::stack_context sctx;
+    sctx.size = this->stack_size;
+    sctx.sp = static_cast<char*>(base) + this->stack_size;
+    return sctx;
+  }
+
+  void deallocate(boost::context::stack_context& sctx) noexcept {
+    void* base = static_cast<char*>(sctx.sp) - sctx.size;
+    unique_lock lock(this->mtx);
+    this->free_stacks.push_back(base);
+    --this->in_use_count;
+  }
+
+ private:
+  void* map() {
+    // Physical pages are only committed when touched.
+    void* base = ::mmap(nullptr, this->stack_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                        /*fd=*/-1, /*offset=*/0);
+    if (base == MAP_FAILED) throw std::bad_alloc();
+    if (this->guard && ::mprotect(base, this->page_size, PROT_NONE) != 0) {
+      PLOG(ERROR) << "mprotect";
+    }
+    unique_lock lock(this->mtx);
+    ++this->mapped_count;
+    return base;
+  }
+
+  const size_t page_size;
+  const size_t stack_size;
+  const bool guard;
+
+  mutex mtx;
+  std::vector<void*> free_stacks;
+  size_t mapped_count = 0;
+  size_t in_use_count = 0;
+  size_t peak_count = 0;
+};
+
+// StackAllocator that draws stacks from a `stack_pool`.
+class pooled_stack {
+ public:
+  explicit pooled_stack(stack_pool& pool) : pool(&pool) {}
+
+  boost::context::stack_context allocate() { return this->pool->allocate(); }
+  void deallocate(boost::context::stack_context& sctx) noexcept {
+    this->pool->deallocate(sctx);
+  }
+
+ private:
+  stack_pool* pool;
+};
+
+// Switching fibers must not be instrumented, or the TSan shadow stack of the
+// switching function would be pushed on one fiber and popped from the other.
+#if __has_attribute(disable_sanitizer_instrumentation)
+#define TAPA_NO_TSAN __attribute__((disable_sanitizer_instrumentation))
+#else
+#define TAPA_NO_TSAN __attribute__((no_sanitize_thread))
+#endif
+
+// ThreadSanitizer fiber of a coroutine. Boost.Context switches stacks behind
+// the back of TSan, which would take all coroutines resumed by a thread as the
+// thread itself, and whose shadow stack of the thread would be corrupted by
+// the switches. Each coroutine thus runs on a fiber of its own, entered
+// right before it is resumed and left right after it yields, so that function
+// entries and exits pair up on every fiber. Switching fibers orders accesses
+// before the switch with those after it, as resuming a coroutine does. This
+// is a no-op without TSan.
+class tsan_fiber {
+ public:
+  tsan_fiber()
+      : fiber(__tsan_create_fiber == nullptr
+                  ? nullptr
+                  : __tsan_create_fiber(/*flags=*/0)) {}
+  tsan_fiber(const tsan_fiber&) = delete;
+  tsan_fiber& operator=(const tsan_fiber&) = delete;
+
+  // Leaves the fiber if the coroutine was destroyed on it.
+  TAPA_NO_TSAN ~tsan_fiber() {
+    if (this->fiber == nullptr) return;
+    if (__tsan_get_current_fiber() == this->fiber) this->leave();
+    __tsan_destroy_fiber(this->fiber);
+  }
+
+  TAPA_NO_TSAN void enter() {
+    if (this->fiber == nullptr) return;
+    this->resumer = __tsan_get_current_fiber();
+    __tsan_switch_to_fiber(this->fiber, /*flags=*/0);
+  }
+
+  TAPA_NO_TSAN void leave() {
+    if (this->fiber == nullptr) return;
+    __tsan_switch_to_fiber(this->resumer, /*flags=*/0);
+  }
+
+  // Returns `f()` called on the fiber. Boost.Context enters the stack of a
+  // coroutine when creating it, so the coroutine must be created on the fiber
+  // that it runs and is destroyed on.
+  template <typename F>
+  TAPA_NO_TSAN auto run(F&& f) {
+    this->enter();
+    auto result = f();
+    this->leave();
+    return result;
+  }
+
+ private:
+  void* const fiber;
+  void* resumer = nullptr;  // Fiber of the thread that entered this fiber.
+};
+
+// Location of a logical CPU in the machine.
+struct cpu_info {
+  int cpu = 0;
+  int node = 0;     // NUMA node.
+  int package = 0;  // Socket.
+  int core = 0;     // Physical core in the socket; shared by SMT siblings.
+  int l3 = -1;      // Last-level cache; -1 if unknown.
+};
+
+// Reads an integer from a sysfs file. Returns `fallback` on failure.
+int read_sysfs_int(const string& path, int fallback) {
+  std::ifstream ifs(path);
+  int value;
+  return ifs >> value ? value : fallback;
+}
+
+// Parses a sysfs CPU list, e.g., "0-3,8,10-11".
+std::vector<int> parse_cpu_list(const string& list) {
+  std::vector<int> cpus;
+  std::istringstream iss(list);
+  string range;
+  while (std::getline(iss, range, ',')) {
+    const auto dash = range.find('-');
+    const int first = std::stoi(range.substr(0, dash));
+    const int last =
+        dash == string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+// Returns the CPUs this process may run on, with their topology discovered
+// from sysfs, or from `/proc/cpuinfo` if sysfs is unavailable.
+std::vector<cpu_info> get_cpu_topology() {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    PLOG(WARNING) << "sched_getaffinity";
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) CPU_SET(cpu, &allowed);
+  }
+
+  unordered_map<int, int> cpu_to_node;
+  for (int node = 0;; ++node) {
+    std::ifstream ifs("/sys/devices/system/node/node" + std::to_string(node) +
+                      "/cpulist");
+    string list;
+    if (!std::getline(ifs, list)) break;
+    for (int cpu : parse_cpu_list(list)) cpu_to_node[cpu] = node;
+  }
+
+  // Fallback topology in `/proc/cpuinfo`, indexed by "processor".
+  unordered_map<int, cpu_info> cpuinfo;
+  {
+    std::ifstream ifs("/proc/cpuinfo");
+    string line;
+    cpu_info info;
+    while (std::getline(ifs, line)) {
+      std::istringstream iss(line);
+      string token;
+      string value;
+      if (std::getline(iss, token, ':') && std::getline(iss, value)) {
+        token.erase(0, token.find_first_not_of(" \t"));
+        token.erase(token.find_last_not_of(" \t") + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t") + 1);
+        if (token == "processor") info.cpu = std::stoi(value);
+        if (token == "physical id") info.package = std::stoi(value);
+        if (token == "core id") info.core = std::stoi(value);
+      } else if (line.empty()) {
+        cpuinfo[info.cpu] = info;
+        info = {};
+      }
+    }
+  }
+
+  std::vector<cpu_info> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &allowed)) continue;
+    const string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    cpu_info info;
+    if (auto it = cpuinfo.find(cpu); it != cpuinfo.end()) {
+      info = it->second;
+    } else {
+      // Without any topology info, treat each CPU as a physical core.
+      info.core = cpu;
+    }
+    info.cpu = cpu;
+    info.package =
+        read_sysfs_int(dir + "/topology/physical_package_id", info.package);
+    info.core = read_sysfs_int(dir + "/topology/core_id", info.core);
+    info.l3 = read_sysfs_int(dir + "/cache/index3/id", info.l3);
+    if (auto it = cpu_to_node.find(cpu); it != cpu_to_node.end()) {
+      info.node = it->second;
+    }
+    cpus.push_back(info);
+  }
+  return cpus;
+}
+
+// Returns one CPU per physical core, ordered so that neighboring entries are
+// close in the machine (same NUMA node, socket, and last-level cache).
+std::vector<cpu_info> get_physical_cores() {
+  auto cpus = get_cpu_topology();
+  std::sort(cpus.begin(), cpus.end(), [](const cpu_info& a, const cpu_info& b) {
+    return std::tie(a.node, a.package, a.l3, a.core, a.cpu) <
+           std::tie(b.node, b.package, b.l3, b.core, b.cpu);
+  });
+  // Keep the first SMT sibling of each physical core.
+  cpus.erase(std::unique(cpus.begin(), cpus.end(),
+                         [](const cpu_info& a, const cpu_info& b) {
+                           return a.package == b.package && a.core == b.core;
+                         }),
+             cpus.end());
+  return cpus;
+}
+
+// How tasks are executed, selected by `TAPA_ENGINE`. Detached tasks always run
+// as coroutines so that they can be destroyed when the top-level task finishes.
+enum class engine_t {
+  kCoroutine,  // All tasks run as coroutines on the worker threads.
+  kThread,     // Each joined task runs on a dedicated thread.
+  kHybrid,     // Joined tasks listed in `TAPA_THREAD_TASKS` run on threads.
+
+  // All tasks run as coroutines on a single worker thread, resumed in the
+  // order they are invoked, so that repeated runs behave the same.
+  kDeterministic,
+
+  // Like `kDeterministic`, but joined tasks invoked by other tasks run to
+  // completion on the invoking coroutine in the order they are invoked, and
+  // channels are unbounded. This avoids switching coroutines altogether if
+  // producers are invoked before their consumers.
+  kStatic,
+};
+
+engine_t get_engine() {
+  static const engine_t engine = [] {
+    const char* env = getenv("TAPA_ENGINE");
+    if (env == nullptr || std::string_view(env) == "coroutine") {
+      return engine_t::kCoroutine;
+    }
+    if (std::string_view(env) == "thread") return engine_t::kThread;
+    if (std::string_view(env) == "hybrid") return engine_t::kHybrid;
+    if (std::string_view(env) == "deterministic") {
+      return engine_t::kDeterministic;
+    }
+    if (std::string_view(env) == "static") return engine_t::kStatic;
+    LOG(WARNING) << "unknown TAPA_ENGINE '" << env << "'; using coroutine";
+    return engine_t::kCoroutine;
+  }();
+  return engine;
+}
+
+// Returns the comma-separated task names in `TAPA_THREAD_TASKS`.
+unordered_set<string> get_thread_tasks() {
+  unordered_set<string> names;
+  std::string_view env = getenv("TAPA_THREAD_TASKS") ?: "";
+  while (!env.empty()) {
+    const size_t pos = std::min(env.find(','), env.size());
+    if (pos > 0) names.emplace(env.substr(0, pos));
+    env.remove_prefix(std::min(pos + 1, env.size()));
+  }
+  return names;
+}
+
+// Returns how long all joined coroutines must stay blocked on channels before
+// the simulation is considered deadlocked, or 0 if deadlock detection is
+// disabled. Set by `TAPA_DEADLOCK_TIMEOUT` in seconds.
+uint64_t get_deadlock_timeout_ns() {
+  constexpr uint64_t kDefaultTimeoutSeconds = 10;
+  const char* env = getenv("TAPA_DEADLOCK_TIMEOUT");
+  const uint64_t seconds =
+      env == nullptr ? kDefaultTimeoutSeconds : strtoull(env, nullptr, 10);
+  return seconds * 1000 * 1000 * 1000;
+}
+
+// Returns whether new tasks are placed near the tasks they share channels with,
+// which is disabled by `TAPA_TASK_PLACEMENT=round-robin`.
+bool is_graph_placement_enabled() {
+  const char* env = getenv("TAPA_TASK_PLACEMENT");
+  if (env == nullptr || std::string_view(env) == "graph") return true;
+  LOG_IF(WARNING, std::string_view(env) != "round-robin")
+      << "unknown TAPA_TASK_PLACEMENT '" << env << "'; using round-robin";
+  return false;
 }
 
+// Returns whether worker threads are pinned to CPUs, which is enabled by
+// `TAPA_PIN_WORKERS=1`.
+bool is_worker_pinning_enabled() {
+  const char* env = getenv("TAPA_PIN_WORKERS");
+  return env != nullptr && std::string_view(env) != "0";
+}
+
+class worker;
+
+// A coroutine together with the handle it yields through. A routine is owned
+// by the run queue of exactly one worker at a time, but may be resumed by any
+// worker thread.
+struct routine {
+  routine(bool detach, unique_function&& f, const task_info& info,
+          stack_pool& stacks)
+      : detach(detach),
+        channels(info.channels),
+        func(info.func),
+        label(info.label),
+        body(std::move(f)),
+        coroutine(this->fiber.run([&] {
+          return push_type(pooled_stack(stacks), [this](pull_type& handle) {
+            this->handle = current_handle = &handle;
+            this->body();
+          });
+        })) {}
+
+  // Destroys the coroutine on its own fiber, as it was created, which also
+  // unwinds the stack of an unfinished coroutine.
+  ~routine() { this->fiber.enter(); }
+
+  // Returns a human-readable name of the task.
+  string name() const {
+    string name = GetFunctionName(this->func);
+    if (name.empty()) name = this->label.empty() ? "<anonymous>" : this->label;
+    if (!this->label.empty() && name != this->label) {
+      name += " (" + this->label + ")";
+    }
+    return name;
+  }
+
+  const bool detach;
+  const std::vector<const void*> channels;
+  const void* const func;
+  const string label;
+  unique_function body;
+  pull_type* handle = nullptr;
+  tsan_fiber fiber;  // Destroyed after `coroutine`.
+  push_type coroutine;
+
+  // Index of the worker this coroutine was initially placed on.
+  size_t home = 0;
+
+  // Set if profiling is enabled.
+  task_profile* profile = nullptr;
+
+  // Index among routines of the same task function, and `<task>/<instance>`
+  // once logged.
+  int instance = 0;
+  string log_name;
+
+  // Index in the task graph of the task instance running on this coroutine;
+  // see `get_graph_instance`.
+  int graph_instance = -1;
+
+  // Set for detached coroutines once no joined task is connected to them
+  // through channels. Guarded by `thread_pool::worker_mtx` when written.
+  std::atomic_bool cancelled{false};
+
+  // Set by the coroutine before it yields to ask the worker to park it.
+  struct park_request_t {
+    wait_queue* queue = nullptr;
+    const function<bool()>* ready = nullptr;
+    const yield_reason* reason = nullptr;
+  } park_request;
+
+  // Set while the coroutine is parked in a `wait_queue`.
+  wait_queue* parked_on = nullptr;
+  const yield_reason* wait_reason = nullptr;
+  worker* owner = nullptr;
+  std::list<routine*>::iterator wait_it;
+  std::list<std::unique_ptr<routine>>::iterator parked_it;
+};
+
+class thread_pool;
+
 class worker {
-  // dict mapping detach to list of coroutine
-  // list is used because the stable pointer can be used as key in handle_table
-  unordered_map<bool, std::list<push_type>> coroutines;
+  thread_pool& pool;
 
-  // dict mapping coroutine to handle
-  unordered_map<push_type*, pull_type*> handle_table;
+  // Runnable coroutines owned by this worker. The owner resumes from the front
+  // and puts yielded coroutines back to the end; thieves steal from the end so
+  // that the coroutines that just ran stay warm in the owner's cache.
+  std::deque<std::unique_ptr<routine>> run_queue;
 
-  std::queue<std::tuple<bool, function<void()>>> tasks;
-  mutex mtx;
-  condition_variable task_cv;
-  condition_variable wait_cv;
-  bool done = false;
+  // Coroutines parked in a `wait_queue` by this worker. They are moved back to
+  // the run queue when the `wait_queue` is notified.
+  std::list<std::unique_ptr<routine>> parked;
+
+  mutable mutex mtx;
+  std::atomic_size_t run_queue_size{0};
+  std::atomic_bool busy{false};
   std::atomic_int signal{0};
   std::thread thread;
 
  public:
-  worker() {
-    auto stack_size = get_stack_size();
-    this->thread = std::thread([this, stack_size]() {
-      for (;;) {
-        // accept new tasks
-        {
-          unique_lock lock(this->mtx);
-          this->task_cv.wait(lock, [this] {
-            return this->done || !this->coroutines.empty() ||
-                   !this->tasks.empty();
-          });
+  // CPU this worker runs on, if pinned, or is closest to otherwise.
+  const cpu_info place;
+  const bool pinned;
 
-          // stop worker if it is done
-          if (this->done && this->tasks.empty()) break;
-
-          // create coroutines
-          while (!this->tasks.empty()) {
-            bool detach;
-            function<void()> f;
-            std::tie(detach, f) = this->tasks.front();
-            this->tasks.pop();
-
-            auto& l = this->coroutines[detach];  // list of coroutines
-            auto coroutine = new push_type*;
-            auto call_back = [this, f, coroutine](pull_type& handle) {
-              this->handle_table[*coroutine] = current_handle = &handle;
-              delete coroutine;
-              f();
-            };
-            l.emplace_back(fixedsize_stack(stack_size), call_back);
-            *coroutine = &l.back();
-          }
-        }
+  worker(thread_pool& pool, const cpu_info& place, bool pinned)
+      : pool(pool), place(place), pinned(pinned) {}
 
-        // iterate over all tasks and their coroutines
-        bool active = false;
-        bool debugging = this->signal;
-        if (debugging) debug = true;
-        for (auto& pair : this->coroutines) {
-          bool detach = pair.first;
-          auto& coroutines = pair.second;
-          for (auto it = coroutines.begin(); it != coroutines.end();) {
-            if (auto& coroutine = *it) {
-              current_handle = this->handle_table[&coroutine];
-              coroutine();
-            }
+  void start();
 
-            if (*it) {
-              if (!detach) active = true;
-              ++it;
-            } else {
-              unique_lock lock(this->mtx);
-              it = coroutines.erase(it);
-            }
-          }
-        }
-        if (debugging) {
-          debug = false;
-          this->signal = 0;
-        }
-        // response to wait requests
-        if (!active) this->wait_cv.notify_all();
-      }
-    });
+  // Whether `other` shares the last-level cache with this worker.
+  bool is_near(const worker& other) const {
+    return std::tie(this->place.node, this->place.package, this->place.l3) ==
+           std::tie(other.place.node, other.place.package, other.place.l3);
   }
 
-  void add_task(bool detach, const function<void()>& f) {
-    {
-      unique_lock lock(this->mtx);
-      this->tasks.emplace(detach, f);
-    }
-    this->task_cv.notify_one();
+  void push(std::unique_ptr<routine> r) {
+    unique_lock lock(this->mtx);
+    this->run_queue.push_back(std::move(r));
+    this->run_queue_size = this->run_queue.size();
   }
 
-  void wait() {
+  template <typename InputIt>
+  void push(InputIt first, InputIt last) {
     unique_lock lock(this->mtx);
-    this->wait_cv.wait(lock, [this] {
-      return this->tasks.empty() && this->coroutines[false].empty();
-    });
+    for (; first != last; ++first) this->run_queue.push_back(std::move(*first));
+    this->run_queue_size = this->run_queue.size();
   }
 
-  void send(int signal) { this->signal = signal; }
+  // Puts `prev`, if not null, back to the end of the run queue and returns the
+  // next coroutine to resume, or `nullptr` if there is nothing to resume.
+  std::unique_ptr<routine> rotate(std::unique_ptr<routine> prev) {
+    // Other threads never take coroutines out of an empty run queue, so there
+    // is no need to lock if this worker has nothing else to resume.
+    if (this->run_queue_size == 0) return prev;
+    unique_lock lock(this->mtx);
+    if (prev != nullptr) this->run_queue.push_back(std::move(prev));
+    auto r = std::move(this->run_queue.front());
+    this->run_queue.pop_front();
+    this->run_queue_size = this->run_queue.size();
+    return r;
+  }
 
-  ~worker() {
-    {
-      unique_lock lock(this->mtx);
-      this->done = true;
+  // Returns the number of coroutines a thief may take from this worker. The
+  // coroutine being resumed counts towards the load of this worker, so that a
+  // worker owning a single coroutine keeps it instead of having it ping-pong
+  // between threads.
+  size_t stealable() const {
+    const size_t load = this->run_queue_size +
+                        this->busy.load(std::memory_order_relaxed);
+    return std::min<size_t>(load / 2, this->run_queue_size);
+  }
+
+  // Moves about half of the runnable coroutines to `loot`.
+  void steal(std::vector<std::unique_ptr<routine>>& loot) {
+    unique_lock lock(this->mtx);
+    for (size_t n = this->stealable(); n > 0 && !this->run_queue.empty(); --n) {
+      loot.push_back(std::move(this->run_queue.back()));
+      this->run_queue.pop_back();
+      this->run_queue_size = this->run_queue.size();
     }
-    this->task_cv.notify_all();
-    this->thread.join();
   }
+
+  // Takes the ownership of `r` while it is parked. Must be called with the
+  // lock of the `wait_queue` that `r` is parked on.
+  void park(std::unique_ptr<routine> r) {
+    unique_lock lock(this->mtx);
+    r->owner = this;
+    this->parked.push_back(std::move(r));
+    this->parked.back()->parked_it = std::prev(this->parked.end());
+  }
+
+  // Moves a parked coroutine back to the run queue. Must be called with the
+  // lock of the `wait_queue` that `r` is parked on.
+  void unpark(routine* r);
+
+  bool has_runnable() const { return this->run_queue_size > 0; }
+
+  // Removes coroutines parked by this worker from their `wait_queue`s. The
+  // worker must be paused.
+  void unlink_parked();
+
+  // Destroys all coroutines of this worker. The worker must be paused, and
+  // parked coroutines must be unlinked.
+  void clear() {
+    // Destroyed after the lock is released.
+    std::deque<std::unique_ptr<routine>> run_queue;
+    std::list<std::unique_ptr<routine>> parked;
+    unique_lock lock(this->mtx);
+    run_queue.swap(this->run_queue);
+    parked.swap(this->parked);
+    this->run_queue_size = 0;
+  }
+
+  // Appends coroutines parked by this worker to `routines`.
+  void get_parked(std::vector<const routine*>& routines) const {
+    unique_lock lock(this->mtx);
+    for (auto& r : this->parked) routines.push_back(r.get());
+  }
+
+  void join() {
+    if (this->thread.joinable()) this->thread.join();
+  }
+
+  void send(int signal) { this->signal = signal; }
+
+  ~worker();
+
+ private:
+  void run();
+  void log_parked() const;
 };
 
 void signal_handler(int signal);
 
+// Work-stealing scheduler. New coroutines are placed on the worker that already
+// runs most of the coroutines they share channels with, subject to a load cap,
+// and workers that run out of coroutines steal from the most loaded worker.
 class thread_pool {
+  // Declared before `workers` because destroying coroutines returns stacks.
+  stack_pool stacks{get_stack_size(), /*guard=*/is_stack_guard_enabled()};
+
+  // Profiles of the current top-level task, whose report is written by `stop`
+  // after all workers have paused.
+  std::unique_ptr<profiler> profiles = profiler::New();
+
+  const std::vector<cpu_info> cores = get_physical_cores();
+  const bool pin_workers = is_worker_pinning_enabled();
+
+  std::vector<std::unique_ptr<worker>> workers;
+  size_t next_worker = 0;
   mutex worker_mtx;
-  std::list<worker> workers;
-  decltype(workers)::iterator it;
+
+  const engine_t engine = get_engine();
+  const unordered_set<string> thread_tasks = get_thread_tasks();
+  std::vector<std::thread> threads;  // Guarded by `mtx`.
+  std::atomic_int64_t running_thread_count{0};
+
+  // Deadlock detection state. `progress` changes whenever a coroutine is
+  // unparked or finishes; the others are guarded by `deadlock_mtx`.
+  const uint64_t deadlock_timeout_ns = get_deadlock_timeout_ns();
+  std::atomic_uint64_t progress{0};
+  std::atomic_int64_t parked_joined_count{0};
+  mutex deadlock_mtx;
+  uint64_t last_progress = 0;
+  uint64_t blocked_since_ns = 0;
+
+  // Graph-aware placement state, guarded by `worker_mtx`. A channel is mapped
+  // to the worker of the first coroutine placed with it, and unmapped once the
+  // second endpoint is placed.
+  const bool graph_placement = is_graph_placement_enabled();
+  unordered_map<const void*, size_t> channel_worker;
+  std::vector<size_t> placed_load;  // Unfinished coroutines per home worker.
+  size_t placed_count = 0;
+  unordered_map<const void*, int> instance_count;
+
+  // Unfinished users of each channel, guarded by `worker_mtx`. Detached
+  // coroutines are cancelled once they are no longer connected to any joined
+  // task through channels. Joined tasks on threads are only counted.
+  unordered_map<const void*, std::vector<routine*>> channel_routines;
+  unordered_map<const void*, size_t> channel_threads;
+  size_t cancelled_count = 0;
+
+  // Joined coroutines that have been scheduled but not finished.
+  std::atomic_int64_t joined_count{0};
+  std::atomic_bool done{false};
+  mutex mtx;
+  condition_variable idle_cv;
+  condition_variable wait_cv;
+
+  // Workers are paused between top-level tasks, so that the pool can be
+  // reused without creating threads again. `paused_count` is guarded by `mtx`.
+  std::atomic_bool paused{false};
+  size_t paused_count = 0;
+  condition_variable paused_cv;
 
  public:
+  // Process that created the pool. Forked children do not inherit the workers.
+  const pid_t pid = getpid();
+
   thread_pool(size_t worker_count = 0) {
     signal(SIGINT, signal_handler);
-    if (worker_count == 0) {
+    if (is_deterministic()) {
+      // Streams are not synchronized in this mode, so there must be only one
+      // worker thread.
+      LOG_IF(WARNING, getenv("TAPA_CONCURRENCY") != nullptr)
+          << "TAPA_CONCURRENCY is ignored with a single-threaded TAPA_ENGINE";
+      worker_count = 1;
+    } else if (worker_count == 0) {
       if (auto concurrency = getenv("TAPA_CONCURRENCY")) {
         worker_count = atoi(concurrency);
       } else {
-        worker_count = get_physical_core_count();
+        worker_count = this->cores.size();
       }
     }
-    this->add_worker(worker_count);
-    it = workers.begin();
+    this->add_worker(std::max<size_t>(worker_count, 1));
   }
 
   void add_worker(size_t count = 1) {
     unique_lock lock(this->worker_mtx);
+    // All workers are constructed before any of them starts stealing.
+    const size_t first = this->workers.size();
     for (size_t i = 0; i < count; ++i) {
-      this->workers.emplace_back();
+      // Consecutive workers are placed on nearby cores. Since consecutively
+      // invoked tasks are placed on consecutive workers, tasks connected by
+      // channels tend to share the last-level cache.
+      const size_t index = this->workers.size();
+      const cpu_info place = this->cores.empty()
+                                 ? cpu_info{}
+                                 : this->cores[index % this->cores.size()];
+      this->workers.push_back(std::make_unique<worker>(
+          *this, place, this->pin_workers && !this->cores.empty()));
+      this->placed_load.push_back(0);
+    }
+    for (size_t i = first; i < this->workers.size(); ++i) {
+      this->workers[i]->start();
+    }
+  }
+
+  void add_task(bool detach, unique_function&& f, const task_info& info) {
+    if (!detach && this->is_threaded(info)) {
+      ++this->joined_count;
+      ++this->running_thread_count;
+      {
+        unique_lock lock(this->worker_mtx);
+        this->track(nullptr, info.channels);
+      }
+      unique_lock lock(this->mtx);
+      this->threads.emplace_back(
+          [this, f = std::move(f), channels = info.channels]() mutable {
+            f();
+            --this->running_thread_count;
+            {
+              unique_lock lock(this->worker_mtx);
+              this->untrack(nullptr, channels);
+            }
+            this->finish(/*detach=*/false);
+          });
+      return;
+    }
+
+    auto r =
+        std::make_unique<routine>(detach, std::move(f), info, this->stacks);
+    if (this->profiles != nullptr) {
+      r->profile = this->profiles->add(info.func, info.label);
+    }
+    if (!detach) ++this->joined_count;
+    {
+      unique_lock lock(this->worker_mtx);
+      r->home = this->place(info.channels);
+      r->instance = this->instance_count[info.func]++;
+      ++this->placed_load[r->home];
+      ++this->placed_count;
+      this->track(r.get(), info.channels);
+      this->workers[r->home]->push(std::move(r));
+    }
+    this->idle_cv.notify_all();
+  }
+
+  // Whether a joined task runs on a dedicated thread instead of a coroutine.
+  // Tasks on threads block the thread when waiting on channels, and are
+  // scheduled by the operating system.
+  bool is_threaded(const task_info& info) const {
+    switch (this->engine) {
+      case engine_t::kCoroutine:
+      case engine_t::kDeterministic:
+      case engine_t::kStatic:
+        return false;
+      case engine_t::kThread:
+        return true;
+      case engine_t::kHybrid:
+        return this->thread_tasks.count(string(info.label)) > 0 ||
+               this->thread_tasks.count(GetFunctionName(info.func)) > 0;
+    }
+    return false;
+  }
+
+  // Chooses the worker for a new coroutine using `channels`, which is a greedy
+  // online partitioning of the task graph: among workers that are not loaded
+  // more than one coroutine above the average, picks the one sharing the most
+  // channels with the new coroutine, breaking ties round-robin. Falls back to
+  // plain round-robin if graph placement is disabled.
+  size_t place(const std::vector<const void*>& channels) {
+    const size_t n = this->workers.size();
+    const size_t round_robin = this->next_worker;
+    this->next_worker = (this->next_worker + 1) % n;
+    if (!this->graph_placement || n == 1) return round_robin;
+
+    // Stale channels from finished coroutines must not attract new ones.
+    if (this->placed_count == 0) this->channel_worker.clear();
+
+    std::vector<size_t> shared(n);
+    for (const void* channel : channels) {
+      if (auto it = this->channel_worker.find(channel);
+          it != this->channel_worker.end()) {
+        ++shared[it->second];
+      }
+    }
+    const size_t cap = this->placed_count / n + 1;
+    size_t best = round_robin;
+    for (size_t i = 0; i < n; ++i) {
+      const size_t w = (round_robin + i) % n;
+      if (this->placed_load[w] > cap) continue;
+      if (this->placed_load[best] > cap || shared[w] > shared[best]) best = w;
+    }
+
+    for (const void* channel : channels) {
+      if (auto [it, inserted] = this->channel_worker.emplace(channel, best);
+          !inserted) {
+        this->channel_worker.erase(it);
+      }
+    }
+    return best;
+  }
+
+  // Steals coroutines from the most loaded worker on behalf of `thief`.
+  // Returns one of the stolen coroutines and leaves the rest in the run queue
+  // of `thief`, or returns `nullptr` if nothing can be stolen.
+  //
+  // Workers sharing the last-level cache with `thief` are preferred, so that
+  // coroutines communicating through channels tend to stay in one cache.
+  std::unique_ptr<routine> steal(worker& thief) {
+    worker* victim = nullptr;
+    worker* near_victim = nullptr;
+    size_t max_stealable = 0;
+    size_t max_near_stealable = 0;
+    for (auto& w : this->workers) {
+      if (w.get() == &thief) continue;
+      const size_t n = w->stealable();
+      if (n > max_stealable) {
+        victim = w.get();
+        max_stealable = n;
+      }
+      if (n > max_near_stealable && thief.is_near(*w)) {
+        near_victim = w.get();
+        max_near_stealable = n;
+      }
     }
+    if (near_victim != nullptr) victim = near_victim;
+    if (victim == nullptr) return nullptr;
+
+    std::vector<std::unique_ptr<routine>> loot;
+    victim->steal(loot);
+    if (loot.empty()) return nullptr;
+    auto r = std::move(loot.back());
+    loot.pop_back();
+    thief.push(loot.begin(), loot.end());
+    return r;
+  }
+
+  // Blocks an idle worker until a coroutine is unparked for it or there may
+  // be something to steal. Returns `false` if the pool is shutting down.
+  bool idle(const worker& w) {
+    // Coroutines are polled rather than signaled when they become stealable,
+    // so idle workers check again periodically.
+    constexpr auto kIdleTimeout = boost::chrono::milliseconds(1);
+    unique_lock lock(this->mtx);
+    this->idle_cv.wait_for(lock, kIdleTimeout, [this, &w] {
+      return this->is_done() || this->paused || w.has_runnable();
+    });
+    return !this->done;
+  }
+
+  bool is_paused() const { return this->paused; }
+
+  // Blocks a worker while the pool is paused. Returns `false` if the pool is
+  // shutting down.
+  bool pause() {
+    unique_lock lock(this->mtx);
+    ++this->paused_count;
+    this->paused_cv.notify_all();
+    this->idle_cv.wait(lock, [this] { return this->done || !this->paused; });
+    --this->paused_count;
+    return !this->done;
   }
 
-  void add_task(bool detach, const function<void()>& f) {
+  // Called when a top-level task finishes. Pauses all workers, destroys the
+  // detached coroutines left behind, and writes the profiles.
+  void stop() {
+    // Joined tasks have finished by now, but their threads may still be
+    // returning from `finish`.
+    for (auto& thread : this->threads) thread.join();
+    this->threads.clear();
+    {
+      unique_lock lock(this->mtx);
+      this->paused = true;
+      this->idle_cv.notify_all();
+      this->paused_cv.wait(lock, [this] {
+        return this->paused_count == this->workers.size();
+      });
+    }
+
+    // Destroying a coroutine may notify the `wait_queue`s of any worker, so
+    // no coroutine may be parked in any of them by then.
+    for (auto& w : this->workers) w->unlink_parked();
+    for (auto& w : this->workers) w->clear();
+    this->profiles.reset();
+
     unique_lock lock(this->worker_mtx);
-    it->add_task(detach, f);
-    ++it;
-    if (it == this->workers.end()) it = this->workers.begin();
+    this->next_worker = 0;
+    this->channel_worker.clear();
+    std::fill(this->placed_load.begin(), this->placed_load.end(), 0);
+    this->placed_count = 0;
+    this->instance_count.clear();
+    this->channel_routines.clear();
+    this->channel_threads.clear();
+    this->cancelled_count = 0;
+    this->blocked_since_ns = 0;
+  }
+
+  // Called when a top-level task starts, unless the pool is new.
+  void resume() {
+    this->profiles = profiler::New();
+    {
+      unique_lock lock(this->mtx);
+      this->paused = false;
+    }
+    this->idle_cv.notify_all();
+  }
+
+  // Wakes up idle workers after coroutines are unparked.
+  void wake() {
+    ++this->progress;
+    { unique_lock lock(this->mtx); }
+    this->idle_cv.notify_all();
+  }
+
+  // Tracks the number of joined coroutines parked in a `wait_queue`.
+  void count_parked(const routine& r, int delta) {
+    if (!r.detach) this->parked_joined_count += delta;
+  }
+
+  // Reports and exits if all joined coroutines have been parked without any
+  // progress for `deadlock_timeout_ns`. Called periodically by workers.
+  void detect_deadlock() {
+    if (this->deadlock_timeout_ns == 0) return;
+    boost::unique_lock<mutex> lock(this->deadlock_mtx, boost::try_to_lock);
+    if (!lock.owns_lock()) return;
+
+    // Tasks on threads block without parking, so they are not tracked.
+    const bool blocked = this->running_thread_count == 0 &&
+                         this->joined_count > 0 &&
+                         this->parked_joined_count == this->joined_count;
+    const uint64_t progress = this->progress;
+    const uint64_t now = get_time_ns();
+    if (!blocked || progress != this->last_progress ||
+        this->blocked_since_ns == 0) {
+      this->last_progress = progress;
+      this->blocked_since_ns = blocked ? now : 0;
+      return;
+    }
+    if (now - this->blocked_since_ns < this->deadlock_timeout_ns) return;
+
+    this->report_deadlock();
+    exit(EXIT_FAILURE);
+  }
+
+  // Logs a cycle in the wait-for graph of parked coroutines. A coroutine
+  // blocked on a channel waits for the other coroutines using that channel.
+  void report_deadlock() {
+    std::vector<const routine*> parked;
+    for (auto& w : this->workers) w->get_parked(parked);
+
+    unordered_map<const void*, std::vector<size_t>> users;  // Channel users.
+    for (size_t i = 0; i < parked.size(); ++i) {
+      for (const void* channel : parked[i]->channels) {
+        users[channel].push_back(i);
+      }
+    }
+    auto waits_for = [&](size_t i) {
+      std::vector<size_t> targets;
+      if (auto it = users.find(parked[i]->wait_reason->channel());
+          it != users.end()) {
+        for (size_t j : it->second) {
+          if (j != i) targets.push_back(j);
+        }
+      }
+      return targets;
+    };
+
+    // Finds a cycle with an iterative depth-first search.
+    enum { kUnvisited, kOnPath, kDone };
+    std::vector<int> state(parked.size(), kUnvisited);
+    std::vector<size_t> cycle;
+    for (size_t root = 0; root < parked.size() && cycle.empty(); ++root) {
+      if (state[root] != kUnvisited) continue;
+      std::vector<std::pair<size_t, std::vector<size_t>>> path;
+      path.emplace_back(root, waits_for(root));
+      state[root] = kOnPath;
+      while (!path.empty() && cycle.empty()) {
+        auto& [node, targets] = path.back();
+        if (targets.empty()) {
+          state[node] = kDone;
+          path.pop_back();
+          continue;
+        }
+        const size_t next = targets.back();
+        targets.pop_back();
+        if (state[next] == kOnPath) {
+          auto it = std::find_if(path.begin(), path.end(),
+                                 [next](auto& p) { return p.first == next; });
+          for (; it != path.end(); ++it) cycle.push_back(it->first);
+        } else if (state[next] == kUnvisited) {
+          state[next] = kOnPath;
+          path.emplace_back(next, waits_for(next));
+        }
+      }
+    }
+
+    unique_lock l(debug_mtx);
+    LOG(ERROR) << "deadlock detected: all " << this->joined_count
+               << " joined tasks have been blocked for "
+               << this->deadlock_timeout_ns / 1000 / 1000 / 1000
+               << " s; set TAPA_DEADLOCK_TIMEOUT=0 to disable detection";
+    if (cycle.empty()) {
+      for (const routine* r : parked) {
+        LOG(ERROR) << "  " << r->name() << " is blocked because "
+                   << r->wait_reason->str();
+      }
+      return;
+    }
+    for (size_t i = 0; i < cycle.size(); ++i) {
+      const routine* r = parked[cycle[i]];
+      LOG(ERROR) << "  " << r->name() << " waits for "
+                 << parked[cycle[(i + 1) % cycle.size()]]->name()
+                 << " because " << r->wait_reason->str();
+    }
+  }
+
+  // Records that `r`, or a joined task on a thread if `r` is null, uses
+  // `channels`. A joined task revives the cancelled coroutines it connects to.
+  // Requires holding `worker_mtx`.
+  void track(routine* r, const std::vector<const void*>& channels) {
+    if ((r == nullptr || !r->detach) && this->cancelled_count > 0) {
+      std::vector<routine*> detached;
+      for (const void* channel : channels) {
+        this->connects_joined(channel, detached);
+      }
+      for (routine* d : detached) {
+        if (d->cancelled.exchange(false)) --this->cancelled_count;
+      }
+    }
+    for (const void* channel : channels) {
+      if (r == nullptr) {
+        ++this->channel_threads[channel];
+      } else {
+        this->channel_routines[channel].push_back(r);
+      }
+    }
+  }
+
+  // Reverts `track` when the task finishes. Detached coroutines that are no
+  // longer connected to any joined task are cancelled. Requires holding
+  // `worker_mtx`.
+  void untrack(routine* r, const std::vector<const void*>& channels) {
+    for (const void* channel : channels) {
+      if (r == nullptr) {
+        if (auto it = this->channel_threads.find(channel);
+            it != this->channel_threads.end() && --it->second == 0) {
+          this->channel_threads.erase(it);
+        }
+      } else if (auto it = this->channel_routines.find(channel);
+                 it != this->channel_routines.end()) {
+        auto& users = it->second;
+        if (auto pos = std::find(users.begin(), users.end(), r);
+            pos != users.end()) {
+          users.erase(pos);
+        }
+        if (users.empty()) this->channel_routines.erase(it);
+      }
+    }
+    if (r != nullptr && r->cancelled) --this->cancelled_count;
+    if (r != nullptr && r->detach) return;
+
+    std::vector<routine*> detached;
+    for (const void* channel : channels) {
+      detached.clear();
+      if (this->connects_joined(channel, detached)) continue;
+      for (routine* d : detached) {
+        if (!d->cancelled.exchange(true)) ++this->cancelled_count;
+      }
+    }
+  }
+
+  // Searches the unfinished tasks connected to `channel` through channels of
+  // detached coroutines. Returns true as soon as a joined task is found.
+  // Detached coroutines visited are appended to `detached`. Requires holding
+  // `worker_mtx`.
+  bool connects_joined(const void* channel, std::vector<routine*>& detached) {
+    unordered_set<const void*> visited = {channel};
+    unordered_set<const routine*> visited_routines;
+    std::vector<const void*> pending = {channel};
+    while (!pending.empty()) {
+      const void* const next = pending.back();
+      pending.pop_back();
+      if (this->channel_threads.count(next) > 0) return true;
+      auto it = this->channel_routines.find(next);
+      if (it == this->channel_routines.end()) continue;
+      for (routine* r : it->second) {
+        if (!r->detach) return true;
+        if (!visited_routines.insert(r).second) continue;
+        detached.push_back(r);
+        for (const void* channel : r->channels) {
+          if (visited.insert(channel).second) pending.push_back(channel);
+        }
+      }
+    }
+    return false;
+  }
+
+  // Whether `r`, a cancelled coroutine about to park, waits for a channel
+  // that no other unfinished task uses, so that it would never be woken up.
+  bool is_abandoned(const routine& r) {
+    if (!r.cancelled) return false;
+    const void* const channel = r.park_request.reason->channel();
+    if (channel == nullptr) return false;
+    unique_lock lock(this->worker_mtx);
+    if (this->channel_threads.count(channel) > 0) return false;
+    auto it = this->channel_routines.find(channel);
+    return it != this->channel_routines.end() &&
+           std::all_of(it->second.begin(), it->second.end(),
+                       [&r](const routine* user) { return user == &r; });
+  }
+
+  bool is_done() const { return this->done; }
+
+  void retire(routine& r) {
+    {
+      unique_lock lock(this->worker_mtx);
+      --this->placed_load[r.home];
+      --this->placed_count;
+      this->untrack(&r, r.channels);
+    }
+    this->finish(r.detach);
+  }
+
+  void finish(bool detach) {
+    ++this->progress;
+    if (!detach && --this->joined_count == 0) {
+      unique_lock lock(this->mtx);
+      this->wait_cv.notify_all();
+    }
   }
 
   void wait() {
-    for (auto& w : this->workers) w.wait();
+    unique_lock lock(this->mtx);
+    this->wait_cv.wait(lock, [this] { return this->joined_count == 0; });
   }
 
   void send(int signal) {
-    for (auto& worker : this->workers) worker.send(signal);
+    for (auto& worker : this->workers) worker->send(signal);
   }
 
+  // Must be stopped first.
   ~thread_pool() {
+    {
+      unique_lock lock(this->mtx);
+      this->done = true;
+    }
+    this->idle_cv.notify_all();
+    for (auto& w : this->workers) w->join();
     unique_lock lock(this->worker_mtx);
     this->workers.clear();
   }
 };
 
 thread_pool* pool = nullptr;
+
+}  // namespace
+
+struct wait_queue::impl {
+  std::mutex mtx;
+  std::condition_variable cv;  // Notifies threads blocked in `wait`.
+  std::list<routine*> routines;
+
+  // Parks `r` in the `wait_queue` it requested, unless it is ready already.
+  static void park(std::unique_ptr<routine> r, worker& w) {
+    wait_queue& queue = *std::exchange(r->park_request.queue, nullptr);
+    std::unique_lock<std::mutex> lock(queue.impl_->mtx);
+    ++queue.waiter_count_;
+    // Re-evaluate after `waiter_count_` is updated so that the notification is
+    // not lost if the state changed after the coroutine yielded.
+    if ((*r->park_request.ready)()) {
+      --queue.waiter_count_;
+      w.push(std::move(r));
+      return;
+    }
+    r->parked_on = &queue;
+    r->wait_reason = r->park_request.reason;
+    pool->count_parked(*r, 1);
+    r->wait_it = queue.impl_->routines.insert(queue.impl_->routines.end(),
+                                              r.get());
+    w.park(std::move(r));
+  }
+
+  // Removes a parked coroutine from its `wait_queue` without resuming it.
+  static void unlink(routine& r) {
+    wait_queue& queue = *r.parked_on;
+    std::unique_lock<std::mutex> lock(queue.impl_->mtx);
+    queue.impl_->routines.erase(r.wait_it);
+    --queue.waiter_count_;
+    r.parked_on = nullptr;
+  }
+};
+
+wait_queue::wait_queue() : impl_(std::make_unique<impl>()) {}
+
+wait_queue::~wait_queue() = default;
+
+void wait_queue::wait(const function<bool()>& ready,
+                      const yield_reason& reason) {
+  // Do not access `current_routine` after yielding, because the coroutine may
+  // be resumed by another thread.
+  routine* const self = current_routine;
+  if (self == nullptr) {
+    // Not in a coroutine; block the calling thread instead.
+    std::unique_lock<std::mutex> lock(this->impl_->mtx);
+    ++this->waiter_count_;
+    this->impl_->cv.wait(lock, ready);
+    --this->waiter_count_;
+    return;
+  }
+  while (!ready()) {
+    self->park_request = {this, &ready, &reason};
+    yield(reason);
+  }
+}
+
+void wait_queue::notify_all() {
+  bool unparked = false;
+  {
+    std::unique_lock<std::mutex> lock(this->impl_->mtx);
+    for (routine* r : this->impl_->routines) {
+      r->parked_on = nullptr;
+      r->owner->unpark(r);
+      --this->waiter_count_;
+      unparked = true;
+    }
+    this->impl_->routines.clear();
+  }
+  this->impl_->cv.notify_all();
+  if (unparked) pool->wake();
+}
+
+namespace {
+
+void worker::start() {
+  this->thread = std::thread([this] { this->run(); });
+  if (this->pinned) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(this->place.cpu, &cpus);
+    if (int rc = pthread_setaffinity_np(this->thread.native_handle(),
+                                        sizeof(cpus), &cpus)) {
+      LOG(WARNING) << "failed to pin worker to CPU " << this->place.cpu << ": "
+                   << std::strerror(rc);
+    }
+  }
+}
+
+void worker::run() {
+  // Number of coroutine resumptions left to print debug info for.
+  size_t debug_budget = 0;
+  // Deadlocks are checked every `kDeadlockCheckInterval` resumptions as well
+  // as when idle, because detached coroutines may keep polling.
+  constexpr size_t kDeadlockCheckInterval = 1024;
+  size_t resume_count = 0;
+  std::unique_ptr<routine> r;
+  while (!this->pool.is_done()) {
+    if (this->pool.is_paused()) {
+      // The pool destroys the coroutines of paused workers.
+      if (r != nullptr) this->push(std::move(r));
+      this->busy.store(false, std::memory_order_relaxed);
+      flush_log_buffer(/*force=*/true);
+      if (!this->pool.pause()) break;
+      continue;
+    }
+    if (this->signal) {
+      this->log_parked();
+      debug_budget = this->run_queue_size + (r != nullptr);
+      this->signal = 0;
+    }
+
+    r = this->rotate(std::move(r));
+    if (r == nullptr) r = this->pool.steal(*this);
+    this->busy.store(r != nullptr, std::memory_order_relaxed);
+    if (r == nullptr) {
+      flush_log_buffer(/*force=*/true);
+      this->pool.detect_deadlock();
+      if (!this->pool.idle(*this)) break;
+      continue;
+    }
+    if (++resume_count % kDeadlockCheckInterval == 0) {
+      this->pool.detect_deadlock();
+    }
+
+    debug = debug_budget > 0;
+    if (debug) --debug_budget;
+
+    task_profile* const profile = r->profile;
+    const uint64_t resume_ns = profile == nullptr ? 0 : get_time_ns();
+
+    current_routine = r.get();
+    current_handle = r->handle;
+    r->fiber.enter();
+    r->coroutine();
+    r->fiber.leave();
+    current_handle = nullptr;
+    current_routine = nullptr;
+    flush_log_buffer(/*force=*/false);
+
+    if (profile != nullptr) {
+      const uint64_t end_ns = get_time_ns();
+      ++profile->resumes;
+      profile->run_ns += end_ns - resume_ns;
+      if (r->coroutine) profile->count_yield(last_yield->kind());
+      profile->trace_run(resume_ns, end_ns,
+                         r->coroutine ? last_yield : nullptr);
+    }
+
+    if (!r->coroutine) {
+      this->pool.retire(*r);
+      r.reset();
+    } else if (r->park_request.queue != nullptr) {
+      if (this->pool.is_abandoned(*r)) {
+        // Nothing can wake up the coroutine, so it is dropped instead.
+        r->park_request = {};
+        this->pool.retire(*r);
+        r.reset();
+      } else {
+        wait_queue::impl::park(std::move(r), *this);
+      }
+    }
+  }
+  // Unfinished (detached) coroutines are destroyed together with this worker.
+  if (r != nullptr) this->push(std::move(r));
+  flush_log_buffer(/*force=*/true);
+  debug = false;
+}
+
+void worker::unpark(routine* r) {
+  this->pool.count_parked(*r, -1);
+  unique_lock lock(this->mtx);
+  this->run_queue.push_back(std::move(*r->parked_it));
+  this->parked.erase(r->parked_it);
+  this->run_queue_size = this->run_queue.size();
+}
+
+void worker::log_parked() const {
+  unique_lock lock(this->mtx);
+  unique_lock l(debug_mtx);
+  for (auto& r : this->parked) {
+    LOG(INFO) << r->wait_reason->str() << " (parked)";
+  }
+}
+
+void worker::unlink_parked() {
+  for (auto& r : this->parked) {
+    this->pool.count_parked(*r, -1);
+    wait_queue::impl::unlink(*r);
+  }
+}
+
+worker::~worker() {
+  this->join();
+  this->unlink_parked();
+}
+
 const task* top_task = nullptr;
 mutex mtx;
 
@@ -326,27 +1508,83 @@ void signal_handler(int signal) {
 
 }  // namespace
 
-void schedule(bool detach, const function<void()>& f) {
-  pool->add_task(detach, f);
+void schedule(bool detach, unique_function f, const task_info& info) {
+  if (!detach && is_statically_scheduled() && current_routine != nullptr) {
+    f();
+    return;
+  }
+  pool->add_task(detach, std::move(f), info);
+}
+
+bool is_cancelled() {
+  return current_routine != nullptr &&
+         current_routine->cancelled.load(std::memory_order_acquire);
+}
+
+bool is_deterministic() {
+  return get_engine() == engine_t::kDeterministic || is_statically_scheduled();
+}
+
+bool is_statically_scheduled() { return get_engine() == engine_t::kStatic; }
+
+int& graph_instance() {
+  static thread_local int instance = -1;
+  return current_routine == nullptr ? instance
+                                    : current_routine->graph_instance;
+}
+
+const std::string* get_coroutine_name() {
+  routine* const r = current_routine;
+  if (r == nullptr) return nullptr;
+  if (r->log_name.empty()) {
+    r->log_name = r->profile == nullptr
+                      ? r->name() + "/" + std::to_string(r->instance)
+                      : r->profile->name + "/" +
+                            std::to_string(r->profile->instance);
+  }
+  return &r->log_name;
 }
 
 }  // namespace internal
 
 task::task() {
   unique_lock lock(internal::mtx);
-  if (internal::pool == nullptr) {
-    internal::pool = new internal::thread_pool;
+  if (internal::top_task == nullptr) {
+    // The pool is kept across top-level tasks until `tapa::shutdown`.
+    if (internal::pool != nullptr && internal::pool->pid != getpid()) {
+      internal::pool = nullptr;  // Leaked, since its workers are not here.
+    }
+    if (internal::pool == nullptr) {
+      internal::pool = new internal::thread_pool;
+    } else {
+      internal::pool->resume();
+    }
     internal::top_task = this;
+    if (internal::get_graph_instance() < 0) internal::reset_task_graph();
   }
 }
 
 task::~task() {
   if (this == internal::top_task) {
     internal::pool->wait();
+    internal::channel_stats::WriteReport();
+    internal::mmap_timing::WriteReport();
+    internal::mmap_stats::WriteReport();
+    internal::write_task_graph_report();
+    internal::pool->stop();
     unique_lock lock(internal::mtx);
+    internal::top_task = nullptr;
+  }
+}
+
+void shutdown() {
+  unique_lock lock(internal::mtx);
+  CHECK(internal::top_task == nullptr)
+      << "tapa::shutdown() must not be called while a task is running";
+  if (internal::pool != nullptr && internal::pool->pid == getpid()) {
     delete internal::pool;
-    internal::pool = nullptr;
   }
+  internal::pool = nullptr;
 }
 
 }  // namespace tapa
@@ -365,7 +1603,29 @@ __attribute__((weak)) void __sanitizer_finish_switch_fiber(void*, const void**,
 namespace tapa {
 namespace internal {
 
-void yield(const std::string& msg) { std::this_thread::yield(); }
+void yield(const yield_reason& reason) { std::this_thread::yield(); }
+
+struct wait_queue::impl {
+  std::mutex mtx;
+  std::condition_variable cv;
+};
+
+wait_queue::wait_queue() : impl_(std::make_unique<impl>()) {}
+
+wait_queue::~wait_queue() = default;
+
+void wait_queue::wait(const std::function<bool()>& ready,
+                      const yield_reason& reason) {
+  std::unique_lock<std::mutex> lock(this->impl_->mtx);
+  ++this->waiter_count_;
+  this->impl_->cv.wait(lock, ready);
+  --this->waiter_count_;
+}
+
+void wait_queue::notify_all() {
+  { std::unique_lock<std::mutex> lock(this->impl_->mtx); }
+  this->impl_->cv.notify_all();
+}
 
 namespace {
 
@@ -376,15 +1636,28 @@ std::mutex mtx;
 
 }  // namespace
 
-void schedule(bool detach, const std::function<void()>& f) {
+void schedule(bool detach, unique_function f, const task_info& info) {
   if (detach) {
-    std::thread(f).detach();
+    std::thread(std::move(f)).detach();
   } else {
     std::unique_lock<std::mutex> lock(internal::mtx);
-    threads->emplace_back(f);
+    threads->emplace_back(std::move(f));
   }
 }
 
+bool is_deterministic() { return false; }
+
+bool is_statically_scheduled() { return false; }
+
+const std::string* get_coroutine_name() { return nullptr; }
+
+int& graph_instance() {
+  static thread_local int instance = -1;
+  return instance;
+}
+
+bool is_cancelled() { return false; }
+
 }  // namespace internal
 
 task::task() {
@@ -392,6 +1665,7 @@ task::task() {
   ++internal::active_task_count;
   if (internal::top_task == nullptr) {
     internal::top_task = this;
+    if (internal::get_graph_instance() < 0) internal::reset_task_graph();
   }
   if (internal::threads == nullptr) {
     internal::threads = new std::deque<std::thread>;
@@ -417,12 +1691,19 @@ task::~task() {
       }
       std::this_thread::yield();
     }
+    internal::channel_stats::WriteReport();
+    internal::mmap_timing::WriteReport();
+    internal::mmap_stats::WriteReport();
+    internal::write_task_graph_report();
     internal::top_task = nullptr;
   }
   std::unique_lock<std::mutex> lock(internal::mtx);
   --internal::active_task_count;
 }
 
+// Threads are joined by each top-level task already.
+void shutdown() {}
+
 }  // namespace tapa
 
 #endif  // TAPA_ENABLE_COROUTINE
@@ -431,28 +1712,71 @@ namespace tapa {
 namespace internal {
 
 void* allocate(size_t length) {
-  void* addr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
-                      MAP_SHARED | MAP_ANONYMOUS, /*fd=*/-1, /*offset=*/0);
+  void* addr = map_shared_memory(length, /*flags=*/0);
   if (addr == MAP_FAILED) throw std::bad_alloc();
   return addr;
 }
 void deallocate(void* addr, size_t length) {
-  if (::munmap(addr, length) != 0) throw std::bad_alloc();
+  if (!unmap_shared_memory(addr, length)) throw std::bad_alloc();
 }
 
-}  // namespace internal
+int get_graph_instance() { return graph_instance(); }
 
-task& task::invoke_frt(std::shared_ptr<fpga::Instance> instance) {
+graph_scope::graph_scope(int instance) : saved_(graph_instance()) {
+  graph_instance() = instance;
+}
+
+graph_scope::~graph_scope() { graph_instance() = this->saved_; }
+
+namespace {
+
+// Returns the comma-separated `<task>=<path>` pairs in `TAPA_OFFLOAD_TASKS`.
+std::unordered_map<std::string, std::string> get_offload_tasks() {
+  std::unordered_map<std::string, std::string> paths;
+  std::string_view env = getenv("TAPA_OFFLOAD_TASKS") ?: "";
+  while (!env.empty()) {
+    const size_t pos = std::min(env.find(','), env.size());
+    const std::string_view pair = env.substr(0, pos);
+    if (const size_t eq = pair.find('='); eq != std::string_view::npos) {
+      paths.emplace(pair.substr(0, eq), pair.substr(eq + 1));
+    } else if (!pair.empty()) {
+      LOG(WARNING) << "ignoring '" << pair << "' in TAPA_OFFLOAD_TASKS, "
+                   << "which is not in the form of <task>=<path>";
+    }
+    env.remove_prefix(std::min(pos + 1, env.size()));
+  }
+  return paths;
+}
+
+}  // namespace
+
+const std::string* get_offload_path(const task_info& info) {
+  static const auto* const paths =
+      new std::unordered_map<std::string, std::string>(get_offload_tasks());
+  if (paths->empty()) return nullptr;
+  auto it = paths->find(std::string(info.label));
+  if (it == paths->end()) it = paths->find(GetFunctionName(info.func));
+  if (it == paths->end()) return nullptr;
+  LOG(INFO) << "offloading " << it->first << " to " << it->second;
+  return &it->second;
+}
+
+void schedule_instance(std::shared_ptr<fpga::Instance> instance) {
   instance->WriteToDevice();
   instance->Exec();
   instance->ReadFromDevice();
-  internal::schedule(
-      /*detach=*/false, [instance = std::move(instance)]() {
-        while (!instance->IsFinished()) {
-          internal::yield("fpga::Instance() is not finished");
-        }
-        instance->Finish();
-      });
+  schedule(/*detach=*/false, [instance = std::move(instance)]() {
+    while (!instance->IsFinished()) {
+      yield("fpga::Instance() is not finished");
+    }
+    instance->Finish();
+  });
+}
+
+}  // namespace internal
+
+task& task::invoke_frt(std::shared_ptr<fpga::Instance> instance) {
+  internal::schedule_instance(std::move(instance));
   return *this;
 }
 
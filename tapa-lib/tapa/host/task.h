@@ -8,16 +8,25 @@
 #include "tapa/base/task.h"
 
 #include "tapa/host/coroutine.h"
+#include "tapa/host/fork_server.h"
 #include "tapa/host/internal_util.h"
 #include "tapa/host/logging.h"
+#include "tapa/host/task_graph.h"
 
 #include <sys/wait.h>
 #include <unistd.h>
 #include <chrono>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <frt.h>
 
@@ -31,6 +40,8 @@ struct accessor {
   static void access(fpga::Instance& instance, int& idx, Arg&& arg) {
     instance.SetArg(idx++, static_cast<Param>(arg));
   }
+  static void collect(const std::remove_reference_t<Arg>& arg,
+                      std::vector<memory_region>& regions) {}
 };
 
 template <typename T>
@@ -39,11 +50,47 @@ struct accessor<T, seq> {
   static void access(fpga::Instance& instance, int& idx, seq&& arg) {
     instance.SetArg(idx++, static_cast<T>(arg.pos++));
   }
+  static void collect(const seq& arg, std::vector<memory_region>& regions) {}
 };
 
 void* allocate(size_t length);
 void deallocate(void* addr, size_t length);
 
+// Returns the bitstream or XO that `TAPA_OFFLOAD_TASKS` assigns to the task
+// described by `info`, or null if the task runs in software simulation.
+const std::string* get_offload_path(const task_info& info);
+
+// Runs `instance` with its arguments set, as a joined task that finishes once
+// the kernel finishes.
+void schedule_instance(std::shared_ptr<fpga::Instance> instance);
+
+// Whether `T` is a `tapa::device_buffer`, whose device memory is kept by an
+// instance that stays loaded across invocations.
+template <typename T>
+inline constexpr bool is_device_buffer_v = false;
+
+// Returns the instance of `bitstream` that stays loaded until exit, loading it
+// if not yet, and locks it with `lock` for an invocation.
+fpga::Instance& get_resident_instance(const std::string& bitstream,
+                                      std::unique_lock<std::mutex>& lock);
+
+// Keeps `storage`, the host memory of a device buffer, alive while it is bound
+// to argument `index` of `instance`, if `instance` stays loaded, so that other
+// memory allocated at the same address is never mistaken for it.
+void bind_device_buffer(fpga::Instance& instance, int index,
+                        std::shared_ptr<const void> storage);
+
+// Whether `Arg` can be passed to a kernel on a device as `Param`.
+template <typename Param, typename Arg, typename = void>
+inline constexpr bool is_fpga_arg_v = false;
+template <typename Param, typename Arg>
+inline constexpr bool is_fpga_arg_v<
+    Param, Arg,
+    std::void_t<decltype(accessor<Param, Arg>::access(
+        std::declval<fpga::Instance&>(), std::declval<int&>(),
+        std::declval<Arg>()))>> =
+    std::is_copy_constructible_v<std::decay_t<Param>>;
+
 template <typename F>
 struct invoker {
   using FuncType = std::decay_t<F>;
@@ -54,16 +101,44 @@ struct invoker {
       "task function must return void");
 
   template <typename... Args>
-  static void invoke(int mode, F&& f, Args&&... args) {
-    // Create a functor that captures args by value
-    auto functor = invoker::functor_with_accessors(
-        std::forward<F>(f), std::index_sequence_for<Args...>{},
-        std::forward<Args>(args)...);
+  static void invoke(int mode, std::string_view label, F&& f, Args&&... args) {
+    task_info info;
+    info.label = label;
+    if constexpr (std::is_pointer_v<FuncType>) {
+      info.func = reinterpret_cast<const void*>(static_cast<FuncType>(f));
+      if constexpr (is_offloadable<Args...>(
+                        std::index_sequence_for<Args...>{})) {
+        if (mode == 0) {
+          if (const std::string* path = get_offload_path(info)) {
+            auto instance = std::make_shared<fpga::Instance>(*path);
+            set_fpga_args(*instance, std::forward<F>(f),
+                          std::index_sequence_for<Args...>{},
+                          std::forward<Args>(args)...);
+            schedule_instance(std::move(instance));
+            return;
+          }
+        }
+      }
+    }
+
+    const int instance = record_instance(info, /*is_detached=*/mode < 0);
+    graph_ports ports(instance);
+
+    // Create a functor that captures args by value, which runs as `instance`
+    // of the task graph.
+    auto functor = [instance,
+                    functor = invoker::functor_with_accessors(
+                        info.channels, ports, std::forward<F>(f),
+                        std::index_sequence_for<Args...>{},
+                        std::forward<Args>(args)...)]() mutable {
+      graph_scope scope(instance);
+      std::move(functor)();
+    };
 
     if (mode > 0) {  // Sequential scheduling.
       std::move(functor)();
     } else {
-      internal::schedule(/*detach=*/mode < 0, std::move(functor));
+      internal::schedule(/*detach=*/mode < 0, std::move(functor), info);
     }
   }
 
@@ -72,6 +147,16 @@ struct invoker {
                         const std::string& bitstream, Args&&... args) {
     if (bitstream.empty()) {
       LOG(INFO) << "running software simulation with TAPA library";
+      // The top-level function is the root of the task graph.
+      reset_task_graph();
+      task_info info;
+      if constexpr (std::is_pointer_v<FuncType>) {
+        info.func = reinterpret_cast<const void*>(static_cast<FuncType>(f));
+      }
+      const int instance = record_instance(info, /*is_detached=*/false);
+      graph_ports ports(instance);
+      (record_graph_ports(ports, args), ...);
+      graph_scope scope(instance);
       const auto tic = std::chrono::steady_clock::now();
       f(std::forward<Args>(args)...);
       const auto toc = std::chrono::steady_clock::now();
@@ -79,6 +164,18 @@ struct invoker {
           .count();
     } else {
       if (run_in_new_process) {
+        if constexpr ((std::is_trivially_copyable_v<std::decay_t<Args>> &&
+                       ...)) {
+          int64_t kernel_time_ns;
+          if (run_in_fork_server(
+                  &invoke_serialized<Args...>, serialize(f, bitstream, args...),
+                  collect_memory_regions<Args...>(
+                      std::index_sequence_for<Args...>{}, args...),
+                  kernel_time_ns)) {
+            return kernel_time_ns;
+          }
+        }
+
         auto kernel_time_ns_raw = allocate(sizeof(int64_t));
         auto deleter = [](int64_t* p) { deallocate(p, sizeof(int64_t)); };
         std::unique_ptr<int64_t, decltype(deleter)> kernel_time_ns(
@@ -102,6 +199,19 @@ struct invoker {
     }
   }
 
+  // Invokes `instance` with `args` without waiting for it to finish. Waits
+  // first if the pipeline of `instance` is full.
+  template <typename... Args>
+  static void invoke_async(fpga::Instance& instance, F&& f, Args&&... args) {
+    instance.BeginInvocation();
+    set_fpga_args(instance, std::forward<F>(f),
+                  std::index_sequence_for<Args...>{},
+                  std::forward<Args>(args)...);
+    instance.WriteToDevice();
+    instance.Exec();
+    instance.ReadFromDevice();
+  }
+
   template <typename Func, size_t... Is, typename... CapturedArgs>
   static void set_fpga_args(fpga::Instance& instance, Func&& func,
                             std::index_sequence<Is...>,
@@ -114,26 +224,111 @@ struct invoker {
   }
 
  private:
+  // Whether all arguments can be passed to a kernel on a device, so that the
+  // task can be offloaded by `TAPA_OFFLOAD_TASKS`.
+  template <typename... Args, size_t... Is>
+  static constexpr bool is_offloadable(std::index_sequence<Is...>) {
+    return (is_fpga_arg_v<std::tuple_element_t<Is, Params>, Args> && ...);
+  }
+
   template <typename... Args>
   static int64_t invoke(F&& f, const std::string& bitstream, Args&&... args) {
+    if constexpr ((is_device_buffer_v<std::decay_t<Args>> || ...)) {
+      // Device buffers are reused from the previous invocation of the same
+      // instance.
+      std::unique_lock<std::mutex> lock;
+      fpga::Instance& instance = get_resident_instance(bitstream, lock);
+      invoke_async(instance, std::forward<F>(f), std::forward<Args>(args)...);
+      instance.Finish();
+      return instance.ComputeTimeNanoSeconds();
+    }
     auto instance = fpga::Instance(bitstream);
-    set_fpga_args(instance, std::forward<F>(f),
-                  std::index_sequence_for<Args...>{},
-                  std::forward<Args>(args)...);
-    instance.WriteToDevice();
-    instance.Exec();
-    instance.ReadFromDevice();
+    invoke_async(instance, std::forward<F>(f), std::forward<Args>(args)...);
     instance.Finish();
     return instance.ComputeTimeNanoSeconds();
   }
 
+  // Returns the host memory that `args` refer to.
+  template <typename... Args, size_t... Is>
+  static std::vector<memory_region> collect_memory_regions(
+      std::index_sequence<Is...>,
+      const std::remove_reference_t<Args>&... args) {
+    std::vector<memory_region> regions;
+    (accessor<std::tuple_element_t<Is, Params>, Args>::collect(args, regions),
+     ...);
+    return regions;
+  }
+
+  // Returns `f`, `args`, and `bitstream` serialized for `invoke_serialized`.
+  // `args` must be trivially copyable.
+  template <typename... Args>
+  static std::string serialize(F& f, const std::string& bitstream,
+                               const Args&... args) {
+    const FuncType func = f;
+    std::string payload(reinterpret_cast<const char*>(&func), sizeof(func));
+    (payload.append(reinterpret_cast<const char*>(&args), sizeof(args)), ...);
+    return payload + bitstream;
+  }
+
+  template <typename T>
+  static T deserialize(const char*& payload) {
+    alignas(T) char storage[sizeof(T)];
+    std::memcpy(storage, payload, sizeof(T));
+    payload += sizeof(T);
+    return *std::launder(reinterpret_cast<T*>(storage));
+  }
+
+  // Runs in a child process of the fork server.
+  template <typename... Args>
+  static int64_t invoke_serialized(const char* payload) {
+    const auto func = deserialize<FuncType>(payload);
+    std::tuple<std::decay_t<Args>...> args{
+        deserialize<std::decay_t<Args>>(payload)...};
+    const std::string bitstream = payload;
+    return std::apply(
+        [&](std::decay_t<Args>&... args) {
+          return invoke<Args...>(*func, bitstream,
+                                 static_cast<Args&&>(args)...);
+        },
+        args);
+  }
+
   template <typename Func, size_t... Is, typename... CapturedArgs>
-  static auto functor_with_accessors(Func&& func, std::index_sequence<Is...>,
+  static auto functor_with_accessors(std::vector<const void*>& channels,
+                                     graph_ports& ports, Func&& func,
+                                     std::index_sequence<Is...>,
                                      CapturedArgs&&... args) {
-    // std::bind creates a copy of args
-    return std::bind(
-        func, accessor<std::tuple_element_t<Is, Params>, CapturedArgs>::access(
-                  std::forward<CapturedArgs>(args))...);
+    // Accessed args are moved into the functor, which is then moved, never
+    // copied, until the task runs. Braced initialization accesses them in
+    // order.
+    using Captured = std::tuple<std::decay_t<
+        decltype(accessor<std::tuple_element_t<Is, Params>,
+                          CapturedArgs>::access(
+            std::declval<CapturedArgs&&>()))>...>;
+    Captured captured{with_channels(
+        channels, ports,
+        accessor<std::tuple_element_t<Is, Params>, CapturedArgs>::access(
+            std::forward<CapturedArgs>(args)))...};
+    return [func = std::forward<Func>(func),
+            captured = std::move(captured)]() mutable {
+      std::apply(func, captured);
+    };
+  }
+
+  // Collects the channels referred to by an accessed argument, and records
+  // them in the task graph.
+  template <typename Arg>
+  static Arg&& with_channels(std::vector<const void*>& channels,
+                             graph_ports& ports, Arg&& arg) {
+    channel_traits<std::decay_t<Arg>>::collect(arg, channels);
+    record_graph_ports(ports, arg);
+    return std::forward<Arg>(arg);
+  }
+
+  template <typename Arg>
+  static void record_graph_ports(graph_ports& ports, const Arg& arg) {
+    graph_traits<std::decay_t<Arg>>::record(arg, ports);
+    ports.next_arg();
   }
 };
 
@@ -216,7 +411,7 @@ struct task {
         internal::is_callable_v<typename std::remove_reference_t<Func>>,
         "the first argument for tapa::task::invoke() must be callable");
     internal::invoker<Func>::template invoke<Args...>(
-        mode_override.value_or(mode), std::forward<Func>(func),
+        mode_override.value_or(mode), name, std::forward<Func>(func),
         std::forward<Args>(args)...);
     return *this;
   }
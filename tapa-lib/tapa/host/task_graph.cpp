@@ -0,0 +1,247 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/task_graph.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "tapa/host/internal_util.h"
+#include "tapa/host/stream.h"
+
+namespace tapa {
+
+namespace {
+
+std::mutex graph_mtx;
+task_graph graph;
+
+// Index in `graph.streams` of each queue, by its serial.
+std::unordered_map<uint64_t, int> stream_indices;
+
+// Returns the name of a stream or memory as an argument.
+std::string get_arg_name(const task_graph& graph, const task_graph::port& port) {
+  if (port.kind == task_graph::port::kMmap) {
+    return "mmap_" + std::to_string(port.index);
+  }
+  const std::string& name = graph.streams[port.index].name;
+  return name.empty() ? "stream_" + std::to_string(port.index) : name;
+}
+
+const char* get_cat(task_graph::port::kind_t kind) {
+  switch (kind) {
+    case task_graph::port::kIstream:
+      return "istream";
+    case task_graph::port::kOstream:
+      return "ostream";
+    case task_graph::port::kMmap:
+      return "mmap";
+  }
+  return "";
+}
+
+}  // namespace
+
+std::string task_graph::to_json() const {
+  // First instance of each task, and the children of each instance.
+  std::map<std::string, int> tasks;
+  std::vector<std::vector<int>> children(this->instances.size());
+  for (int i = 0; i < int(this->instances.size()); ++i) {
+    const instance& inst = this->instances[i];
+    tasks.emplace(inst.task, i);
+    if (inst.parent >= 0) children[inst.parent].push_back(i);
+  }
+
+  // Index of each instance among the instances of the same task invoked by its
+  // parent.
+  std::vector<int> step_indices(this->instances.size());
+  for (const auto& siblings : children) {
+    std::map<std::string, int> counts;
+    for (int i : siblings) step_indices[i] = counts[this->instances[i].task]++;
+  }
+
+  std::ostringstream os;
+  os << "{\"top\":";
+  internal::WriteJsonString(
+      os, this->instances.empty() ? "" : this->instances.front().task);
+  os << ",\"cflags\":[],\"tasks\":{";
+  bool is_first_task = true;
+  for (const auto& [name, index] : tasks) {
+    os << (is_first_task ? "" : ",");
+    is_first_task = false;
+    internal::WriteJsonString(os, name);
+    os << ":{\"level\":";
+    if (children[index].empty()) {
+      os << "\"lower\",\"target\":\"hls\",\"vendor\":\"xilinx\",\"code\":\"\"}";
+      continue;
+    }
+    os << "\"upper\",\"target\":\"hls\",\"vendor\":\"xilinx\",\"code\":\"\","
+          "\"ports\":[],\"tasks\":{";
+
+    // Children grouped by task, in the order of their first instances.
+    std::vector<std::string> child_tasks;
+    std::map<std::string, std::vector<int>> steps;
+    for (int child : children[index]) {
+      auto& instances = steps[this->instances[child].task];
+      if (instances.empty()) child_tasks.push_back(this->instances[child].task);
+      instances.push_back(child);
+    }
+    for (size_t i = 0; i < child_tasks.size(); ++i) {
+      os << (i == 0 ? "" : ",");
+      internal::WriteJsonString(os, child_tasks[i]);
+      os << ":[";
+      const auto& instances = steps[child_tasks[i]];
+      for (size_t j = 0; j < instances.size(); ++j) {
+        const instance& inst = this->instances[instances[j]];
+        os << (j == 0 ? "" : ",") << "{\"step\":" << (inst.is_detached ? -1 : 0)
+           << ",\"args\":{";
+        for (size_t k = 0; k < inst.ports.size(); ++k) {
+          const port& port = inst.ports[k];
+          os << (k == 0 ? "" : ",") << "\"" << port.arg;
+          // Arrays of streams have one port per stream, named `<arg>[<i>]`.
+          const bool is_array =
+              (k > 0 && inst.ports[k - 1].arg == port.arg) ||
+              (k + 1 < inst.ports.size() && inst.ports[k + 1].arg == port.arg);
+          if (is_array) {
+            size_t first = k;
+            while (first > 0 && inst.ports[first - 1].arg == port.arg) --first;
+            os << "[" << k - first << "]";
+          }
+          os << "\":{\"arg\":";
+          internal::WriteJsonString(os, get_arg_name(*this, port));
+          os << ",\"cat\":\"" << get_cat(port.kind) << "\"}";
+        }
+        os << "}}";
+      }
+      os << "]";
+    }
+
+    os << "},\"fifos\":{";
+    bool is_first_fifo = true;
+    for (int i = 0; i < int(this->streams.size()); ++i) {
+      const stream& fifo = this->streams[i];
+      if (fifo.owner != index) continue;
+      os << (is_first_fifo ? "" : ",");
+      is_first_fifo = false;
+      internal::WriteJsonString(
+          os, get_arg_name(*this, {0, port::kIstream, i}));
+      os << ":{";
+      if (fifo.producer >= 0) {
+        os << "\"produced_by\":[";
+        internal::WriteJsonString(os, this->instances[fifo.producer].task);
+        os << "," << step_indices[fifo.producer] << "],";
+      }
+      if (fifo.consumer >= 0) {
+        os << "\"consumed_by\":[";
+        internal::WriteJsonString(os, this->instances[fifo.consumer].task);
+        os << "," << step_indices[fifo.consumer] << "],";
+      }
+      os << "\"depth\":";
+      if (fifo.depth == kStreamInfiniteDepth) {
+        os << "null";
+      } else {
+        os << fifo.depth;
+      }
+      os << "}";
+    }
+    os << "}}";
+  }
+  os << "}}";
+  return os.str();
+}
+
+task_graph get_task_graph() {
+  std::unique_lock lock(graph_mtx);
+  return graph;
+}
+
+namespace internal {
+
+void graph_ports::add_stream(const type_erased_queue* queue,
+                             task_graph::port::kind_t kind) {
+  std::unique_lock lock(graph_mtx);
+  const int owner = graph.instances[this->instance_].parent;
+  auto [it, is_new] =
+      stream_indices.emplace(queue->get_serial(), graph.streams.size());
+  if (is_new) {
+    graph.streams.push_back({
+        .name = queue->get_name(),
+        .depth = queue->get_synthesis_depth(),
+        .owner = owner,
+        .producer = -1,
+        .consumer = -1,
+    });
+  }
+  task_graph::stream& stream = graph.streams[it->second];
+
+  // Only children of the owner are connected by the stream; descendants
+  // further down are reached through the ports of those children.
+  if (stream.owner == owner) {
+    int& end = kind == task_graph::port::kOstream ? stream.producer
+                                                  : stream.consumer;
+    if (end < 0) end = this->instance_;
+  }
+  graph.instances[this->instance_].ports.push_back(
+      {this->arg_, kind, it->second});
+}
+
+void graph_ports::add_mmap(const void* data, uint64_t size) {
+  std::unique_lock lock(graph_mtx);
+  int index = 0;
+  while (index < int(graph.mmaps.size()) &&
+         (graph.mmaps[index].data != data || graph.mmaps[index].size != size)) {
+    ++index;
+  }
+  if (index == int(graph.mmaps.size())) graph.mmaps.push_back({data, size});
+  graph.instances[this->instance_].ports.push_back(
+      {this->arg_, task_graph::port::kMmap, index});
+}
+
+int record_instance(const task_info& info, bool is_detached) {
+  std::string name = GetFunctionName(info.func);
+  if (name.empty()) name = info.label.empty() ? "<anonymous>" : info.label;
+  const int parent = get_graph_instance();
+  std::unique_lock lock(graph_mtx);
+  graph.instances.push_back({
+      .task = std::move(name),
+      .label = std::string(info.label),
+      .parent = parent,
+      .is_detached = is_detached,
+      .ports = {},
+  });
+  return graph.instances.size() - 1;
+}
+
+void reset_task_graph() {
+  std::unique_lock lock(graph_mtx);
+  graph = {};
+  stream_indices.clear();
+}
+
+void write_task_graph_report() {
+  const char* path = getenv("TAPA_TASK_GRAPH");
+  if (path == nullptr || *path == '\0') return;
+
+  std::ofstream ofs(path);
+  ofs << get_task_graph().to_json() << "\n";
+  if (ofs.fail()) {
+    LOG(ERROR) << "failed to write task graph to '" << path << "'";
+  } else {
+    LOG(INFO) << "task graph is written to '" << path << "'";
+  }
+}
+
+}  // namespace internal
+
+}  // namespace tapa
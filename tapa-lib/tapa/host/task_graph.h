@@ -0,0 +1,141 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#ifndef TAPA_HOST_TASK_GRAPH_H_
+#define TAPA_HOST_TASK_GRAPH_H_
+
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include "tapa/host/coroutine.h"
+
+namespace tapa {
+
+/// Task instances of a software simulation and the channels connecting them,
+/// as recorded by @c tapa::task::invoke. Obtained by @c tapa::get_task_graph.
+struct task_graph {
+  /// A stream or memory passed to a task instance.
+  struct port {
+    enum kind_t { kIstream, kOstream, kMmap };
+
+    /// Position of the argument among those passed to the task.
+    int arg;
+    kind_t kind;
+
+    /// Index in @c streams or @c mmaps, depending on @c kind.
+    int index;
+  };
+
+  struct instance {
+    /// Name of the task function, or the label passed to
+    /// @c tapa::task::invoke if the name is unknown; see
+    /// @c TAPA_TASK_GRAPH.
+    std::string task;
+
+    /// Label passed to @c tapa::task::invoke, if any.
+    std::string label;
+
+    /// Index of the instance that invoked this one, or -1 for the top-level
+    /// task.
+    int parent;
+    bool is_detached;
+    std::vector<port> ports;
+  };
+
+  struct stream {
+    /// Name passed to the constructor, e.g., `name[i]` of @c tapa::streams.
+    std::string name;
+
+    /// Depth in hardware, as opposed to the simulation depth.
+    uint64_t depth;
+
+    /// Instance that declared the stream, i.e., the parent of the first
+    /// instance it is passed to, or -1 if unknown.
+    int owner;
+
+    /// Children of @c owner that write and read the stream, or -1 if none.
+    int producer;
+    int consumer;
+  };
+
+  struct mmap {
+    const void* data;
+    uint64_t size;  // In bytes.
+  };
+
+  /// Instances in the order they are invoked. Parents precede their children.
+  std::vector<instance> instances;
+  std::vector<stream> streams;
+  std::vector<mmap> mmaps;
+
+  /// Returns the graph in the format of the graph JSON of @c tapa-visualizer.
+  /// Each task is described by its first instance. As argument names are not
+  /// known on the host, arguments are named by their positions.
+  std::string to_json() const;
+};
+
+/// Returns the task graph of the running or last finished top-level task.
+task_graph get_task_graph();
+
+namespace internal {
+
+class type_erased_queue;
+
+// Records the ports of a task instance in the order of its arguments.
+class graph_ports {
+ public:
+  explicit graph_ports(int instance) : instance_(instance) {}
+
+  void add_stream(const type_erased_queue* queue, task_graph::port::kind_t kind);
+  void add_mmap(const void* data, uint64_t size);
+
+  // Moves on to the next argument.
+  void next_arg() { ++arg_; }
+
+ private:
+  const int instance_;
+  int arg_ = 0;
+};
+
+// Records the ports of a task argument. Specialized by channel and memory
+// types.
+template <typename T, typename = void>
+struct graph_traits {
+  static void record(const T& arg, graph_ports& ports) {}
+};
+
+// Records an instance of the task described by `info` invoked by the calling
+// task instance, and returns its index.
+int record_instance(const task_info& info, bool is_detached);
+
+// Starts a new graph, e.g., for a new top-level task.
+void reset_task_graph();
+
+// Returns the index of the calling task instance, or -1 if unknown.
+int get_graph_instance();
+
+// Makes `instance` the calling task instance during its lifetime.
+class graph_scope {
+ public:
+  explicit graph_scope(int instance);
+  ~graph_scope();
+
+  // Not copyable or movable.
+  graph_scope(const graph_scope&) = delete;
+  graph_scope& operator=(const graph_scope&) = delete;
+
+ private:
+  const int saved_;
+};
+
+// Writes the graph to `TAPA_TASK_GRAPH`, if set.
+void write_task_graph_report();
+
+}  // namespace internal
+
+}  // namespace tapa
+
+#endif  // TAPA_HOST_TASK_GRAPH_H_
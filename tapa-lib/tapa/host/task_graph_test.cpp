@@ -0,0 +1,135 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/task_graph.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "tapa.h"
+
+namespace tapa {
+namespace {
+
+constexpr int kN = 100;
+
+void Load(tapa::mmap<const int> mem, tapa::ostream<int>& data_out) {
+  for (int i = 0; i < kN; ++i) data_out.write(mem[i]);
+}
+
+void Add(tapa::istreams<int, 2>& data_in, tapa::ostream<int>& data_out) {
+  for (int i = 0; i < kN; ++i) {
+    data_out.write(data_in[0].read() + data_in[1].read());
+  }
+}
+
+void Store(tapa::istream<int>& data_in, tapa::mmap<int> mem) {
+  for (int i = 0; i < kN; ++i) mem[i] = data_in.read();
+}
+
+// Passes its streams through to its children.
+void Inner(tapa::istreams<int, 2>& data_in, tapa::ostream<int>& data_out) {
+  tapa::task().invoke(Add, "add", data_in, data_out);
+}
+
+void Top(tapa::mmap<const int> a, tapa::mmap<const int> b, tapa::mmap<int> c) {
+  tapa::streams<int, 2, 4> data_in("data_in");
+  tapa::stream<int, 8, 16> data_out("data_out");
+  tapa::task()
+      .invoke(Load, "load_a", a, data_in)
+      .invoke(Load, "load_b", b, data_in)
+      .invoke(Inner, "inner", data_in, data_out)
+      .invoke(Store, "store", data_out, c);
+}
+
+TEST(TaskGraphTest, RecordsInstancesAndChannels) {
+  std::vector<int> a(kN), b(kN), c(kN);
+  for (int i = 0; i < kN; ++i) {
+    a[i] = i;
+    b[i] = i * 2;
+  }
+  tapa::invoke(Top, "", tapa::read_only_mmap<const int>(a),
+               tapa::read_only_mmap<const int>(b),
+               tapa::write_only_mmap<int>(c));
+  for (int i = 0; i < kN; ++i) ASSERT_EQ(c[i], i * 3) << i;
+
+  const task_graph graph = get_task_graph();
+  ASSERT_EQ(graph.instances.size(), 6);
+  EXPECT_EQ(graph.instances[0].parent, -1);
+  EXPECT_EQ(graph.instances[0].ports.size(), 3);
+  for (int i = 1; i <= 4; ++i) EXPECT_EQ(graph.instances[i].parent, 0) << i;
+
+  // Instances of the same parent are recorded in the order of invocation,
+  // but children of different parents may interleave.
+  int add = -1;
+  for (int i = 0; i < int(graph.instances.size()); ++i) {
+    if (graph.instances[i].label == "add") add = i;
+  }
+  ASSERT_GE(add, 0);
+  ASSERT_EQ(graph.instances[3].label, "inner");
+  EXPECT_EQ(graph.instances[add].parent, 3);
+  EXPECT_FALSE(graph.instances[add].is_detached);
+
+  ASSERT_EQ(graph.streams.size(), 3);
+  EXPECT_EQ(graph.streams[0].name, "data_in[0]");
+  EXPECT_EQ(graph.streams[0].depth, 4);
+  EXPECT_EQ(graph.streams[0].owner, 0);
+  EXPECT_EQ(graph.streams[0].producer, 1);
+  EXPECT_EQ(graph.streams[0].consumer, 3);
+  EXPECT_EQ(graph.streams[1].name, "data_in[1]");
+  EXPECT_EQ(graph.streams[1].producer, 2);
+  EXPECT_EQ(graph.streams[1].consumer, 3);
+  EXPECT_EQ(graph.streams[2].name, "data_out");
+  EXPECT_EQ(graph.streams[2].depth, 8);
+  EXPECT_EQ(graph.streams[2].producer, 3);
+  EXPECT_EQ(graph.streams[2].consumer, 4);
+
+  // `add` reads both streams of its array argument.
+  const auto& ports = graph.instances[add].ports;
+  ASSERT_EQ(ports.size(), 3);
+  EXPECT_EQ(ports[0].arg, 0);
+  EXPECT_EQ(ports[0].kind, task_graph::port::kIstream);
+  EXPECT_EQ(ports[0].index, 0);
+  EXPECT_EQ(ports[1].arg, 0);
+  EXPECT_EQ(ports[1].index, 1);
+  EXPECT_EQ(ports[2].arg, 1);
+  EXPECT_EQ(ports[2].kind, task_graph::port::kOstream);
+  EXPECT_EQ(ports[2].index, 2);
+
+  ASSERT_EQ(graph.mmaps.size(), 3);
+  EXPECT_EQ(graph.mmaps[2].data, c.data());
+  EXPECT_EQ(graph.mmaps[2].size, kN * sizeof(int));
+  ASSERT_EQ(graph.instances[4].ports.size(), 2);
+  EXPECT_EQ(graph.instances[4].ports[1].kind, task_graph::port::kMmap);
+  EXPECT_EQ(graph.instances[4].ports[1].index, 2);
+
+  const std::string json = graph.to_json();
+  EXPECT_NE(json.find(R"("data_out":{"produced_by":["inner",0],)"
+                      R"("consumed_by":["store",0],"depth":8})"),
+            std::string::npos)
+      << json;
+}
+
+TEST(TaskGraphTest, ResetsForEachTopLevelTask) {
+  std::vector<int> c(kN);
+  tapa::mmap<const int> src(c);
+  tapa::mmap<int> dst(c);
+  tapa::stream<int, 2> data_q("data");
+  tapa::task()
+      .invoke(Load, "load", src, data_q)
+      .invoke(Store, "store", data_q, dst);
+
+  const task_graph graph = get_task_graph();
+  ASSERT_EQ(graph.instances.size(), 2);
+  EXPECT_EQ(graph.instances[0].parent, -1);
+  EXPECT_EQ(graph.instances[1].parent, -1);
+  ASSERT_EQ(graph.streams.size(), 1);
+  EXPECT_EQ(graph.streams[0].owner, -1);
+  EXPECT_EQ(graph.streams[0].producer, 0);
+  EXPECT_EQ(graph.streams[0].consumer, 1);
+}
+
+}  // namespace
+}  // namespace tapa
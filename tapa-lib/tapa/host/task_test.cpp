@@ -4,7 +4,17 @@
 
 #include "tapa/host/task.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <utility>
 
 #include <gtest/gtest.h>
 
@@ -56,5 +66,233 @@ TEST(TaskTest, InvokingTemplatedTaskWorks) {
       .invoke(DataSource, data_q, kN);
 }
 
+void Forward(tapa::istream<int>& data_in_q, tapa::ostream<int>& data_out_q,
+             int n) {
+  for (int i = 0; i < n; ++i) {
+    data_out_q.write(data_in_q.read());
+  }
+}
+
+// Coroutines may migrate between worker threads when idle workers steal.
+TEST(TaskTest, InvokingLongTaskChainWorks) {
+  constexpr int kChainLength = 64;
+  constexpr int kChainN = 1000;
+  tapa::streams<int, kChainLength + 1> data_q;
+  tapa::task()
+      .invoke(DataSource, data_q, kChainN)
+      .invoke<tapa::join, kChainLength>(Forward, data_q, data_q, kChainN)
+      .invoke(DataSink, data_q, kChainN);
+}
+
+constexpr int kChunkSize = 7;
+
+void BulkSource(tapa::ostream<int>& data_out_q, int n) {
+  int values[kChunkSize];
+  for (int i = 0; i < n; i += kChunkSize) {
+    for (int j = 0; j < kChunkSize; ++j) values[j] = i + j;
+    data_out_q.write_n(values, std::min(kChunkSize, n - i));
+  }
+  data_out_q.close();
+}
+
+void BulkSink(tapa::istream<int>& data_in_q, int n) {
+  int values[kChunkSize];
+  data_in_q.read_n(values, kChunkSize);
+  for (int j = 0; j < kChunkSize; ++j) EXPECT_EQ(values[j], j);
+  for (int i = kChunkSize; i < n;) {
+    const size_t count = data_in_q.try_read_up_to(values, kChunkSize);
+    for (size_t j = 0; j < count; ++j) EXPECT_EQ(values[j], i++);
+  }
+  EXPECT_EQ(data_in_q.try_read_up_to(values, kChunkSize), 0);
+  data_in_q.open();
+}
+
+// Bulk operations wrap around a ring buffer smaller than the chunk size.
+TEST(TaskTest, BulkReadAndWriteWorks) {
+  tapa::stream<int, 4> data_q;
+  tapa::task()
+      .invoke(BulkSource, data_q, kN)
+      .invoke(BulkSink, data_q, kN);
+}
+
+void Check(tapa::istream<int>& data_in_q, int n) {
+  for (int i = 0; i < n; ++i) EXPECT_EQ(data_in_q.read(), i);
+}
+
+// Every consumer receives all tokens, although the producer can only run a
+// FIFO ahead of the slowest one.
+TEST(TaskTest, BroadcastStreamReachesAllConsumers) {
+  constexpr int kConsumerCount = 3;
+  tapa::broadcast_stream<int, kConsumerCount, 2> data_q("data");
+  tapa::task()
+      .invoke(DataSource, data_q, kN)
+      .invoke<tapa::join, kConsumerCount>(Check, data_q, kN);
+}
+
+TEST(TaskTest, WritingChannelStatsSucceeds) {
+  const std::string path = testing::TempDir() + "/channel_stats.json";
+  ASSERT_EQ(setenv("TAPA_STREAM_STATS", path.c_str(), /*replace=*/1), 0);
+  {
+    tapa::stream<int, 4> data_q("data");
+    tapa::task()
+        .invoke(BulkSource, data_q, kN)
+        .invoke(BulkSink, data_q, kN);
+  }
+  EXPECT_EQ(unsetenv("TAPA_STREAM_STATS"), 0);
+
+  std::ifstream ifs(path);
+  const std::string report((std::istreambuf_iterator<char>(ifs)),
+                           std::istreambuf_iterator<char>());
+  EXPECT_NE(report.find(R"("name": "data", "depth": 4, "pushes": 5001, )"
+                        R"("pops": 5001, "max_occupancy": 4, )"),
+            std::string::npos)
+      << report;
+}
+
+TEST(TaskTest, UniqueFunctionRunsSmallAndLargeCallables) {
+  int calls = 0;
+  auto small = std::make_unique<int>(1);
+  internal::unique_function f = [&calls, small = std::move(small)] {
+    calls += *small;
+  };
+  std::array<int, 64> large;
+  large.fill(2);
+  internal::unique_function g = [&calls, large] { calls += large.back(); };
+
+  internal::unique_function moved = std::move(f);
+  EXPECT_FALSE(f);
+  moved();
+  std::swap(moved, g);
+  moved();
+  g();
+  EXPECT_EQ(calls, 4);
+}
+
+// Counts copies of itself, which are not expected when tasks are scheduled.
+struct CopyCounter {
+  explicit CopyCounter(int* copies) : copies(copies) {}
+  CopyCounter(const CopyCounter& other) : copies(other.copies) { ++*copies; }
+  CopyCounter(CopyCounter&& other) = default;
+  int* copies;
+};
+
+void TakeCopyCounter(CopyCounter counter) {}
+
+TEST(TaskTest, InvokingTaskOnlyCopiesArgumentsForParameters) {
+  int copies = 0;
+  CopyCounter counter(&copies);
+  tapa::task().invoke(TakeCopyCounter, counter);
+
+  // Once when the task is invoked and once when the task function is called.
+  EXPECT_EQ(copies, 2);
+}
+
+#if TAPA_ENABLE_COROUTINE
+
+std::atomic<int> detached_sum{0};
+std::atomic_bool is_detached_sum_dropped{false};
+
+void DetachedSum(tapa::istream<int>& data_in_q) {
+  struct Sentinel {
+    ~Sentinel() { is_detached_sum_dropped = true; }
+  } sentinel;
+  for (;;) detached_sum += data_in_q.read();
+}
+
+void WaitForDetachedSum(int n) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!is_detached_sum_dropped &&
+         std::chrono::steady_clock::now() < deadline) {
+    internal::yield("waiting for DetachedSum to be dropped");
+  }
+  EXPECT_TRUE(is_detached_sum_dropped);
+  EXPECT_EQ(detached_sum, n * (n - 1) / 2);
+}
+
+// Detached tasks are dropped once the joined tasks feeding them have finished
+// and their inputs are drained, not when the top-level task finishes.
+TEST(TaskTest, DetachedTaskIsDroppedOnceDrained) {
+  constexpr int kDetachedN = 100;
+  tapa::stream<int, 2> data_q;
+  tapa::task()
+      .invoke(DataSource, data_q, kDetachedN)
+      .invoke<tapa::detach>(DetachedSum, data_q)
+      .invoke(WaitForDetachedSum, kDetachedN);
+}
+
+std::atomic<int> poller_count{0};
+
+void Poll() {
+  struct Sentinel {
+    Sentinel() { ++poller_count; }
+    ~Sentinel() { --poller_count; }
+  } sentinel;
+  for (;;) internal::yield("polling");
+}
+
+// Worker threads are kept across top-level tasks, but detached tasks are not.
+TEST(TaskTest, RepeatedTopLevelTasksReuseThreadPool) {
+  for (int i = 0; i < 100; ++i) {
+    if (i == 50) tapa::shutdown();
+    tapa::stream<int, 2> data_q;
+    tapa::task()
+        .invoke<tapa::detach>(Poll)
+        .invoke(DataSource, data_q, 10)
+        .invoke(DataSink, data_q, 10);
+    EXPECT_EQ(poller_count, 0);
+  }
+}
+
+// Collects the messages passed to glog.
+class MessageCollector : public google::LogSink {
+ public:
+  void send(google::LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, const struct ::tm* tm_time,
+            const char* message, size_t message_len) override {
+    std::unique_lock lock(this->mtx);
+    this->text.append(message, message_len) += '\n';
+    ++this->count;
+  }
+
+  std::mutex mtx;
+  std::string text;
+  int count = 0;
+};
+
+std::atomic_bool logged_in_coroutine{false};
+
+void LoggingSource(tapa::ostream<int>& data_out_q, int n) {
+  logged_in_coroutine = internal::get_coroutine_name() != nullptr;
+  for (int i = 0; i < n; ++i) {
+    LOG(INFO) << "writing " << i;
+    data_out_q.write(i);
+  }
+}
+
+// Messages of coroutines are tagged and passed to glog in batches.
+TEST(TaskTest, LoggingInCoroutinesKeepsAllMessages) {
+  MessageCollector collector;
+  google::AddLogSink(&collector);
+  {
+    tapa::stream<int, 2> data_q;
+    tapa::task()
+        .invoke(LoggingSource, "source", data_q, kN)
+        .invoke(DataSink, data_q, kN);
+  }
+  google::RemoveLogSink(&collector);
+
+  for (int i = 0; i < kN; ++i) {
+    const std::string line = "writing " + std::to_string(i) + "\n";
+    ASSERT_NE(collector.text.find(line), std::string::npos) << line;
+  }
+  if (logged_in_coroutine) {
+    EXPECT_NE(collector.text.find("/0] writing 0\n"), std::string::npos);
+    EXPECT_LT(collector.count, kN);
+  }
+}
+
+#endif  // TAPA_ENABLE_COROUTINE
+
 }  // namespace
 }  // namespace tapa
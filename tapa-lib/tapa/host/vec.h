@@ -14,16 +14,67 @@
 #include <array>
 #include <functional>
 #include <ostream>
+#include <type_traits>
+
+#include <glog/logging.h>
 
 #include "tapa/host/util.h"
 
 namespace tapa {
 
+namespace internal {
+
+// Returns the number of bytes that operations on `vec_t<T, N>` process at a
+// time with compiler vector extensions, or 0 if the operations are done
+// element by element. The vector extensions are lowered to SSE, AVX2, or
+// AVX-512 instructions, depending on the target of the host compiler.
+template <typename T, int N>
+constexpr int simd_bytes() {
+  constexpr bool is_simd_type =
+      std::is_same_v<T, float> || std::is_same_v<T, double> ||
+      std::is_same_v<T, int8_t> || std::is_same_v<T, uint8_t> ||
+      std::is_same_v<T, int16_t> || std::is_same_v<T, uint16_t> ||
+      std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> ||
+      std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>;
+  constexpr int bytes = sizeof(T) * N;
+  if (!is_simd_type || N < 2) return 0;
+  if (bytes % 64 == 0) return 64;
+  if (bytes >= 16 && (bytes & (bytes - 1)) == 0) return bytes;
+  return 0;
+}
+
+// Computes `dst[i] = lhs[i] op rhs[i]` for `i` in `[0, N)` with compiler
+// vector extensions, where `op(dst, lhs, rhs)` applies `op` to vectors. `dst`
+// may alias `lhs` or `rhs`. Vectors are passed by reference, because passing
+// wide vectors by value depends on the instruction set.
+template <typename T, int N, typename Op>
+inline void simd_apply(T* dst, const T* lhs, const T* rhs, const Op& op) {
+  constexpr int kBytes = simd_bytes<T, N>();
+  typedef T simd_t __attribute__((vector_size(kBytes)));
+  for (int i = 0; i < int(sizeof(T)) * N; i += kBytes) {
+    simd_t lhs_simd;
+    simd_t rhs_simd;
+    std::memcpy(&lhs_simd, reinterpret_cast<const char*>(lhs) + i, kBytes);
+    std::memcpy(&rhs_simd, reinterpret_cast<const char*>(rhs) + i, kBytes);
+    simd_t dst_simd;
+    op(dst_simd, lhs_simd, rhs_simd);
+    std::memcpy(reinterpret_cast<char*>(dst) + i, &dst_simd, kBytes);
+  }
+}
+
+}  // namespace internal
+
 template <typename T, int N>
 struct vec_t : protected std::array<T, N> {
  private:
   using base_type = std::array<T, N>;
 
+  // Whether operations with `vec_t<T2, N>` can use vector extensions.
+  template <typename T2>
+  static constexpr bool is_simd_operand() {
+    return std::is_same_v<T, T2> && internal::simd_bytes<T, N>() > 0;
+  }
+
  public:
   // static constexpr metadata
   static constexpr int length = N;
@@ -79,32 +130,45 @@ struct vec_t : protected std::array<T, N> {
     return *this;
   }
 
-// assignment operators
-#define DEFINE_OP(op)                                    \
-  template <typename T2>                                 \
-  vec_t<T, N>& operator op##=(const vec_t<T2, N>& rhs) { \
-    for (size_type i = 0; i < N; ++i) {                  \
-      set(i, get(i) op rhs[i]);                          \
-    }                                                    \
-    return *this;                                        \
-  }                                                      \
-  template <typename T2>                                 \
-  vec_t<T, N>& operator op##=(const T2 & rhs) {          \
-    for (size_type i = 0; i < N; ++i) {                  \
-      set(i, get(i) op rhs);                             \
-    }                                                    \
-    return *this;                                        \
+// assignment operators; operators that are `simd` use vector extensions if
+// both operands are vectors of `T`
+#define DEFINE_OP(op, simd)                                            \
+  template <typename T2>                                               \
+  vec_t<T, N>& operator op##=(const vec_t<T2, N>& rhs) {               \
+    if constexpr ((simd) && is_simd_operand<T2>()) {                   \
+      internal::simd_apply<T, N>(                                      \
+          this->data(), this->data(), rhs.data(),                      \
+          [](auto& dst, auto& a, auto& b) { dst = a op b; });          \
+    } else {                                                           \
+      for (size_type i = 0; i < N; ++i) {                              \
+        set(i, get(i) op rhs[i]);                                      \
+      }                                                                \
+    }                                                                  \
+    return *this;                                                      \
+  }                                                                    \
+  template <typename T2>                                               \
+  vec_t<T, N>& operator op##=(const T2 & rhs) {                        \
+    if constexpr ((simd) && is_simd_operand<T2>()) {                   \
+      vec_t<T, N> rhs_vec;                                             \
+      rhs_vec.set(rhs);                                                \
+      *this op## = rhs_vec;                                            \
+    } else {                                                           \
+      for (size_type i = 0; i < N; ++i) {                              \
+        set(i, get(i) op rhs);                                         \
+      }                                                                \
+    }                                                                  \
+    return *this;                                                      \
   }
-  DEFINE_OP(+)
-  DEFINE_OP(-)
-  DEFINE_OP(*)
-  DEFINE_OP(/)
-  DEFINE_OP(%)
-  DEFINE_OP(&)
-  DEFINE_OP(|)
-  DEFINE_OP(^)
-  DEFINE_OP(<<)
-  DEFINE_OP(>>)
+  DEFINE_OP(+, true)
+  DEFINE_OP(-, true)
+  DEFINE_OP(*, true)
+  DEFINE_OP(/, std::is_floating_point_v<T>)
+  DEFINE_OP(%, false)
+  DEFINE_OP(&, true)
+  DEFINE_OP(|, true)
+  DEFINE_OP(^, true)
+  DEFINE_OP(<<, false)
+  DEFINE_OP(>>, false)
 #undef DEFINE_OP
 
 // unary arithemetic operators
@@ -124,19 +188,13 @@ struct vec_t : protected std::array<T, N> {
 #define DEFINE_OP(op)                                \
   template <typename T2>                             \
   vec_t<T, N> operator op(const vec_t<T2, N>& rhs) { \
-    vec_t<T, N> result;                              \
-    for (size_type i = 0; i < N; ++i) {              \
-      result.set(i, get(i) op rhs[i]);               \
-    }                                                \
-    return result;                                   \
+    vec_t<T, N> result = *this;                      \
+    return result op## = rhs;                        \
   }                                                  \
   template <typename T2>                             \
   vec_t<T, N> operator op(const T2 & rhs) {          \
-    vec_t<T, N> result;                              \
-    for (size_type i = 0; i < N; ++i) {              \
-      result.set(i, get(i) op rhs);                  \
-    }                                                \
-    return result;                                   \
+    vec_t<T, N> result = *this;                      \
+    return result op## = rhs;                        \
   }
   DEFINE_OP(+)
   DEFINE_OP(-)
@@ -168,15 +226,16 @@ struct vec_t : protected std::array<T, N> {
   }
 };
 
+// Helpers below copy contiguous elements, which compile to vector moves and
+// shuffles for trivially copyable `T`.
+
 // return vec[begin:end]
 template <int begin, int end, typename T, int N>
 inline vec_t<T, end - begin> truncated(const vec_t<T, N>& vec) {
   static_assert(begin >= 0, "cannot truncate before 0");
   static_assert(end <= N, "cannot truncate after N");
   vec_t<T, end - begin> result;
-  for (int i = 0; i < end - begin; ++i) {
-    result.set(i, vec[begin + i]);
-  }
+  std::copy_n(&vec[begin], end - begin, &result[0]);
   return result;
 }
 
@@ -194,9 +253,7 @@ inline vec_t<T, length> truncated(const vec_t<T, N>& vec, int begin) {
   CHECK_GE(begin, 0) << "cannot truncate before 0";
   CHECK_LE(end, N) << "cannot truncate after N";
   vec_t<T, length> result;
-  for (int i = 0; i < length; ++i) {
-    result.set(i, vec[begin + i]);
-  }
+  std::copy_n(&vec[begin], length, &result[0]);
   return result;
 }
 
@@ -204,9 +261,7 @@ inline vec_t<T, length> truncated(const vec_t<T, N>& vec, int begin) {
 template <typename T, int N>
 inline vec_t<T, N + 1> cat(const vec_t<T, N>& vec, const T& val) {
   vec_t<T, N + 1> result;
-  for (int i = 0; i < N; ++i) {
-    result.set(i, vec[i]);
-  }
+  std::copy_n(&vec[0], N, &result[0]);
   result.set(N, val);
   return result;
 }
@@ -216,9 +271,7 @@ template <typename T, int N>
 inline vec_t<T, N + 1> cat(const T& val, const vec_t<T, N>& vec) {
   vec_t<T, N + 1> result;
   result.set(0, val);
-  for (int i = 0; i < N; ++i) {
-    result.set(i + 1, vec[i]);
-  }
+  std::copy_n(&vec[0], N, &result[1]);
   return result;
 }
 
@@ -226,12 +279,8 @@ inline vec_t<T, N + 1> cat(const T& val, const vec_t<T, N>& vec) {
 template <typename T, int N1, int N2>
 inline vec_t<T, N1 + N2> cat(const vec_t<T, N1>& v1, const vec_t<T, N2>& v2) {
   vec_t<T, N1 + N2> result;
-  for (int i = 0; i < N1; ++i) {
-    result.set(i, v1[i]);
-  }
-  for (int i = 0; i < N2; ++i) {
-    result.set(i + N1, v2[i]);
-  }
+  std::copy_n(&v1[0], N1, &result[0]);
+  std::copy_n(&v2[0], N2, &result[N1]);
   return result;
 }
 
@@ -0,0 +1,60 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "tapa/host/vec.h"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+namespace tapa {
+namespace {
+
+static_assert(internal::simd_bytes<float, 16>() == 64);
+static_assert(internal::simd_bytes<int8_t, 128>() == 64);
+static_assert(internal::simd_bytes<int16_t, 8>() == 16);
+static_assert(internal::simd_bytes<int32_t, 3>() == 0);
+static_assert(internal::simd_bytes<bool, 64>() == 0);
+
+TEST(VecTest, FloatOperationsMatchElementWiseResults) {
+  vec_t<float, 16> lhs;
+  vec_t<float, 16> rhs;
+  for (int i = 0; i < 16; ++i) {
+    lhs.set(i, i * 1.5f);
+    rhs.set(i, i + 1.f);
+  }
+  const vec_t<float, 16> sum = lhs + rhs;
+  const vec_t<float, 16> quotient = lhs / rhs;
+  const vec_t<float, 16> scaled = lhs * 2.f;
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(sum[i], lhs[i] + rhs[i]);
+    EXPECT_EQ(quotient[i], lhs[i] / rhs[i]);
+    EXPECT_EQ(scaled[i], lhs[i] * 2.f);
+  }
+}
+
+TEST(VecTest, NarrowIntegerOperationsWrapAround) {
+  vec_t<int8_t, 64> lhs;
+  lhs.set(int8_t(100));
+  vec_t<int8_t, 64> rhs;
+  rhs.set(int8_t(50));
+  lhs += rhs;
+  EXPECT_EQ(lhs[0], int8_t(150));
+  EXPECT_EQ((lhs ^ rhs)[63], int8_t(int8_t(150) ^ 50));
+  // Operands of other types are converted element by element.
+  EXPECT_EQ((rhs * 2.5)[7], int8_t(125));
+}
+
+TEST(VecTest, CatAndTruncatedPreserveOrder) {
+  vec_t<int, 8> vec;
+  for (int i = 0; i < 8; ++i) vec.set(i, i);
+  const vec_t<int, 8> swapped = cat(truncated<4, 8>(vec), truncated<4>(vec));
+  for (int i = 0; i < 8; ++i) EXPECT_EQ(swapped[i], (i + 4) % 8);
+  EXPECT_EQ(cat(-1, vec)[1], 0);
+  EXPECT_EQ(cat(vec, 8)[8], 8);
+  EXPECT_EQ((truncated<2>(vec, 3)[1]), 4);
+}
+
+}  // namespace
+}  // namespace tapa
@@ -0,0 +1,312 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+//
+// Synthesizable stream-routing primitives. Each function forwards up to one
+// element per output per cycle and is meant to be the whole body of a leaf
+// task, e.g.,
+//
+//   void Merge(tapa::istreams<pkt_t, 4>& in, tapa::ostream<pkt_t>& out) {
+//     tapa::merge(in, out);
+//   }
+//
+// All of them run until every input reaches EoT, and then close each output.
+//
+// To replicate a task for throughput, split its input among N instances with
+// @c distribute and gather their outputs in the same order with @c collect:
+//
+//   void Parallel(tapa::istream<pkt_t>& in, tapa::ostream<pkt_t>& out) {
+//     tapa::streams<pkt_t, 4> in_q("in_q");
+//     tapa::streams<pkt_t, 4> out_q("out_q");
+//     tapa::task()
+//         .invoke(Distribute, in, in_q)
+//         .invoke<tapa::join, 4>(Compute, in_q, out_q)
+//         .invoke(Collect, out_q, out);
+//   }
+//
+// If the order of the outputs does not matter, use @c balance and @c merge
+// instead, which let the instances that are ready take more elements.
+
+#ifndef TAPA_STREAM_UTIL_H_
+#define TAPA_STREAM_UTIL_H_
+
+#include <cstdint>
+
+#include "tapa.h"
+
+namespace tapa {
+
+namespace internal {
+
+// Returns the first of `candidates` at or after `next` in round-robin order,
+// or -1 if there is none.
+template <uint64_t N>
+inline int round_robin(const bool (&candidates)[N], int next) {
+#pragma HLS inline
+  constexpr int kN = N;
+  int chosen = -1;
+  for (int k = kN - 1; k >= 0; --k) {
+#pragma HLS unroll
+    const int i = next + k < kN ? next + k : next + k - kN;
+    if (candidates[i]) chosen = i;
+  }
+  return chosen;
+}
+
+}  // namespace internal
+
+/// Forwards elements of @c in to @c out, taking turns among the inputs that
+/// have data in round-robin order.
+template <uint64_t N, typename T>
+inline void merge(istreams<T, N>& in, ostream<T>& out) {
+  constexpr int kN = N;
+  bool is_done[N];
+#pragma HLS array_partition variable = is_done complete
+  for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+    is_done[i] = false;
+  }
+
+  int next = 0;  // Input with the highest priority.
+  for (int n_done = 0; n_done < kN;) {
+#pragma HLS pipeline II = 1
+    bool is_valid[N];
+    bool is_eot[N];
+    T elems[N];
+    for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+      elems[i] = in[i].peek(is_valid[i], is_eot[i]);
+      is_valid[i] = is_valid[i] && !is_done[i];
+    }
+
+    const int chosen = internal::round_robin(is_valid, next);
+    for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+      if (i != chosen) continue;
+      if (is_eot[i]) {
+        in[i].try_open();
+        is_done[i] = true;
+        ++n_done;
+      } else if (out.try_write(elems[i])) {
+        in[i].read(nullptr);
+        next = i + 1 < kN ? i + 1 : 0;
+      }
+    }
+  }
+  out.close();
+}
+
+/// Forwards each element of @c in to `out[key(elem)]`, which must be in
+/// `[0, N)`.
+template <uint64_t N, typename T, typename KeyFunc>
+inline void demux(istream<T>& in, ostreams<T, N>& out, KeyFunc key) {
+  constexpr int kN = N;
+  for (bool is_done = false; !is_done;) {
+#pragma HLS pipeline II = 1
+    bool is_valid, is_eot;
+    const T elem = in.peek(is_valid, is_eot);
+    if (is_valid && is_eot) {
+      in.try_open();
+      is_done = true;
+    } else if (is_valid) {
+      const int dst = key(elem);
+      bool is_written = false;
+      for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+        if (i == dst) is_written = out[i].try_write(elem);
+      }
+      if (is_written) in.read(nullptr);
+    }
+  }
+  for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+    out[i].close();
+  }
+}
+
+/// Forwards each element of @c in to `out[key(elem)]`, which must be in
+/// `[0, M)`. Each output takes turns among the inputs heading to it in
+/// round-robin order, so that all outputs may be written in the same cycle.
+/// Elements from the same input keep their order.
+template <uint64_t N, uint64_t M, typename T, typename KeyFunc>
+inline void crossbar(istreams<T, N>& in, ostreams<T, M>& out, KeyFunc key) {
+  constexpr int kN = N;
+  constexpr int kM = M;
+  bool is_done[N];
+#pragma HLS array_partition variable = is_done complete
+  for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+    is_done[i] = false;
+  }
+  int next[M];  // Input with the highest priority of each output.
+#pragma HLS array_partition variable = next complete
+  for (int j = 0; j < kM; ++j) {
+#pragma HLS unroll
+    next[j] = 0;
+  }
+
+  for (int n_done = 0; n_done < kN;) {
+#pragma HLS pipeline II = 1
+    bool is_valid[N];
+    bool is_eot[N];
+    T elems[N];
+    int dsts[N];
+    bool is_read[N];
+    for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+      elems[i] = in[i].peek(is_valid[i], is_eot[i]);
+      is_valid[i] = is_valid[i] && !is_done[i];
+      dsts[i] = is_valid[i] && !is_eot[i] ? key(elems[i]) : -1;
+      is_read[i] = false;
+    }
+
+    for (int j = 0; j < kM; ++j) {
+#pragma HLS unroll
+      bool is_candidate[N];
+      for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+        is_candidate[i] = dsts[i] == j;
+      }
+      const int chosen = internal::round_robin(is_candidate, next[j]);
+      for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+        if (i == chosen && out[j].try_write(elems[i])) {
+          is_read[i] = true;
+          next[j] = i + 1 < kN ? i + 1 : 0;
+        }
+      }
+    }
+
+    for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+      if (is_read[i]) {
+        in[i].read(nullptr);
+      } else if (is_valid[i] && is_eot[i]) {
+        in[i].try_open();
+        is_done[i] = true;
+        ++n_done;
+      }
+    }
+  }
+  for (int j = 0; j < kM; ++j) {
+#pragma HLS unroll
+    out[j].close();
+  }
+}
+
+/// Forwards the @c k-th element of @c in to `out[k % N]`, so that @c collect
+/// restores the order of the elements from the same outputs.
+template <uint64_t N, typename T>
+inline void distribute(istream<T>& in, ostreams<T, N>& out) {
+  constexpr int kN = N;
+  int next = 0;  // Output of the next element.
+  for (bool is_done = false; !is_done;) {
+#pragma HLS pipeline II = 1
+    bool is_valid, is_eot;
+    const T elem = in.peek(is_valid, is_eot);
+    if (is_valid && is_eot) {
+      in.try_open();
+      is_done = true;
+    } else if (is_valid) {
+      bool is_written = false;
+      for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+        if (i == next) is_written = out[i].try_write(elem);
+      }
+      if (is_written) {
+        in.read(nullptr);
+        next = next + 1 < kN ? next + 1 : 0;
+      }
+    }
+  }
+  for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+    out[i].close();
+  }
+}
+
+/// Forwards each element of @c in to the first output at or after the last
+/// written one in round-robin order that is not full, so that slow consumers
+/// receive fewer elements. Use @c merge to gather the results in any order.
+template <uint64_t N, typename T>
+inline void balance(istream<T>& in, ostreams<T, N>& out) {
+  constexpr int kN = N;
+  int next = 0;  // Output with the highest priority.
+  for (bool is_done = false; !is_done;) {
+#pragma HLS pipeline II = 1
+    bool is_valid, is_eot;
+    const T elem = in.peek(is_valid, is_eot);
+    if (is_valid && is_eot) {
+      in.try_open();
+      is_done = true;
+    } else if (is_valid) {
+      bool is_ready[N];
+      for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+        is_ready[i] = !out[i].full();
+      }
+      const int chosen = internal::round_robin(is_ready, next);
+      bool is_written = false;
+      for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+        if (i == chosen) is_written = out[i].try_write(elem);
+      }
+      if (is_written) {
+        in.read(nullptr);
+        next = chosen + 1 < kN ? chosen + 1 : 0;
+      }
+    }
+  }
+  for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+    out[i].close();
+  }
+}
+
+/// Forwards the @c k-th element of `in[k % N]` to @c out, i.e., the inverse
+/// of @c distribute, until the input to read next reaches EoT. The remaining
+/// inputs are then drained until they reach EoT, too.
+template <uint64_t N, typename T>
+inline void collect(istreams<T, N>& in, ostream<T>& out) {
+  constexpr int kN = N;
+  bool is_done[N];
+#pragma HLS array_partition variable = is_done complete
+  for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+    is_done[i] = false;
+  }
+
+  int next = 0;  // Input of the next element.
+  bool is_ordered = true;  // Whether no input to read has reached EoT.
+  for (int n_done = 0; n_done < kN;) {
+#pragma HLS pipeline II = 1
+    bool is_valid[N];
+    bool is_eot[N];
+    T elems[N];
+    for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+      elems[i] = in[i].peek(is_valid[i], is_eot[i]);
+    }
+
+    for (int i = 0; i < kN; ++i) {
+#pragma HLS unroll
+      if (!is_valid[i] || is_done[i]) continue;
+      if (is_eot[i]) {
+        in[i].try_open();
+        is_done[i] = true;
+        ++n_done;
+        if (i == next) is_ordered = false;
+      } else if (!is_ordered) {
+        in[i].read(nullptr);
+      } else if (i == next && out.try_write(elems[i])) {
+        in[i].read(nullptr);
+        next = next + 1 < kN ? next + 1 : 0;
+      }
+    }
+  }
+  out.close();
+}
+
+}  // namespace tapa
+
+#endif  // TAPA_STREAM_UTIL_H_
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <type_traits>
 
 #include "tapa/base/mmap.h"
 #include "tapa/stub/stream.h"
@@ -52,6 +54,13 @@ class ommap : public mmap<T> {
 };
 
 template <typename T>
+void load(const mmap<T>& mem, int64_t offset, std::remove_const_t<T>* dst,
+          int64_t n);
+
+template <typename T>
+void store(const mmap<T>& mem, int64_t offset, const T* src, int64_t n);
+
+template <typename T, typename Config = async_mmap_config<>>
 struct async_mmap : public mmap<T> {
  public:
   using addr_t = int64_t;
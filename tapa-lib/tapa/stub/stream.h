@@ -5,6 +5,7 @@
 #pragma once
 
 #include "tapa/base/stream.h"
+#include "tapa/stub/vec.h"
 
 #include <cstddef>
 #include <cstdint>
@@ -22,8 +23,14 @@ class istream {
   T peek(bool& is_success) const;
   T peek(std::nullptr_t) const;
   T peek(bool& is_success, bool& is_eot) const;
+  const T& peek_ref() const;
   bool try_read(T& value);
   T read();
+  void read_n(T* values, size_t n);
+  template <typename U = T, int kLength = U::length>
+  void read_n(typename U::value_type* values, size_t n);
+  size_t try_read_up_to(T* values, size_t n);
+  size_t read_transaction(T* values, size_t n);
   istream& operator>>(T& value);
   T read(bool& is_success);
   T read(std::nullptr_t);
@@ -38,6 +45,12 @@ class ostream {
   bool full() const;
   bool try_write(const T& value);
   void write(const T& value);
+  void write(T&& value);
+  void write_n(const T* values, size_t n);
+  template <typename U = T, int kLength = U::length>
+  void write_n(const typename U::value_type* values, size_t n);
+  size_t try_write_up_to(const T* values, size_t n);
+  void write_transaction(const T* values, size_t n);
   ostream& operator<<(const T& value);
   bool try_close();
   void close();
@@ -58,6 +71,8 @@ class istreams {
  public:
   constexpr static int length = S;
   istream<T> operator[](int pos) const;
+  bool try_read_vec(vec_t<T, S>& values);
+  vec_t<T, S> read_vec();
 };
 
 template <typename T, uint64_t S>
@@ -65,6 +80,8 @@ class ostreams {
  public:
   constexpr static int length = S;
   ostream<T> operator[](int pos) const;
+  bool try_write_vec(const vec_t<T, S>& values);
+  void write_vec(const vec_t<T, S>& values);
 };
 
 template <typename T, uint64_t S, uint64_t N = kStreamDefaultDepth,
@@ -79,4 +96,15 @@ class streams : public istreams<T, S>, public ostreams<T, S> {
   stream<T, N> operator[](int pos) const;
 };
 
+template <typename T, uint64_t S, uint64_t N = kStreamDefaultDepth,
+          uint64_t SimulationDepth = N>
+class broadcast_stream {
+ public:
+  constexpr static int length = S;
+  constexpr static int depth = N;
+  broadcast_stream();
+  template <size_t name_length>
+  broadcast_stream(const char (&name)[name_length]);
+};
+
 }  // namespace tapa
@@ -6,6 +6,9 @@
 #define TAPA_XILINX_HLS_MMAP_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 #include "tapa/base/mmap.h"
 #include "tapa/xilinx/hls/stream.h"
@@ -50,7 +53,28 @@ class addr_ostream {
 template <typename T>
 using mmap = T*;
 
+/// Copies elements @c offset to `offset + n - 1` of @c mem to @c dst.
+///
+/// Synthesized as a `memcpy`, which Vitis HLS turns into a burst.
 template <typename T>
+inline void load(const mmap<T>& mem, int64_t offset,
+                 std::remove_const_t<T>* dst, int64_t n) {
+#pragma HLS inline
+  memcpy(dst, mem + offset, n * sizeof(T));
+}
+
+/// Copies @c n elements from @c src to elements @c offset to
+/// `offset + n - 1` of @c mem.
+///
+/// Synthesized as a `memcpy`, which Vitis HLS turns into a burst.
+template <typename T>
+inline void store(const mmap<T>& mem, int64_t offset, const T* src,
+                  int64_t n) {
+#pragma HLS inline
+  memcpy(mem + offset, src, n * sizeof(T));
+}
+
+template <typename T, typename Config = async_mmap_config<>>
 struct async_mmap {
   using addr_t = int64_t;
   using resp_t = uint8_t;
@@ -13,6 +13,8 @@
 
 #include <hls_stream.h>
 
+#include "tapa/xilinx/hls/vec.h"
+
 namespace tapa {
 
 template <typename T>
@@ -70,6 +72,15 @@ class tapa_stream {
     return val;
   }
 
+  // Hardware has no references to tokens, so the value is returned instead.
+  T peek_ref() const {
+#pragma HLS inline
+    T val;
+    while (!try_peek(val)) {
+    }
+    return val;
+  }
+
   T peek(bool& is_success, bool& is_eot) const {
 #pragma HLS inline
     internal::elem_t<T> peek_val;
@@ -91,6 +102,58 @@ class tapa_stream {
     return _.read().val;
   }
 
+  void read_n(T* values, size_t n) {
+#pragma HLS inline
+    for (size_t i = 0; i < n; ++i) {
+#pragma HLS pipeline II = 1
+      values[i] = read();
+    }
+  }
+
+  size_t try_read_up_to(T* values, size_t n) {
+#pragma HLS inline
+    size_t count = 0;
+    for (bool is_eot; count < n && try_eot(is_eot) && !is_eot; ++count) {
+#pragma HLS pipeline II = 1
+      values[count] = read();
+    }
+    return count;
+  }
+
+  // Transactions use the same EoT tokens as `open` and `close`.
+  size_t read_transaction(T* values, size_t n) {
+#pragma HLS inline
+    static_assert(internal::has_eot_v<T>,
+                  "streams of tapa::no_eot elements have no EoT tokens");
+    size_t count = 0;
+    for (bool is_eot = false; !is_eot;) {
+#pragma HLS pipeline II = 1
+      const internal::elem_t<T> elem = _.read();
+      is_eot = elem.eot;
+      if (!is_eot) {
+        assert(count < n);
+        values[count++] = elem.val;
+      }
+    }
+    return count;
+  }
+
+  // Vector tokens carry `T::length` elements each, so reading elements one
+  // token per cycle uses the full width of the stream.
+  template <typename U = T, int kLength = U::length>
+  void read_n(typename U::value_type* values, size_t n) {
+#pragma HLS inline
+    assert(n % kLength == 0);
+    for (size_t i = 0; i < n / kLength; ++i) {
+#pragma HLS pipeline II = 1
+      const T token = read();
+      for (int j = 0; j < kLength; ++j) {
+#pragma HLS unroll
+        values[i * kLength + j] = token[j];
+      }
+    }
+  }
+
   tapa_stream& operator>>(T& value) {
 #pragma HLS inline
     value = read();
@@ -123,6 +186,8 @@ class tapa_stream {
 
   bool try_open() {
 #pragma HLS inline
+    static_assert(internal::has_eot_v<T>,
+                  "streams of tapa::no_eot elements have no EoT tokens");
     internal::elem_t<T> elem;
     const bool succeeded = _.read_nb(elem);
     assert(!succeeded || elem.eot);
@@ -131,6 +196,8 @@ class tapa_stream {
 
   void open() {
 #pragma HLS inline
+    static_assert(internal::has_eot_v<T>,
+                  "streams of tapa::no_eot elements have no EoT tokens");
     const auto elem = _.read();
     assert(elem.eot);
   }
@@ -150,6 +217,44 @@ class tapa_stream {
     _.write({value, false});
   }
 
+  void write_n(const T* values, size_t n) {
+#pragma HLS inline
+    for (size_t i = 0; i < n; ++i) {
+#pragma HLS pipeline II = 1
+      write(values[i]);
+    }
+  }
+
+  void write_transaction(const T* values, size_t n) {
+#pragma HLS inline
+    write_n(values, n);
+    close();
+  }
+
+  template <typename U = T, int kLength = U::length>
+  void write_n(const typename U::value_type* values, size_t n) {
+#pragma HLS inline
+    assert(n % kLength == 0);
+    for (size_t i = 0; i < n / kLength; ++i) {
+#pragma HLS pipeline II = 1
+      T token;
+      for (int j = 0; j < kLength; ++j) {
+#pragma HLS unroll
+        token[j] = values[i * kLength + j];
+      }
+      write(token);
+    }
+  }
+
+  size_t try_write_up_to(const T* values, size_t n) {
+#pragma HLS inline
+    size_t count = 0;
+    for (; count < n && try_write(values[count]); ++count) {
+#pragma HLS pipeline II = 1
+    }
+    return count;
+  }
+
   tapa_stream& operator<<(const T& value) {
 #pragma HLS inline
     write(value);
@@ -158,6 +263,8 @@ class tapa_stream {
 
   bool try_close() {
 #pragma HLS inline
+    static_assert(internal::has_eot_v<T>,
+                  "streams of tapa::no_eot elements have no EoT tokens");
     internal::elem_t<T> elem;
     memset(&elem.val, 0, sizeof(elem.val));
     elem.eot = true;
@@ -166,6 +273,8 @@ class tapa_stream {
 
   void close() {
 #pragma HLS inline
+    static_assert(internal::has_eot_v<T>,
+                  "streams of tapa::no_eot elements have no EoT tokens");
     internal::elem_t<T> elem;
     elem.eot = true;
     _.write(elem);
@@ -199,6 +308,68 @@ template <typename T, uint64_t S, uint64_t N = kStreamDefaultDepth,
           uint64_t SimulationDepth = N>
 using streams = stream<T, N>[S];
 
+namespace internal {
+
+// Arrays of streams have no member functions in HLS, so tapacc rewrites
+// `in_q.read_vec()` on `tapa::istreams` to `tapa::internal::read_vec(in_q)`
+// and so on. Each accesses all FIFOs in parallel in the same cycle.
+
+template <typename T, int S>
+bool try_read_vec(istream<T> (&streams)[S], vec_t<T, S>& values) {
+#pragma HLS inline
+  bool is_ready = true;
+  for (int i = 0; i < S; ++i) {
+#pragma HLS unroll
+    is_ready &= !streams[i].empty();
+  }
+  if (is_ready) {
+    for (int i = 0; i < S; ++i) {
+#pragma HLS unroll
+      values.set(i, streams[i].read());
+    }
+  }
+  return is_ready;
+}
+
+template <typename T, int S>
+vec_t<T, S> read_vec(istream<T> (&streams)[S]) {
+#pragma HLS inline
+  vec_t<T, S> values;
+  for (int i = 0; i < S; ++i) {
+#pragma HLS unroll
+    values.set(i, streams[i].read());
+  }
+  return values;
+}
+
+template <typename T, int S>
+bool try_write_vec(ostream<T> (&streams)[S], const vec_t<T, S>& values) {
+#pragma HLS inline
+  bool is_ready = true;
+  for (int i = 0; i < S; ++i) {
+#pragma HLS unroll
+    is_ready &= !streams[i].full();
+  }
+  if (is_ready) {
+    for (int i = 0; i < S; ++i) {
+#pragma HLS unroll
+      streams[i].write(values[i]);
+    }
+  }
+  return is_ready;
+}
+
+template <typename T, int S>
+void write_vec(ostream<T> (&streams)[S], const vec_t<T, S>& values) {
+#pragma HLS inline
+  for (int i = 0; i < S; ++i) {
+#pragma HLS unroll
+    streams[i].write(values[i]);
+  }
+}
+
+}  // namespace internal
+
 }  // namespace tapa
 
 #endif  // TAPA_XILINX_HLS_STREAM_H_
@@ -6,6 +6,13 @@
 
 "use strict";
 
+import {
+  clearStats,
+  getBusyFraction,
+  getHeatColor,
+  getStallFraction,
+  setStats,
+} from "./stats.js";
 import { sidebarContainers, updateSidebar } from "./sidebar.js";
 import { getGraphData } from "./praser.js";
 
@@ -21,6 +28,33 @@ export const getComboName = comboId => comboId.replace(/^combo:/, "");
 /** @type {GraphJSON} */
 let graphJson;
 
+// Default colors of the light theme, used without statistics.
+const defaultNodeFill = "#1783FF";
+const defaultEdgeStroke = "#99ADD1";
+
+/** Top-level ports bound to `node`, which fast cosim reports statistics of.
+ *  @type {(node: import("@antv/g6").NodeData) => string[]} */
+export const getNodePorts = node => {
+  // Instances may be in a combo of their own in the top-level task's combo.
+  const top = graphJson && `combo:${graphJson.top}`;
+  if (!top || !(node.combo === top || node.combo?.startsWith(`${top}/`))) {
+    return [];
+  }
+  const subTasks = /** @type {SubTask[] | undefined} */ (node.data?.subTasks)
+    ?? [/** @type {SubTask} */ (node.data)];
+  return subTasks.flatMap(
+    subTask => Object.values(subTask?.args ?? {}).map(({ arg }) => arg)
+  );
+};
+
+/** @type {(node: import("@antv/g6").NodeData) => number | undefined} */
+const getNodeBusyFraction = node =>
+  getBusyFraction(String(node.id), getNodePorts(node));
+
+/** @type {(edge: import("@antv/g6").EdgeData) => number | undefined} */
+const getEdgeStallFraction = edge =>
+  getStallFraction(/** @type {string[] | undefined} */ (edge.data?.fifos) ?? []);
+
 /** Data for G6.Graph()
  * @type {GraphData} */
 let graphData = {
@@ -42,41 +76,81 @@ if (fileInput === null) {
   throw new TypeError("Element input.fileInput not found!");
 }
 
-/** @param {import("@antv/g6").Graph} graph */
-const setupFileInput = (graph) => {
-  const reader = new FileReader();
-  reader.addEventListener("load", e => {
-    const result = e.target?.result;
-    if (typeof result !== "string") return;
+/** Graphs with more nodes than this are drawn without animations and edge
+ *  labels, which dominate the drawing time of big graphs. */
+const maxDetailedNodes = 1000;
 
-    const flat = grouping?.elements.grouping.value === "flat";
+/** Whether the graph has more than `maxDetailedNodes` nodes. */
+let isLarge = false;
 
-    /** @satisfies {GraphJSON} */
-    // eslint-disable-next-line @typescript-eslint/no-unsafe-assignment
-    graphJson = JSON.parse(result);
-    graphData = getGraphData(graphJson, flat);
+/** Builds the graph from `graphJson` with the selected grouping and renders it.
+ *  @param {import("@antv/g6").Graph} graph */
+const renderGraphJson = (graph) => {
+  const flat = grouping?.elements.grouping.value === "flat";
+  graphData = getGraphData(graphJson, flat);
+  console.debug("graphData\n", graphData);
 
-    console.debug("graph.json\n", graphJson);
-    console.debug("graphData\n", graphData);
+  isLarge = graphData.nodes.length > maxDetailedNodes;
+  graph.setOptions({ animation: isLarge ? false : { duration: 250 } });
+  graph.setData(graphData);
+  void graph.render();
 
-    graph.setData(graphData);
-    void graph.render();
+  // render twice for medium-sized graphs
+  // (large enough for a better 2nd render, small enough for performance)
+  graphData.nodes.length > 50 && !isLarge && void graph.render();
+};
 
-    // render twice for medium-sized graphs
-    // (large enough for a better 2nd render, small enough for performance)
-    graphData.nodes.length > 50 &&
-    graphData.nodes.length < 1000 &&
-    void graph.render();
+/** @param {import("@antv/g6").Graph} graph */
+const setupFileInput = (graph) => {
+  // graph.json is parsed in a worker, which keeps the page responsive while
+  // big files load.
+  const worker = new Worker(new URL("./worker.js", import.meta.url));
+  worker.addEventListener("message", ({ data }) => {
+    /** @type {{ json?: GraphJSON, error?: string }} */
+    const { json, error } = data;
+    if (json === undefined) {
+      console.error("failed to parse graph.json:", error);
+      return;
+    }
+    graphJson = json;
+    console.debug("graph.json\n", graphJson);
+    renderGraphJson(graph);
   });
 
   const readFile = () => {
     const file = fileInput.files[0];
-    if (file) reader.readAsText(file);
+    if (file) worker.postMessage(file);
   };
   readFile();
   fileInput.addEventListener("change", readFile);
 };
 
+// Stats Input
+
+/** Loads the profile, channel, and port statistics selected, and colors nodes
+ *  by how busy they are and edges by how often they stall.
+ *  @param {import("@antv/g6").Graph} graph */
+const setupStatsInput = (graph) => {
+  /** @satisfies {HTMLInputElement & { files: FileList } | null} */
+  const statsInput = document.querySelector("input.statsInput");
+  if (statsInput === null) return;
+
+  const readFiles = async () => {
+    clearStats();
+    for (const file of statsInput.files) {
+      /** @type {unknown} */
+      const json = JSON.parse(await file.text());
+      const kind = setStats(json);
+      kind
+        ? console.debug(`${kind} from ${file.name}\n`, json)
+        : console.warn(`${file.name} is not a recognized report`);
+    }
+    graphData.nodes.length > 0 && void graph.draw();
+  };
+  void readFiles();
+  statsInput.addEventListener("change", () => void readFiles());
+};
+
 // Buttons
 
 /** @param {import("@antv/g6").Graph} graph */
@@ -125,14 +199,29 @@ const setupGraphButtons = (graph) => {
     // https://g6.antv.antgroup.com/api/elements/nodes/base-node
     node: {
       style: {
-        labelText: node => node.id,
+        fill: node => {
+          const busy = getNodeBusyFraction(node);
+          return busy === undefined ? defaultNodeFill : getHeatColor(busy);
+        },
+        labelText: node => {
+          const busy = getNodeBusyFraction(node);
+          return busy === undefined
+            ? node.id
+            : `${node.id} (${(busy * 100).toFixed(0)}%)`;
+        },
       },
     },
     edge: {
       style: {
         endArrow: true,
+        stroke: edge => {
+          const stall = getEdgeStallFraction(edge);
+          return stall === undefined ? defaultEdgeStroke : getHeatColor(stall);
+        },
+        lineWidth: edge => getEdgeStallFraction(edge) === undefined ? 1 : 2,
         labelFontFamily: "monospace",
         labelText: ({ id }) => {
+          if (isLarge) return "";
           // Trim the prefix part
           id = id?.slice(id.indexOf("/") + 1);
           // If still very long, then cap each part's length to 15
@@ -152,7 +241,9 @@ const setupGraphButtons = (graph) => {
         labelFontSize: 10,
         labelPlacement: "top",
         strokeWidth: 2,
-        labelText: ({id}) => getComboName(id),
+        labelText: ({ id, data }) => data?.instances
+          ? `${getComboName(id)} (${String(data.instances)} instances)`
+          : getComboName(id),
       }
     },
 
@@ -172,6 +263,8 @@ const setupGraphButtons = (graph) => {
     transforms: ["process-parallel-edges"],
 
     behaviors: [
+      // double click a combo to collapse or expand it
+      "collapse-expand",
       "drag-canvas",
       "zoom-canvas",
       "drag-element",
@@ -212,12 +305,7 @@ const setupGraphButtons = (graph) => {
     for (let i = 0; i < grouping.elements.length; i++) {
       grouping.elements[i].addEventListener("change", ({target}) => {
         if (!(target instanceof HTMLInputElement)) return;
-        if (graphJson) {
-          const flat = target.value === "flat";
-          graphData = getGraphData(graphJson, flat);
-          graph.setData(graphData);
-          void graph.render();
-        }
+        if (graphJson) renderGraphJson(graph);
       })
     }
   }
@@ -228,6 +316,7 @@ const setupGraphButtons = (graph) => {
   );
 
   setupFileInput(graph);
+  setupStatsInput(graph);
   setupGraphButtons(graph);
 
   console.debug("graph object\n", graph);
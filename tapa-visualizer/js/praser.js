@@ -12,6 +12,11 @@ const addToMappedSet = (map, key, value) => {
   set ? set.add(value) : map.set(key, new Set([value]));
 };
 
+/** In the flat view, instances of a task that has more than this many are put
+ *  in a combo of their own, which starts collapsed and expands on double click,
+ *  so that large arrays of tasks do not swamp the layout. */
+const maxExpandedInstances = 16;
+
 /** @type {(json: GraphJSON, flat: boolean) => Required<import("@antv/g6").GraphData>} */
 export const getGraphData = (json, flat = false) => {
 
@@ -41,10 +46,20 @@ export const getGraphData = (json, flat = false) => {
     for (const subTaskName in task.tasks) {
       const subTasks = task.tasks[subTaskName];
       if (flat) {
+        let parent = combo;
+        if (subTasks.length > maxExpandedInstances) {
+          parent = `${combo}/${subTaskName}`;
+          graphData.combos.push({
+            id: parent,
+            combo,
+            data: { instances: subTasks.length },
+            style: { collapsed: true },
+          });
+        }
         subTasks.forEach(
           (subTask, i) => graphData.nodes.push({
             id: `${subTaskName}/${i}`,
-            combo,
+            combo: parent,
             data: subTask,
           })
         );
@@ -87,9 +102,10 @@ export const getGraphData = (json, flat = false) => {
       const matchResult = fifoName.match(/^(.*)\[(\d+)\]$/);
       if (matchResult === null) {
         // Not fifo groups, add edge
-        graphData.edges.push(
-          { source, target, id: `${taskName}/${fifoName}`, data: fifo }
-        );
+        graphData.edges.push({
+          source, target, id: `${taskName}/${fifoName}`,
+          data: { ...fifo, fifos: [fifoName] },
+        });
       } else {
         // add fifo group index
         const name = matchResult[1];
@@ -108,18 +124,25 @@ export const getGraphData = (json, flat = false) => {
         );
       }
       const idWithIndexRange = `${name}[${indexArr[0]}~${indexArr.at(-1)}]`;
-      graphData.edges.push(
-        { source, target, id: `${taskName}/${idWithIndexRange}` }
-      );
+      graphData.edges.push({
+        source, target, id: `${taskName}/${idWithIndexRange}`,
+        data: { fifos: indexArr.map(index => `${name}[${index}]`) },
+      });
     })
 
   }
 
+  /** First node of each task, looked up for each combo
+   *  @type {Map<string, import("@antv/g6").NodeData>} */
+  const firstNodes = new Map();
+  graphData.nodes.forEach(node => {
+    const task = node.id.split("/")[0];
+    firstNodes.has(task) || firstNodes.set(task, node);
+  });
+
   graphData.combos.forEach(combo => {
     if (combo.type === "circle") {
-      const node = graphData.nodes.find(
-        ({id}) => id.split("/")[0] === getComboName(combo.id)
-      );
+      const node = firstNodes.get(getComboName(combo.id));
       if (node) graphData.edges.push(
         { source: combo.id, target: node.id, id: `combo-to-node/${node.id}` }
       );
@@ -4,7 +4,8 @@
  * RapidStream Contributor License Agreement.
  */
 
-import { $, getComboName } from "./graph.js";
+import { $, getComboName, getNodePorts } from "./graph.js";
+import { getPortStats, getStallFraction, profileJson } from "./stats.js";
 
 // sidebar content containers
 export const sidebarContainers = [
@@ -42,6 +43,57 @@ const parseArgs = args => append(
   )
 );
 
+/** Sum of profiles of a flat node (`<task>/<instance>`) or all instances of a
+ *  task (`<task>`).
+ *  @type {(id: string) => TaskProfile[]} */
+const getProfiles = id => profileJson
+  ? Object.entries(profileJson.tasks)
+    .filter(([key, { task }]) => key === id || task === id)
+    .map(([, profile]) => profile)
+  : [];
+
+/** @type {(profiles: TaskProfile[]) => HTMLElement} */
+const parseProfiles = profiles => {
+  /** @type {(key: "resumes" | "run_ns" | "yields" | "empty_yields" | "full_yields") => number} */
+  const sum = key => profiles.reduce((total, profile) => total + profile[key], 0);
+  const wallNs = profileJson?.wall_ns ?? 0;
+  const runMs = sum("run_ns") / 1e6;
+  const share = wallNs > 0 ? ` (${(sum("run_ns") / wallNs * 100).toFixed(1)}%)` : "";
+  return append(
+    $("dd"), append(
+      $("ul"),
+      $("li", { textContent: `Run time: ${runMs.toFixed(3)} ms${share}` }),
+      $("li", { textContent: `Resumes: ${sum("resumes")}` }),
+      $("li", { textContent: `Yields on empty input: ${sum("empty_yields")}` }),
+      $("li", { textContent: `Yields on full output: ${sum("full_yields")}` }),
+      $("li", { textContent: `Other yields: ${sum("yields") - sum("empty_yields") - sum("full_yields")}` }),
+    )
+  );
+};
+
+/** @type {(ports: [string, PortStats][]) => HTMLElement} */
+const parsePortStats = ports => append(
+  $("dd"), append(
+    $("ul"), ...ports.map(
+      ([name, stats]) => $("li", {
+        textContent: `${name}: ${stats.read_beats ?? 0} read beats, ` +
+          `${stats.write_beats ?? 0} write beats, ` +
+          `${(stats.read_data_stall_cycles ?? 0) +
+            (stats.write_data_stall_cycles ?? 0)} data stall cycles`,
+      })
+    )
+  )
+);
+
+/** Stall fraction of `edge` as a suffix of its description, if known.
+ *  @type {(edge: import("@antv/g6").EdgeData) => string} */
+const getStallSuffix = edge => {
+  const stall = getStallFraction(
+    /** @type {string[] | undefined} */ (edge.data?.fifos) ?? []
+  );
+  return stall === undefined ? "" : ` (${(stall * 100).toFixed(1)}% stalled)`;
+};
+
 // Details
 
 /** @type {(node: import("@antv/g6").NodeData) => HTMLDListElement} */
@@ -96,6 +148,21 @@ const getDetailsFromNode = node => {
     console.warn("Selected node is missing data!", node)
   }
 
+  const profiles = getProfiles(String(node.id));
+  if (profiles.length > 0) {
+    dl.append($("dt", { textContent: "Profile" }), parseProfiles(profiles));
+  }
+
+  /** @type {[string, PortStats][]} */
+  const ports = [];
+  for (const port of new Set(getNodePorts(node))) {
+    const stats = getPortStats(port);
+    stats && ports.push([port, stats]);
+  }
+  if (ports.length > 0) {
+    dl.append($("dt", { textContent: "Port Statistics" }), parsePortStats(ports));
+  }
+
   return dl;
 
 };
@@ -130,9 +197,13 @@ const getDetailsFromNode = node => {
 
   connections.replaceChildren(
     $("p", { textContent: "Sources" }),
-    ul(sources.map(edge => $("li", { textContent: `${edge.id} -> ${edge.target}` }))),
+    ul(sources.map(edge => $("li", {
+      textContent: `${edge.id} -> ${edge.target}${getStallSuffix(edge)}`,
+    }))),
     $("p", { textContent: "Targets" }),
-    ul(targets.map(edge => $("li", { textContent: `${edge.id} <- ${edge.source}` }))),
+    ul(targets.map(edge => $("li", {
+      textContent: `${edge.id} <- ${edge.source}${getStallSuffix(edge)}`,
+    }))),
   );
 
   /** @type {Set<string>} */
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+ * All rights reserved. The contributor(s) of this file has/have agreed to the
+ * RapidStream Contributor License Agreement.
+ */
+
+/** Profile report loaded from a software simulation, if any.
+ *  @type {ProfileJSON | undefined} */
+export let profileJson;
+
+/** Channel report loaded from a software simulation, if any.
+ *  @type {ChannelStatsJSON | undefined} */
+export let channelStatsJson;
+
+/** Port statistics loaded from a fast cosim run, if any.
+ *  @type {PortStatsJSON | undefined} */
+export let portStatsJson;
+
+/** Busy fraction of each task and each `<task>/<instance>`.
+ *  @type {Map<string, number>} */
+const busyFractions = new Map();
+
+/** Stall fraction of each channel by name.
+ *  @type {Map<string, number>} */
+const stallFractions = new Map();
+
+/** Fraction of cycles each port of the top-level task moved data.
+ *  @type {Map<string, number>} */
+const portFractions = new Map();
+
+/** @type {(map: Map<string, number>, key: string, value: number) => void} */
+const setMax = (map, key, value) => {
+  map.set(key, Math.max(map.get(key) ?? 0, value));
+};
+
+/** @type {(values: (number | undefined)[]) => number | undefined} */
+const max = values => {
+  const defined = values.filter(value => value !== undefined);
+  return defined.length > 0 ? Math.max(...defined) : undefined;
+};
+
+const updateBusyFractions = () => {
+  busyFractions.clear();
+
+  // Instances of a task are shown as one node by default, which is as busy as
+  // its busiest instance.
+  const wallNs = profileJson?.wall_ns ?? 0;
+  if (profileJson && wallNs > 0) {
+    for (const [key, { task, run_ns }] of Object.entries(profileJson.tasks)) {
+      setMax(busyFractions, key, run_ns / wallNs);
+      setMax(busyFractions, task, run_ns / wallNs);
+    }
+  }
+
+  portFractions.clear();
+  const cycles = portStatsJson?.cycles ?? 0;
+  if (portStatsJson && cycles > 0) {
+    for (const [name, port] of Object.entries(portStatsJson.ports)) {
+      const beats = Math.max(port.read_beats ?? 0, port.write_beats ?? 0);
+      portFractions.set(name, beats / cycles);
+    }
+  }
+};
+
+const updateStallFractions = () => {
+  stallFractions.clear();
+
+  // Fraction of accesses that found the channel full or empty.
+  for (const channel of channelStatsJson?.channels ?? []) {
+    const stalls = channel.full_stalls + channel.empty_stalls;
+    const accesses = channel.pushes + channel.pops + stalls;
+    setMax(stallFractions, channel.name, accesses > 0 ? stalls / accesses : 0);
+  }
+};
+
+/** Loads a report, and returns what it is, or `undefined` if unrecognized.
+ *  @param {unknown} json */
+export const setStats = json => {
+  if (typeof json !== "object" || json === null) return undefined;
+  if ("tasks" in json && "wall_ns" in json) {
+    profileJson = /** @type {ProfileJSON} */ (json);
+    updateBusyFractions();
+    return "profile";
+  }
+  if ("channels" in json) {
+    channelStatsJson = /** @type {ChannelStatsJSON} */ (json);
+    updateStallFractions();
+    return "channels";
+  }
+  if ("ports" in json && "cycles" in json) {
+    portStatsJson = /** @type {PortStatsJSON} */ (json);
+    updateBusyFractions();
+    return "ports";
+  }
+  return undefined;
+};
+
+/** Unloads all reports. */
+export const clearStats = () => {
+  profileJson = channelStatsJson = portStatsJson = undefined;
+  updateBusyFractions();
+  updateStallFractions();
+};
+
+/** Returns the fraction of the wall time node `id` (`<task>` or
+ *  `<task>/<instance>`) ran. Without a profile, returns the largest fraction
+ *  of cycles that top-level ports `ports` bound to the node moved data, or
+ *  `undefined` without statistics of any of them.
+ *  @type {(id: string, ports: string[]) => number | undefined} */
+export const getBusyFraction = (id, ports) => {
+  const busy = busyFractions.get(id);
+  if (busy !== undefined) return busy;
+  return max(ports.map(port => portFractions.get(port)));
+};
+
+/** Returns the largest stall fraction of channels `names`, or `undefined`
+ *  without statistics of any of them.
+ *  @type {(names: string[]) => number | undefined} */
+export const getStallFraction = names =>
+  max(names.map(name => stallFractions.get(name)));
+
+/** Returns the statistics of top-level port `name`, if any.
+ *  @type {(name: string) => PortStats | undefined} */
+export const getPortStats = name => portStatsJson?.ports[name];
+
+/** Maps a fraction from 0 to 1 to a color from green to red.
+ *  @type {(fraction: number) => string} */
+export const getHeatColor = fraction =>
+  `hsl(${Math.round(120 * (1 - Math.min(Math.max(fraction, 0), 1)))}, 75%, 50%)`;
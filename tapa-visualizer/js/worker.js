@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+ * All rights reserved. The contributor(s) of this file has/have agreed to the
+ * RapidStream Contributor License Agreement.
+ */
+
+"use strict";
+
+// Parses graph.json off the main thread, so that the page stays responsive
+// while big files load. The HLS code of tasks, which is the bulk of big files
+// and is not shown, is dropped before the result is sent back.
+
+self.addEventListener("message", ({ data: file }) => {
+  if (!(file instanceof Blob)) return;
+  file.text().then(text => {
+    /** @type {GraphJSON} */
+    // eslint-disable-next-line @typescript-eslint/no-unsafe-assignment
+    const json = JSON.parse(text);
+    for (const task of Object.values(json.tasks)) {
+      task.code = "";
+    }
+    self.postMessage({ json });
+  }).catch((/** @type {unknown} */ error) => {
+    self.postMessage({ error: String(error) });
+  });
+});
@@ -43,6 +43,48 @@ type FIFO = {
   depth?: number;
 };
 
+/** Report written by software simulation with `TAPA_PROFILE=<path>`. */
+type ProfileJSON = {
+  wall_ns: number;
+  /** A dict mapping `<task>/<instance>` to the statistics of the instance. */
+  tasks: Record<string, TaskProfile>;
+};
+
+type TaskProfile = {
+  task: string, instance: number, label: string;
+  resumes: number, run_ns: number;
+  yields: number, empty_yields: number, full_yields: number;
+};
+
+/** Report written by software simulation with `TAPA_STREAM_STATS=<path>`. */
+type ChannelStatsJSON = {
+  channels: ChannelStats[];
+};
+
+type ChannelStats = {
+  name: string, depth: number;
+  pushes: number, pops: number;
+  max_occupancy: number, avg_occupancy: number;
+  full_stalls: number, empty_stalls: number;
+};
+
+/** Port statistics written by fast cosim to `output/port_stats.json`. */
+type PortStatsJSON = {
+  cycles: number;
+  /** A dict mapping top-level port names to their traffic counters. */
+  ports: Record<string, PortStats>;
+};
+
+/** Counters of mmap ports have all fields; those of streams have either the
+ *  read or the write ones. */
+type PortStats = Partial<Record<
+  "read_bursts" | "read_beats" | "read_request_stall_cycles" |
+  "read_data_stall_cycles" | "write_bursts" | "write_beats" |
+  "write_request_stall_cycles" | "write_data_stall_cycles" |
+  "max_outstanding_reads" | "max_outstanding_writes",
+  number
+>>;
+
 type Port = {
   cat: string, name: string, type: string, width: number;
 };
@@ -7,18 +7,22 @@ RapidStream Contributor License Agreement.
 """
 
 import logging
+import os
 import sys
 import tempfile
 
 import click
 
 from tapa import __version__
+from tapa.common import build_trace
 from tapa.steps.analyze import analyze
 from tapa.steps.common import switch_work_dir
 from tapa.steps.gcc import gcc
 from tapa.steps.link import link
 from tapa.steps.meta import compile_entry
 from tapa.steps.pack import pack
+from tapa.steps.stream_log import stream_log
+from tapa.steps.sweep import sweep
 from tapa.steps.synth import synth
 from tapa.steps.version import version
 from tapa.util import setup_logging
@@ -56,6 +60,15 @@ _logger = logging.getLogger().getChild(__name__)
     type=click.Path(file_okay=False),
     help="Specify temporary directory, which will be cleaned up after the execution",
 )
+@click.option(
+    "--resume / --no-resume",
+    default=True,
+    help=(
+        "Skip `analyze` and `synth` if they were completed in the work directory "
+        "with the same inputs, as recorded in `steps.json`, and their outputs "
+        "are intact, e.g., to resume a `compile` that failed in a later step."
+    ),
+)
 @click.option(
     "--recursion-limit",
     default=3000,
@@ -70,6 +83,7 @@ def entry_point(  # noqa: PLR0913,PLR0917
     quiet: bool,
     work_dir: str,
     temp_dir: str | None,
+    resume: bool,
     recursion_limit: int,
 ) -> None:
     """The TAPA compiler."""
@@ -78,8 +92,10 @@ def entry_point(  # noqa: PLR0913,PLR0917
     # Setup execution context
     ctx.ensure_object(dict)
     switch_work_dir(work_dir)
+    ctx.obj["resume"] = resume
     if temp_dir is not None:
         tempfile.tempdir = temp_dir
+    ctx.call_on_close(lambda: _write_build_trace(ctx.obj["work-dir"]))
 
     # Print version information
     _logger.info("tapa version: %s", __version__)
@@ -89,6 +105,14 @@ def entry_point(  # noqa: PLR0913,PLR0917
     _logger.info("Python recursion limit set to %d", recursion_limit)
 
 
+def _write_build_trace(work_dir: str) -> None:
+    """Write the timing of the steps run, if any, for chrome://tracing."""
+    if build_trace.has_events():
+        path = os.path.join(work_dir, "build_trace.json")
+        build_trace.write(path)
+        _logger.info("build trace written to %s", path)
+
+
 entry_point.add_command(analyze)
 entry_point.add_command(synth)
 entry_point.add_command(link)
@@ -96,6 +120,8 @@ entry_point.add_command(pack)
 entry_point.add_command(compile_entry)
 entry_point.add_command(version)
 entry_point.add_command(gcc)
+entry_point.add_command(stream_log)
+entry_point.add_command(sweep)
 
 if __name__ == "__main__":
     entry_point(prog_name="tapa")
@@ -19,7 +19,15 @@ module async_mmap #(
   parameter EnableWriteChannel= 1,
   // for burst inference
   parameter MaxWaitTime       = 3,
-  parameter MaxBurstLen       = 15
+  parameter MaxBurstLen       = 15,
+  // width of the AXI ID ports
+  parameter IdWidth           = 1,
+  // if set to 1: issue up to 2**IdWidth read bursts with distinct IDs and
+  // restore the request order of read data in a reorder buffer
+  // if set to 0: issue all bursts with ID 0
+  parameter EnableReorder     = 0,
+  parameter ReorderBufferSize    = 256,  // in beats, must be a power of 2
+  parameter ReorderBufferSizeLog = 8
 ) (
   // pragma RS clk port=clk
   // pragma RS rst port=rst active=high
@@ -31,7 +39,7 @@ module async_mmap #(
   output wire                        m_axi_AWVALID,
   input  wire                        m_axi_AWREADY,
   output wire [AxiSideAddrWidth-1:0] m_axi_AWADDR,
-  output wire [0:0]                  m_axi_AWID,
+  output wire [IdWidth-1:0]          m_axi_AWID,
   output wire [7:0]                  m_axi_AWLEN,
   output wire [2:0]                  m_axi_AWSIZE,
   output wire [1:0]                  m_axi_AWBURST,
@@ -53,14 +61,14 @@ module async_mmap #(
   input  wire       m_axi_BVALID,
   output wire       m_axi_BREADY,
   input  wire [1:0] m_axi_BRESP,
-  input  wire [0:0] m_axi_BID,
+  input  wire [IdWidth-1:0] m_axi_BID,
 
   // axi read addr channel
   // pragma RS handshake valid=m_axi_ARVALID ready=m_axi_ARREADY data=m_axi_AR.*
   output wire                        m_axi_ARVALID,
   input  wire                        m_axi_ARREADY,
   output wire [AxiSideAddrWidth-1:0] m_axi_ARADDR,
-  output wire [0:0]                  m_axi_ARID,
+  output wire [IdWidth-1:0]          m_axi_ARID,
   output wire [7:0]                  m_axi_ARLEN,
   output wire [2:0]                  m_axi_ARSIZE,
   output wire [1:0]                  m_axi_ARBURST,
@@ -75,7 +83,7 @@ module async_mmap #(
   output wire                 m_axi_RREADY,
   input  wire [DataWidth-1:0] m_axi_RDATA,
   input  wire                 m_axi_RLAST,
-  input  wire [0:0]           m_axi_RID,
+  input  wire [IdWidth-1:0]   m_axi_RID,
   input  wire [1:0]           m_axi_RRESP,
 
 
@@ -505,11 +513,15 @@ module async_mmap #(
     .if_dout   (read_data_dout)
   );
 
+  // whether the next read burst can be issued, and with which ID
+  wire               read_issue_ready;
+  wire [IdWidth-1:0] read_issue_id;
+
   // AR channel
-  assign burst_read_addr_read = m_axi_ARREADY;
-  assign m_axi_ARVALID        = burst_read_addr_empty_n;
+  assign burst_read_addr_read = m_axi_ARREADY && read_issue_ready;
+  assign m_axi_ARVALID        = burst_read_addr_empty_n && read_issue_ready;
   assign m_axi_ARADDR         = {{(AxiSideAddrWidth - AddrWidth){1'b0}}, burst_read_addr_dout_addr};
-  assign m_axi_ARID           = 0;
+  assign m_axi_ARID           = read_issue_id;
   assign m_axi_ARLEN          = burst_read_addr_dout_burst_len;
   assign m_axi_ARSIZE         = DataWidthBytesLog;
   assign m_axi_ARBURST        = 1;        // INCR mode
@@ -519,9 +531,44 @@ module async_mmap #(
   assign m_axi_ARQOS          = 0;
 
   // R channel
-  assign m_axi_RREADY    = read_data_full_n;
-  assign read_data_write = m_axi_RVALID;
-  assign read_data_din   = m_axi_RDATA;
+  generate
+    if (EnableReorder) begin : reorder
+      reorder_read_data #(
+        .DataWidth    (DataWidth),
+        .IdWidth      (IdWidth),
+        .BurstLenWidth(BurstLenWidth),
+        .BufferSize   (ReorderBufferSize),
+        .BufferSizeLog(ReorderBufferSizeLog)
+      ) reorder_read_data_unit (
+        .clk(clk),
+        .rst(rst),
+
+        // from AR channel
+        .issue_ready(read_issue_ready),
+        .issue_id   (read_issue_id),
+        .issue      (m_axi_ARVALID && m_axi_ARREADY),
+        .issue_len  (burst_read_addr_dout_burst_len),
+
+        // from axi
+        .rvalid(m_axi_RVALID),
+        .rready(m_axi_RREADY),
+        .rid   (m_axi_RID),
+        .rdata (m_axi_RDATA),
+        .rlast (m_axi_RLAST),
+
+        // to read resp buffer
+        .data_din   (read_data_din),
+        .data_full_n(read_data_full_n),
+        .data_write (read_data_write)
+      );
+    end else begin : in_order
+      assign read_issue_ready = 1'b1;
+      assign read_issue_id    = {IdWidth{1'b0}};
+      assign m_axi_RREADY     = read_data_full_n;
+      assign read_data_write  = m_axi_RVALID;
+      assign read_data_din    = m_axi_RDATA;
+    end
+  endgenerate
 
   // unused input signals
   wire _unused = &{1'b0,
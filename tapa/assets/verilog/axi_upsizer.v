@@ -0,0 +1,299 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+`default_nettype none
+
+// AXI width converter from a narrow slave to a wide master.
+//
+// Each narrow INCR burst of full-width beats becomes one wide burst that
+// covers the same bytes, so narrow writes are combined into wide beats with
+// byte strobes, and wide read beats are split into narrow ones.  Bursts are
+// issued with ID 0 and the slave IDs are restored from in-order queues, so
+// responses must not interleave across bursts, which the crossbar ensures.
+module axi_upsizer #(
+  parameter AddrWidth = 64,
+  parameter SDataWidth = 32,
+  parameter MDataWidth = 512,
+  parameter IdWidth = 1,
+  // log2 of the number of outstanding bursts in each direction
+  parameter IssueLog = 4
+) (
+  input wire clk,
+  input wire rst,
+
+  input  wire [IdWidth-1:0]        s_axi_awid,
+  input  wire [AddrWidth-1:0]      s_axi_awaddr,
+  input  wire [7:0]                s_axi_awlen,
+  input  wire [2:0]                s_axi_awsize,
+  input  wire [1:0]                s_axi_awburst,
+  input  wire                      s_axi_awlock,
+  input  wire [3:0]                s_axi_awcache,
+  input  wire [2:0]                s_axi_awprot,
+  input  wire [3:0]                s_axi_awqos,
+  input  wire                      s_axi_awvalid,
+  output wire                      s_axi_awready,
+  input  wire [SDataWidth-1:0]     s_axi_wdata,
+  input  wire [SDataWidth/8-1:0]   s_axi_wstrb,
+  input  wire                      s_axi_wlast,
+  input  wire                      s_axi_wvalid,
+  output wire                      s_axi_wready,
+  output wire [IdWidth-1:0]        s_axi_bid,
+  output wire [1:0]                s_axi_bresp,
+  output wire                      s_axi_bvalid,
+  input  wire                      s_axi_bready,
+  input  wire [IdWidth-1:0]        s_axi_arid,
+  input  wire [AddrWidth-1:0]      s_axi_araddr,
+  input  wire [7:0]                s_axi_arlen,
+  input  wire [2:0]                s_axi_arsize,
+  input  wire [1:0]                s_axi_arburst,
+  input  wire                      s_axi_arlock,
+  input  wire [3:0]                s_axi_arcache,
+  input  wire [2:0]                s_axi_arprot,
+  input  wire [3:0]                s_axi_arqos,
+  input  wire                      s_axi_arvalid,
+  output wire                      s_axi_arready,
+  output wire [IdWidth-1:0]        s_axi_rid,
+  output wire [SDataWidth-1:0]     s_axi_rdata,
+  output wire [1:0]                s_axi_rresp,
+  output wire                      s_axi_rlast,
+  output wire                      s_axi_rvalid,
+  input  wire                      s_axi_rready,
+
+  output wire [IdWidth-1:0]        m_axi_awid,
+  output wire [AddrWidth-1:0]      m_axi_awaddr,
+  output wire [7:0]                m_axi_awlen,
+  output wire [2:0]                m_axi_awsize,
+  output wire [1:0]                m_axi_awburst,
+  output wire                      m_axi_awlock,
+  output wire [3:0]                m_axi_awcache,
+  output wire [2:0]                m_axi_awprot,
+  output wire [3:0]                m_axi_awqos,
+  output wire                      m_axi_awvalid,
+  input  wire                      m_axi_awready,
+  output wire [MDataWidth-1:0]     m_axi_wdata,
+  output wire [MDataWidth/8-1:0]   m_axi_wstrb,
+  output wire                      m_axi_wlast,
+  output wire                      m_axi_wvalid,
+  input  wire                      m_axi_wready,
+  input  wire [IdWidth-1:0]        m_axi_bid,
+  input  wire [1:0]                m_axi_bresp,
+  input  wire                      m_axi_bvalid,
+  output wire                      m_axi_bready,
+  output wire [IdWidth-1:0]        m_axi_arid,
+  output wire [AddrWidth-1:0]      m_axi_araddr,
+  output wire [7:0]                m_axi_arlen,
+  output wire [2:0]                m_axi_arsize,
+  output wire [1:0]                m_axi_arburst,
+  output wire                      m_axi_arlock,
+  output wire [3:0]                m_axi_arcache,
+  output wire [2:0]                m_axi_arprot,
+  output wire [3:0]                m_axi_arqos,
+  output wire                      m_axi_arvalid,
+  input  wire                      m_axi_arready,
+  input  wire [IdWidth-1:0]        m_axi_rid,
+  input  wire [MDataWidth-1:0]     m_axi_rdata,
+  input  wire [1:0]                m_axi_rresp,
+  input  wire                      m_axi_rlast,
+  input  wire                      m_axi_rvalid,
+  output wire                      m_axi_rready
+);
+
+  localparam SBytes = SDataWidth / 8;
+  localparam MBytes = MDataWidth / 8;
+  localparam SSize = $clog2(SBytes);
+  localparam MSize = $clog2(MBytes);
+  localparam Ratio = MDataWidth / SDataWidth;
+  localparam LaneWidth = $clog2(Ratio);
+  localparam IssueDepth = 1 << IssueLog;
+
+  // Returns the number of wide beats minus 1 that cover a narrow burst.
+  function [7:0] wide_len;
+    input [MSize-1:0] offset;
+    input [7:0] len;
+    reg [31:0] last_byte;
+    begin
+      last_byte = offset + (len << SSize) + (SBytes - 1);
+      wide_len = last_byte >> MSize;
+    end
+  endfunction
+
+  // queues of outstanding bursts
+  reg [IdWidth+LaneWidth+7:0] read_queue[0:IssueDepth-1];
+  reg [IssueLog:0]            read_head, read_tail;
+  reg [LaneWidth-1:0]         write_queue[0:IssueDepth-1];
+  reg [IssueLog:0]            write_head, write_tail;
+  reg [IdWidth-1:0]           resp_queue[0:IssueDepth-1];
+  reg [IssueLog:0]            resp_head, resp_tail;
+
+  // a queue is full if its count reaches IssueDepth, i.e., sets the MSB
+  wire [IssueLog:0] read_count = read_tail - read_head;
+  wire [IssueLog:0] write_count = write_tail - write_head;
+  wire [IssueLog:0] resp_count = resp_tail - resp_head;
+  wire read_full = read_count[IssueLog];
+  wire read_empty = read_count == 0;
+  wire write_full = write_count[IssueLog];
+  wire write_empty = write_count == 0;
+  wire resp_full = resp_count[IssueLog];
+  wire resp_empty = resp_count == 0;
+
+  // write address channel
+  wire aw_ready = !write_full && !resp_full;
+  assign m_axi_awid = {IdWidth{1'b0}};
+  assign m_axi_awaddr = {s_axi_awaddr[AddrWidth-1:MSize], {MSize{1'b0}}};
+  assign m_axi_awlen = wide_len(s_axi_awaddr[MSize-1:0], s_axi_awlen);
+  assign m_axi_awsize = MSize;
+  assign m_axi_awburst = s_axi_awburst;
+  assign m_axi_awlock = s_axi_awlock;
+  assign m_axi_awcache = s_axi_awcache;
+  assign m_axi_awprot = s_axi_awprot;
+  assign m_axi_awqos = s_axi_awqos;
+  assign m_axi_awvalid = s_axi_awvalid && aw_ready;
+  assign s_axi_awready = m_axi_awready && aw_ready;
+
+  // read address channel
+  assign m_axi_arid = {IdWidth{1'b0}};
+  assign m_axi_araddr = {s_axi_araddr[AddrWidth-1:MSize], {MSize{1'b0}}};
+  assign m_axi_arlen = wide_len(s_axi_araddr[MSize-1:0], s_axi_arlen);
+  assign m_axi_arsize = MSize;
+  assign m_axi_arburst = s_axi_arburst;
+  assign m_axi_arlock = s_axi_arlock;
+  assign m_axi_arcache = s_axi_arcache;
+  assign m_axi_arprot = s_axi_arprot;
+  assign m_axi_arqos = s_axi_arqos;
+  assign m_axi_arvalid = s_axi_arvalid && !read_full;
+  assign s_axi_arready = m_axi_arready && !read_full;
+
+  // read data channel: split each wide beat into narrow beats
+  reg                 r_busy;
+  reg [LaneWidth-1:0] r_lane_q;
+  reg [7:0]           r_left_q;
+
+  wire [IdWidth+LaneWidth+7:0] read_front = read_queue[read_head[IssueLog-1:0]];
+  wire [LaneWidth-1:0] r_lane =
+      r_busy ? r_lane_q : read_front[LaneWidth+7:8];
+  wire [7:0] r_left = r_busy ? r_left_q : read_front[7:0];
+  wire r_beat_done = r_left == 8'd0 || r_lane == Ratio - 1;
+
+  assign s_axi_rid = read_front[IdWidth+LaneWidth+7:LaneWidth+8];
+  assign s_axi_rdata = m_axi_rdata[r_lane*SDataWidth +: SDataWidth];
+  assign s_axi_rresp = m_axi_rresp;
+  assign s_axi_rlast = r_left == 8'd0;
+  assign s_axi_rvalid = m_axi_rvalid && !read_empty;
+  assign m_axi_rready = s_axi_rready && !read_empty && r_beat_done;
+
+  // write data channel: combine narrow beats into wide beats
+  reg                    w_busy;
+  reg [LaneWidth-1:0]    w_lane_q;
+  reg [MDataWidth-1:0]   w_data;
+  reg [MBytes-1:0]       w_strb;
+  reg [MDataWidth-1:0]   w_out_data;
+  reg [MBytes-1:0]       w_out_strb;
+  reg                    w_out_last;
+  reg                    w_out_valid;
+
+  wire [LaneWidth-1:0] w_lane =
+      w_busy ? w_lane_q : write_queue[write_head[IssueLog-1:0]];
+  wire w_accept = s_axi_wvalid && s_axi_wready;
+  assign s_axi_wready = !write_empty && (!w_out_valid || m_axi_wready);
+
+  reg [MDataWidth-1:0] w_data_next;
+  reg [MBytes-1:0]     w_strb_next;
+  always @* begin
+    w_data_next = w_data;
+    w_data_next[w_lane*SDataWidth +: SDataWidth] = s_axi_wdata;
+    w_strb_next = w_strb;
+    w_strb_next[w_lane*SBytes +: SBytes] = s_axi_wstrb;
+  end
+
+  assign m_axi_wdata = w_out_data;
+  assign m_axi_wstrb = w_out_strb;
+  assign m_axi_wlast = w_out_last;
+  assign m_axi_wvalid = w_out_valid;
+
+  // write response channel
+  assign s_axi_bid = resp_queue[resp_head[IssueLog-1:0]];
+  assign s_axi_bresp = m_axi_bresp;
+  assign s_axi_bvalid = m_axi_bvalid && !resp_empty;
+  assign m_axi_bready = s_axi_bready && !resp_empty;
+
+  always @(posedge clk) begin
+    if (s_axi_arvalid && s_axi_arready) begin
+      read_queue[read_tail[IssueLog-1:0]] <=
+          {s_axi_arid, s_axi_araddr[MSize-1:SSize], s_axi_arlen};
+    end
+    if (s_axi_awvalid && s_axi_awready) begin
+      write_queue[write_tail[IssueLog-1:0]] <= s_axi_awaddr[MSize-1:SSize];
+      resp_queue[resp_tail[IssueLog-1:0]] <= s_axi_awid;
+    end
+    if (w_accept) begin
+      if (w_lane == Ratio - 1 || s_axi_wlast) begin
+        w_out_data <= w_data_next;
+        w_out_strb <= w_strb_next;
+        w_out_last <= s_axi_wlast;
+      end else begin
+        w_data <= w_data_next;
+      end
+    end
+  end
+
+  always @(posedge clk) begin
+    if (rst) begin
+      read_head <= 0;
+      read_tail <= 0;
+      write_head <= 0;
+      write_tail <= 0;
+      resp_head <= 0;
+      resp_tail <= 0;
+      r_busy <= 1'b0;
+      r_lane_q <= 0;
+      r_left_q <= 8'd0;
+      w_busy <= 1'b0;
+      w_lane_q <= 0;
+      w_strb <= {MBytes{1'b0}};
+      w_out_valid <= 1'b0;
+    end else begin
+      if (s_axi_arvalid && s_axi_arready) read_tail <= read_tail + 1'b1;
+      if (s_axi_awvalid && s_axi_awready) begin
+        write_tail <= write_tail + 1'b1;
+        resp_tail <= resp_tail + 1'b1;
+      end
+
+      // read data
+      if (s_axi_rvalid && s_axi_rready) begin
+        if (s_axi_rlast) begin
+          r_busy <= 1'b0;
+          read_head <= read_head + 1'b1;
+        end else begin
+          r_busy <= 1'b1;
+          r_lane_q <= r_lane + 1'b1;
+          r_left_q <= r_left - 1'b1;
+        end
+      end
+
+      // write data
+      if (w_out_valid && m_axi_wready) w_out_valid <= 1'b0;
+      if (w_accept) begin
+        if (w_lane == Ratio - 1 || s_axi_wlast) begin
+          w_out_valid <= 1'b1;
+          w_strb <= {MBytes{1'b0}};
+        end else begin
+          w_strb <= w_strb_next;
+        end
+        if (s_axi_wlast) begin
+          w_busy <= 1'b0;
+          write_head <= write_head + 1'b1;
+        end else begin
+          w_busy <= 1'b1;
+          w_lane_q <= w_lane + 1'b1;
+        end
+      end
+
+      // write response
+      if (s_axi_bvalid && s_axi_bready) resp_head <= resp_head + 1'b1;
+    end
+  end
+
+endmodule  // axi_upsizer
+
+`default_nettype wire
@@ -0,0 +1,178 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+`default_nettype none
+
+// first-word fall-through (FWFT) FIFO whose ends are in different clock
+// domains; `reset` must be synchronous to `wr_clk`
+module fifo_async #(
+  parameter DATA_WIDTH = 32,
+  parameter ADDR_WIDTH = 5,   // ignored
+  parameter DEPTH      = 32
+) (
+  input wire wr_clk,
+  input wire reset,
+  input wire rd_clk,
+
+  // write
+  output wire                  if_full_n,
+  input  wire                  if_write_ce,
+  input  wire                  if_write,
+  input  wire [DATA_WIDTH-1:0] if_din,
+
+  // read
+  output wire                  if_empty_n,
+  input  wire                  if_read_ce,
+  input  wire                  if_read,
+  output wire [DATA_WIDTH-1:0] if_dout
+);
+
+  // the XPM FIFO is at least 16 deep and its depth must be a power of 2
+  localparam RealDepth = DEPTH <= 16 ? 16 : 1 << $clog2(DEPTH);
+
+  wire full;
+  wire empty;
+  wire wr_rst_busy;
+  wire rd_rst_busy;
+
+  assign if_full_n  = !full && !wr_rst_busy;
+  assign if_empty_n = !empty && !rd_rst_busy;
+
+  xpm_fifo_async #(
+    .CDC_SYNC_STAGES    (2),
+    .FIFO_MEMORY_TYPE   ("auto"),
+    .FIFO_READ_LATENCY  (0),
+    .FIFO_WRITE_DEPTH   (RealDepth),
+    .READ_DATA_WIDTH    (DATA_WIDTH),
+    .READ_MODE          ("fwft"),
+    .USE_ADV_FEATURES   ("0000"),
+    .WRITE_DATA_WIDTH   (DATA_WIDTH)
+  ) unit (
+    .sleep        (1'b0),
+    .rst          (reset),
+    .wr_clk       (wr_clk),
+    .wr_en        (if_write && if_write_ce && if_full_n),
+    .din          (if_din),
+    .full         (full),
+    .wr_rst_busy  (wr_rst_busy),
+    .rd_clk       (rd_clk),
+    .rd_en        (if_read && if_read_ce && if_empty_n),
+    .dout         (if_dout),
+    .empty        (empty),
+    .rd_rst_busy  (rd_rst_busy),
+    .injectsbiterr(1'b0),
+    .injectdbiterr(1'b0)
+  );
+
+endmodule  // fifo_async
+
+// synchronize the deassertion of an asynchronous active-low reset to `clk`
+module reset_sync #(
+  parameter STAGES = 2
+) (
+  input  wire clk,
+  input  wire async_rst_n,
+  output wire rst_n
+);
+
+  (* ASYNC_REG = "TRUE" *) reg [STAGES-1:0] sync;
+
+  assign rst_n = sync[STAGES-1];
+
+  always @(posedge clk or negedge async_rst_n) begin
+    if (!async_rst_n) begin
+      sync <= {STAGES{1'b0}};
+    end else begin
+      sync <= {sync[STAGES-2:0], 1'b1};
+    end
+  end
+
+endmodule  // reset_sync
+
+// Cross the `ap_ctrl_hs` handshake of a task running on `m_clk` to the
+// upper-level task running on `s_clk`.
+//
+// A start request and its acknowledgement are passed as toggles, so that each
+// `s_ap_start` starts the task exactly once, and `s_ap_ready` and `s_ap_done`
+// are single-cycle pulses as if the task were running on `s_clk`.
+module handshake_crossing (
+  input  wire s_clk,
+  input  wire s_reset,
+  input  wire s_ap_start,
+  output wire s_ap_ready,
+  output wire s_ap_done,
+  output wire s_ap_idle,
+
+  input  wire m_clk,
+  input  wire m_reset,
+  output reg  m_ap_start,
+  input  wire m_ap_ready,
+  input  wire m_ap_done,
+  input  wire m_ap_idle
+);
+
+  // `s_clk` domain
+  reg req;      // toggled to request a start
+  reg pending;  // whether a start is not acknowledged yet
+  reg ack_seen;
+  reg done_seen;
+  (* ASYNC_REG = "TRUE" *) reg [1:0] ack_sync;
+  (* ASYNC_REG = "TRUE" *) reg [1:0] done_sync;
+  (* ASYNC_REG = "TRUE" *) reg [1:0] idle_sync;
+
+  // `m_clk` domain
+  reg req_seen;
+  reg ack;      // toggled when the task is ready
+  reg done;     // toggled when the task is done
+  (* ASYNC_REG = "TRUE" *) reg [1:0] req_sync;
+
+  assign s_ap_ready = ack_sync[1] != ack_seen;
+  assign s_ap_done  = done_sync[1] != done_seen;
+  assign s_ap_idle  = idle_sync[1];
+
+  always @(posedge s_clk) begin
+    ack_sync  <= {ack_sync[0], ack};
+    done_sync <= {done_sync[0], done};
+    idle_sync <= {idle_sync[0], m_ap_idle};
+    if (s_reset) begin
+      req       <= 1'b0;
+      pending   <= 1'b0;
+      ack_seen  <= 1'b0;
+      done_seen <= 1'b0;
+    end else begin
+      if (s_ap_start && !pending) begin
+        req     <= !req;
+        pending <= 1'b1;
+      end else if (s_ap_ready) begin
+        pending <= 1'b0;
+      end
+      ack_seen  <= ack_sync[1];
+      done_seen <= done_sync[1];
+    end
+  end
+
+  always @(posedge m_clk) begin
+    req_sync <= {req_sync[0], req};
+    if (m_reset) begin
+      req_seen   <= 1'b0;
+      ack        <= 1'b0;
+      done       <= 1'b0;
+      m_ap_start <= 1'b0;
+    end else begin
+      if (req_sync[1] != req_seen) begin
+        req_seen   <= req_sync[1];
+        m_ap_start <= 1'b1;
+      end else if (m_ap_start && m_ap_ready) begin
+        ack        <= !ack;
+        m_ap_start <= 1'b0;
+      end
+      if (m_ap_done) begin
+        done <= !done;
+      end
+    end
+  end
+
+endmodule  // handshake_crossing
+
+`default_nettype wire
@@ -5,7 +5,12 @@
 `default_nettype none
 
 // first-word fall-through (FWFT) FIFO
+//
+// MEM_STYLE selects the memory as in Vivado's `ram_style`, i.e., "shiftreg",
+// "distributed", "block", or "ultra"; "auto" picks one from DEPTH and
+// DATA_WIDTH.
 module fifo #(
+  parameter MEM_STYLE  = "auto",
   parameter DATA_WIDTH = 32,
   parameter ADDR_WIDTH = 5,
   parameter DEPTH      = 32
@@ -44,7 +49,9 @@ generate
       .if_read   (if_read),
       .if_dout   (if_dout)
     );
-  end else if (DATA_WIDTH >= 36 && DEPTH >= 4096) begin : uram
+  end else if (MEM_STYLE == "ultra" ||
+               MEM_STYLE == "auto" && DATA_WIDTH >= 36 && DEPTH >= 4096)
+  begin : uram
     fifo_bram #(
       .MEM_STYLE ("ultra"),
       .DATA_WIDTH(DATA_WIDTH),
@@ -64,7 +71,8 @@ generate
       .if_read   (if_read),
       .if_dout   (if_dout)
     );
-  end else if (DEPTH >=128) begin : bram
+  end else if (MEM_STYLE == "block" || MEM_STYLE == "auto" && DEPTH >= 128)
+  begin : bram
     fifo_bram #(
       .MEM_STYLE ("block"),
       .DATA_WIDTH(DATA_WIDTH),
@@ -79,6 +87,26 @@ generate
       .if_write   (if_write),
       .if_din     (if_din),
 
+      .if_empty_n(if_empty_n),
+      .if_read_ce(if_read_ce),
+      .if_read   (if_read),
+      .if_dout   (if_dout)
+    );
+  end else if (MEM_STYLE == "distributed") begin : lutram
+    fifo_bram #(
+      .MEM_STYLE ("distributed"),
+      .DATA_WIDTH(DATA_WIDTH),
+      .ADDR_WIDTH(ADDR_WIDTH),
+      .DEPTH     (DEPTH)
+    ) unit (
+      .clk  (clk),
+      .reset(reset),
+
+      .if_full_n  (if_full_n),
+      .if_write_ce(if_write_ce),
+      .if_write   (if_write),
+      .if_din     (if_din),
+
       .if_empty_n(if_empty_n),
       .if_read_ce(if_read_ce),
       .if_read   (if_read),
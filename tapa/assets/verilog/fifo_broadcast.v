@@ -0,0 +1,80 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+`default_nettype none
+
+// FIFO whose entries are received by each of its consumers. The entries are
+// stored once, and each consumer has its own read pointer into them and its own
+// lane of the read ports. An entry is freed once every consumer has read it, so
+// the FIFO is full when any consumer lags `DEPTH` entries behind the producer.
+module fifo_broadcast #(
+  parameter CONSUMERS  = 2,
+  parameter DATA_WIDTH = 64,
+  parameter ADDR_WIDTH = 5,
+  parameter DEPTH      = 32
+) (
+  input wire clk,
+  input wire reset,
+
+  // write
+  output wire                  if_full_n,
+  input  wire                  if_write_ce,
+  input  wire                  if_write,
+  input  wire [DATA_WIDTH-1:0] if_din,
+
+  // read, a lane per consumer
+  output wire [CONSUMERS-1:0]            if_empty_n,
+  input  wire                            if_read_ce,
+  input  wire [CONSUMERS-1:0]            if_read,
+  output wire [CONSUMERS*DATA_WIDTH-1:0] if_dout
+);
+  reg [DATA_WIDTH-1:0] mem [0:DEPTH-1];
+  reg [ADDR_WIDTH-1:0] write_addr;
+
+  wire [CONSUMERS-1:0] is_full;
+  wire                 push = if_write_ce && if_write && if_full_n;
+
+  assign if_full_n = ~|is_full;
+
+  always @(posedge clk) begin
+    if (push) begin
+      mem[write_addr] <= if_din;
+    end
+    if (reset) begin
+      write_addr <= {ADDR_WIDTH{1'b0}};
+    end else if (push) begin
+      write_addr <= write_addr == DEPTH - 1 ? {ADDR_WIDTH{1'b0}}
+                                            : write_addr + 1'b1;
+    end
+  end
+
+  genvar i;
+  generate
+    for (i = 0; i < CONSUMERS; i = i + 1) begin : consumer
+      reg  [ADDR_WIDTH-1:0] read_addr;
+      reg  [ADDR_WIDTH:0]   used;  // entries not read by this consumer yet
+      wire                  pop = if_read_ce && if_read[i] && if_empty_n[i];
+
+      assign is_full[i]    = used == DEPTH;
+      assign if_empty_n[i] = used != 0;
+      assign if_dout[i*DATA_WIDTH +: DATA_WIDTH] = mem[read_addr];
+
+      always @(posedge clk) begin
+        if (reset) begin
+          read_addr <= {ADDR_WIDTH{1'b0}};
+          used      <= {(ADDR_WIDTH+1){1'b0}};
+        end else begin
+          if (pop) begin
+            read_addr <= read_addr == DEPTH - 1 ? {ADDR_WIDTH{1'b0}}
+                                                : read_addr + 1'b1;
+          end
+          used <= used + push - pop;
+        end
+      end
+    end
+  endgenerate
+
+endmodule  // fifo_broadcast
+
+`default_nettype wire
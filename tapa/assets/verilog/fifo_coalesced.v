@@ -0,0 +1,107 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+`default_nettype none
+
+// FIFO shared by streams that are written and read in lockstep. Each stream is
+// a lane occupying a slice of the data bus. A lane written ahead of the others
+// is held until all lanes are written, and then all lanes are pushed as one
+// entry. A lane read ahead of the others is hidden until all lanes are read,
+// and then the entry is popped.
+module fifo_coalesced #(
+  parameter LANES      = 2,
+  parameter DATA_WIDTH = 64,
+  parameter ADDR_WIDTH = 5,
+  parameter DEPTH      = 32,
+  // least significant bit of each lane in `if_din` and `if_dout`, 32 bits each
+  parameter [LANES*32-1:0] LANE_OFFSET = {32'd32, 32'd0}
+) (
+  input wire clk,
+  input wire reset,
+
+  // write
+  output wire [LANES-1:0]      if_full_n,
+  input  wire                  if_write_ce,
+  input  wire [LANES-1:0]      if_write,
+  input  wire [DATA_WIDTH-1:0] if_din,
+
+  // read
+  output wire [LANES-1:0]      if_empty_n,
+  input  wire                  if_read_ce,
+  input  wire [LANES-1:0]      if_read,
+  output wire [DATA_WIDTH-1:0] if_dout
+);
+  reg  [LANES-1:0]      is_held;   // lane is written but not pushed yet
+  reg  [LANES-1:0]      is_taken;  // lane is read but not popped yet
+  reg  [DATA_WIDTH-1:0] held_data;
+
+  wire [LANES-1:0] write = if_write & {LANES{if_write_ce}};
+  wire [LANES-1:0] read  = if_read & {LANES{if_read_ce}};
+
+  wire                  fifo_full_n;
+  wire                  fifo_empty_n;
+  wire [DATA_WIDTH-1:0] fifo_din;
+  wire                  push = fifo_full_n && &(is_held | write);
+  wire                  pop  = fifo_empty_n && &(is_taken | read);
+
+  // Bits of the lanes that are held or written, built lane by lane.
+  wire [DATA_WIDTH-1:0] upper_mask   [0:LANES];
+  wire [DATA_WIDTH-1:0] held_mask    [0:LANES];
+  wire [DATA_WIDTH-1:0] written_mask [0:LANES];
+  assign upper_mask[LANES] = {DATA_WIDTH{1'b0}};
+  assign held_mask[0]      = {DATA_WIDTH{1'b0}};
+  assign written_mask[0]   = {DATA_WIDTH{1'b0}};
+
+  genvar i;
+  generate
+    for (i = 0; i < LANES; i = i + 1) begin : lane
+      wire [DATA_WIDTH-1:0] mask = upper_mask[i] & ~upper_mask[i + 1];
+      assign upper_mask[i] = {DATA_WIDTH{1'b1}} << LANE_OFFSET[i*32 +: 32];
+      assign held_mask[i + 1] =
+          held_mask[i] | (is_held[i] ? mask : {DATA_WIDTH{1'b0}});
+      assign written_mask[i + 1] =
+          written_mask[i] | (write[i] ? mask : {DATA_WIDTH{1'b0}});
+    end
+  endgenerate
+
+  assign if_full_n  = ~is_held;
+  assign if_empty_n = {LANES{fifo_empty_n}} & ~is_taken;
+  assign fifo_din   = (held_data & held_mask[LANES]) |
+                      (if_din & ~held_mask[LANES]);
+
+  always @(posedge clk) begin
+    if (reset) begin
+      is_held  <= {LANES{1'b0}};
+      is_taken <= {LANES{1'b0}};
+    end else begin
+      is_held  <= push ? {LANES{1'b0}} : is_held | write;
+      is_taken <= pop ? {LANES{1'b0}} : is_taken | read;
+    end
+
+    held_data <= (held_data & ~written_mask[LANES]) |
+                 (if_din & written_mask[LANES]);
+  end
+
+  fifo #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .ADDR_WIDTH(ADDR_WIDTH),
+    .DEPTH     (DEPTH)
+  ) unit (
+    .clk  (clk),
+    .reset(reset),
+
+    .if_full_n  (fifo_full_n),
+    .if_write_ce(1'b1),
+    .if_write   (push),
+    .if_din     (fifo_din),
+
+    .if_empty_n(fifo_empty_n),
+    .if_read_ce(1'b1),
+    .if_read   (pop),
+    .if_dout   (if_dout)
+  );
+
+endmodule  // fifo_coalesced
+
+`default_nettype wire
@@ -38,8 +38,6 @@ module fifo_srl #(
   reg                     internal_empty_n;
   reg                     internal_full_n;
 
-  (* shreg_extract = "yes" *) reg [DATA_WIDTH-1:0] mem [0:REAL_DEPTH-1];
-
   assign if_empty_n = internal_empty_n;
   assign if_full_n = internal_full_n;
   assign shift_reg_data = if_din;
@@ -48,7 +46,6 @@ module fifo_srl #(
   assign shift_reg_addr = out_ptr[REAL_ADDR_WIDTH] == 1'b0 ? out_ptr[REAL_ADDR_WIDTH-1:0] : {REAL_ADDR_WIDTH{1'b0}};
   assign shift_reg_ce = (if_write & if_write_ce) & internal_full_n;
 
-  assign shift_reg_q = mem[shift_reg_addr];
 
   always @(posedge clk) begin
     if (reset) begin
@@ -74,6 +71,30 @@ module fifo_srl #(
     end
   end
 
+`ifdef TAPA_SIM_FIFO
+  // Simulation model: a ring buffer written at `ring_ptr` holds the same
+  // data as the shift register, as `mem[k]` is `ring[ring_ptr - 1 - k]`, but
+  // a write updates one entry instead of moving all of them.
+  localparam RING_ADDR_WIDTH = REAL_ADDR_WIDTH - 1;
+
+  reg [DATA_WIDTH-1:0] ring [0:(1 << RING_ADDR_WIDTH)-1];
+  reg [RING_ADDR_WIDTH-1:0] ring_ptr = {RING_ADDR_WIDTH{1'b0}};
+  wire [RING_ADDR_WIDTH-1:0] ring_addr =
+    ring_ptr - 1'b1 - shift_reg_addr[RING_ADDR_WIDTH-1:0];
+
+  assign shift_reg_q = ring[ring_addr];
+
+  always @(posedge clk) begin
+    if (shift_reg_ce) begin
+      ring[ring_ptr] <= shift_reg_data;
+      ring_ptr <= ring_ptr + 1'b1;
+    end
+  end
+`else
+  (* shreg_extract = "yes" *) reg [DATA_WIDTH-1:0] mem [0:REAL_DEPTH-1];
+
+  assign shift_reg_q = mem[shift_reg_addr];
+
   integer i;
   always @(posedge clk) begin
     if (shift_reg_ce) begin
@@ -82,6 +103,7 @@ module fifo_srl #(
       mem[0] <= shift_reg_data;
     end
   end
+`endif
 
 endmodule  // fifo_srl
 
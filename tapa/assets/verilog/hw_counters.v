@@ -0,0 +1,133 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+`default_nettype none
+
+// Count events while the kernel runs, and serve the counters on the read
+// channels of `s_axi_control` from `BaseAddr`, as laid out by
+// `tapa/common/hw_counters.py`.
+//
+// Reads below `BaseAddr` are forwarded to the control registers generated by
+// HLS. Only one read is in flight at a time, so the responses of the two are
+// never reordered. The counters are cleared when the kernel starts, and
+// counter 0 counts the cycles the kernel runs.
+module hw_counters #(
+  parameter AddrWidth  = 12,
+  parameter BaseAddr   = 'h800,
+  parameter EventCount = 1,
+  parameter NameSize   = 4,  // in bytes, a multiple of 4
+  parameter [NameSize*8-1:0] Names = 0
+) (
+  input wire clk,
+  input wire rst,
+  input wire ap_start,
+  input wire ap_idle,
+
+  input wire [EventCount-1:0] events,
+
+  // from the host
+  input  wire                 s_arvalid,
+  output wire                 s_arready,
+  input  wire [AddrWidth-1:0] s_araddr,
+  output wire                 s_rvalid,
+  input  wire                 s_rready,
+  output wire [31:0]          s_rdata,
+  output wire [1:0]           s_rresp,
+
+  // to the control registers
+  output wire                 m_arvalid,
+  input  wire                 m_arready,
+  output wire [AddrWidth-1:0] m_araddr,
+  input  wire                 m_rvalid,
+  output wire                 m_rready,
+  input  wire [31:0]          m_rdata,
+  input  wire [1:0]           m_rresp
+);
+
+  localparam Magic         = 32'h54415041;
+  localparam CounterCount  = EventCount + 1;
+  localparam NameWordCount = NameSize / 4;
+  localparam HeaderWords   = 4;
+
+  reg [63:0] counters [0:CounterCount-1];
+
+  reg        counter_rvalid;
+  reg [31:0] counter_rdata;
+  reg        forwarded;  // whether a forwarded read is not responded yet
+
+  wire                 is_counter   = s_araddr >= BaseAddr;
+  wire [AddrWidth-1:0] offset       = s_araddr - BaseAddr;
+  wire [AddrWidth-3:0] word         = offset[AddrWidth-1:2];
+  wire [AddrWidth-3:0] counter_word = word - HeaderWords;
+  wire [AddrWidth-3:0] name_word    = counter_word - 2 * CounterCount;
+
+  assign m_arvalid = s_arvalid && !is_counter && !counter_rvalid;
+  assign m_araddr  = s_araddr;
+  assign s_arready = is_counter ? !counter_rvalid && !forwarded
+                                : m_arready && !counter_rvalid;
+
+  assign s_rvalid = counter_rvalid || m_rvalid;
+  assign s_rdata  = counter_rvalid ? counter_rdata : m_rdata;
+  assign s_rresp  = counter_rvalid ? 2'b00 : m_rresp;
+  assign m_rready = s_rready && !counter_rvalid;
+
+  integer i;
+
+  always @(posedge clk) begin
+    if (rst || (ap_start && ap_idle)) begin
+      for (i = 0; i < CounterCount; i = i + 1) begin
+        counters[i] <= 64'd0;
+      end
+    end else if (!ap_idle) begin
+      counters[0] <= counters[0] + 1;
+      for (i = 1; i < CounterCount; i = i + 1) begin
+        if (events[i-1]) begin
+          counters[i] <= counters[i] + 1;
+        end
+      end
+    end
+  end
+
+  always @(posedge clk) begin
+    if (s_arvalid && s_arready && is_counter) begin
+      if (word == 0) begin
+        counter_rdata <= Magic;
+      end else if (word == 1) begin
+        counter_rdata <= CounterCount;
+      end else if (word == 2) begin
+        counter_rdata <= NameSize;
+      end else if (word < HeaderWords) begin
+        counter_rdata <= 32'd0;
+      end else if (counter_word < 2 * CounterCount) begin
+        counter_rdata <= counter_word[0] ? counters[counter_word >> 1][63:32]
+                                         : counters[counter_word >> 1][31:0];
+      end else if (name_word < NameWordCount) begin
+        counter_rdata <= Names[name_word * 32 +: 32];
+      end else begin
+        counter_rdata <= 32'd0;
+      end
+    end
+  end
+
+  always @(posedge clk) begin
+    if (rst) begin
+      counter_rvalid <= 1'b0;
+      forwarded      <= 1'b0;
+    end else begin
+      if (s_arvalid && s_arready && is_counter) begin
+        counter_rvalid <= 1'b1;
+      end else if (s_rready) begin
+        counter_rvalid <= 1'b0;
+      end
+      if (m_arvalid && m_arready) begin
+        forwarded <= 1'b1;
+      end else if (m_rvalid && m_rready) begin
+        forwarded <= 1'b0;
+      end
+    end
+  end
+
+endmodule  // hw_counters
+
+`default_nettype wire
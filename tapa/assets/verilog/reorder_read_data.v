@@ -0,0 +1,125 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+`default_nettype none
+
+// Issue read bursts with distinct AXI IDs and restore the request order of
+// the read data, so that memory may serve the bursts out of order.
+//
+// Each burst in flight holds one of the 2**IdWidth IDs and reserves its beats
+// in a circular reorder buffer when it is issued. Read data are written to
+// the reserved beats as they arrive, and are popped in order from the buffer.
+// Bursts sharing an ID must be served in order by AXI, so an ID is only
+// reused after the last beat of its previous burst arrives.
+module reorder_read_data #(
+  parameter DataWidth     = 512,
+  parameter IdWidth       = 1,
+  parameter BurstLenWidth = 9,
+  parameter BufferSize    = 256,  // must be a power of 2
+  parameter BufferSizeLog = 8     // must equal log2(BufferSize)
+) (
+  input wire clk,
+  input wire rst,
+
+  // whether a burst of `issue_len` + 1 beats can be issued with `issue_id`
+  output wire                     issue_ready,
+  output wire [IdWidth-1:0]       issue_id,
+  input  wire                     issue,
+  input  wire [BurstLenWidth-1:0] issue_len,
+
+  // from the axi read response channel
+  input  wire                 rvalid,
+  output wire                 rready,
+  input  wire [IdWidth-1:0]   rid,
+  input  wire [DataWidth-1:0] rdata,
+  input  wire                 rlast,
+
+  // to the read data buffer
+  output wire [DataWidth-1:0] data_din,
+  input  wire                 data_full_n,
+  output wire                 data_write
+);
+
+  localparam IdCount = 1 << IdWidth;
+
+  reg [DataWidth-1:0]     buffer [0:BufferSize-1];
+  reg [BufferSize-1:0]    buffer_valid;
+  reg [BufferSizeLog-1:0] head;  // next beat to pop
+  reg [BufferSizeLog-1:0] tail;  // first beat of the next burst
+  reg [BufferSizeLog:0]   used;  // beats reserved and not popped
+
+  reg [IdCount-1:0]       busy;  // whether each ID has a burst in flight
+  reg [BufferSizeLog-1:0] next_beat [0:IdCount-1];  // next beat of each ID
+  reg [IdWidth-1:0]       next_id;
+
+  // register the popped data so that the buffer can be mapped to BRAM
+  reg                 out_valid;
+  reg [DataWidth-1:0] out_data;
+
+  wire [BufferSizeLog-1:0] rbeat = next_beat[rid];
+  wire pop = buffer_valid[head] && (!out_valid || data_full_n);
+
+  // IDs are assigned round-robin; all beats of a burst are reserved up front
+  // so that read data can always be accepted
+  assign issue_ready = !busy[next_id] && used + issue_len + 1 <= BufferSize;
+  assign issue_id    = next_id;
+  assign rready      = 1'b1;
+  assign data_din    = out_data;
+  assign data_write  = out_valid && data_full_n;
+
+  always @(posedge clk) begin
+    if (rvalid) begin
+      buffer[rbeat] <= rdata;
+    end
+    if (pop) begin
+      out_data <= buffer[head];
+    end
+  end
+
+  // a burst is issued only with a free ID, and read data only arrive for a
+  // busy ID, so `issue` and `rvalid` never update the same ID
+  always @(posedge clk) begin
+    if (issue) begin
+      next_beat[next_id] <= tail;
+    end
+    if (rvalid) begin
+      next_beat[rid] <= rbeat + 1;
+    end
+  end
+
+  always @(posedge clk) begin
+    if (rst) begin
+      buffer_valid <= {BufferSize{1'b0}};
+      head         <= {BufferSizeLog{1'b0}};
+      tail         <= {BufferSizeLog{1'b0}};
+      used         <= {(BufferSizeLog+1){1'b0}};
+      busy         <= {IdCount{1'b0}};
+      next_id      <= {IdWidth{1'b0}};
+      out_valid    <= 1'b0;
+    end else begin
+      if (issue) begin
+        busy[next_id] <= 1'b1;
+        tail          <= tail + issue_len + 1;
+        next_id       <= next_id + 1;
+      end
+      if (rvalid) begin
+        buffer_valid[rbeat] <= 1'b1;
+        if (rlast) begin
+          busy[rid] <= 1'b0;
+        end
+      end
+      if (pop) begin
+        buffer_valid[head] <= 1'b0;
+        head               <= head + 1;
+        out_valid          <= 1'b1;
+      end else if (data_write) begin
+        out_valid <= 1'b0;
+      end
+      used <= used + (issue ? issue_len + 1 : 0) - pop;
+    end
+  end
+
+endmodule  // reorder_read_data
+
+`default_nettype wire
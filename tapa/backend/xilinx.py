@@ -9,6 +9,7 @@ RapidStream Contributor License Agreement.
 import argparse
 import enum
 import glob
+import hashlib
 import logging
 import os
 import shlex
@@ -17,7 +18,7 @@ import tarfile
 import tempfile
 import xml.sax.saxutils
 import zipfile
-from collections.abc import Iterable
+from collections.abc import Iterable, Sequence
 from types import TracebackType
 from typing import BinaryIO, NamedTuple, TextIO
 from xml.etree import ElementTree as ET
@@ -99,9 +100,18 @@ class VivadoHls(subprocess.Popen):
     Args:
       commands: A string of Tcl commands.
       hls: Either 'vivado_hls' or 'vitis_hls'.
+      cwd: The working directory or empty for a temporary directory.
+      launcher: Command prefix to launch HLS with, e.g., `["ssh", "host"]` or
+          `["srun"]`. See `get_launcher_cmd_args`.
     """
 
-    def __init__(self, commands: str, hls: str = "vivado_hls", cwd: str = "") -> None:
+    def __init__(
+        self,
+        commands: str,
+        hls: str = "vivado_hls",
+        cwd: str = "",
+        launcher: Sequence[str] = (),
+    ) -> None:
         if cwd:
             self.cwd = cwd
         else:
@@ -124,6 +134,10 @@ class VivadoHls(subprocess.Popen):
             cmd_args = get_cmd_args(cmd_args, ["XILINX_HLS", "XILINX_VITIS"], kwargs)
         elif hls == "vivado_hls":
             cmd_args = get_cmd_args(cmd_args, ["XILINX_VIVADO"], kwargs)
+        if launcher:
+            cmd_args = get_launcher_cmd_args(cmd_args, launcher, cwd, kwargs["env"])
+            kwargs.pop("shell", None)
+            kwargs.pop("executable", None)
         super().__init__(cmd_args, cwd=cwd, **kwargs)
 
     def __exit__(
@@ -176,7 +190,11 @@ package_xo -force -xo_path "{xo_file}" -kernel_name {top_name} \
 """
 
 BUS_IFACE = r"""
-ipx::associate_bus_interfaces -busif {} -clock ap_clk [ipx::current_core]
+ipx::associate_bus_interfaces -busif {} -clock {} [ipx::current_core]
+"""
+
+CLOCK_2_RESET = r"""
+ipx::associate_bus_interfaces -clock ap_clk_2 -reset ap_rst_n_2 [ipx::current_core]
 """
 
 BUS_PARAM = """\
@@ -203,6 +221,8 @@ class PackageXo(Vivado):
       iface_names: Other interface names, default to (S_AXI_NAME,).
       cpp_kernels: File names of C++ kernels.
       part_num: Part number of the target device.
+      clock_2_m_axi_names: Variable names whose m_axi bus is on `ap_clk_2`
+          instead of `ap_clk`.
     """
 
     def __init__(  # noqa: PLR0913,PLR0917
@@ -215,6 +235,7 @@ class PackageXo(Vivado):
         iface_names: Iterable[str] = (S_AXI_NAME,),
         cpp_kernels: Iterable[str] = (),
         part_num: str = "",
+        clock_2_m_axi_names: Iterable[str] = (),
     ) -> None:
         self.tmpdir = tempfile.TemporaryDirectory(prefix="package-xo-")
         if _logger.isEnabledFor(logging.DEBUG):
@@ -222,10 +243,14 @@ class PackageXo(Vivado):
                 for filename in files:
                     _logger.debug("packing: %s", filename)
 
-        bus_ifaces: list[str] = list(map(BUS_IFACE.format, iface_names))
+        clock_2_m_axi_names = set(clock_2_m_axi_names)
+        bus_ifaces = [BUS_IFACE.format(x, "ap_clk") for x in iface_names]
+        if clock_2_m_axi_names:
+            bus_ifaces.append(CLOCK_2_RESET)
         for m_axi_name in m_axi_names:
             m_axi_iface_name = M_AXI_PREFIX + m_axi_name
-            bus_ifaces.append(BUS_IFACE.format(m_axi_iface_name))
+            clock = "ap_clk_2" if m_axi_name in clock_2_m_axi_names else "ap_clk"
+            bus_ifaces.append(BUS_IFACE.format(m_axi_iface_name, clock))
             if not isinstance(m_axi_names, dict):
                 continue
             for key, value in m_axi_names.get(m_axi_name, {}).items():
@@ -296,6 +321,9 @@ class RunHls(VivadoHls):
       auto_prefix: In `config_rtl`, add `-auto_prefix` or not. Note that Vitis HLS
           2020.2 enables this option regardless of the option here.
       hls: Either 'vivado_hls' or 'vitis_hls'.
+      launcher: Command prefix to launch HLS with. See `VivadoHls`.
+      tempdir_parent: Parent of the temporary working directory, which must be
+          shared with the host HLS is launched on if `launcher` is given.
     """
 
     def __init__(  # noqa: PLR0913,PLR0917
@@ -311,9 +339,13 @@ class RunHls(VivadoHls):
         hls: str = "vivado_hls",
         std: str = "c++11",
         other_configs: str = "",
+        launcher: Sequence[str] = (),
+        tempdir_parent: str | None = None,
     ) -> None:
         if work_dir is None:
-            self.tempdir = tempfile.TemporaryDirectory(prefix=f"run-hls-{top_name}-")
+            self.tempdir = tempfile.TemporaryDirectory(
+                prefix=f"run-hls-{top_name}-", dir=tempdir_parent
+            )
             self.project_path = self.tempdir.name
         else:
             self.tempdir = None
@@ -350,7 +382,9 @@ class RunHls(VivadoHls):
             "config": rtl_config,
             "other_configs": other_configs,
         }
-        super().__init__(HLS_COMMANDS.format(**kwargs), hls, self.project_path)
+        super().__init__(
+            HLS_COMMANDS.format(**kwargs), hls, self.project_path, launcher
+        )
 
     def __exit__(
         self,
@@ -717,6 +751,39 @@ def print_kernel_xml(name: str, args: Iterable[Arg], kernel_xml: TextIO) -> None
     )
 
 
+def write_args_file(xo_path: str) -> None:
+    """Write the kernel arguments of `xo_path` to `<xo_path>.args`.
+
+    The FPGA runtime reads them from there instead of extracting `kernel.xml`
+    from the xo file; see `ParseArgsFile` in `fpga-runtime/src/frt/arg_info.h`.
+    """
+    with zipfile.ZipFile(xo_path) as xo:
+        kernel_xml = next(x for x in xo.namelist() if x.endswith("/kernel.xml"))
+        root = ET.fromstring(xo.read(kernel_xml).strip())
+    lines = [f"tapa-args-v1 {os.path.getsize(xo_path)}"]
+    lines += (
+        "\t".join(arg.attrib[x] for x in ("id", "addressQualifier", "name", "type"))
+        for arg in root.findall("kernel/args/arg")
+    )
+    with open(f"{xo_path}.args", "w", encoding="utf-8") as fp:
+        fp.writelines(f"{line}\n" for line in lines)
+
+
+def write_hash_file(xo_path: str) -> None:
+    """Write the SHA-256 digest of `xo_path` to `<xo_path>.sha256`.
+
+    The file is in the format of `sha256sum`, so that `sha256sum -c` verifies
+    the xo file, and so that build caches can tell whether a reproducible xo
+    file changed without reading it again.
+    """
+    digest = hashlib.sha256()
+    with open(xo_path, "rb") as fp:
+        for chunk in iter(lambda: fp.read(1 << 20), b""):
+            digest.update(chunk)
+    with open(f"{xo_path}.sha256", "w", encoding="utf-8") as fp:
+        fp.write(f"{digest.hexdigest()}  {os.path.basename(xo_path)}\n")
+
+
 def get_cmd_args(
     cmd_args: list[str],
     env_names: Iterable[str],
@@ -751,3 +818,52 @@ def get_cmd_args(
                     ]
                 )
     return cmd_args
+
+
+def get_launcher_cmd_args(
+    cmd_args: list[str] | str,
+    launcher: Sequence[str],
+    cwd: str,
+    env: dict[str, str],
+) -> list[str]:
+    """Get command arguments that run a command through a launcher.
+
+    The command is written to a script in `cwd`, together with the environment
+    variables it needs, and the script is run as `launcher bash script`. This
+    works the same for launchers that run the command on another host, e.g.,
+    `ssh host` or `srun`, as long as `cwd` is on a file system shared with that
+    host, and the tools are installed at the same paths.
+
+    Args:
+      cmd_args: The command arguments returned by `get_cmd_args`.
+      launcher: The command prefix that launches the script.
+      cwd: The working directory of the command.
+      env: The environment of the command.
+
+    Returns:
+      Command arguments for subprocess.Popen without a shell.
+    """
+    if not isinstance(cmd_args, str):
+        cmd_args = " ".join(["exec", *map(shlex.quote, cmd_args)])
+    cwd = os.path.abspath(cwd)
+    exported_names = sorted(
+        name
+        for name in env
+        if name in {"HOME", "PATH", "LD_LIBRARY_PATH"}
+        or name.startswith("XILINX")
+        or name.endswith("LICENSE_FILE")
+    )
+    script = os.path.join(cwd, "launch.sh")
+    with open(script, "w", encoding="utf-8") as script_file:
+        script_file.write(
+            "\n".join(
+                [
+                    "#!/bin/bash",
+                    *(f"export {x}={shlex.quote(env[x])}" for x in exported_names),
+                    f"cd {shlex.quote(cwd)}",
+                    cmd_args,
+                    "",
+                ]
+            )
+        )
+    return [*launcher, "bash", script]
@@ -0,0 +1,66 @@
+"""Place AIE kernels so that kernels connected by streams are adjacent."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+from collections.abc import Iterable
+
+# PLIO widths supported by the AIE array interface tiles.
+PLIO_WIDTHS = (32, 64, 128)
+
+
+def get_plio_width(width: int) -> int:
+    """Return the narrowest PLIO width that holds `width` bits.
+
+    Ports wider than the widest PLIO are transferred over multiple beats.
+    """
+    return next((w for w in PLIO_WIDTHS if w >= width), PLIO_WIDTHS[-1])
+
+
+def order_kernels(kernels: list[str], edges: Iterable[tuple[str, str]]) -> list[str]:
+    """Return `kernels` ordered so that consumers follow their producers.
+
+    Kernels are visited depth-first along the `(producer, consumer)` edges,
+    starting from each unvisited kernel in the given order. Kernels that are
+    not connected keep their relative order.
+    """
+    consumers: dict[str, list[str]] = {kernel: [] for kernel in kernels}
+    for producer, consumer in edges:
+        consumers[producer].append(consumer)
+
+    order = []
+    visited = set()
+    for root in kernels:
+        stack = [root]
+        while stack:
+            kernel = stack.pop()
+            if kernel in visited:
+                continue
+            visited.add(kernel)
+            order.append(kernel)
+            stack.extend(reversed(consumers[kernel]))
+    return order
+
+
+def place_kernels(
+    kernels: list[str],
+    edges: Iterable[tuple[str, str]],
+    rows: int,
+) -> dict[str, tuple[int, int]]:
+    """Return the `(column, row)` tile of each kernel.
+
+    Kernels are ordered by `order_kernels` and laid out column by column in a
+    serpentine, i.e., even columns go up and odd columns go down, so that every
+    pair of consecutive kernels occupies neighboring tiles.
+    """
+    if rows <= 0:
+        msg = f"AIE array must have at least one row, got {rows}"
+        raise ValueError(msg)
+    tiles = {}
+    for idx, kernel in enumerate(order_kernels(kernels, edges)):
+        col, row = divmod(idx, rows)
+        tiles[kernel] = (col, row if col % 2 == 0 else rows - 1 - row)
+    return tiles
@@ -0,0 +1,42 @@
+"""Unit tests for tapa.common.aie_placement."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import pytest
+
+from tapa.common.aie_placement import get_plio_width, order_kernels, place_kernels
+
+
+def test_get_plio_width() -> None:
+    assert get_plio_width(8) == 32
+    assert get_plio_width(32) == 32
+    assert get_plio_width(33) == 64
+    assert get_plio_width(128) == 128
+    assert get_plio_width(512) == 128
+
+
+def test_order_kernels_follows_streams() -> None:
+    kernels = ["a0", "b0", "c0", "d0"]
+    edges = [("c0", "b0"), ("a0", "c0")]
+    assert order_kernels(kernels, edges) == ["a0", "c0", "b0", "d0"]
+
+
+def test_place_kernels_is_serpentine() -> None:
+    kernels = [f"k{i}" for i in range(5)]
+    edges = [(f"k{i}", f"k{i + 1}") for i in range(4)]
+    assert place_kernels(kernels, edges, rows=2) == {
+        "k0": (0, 0),
+        "k1": (0, 1),
+        "k2": (1, 1),
+        "k3": (1, 0),
+        "k4": (2, 0),
+    }
+
+
+def test_place_kernels_rejects_empty_array() -> None:
+    with pytest.raises(ValueError, match="at least one row"):
+        place_kernels(["k0"], [], rows=0)
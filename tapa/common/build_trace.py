@@ -0,0 +1,104 @@
+"""Record the build as a trace in the Chrome trace event format.
+
+The trace can be opened in `chrome://tracing` or https://ui.perfetto.dev.
+Spans on the same thread nest, and each thread of a parallel step, e.g., an
+HLS worker, is shown in its own row.
+"""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import contextlib
+import functools
+import json
+import os
+import resource
+import threading
+import time
+from collections.abc import Callable, Iterator
+from typing import ParamSpec, TypeVar
+
+from tapa.common.hls_memory import PeakMemoryMonitor
+
+_P = ParamSpec("_P")
+_R = TypeVar("_R")
+
+_lock = threading.Lock()
+_events: list[dict[str, object]] = []
+
+
+def _get_cpu_time() -> float:
+    """Return the CPU time of this process and its waited-for children."""
+    children = resource.getrusage(resource.RUSAGE_CHILDREN)
+    return time.process_time() + children.ru_utime + children.ru_stime
+
+
+@contextlib.contextmanager
+def span(name: str, category: str, **args: object) -> Iterator[dict[str, object]]:
+    """Record the enclosed code as a complete event of `category`.
+
+    The event records the wall time and, as `cpu_time`, the CPU time of this
+    process and its waited-for children in seconds, which includes concurrent
+    spans of other threads. The yielded arguments of the event may be updated
+    with more precise measures, e.g., the CPU time of a subprocess.
+    """
+    start = time.time()
+    cpu_start = _get_cpu_time()
+    try:
+        yield args
+    finally:
+        end = time.time()
+        args.setdefault("cpu_time", round(_get_cpu_time() - cpu_start, 3))
+        event = {
+            "name": name,
+            "cat": category,
+            "ph": "X",
+            "ts": int(start * 1e6),
+            "dur": int((end - start) * 1e6),
+            "pid": os.getpid(),
+            "tid": threading.get_ident(),
+            "args": args,
+        }
+        with _lock:
+            _events.append(event)
+
+
+def traced(name: str) -> Callable[[Callable[_P, _R]], Callable[_P, _R]]:
+    """Record each call of the decorated step, including its peak memory."""
+
+    def decorator(func: Callable[_P, _R]) -> Callable[_P, _R]:
+        @functools.wraps(func)
+        def wrapper(*args: _P.args, **kwargs: _P.kwargs) -> _R:
+            with span(name, "step") as event_args:
+                try:
+                    with PeakMemoryMonitor(os.getpid()) as monitor:
+                        return func(*args, **kwargs)
+                finally:
+                    event_args["peak_memory"] = monitor.peak
+
+        return wrapper
+
+    return decorator
+
+
+def has_events() -> bool:
+    """Return whether any event has been recorded."""
+    with _lock:
+        return bool(_events)
+
+
+def write(path: str) -> None:
+    """Write the events recorded so far to `path` as JSON."""
+    with _lock:
+        trace = {"traceEvents": list(_events), "displayTimeUnit": "ms"}
+    with open(path, "w", encoding="utf-8") as fp:
+        json.dump(trace, fp)
+
+
+def clear() -> None:
+    """Discard the events recorded so far."""
+    with _lock:
+        _events.clear()
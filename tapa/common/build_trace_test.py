@@ -0,0 +1,47 @@
+"""Unit tests for tapa.common.build_trace."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import json
+from pathlib import Path
+
+from tapa.common import build_trace
+
+
+def test_span_nests_complete_events(tmp_path: Path) -> None:
+    build_trace.clear()
+    with build_trace.span("outer", "step"):
+        with build_trace.span("inner", "hls", task="Foo") as args:
+            args["peak_memory"] = 42
+    path = tmp_path / "trace.json"
+    build_trace.write(str(path))
+
+    inner, outer = json.loads(path.read_text(encoding="utf-8"))["traceEvents"]
+    assert (inner["name"], inner["cat"], inner["ph"]) == ("inner", "hls", "X")
+    assert inner["args"]["task"] == "Foo"
+    assert inner["args"]["peak_memory"] == 42
+    assert inner["args"]["cpu_time"] >= 0
+    assert outer["ts"] <= inner["ts"]
+    assert inner["ts"] + inner["dur"] <= outer["ts"] + outer["dur"]
+
+
+def test_traced_records_peak_memory(tmp_path: Path) -> None:
+    build_trace.clear()
+
+    @build_trace.traced("synth")
+    def synth(value: int) -> int:
+        return value + 1
+
+    assert synth(1) == 2  # noqa: PLR2004
+    path = tmp_path / "trace.json"
+    build_trace.write(str(path))
+    (event,) = json.loads(path.read_text(encoding="utf-8"))["traceEvents"]
+    assert (event["name"], event["cat"]) == ("synth", "step")
+    assert event["args"]["peak_memory"] > 0
+
+    build_trace.clear()
+    assert not build_trace.has_events()
@@ -0,0 +1,95 @@
+"""Recommend FIFO depths from the stream bursts found by tapacc."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import logging
+from typing import NamedTuple
+
+_logger = logging.getLogger().getChild(__name__)
+
+# FIFOs shallower than this cannot sustain one token per cycle.
+MIN_DEPTH = 2
+
+
+class FifoDepth(NamedTuple):
+    """Declared and recommended depths of a FIFO in an upper-level task."""
+
+    task: str
+    fifo: str
+    declared: int
+    recommended: int
+
+
+def _get_burst(graph: dict, upper: dict, end: list | None, fifo: str) -> int | None:
+    """Return the burst of the port connected to `fifo` at `end`, if known.
+
+    `end` is the `[task_name, index]` pair found in `produced_by` or
+    `consumed_by`. Bursts are only known for ports of lower-level tasks.
+    """
+    if end is None:
+        return None
+    task_name, index = end
+    args = upper["tasks"][task_name][index].get("args", {})
+    port_name = next((port for port, arg in args.items() if arg["arg"] == fifo), None)
+    for port in graph["tasks"].get(task_name, {}).get("ports", []):
+        if port["name"] == port_name:
+            return port.get("burst")
+    return None
+
+
+def recommend_fifo_depths(graph: dict) -> list[FifoDepth]:
+    """Return the recommended depths of FIFOs whose both ends are analyzed.
+
+    A FIFO is recommended to hold the longest burst of tokens either end
+    transfers without touching its other streams. A shallower FIFO makes that
+    end stall, and deadlocks if the other end is in turn waiting on a stream
+    that the stalled end would only access after the burst.
+    """
+    depths = []
+    for task_name, task in graph["tasks"].items():
+        for fifo_name, fifo in task.get("fifos", {}).items():
+            if "depth" not in fifo:
+                continue  # External ports have no depth.
+            bursts = [
+                _get_burst(graph, task, fifo.get(end), fifo_name)
+                for end in ("produced_by", "consumed_by")
+            ]
+            if None in bursts:
+                continue
+            depths.append(
+                FifoDepth(
+                    task=task_name,
+                    fifo=fifo_name,
+                    declared=fifo["depth"],
+                    recommended=max(MIN_DEPTH, *bursts),
+                )
+            )
+    return depths
+
+
+def infer_fifo_depths(graph: dict, apply: bool) -> None:
+    """Report FIFOs whose depth differs from the recommended one.
+
+    If `apply` is set, the depths in `graph` are updated as recommended.
+    """
+    for depth in recommend_fifo_depths(graph):
+        if depth.declared == depth.recommended:
+            continue
+        level = logging.WARNING if depth.declared < depth.recommended else logging.INFO
+        _logger.log(
+            level,
+            "FIFO `%s` in task `%s` has depth %d; recommended depth is %d%s",
+            depth.fifo,
+            depth.task,
+            depth.declared,
+            depth.recommended,
+            " (applied)" if apply else "",
+        )
+        if apply:
+            graph["tasks"][depth.task]["fifos"][depth.fifo]["depth"] = (
+                depth.recommended
+            )
@@ -0,0 +1,69 @@
+"""Unit tests for tapa.common.fifo_depth."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+from tapa.common.fifo_depth import FifoDepth, infer_fifo_depths, recommend_fifo_depths
+
+
+def _make_graph(producer_burst: int | None, consumer_burst: int) -> dict:
+    producer_port = {"name": "out", "cat": "ostream", "width": 32, "type": "int"}
+    if producer_burst is not None:
+        producer_port["burst"] = producer_burst
+    return {
+        "top": "Top",
+        "tasks": {
+            "Top": {
+                "level": "upper",
+                "ports": [],
+                "fifos": {
+                    "q": {
+                        "depth": 4,
+                        "produced_by": ["Producer", 0],
+                        "consumed_by": ["Consumer", 0],
+                    },
+                },
+                "tasks": {
+                    "Producer": [{"step": 0, "args": {"out": {"arg": "q"}}}],
+                    "Consumer": [{"step": 0, "args": {"in": {"arg": "q"}}}],
+                },
+            },
+            "Producer": {"level": "lower", "ports": [producer_port]},
+            "Consumer": {
+                "level": "lower",
+                "ports": [
+                    {
+                        "name": "in",
+                        "cat": "istream",
+                        "width": 32,
+                        "type": "int",
+                        "burst": consumer_burst,
+                    },
+                ],
+            },
+        },
+    }
+
+
+def test_recommend_fifo_depths() -> None:
+    assert recommend_fifo_depths(_make_graph(16, 1)) == [
+        FifoDepth(task="Top", fifo="q", declared=4, recommended=16),
+    ]
+    assert recommend_fifo_depths(_make_graph(1, 1)) == [
+        FifoDepth(task="Top", fifo="q", declared=4, recommended=2),
+    ]
+
+
+def test_recommend_fifo_depths_skips_unknown_bursts() -> None:
+    assert not recommend_fifo_depths(_make_graph(None, 1))
+
+
+def test_infer_fifo_depths() -> None:
+    graph = _make_graph(16, 1)
+    infer_fifo_depths(graph, apply=False)
+    assert graph["tasks"]["Top"]["fifos"]["q"]["depth"] == 4
+    infer_fifo_depths(graph, apply=True)
+    assert graph["tasks"]["Top"]["fifos"]["q"]["depth"] == 16
@@ -0,0 +1,83 @@
+"""Pick the memory that implements each FIFO with a resource cost model."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+from typing import NamedTuple
+
+# Vivado `ram_style` of each FIFO implementation, passed as `MEM_STYLE`.
+MEM_STYLES = {
+    "srl": "shiftreg",
+    "lutram": "distributed",
+    "bram": "block",
+    "uram": "ultra",
+}
+
+# LUTs that one BRAM18 or URAM is worth, roughly the ratio of the amounts of
+# these resources on Alveo devices.
+LUTS_PER_BRAM18 = 320
+LUTS_PER_URAM = 1280
+
+# Bits per row of a BRAM18 for each maximum depth, in simple dual-port mode.
+_BRAM18_WIDTHS = ((512, 36), (1024, 18), (2048, 9), (4096, 4), (8192, 2))
+_BRAM18_DEPTH = 16384  # deepest BRAM18 configuration, 1 bit per row
+_URAM_WIDTH, _URAM_DEPTH = 72, 4096
+_SRL_DEPTH = 32  # SRLC32E
+_LUTRAM_WIDTH, _LUTRAM_DEPTH, _LUTRAM_LUTS = 3, 64, 4  # RAM64M
+
+
+class FifoCost(NamedTuple):
+    """Resources used by the memory of a FIFO."""
+
+    lut: int = 0
+    bram18: int = 0
+    uram: int = 0
+
+    def __add__(self, other: tuple) -> "FifoCost":
+        return FifoCost(*(x + y for x, y in zip(self, other)))
+
+    @property
+    def weight(self) -> int:
+        """Return the cost in LUTs."""
+        return self.lut + self.bram18 * LUTS_PER_BRAM18 + self.uram * LUTS_PER_URAM
+
+
+def _ceil_div(x: int, y: int) -> int:
+    return -(-x // y)
+
+
+def estimate_fifo_cost(style: str, width: int, depth: int) -> FifoCost:
+    """Return the resources used by a `width`x`depth` FIFO of `style`."""
+    if style == "srl":
+        return FifoCost(lut=width * _ceil_div(depth, _SRL_DEPTH))
+    if style == "lutram":
+        return FifoCost(
+            lut=_ceil_div(width, _LUTRAM_WIDTH)
+            * _ceil_div(depth, _LUTRAM_DEPTH)
+            * _LUTRAM_LUTS
+        )
+    if style == "bram":
+        for max_depth, row_width in _BRAM18_WIDTHS:
+            if depth <= max_depth:
+                return FifoCost(bram18=_ceil_div(width, row_width))
+        return FifoCost(bram18=width * _ceil_div(depth, _BRAM18_DEPTH))
+    if style == "uram":
+        return FifoCost(
+            uram=_ceil_div(width, _URAM_WIDTH) * _ceil_div(depth, _URAM_DEPTH)
+        )
+    msg = f"unknown FIFO implementation '{style}', expected one of {list(MEM_STYLES)}"
+    raise ValueError(msg)
+
+
+def pick_fifo_style(width: int, depth: int) -> str:
+    """Return the FIFO implementation that costs the fewest LUTs.
+
+    Ties are broken in the order of `MEM_STYLES`, which prefers logic over
+    memory blocks.
+    """
+    return min(
+        MEM_STYLES, key=lambda style: estimate_fifo_cost(style, width, depth).weight
+    )
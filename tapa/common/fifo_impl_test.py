@@ -0,0 +1,33 @@
+"""Unit tests for tapa.common.fifo_impl."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import pytest
+
+from tapa.common.fifo_impl import FifoCost, estimate_fifo_cost, pick_fifo_style
+
+
+def test_estimate_fifo_cost() -> None:
+    assert estimate_fifo_cost("srl", 32, 33) == FifoCost(lut=64)
+    assert estimate_fifo_cost("lutram", 32, 64) == FifoCost(lut=44)
+    assert estimate_fifo_cost("bram", 32, 512) == FifoCost(bram18=1)
+    assert estimate_fifo_cost("bram", 32, 2048) == FifoCost(bram18=4)
+    assert estimate_fifo_cost("uram", 512, 4096) == FifoCost(uram=8)
+
+
+def test_estimate_fifo_cost_rejects_unknown_style() -> None:
+    with pytest.raises(ValueError, match="unknown FIFO implementation"):
+        estimate_fifo_cost("flipflop", 32, 2)
+
+
+def test_pick_fifo_style() -> None:
+    # wide and shallow FIFOs stay in logic
+    assert pick_fifo_style(512, 32) == "srl"
+    assert pick_fifo_style(512, 64) == "lutram"
+    # deep FIFOs go to memory blocks
+    assert pick_fifo_style(32, 1024) == "bram"
+    assert pick_fifo_style(512, 8192) == "uram"
@@ -0,0 +1,211 @@
+"""Partition the top task into slots and pipeline the streams between slots."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import re
+from collections.abc import Iterable
+
+# Slots are named as in RapidStream, where each row of slots is one SLR.
+_SLOT_PATTERN = re.compile(r"SLOT_X(\d+)Y(\d+)")
+
+# Pipeline levels added for each column and each row (SLR) crossed.
+LEVELS_PER_COLUMN = 1
+LEVELS_PER_ROW = 2
+
+
+def parse_slot(slot: str) -> tuple[int, int]:
+    """Return the `(column, row)` of a slot named like `SLOT_X0Y1`."""
+    match = _SLOT_PATTERN.fullmatch(slot)
+    if match is None:
+        msg = f"invalid slot '{slot}', expected a name like 'SLOT_X0Y1'"
+        raise ValueError(msg)
+    return int(match[1]), int(match[2])
+
+
+def get_relay_level(src: str, dst: str) -> int:
+    """Return the pipeline levels of a stream from slot `src` to slot `dst`.
+
+    Streams within a slot are not pipelined. Otherwise, each column crossed
+    adds `LEVELS_PER_COLUMN` levels and each SLR crossed adds `LEVELS_PER_ROW`
+    levels, since SLR crossings are much longer than routes within an SLR.
+    """
+    src_col, src_row = parse_slot(src)
+    dst_col, dst_row = parse_slot(dst)
+    return (
+        abs(src_col - dst_col) * LEVELS_PER_COLUMN
+        + abs(src_row - dst_row) * LEVELS_PER_ROW
+    )
+
+
+def get_slots(grid: str) -> list[str]:
+    """Return the slots of a grid of `COLUMNSxROWS` slots, e.g., `1x3`."""
+    match = re.fullmatch(r"([1-9]\d*)x([1-9]\d*)", grid)
+    if match is None:
+        msg = f"invalid grid '{grid}', expected COLUMNSxROWS like '1x3'"
+        raise ValueError(msg)
+    return [
+        f"SLOT_X{col}Y{row}"
+        for row in range(int(match[2]))
+        for col in range(int(match[1]))
+    ]
+
+
+def get_crossing_cost(
+    floorplan: dict[str, str], streams: Iterable[tuple[str, str, int]]
+) -> int:
+    """Return the bits of `streams` times the relay levels they cross.
+
+    Each stream is `(producer, consumer, width)`, where the producer and the
+    consumer are keys of `floorplan`.
+    """
+    return sum(
+        width * get_relay_level(floorplan[src], floorplan[dst])
+        for src, dst, width in streams
+    )
+
+
+def partition(
+    areas: dict[str, dict[str, int]],
+    streams: Iterable[tuple[str, str, int]],
+    slots: list[str],
+    capacity: dict[str, float],
+    fixed: dict[str, str] | None = None,
+) -> dict[str, str]:
+    """Assign each instance in `areas` to one of `slots`.
+
+    The partition minimizes the crossing cost of `streams`, i.e., wide streams
+    are kept within a slot, or else within an SLR, while the area of each
+    slot stays within `capacity`, which bounds each resource in `areas`.
+    Instances in `fixed` keep their slots.
+
+    Instances are placed greedily, most connected to the placed ones first,
+    in the feasible slot that adds the least cost.  The partition is then
+    refined by moving and swapping instances while the cost decreases.
+
+    Raises:
+        ValueError: If the instances do not fit in the slots.
+    """
+    fixed = dict(fixed or {})
+    neighbors: dict[str, list[tuple[str, int]]] = {name: [] for name in areas}
+    for src, dst, width in streams:
+        if src != dst:
+            neighbors[src].append((dst, width))
+            neighbors[dst].append((src, width))
+
+    floorplan: dict[str, str] = {}
+    usage = {slot: dict.fromkeys(capacity, 0) for slot in slots}
+
+    def fits(name: str, slot: str) -> bool:
+        return all(
+            usage[slot][key] + areas[name].get(key, 0) <= limit
+            for key, limit in capacity.items()
+        )
+
+    def place(name: str, slot: str) -> None:
+        floorplan[name] = slot
+        for key in capacity:
+            usage[slot][key] += areas[name].get(key, 0)
+
+    def unplace(name: str) -> str:
+        slot = floorplan.pop(name)
+        for key in capacity:
+            usage[slot][key] -= areas[name].get(key, 0)
+        return slot
+
+    def get_cost(name: str, slot: str) -> int:
+        return sum(
+            width * get_relay_level(slot, floorplan[other])
+            for other, width in neighbors[name]
+            if other in floorplan and other != name
+        )
+
+    for name, slot in fixed.items():
+        if name not in areas:
+            msg = f"instance '{name}' is fixed to '{slot}' but does not exist"
+            raise ValueError(msg)
+        if slot not in slots:
+            msg = f"instance '{name}' is fixed to '{slot}', which is not a slot"
+            raise ValueError(msg)
+        place(name, slot)
+
+    def get_priority(name: str) -> tuple[int, int]:
+        connected = sum(width for other, width in neighbors[name] if other in floorplan)
+        return connected, sum(areas[name].values())
+
+    unplaced = [name for name in areas if name not in fixed]
+    while unplaced:
+        name = max(unplaced, key=get_priority)
+        unplaced.remove(name)
+        candidates = [slot for slot in slots if fits(name, slot)]
+        if not candidates:
+            msg = (
+                f"instance '{name}' does not fit in any of {len(slots)} slots; "
+                "use more slots or a higher utilization"
+            )
+            raise ValueError(msg)
+        place(name, min(candidates, key=lambda slot: get_cost(name, slot)))
+
+    movable = [name for name in areas if name not in fixed]
+    improved = True
+    while improved:
+        improved = False
+        for name in movable:
+            old_slot = unplace(name)
+            old_cost = get_cost(name, old_slot)
+            best = min(
+                (slot for slot in slots if fits(name, slot)),
+                key=lambda slot: get_cost(name, slot),
+            )
+            if get_cost(name, best) < old_cost:
+                improved = True
+                place(name, best)
+            else:
+                place(name, old_slot)
+
+        for i, name in enumerate(movable):
+            for other in movable[i + 1 :]:
+                slot, other_slot = floorplan[name], floorplan[other]
+                if slot == other_slot:
+                    continue
+                old_cost = get_cost(name, slot) + get_cost(other, other_slot)
+                unplace(name)
+                unplace(other)
+                if fits(name, other_slot) and fits(other, slot):
+                    place(name, other_slot)
+                    place(other, slot)
+                    if get_cost(name, other_slot) + get_cost(other, slot) < old_cost:
+                        improved = True
+                        continue
+                    unplace(name)
+                    unplace(other)
+                place(name, slot)
+                place(other, other_slot)
+    return floorplan
+
+
+def get_pblock_constraints(floorplan: dict[str, str]) -> str:
+    """Return Vivado constraints that place instances in the SLR of their slot.
+
+    Each row of slots is an SLR, so instances are added to one pblock per SLR.
+    Columns within an SLR are left to the placer.
+    """
+    rows: dict[int, list[str]] = {}
+    for name, slot in sorted(floorplan.items()):
+        rows.setdefault(parse_slot(slot)[1], []).append(name)
+    lines = []
+    for row, names in sorted(rows.items()):
+        pblock = f"pblock_tapa_SLR{row}"
+        lines += [
+            f"create_pblock {pblock}",
+            f"resize_pblock {pblock} -add SLR{row}",
+            *(
+                f"add_cells_to_pblock {pblock} "
+                f'[get_cells -hierarchical -filter {{NAME =~ "*/{name}"}}]'
+                for name in names
+            ),
+        ]
+    return "".join(f"{line}\n" for line in lines)
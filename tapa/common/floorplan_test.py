@@ -0,0 +1,85 @@
+"""Unit tests for tapa.common.floorplan."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import pytest
+
+from tapa.common.floorplan import (
+    get_crossing_cost,
+    get_pblock_constraints,
+    get_relay_level,
+    get_slots,
+    parse_slot,
+    partition,
+)
+
+
+def test_parse_slot() -> None:
+    assert parse_slot("SLOT_X1Y3") == (1, 3)
+
+
+def test_parse_slot_rejects_invalid_names() -> None:
+    with pytest.raises(ValueError, match="invalid slot"):
+        parse_slot("SLR0")
+
+
+def test_get_relay_level() -> None:
+    assert get_relay_level("SLOT_X0Y0", "SLOT_X0Y0") == 0
+    assert get_relay_level("SLOT_X0Y0", "SLOT_X1Y0") == 1
+    assert get_relay_level("SLOT_X0Y2", "SLOT_X0Y0") == 4
+    assert get_relay_level("SLOT_X1Y0", "SLOT_X0Y1") == 3
+
+
+def test_get_slots() -> None:
+    assert get_slots("2x2") == ["SLOT_X0Y0", "SLOT_X1Y0", "SLOT_X0Y1", "SLOT_X1Y1"]
+    with pytest.raises(ValueError, match="invalid grid"):
+        get_slots("0x3")
+
+
+def test_partition_keeps_wide_streams_within_a_slot() -> None:
+    # A chain A -> B -> C -> D where only B -> C is narrow, and two instances
+    # fit in a slot.
+    areas = {name: {"LUT": 10} for name in "ABCD"}
+    streams = [("A", "B", 512), ("B", "C", 1), ("C", "D", 512)]
+    slots = get_slots("1x2")
+    floorplan = partition(areas, streams, slots, {"LUT": 20})
+    assert floorplan["A"] == floorplan["B"]
+    assert floorplan["C"] == floorplan["D"]
+    assert floorplan["A"] != floorplan["C"]
+    assert get_crossing_cost(floorplan, streams) == 2
+
+
+def test_partition_prefers_crossing_columns_to_rows() -> None:
+    areas = {name: {"LUT": 10} for name in "AB"}
+    floorplan = partition(
+        areas, [("A", "B", 32)], get_slots("2x2"), {"LUT": 10}, {"A": "SLOT_X0Y0"}
+    )
+    assert floorplan == {"A": "SLOT_X0Y0", "B": "SLOT_X1Y0"}
+
+
+def test_partition_rejects_designs_too_large() -> None:
+    areas = {name: {"LUT": 10} for name in "ABC"}
+    with pytest.raises(ValueError, match="does not fit"):
+        partition(areas, [], get_slots("1x2"), {"LUT": 10})
+
+
+def test_get_pblock_constraints() -> None:
+    constraints = get_pblock_constraints(
+        {"A_0": "SLOT_X0Y1", "B_0": "SLOT_X1Y1", "C_0": "SLOT_X0Y0"}
+    )
+    assert constraints.splitlines() == [
+        "create_pblock pblock_tapa_SLR0",
+        "resize_pblock pblock_tapa_SLR0 -add SLR0",
+        "add_cells_to_pblock pblock_tapa_SLR0 "
+        '[get_cells -hierarchical -filter {NAME =~ "*/C_0"}]',
+        "create_pblock pblock_tapa_SLR1",
+        "resize_pblock pblock_tapa_SLR1 -add SLR1",
+        "add_cells_to_pblock pblock_tapa_SLR1 "
+        '[get_cells -hierarchical -filter {NAME =~ "*/A_0"}]',
+        "add_cells_to_pblock pblock_tapa_SLR1 "
+        '[get_cells -hierarchical -filter {NAME =~ "*/B_0"}]',
+    ]
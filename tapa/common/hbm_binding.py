@@ -0,0 +1,96 @@
+"""Assignment of HBM pseudo-channels to the mmap ports of a kernel.
+
+Each port is bound to one pseudo-channel. Ports are bound in descending order
+of their estimated traffic, each to the pseudo-channel with the least traffic
+so far. Ties go to the HBM stack with the least traffic, so that heavy ports
+are spread across stacks, and then to the pseudo-channel with fewer ports.
+"""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import fnmatch
+import json
+from collections.abc import Iterable, Mapping
+from pathlib import Path
+
+# HBM of Alveo U50, U55C, and U280 has 2 stacks of 16 pseudo-channels each.
+DEFAULT_CHANNEL_COUNT = 32
+CHANNELS_PER_STACK = 16
+
+
+def load_port_stats(path: Path, widths: Mapping[str, int]) -> dict[str, float]:
+    """Return the bytes transferred by each mmap port in `port_stats.json`.
+
+    `path` is written by fast cosim, and `widths` maps ports to their data
+    widths in bits. Ports not in `widths` are ignored.
+    """
+    with path.open(encoding="utf-8") as fp:
+        ports = json.load(fp)["ports"]
+    return {
+        name: (stats.get("read_beats", 0) + stats.get("write_beats", 0))
+        * widths[name]
+        / 8
+        for name, stats in ports.items()
+        if name in widths
+    }
+
+
+def apply_traffic_hints(
+    traffic: Mapping[str, float], ports: Iterable[str], hints: Iterable[str]
+) -> dict[str, float]:
+    """Return `traffic` of `ports` overridden by `hints`.
+
+    Each hint is `pattern=weight`, which sets the traffic of ports matching the
+    glob `pattern`. Later hints take precedence. Ports without traffic have 0.
+    """
+    result = {port: traffic.get(port, 0.0) for port in ports}
+    for hint in hints:
+        pattern, sep, weight = hint.rpartition("=")
+        try:
+            value = float(weight)
+        except ValueError:
+            value = -1.0
+        if not sep or value < 0:
+            msg = f"invalid HBM traffic hint '{hint}'; expect 'port=weight'"
+            raise ValueError(msg)
+        matched = fnmatch.filter(result, pattern)
+        if not matched:
+            msg = f"HBM traffic hint '{hint}' matches no mmap port"
+            raise ValueError(msg)
+        for port in matched:
+            result[port] = value
+    return result
+
+
+def bind_channels(
+    traffic: Mapping[str, float], channel_count: int = DEFAULT_CHANNEL_COUNT
+) -> dict[str, int]:
+    """Return the pseudo-channel bound to each port of `traffic`."""
+    if channel_count <= 0:
+        msg = f"invalid HBM pseudo-channel count: {channel_count}"
+        raise ValueError(msg)
+    stack_count = -(-channel_count // CHANNELS_PER_STACK)
+    channel_loads = [0.0] * channel_count
+    channel_ports = [0] * channel_count
+    stack_loads = [0.0] * stack_count
+
+    binding = {}
+    for port in sorted(traffic, key=lambda x: (-traffic[x], x)):
+        channel = min(
+            range(channel_count),
+            key=lambda x: (
+                channel_loads[x],
+                stack_loads[x // CHANNELS_PER_STACK],
+                channel_ports[x],
+                x,
+            ),
+        )
+        binding[port] = channel
+        channel_loads[channel] += traffic[port]
+        channel_ports[channel] += 1
+        stack_loads[channel // CHANNELS_PER_STACK] += traffic[port]
+    return binding
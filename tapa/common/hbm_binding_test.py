@@ -0,0 +1,68 @@
+"""Unit tests for tapa.common.hbm_binding."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import json
+from pathlib import Path
+
+import pytest
+
+from tapa.common.hbm_binding import (
+    apply_traffic_hints,
+    bind_channels,
+    load_port_stats,
+)
+
+
+def test_bind_channels_spreads_heavy_ports_across_stacks() -> None:
+    binding = bind_channels({"a": 100, "b": 90, "c": 80, "d": 1})
+    assert binding == {"a": 0, "b": 16, "c": 17, "d": 1}
+
+
+def test_bind_channels_shares_channels_by_traffic() -> None:
+    traffic = {"heavy": 10, "light_0": 3, "light_1": 3, "light_2": 3}
+    binding = bind_channels(traffic, channel_count=2)
+    assert binding == {"heavy": 0, "light_0": 1, "light_1": 1, "light_2": 1}
+
+
+def test_bind_channels_spreads_ports_without_traffic() -> None:
+    binding = bind_channels(dict.fromkeys(("a", "b", "c"), 0))
+    assert sorted(binding.values()) == [0, 1, 2]
+
+
+def test_bind_channels_rejects_no_channels() -> None:
+    with pytest.raises(ValueError, match="pseudo-channel count"):
+        bind_channels({"a": 1}, channel_count=0)
+
+
+def test_apply_traffic_hints() -> None:
+    traffic = apply_traffic_hints(
+        {"a_0": 5, "b": 7},
+        ["a_0", "a_1", "b"],
+        ["a_*=2", "a_1=3"],
+    )
+    assert traffic == {"a_0": 2, "a_1": 3, "b": 7}
+
+
+@pytest.mark.parametrize("hint", ["a", "a=x", "a=-1", "c=1"])
+def test_apply_traffic_hints_rejects_invalid_hints(hint: str) -> None:
+    with pytest.raises(ValueError, match="HBM traffic hint"):
+        apply_traffic_hints({}, ["a", "b"], [hint])
+
+
+def test_load_port_stats(tmp_path: Path) -> None:
+    path = tmp_path / "port_stats.json"
+    path.write_text(
+        json.dumps({
+            "cycles": 100,
+            "ports": {
+                "a": {"read_beats": 3, "write_beats": 1},
+                "q": {"read_beats": 9},
+            },
+        })
+    )
+    assert load_port_stats(path, {"a": 512}) == {"a": 256}
@@ -0,0 +1,67 @@
+"""Content-addressed cache of HLS tarballs shared across work directories."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import logging
+import os
+import shutil
+import tempfile
+from pathlib import Path
+
+_logger = logging.getLogger().getChild(__name__)
+
+
+class HlsCache:
+    """Tarballs keyed by the digest of everything they depend on.
+
+    The cache is a flat directory of `<key>.tar` files, so it can be shared
+    across work directories and, e.g., over NFS, across machines. Entries are
+    written to a temporary file and then renamed, so concurrent readers never
+    see a partially written tarball.
+    """
+
+    def __init__(self, directory: str | Path) -> None:
+        self.directory = Path(directory)
+
+    def _get_path(self, key: str) -> Path:
+        return self.directory / f"{key}.tar"
+
+    def load(self, key: str, tar: str | Path) -> bool:
+        """Copy the tarball of `key` to `tar`; return whether it was cached."""
+        try:
+            _copy_atomically(self._get_path(key), Path(tar))
+        except FileNotFoundError:
+            return False
+        _logger.debug("loaded %s from HLS cache entry %s", tar, key)
+        return True
+
+    def store(self, key: str, tar: str | Path) -> None:
+        """Add tarball `tar` to the cache as the entry of `key`.
+
+        Failing to write the cache is not fatal since the tarball is still
+        usable in the work directory.
+        """
+        try:
+            self.directory.mkdir(parents=True, exist_ok=True)
+            _copy_atomically(Path(tar), self._get_path(key))
+        except OSError as e:
+            _logger.warning("cannot store %s in HLS cache: %s", tar, e)
+        else:
+            _logger.debug("stored %s as HLS cache entry %s", tar, key)
+
+
+def _copy_atomically(src: Path, dst: Path) -> None:
+    with tempfile.NamedTemporaryFile(
+        dir=dst.parent, prefix=f".{dst.name}.", delete=False
+    ) as tmp:
+        try:
+            with open(src, "rb") as src_fp:
+                shutil.copyfileobj(src_fp, tmp)
+        except BaseException:
+            os.unlink(tmp.name)
+            raise
+    os.replace(tmp.name, dst)
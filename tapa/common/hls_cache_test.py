@@ -0,0 +1,32 @@
+"""Unit tests for tapa.common.hls_cache."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+from pathlib import Path
+
+from tapa.common.hls_cache import HlsCache
+
+
+def test_store_and_load(tmp_path: Path) -> None:
+    cache = HlsCache(tmp_path / "cache")
+    tar = tmp_path / "task.tar"
+    tar.write_bytes(b"rtl")
+    cache.store("key", tar)
+
+    loaded = tmp_path / "work" / "task.tar"
+    loaded.parent.mkdir()
+    assert cache.load("key", loaded)
+    assert loaded.read_bytes() == b"rtl"
+    assert sorted(p.name for p in (tmp_path / "cache").iterdir()) == ["key.tar"]
+
+
+def test_load_missing_entry(tmp_path: Path) -> None:
+    cache = HlsCache(tmp_path / "cache")
+    tar = tmp_path / "task.tar"
+    assert not cache.load("key", tar)
+    assert not tar.exists()
+    assert list(tmp_path.iterdir()) == []
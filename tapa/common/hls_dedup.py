@@ -0,0 +1,75 @@
+"""Find tasks whose HLS results only differ in the task name."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import copy
+import difflib
+import io
+import re
+import tarfile
+
+
+def find_duplicate_tasks(codes: dict[str, str], reference: str) -> dict[str, str]:
+    """Return tasks mapped to an earlier task whose code is the same modulo name.
+
+    `codes` maps task names to their extracted code, and `reference` is the
+    extracted code of a task not in `codes`, e.g., the top-level task. Every
+    task is extracted from the same translation unit with the bodies of the
+    other tasks stripped, so the code of a task differs from `reference` only
+    where either of them keeps its body. The differences shared by all tasks
+    are those of the reference task; the rest are those of the task itself,
+    which are compared with the task name masked.
+    """
+    ref_lines = reference.splitlines(keepends=True)
+    diffs: dict[str, set[tuple[int, int, str]]] = {}
+    for name, code in codes.items():
+        code_lines = code.splitlines(keepends=True)
+        matcher = difflib.SequenceMatcher(None, ref_lines, code_lines, autojunk=False)
+        diffs[name] = {
+            (i1, i2, "".join(code_lines[j1:j2]))
+            for tag, i1, i2, j1, j2 in matcher.get_opcodes()
+            if tag != "equal"
+        }
+    if len(diffs) < 2:  # noqa: PLR2004
+        return {}
+    common = set.intersection(*diffs.values())
+
+    representatives: dict[tuple[str, ...], str] = {}
+    duplicates = {}
+    for name, diff in diffs.items():
+        name_re = re.compile(rf"\b{re.escape(name)}\b")
+        key = tuple(
+            sorted(
+                name_re.sub("\0", "".join(ref_lines[i1:i2]) + "\0\0" + text)
+                for i1, i2, text in diff - common
+            )
+        )
+        representative = representatives.setdefault(key, name)
+        if representative != name:
+            duplicates[name] = representative
+    return duplicates
+
+
+def rename_hls_tar(src: str, dst: str, old: str, new: str) -> None:
+    """Copy the HLS tarball of task `old` as that of the equivalent task `new`.
+
+    HLS prefixes the names of all generated modules and reports with the task
+    name, so `old` followed by a non-word character or `_` is replaced with
+    `new` in both the member names and their contents.
+    """
+    pattern = re.compile(rf"\b{re.escape(old)}(?=\b|_)".encode())
+    with tarfile.open(src) as src_tar, tarfile.open(dst, "w") as dst_tar:
+        for info in src_tar:
+            new_info = copy.copy(info)
+            new_info.name = pattern.sub(new.encode(), info.name.encode()).decode()
+            fileobj = src_tar.extractfile(info)
+            if fileobj is None:
+                dst_tar.addfile(new_info)
+                continue
+            content = pattern.sub(new.encode(), fileobj.read())
+            new_info.size = len(content)
+            dst_tar.addfile(new_info, io.BytesIO(content))
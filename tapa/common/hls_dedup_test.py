@@ -0,0 +1,54 @@
+"""Unit tests for tapa.common.hls_dedup."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import io
+import tarfile
+from pathlib import Path
+
+from tapa.common.hls_dedup import find_duplicate_tasks, rename_hls_tar
+
+_BODIES = {
+    "PeA": "void PeA(int& x) {\n  x += 1;\n}\n",
+    "PeB": "void PeB(int& x) {\n  x += 1;\n}\n",
+    "PeC": "void PeC(int& x) {\n  x += 2;\n}\n",
+    "Top": "void Top(int& x) {\n  PeA(x);\n  PeB(x);\n  PeC(x);\n}\n",
+}
+
+
+def _extract(name: str) -> str:
+    """Mimic tapacc by stripping the bodies of all tasks but `name`."""
+    return "\n".join(
+        body if task == name else body.split(" {")[0] + " ;\n"
+        for task, body in _BODIES.items()
+    )
+
+
+def test_find_duplicate_tasks() -> None:
+    codes = {name: _extract(name) for name in ("PeA", "PeB", "PeC")}
+    assert find_duplicate_tasks(codes, _extract("Top")) == {"PeB": "PeA"}
+
+
+def test_find_duplicate_tasks_needs_two_tasks() -> None:
+    assert not find_duplicate_tasks({"PeA": _extract("PeA")}, _extract("Top"))
+
+
+def test_rename_hls_tar(tmp_path: Path) -> None:
+    src = tmp_path / "PeA.tar"
+    with tarfile.open(src, "w") as tar:
+        content = b"module PeA_fifo_w32; endmodule\nmodule PeA; PeAx y;"
+        info = tarfile.TarInfo("hdl/PeA.v")
+        info.size = len(content)
+        tar.addfile(info, io.BytesIO(content))
+
+    dst = tmp_path / "PeB.tar"
+    rename_hls_tar(str(src), str(dst), "PeA", "PeB")
+    with tarfile.open(dst) as tar:
+        assert tar.getnames() == ["hdl/PeB.v"]
+        fileobj = tar.extractfile("hdl/PeB.v")
+        assert fileobj is not None
+        assert fileobj.read() == b"module PeB_fifo_w32; endmodule\nmodule PeB; PeAx y;"
@@ -0,0 +1,129 @@
+"""Schedule HLS jobs by their memory usage."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import contextlib
+import json
+import logging
+import threading
+from collections.abc import Iterator
+from pathlib import Path
+
+import psutil
+
+_logger = logging.getLogger().getChild(__name__)
+
+# Memory assumed for a job that has never run, in bytes.
+DEFAULT_JOB_MEMORY = 4 << 30
+
+# Interval between samples of the memory usage of a job, in seconds.
+_SAMPLE_INTERVAL = 1.0
+
+
+class MemoryBudget:
+    """Admits jobs as long as their estimated memory fits in a budget.
+
+    A job larger than the whole budget is admitted when no other job runs, so
+    that every job eventually runs.
+    """
+
+    def __init__(self, total: int) -> None:
+        self.total = total
+        self._used = 0
+        self._cond = threading.Condition()
+
+    @contextlib.contextmanager
+    def reserve(self, size: int) -> Iterator[None]:
+        """Block until `size` bytes fit in the budget and hold them."""
+        with self._cond:
+            self._cond.wait_for(
+                lambda: self._used == 0 or self._used + size <= self.total
+            )
+            self._used += size
+        try:
+            yield
+        finally:
+            with self._cond:
+                self._used -= size
+                self._cond.notify_all()
+
+
+class MemoryHistory:
+    """Peak memory usage of past jobs, persisted as a JSON file."""
+
+    def __init__(self, path: str | Path) -> None:
+        self.path = Path(path)
+        self._lock = threading.Lock()
+        try:
+            self._peaks: dict[str, int] = json.loads(
+                self.path.read_text(encoding="utf-8")
+            )
+        except (FileNotFoundError, json.JSONDecodeError):
+            self._peaks = {}
+
+    def estimate(self, name: str, default: int = DEFAULT_JOB_MEMORY) -> int:
+        """Return the peak memory of job `name` in its last run, or `default`."""
+        with self._lock:
+            return self._peaks.get(name, default)
+
+    def update(self, name: str, peak: int) -> None:
+        """Record `peak` as the peak memory of job `name` and save the history."""
+        with self._lock:
+            self._peaks[name] = peak
+            self.path.write_text(
+                json.dumps(self._peaks, indent=2, sort_keys=True), encoding="utf-8"
+            )
+
+
+class PeakMemoryMonitor:
+    """Samples the memory usage of a process tree in a background thread.
+
+    Use as a context manager around the lifetime of the process. `peak` is
+    the largest resident set size of the process and its descendants seen,
+    and `cpu_time` is the CPU time in seconds they used as of the last sample.
+    """
+
+    def __init__(self, pid: int) -> None:
+        self.peak = 0
+        self.cpu_time = 0.0
+        self._pid = pid
+        self._stopped = threading.Event()
+        self._thread = threading.Thread(target=self._run, daemon=True)
+
+    def __enter__(self) -> "PeakMemoryMonitor":
+        self._thread.start()
+        return self
+
+    def __exit__(self, *args: object) -> None:
+        self._stopped.set()
+        self._thread.join()
+
+    def _run(self) -> None:
+        while True:
+            rss, cpu_time = _get_tree_usage(self._pid)
+            self.peak = max(self.peak, rss)
+            self.cpu_time = max(self.cpu_time, cpu_time)
+            if self._stopped.wait(_SAMPLE_INTERVAL):
+                return
+
+
+def _get_tree_usage(pid: int) -> tuple[int, float]:
+    try:
+        proc = psutil.Process(pid)
+        procs = [proc, *proc.children(recursive=True)]
+    except psutil.NoSuchProcess:
+        return 0, 0.0
+    rss = 0
+    cpu_time = 0.0
+    for p in procs:
+        with contextlib.suppress(psutil.NoSuchProcess, psutil.AccessDenied):
+            rss += p.memory_info().rss
+            # Exited descendants count once waited for by their parents.
+            times = p.cpu_times()
+            cpu_time += times.user + times.system
+            cpu_time += times.children_user + times.children_system
+    return rss, cpu_time
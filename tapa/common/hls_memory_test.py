@@ -0,0 +1,49 @@
+"""Unit tests for tapa.common.hls_memory."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import os
+import threading
+from pathlib import Path
+
+from tapa.common.hls_memory import MemoryBudget, MemoryHistory, PeakMemoryMonitor
+
+
+def test_memory_budget_blocks_until_released() -> None:
+    budget = MemoryBudget(10)
+    admitted = threading.Event()
+
+    def reserve() -> None:
+        with budget.reserve(6):
+            admitted.set()
+
+    with budget.reserve(6):
+        thread = threading.Thread(target=reserve)
+        thread.start()
+        assert not admitted.wait(0.1)
+    thread.join()
+    assert admitted.is_set()
+
+
+def test_memory_budget_admits_oversized_job_alone() -> None:
+    budget = MemoryBudget(10)
+    with budget.reserve(20):
+        pass
+
+
+def test_memory_history(tmp_path: Path) -> None:
+    history = MemoryHistory(tmp_path / "history.json")
+    assert history.estimate("task", default=1) == 1
+    history.update("task", 42)
+    assert MemoryHistory(tmp_path / "history.json").estimate("task") == 42
+
+
+def test_peak_memory_monitor() -> None:
+    with PeakMemoryMonitor(os.getpid()) as monitor:
+        pass
+    assert monitor.peak > 0
+    assert monitor.cpu_time > 0
@@ -0,0 +1,141 @@
+"""Summaries of HLS synthesis reports, parsed once per HLS result."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import decimal
+import json
+import logging
+from pathlib import Path
+from typing import NamedTuple
+from xml.etree import ElementTree as ET
+
+_logger = logging.getLogger().getChild(__name__)
+
+
+class HlsReport(NamedTuple):
+    """What TAPA uses from the csynth XML report of a task."""
+
+    part_num: str
+    clock_period: decimal.Decimal
+    area: dict[str, int]
+    # Resources of the device, or empty if the report does not have them.
+    available: dict[str, int]
+    # Worst-case cycles of an invocation, or `None` if data-dependent.
+    latency: int | None
+    # Largest initiation interval of the innermost loops and the largest
+    # latency of their iterations, or `None` if the task has no such loops.
+    # Iterations of loops that are not pipelined do not overlap, so their
+    # initiation interval is their iteration latency.
+    loop_ii: int | None
+    loop_depth: int | None
+
+
+def _get_int(element: ET.Element | None) -> int | None:
+    """Return the integer in `element`, or `None` if it is not one, e.g., `undef`."""
+    if element is None or element.text is None:
+        return None
+    try:
+        return int(element.text)
+    except ValueError:
+        return None
+
+
+def _get_innermost_loops(xml: ET.ElementTree) -> list[tuple[int, int]]:
+    """Return the initiation interval and iteration latency of innermost loops.
+
+    Loops are nested in their parent loops in the report.  Pipelined loops
+    flatten the loops they contain, so they are innermost as well.
+    """
+    loops = []
+    for loop in xml.iterfind("./PerformanceEstimates/SummaryOfLoopLatency//*"):
+        if loop.find("TripCount") is None:
+            continue
+        ii = _get_int(loop.find("PipelineII"))
+        if ii is not None:
+            loops.append((ii, _get_int(loop.find("PipelineDepth")) or ii))
+        elif not any(child.find("TripCount") is not None for child in loop):
+            latency = _get_int(loop.find("IterationLatency"))
+            if latency is not None:
+                loops.append((latency, latency))
+    return loops
+
+
+def _parse_hls_report(path: Path) -> HlsReport:
+    xml = ET.parse(path)
+    part = xml.find("./UserAssignments/Part")
+    assert part is not None
+    assert part.text
+    period = xml.find(
+        "./PerformanceEstimates/SummaryOfTimingAnalysis/EstimatedClockPeriod",
+    )
+    assert period is not None
+    assert period.text
+    resources = xml.find("./AreaEstimates/Resources")
+    assert resources is not None
+    available = xml.find("./AreaEstimates/AvailableResources")
+    loops = _get_innermost_loops(xml)
+    return HlsReport(
+        part_num=part.text,
+        clock_period=decimal.Decimal(period.text),
+        area={
+            x.tag: int(x.text or "-1") for x in sorted(resources, key=lambda x: x.tag)
+        },
+        available=(
+            {} if available is None else {x.tag: int(x.text or "0") for x in available}
+        ),
+        latency=_get_int(
+            xml.find("./PerformanceEstimates/SummaryOfOverallLatency/Worst-caseLatency")
+        ),
+        loop_ii=max((ii for ii, _ in loops), default=None),
+        loop_depth=max((depth for _, depth in loops), default=None),
+    )
+
+
+def load_hls_report(path: str | Path) -> HlsReport:
+    """Return the summary of the csynth XML report at `path`.
+
+    The summary is saved to `<path>.summary.json` with the size and mtime of
+    the report, and reused while they are unchanged. Extracting the same
+    tarball again keeps the mtime, so each report is only parsed once.
+    """
+    path = Path(path)
+    summary_path = path.with_name(path.name + ".summary.json")
+    stat = path.stat()
+    stamp = [stat.st_size, stat.st_mtime_ns]
+    try:
+        summary = json.loads(summary_path.read_text(encoding="utf-8"))
+        if summary["stamp"] == stamp:
+            return HlsReport(
+                part_num=summary["part_num"],
+                clock_period=decimal.Decimal(summary["clock_period"]),
+                area=summary["area"],
+                available=summary["available"],
+                latency=summary["latency"],
+                loop_ii=summary["loop_ii"],
+                loop_depth=summary["loop_depth"],
+            )
+    except (FileNotFoundError, json.JSONDecodeError, KeyError):
+        pass
+
+    _logger.debug("parsing HLS report %s", path)
+    report = _parse_hls_report(path)
+    summary_path.write_text(
+        json.dumps(
+            {
+                "stamp": stamp,
+                "part_num": report.part_num,
+                "clock_period": str(report.clock_period),
+                "area": report.area,
+                "available": report.available,
+                "latency": report.latency,
+                "loop_ii": report.loop_ii,
+                "loop_depth": report.loop_depth,
+            }
+        ),
+        encoding="utf-8",
+    )
+    return report
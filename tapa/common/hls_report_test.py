@@ -0,0 +1,76 @@
+"""Unit tests for tapa.common.hls_report."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import decimal
+import os
+from pathlib import Path
+
+from tapa.common.hls_report import load_hls_report
+
+_XML = """<profile>
+  <UserAssignments><Part>xcu250-figd2104-2L-e</Part></UserAssignments>
+  <PerformanceEstimates>
+    <SummaryOfTimingAnalysis>
+      <EstimatedClockPeriod>{period}</EstimatedClockPeriod>
+    </SummaryOfTimingAnalysis>
+    <SummaryOfOverallLatency>
+      <Worst-caseLatency>undef</Worst-caseLatency>
+    </SummaryOfOverallLatency>
+    <SummaryOfLoopLatency>
+      <outer>
+        <TripCount>undef</TripCount>
+        <IterationLatency>undef</IterationLatency>
+        <inner>
+          <TripCount>64</TripCount>
+          <PipelineII>2</PipelineII>
+          <PipelineDepth>9</PipelineDepth>
+        </inner>
+      </outer>
+      <copy>
+        <TripCount>16</TripCount>
+        <IterationLatency>3</IterationLatency>
+      </copy>
+    </SummaryOfLoopLatency>
+  </PerformanceEstimates>
+  <AreaEstimates>
+    <Resources><LUT>42</LUT><FF>7</FF><DSP>0</DSP></Resources>
+    <AvailableResources><LUT>1000</LUT><FF>2000</FF></AvailableResources>
+  </AreaEstimates>
+</profile>
+"""
+
+
+def test_load_hls_report(tmp_path: Path) -> None:
+    path = tmp_path / "Task_csynth.xml"
+    path.write_text(_XML.format(period="2.345"), encoding="utf-8")
+    report = load_hls_report(path)
+    assert report.part_num == "xcu250-figd2104-2L-e"
+    assert report.clock_period == decimal.Decimal("2.345")
+    assert report.area == {"DSP": 0, "FF": 7, "LUT": 42}
+    assert list(report.area) == ["DSP", "FF", "LUT"]
+    assert report.available == {"LUT": 1000, "FF": 2000}
+    assert report.latency is None
+    # `copy` is not pipelined, so its iterations start every 3 cycles.
+    assert report.loop_ii == 3
+    assert report.loop_depth == 9
+
+
+def test_load_hls_report_reuses_summary(tmp_path: Path) -> None:
+    path = tmp_path / "Task_csynth.xml"
+    path.write_text(_XML.format(period="2.345"), encoding="utf-8")
+    load_hls_report(path)
+
+    # A summary with the same stamp is used without parsing the report.
+    mtime_ns = path.stat().st_mtime_ns
+    path.write_text(_XML.format(period="9.999"), encoding="utf-8")
+    os.utime(path, ns=(mtime_ns, mtime_ns))
+    assert load_hls_report(path).clock_period == decimal.Decimal("2.345")
+
+    # A changed report is parsed again.
+    os.utime(path, ns=(mtime_ns + 1, mtime_ns + 1))
+    assert load_hls_report(path).clock_period == decimal.Decimal("9.999")
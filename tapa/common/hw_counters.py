@@ -0,0 +1,65 @@
+"""Layout of hardware counters read through the control registers.
+
+The counters are served as 32-bit words of `s_axi_control` from `BASE_ADDR`,
+above the registers generated by HLS, which are in the first half of the
+4 KiB control address space of a Vitis kernel:
+
+  BASE_ADDR + 0x0:          `MAGIC`, to tell counters from aliased registers
+  BASE_ADDR + 0x4:          number of 64-bit counters
+  BASE_ADDR + 0x8:          size of the names in bytes
+  BASE_ADDR + 0x10 + 8 * i: counter `i`, lower word first
+  after the counters:       the names, NUL-terminated and padded with NULs
+
+Counter 0 counts the cycles the kernel runs. The names are `kind:name` of
+each stream or mmap, whose counters follow in the order of `COUNTERS[kind]`.
+"""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+from collections.abc import Iterable
+
+# Width of byte addresses in the 4 KiB control address space.
+ADDR_WIDTH = 12
+BASE_ADDR = 0x800
+WINDOW_SIZE = 0x800
+HEADER_SIZE = 0x10
+MAGIC = 0x54415041  # "TAPA" in ASCII
+
+# Events counted for each kind of monitored interface.
+COUNTERS = {
+    "stream": ("full_cycles", "empty_cycles", "transfers"),
+    "mmap": (
+        "read_beats",
+        "write_beats",
+        "read_stall_cycles",
+        "write_stall_cycles",
+    ),
+}
+
+
+def encode_names(entries: Iterable[tuple[str, str]]) -> bytes:
+    """Return the names of `(kind, name)` entries as served to the host."""
+    data = b"".join(f"{kind}:{name}".encode() + b"\0" for kind, name in entries)
+    return data + b"\0" * (-len(data) % 4)
+
+
+def get_counter_count(entries: Iterable[tuple[str, str]]) -> int:
+    """Return the number of counters, including the cycle counter."""
+    return 1 + sum(len(COUNTERS[kind]) for kind, _ in entries)
+
+
+def check_size(entries: Iterable[tuple[str, str]]) -> None:
+    """Raise ValueError if the counters of `entries` exceed `WINDOW_SIZE`."""
+    entries = tuple(entries)
+    size = HEADER_SIZE + 8 * get_counter_count(entries) + len(encode_names(entries))
+    if size > WINDOW_SIZE:
+        msg = (
+            f"hardware counters of {len(entries)} streams and mmaps take {size} "
+            f"bytes, but only {WINDOW_SIZE} bytes of control registers are "
+            "available; please monitor fewer of them"
+        )
+        raise ValueError(msg)
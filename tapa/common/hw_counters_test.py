@@ -0,0 +1,30 @@
+"""Unit tests for tapa.common.hw_counters."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import pytest
+
+from tapa.common.hw_counters import check_size, encode_names, get_counter_count
+
+
+def test_encode_names_pads_to_words() -> None:
+    assert encode_names([("stream", "q")]) == b"stream:q\0\0\0\0"
+    assert encode_names([("mmap", "mem"), ("stream", "ab")]) == (
+        b"mmap:mem\0stream:ab\0\0"
+    )
+    assert encode_names([]) == b""
+
+
+def test_get_counter_count() -> None:
+    assert get_counter_count([]) == 1
+    assert get_counter_count([("stream", "q"), ("mmap", "mem")]) == 8
+
+
+def test_check_size() -> None:
+    check_size([("stream", f"q_{i}") for i in range(50)])
+    with pytest.raises(ValueError, match="monitor fewer"):
+        check_size([("stream", f"q_{i}") for i in range(60)])
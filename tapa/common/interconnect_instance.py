@@ -44,11 +44,13 @@ class InterconnectInstance(Base):
 
         def find_use(prefix: str) -> tuple[str, int]:
             name = self.global_name if interconnect_global_name else self.name
+            # The producer of a broadcast stream is passed the broadcast stream.
+            names = {name, obj.get("broadcast", name)}
 
             for task_name, inst in insts.items():
                 for idx, task in enumerate(inst):
                     for arg in task["args"].values():
-                        if arg["arg"] == name and arg["cat"].startswith(prefix):
+                        if arg["arg"] in names and arg["cat"].startswith(prefix):
                             return task_name, idx
 
             msg = f"invalid consumed/produced_by for interconnect {name}"
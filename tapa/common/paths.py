@@ -97,6 +97,7 @@ def find_external_lib_in_runfiles() -> set[Path]:
                 potential_path / "gflags+",
                 potential_path / "glog+",
                 potential_path / "tinyxml2+",
+                potential_path / "zlib+",
                 potential_path / "rules_boost++non_module_dependencies+boost",
             }
 
@@ -157,5 +158,9 @@ def get_tapa_ldflags() -> tuple[str, ...]:
         "-lgflags",
         "-l:libOpenCL.so.1",
         "-ltinyxml2",
+        "-lz",
         "-lstdc++fs",
+        "-ldl",
+        # Export task functions so that `TAPA_PROFILE` can report their names
+        "-rdynamic",
     )
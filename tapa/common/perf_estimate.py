@@ -0,0 +1,124 @@
+"""Static estimation of the steady-state throughput of a task graph."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import math
+from typing import NamedTuple
+
+# Depth that a FIFO needs to transfer a token per cycle without other delays.
+MIN_DEPTH = 2
+
+
+class TaskPerf(NamedTuple):
+    """Steady-state performance of a task instance."""
+
+    # Cycles between tokens, or `None` if unknown, e.g., without loops.
+    interval: int | None
+    # Cycles from consuming a token to producing the tokens it results in.
+    depth: int
+
+
+class Stream(NamedTuple):
+    """A FIFO between two task instances."""
+
+    name: str
+    producer: str
+    consumer: str
+    depth: int
+
+
+def _get_feed_forward_order(
+    nodes: list[str], streams: list[Stream]
+) -> tuple[list[str], set[str]]:
+    """Return `nodes` in topological order and the streams closing cycles.
+
+    Streams are removed from cycles in the order of their consumers, so that
+    the result does not depend on the order of `streams`.
+    """
+    inputs: dict[str, list[Stream]] = {node: [] for node in nodes}
+    for stream in streams:
+        inputs[stream.consumer].append(stream)
+    order: list[str] = []
+    feedback: set[str] = set()
+    remaining = set(nodes)
+    while remaining:
+        ready = sorted(
+            node
+            for node in remaining
+            if all(
+                s.producer not in remaining or s.name in feedback
+                for s in inputs[node]
+            )
+        )
+        if not ready:
+            # Break a cycle at the first node, taking its pending inputs as
+            # feedback.
+            node = min(remaining)
+            feedback.update(s.name for s in inputs[node] if s.producer in remaining)
+            ready = [node]
+        for node in ready:
+            order.append(node)
+            remaining.remove(node)
+    return order, feedback
+
+
+def estimate(tasks: dict[str, TaskPerf], streams: list[Stream]) -> dict:
+    """Estimate the throughput of `tasks` connected by `streams`.
+
+    All instances run concurrently, so in steady state the graph transfers a
+    token every `interval` cycles, where `interval` is that of the slowest
+    instance, the bottleneck.  Tokens reach an instance along paths of
+    different latencies; a FIFO on a path shorter than the longest one holds
+    the tokens produced in the difference, and stalls its producer if it is
+    not deep enough.  Streams closing cycles are not checked.
+
+    Returns a dict with the `interval`, the `bottlenecks`, the `latency` of
+    the longest path, and the `stalling_streams` with their `depth` and the
+    `required_depth` to run at the estimated interval.
+    """
+    streams = [s for s in streams if s.producer in tasks and s.consumer in tasks]
+    intervals = [perf.interval for perf in tasks.values() if perf.interval]
+    interval = max(intervals, default=None)
+    bottlenecks = sorted(
+        name for name, perf in tasks.items() if interval and perf.interval == interval
+    )
+
+    order, feedback = _get_feed_forward_order(sorted(tasks), streams)
+    # Cycle in which the first token reaches each instance.
+    arrival = dict.fromkeys(tasks, 0)
+    inputs: dict[str, list[Stream]] = {name: [] for name in tasks}
+    for stream in streams:
+        if stream.name not in feedback:
+            inputs[stream.consumer].append(stream)
+    for name in order:
+        arrival[name] = max(
+            (arrival[s.producer] + tasks[s.producer].depth for s in inputs[name]),
+            default=0,
+        )
+
+    stalling = {}
+    for stream in sorted(streams):
+        if stream.name in feedback:
+            continue
+        slack = arrival[stream.consumer] - (
+            arrival[stream.producer] + tasks[stream.producer].depth
+        )
+        required = MIN_DEPTH + math.ceil(slack / (interval or 1))
+        if stream.depth < required:
+            stalling[stream.name] = {
+                "depth": stream.depth,
+                "required_depth": required,
+            }
+
+    return {
+        "interval": interval,
+        "bottlenecks": bottlenecks,
+        "latency": max(
+            (arrival[name] + perf.depth for name, perf in tasks.items()), default=0
+        ),
+        "stalling_streams": stalling,
+    }
@@ -0,0 +1,68 @@
+"""Unit tests for tapa.common.perf_estimate."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+from tapa.common.perf_estimate import Stream, TaskPerf, estimate
+
+
+def test_estimate_finds_bottleneck() -> None:
+    result = estimate(
+        {
+            "load": TaskPerf(interval=1, depth=10),
+            "compute": TaskPerf(interval=4, depth=20),
+            "store": TaskPerf(interval=1, depth=5),
+        },
+        [
+            Stream("a", "load", "compute", depth=2),
+            Stream("b", "compute", "store", depth=2),
+        ],
+    )
+    assert result == {
+        "interval": 4,
+        "bottlenecks": ["compute"],
+        "latency": 35,
+        "stalling_streams": {},
+    }
+
+
+def test_estimate_flags_shallow_bypass() -> None:
+    # `skip` bypasses `slow`, so it holds the tokens produced in 100 cycles.
+    tasks = {
+        "fork": TaskPerf(interval=2, depth=1),
+        "slow": TaskPerf(interval=1, depth=100),
+        "join": TaskPerf(interval=1, depth=1),
+    }
+    streams = [
+        Stream("to_slow", "fork", "slow", depth=2),
+        Stream("from_slow", "slow", "join", depth=2),
+        Stream("skip", "fork", "join", depth=8),
+    ]
+    result = estimate(tasks, streams)
+    assert result["latency"] == 102
+    assert result["stalling_streams"] == {
+        "skip": {"depth": 8, "required_depth": 52},
+    }
+
+    streams[2] = Stream("skip", "fork", "join", depth=64)
+    assert estimate(tasks, streams)["stalling_streams"] == {}
+
+
+def test_estimate_ignores_feedback_and_unknown_tasks() -> None:
+    result = estimate(
+        {
+            "a": TaskPerf(interval=None, depth=1),
+            "b": TaskPerf(interval=3, depth=50),
+        },
+        [
+            Stream("ab", "a", "b", depth=2),
+            Stream("ba", "b", "a", depth=1),
+            Stream("host", "b", "port", depth=1),
+        ],
+    )
+    assert result["interval"] == 3
+    assert result["bottlenecks"] == ["b"]
+    assert result["stalling_streams"] == {}
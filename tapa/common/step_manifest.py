@@ -0,0 +1,114 @@
+"""Manifest of the steps completed in a work directory, to resume a flow."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import hashlib
+import json
+import logging
+import os
+from collections.abc import Iterable
+from pathlib import Path
+
+_logger = logging.getLogger().getChild(__name__)
+
+# Steps in the order of the flow. Rerunning a step invalidates the later ones.
+STEPS = ("analyze", "synth")
+
+MANIFEST_NAME = "steps.json"
+
+
+def get_key(*parts: object) -> str:
+    """Return a digest of `parts`, which must be serializable as JSON."""
+    content = json.dumps(parts, sort_keys=True, default=str).encode()
+    return hashlib.sha256(content).hexdigest()
+
+
+def get_file_key(paths: Iterable[str | Path]) -> str:
+    """Return a digest of the content of the files at `paths`."""
+    digest = hashlib.sha256()
+    for path in paths:
+        digest.update(str(path).encode() + b"\0")
+        digest.update(Path(path).read_bytes())
+    return digest.hexdigest()
+
+
+class StepManifest:
+    """Steps completed in a work directory with the key of their inputs.
+
+    Each step records a key of its inputs, e.g., options and source files, and
+    the digests of the files it wrote, relative to the work directory.  A
+    later run may skip the step if its key is unchanged and its outputs are
+    still intact, e.g., to resume a flow that failed in a later step.
+    """
+
+    def __init__(self, work_dir: str | Path) -> None:
+        self.work_dir = Path(work_dir)
+        self.path = self.work_dir / MANIFEST_NAME
+        try:
+            self._steps: dict[str, dict] = json.loads(
+                self.path.read_text(encoding="utf-8")
+            )
+        except (FileNotFoundError, json.JSONDecodeError):
+            self._steps = {}
+
+    def get_key(self, step: str) -> str | None:
+        """Return the key of `step` if it is recorded, or `None`."""
+        entry = self._steps.get(step)
+        return None if entry is None else entry["key"]
+
+    def is_done(self, step: str, key: str) -> bool:
+        """Return whether `step` was completed with `key` and is intact."""
+        entry = self._steps.get(step)
+        if entry is None or entry["key"] != key:
+            return False
+        for name, digest in entry["outputs"].items():
+            path = self.work_dir / name
+            if not path.exists() or _get_digest(path) != digest:
+                _logger.info("%s output `%s` changed since the last run", step, name)
+                return False
+        return True
+
+    def invalidate(self, step: str) -> None:
+        """Remove the records of `step` and the steps after it."""
+        later = STEPS[STEPS.index(step) :]
+        if any(name in self._steps for name in later):
+            for name in later:
+                self._steps.pop(name, None)
+            self._save()
+
+    def record(self, step: str, key: str, outputs: Iterable[str]) -> None:
+        """Record that `step` completed with `key` and wrote `outputs`.
+
+        Outputs are files or directories relative to the work directory.  The
+        records of later steps are removed, as they used older outputs.
+        """
+        self.invalidate(step)
+        self._steps[step] = {
+            "key": key,
+            "outputs": {
+                name: _get_digest(self.work_dir / name)
+                for name in outputs
+                if (self.work_dir / name).exists()
+            },
+        }
+        self._save()
+
+    def _save(self) -> None:
+        tmp_path = self.path.with_name(f"{self.path.name}.tmp")
+        tmp_path.write_text(json.dumps(self._steps, indent=2), encoding="utf-8")
+        os.replace(tmp_path, self.path)
+
+
+def _get_digest(path: Path) -> str:
+    """Return a digest of the file at `path`, or of all files under it."""
+    if path.is_file():
+        return hashlib.sha256(path.read_bytes()).hexdigest()
+    digest = hashlib.sha256()
+    for file in sorted(p for p in path.rglob("*") if p.is_file()):
+        digest.update(str(file.relative_to(path)).encode() + b"\0")
+        digest.update(file.read_bytes())
+    return digest.hexdigest()
@@ -0,0 +1,53 @@
+"""Unit tests for tapa.common.step_manifest."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+from pathlib import Path
+
+from tapa.common.step_manifest import StepManifest, get_file_key, get_key
+
+
+def test_step_is_done_with_same_key(tmp_path: Path) -> None:
+    (tmp_path / "graph.json").write_text("{}", encoding="utf-8")
+    StepManifest(tmp_path).record("analyze", get_key("a"), ["graph.json"])
+
+    manifest = StepManifest(tmp_path)
+    assert manifest.get_key("analyze") == get_key("a")
+    assert manifest.is_done("analyze", get_key("a"))
+    assert not manifest.is_done("analyze", get_key("b"))
+    assert not manifest.is_done("synth", get_key("a"))
+
+
+def test_step_is_not_done_once_outputs_change(tmp_path: Path) -> None:
+    (tmp_path / "hdl").mkdir()
+    (tmp_path / "hdl" / "top.v").write_text("module top; endmodule", encoding="utf-8")
+    StepManifest(tmp_path).record("synth", "key", ["hdl", "missing.json"])
+    assert StepManifest(tmp_path).is_done("synth", "key")
+
+    (tmp_path / "hdl" / "top.v").write_text("", encoding="utf-8")
+    assert not StepManifest(tmp_path).is_done("synth", "key")
+
+
+def test_rerunning_step_invalidates_later_steps(tmp_path: Path) -> None:
+    manifest = StepManifest(tmp_path)
+    manifest.record("analyze", "analyze-key", [])
+    manifest.record("synth", "synth-key", [])
+    assert StepManifest(tmp_path).is_done("synth", "synth-key")
+
+    StepManifest(tmp_path).invalidate("analyze")
+    manifest = StepManifest(tmp_path)
+    assert manifest.get_key("analyze") is None
+    assert not manifest.is_done("synth", "synth-key")
+
+
+def test_file_key_depends_on_content(tmp_path: Path) -> None:
+    path = tmp_path / "a.cpp"
+    path.write_text("int a;", encoding="utf-8")
+    key = get_file_key([path])
+    assert get_file_key([path]) == key
+    path.write_text("int b;", encoding="utf-8")
+    assert get_file_key([path]) != key
@@ -0,0 +1,147 @@
+"""Reader of stream logs generated by TAPA software simulation."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import struct
+import zlib
+from collections.abc import Iterator
+from pathlib import Path
+from typing import BinaryIO, NamedTuple, TextIO
+
+# Binary log header: magic, version, and size of values in bytes. Keep in sync
+# with `tapa-lib/tapa/host/stream.cpp`.
+_MAGIC = b"TAPASLOG"
+_VERSION = 1
+_HEADER = struct.Struct("<8sII")
+
+# Compressed logs are the magic followed by chunks of the binary log, each the
+# compressed size, the decompressed size, and the zlib stream.
+_COMPRESSED_MAGIC = b"TAPASLGZ"
+_CHUNK_HEADER = struct.Struct("<II")
+
+
+class Token(NamedTuple):
+    """A token in a stream, with the raw bytes of the value in host order."""
+
+    eot: bool
+    val: bytes
+
+    def to_hex(self) -> str:
+        """Returns the value in the text log format, or "" for EoT."""
+        return "" if self.eot else "0x" + self.val.hex()
+
+    def to_bits(self) -> str:
+        """Returns the token as `fpga::ToBinaryString` encodes it for cosim.
+
+        The first bit is EoT, followed by the value from the most significant
+        bit. The host is assumed to be little-endian.
+        """
+        return ("1" if self.eot else "0") + "".join(
+            f"{byte:08b}" for byte in reversed(self.val)
+        )
+
+
+def is_binary_log(path: Path) -> bool:
+    """Returns whether the file at `path` is a binary stream log."""
+    with path.open("rb") as file:
+        return file.read(len(_MAGIC)) in {_MAGIC, _COMPRESSED_MAGIC}
+
+
+class _DecompressedFile:
+    """Reads the binary log in the chunks of a compressed log."""
+
+    def __init__(self, file: BinaryIO) -> None:
+        self._file = file
+        self._chunk = b""
+        self._offset = 0
+
+    def read(self, size: int) -> bytes:
+        data = b""
+        while len(data) < size:
+            if self._offset == len(self._chunk):
+                self._chunk = self._read_chunk()
+                self._offset = 0
+                if not self._chunk:
+                    break
+            end = self._offset + size - len(data)
+            data += self._chunk[self._offset : end]
+            self._offset = min(end, len(self._chunk))
+        return data
+
+    def _read_chunk(self) -> bytes:
+        header = self._file.read(_CHUNK_HEADER.size)
+        if not header:
+            return b""
+        if len(header) != _CHUNK_HEADER.size:
+            msg = "truncated stream log chunk"
+            raise ValueError(msg)
+        compressed_size, size = _CHUNK_HEADER.unpack(header)
+        compressed = self._file.read(compressed_size)
+        if len(compressed) != compressed_size:
+            msg = "truncated stream log chunk"
+            raise ValueError(msg)
+        try:
+            chunk = zlib.decompress(compressed)
+        except zlib.error as e:
+            msg = f"corrupted stream log chunk: {e}"
+            raise ValueError(msg) from e
+        if len(chunk) != size:
+            msg = "corrupted stream log chunk"
+            raise ValueError(msg)
+        return chunk
+
+
+def read_binary_log(file: BinaryIO) -> Iterator[Token]:
+    """Yields tokens from a binary stream log, which may be compressed.
+
+    Raises:
+        ValueError: If the log is malformed.
+    """
+    magic = file.read(len(_MAGIC))
+    if magic == _COMPRESSED_MAGIC:
+        file = _DecompressedFile(file)  # type: ignore[assignment]
+        magic = file.read(len(_MAGIC))
+    header = magic + file.read(_HEADER.size - len(magic)) if magic else b""
+    if not header:
+        return  # No token is ever written.
+    if len(header) != _HEADER.size:
+        msg = "truncated stream log header"
+        raise ValueError(msg)
+    magic, version, width = _HEADER.unpack(header)
+    if magic != _MAGIC:
+        msg = "not a binary stream log"
+        raise ValueError(msg)
+    if version != _VERSION:
+        msg = f"unsupported stream log version {version}"
+        raise ValueError(msg)
+
+    while record := file.read(1 + width):
+        if len(record) != 1 + width:
+            msg = "truncated stream log record"
+            raise ValueError(msg)
+        yield Token(eot=record[0] != 0, val=record[1:])
+
+
+def read_bits_dump(file: TextIO) -> Iterator[str]:
+    """Yields tokens from a text dump with one `Token.to_bits` per line."""
+    for line in file:
+        if line := line.strip():
+            yield line
+
+
+def bits_equal(lhs: str, rhs: str) -> bool:
+    """Returns whether two `Token.to_bits` strings are equal.
+
+    The values may have different widths, e.g., for `ap_uint<N>` whose size is
+    rounded up to bytes on the host, in which case the extra high bits must be
+    zero.
+    """
+    if lhs[:1] != rhs[:1]:
+        return False
+    lhs, rhs = lhs[1:], rhs[1:]
+    width = max(len(lhs), len(rhs))
+    return lhs.rjust(width, "0") == rhs.rjust(width, "0")
@@ -0,0 +1,57 @@
+"""Unit tests for tapa.common.stream_log."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import io
+import struct
+import zlib
+
+import pytest
+
+from tapa.common.stream_log import Token, bits_equal, read_binary_log
+
+# Same as `StreamLogTest.LoggingInBinaryFormatSucceeds` in `stream_test.cpp`.
+_LOG = b"TAPASLOG\1\0\0\0\2\0\0\0" + b"\0\x33\x23" + b"\1\0\0"
+
+
+def test_read_binary_log() -> None:
+    tokens = list(read_binary_log(io.BytesIO(_LOG)))
+    assert tokens == [
+        Token(eot=False, val=b"\x33\x23"),
+        Token(eot=True, val=b"\0\0"),
+    ]
+    assert [token.to_hex() for token in tokens] == ["0x3323", ""]
+    assert tokens[0].to_bits() == "0" + "0010001100110011"
+
+
+def test_read_compressed_binary_log() -> None:
+    chunks = (_LOG[:13], _LOG[13:])
+    log = b"TAPASLGZ" + b"".join(
+        struct.pack("<II", len(compressed), len(chunk)) + compressed
+        for chunk in chunks
+        for compressed in (zlib.compress(chunk),)
+    )
+    assert list(read_binary_log(io.BytesIO(log))) == list(
+        read_binary_log(io.BytesIO(_LOG))
+    )
+    with pytest.raises(ValueError, match="truncated"):
+        list(read_binary_log(io.BytesIO(log[:-1])))
+
+
+def test_read_empty_binary_log() -> None:
+    assert not list(read_binary_log(io.BytesIO(b"")))
+
+
+def test_read_truncated_binary_log() -> None:
+    with pytest.raises(ValueError, match="truncated"):
+        list(read_binary_log(io.BytesIO(_LOG[:-1])))
+
+
+def test_bits_equal() -> None:
+    assert bits_equal("000000101", "0101")
+    assert not bits_equal("010000101", "0101")
+    assert not bits_equal("1101", "0101")
@@ -0,0 +1,100 @@
+"""Variants of a design over a grid of preprocessor parameters."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import csv
+import itertools
+import json
+import re
+from decimal import Decimal
+from pathlib import Path
+from typing import TextIO
+
+# Columns of the area in `report.json`, in the order they are tabulated.
+AREA_KEYS = ("LUT", "FF", "BRAM_18K", "URAM", "DSP")
+
+
+def parse_grid(params: list[str] | tuple[str, ...]) -> dict[str, list[str]]:
+    """Parse `NAME=V1,V2,...` of each parameter into `{NAME: [V1, V2, ...]}`."""
+    grid: dict[str, list[str]] = {}
+    for param in params:
+        name, sep, values = param.partition("=")
+        name = name.strip()
+        if not sep or not re.fullmatch(r"[A-Za-z_]\w*", name) or not values:
+            msg = f"expected NAME=V1,V2,... for a parameter, got '{param}'"
+            raise ValueError(msg)
+        if name in grid:
+            msg = f"parameter '{name}' is given more than once"
+            raise ValueError(msg)
+        grid[name] = [value.strip() for value in values.split(",")]
+    return grid
+
+
+def get_variants(grid: dict[str, list[str]]) -> list[dict[str, str]]:
+    """Return the value of each parameter for all variants in the grid."""
+    return [dict(zip(grid, values)) for values in itertools.product(*grid.values())]
+
+
+def get_variant_name(variant: dict[str, str]) -> str:
+    """Return a directory name for `variant`, e.g., `PE-4_WIDTH-16`."""
+    name = "_".join(f"{key}-{value}" for key, value in variant.items())
+    return re.sub(r"[^\w.-]", "_", name)
+
+
+def get_cflags(variant: dict[str, str]) -> list[str]:
+    """Return the flags defining the parameters of `variant` as macros."""
+    return [f"-D{key}={value}" for key, value in variant.items()]
+
+
+def get_variant_result(work_dir: Path, cosim_dir: Path | None) -> dict[str, object]:
+    """Return the area, Fmax, and cosim cycles of a variant, where available.
+
+    The area and the clock period are read from `report.json` in `work_dir`,
+    and the cycles of the kernel from the port statistics that cosimulation
+    saved to `cosim_dir`.  Missing results are `None`.
+    """
+    result: dict[str, object] = dict.fromkeys(
+        (*AREA_KEYS, "fmax_mhz", "cosim_cycles", "cosim_us")
+    )
+    try:
+        report = json.loads((work_dir / "report.json").read_text(encoding="utf-8"))
+    except (FileNotFoundError, json.JSONDecodeError):
+        report = None
+    if report is not None:
+        area = report["area"]["total"]
+        for key in AREA_KEYS:
+            result[key] = area.get(key)
+        clock_period = Decimal(report["performance"]["clock_period"])
+        if clock_period > 0:
+            result["fmax_mhz"] = round(float(1000 / clock_period), 2)
+
+    if cosim_dir is not None:
+        try:
+            stats = json.loads(
+                (cosim_dir / "output" / "port_stats.json").read_text(encoding="utf-8")
+            )
+        except (FileNotFoundError, json.JSONDecodeError):
+            stats = None
+        if stats is not None and "cycles" in stats:
+            result["cosim_cycles"] = stats["cycles"]
+            if result["fmax_mhz"]:
+                result["cosim_us"] = round(stats["cycles"] / result["fmax_mhz"], 3)
+    return result
+
+
+def write_results(
+    fp: TextIO, variants: list[dict[str, str]], results: list[dict[str, object]]
+) -> None:
+    """Write a CSV table with a row of parameters and results per variant."""
+    if not variants:
+        return
+    writer = csv.writer(fp)
+    writer.writerow([*variants[0], *results[0]])
+    for variant, result in zip(variants, results):
+        writer.writerow(
+            [*variant.values(), *("" if v is None else v for v in result.values())]
+        )
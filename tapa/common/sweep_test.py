@@ -0,0 +1,94 @@
+"""Unit tests for tapa.common.sweep."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import io
+import json
+from pathlib import Path
+
+import pytest
+
+from tapa.common.sweep import (
+    get_cflags,
+    get_variant_name,
+    get_variant_result,
+    get_variants,
+    parse_grid,
+    write_results,
+)
+
+
+def test_variants_cover_grid() -> None:
+    grid = parse_grid(["PE=2,4", "WIDTH = 8, 16"])
+    assert grid == {"PE": ["2", "4"], "WIDTH": ["8", "16"]}
+    variants = get_variants(grid)
+    assert variants == [
+        {"PE": "2", "WIDTH": "8"},
+        {"PE": "2", "WIDTH": "16"},
+        {"PE": "4", "WIDTH": "8"},
+        {"PE": "4", "WIDTH": "16"},
+    ]
+    assert get_variant_name(variants[1]) == "PE-2_WIDTH-16"
+    assert get_cflags(variants[1]) == ["-DPE=2", "-DWIDTH=16"]
+
+
+def test_variant_name_is_a_file_name() -> None:
+    assert get_variant_name({"TYPE": "ap_uint<8>"}) == "TYPE-ap_uint_8_"
+
+
+@pytest.mark.parametrize("param", ["PE", "PE=", "1PE=2", "P E=2"])
+def test_parse_grid_rejects_malformed_param(param: str) -> None:
+    with pytest.raises(ValueError, match="NAME=V1,V2"):
+        parse_grid([param])
+
+
+def test_parse_grid_rejects_repeated_param() -> None:
+    with pytest.raises(ValueError, match="more than once"):
+        parse_grid(["PE=2", "PE=4"])
+
+
+def test_variant_result(tmp_path: Path) -> None:
+    (tmp_path / "report.json").write_text(
+        json.dumps(
+            {
+                "area": {"total": {"LUT": 100, "FF": 200, "BRAM_18K": 2}},
+                "performance": {"clock_period": "4.000"},
+            }
+        ),
+        encoding="utf-8",
+    )
+    cosim_dir = tmp_path / "cosim"
+    (cosim_dir / "output").mkdir(parents=True)
+    (cosim_dir / "output" / "port_stats.json").write_text(
+        json.dumps({"cycles": 5000, "ports": {}}), encoding="utf-8"
+    )
+
+    result = get_variant_result(tmp_path, cosim_dir)
+    assert result["LUT"] == 100
+    assert result["URAM"] is None
+    assert result["fmax_mhz"] == 250
+    assert result["cosim_cycles"] == 5000
+    assert result["cosim_us"] == 20
+
+
+def test_missing_variant_result(tmp_path: Path) -> None:
+    result = get_variant_result(tmp_path, tmp_path / "cosim")
+    assert set(result.values()) == {None}
+
+
+def test_write_results() -> None:
+    fp = io.StringIO()
+    write_results(
+        fp,
+        [{"PE": "2"}, {"PE": "4"}],
+        [{"status": "compiled", "LUT": 100}, {"status": "compile failed", "LUT": None}],
+    )
+    assert fp.getvalue().splitlines() == [
+        "PE,status,LUT",
+        "2,compiled,100",
+        "4,compile failed,",
+    ]
@@ -0,0 +1,87 @@
+"""Find chains of simple tasks that could be fused into one task."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import logging
+from typing import NamedTuple
+
+_logger = logging.getLogger().getChild(__name__)
+
+
+class TaskChain(NamedTuple):
+    """Instances of an upper-level task connected one after another."""
+
+    task: str
+    # Names of the instances in dataflow order, e.g., `Scale_0`.
+    instances: tuple[str, ...]
+    # FIFOs between consecutive instances.
+    fifos: tuple[str, ...]
+
+
+def _is_simple(graph: dict, name: str, instance: dict) -> bool:
+    """Return whether an instance of `name` is simple.
+
+    Simple instances are of lower-level tasks with at most one input and one
+    output stream and no memory ports.
+    """
+    if graph["tasks"].get(name, {}).get("level") != "lower":
+        return False
+    cats = [arg["cat"] for arg in instance.get("args", {}).values()]
+    return (
+        all(cat in {"istream", "ostream", "scalar"} for cat in cats)
+        and cats.count("istream") <= 1
+        and cats.count("ostream") <= 1
+    )
+
+
+def find_task_chains(graph: dict) -> list[TaskChain]:
+    """Return the chains of two or more simple instances in `graph`.
+
+    A chain is a path of instances of lower-level tasks with at most one
+    input and one output stream each, where each instance consumes what the
+    previous one produces. Each instance of a chain is a module of its own
+    after synthesis, with a FIFO and its handshakes to the next one, which a
+    fused task would not need.
+    """
+    chains = []
+    for task_name, task in graph["tasks"].items():
+        instances = task.get("tasks", {})
+        # Next instance and the FIFO to it, for instances in chains.
+        successor: dict[str, tuple[str, str]] = {}
+        has_predecessor: set[str] = set()
+        for fifo_name, fifo in task.get("fifos", {}).items():
+            if "produced_by" not in fifo or "consumed_by" not in fifo:
+                continue  # External ports.
+            ends = [fifo["produced_by"], fifo["consumed_by"]]
+            if not all(
+                _is_simple(graph, name, instances[name][index]) for name, index in ends
+            ):
+                continue
+            producer, consumer = (f"{name}_{index}" for name, index in ends)
+            successor[producer] = (consumer, fifo_name)
+            has_predecessor.add(consumer)
+        for head in sorted(successor.keys() - has_predecessor):
+            chain = [head]
+            fifos = []
+            while chain[-1] in successor:
+                consumer, fifo_name = successor[chain[-1]]
+                chain.append(consumer)
+                fifos.append(fifo_name)
+            chains.append(TaskChain(task_name, tuple(chain), tuple(fifos)))
+    return chains
+
+
+def report_task_chains(graph: dict) -> None:
+    """Log the chains of simple instances that could be fused."""
+    for chain in find_task_chains(graph):
+        _logger.info(
+            "instances %s in task `%s` form a chain of simple tasks; fusing "
+            "them into one task would save %d FIFO(s) and module(s)",
+            " -> ".join(f"`{name}`" for name in chain.instances),
+            chain.task,
+            len(chain.fifos),
+        )
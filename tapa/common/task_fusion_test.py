@@ -0,0 +1,64 @@
+"""Unit tests for tapa.common.task_fusion."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+from tapa.common.task_fusion import TaskChain, find_task_chains
+
+
+def _stream_args(**args: str) -> dict:
+    return {
+        "args": {
+            port: {"cat": "istream" if port == "in" else "ostream", "arg": arg}
+            for port, arg in args.items()
+        }
+    }
+
+
+def _make_graph() -> dict:
+    """Return `Load -> Scale -> Offset -> Store`, where `Load` reads memory."""
+    load = _stream_args(out="a")
+    load["args"]["mem"] = {"cat": "mmap", "arg": "mem"}
+    return {
+        "top": "Top",
+        "tasks": {
+            "Top": {
+                "level": "upper",
+                "fifos": {
+                    "a": {"produced_by": ["Load", 0], "consumed_by": ["Scale", 0]},
+                    "b": {"produced_by": ["Scale", 0], "consumed_by": ["Offset", 0]},
+                    "c": {"produced_by": ["Offset", 0], "consumed_by": ["Store", 0]},
+                    "out": {"produced_by": ["Store", 0]},
+                },
+                "tasks": {
+                    "Load": [load],
+                    "Scale": [_stream_args(**{"in": "a", "out": "b"})],
+                    "Offset": [_stream_args(**{"in": "b", "out": "c"})],
+                    "Store": [_stream_args(**{"in": "c", "out": "out"})],
+                },
+            },
+            "Load": {"level": "lower"},
+            "Scale": {"level": "lower"},
+            "Offset": {"level": "lower"},
+            "Store": {"level": "lower"},
+        },
+    }
+
+
+def test_find_task_chains() -> None:
+    assert find_task_chains(_make_graph()) == [
+        TaskChain(
+            task="Top",
+            instances=("Scale_0", "Offset_0", "Store_0"),
+            fifos=("b", "c"),
+        ),
+    ]
+
+
+def test_find_task_chains_stops_at_upper_tasks() -> None:
+    graph = _make_graph()
+    graph["tasks"]["Offset"]["level"] = "upper"
+    assert not find_task_chains(graph)
@@ -8,60 +8,103 @@ RapidStream Contributor License Agreement.
 
 import contextlib
 import decimal
+import fnmatch
 import glob
+import hashlib
 import itertools
 import json
 import logging
+import multiprocessing
 import os
 import os.path
+import queue
 import re
+import shlex
 import shutil
 import sys
 import tarfile
 import tempfile
 import zipfile
+from collections.abc import Sequence
 from concurrent import futures
 from pathlib import Path
 from typing import NamedTuple
-from xml.etree import ElementTree as ET
 
 import toposort
 import yaml
-from psutil import cpu_count
+from psutil import cpu_count, virtual_memory
 from pyverilog.vparser.ast import (
     Always,
     Assign,
+    Concat,
+    Constant,
     Eq,
     Identifier,
     IfStatement,
     Input,
     IntConst,
     Land,
+    Lor,
     Minus,
     Node,
     NonblockingSubstitution,
     Output,
+    ParamArg,
     Plus,
     PortArg,
     Reg,
     SingleStatement,
     StringConst,
     SystemCall,
+    Unot,
     Wire,
 )
 from pyverilog.vparser.parser import ParseError
 
-from tapa.backend.xilinx import RunAie, RunHls
+from tapa.backend.xilinx import (
+    M_AXI_PREFIX,
+    S_AXI_NAME,
+    RunAie,
+    RunHls,
+    write_args_file,
+    write_hash_file,
+)
+from tapa.common import build_trace
+from tapa.common.aie_placement import get_plio_width, place_kernels
+from tapa.common.fifo_impl import (
+    MEM_STYLES,
+    FifoCost,
+    estimate_fifo_cost,
+    pick_fifo_style,
+)
+from tapa.common.floorplan import (
+    get_crossing_cost,
+    get_pblock_constraints,
+    get_relay_level,
+    get_slots,
+    partition,
+)
+from tapa.common.hls_cache import HlsCache
+from tapa.common.hls_dedup import find_duplicate_tasks, rename_hls_tar
+from tapa.common.hls_memory import MemoryBudget, MemoryHistory, PeakMemoryMonitor
+from tapa.common.hls_report import HlsReport, load_hls_report
+from tapa.common.hw_counters import ADDR_WIDTH as HW_COUNTERS_ADDR_WIDTH
+from tapa.common.hw_counters import BASE_ADDR as HW_COUNTERS_BASE_ADDR
+from tapa.common.hw_counters import COUNTERS as HW_COUNTERS
+from tapa.common.hw_counters import check_size, encode_names
+from tapa.common.perf_estimate import Stream, TaskPerf, estimate
 from tapa.instance import Instance, Port
 from tapa.safety_check import check_mmap_arg_name
 from tapa.synthesis import ProgramSynthesisMixin
 from tapa.task import Task
 from tapa.util import (
     clang_format,
+    get_indexed_name,
     get_instance_name,
     get_module_name,
     get_vendor_include_paths,
     get_xpfm_path,
+    range_or_none,
 )
 from tapa.verilog.ast_utils import (
     make_block,
@@ -71,7 +114,7 @@ from tapa.verilog.ast_utils import (
     make_port_arg,
     make_width,
 )
-from tapa.verilog.util import Pipeline, match_array_name, wire_name
+from tapa.verilog.util import Pipeline, match_array_name, sanitize_array_name, wire_name
 from tapa.verilog.xilinx import generate_handshake_ports, pack
 from tapa.verilog.xilinx.async_mmap import (
     ASYNC_MMAP_SUFFIXES,
@@ -80,23 +123,29 @@ from tapa.verilog.xilinx.async_mmap import (
     generate_async_mmap_signals,
 )
 from tapa.verilog.xilinx.const import (
+    CLK,
+    CLK_2,
     CLK_SENS_LIST,
     DONE,
     FALSE,
     HANDSHAKE_CLK,
+    HANDSHAKE_CLK_2,
     HANDSHAKE_DONE,
     HANDSHAKE_IDLE,
     HANDSHAKE_INPUT_PORTS,
     HANDSHAKE_OUTPUT_PORTS,
     HANDSHAKE_READY,
     HANDSHAKE_RST_N,
+    HANDSHAKE_RST_N_2,
     HANDSHAKE_START,
     IDLE,
     ISTREAM_SUFFIXES,
     OSTREAM_SUFFIXES,
     READY,
     RST,
+    RST_2,
     RST_N,
+    RST_N_2,
     RTL_SUFFIX,
     START,
     STATE,
@@ -113,12 +162,71 @@ STATE10 = IntConst("2'b10")
 
 CUSTOM_RTL_FILE_EXTENSIONS = (".v", ".tcl")
 
+# Instance and address width parameter of `s_axi_control` generated by HLS.
+S_AXI_INSTANCE = "control_s_axi_U"
+S_AXI_ADDR_WIDTH_PARAM = "C_S_AXI_CONTROL_ADDR_WIDTH"
+
+
+class _AieLink(NamedTuple):
+    """Kernel port at one end of an AIE connection."""
+
+    kernel: str
+    port: str
+    is_io: bool
+
+
+def _get_aie_links(task: Task) -> tuple[dict[str, list[_AieLink]], ...]:
+    """Returns the kernel ports writing to and reading from each argument.
+
+    An argument may be linked to multiple kernel ports if it is shared by
+    replicated kernels, e.g., those invoked with `invoke<mode, n>`.
+    """
+    link_from_src: dict[str, list[_AieLink]] = {}
+    link_to_dst: dict[str, list[_AieLink]] = {}
+    for name, insts in task.tasks.items():
+        for i, inst in enumerate(insts):
+            in_num = 0
+            out_num = 0
+            for conn_dict in inst["args"].values():
+                cat = conn_dict["cat"]
+                if cat in {"istream", "immap"}:
+                    link = _AieLink(f"k_{name}{i}", f"in[{in_num}]", cat == "immap")
+                    link_to_dst.setdefault(conn_dict["arg"], []).append(link)
+                    in_num += 1
+                elif cat in {"ostream", "ommap"}:
+                    link = _AieLink(f"k_{name}{i}", f"out[{out_num}]", cat == "ommap")
+                    link_from_src.setdefault(conn_dict["arg"], []).append(link)
+                    out_num += 1
+                else:
+                    msg = f"Unknown connection category: {cat}"
+                    raise ValueError(msg)
+    return link_from_src, link_to_dst
+
+
+def _get_plio_names(task: Task) -> dict[str, list[str]]:
+    """Returns the PLIO names of each port.
+
+    A port linked to multiple kernels is split into one PLIO per kernel so that
+    replicated kernels do not share the bandwidth of a single PLIO.
+    """
+    link_from_src, link_to_dst = _get_aie_links(task)
+    plio_names = {}
+    for name in task.ports:
+        num_links = len(link_from_src.get(name, [])) + len(link_to_dst.get(name, []))
+        if num_links > 1:
+            plio_names[name] = [f"{name}_{i}" for i in range(num_links)]
+        else:
+            plio_names[name] = [name]
+    return plio_names
+
 
 def gen_declarations(task: Task) -> tuple[list[str], list[str], list[str]]:
     """Generates kernel and port declarations."""
+    plio_names = _get_plio_names(task)
     port_decl = [
-        f"input_plio p_{port.name};" if port.is_immap else f"output_plio p_{port.name};"
+        f"input_plio p_{plio};" if port.is_immap else f"output_plio p_{plio};"
         for port in task.ports.values()
+        for plio in plio_names[port.name]
     ]
     kernel_decl = [
         f"kernel k_{name}{i};"
@@ -129,8 +237,16 @@ def gen_declarations(task: Task) -> tuple[list[str], list[str], list[str]]:
     return header_decl, kernel_decl, port_decl
 
 
-def gen_definitions(task: Task) -> tuple[list[str], ...]:
-    """Generates kernel and port definitions."""
+def gen_definitions(
+    task: Task,
+    array_rows: int | None = None,
+) -> tuple[list[str], ...]:
+    """Generates kernel and port definitions.
+
+    If `array_rows` is given, each kernel is constrained to a tile of an AIE
+    array with that many rows such that kernels connected by streams are placed
+    in neighboring tiles.
+    """
     kernel_def = [
         f"k_{name}{i} = kernel::create({name});"
         for name, insts in task.tasks.items()
@@ -153,19 +269,42 @@ def gen_definitions(task: Task) -> tuple[list[str], ...]:
         for name, insts in task.tasks.items()
         for i in range(len(insts))
     ]
-    kernel_loc = [
-        f"//location<kernel>(k_{name}{i}) = tile(X, X);"
-        for name, insts in task.tasks.items()
-        for i in range(len(insts))
-    ]
+    if array_rows is None:
+        kernel_loc = [
+            f"//location<kernel>(k_{name}{i}) = tile(X, X);"
+            for name, insts in task.tasks.items()
+            for i in range(len(insts))
+        ]
+    else:
+        link_from_src, link_to_dst = _get_aie_links(task)
+        tiles = place_kernels(
+            [
+                f"k_{name}{i}"
+                for name, insts in task.tasks.items()
+                for i in range(len(insts))
+            ],
+            [
+                (src.kernel, dst.kernel)
+                for name in task.fifos
+                for src in link_from_src.get(name, [])
+                for dst in link_to_dst.get(name, [])
+            ],
+            array_rows,
+        )
+        kernel_loc = [
+            f"location<kernel>({kernel}) = tile({col}, {row});"
+            for kernel, (col, row) in tiles.items()
+        ]
 
+    plio_names = _get_plio_names(task)
     port_def = [
-        f'p_{port.name} = input_plio::create("{port.name}",'
-        f' plio_{port.width}_bits, "{port.name}.txt");'
+        f'p_{plio} = input_plio::create("{plio}",'
+        f' plio_{get_plio_width(port.width)}_bits, "{plio}.txt");'
         if port.is_immap
-        else f'p_{port.name} = output_plio::create("{port.name}",'
-        f' plio_{port.width}_bits, "{port.name}.txt");'
+        else f'p_{plio} = output_plio::create("{plio}",'
+        f' plio_{get_plio_width(port.width)}_bits, "{plio}.txt");'
         for port in task.ports.values()
+        for plio in plio_names[port.name]
     ]
     return (
         kernel_def,
@@ -177,69 +316,38 @@ def gen_definitions(task: Task) -> tuple[list[str], ...]:
     )
 
 
-def gen_connections(task: Task) -> list[str]:  # noqa: C901  # TODO: refactor this function
+def gen_connections(task: Task) -> list[str]:
     """Generates connections between ports and kernels."""
-    link_from_src = {}
-    link_to_dst = {}
-    for name, insts in task.tasks.items():
-        for i, inst in enumerate(insts):
-            arg_dict = inst["args"]
-            in_num = 0
-            out_num = 0
-            for conn_dict in arg_dict.values():
-                if conn_dict["cat"] == "istream":
-                    link_to_dst[conn_dict["arg"]] = [
-                        f"{name}{i}.in[{in_num}]",
-                        "net",
-                    ]
-                    in_num += 1
-                elif conn_dict["cat"] == "ostream":
-                    link_from_src[conn_dict["arg"]] = [
-                        f"{name}{i}.out[{out_num}]",
-                        "net",
-                    ]
-                    out_num += 1
-                elif conn_dict["cat"] == "immap":
-                    link_to_dst[conn_dict["arg"]] = [
-                        f"{name}{i}.in[{in_num}]",
-                        "io",
-                    ]
-                    in_num += 1
-                elif conn_dict["cat"] == "ommap":
-                    link_from_src[conn_dict["arg"]] = [
-                        f"{name}{i}.out[{out_num}]",
-                        "io",
-                    ]
-                    out_num += 1
-                else:
-                    msg = f"Unknown connection category: {conn_dict['cat']}"
-                    raise ValueError(msg)
+    link_from_src, link_to_dst = _get_aie_links(task)
 
     connect_def = []
     for name in task.fifos:
-        assert link_from_src[name][1] == "net", "FIFOs should be connected to/from net"
+        (src,) = link_from_src[name]
+        (dst,) = link_to_dst[name]
+        assert not src.is_io, "FIFOs should be connected to/from net"
         connect_def.append(
-            f"connect<stream> {name} (k_{link_from_src[name][0]},"
-            f" k_{link_to_dst[name][0]});"
+            f"connect<stream> {name} ({src.kernel}.{src.port},"
+            f" {dst.kernel}.{dst.port});"
         )
 
+    plio_names = _get_plio_names(task)
     for port in task.ports.values():
         name = port.name
         width = port.width
-        if name in link_from_src:
-            assert link_from_src[name][1] == "io", (
-                "Ports should be connected to/from io"
-            )
+        plios = iter(plio_names[name])
+        for src in link_from_src.get(name, []):
+            assert src.is_io, "Ports should be connected to/from io"
+            plio = next(plios)
             connect_def.append(
-                f"connect<window<{width}>> {name}_link"
-                f" (k_{link_from_src[name][0]}, p_{name}.in[0]);"
+                f"connect<window<{width}>> {plio}_link"
+                f" ({src.kernel}.{src.port}, p_{plio}.in[0]);"
             )
-
-        if name in link_to_dst:
-            assert link_to_dst[name][1] == "io", "Ports should be connected to/from io"
+        for dst in link_to_dst.get(name, []):
+            assert dst.is_io, "Ports should be connected to/from io"
+            plio = next(plios)
             connect_def.append(
-                f"connect<window<{width}>> {name}_link"
-                f" (p_{name}.out[0], k_{link_to_dst[name][0]});"
+                f"connect<window<{width}>> {plio}_link"
+                f" (p_{plio}.out[0], {dst.kernel}.{dst.port});"
             )
 
     return connect_def
@@ -379,7 +487,33 @@ int main(int argc, char ** argv)
                 self.gen_templates += (name,)
 
         self.files: dict[str, str] = {}
-        self._hls_report_xmls: dict[str, ET.ElementTree] = {}
+        # Shared mmaps with more children than the radix use crossbar trees.
+        self.crossbar_radix = 0
+        self.crossbar_stages = 1
+        # Slot of each task instance and m_axi port in the top task, e.g.,
+        # `SLOT_X0Y1`.
+        self.floorplan: dict[str, str] = {}
+        # Register stages of m_axi ports of the top task, which override the
+        # stages derived from the floorplan.
+        self.m_axi_stages: dict[str, int] = {}
+        # FIFO implementation of streams named `fifo` or `Task.fifo`, e.g., `srl`.
+        self.fifo_impls: dict[str, str] = {}
+        # Tasks whose instances in the top task run on `ap_clk_2`, and the HLS
+        # clock period of these tasks if different from the other tasks.
+        self.clock_2_tasks: tuple[str, ...] = ()
+        self.clock_2_period: float | None = None
+        # Whether detached tasks that take no scalars are synthesized without
+        # the block-level handshake, and whether the FSMs of upper-level tasks
+        # report `ap_done` one cycle after their children are done.
+        self.free_running_detached = False
+        self.low_latency_control = False
+        # Patterns of streams and mmaps of the top task counted in hardware.
+        self.hw_counters: tuple[str, ...] = ()
+        self._hls_reports: dict[str, HlsReport] = {}
+        # Parsed RTL of tasks whose tarballs are extracted, and the processes
+        # parsing them; see `_load_task_rtl`.
+        self._rtl_modules: dict[str, futures.Future[Module]] = {}
+        self._rtl_parser: futures.ProcessPoolExecutor | None = None
 
     def __del__(self) -> None:
         if self.is_temp:
@@ -479,6 +613,41 @@ int main(int argc, char ** argv)
         os.makedirs(os.path.join(self.work_dir, "tar"), exist_ok=True)
         return os.path.join(self.work_dir, "tar", name + ".tar")
 
+    def get_tar_stamp(self, name: str) -> str:
+        return self.get_tar(name) + ".sha256"
+
+    def get_hls_key(self, name: str, *settings: str) -> str:
+        """Return a digest of everything the tarball of task `name` depends on.
+
+        This covers the extracted C++ code of the task, the extracted headers,
+        the HLS tool in use, and `settings`.
+        """
+        digest = hashlib.sha256()
+        with open(self.get_cpp_path(name), "rb") as src_code:
+            digest.update(src_code.read())
+        for header_name, content in sorted(self.headers.items()):
+            digest.update(f"\0{header_name}\0{content}".encode())
+        for setting in (
+            shutil.which("vitis_hls") or "",
+            shutil.which("v++") or "",
+            *settings,
+        ):
+            digest.update(f"\0{setting}".encode())
+        return digest.hexdigest()
+
+    def _find_duplicate_tasks(self) -> dict[str, str]:
+        """Return lower-level tasks mapped to an equivalent task to synthesize."""
+        codes = {}
+        for task in self._tasks.values():
+            if task.is_lower and task.name != self.top:
+                with open(self.get_cpp_path(task.name), encoding="utf-8") as fp:
+                    codes[task.name] = fp.read()
+        with open(self.get_cpp_path(self.top), encoding="utf-8") as fp:
+            duplicates = find_duplicate_tasks(codes, fp.read())
+        for name, representative in duplicates.items():
+            _logger.info("task %s is equivalent to task %s", name, representative)
+        return duplicates
+
     def get_rtl(self, name: str, prefix: bool = True) -> str:
         return os.path.join(
             self.rtl_dir,
@@ -492,36 +661,32 @@ int main(int argc, char ** argv)
             name + RTL_SUFFIX,
         )
 
-    def _get_hls_report_xml(self, name: str) -> ET.ElementTree:
-        tree = self._hls_report_xmls.get(name)
-        if tree is None:
+    def _get_hls_report(self, name: str) -> HlsReport:
+        report = self._hls_reports.get(name)
+        if report is None:
             filename = os.path.join(self.report_dir, f"{name}_csynth.xml")
-            self._hls_report_xmls[name] = tree = ET.parse(filename)
-        return tree
+            self._hls_reports[name] = report = load_hls_report(filename)
+        return report
 
     def _get_part_num(self, name: str) -> str:
-        xml = self._get_hls_report_xml(name)
-        part = xml.find("./UserAssignments/Part")
-        assert part is not None
-        assert part.text
-        return part.text
+        return self._get_hls_report(name).part_num
 
     def get_area(self, name: str) -> dict[str, int]:
-        node = self._get_hls_report_xml(name).find("./AreaEstimates/Resources")
-        assert node is not None
-        return {x.tag: int(x.text or "-1") for x in sorted(node, key=lambda x: x.tag)}
+        return dict(self._get_hls_report(name).area)
 
     def get_clock_period(self, name: str) -> decimal.Decimal:
-        xml = self._get_hls_report_xml(name)
-        period = xml.find(
-            "./PerformanceEstimates/SummaryOfTimingAnalysis/EstimatedClockPeriod",
-        )
-        assert period is not None
-        assert period.text
-        return decimal.Decimal(period.text)
+        return self._get_hls_report(name).clock_period
+
+    def extract_cpp(
+        self,
+        target: str = "hls",
+        aie_array_rows: int | None = None,
+    ) -> "Program":
+        """Extract HLS/AIE C++ files.
 
-    def extract_cpp(self, target: str = "hls") -> "Program":
-        """Extract HLS/AIE C++ files."""
+        If `aie_array_rows` is given, AIE kernels are placed in an array with
+        that many rows.
+        """
         _logger.info("extracting %s C++ files", target)
         check_mmap_arg_name(list(self._tasks.values()))
 
@@ -532,7 +697,7 @@ int main(int argc, char ** argv)
                     "There should be exactly one top-level task"
                 )
                 top_aie_task_is_done = True
-                code_content = self.get_aie_graph(task)
+                code_content = self.get_aie_graph(task, aie_array_rows)
                 with open(
                     self.get_header_path(task.name), "w", encoding="utf-8"
                 ) as src_code:
@@ -588,14 +753,80 @@ int main(int argc, char ** argv)
         keep_hls_work_dir: bool = False,
         flow_type: str = "hls",
         platform: str | None = None,
+        skip_based_on_content: bool = False,
+        aie_array_rows: int | None = None,
+        hls_cache_dir: str | None = None,
+        hls_launchers: Sequence[str] = (),
+        hls_memory_budget: int | None = None,
+        dedup_hls: bool = False,
     ) -> "Program":
-        """Run HLS with extracted HLS C++ files and generate tarballs."""
-        self.extract_cpp(flow_type)
+        """Run HLS with extracted HLS C++ files and generate tarballs.
+
+        If `skip_based_on_content` is set, a task is skipped if its tarball was
+        generated from the same C++ code, headers, and HLS settings.
+
+        If `hls_cache_dir` is set, tarballs are also looked up in and added to
+        the cache in that directory, which may be shared with other work
+        directories.
+
+        If `hls_launchers` is set, each HLS run is launched by a command prefix
+        taken from it, e.g., `ssh host` or `srun --mem=16G`, which is not used
+        by other runs at the same time. A launcher may be repeated to run
+        multiple jobs with it. The work directory must be shared with the hosts
+        that HLS is launched on.
+
+        Local HLS jobs are started as long as their memory usage, estimated by
+        the peak usage in their last runs, fits in `hls_memory_budget` bytes,
+        which defaults to the available memory. Tasks that used the most memory
+        are started first, as they tend to take the longest.
+
+        If `dedup_hls` is set, lower-level tasks whose extracted code only
+        differs in the task name are synthesized once, and the results of the
+        others are renamed from it.
+
+        The RTL of each task is extracted and parsed as soon as its tarball is
+        ready, while other tasks are still running HLS.
+        """
+        self.extract_cpp(flow_type, aie_array_rows)
+        hls_cache = HlsCache(hls_cache_dir) if hls_cache_dir else None
+        hls_work_dir = f"{self.work_dir}/hls"
+        launchers: queue.SimpleQueue[tuple[str, ...]] = queue.SimpleQueue()
+        for launcher in hls_launchers:
+            launchers.put(tuple(shlex.split(launcher)))
+        if hls_launchers:
+            os.makedirs(hls_work_dir, exist_ok=True)
+        hls_memory = MemoryHistory(os.path.join(self.work_dir, "hls_memory.json"))
+        memory_budget = MemoryBudget(hls_memory_budget or virtual_memory().available)
+        duplicates = (
+            self._find_duplicate_tasks() if dedup_hls and flow_type == "hls" else {}
+        )
+        # Equivalent tasks are only shared if synthesized at the same clock.
+        duplicates = {
+            name: representative
+            for name, representative in duplicates.items()
+            if (name in self.clock_2_tasks) == (representative in self.clock_2_tasks)
+        }
+        # Free-running tasks are only shared with each other.
+        free_running_tasks = self._get_free_running_tasks()
+        duplicates = {
+            name: representative
+            for name, representative in duplicates.items()
+            if (name in free_running_tasks) == (representative in free_running_tasks)
+        }
+        duplicate_keys: dict[str, str] = {}
 
         _logger.info("running %s", flow_type)
 
         def worker(task: Task, idx: int) -> None:
             _logger.info("start worker for %s, target: %s", task.name, task.target_type)
+            task_clock_period = clock_period
+            if task.name in self.clock_2_tasks and self.clock_2_period is not None:
+                task_clock_period = self.clock_2_period
+            task_configs = other_configs
+            if task.name in free_running_tasks:
+                task_configs += (
+                    f"\nset_directive_interface -mode ap_ctrl_none {task.name} return"
+                )
             os.nice(idx % 19)
             try:
                 if skip_based_on_mtime and os.path.getmtime(
@@ -618,23 +849,74 @@ int main(int argc, char ** argv)
                     *(f"-isystem{x}" for x in get_vendor_include_paths()),
                 ),
             )
+            hls_key = self.get_hls_key(
+                task.name,
+                flow_type,
+                hls_cflags,
+                str(task_clock_period),
+                part_num,
+                task_configs,
+                platform or "",
+            )
+            tar_stamp = Path(self.get_tar_stamp(task.name))
+            if skip_based_on_content:
+                try:
+                    if (
+                        os.path.exists(self.get_tar(task.name))
+                        and tar_stamp.read_text(encoding="utf-8") == hls_key
+                    ):
+                        _logger.info(
+                            "skipping %s for %s since its inputs are unchanged",
+                            flow_type,
+                            task.name,
+                        )
+                        return
+                except FileNotFoundError:
+                    pass
+            tar_stamp.unlink(missing_ok=True)
+            if hls_cache is not None and hls_cache.load(
+                hls_key, self.get_tar(task.name)
+            ):
+                _logger.info("reusing cached %s result for %s", flow_type, task.name)
+                tar_stamp.write_text(hls_key, encoding="utf-8")
+                return
+            if task.name in duplicates:
+                # Renamed from the tarball of its representative after all runs.
+                duplicate_keys[task.name] = hls_key
+                return
             if flow_type == "hls":
-                with (
-                    open(self.get_tar(task.name), "wb") as tarfileobj,
-                    RunHls(
-                        tarfileobj,
-                        kernel_files=[(self.get_cpp_path(task.name), hls_cflags)],
-                        work_dir=f"{self.work_dir}/hls" if keep_hls_work_dir else None,
-                        top_name=task.name,
-                        clock_period=str(clock_period),
-                        part_num=part_num,
-                        auto_prefix=True,
-                        hls="vitis_hls",
-                        std="c++14",
-                        other_configs=other_configs,
-                    ) as proc,
-                ):
-                    stdout, stderr = proc.communicate()
+                launcher = launchers.get() if hls_launchers else ()
+                # Jobs launched on other hosts do not use local memory.
+                memory = 0 if hls_launchers else hls_memory.estimate(task.name)
+                try:
+                    with (
+                        memory_budget.reserve(memory),
+                        build_trace.span(task.name, "hls") as event_args,
+                        open(self.get_tar(task.name), "wb") as tarfileobj,
+                        RunHls(
+                            tarfileobj,
+                            kernel_files=[(self.get_cpp_path(task.name), hls_cflags)],
+                            work_dir=hls_work_dir if keep_hls_work_dir else None,
+                            top_name=task.name,
+                            clock_period=str(task_clock_period),
+                            part_num=part_num,
+                            auto_prefix=True,
+                            hls="vitis_hls",
+                            std="c++14",
+                            other_configs=task_configs,
+                            launcher=launcher,
+                            tempdir_parent=hls_work_dir if hls_launchers else None,
+                        ) as proc,
+                        PeakMemoryMonitor(proc.pid) as monitor,
+                    ):
+                        stdout, stderr = proc.communicate()
+                        event_args["cpu_time"] = round(monitor.cpu_time, 3)
+                        event_args["peak_memory"] = monitor.peak
+                finally:
+                    if hls_launchers:
+                        launchers.put(launcher)
+                if proc.returncode == 0 and not hls_launchers:
+                    hls_memory.update(task.name, monitor.peak)
             elif flow_type == "aie":
                 if task.name != self.top:
                     # For AIE flow, only the top-level task is synthesized
@@ -672,15 +954,49 @@ int main(int argc, char ** argv)
                 aie_dummy_bug_msg = "/bin/sh: 1: [[: not found"
                 if aie_dummy_bug_msg not in stderr.decode("utf-8"):
                     raise RuntimeError(msg)
+            tar_stamp.write_text(hls_key, encoding="utf-8")
+            if hls_cache is not None:
+                hls_cache.store(hls_key, self.get_tar(task.name))
 
-        jobs = jobs or cpu_count(logical=False)
+        jobs = jobs or len(hls_launchers) or cpu_count(logical=False)
         _logger.info(
             "spawn %d workers for parallel %s synthesis of the tasks", jobs, flow_type
         )
 
+        if flow_type == "hls":
+            self._start_rtl_parser()
+
         try:
             with futures.ThreadPoolExecutor(max_workers=jobs) as executor:
-                any(executor.map(worker, self._tasks.values(), itertools.count(0)))
+                tasks = sorted(
+                    self._tasks.values(),
+                    key=lambda task: hls_memory.estimate(task.name),
+                    reverse=True,
+                )
+                running = {
+                    executor.submit(worker, task, idx): task
+                    for idx, task in enumerate(tasks)
+                }
+                for future in futures.as_completed(running):
+                    future.result()
+                    task = running[future]
+                    if flow_type == "hls" and task.name not in duplicates:
+                        self._load_task_rtl(task)
+            for name, hls_key in duplicate_keys.items():
+                representative = duplicates[name]
+                _logger.info(
+                    "reusing %s result of %s for %s", flow_type, representative, name
+                )
+                rename_hls_tar(
+                    self.get_tar(representative),
+                    self.get_tar(name),
+                    representative,
+                    name,
+                )
+                Path(self.get_tar_stamp(name)).write_text(hls_key, encoding="utf-8")
+            if flow_type == "hls":
+                for name in duplicates:
+                    self._load_task_rtl(self._tasks[name])
         except RuntimeError:
             _logger.error(
                 "HLS failed, see above for details. You may use `--keep-hls-work-dir` "
@@ -690,31 +1006,70 @@ int main(int argc, char ** argv)
 
         return self
 
-    def generate_task_rtl(self, print_fifo_ops: bool) -> "Program":
-        """Extract HDL files from tarballs generated from HLS."""
+    def _start_rtl_parser(self) -> None:
+        """Start the processes that parse the RTL of tasks.
+
+        The processes are forked before HLS threads are started, as forking a
+        process with running threads may deadlock the child.
+        """
+        if self._rtl_parser is None:
+            self._rtl_parser = futures.ProcessPoolExecutor(
+                mp_context=multiprocessing.get_context("fork")
+            )
+            # Forked processes are all started by the first submission.
+            self._rtl_parser.submit(int).result()
+
+    def _load_task_rtl(self, task: Task) -> None:
+        """Extract the tarball of `task` and start parsing its RTL."""
+        _logger.debug("extracting RTL files of %s", task.name)
+        with (
+            build_trace.span(task.name, "extract"),
+            tarfile.open(self.get_tar(task.name), "r") as tarfileobj,
+        ):
+            tarfileobj.extractall(path=self.work_dir)
+        self._start_rtl_parser()
+        assert self._rtl_parser is not None
+        self._rtl_modules[task.name] = self._rtl_parser.submit(
+            Module, [self.get_rtl(task.name)], not task.is_upper
+        )
+
+    def generate_task_rtl(
+        self, print_fifo_ops: bool, coalesce_streams: bool = False
+    ) -> "Program":
+        """Extract HDL files from tarballs generated from HLS.
+
+        Tasks already loaded by `run_hls_or_aie` are not extracted again.
+        """
         _logger.info("extracting RTL files")
-        for task in self._tasks.values():
-            with tarfile.open(self.get_tar(task.name), "r") as tarfileobj:
-                tarfileobj.extractall(path=self.work_dir)
+        with build_trace.span("extract", "synth"):
+            for task in self._tasks.values():
+                if task.name not in self._rtl_modules:
+                    self._load_task_rtl(task)
 
         for file_name in (
             "arbiter.v",
             "async_mmap.v",
             "axi_pipeline.v",
+            "clock_crossing.v",
             "axi_crossbar_addr.v",
             "axi_crossbar_rd.v",
             "axi_crossbar_wr.v",
             "axi_crossbar.v",
             "axi_register_rd.v",
             "axi_register_wr.v",
+            "axi_upsizer.v",
             "detect_burst.v",
             "fifo.v",
             "fifo_bram.v",
+            "fifo_broadcast.v",
+            "fifo_coalesced.v",
             "fifo_fwd.v",
             "fifo_srl.v",
             "generate_last.v",
+            "hw_counters.v",
             "priority_encoder.v",
             "relay_station.v",
+            "reorder_read_data.v",
             "a_axi_write_broadcastor_1_to_3.v",
             "a_axi_write_broadcastor_1_to_4.v",
         ):
@@ -725,38 +1080,192 @@ int main(int argc, char ** argv)
 
         # extract and parse RTL and populate tasks
         _logger.info("parsing RTL files and populating tasks")
-        for task, module in zip(
-            self._tasks.values(),
-            futures.ProcessPoolExecutor().map(
-                Module,
-                ([self.get_rtl(x.name)] for x in self._tasks.values()),
-                (not x.is_upper for x in self._tasks.values()),
-            ),
-        ):
-            _logger.debug("parsing %s", task.name)
-            task.module = module
-            task.self_area = self.get_area(task.name)
-            task.clock_period = self.get_clock_period(task.name)
-            _logger.debug("populating %s", task.name)
-            self._populate_task(task)
+        with build_trace.span("parse", "synth"):
+            for task in self._tasks.values():
+                _logger.debug("parsing %s", task.name)
+                task.module = self._rtl_modules.pop(task.name).result()
+                task.self_area = self.get_area(task.name)
+                task.clock_period = self.get_clock_period(task.name)
+                task.low_latency_control = self.low_latency_control
+                _logger.debug("populating %s", task.name)
+                self._populate_task(task)
+        assert self._rtl_parser is not None
+        self._rtl_parser.shutdown()
+        self._rtl_parser = None
+        self._check_clock_2_tasks()
+
+        # HLS may have widened the m_axi ports of lower-level tasks; tasks are
+        # sorted so that children are updated before their parents
+        for task in self._tasks.values():
+            if task.is_upper:
+                task.update_mmap_widths()
+        for port in self.toplevel_ports:
+            port.width = self.top_task.ports[port.name].width
 
         # instrument the upper-level RTL except the top-level
         _logger.info("instrumenting upper-level RTL")
+        tasks = []
         for task in self._tasks.values():
             if task.is_upper and task.name != self.top:
-                self._instrument_upper_and_template_task(task, print_fifo_ops)
+                tasks.append(task)
             elif not task.is_upper and task.name in self.gen_templates:
                 assert task.ports
-                self._instrument_upper_and_template_task(task, print_fifo_ops)
+                tasks.append(task)
+        with build_trace.span("instrument", "synth"):
+            self._instrument_tasks(tasks, print_fifo_ops, coalesce_streams)
 
         return self
 
-    def generate_top_rtl(self, print_fifo_ops: bool) -> "Program":
+    def update_graph_port_widths(self, graph: dict) -> None:
+        """Write the port widths of upper-level tasks back to `graph`.
+
+        Widths of mmap ports are updated by `generate_task_rtl`, and programs
+        loaded from the graph by later steps need the updated widths.
+        """
+        for task in self._tasks.values():
+            if task.is_upper:
+                for port in graph["tasks"][task.name]["ports"]:
+                    port["width"] = task.ports[sanitize_array_name(port["name"])].width
+
+    def partition_floorplan(self, grid: str, max_util: float) -> "Program":
+        """Partition the instances of the top task into a grid of slots.
+
+        The area of each instance comes from its HLS report, and each slot
+        may use up to `max_util` of its share of the device resources, or of
+        the total area if the device resources are not reported.  Instances
+        and m_axi ports in `floorplan` keep their slots.  The streams crossing
+        slots are minimized by their widths and distances, and the result is
+        added to `floorplan`, so crossing streams are pipelined with relay
+        stations.  It is also saved as `floorplan.json`, and as
+        `floorplan.xdc` with a pblock for each SLR.
+        """
+        slots = get_slots(grid)
+        task = self.top_task
+        areas = {instance.name: instance.task.total_area for instance in task.instances}
+        streams = []
+        for fifo_name, fifo in task.fifos.items():
+            if "produced_by" in fifo and "consumed_by" in fifo:
+                streams.append(
+                    (
+                        get_instance_name(fifo["produced_by"]),
+                        get_instance_name(fifo["consumed_by"]),
+                        self._get_fifo_bits(task, fifo_name) or 1,
+                    )
+                )
+        total: dict[str, int] = {}
+        for area in areas.values():
+            for key, value in area.items():
+                total[key] = total.get(key, 0) + value
+        # Placed m_axi ports pull their users like streams of their width.
+        ports: dict[str, dict[str, int]] = {
+            name: {} for name in task.mmaps if name in self.floorplan
+        }
+        streams.extend(
+            (name, arg.instance.name, task.ports[name].width)
+            for name in ports
+            for arg in task.mmaps[name].args
+        )
+        available = self._get_hls_report(self.top).available
+        if available:
+            capacity = {
+                key: available[key] * max_util / len(slots)
+                for key in total
+                if available.get(key, 0) > 0
+            }
+        else:
+            capacity = {
+                key: value / len(slots) / max_util for key, value in total.items()
+            }
+
+        fixed = {
+            name: slot
+            for name, slot in self.floorplan.items()
+            if name in areas or name in ports
+        }
+        with build_trace.span("floorplan", "synth"):
+            result = partition({**areas, **ports}, streams, slots, capacity, fixed)
+        instances = {name: result[name] for name in areas}
+        self.floorplan = {**self.floorplan, **instances}
+        _logger.info(
+            "partitioned %d instances into %d slots, with %d bit-levels of streams "
+            "crossing slots",
+            len(areas),
+            len(slots),
+            get_crossing_cost(result, streams),
+        )
+        with open(
+            os.path.join(self.work_dir, "floorplan.json"), "w", encoding="utf-8"
+        ) as fp:
+            json.dump(self.floorplan, fp, indent=2)
+        with open(
+            os.path.join(self.work_dir, "floorplan.xdc"), "w", encoding="utf-8"
+        ) as fp:
+            fp.write(get_pblock_constraints(instances))
+        return self
+
+    def _instrument_tasks(
+        self,
+        tasks: list[Task],
+        print_fifo_ops: bool,
+        coalesce_streams: bool,
+    ) -> None:
+        """Instrument `tasks` in parallel, each after its upper-level children.
+
+        Tasks are instrumented in waves. Tasks in the same wave do not
+        instantiate each other, so they are instrumented in forked processes,
+        which share the program without pickling it and send back the modules
+        they modified.
+        """
+        global _forked_program  # noqa: PLW0603
+        remaining = {task.name: task for task in tasks}
+        while remaining:
+            wave = [
+                task
+                for task in remaining.values()
+                if not any(child in remaining for child in task.tasks)
+            ]
+            for task in wave:
+                del remaining[task.name]
+            wave_trace = build_trace.span(
+                "instrument wave", "synth", tasks=[task.name for task in wave]
+            )
+            if len(wave) == 1:
+                with wave_trace:
+                    self._instrument_upper_and_template_task(
+                        wave[0], print_fifo_ops, coalesce_streams
+                    )
+                continue
+
+            _forked_program = self
+            try:
+                with wave_trace, futures.ProcessPoolExecutor(
+                    max_workers=min(len(wave), cpu_count()),
+                    mp_context=multiprocessing.get_context("fork"),
+                ) as executor:
+                    results = executor.map(
+                        _instrument_in_forked_process,
+                        (task.name for task in wave),
+                        itertools.repeat(print_fifo_ops),
+                        itertools.repeat(coalesce_streams),
+                    )
+                    for task, (module, fsm_module, files) in zip(wave, results):
+                        task.module = module
+                        if fsm_module is not None:
+                            task.fsm_module = fsm_module
+                        self.files.update(files)
+            finally:
+                _forked_program = None
+
+    def generate_top_rtl(
+        self, print_fifo_ops: bool, coalesce_streams: bool = False
+    ) -> "Program":
         """Instrument HDL files generated from HLS.
 
         Args:
         ----
             print_fifo_ops: Whether to print debugging info for FIFO operations.
+            coalesce_streams: Whether to share a FIFO among streams that are
+                always transferred together by both of their ends.
 
         Returns:
         -------
@@ -769,15 +1278,24 @@ int main(int argc, char ** argv)
 
         # instrument the top-level RTL
         _logger.info("instrumenting top-level RTL")
-        self._instrument_upper_and_template_task(
-            self.top_task,
-            print_fifo_ops,
-        )
+        with build_trace.span("instrument top", "synth"):
+            self._instrument_upper_and_template_task(
+                self.top_task,
+                print_fifo_ops,
+                coalesce_streams,
+            )
 
         _logger.info("generating report")
         task_report = self.top_task.report
+        task_report["performance"]["estimate"] = self.estimate_performance()
         with open(self.report.yaml, "w", encoding="utf-8") as fp:
-            yaml.dump(task_report, fp, default_flow_style=False, sort_keys=False)
+            yaml.dump(
+                task_report,
+                fp,
+                Dumper=_ReportDumper,
+                default_flow_style=False,
+                sort_keys=False,
+            )
         with open(self.report.json, "w", encoding="utf-8") as fp:
             json.dump(task_report, fp, indent=2)
 
@@ -789,7 +1307,75 @@ int main(int argc, char ** argv)
 
         return self
 
-    def pack_rtl(self, output_file: str) -> "Program":
+    def estimate_performance(self) -> dict:
+        """Estimate the steady-state throughput of the top task before cosim.
+
+        Each lower-level instance transfers a token every initiation interval
+        of its innermost loops, and delays it by their iteration latency, as
+        reported by HLS.  Upper-level instances are estimated recursively.
+        Bottlenecks and FIFOs that are too shallow for the paths they bypass
+        are logged.
+        """
+        result = self._estimate_task_performance(self.top_task, {})
+        interval = result["interval"]
+        clock_period = self.top_task.clock_period
+        result["tokens_per_us"] = (
+            round(float(1000 / clock_period / interval), 3)
+            if interval and clock_period > 0
+            else None
+        )
+        if interval:
+            _logger.info(
+                "estimated a token every %d cycles, limited by %s",
+                interval,
+                ", ".join(result["bottlenecks"]),
+            )
+        return result
+
+    def _estimate_task_performance(
+        self, task: Task, estimates: dict[str, dict]
+    ) -> dict:
+        """Return the estimate of upper-level `task`, memoized in `estimates`."""
+        if task.name in estimates:
+            return estimates[task.name]
+        tasks = {}
+        for instance in task.instances:
+            if instance.task.is_upper:
+                child = self._estimate_task_performance(instance.task, estimates)
+                perf = TaskPerf(child["interval"], child["latency"])
+            else:
+                report = self._get_hls_report(instance.task.name)
+                perf = TaskPerf(report.loop_ii, report.loop_depth or 1)
+            tasks[instance.name] = perf
+        streams = [
+            Stream(
+                name,
+                get_instance_name(fifo["produced_by"]),
+                get_instance_name(fifo["consumed_by"]),
+                fifo["depth"],
+            )
+            for name, fifo in task.fifos.items()
+            if "produced_by" in fifo and "consumed_by" in fifo and "depth" in fifo
+        ]
+        estimates[task.name] = result = estimate(tasks, streams)
+        for name, stream in result["stalling_streams"].items():
+            _logger.warning(
+                "stream %s.%s of depth %d may stall its producer; a depth of %d "
+                "is estimated to sustain the throughput",
+                task.name,
+                name,
+                stream["depth"],
+                stream["required_depth"],
+            )
+        return result
+
+    def pack_rtl(self, output_file: str, incremental: bool = False) -> "Program":
+        """Package the RTL code and HLS reports into a .xo file.
+
+        If `incremental` is set, Vivado only runs again if the kernel interface
+        or the set of RTL files changed since the last packaging in the work
+        directory; otherwise, the RTL files in the last .xo file are replaced.
+        """
         _logger.info("packaging RTL code")
         with contextlib.ExitStack() as stack:  # avoid nested with statement
             tmp_fp = stack.enter_context(tempfile.TemporaryFile())
@@ -799,6 +1385,8 @@ int main(int argc, char ** argv)
                 rtl_dir=self.rtl_dir,
                 part_num=self._get_part_num(self.top),
                 output_file=tmp_fp,
+                cache_dir=os.path.join(self.work_dir, "xo") if incremental else None,
+                clock_2_ports=self._get_clock_2_ports(),
             )
             tmp_fp.seek(0)
 
@@ -823,9 +1411,25 @@ int main(int argc, char ** argv)
                 redacted_info.external_attr = info.external_attr
                 output_fp.writestr(redacted_info, _redact(packed_obj, info))
 
+        write_args_file(output_file)
+        write_hash_file(output_file)
         _logger.info("generated the v++ xo file at %s", output_file)
         return self
 
+    def _get_clock_2_ports(self) -> tuple[str, ...]:
+        """Return the top-level mmap ports that are accessed on `ap_clk_2`."""
+        return tuple(
+            sorted(
+                {
+                    arg["arg"]
+                    for name in self.clock_2_tasks
+                    for obj in self.top_task.tasks.get(name, ())
+                    for arg in obj["args"].values()
+                    if arg["cat"] == "mmap"
+                }
+            )
+        )
+
     def _populate_task(self, task: Task) -> None:
         task.instances = tuple(
             Instance(self.get_task(name), instance_id=idx, **obj)
@@ -833,15 +1437,95 @@ int main(int argc, char ** argv)
             for idx, obj in enumerate(objs)
         )
 
+    def _check_clock_2_tasks(self) -> None:
+        """Check that tasks on `ap_clk_2` only cross clocks through streams.
+
+        Scalars are passed as is since they do not change while tasks run.
+        """
+        if not self.clock_2_tasks:
+            return
+        for task in self._tasks.values():
+            if not task.is_upper or task.name == self.top:
+                continue
+            for instance in task.instances:
+                if instance.task.name in self.clock_2_tasks:
+                    msg = (
+                        f"task {instance.task.name} runs on ap_clk_2 and can only "
+                        f"be instantiated by the top-level task, not {task.name}"
+                    )
+                    raise ValueError(msg)
+
+        mmap_users: dict[str, list[str]] = {}
+        for instance in self.top_task.instances:
+            for arg in instance.args:
+                if arg.cat.is_mmap:
+                    mmap_users.setdefault(arg.name, []).append(instance.name)
+        for instance in self.top_task.instances:
+            if instance.task.name not in self.clock_2_tasks:
+                continue
+            for arg in instance.args:
+                if arg.cat.is_async_mmap:
+                    msg = f"async_mmap {arg.name} cannot be accessed on ap_clk_2"
+                    raise ValueError(msg)
+                if arg.cat.is_mmap and len(mmap_users[arg.name]) > 1:
+                    msg = (
+                        f"mmap {arg.name} cannot be accessed on ap_clk_2 since it "
+                        f"is shared by {', '.join(mmap_users[arg.name])}"
+                    )
+                    raise ValueError(msg)
+                if arg.cat.is_stream and self.top_task.is_fifo_external(arg.name):
+                    msg = f"top-level stream {arg.name} cannot be accessed on ap_clk_2"
+                    raise ValueError(msg)
+
+    def _is_clock_2(self, task: Task, end: tuple[str, int]) -> bool:
+        """Return whether the instance at `end` of a FIFO in `task` is on ap_clk_2."""
+        return task.name == self.top and end[0] in self.clock_2_tasks
+
+    def _get_free_running_tasks(self) -> set[str]:
+        """Return lower-level tasks to synthesize with `ap_ctrl_none`.
+
+        A task may run freely once out of reset if all of its instances are
+        detached and only take streams and constants, because nothing is
+        passed to it by the start of the kernel.
+        """
+        if not self.free_running_detached:
+            return set()
+        candidates = {
+            task.name
+            for task in self._tasks.values()
+            if task.is_lower
+            and task.name != self.top
+            and task.name not in self.gen_templates
+            and task.name not in self.clock_2_tasks
+        }
+        instantiated = set()
+        for task in self._tasks.values():
+            if not task.is_upper:
+                continue
+            for name, objs in task.tasks.items():
+                instantiated.add(name)
+                for obj in objs:
+                    if obj["step"] >= 0 or not all(
+                        arg["cat"] in {"istream", "ostream"} or "'d" in arg["arg"]
+                        for arg in obj["args"].values()
+                    ):
+                        candidates.discard(name)
+        return candidates & instantiated
+
     def _connect_fifos(self, task: Task) -> None:
         _logger.debug("  connecting %s's children tasks", task.name)
+        declared_wires = set()
         for fifo_name in task.fifos:
             for direction in task.get_fifo_directions(fifo_name):
                 task_name, _, fifo_port = task.get_connection_to(fifo_name, direction)
+                end_name = task.get_fifo_end_name(fifo_name, direction)
 
                 for suffix in task.get_fifo_suffixes(direction):
                     # declare wires for FIFOs
-                    w_name = wire_name(fifo_name, suffix)
+                    w_name = wire_name(end_name, suffix)
+                    if w_name in declared_wires:
+                        continue  # lanes of a broadcast stream share the producer
+                    declared_wires.add(w_name)
                     wire_width = (
                         self.get_task(task_name)
                         .module.get_port_of(fifo_port, suffix)
@@ -856,7 +1540,44 @@ int main(int argc, char ** argv)
                     fifo_name, task.name == self.top and self.vitis_mode
                 )
 
-    def _instantiate_fifos(self, task: Task, print_fifo_ops: bool) -> None:
+    def _get_lockstep_fifos(
+        self, task: Task, fifos: dict[str, dict]
+    ) -> list[dict[str, int]]:
+        """Return groups of FIFOs that both of their ends transfer in lockstep.
+
+        Each group maps the names of its FIFOs to their widths.
+        """
+        groups: dict[tuple, dict[str, int]] = {}
+        for fifo_name, fifo in fifos.items():
+            key = []
+            for direction in ("produced_by", "consumed_by"):
+                task_name, _, port_name = task.get_connection_to(fifo_name, direction)
+                ports = getattr(self.get_task(task_name), "ports", {})
+                port = ports.get(sanitize_array_name(port_name))
+                if port is None or port.lockstep is None:
+                    break
+                if task_name in self.gen_templates:
+                    break  # Templates may access streams differently.
+                key.append((*fifo[direction], port.lockstep))
+            else:
+                producer_task, _, fifo_port = task.get_connection_to(
+                    fifo_name, "produced_by"
+                )
+                width = (
+                    self.get_task(producer_task)
+                    .module.get_port_of(fifo_port, OSTREAM_SUFFIXES[0])
+                    .width
+                )
+                try:
+                    lane_width = int(width.msb.value) - int(width.lsb.value) + 1
+                except ValueError:
+                    continue  # Lanes must have constant widths.
+                groups.setdefault(tuple(key), {})[fifo_name] = lane_width
+        return [group for group in groups.values() if len(group) > 1]
+
+    def _instantiate_fifos(
+        self, task: Task, print_fifo_ops: bool, coalesce_streams: bool
+    ) -> None:
         _logger.debug("  instantiating FIFOs in %s", task.name)
 
         # skip instantiating if the fifo is not declared in this task
@@ -864,6 +1585,46 @@ int main(int argc, char ** argv)
         if not fifos:
             return
 
+        coalesced_fifos = set()
+        if coalesce_streams:
+            fifos_on_clk = {
+                name: fifo
+                for name, fifo in fifos.items()
+                if "broadcast" not in fifo
+                and not self._is_clock_2(task, fifo["produced_by"])
+                and not self._is_clock_2(task, fifo["consumed_by"])
+            }
+            for lanes in self._get_lockstep_fifos(task, fifos_on_clk):
+                _logger.info("coalescing FIFOs %s in %s", ", ".join(lanes), task.name)
+                task.module.add_coalesced_fifo_instance(
+                    name=f"{sanitize_array_name(next(iter(lanes)))}_coalesced",
+                    rst=RST,
+                    lanes=lanes,
+                    depth=max(fifos[x]["depth"] for x in lanes),
+                )
+                coalesced_fifos.update(lanes)
+
+        broadcasts: dict[str, list[str]] = {}
+        for fifo_name, fifo in fifos.items():
+            if "broadcast" in fifo:
+                broadcasts.setdefault(fifo["broadcast"], []).append(fifo_name)
+        for name, lanes in broadcasts.items():
+            is_clock_2 = self._is_clock_2(task, fifos[lanes[0]]["produced_by"])
+            if any(
+                self._is_clock_2(task, fifos[x]["consumed_by"]) != is_clock_2
+                for x in lanes
+            ):
+                msg = f"broadcast stream {name} in {task.name} crosses clock domains"
+                raise ValueError(msg)
+            task.module.add_broadcast_fifo_instance(
+                name=name,
+                rst=RST_2 if is_clock_2 else RST,
+                lanes=lanes,
+                width=self._get_fifo_width(task, lanes[0]),
+                depth=max(fifos[x]["depth"] for x in lanes),
+                clk=CLK_2 if is_clock_2 else CLK,
+            )
+
         col_width = max(
             max(
                 len(name),
@@ -873,16 +1634,32 @@ int main(int argc, char ** argv)
             for name, fifo in fifos.items()
         )
 
+        total_cost = FifoCost()
         for fifo_name, fifo in fifos.items():
             _logger.debug("    instantiating %s.%s", task.name, fifo_name)
 
             # add FIFO instances
-            task.module.add_fifo_instance(
-                name=fifo_name,
-                rst=RST,
-                width=self._get_fifo_width(task, fifo_name),
-                depth=fifo["depth"],
-            )
+            if fifo_name not in coalesced_fifos and "broadcast" not in fifo:
+                is_write_clock_2 = self._is_clock_2(task, fifo["produced_by"])
+                is_read_clock_2 = self._is_clock_2(task, fifo["consumed_by"])
+                read_clk = None
+                if is_write_clock_2 != is_read_clock_2:
+                    read_clk = CLK_2 if is_read_clock_2 else CLK
+                level = self._get_relay_level(task, fifo_name)
+                mem_style = "auto"
+                if not level and read_clk is None:
+                    mem_style, cost = self._get_fifo_mem_style(task, fifo_name)
+                    total_cost += cost
+                task.module.add_fifo_instance(
+                    name=fifo_name,
+                    rst=RST_2 if is_write_clock_2 else RST,
+                    width=self._get_fifo_width(task, fifo_name),
+                    depth=fifo["depth"],
+                    level=level,
+                    mem_style=mem_style,
+                    clk=CLK_2 if is_write_clock_2 else CLK,
+                    read_clk=read_clk,
+                )
 
             if not print_fifo_ops:
                 continue
@@ -905,6 +1682,7 @@ int main(int argc, char ** argv)
                 ),
                 ("consumed_by", "produced_by"),
             ):
+                end_name = task.get_fifo_end_name(fifo_name, fifo_tag)
                 display = SingleStatement(
                     statement=SystemCall(
                         syscall="display",
@@ -917,7 +1695,7 @@ int main(int argc, char ** argv)
                                     **fmtargs,
                                 ),
                             ),
-                            Identifier(name=wire_name(fifo_name, suffixes[0])),
+                            Identifier(name=wire_name(end_name, suffixes[0])),
                         ),
                     ),
                 )
@@ -928,7 +1706,7 @@ int main(int argc, char ** argv)
                             IfStatement(
                                 cond=Eq(
                                     left=Identifier(
-                                        name=wire_name(fifo_name, suffixes[-1]),
+                                        name=wire_name(end_name, suffixes[-1]),
                                     ),
                                     right=TRUE,
                                 ),
@@ -940,6 +1718,100 @@ int main(int argc, char ** argv)
                 )
             task.module.add_logics(debugging_blocks)
 
+        _logger.info(
+            "FIFOs in %s are estimated to use %d LUTs, %d BRAM18s, and %d URAMs",
+            task.name,
+            *total_cost,
+        )
+
+    def _get_fifo_mem_style(self, task: Task, fifo_name: str) -> tuple[str, FifoCost]:
+        """Return the `MEM_STYLE` of `fifo_name` in `task` and its estimated cost.
+
+        The implementation is overridden by `fifo_impls` if specified, or else
+        picked by the cost model. FIFOs of non-constant widths and FIFOs of
+        depth 1, which use registers only, are left to the FIFO module.
+        """
+        depth = task.fifos[fifo_name]["depth"]
+        width = self._get_fifo_bits(task, fifo_name)
+        if width is None or depth <= 1:
+            return "auto", FifoCost()
+        impl = self.fifo_impls.get(
+            f"{task.name}.{fifo_name}",
+            self.fifo_impls.get(fifo_name),
+        ) or pick_fifo_style(width, depth)
+        _logger.debug("    implementing %s.%s in %s", task.name, fifo_name, impl)
+        return MEM_STYLES[impl], estimate_fifo_cost(impl, width, depth)
+
+    def _get_fifo_bits(self, task: Task, fifo_name: str) -> int | None:
+        """Return the width of `fifo_name` in `task`, or `None` if not constant."""
+        producer_task, _, fifo_port = task.get_connection_to(fifo_name, "produced_by")
+        width = (
+            self.get_task(producer_task)
+            .module.get_port_of(fifo_port, OSTREAM_SUFFIXES[0])
+            .width
+        )
+        try:
+            return int(width.msb.value) - int(width.lsb.value) + 1
+        except (AttributeError, ValueError):
+            return None
+
+    def _get_relay_level(self, task: Task, fifo_name: str) -> int:
+        """Return the relay station levels of `fifo_name` per the floorplan.
+
+        Only FIFOs of the top task whose producer and consumer are both placed
+        are pipelined.
+        """
+        if task.name != self.top or not self.floorplan:
+            return 0
+        fifo = task.fifos[fifo_name]
+        src = self.floorplan.get(get_instance_name(fifo["produced_by"]))
+        dst = self.floorplan.get(get_instance_name(fifo["consumed_by"]))
+        if src is None or dst is None:
+            return 0
+        level = get_relay_level(src, dst)
+        if level:
+            _logger.info(
+                "pipelining FIFO %s from %s to %s with %d levels",
+                fifo_name,
+                src,
+                dst,
+                level,
+            )
+        return level
+
+    def _get_m_axi_stages(self, task: Task) -> dict[str, int]:
+        """Return the register stages of the m_axi ports of `task`.
+
+        Only ports of the top task are pipelined.  A port placed in the
+        floorplan gets as many stages as the relay levels to its farthest
+        placed user, unless `m_axi_stages` specifies its stages.
+        """
+        if task.name != self.top:
+            return {}
+        clock_2_ports = self._get_clock_2_ports()
+        stages = {}
+        for arg_name, mmap in task.mmaps.items():
+            slot = self.floorplan.get(arg_name)
+            if slot is None or arg_name in clock_2_ports:
+                continue
+            stages[arg_name] = max(
+                (
+                    get_relay_level(slot, self.floorplan[arg.instance.name])
+                    for arg in mmap.args
+                    if arg.instance.name in self.floorplan
+                ),
+                default=0,
+            )
+        for arg_name, count in self.m_axi_stages.items():
+            if arg_name not in task.mmaps:
+                msg = f"m_axi port '{arg_name}' does not exist in {task.name}"
+                raise ValueError(msg)
+            if count and arg_name in clock_2_ports:
+                msg = f"m_axi port '{arg_name}' on ap_clk_2 cannot be pipelined"
+                raise ValueError(msg)
+            stages[arg_name] = count
+        return {name: count for name, count in stages.items() if count}
+
     def _instantiate_children_tasks(  # noqa: C901,PLR0912,PLR0915,PLR0914  # TODO: refactor this method
         self,
         task: Task,
@@ -951,7 +1823,13 @@ int main(int argc, char ** argv)
         arg_table: dict[str, Pipeline] = {}
         async_mmap_args: dict[Instance.Arg, list[str]] = {}
 
-        task.add_m_axi(width_table, self.files)
+        task.add_m_axi(
+            width_table,
+            self.files,
+            self.crossbar_radix,
+            self.crossbar_stages,
+            self._get_m_axi_stages(task),
+        )
 
         # Wires connecting to the upstream (s_axi_control).
         fsm_upstream_portargs: list[PortArg] = [
@@ -1045,7 +1923,7 @@ int main(int argc, char ** argv)
                             generate_async_mmap_signals(
                                 tag=tag,
                                 arg=arg.mmap_name,
-                                data_width=width_table[arg.name],
+                                data_width=instance.task.ports[arg.port].width,
                             ),
                         )
                     else:
@@ -1061,7 +1939,10 @@ int main(int argc, char ** argv)
             start_q = Pipeline(f"{instance.start.name}_global")
             task.fsm_module.add_pipeline(start_q, self.start_q[0])
 
-            if instance.is_autorun:
+            if instance.task.is_free_running:
+                # free-running modules start on their own once out of reset
+                _logger.debug("    %s is free-running", instance.name)
+            elif instance.is_autorun:
                 # autorun modules start when the global start signal is asserted
                 task.fsm_module.add_logics(
                     [
@@ -1090,7 +1971,28 @@ int main(int argc, char ** argv)
                 # set up state
                 is_done_q = Pipeline(f"{instance.is_done.name}")
                 done_q = Pipeline(f"{instance.done.name}_global")
-                task.fsm_module.add_pipeline(is_done_q, instance.is_state(STATE10))
+                is_done = instance.is_state(STATE10)
+                if task.low_latency_control:
+                    # also done in the cycle the instance finishes
+                    is_done = make_operation(
+                        operator=Lor,
+                        nodes=(
+                            is_done,
+                            make_operation(
+                                operator=Land,
+                                nodes=(
+                                    instance.is_state(STATE01),
+                                    instance.ready,
+                                    instance.done,
+                                ),
+                            ),
+                            make_operation(
+                                operator=Land,
+                                nodes=(instance.is_state(STATE11), instance.done),
+                            ),
+                        ),
+                    )
+                task.fsm_module.add_pipeline(is_done_q, is_done)
                 task.fsm_module.add_pipeline(done_q, self.done_q[0])
 
                 if_branch = instance.set_state(STATE00)
@@ -1160,7 +2062,10 @@ int main(int argc, char ** argv)
             fsm_downstream_module_ports.extend(instance.public_handshake_ports)
 
             # add task module instances
-            portargs = list(generate_handshake_ports(instance, RST_N))
+            if task.name == self.top and instance.task.name in self.clock_2_tasks:
+                portargs = self._cross_handshake_to_clock_2(task, instance)
+            else:
+                portargs = list(generate_handshake_ports(instance, RST_N))
             for arg in instance.args:
                 if arg.cat.is_scalar:
                     portargs.append(
@@ -1222,12 +2127,17 @@ int main(int argc, char ** argv)
 
         if task.is_upper:
             for arg, tag in async_mmap_args.items():
+                port = arg.instance.task.ports[arg.port]
                 task.module.add_async_mmap_instance(
                     name=arg.mmap_name,
                     tags=tag,
                     rst=RST,
-                    data_width=width_table[arg.name],
+                    data_width=port.width,
                     addr_width=addr_width,
+                    buffer_size=port.buffer_size,
+                    max_burst_len=port.max_burst_len and port.max_burst_len - 1,
+                    id_width=port.id_width,
+                    reorder_buffer_size=port.reorder_buffer_size,
                 )
 
             task.module.add_instance(
@@ -1238,6 +2148,195 @@ int main(int argc, char ** argv)
 
         return is_done_signals
 
+    @staticmethod
+    def _cross_handshake_to_clock_2(task: Task, instance: Instance) -> list[PortArg]:
+        """Cross the handshake of `instance` to `ap_clk_2` and return its ports.
+
+        The FSM of `task` drives the handshake signals of `instance` on `ap_clk`
+        as usual, which are passed to and from the instance on `ap_clk_2` by a
+        `handshake_crossing`.
+        """
+        ports = (HANDSHAKE_START, *HANDSHAKE_OUTPUT_PORTS)
+        task.module.add_signals(
+            Wire(wire_name(f"{instance.name}_clk_2", x)) for x in ports
+        )
+        task.module.add_instance(
+            module_name="handshake_crossing",
+            instance_name=f"{instance.name}_handshake_crossing",
+            ports=(
+                make_port_arg("s_clk", CLK),
+                make_port_arg("s_reset", RST),
+                make_port_arg(f"s_{HANDSHAKE_START}", instance.start),
+                *(
+                    make_port_arg(
+                        f"s_{x}",
+                        "" if instance.is_autorun else wire_name(instance.name, x),
+                    )
+                    for x in HANDSHAKE_OUTPUT_PORTS
+                ),
+                make_port_arg("m_clk", CLK_2),
+                make_port_arg("m_reset", RST_2),
+                *(
+                    make_port_arg(f"m_{x}", wire_name(f"{instance.name}_clk_2", x))
+                    for x in ports
+                ),
+            ),
+        )
+        return [
+            make_port_arg(HANDSHAKE_CLK, CLK_2),
+            make_port_arg(HANDSHAKE_RST_N, RST_N_2),
+            *(
+                make_port_arg(x, wire_name(f"{instance.name}_clk_2", x))
+                for x in ports
+            ),
+        ]
+
+    @staticmethod
+    def _add_clock_2(task: Task) -> None:
+        """Add `ap_clk_2` and its reset synchronized to it to the top `task`."""
+        task.module.add_ports([Input(HANDSHAKE_CLK_2), Input(HANDSHAKE_RST_N_2)])
+        task.module.add_signals([Wire(RST_N_2.name)])
+        task.module.add_instance(
+            module_name="reset_sync",
+            instance_name=f"{RST_N_2.name}_unit",
+            ports=(
+                make_port_arg("clk", CLK_2),
+                make_port_arg("async_rst_n", HANDSHAKE_RST_N_2),
+                make_port_arg("rst_n", RST_N_2),
+            ),
+        )
+
+    def _get_hw_counter_entries(self, task: Task) -> list[tuple[str, str]]:
+        """Return `(kind, name)` of streams and mmaps of `task` to monitor."""
+        entries = []
+        for fifo_name, fifo in task.fifos.items():
+            if (
+                not task.is_fifo_external(fifo_name)
+                and not self._is_clock_2(task, fifo["produced_by"])
+                and not self._is_clock_2(task, fifo["consumed_by"])
+                and any(fnmatch.fnmatch(fifo_name, x) for x in self.hw_counters)
+            ):
+                entries.append(("stream", fifo_name))
+        for port in task.ports.values():
+            if port.cat.is_mmap and any(
+                fnmatch.fnmatch(port.name, x) for x in self.hw_counters
+            ):
+                entries.extend(
+                    ("mmap", get_indexed_name(port.name, i))
+                    for i in range_or_none(port.chan_count)
+                )
+        return entries
+
+    def _add_hw_counters(self, task: Task) -> None:
+        """Count events of streams and mmaps of the top `task` in hardware.
+
+        The counters are served on `s_axi_control` above the registers of HLS,
+        whose read channels are reconnected through a `hw_counters` instance.
+        """
+        if not self.vitis_mode:
+            msg = "hardware counters are read through s_axi_control of Vitis kernels"
+            raise ValueError(msg)
+        entries = self._get_hw_counter_entries(task)
+        if not entries:
+            _logger.warning("no stream or mmap matches --hw-counter")
+            return
+        check_size(entries)
+        old_addr_width = task.module.set_param_value(
+            S_AXI_ADDR_WIDTH_PARAM, HW_COUNTERS_ADDR_WIDTH
+        )
+        if 1 << old_addr_width > HW_COUNTERS_BASE_ADDR:
+            msg = "control registers overlap with hardware counters"
+            raise ValueError(msg)
+
+        events: list[Node] = []
+        for kind, name in entries:
+            if kind == "stream":
+                # Lanes of a broadcast stream share the write side.
+                write_name = task.get_fifo_end_name(name, "produced_by")
+                full_n, empty_n, write = (
+                    Identifier(wire_name(x, suffix))
+                    for x, suffix in (
+                        (write_name, "_full_n"),
+                        (name, "_empty_n"),
+                        (write_name, "_write"),
+                    )
+                )
+                events.extend((Unot(full_n), Unot(empty_n), Land(write, full_n)))
+            else:
+                valid, ready = (
+                    {
+                        channel: Identifier(f"{M_AXI_PREFIX}{name}_{channel}{x}")
+                        for channel in ("AR", "AW", "R", "W")
+                    }
+                    for x in ("VALID", "READY")
+                )
+                events.extend(
+                    (
+                        Land(valid["R"], ready["R"]),
+                        Land(valid["W"], ready["W"]),
+                        Land(valid["AR"], Unot(ready["AR"])),
+                        Land(valid["AW"], Unot(ready["AW"])),
+                    )
+                )
+            _logger.info(
+                "counting %s of %s %s in hardware",
+                ", ".join(HW_COUNTERS[kind]),
+                kind,
+                name,
+            )
+
+        names = encode_names(entries)
+        s_axi_ports = {
+            "ARVALID": "arvalid",
+            "ARREADY": "arready",
+            "ARADDR": "araddr",
+            "RVALID": "rvalid",
+            "RREADY": "rready",
+            "RDATA": "rdata",
+            "RRESP": "rresp",
+        }
+        widths = {"araddr": HW_COUNTERS_ADDR_WIDTH, "rdata": 32, "rresp": 2}
+        task.module.add_signals(
+            Wire(f"hw_counters__{x}", make_width(widths.get(x, 0)))
+            for x in s_axi_ports.values()
+        )
+        task.module.connect_instance_ports(
+            S_AXI_INSTANCE,
+            {port: f"hw_counters__{x}" for port, x in s_axi_ports.items()},
+        )
+        task.module.add_instance(
+            module_name="hw_counters",
+            instance_name="hw_counters_unit",
+            ports=(
+                make_port_arg("clk", CLK),
+                make_port_arg("rst", RST),
+                make_port_arg("ap_start", START),
+                make_port_arg("ap_idle", IDLE),
+                make_port_arg("events", Concat(tuple(reversed(events)))),
+                *(
+                    make_port_arg(f"s_{x}", f"{S_AXI_NAME}_{port}")
+                    for port, x in s_axi_ports.items()
+                ),
+                *(
+                    make_port_arg(f"m_{x}", f"hw_counters__{x}")
+                    for x in s_axi_ports.values()
+                ),
+            ),
+            params=(
+                ParamArg("AddrWidth", Constant(HW_COUNTERS_ADDR_WIDTH)),
+                ParamArg("BaseAddr", Constant(HW_COUNTERS_BASE_ADDR)),
+                ParamArg("EventCount", Constant(len(events))),
+                ParamArg("NameSize", Constant(len(names))),
+                ParamArg(
+                    "Names",
+                    Constant(
+                        f"{len(names) * 8}'h"
+                        f"{int.from_bytes(names, 'little'):0{len(names) * 2}x}"
+                    ),
+                ),
+            ),
+        )
+
     def _instantiate_global_fsm(
         self,
         module: Module,
@@ -1312,6 +2411,7 @@ int main(int argc, char ** argv)
         self,
         task: Task,
         print_fifo_ops: bool,
+        coalesce_streams: bool = False,
     ) -> None:
         """Codegen for the top task."""
         # assert task.is_upper
@@ -1373,7 +2473,9 @@ int main(int argc, char ** argv)
                 ) as rtl_code:
                     rtl_code.write(task.module.get_template_code())
         else:
-            self._instantiate_fifos(task, print_fifo_ops)
+            if task.name == self.top and self.clock_2_tasks:
+                self._add_clock_2(task)
+            self._instantiate_fifos(task, print_fifo_ops, coalesce_streams)
             self._connect_fifos(task)
             width_table = {port.name: port.width for port in task.ports.values()}
             is_done_signals = self._instantiate_children_tasks(
@@ -1381,6 +2483,8 @@ int main(int argc, char ** argv)
                 width_table,
                 tuple(top_fifos),
             )
+            if task.name == self.top and self.hw_counters:
+                self._add_hw_counters(task)
             self._instantiate_global_fsm(task.fsm_module, is_done_signals)
 
             with open(
@@ -1389,11 +2493,16 @@ int main(int argc, char ** argv)
                 encoding="utf-8",
             ) as rtl_code:
                 rtl_code.write(task.fsm_module.code)
+            task.fsm_module = task.fsm_module.get_interface()
 
         # generate the top-level task
         with open(self.get_rtl(task.name), "w", encoding="utf-8") as rtl_code:
             rtl_code.write(task.module.code)
 
+        # Only the interface is needed by the parents, so the body is released
+        # to keep the peak memory bounded by the largest instrumented module.
+        task.module = task.module.get_interface()
+
     def _get_fifo_width(self, task: Task, fifo: str) -> Node:
         producer_task, _, fifo_port = task.get_connection_to(fifo, "produced_by")
         port = self.get_task(producer_task).module.get_port_of(
@@ -1484,7 +2593,7 @@ int main(int argc, char ** argv)
             ]
             raise ValueError("\n".join(msg))
 
-    def get_aie_graph(self, task: Task) -> str:
+    def get_aie_graph(self, task: Task, array_rows: int | None = None) -> str:
         """Generates the complete AIE graph code."""
 
         _header_decl, kernel_decl, port_decl = gen_declarations(task)
@@ -1495,7 +2604,7 @@ int main(int argc, char ** argv)
             kernel_runtime,
             kernel_loc,
             port_def,
-        ) = gen_definitions(task)
+        ) = gen_definitions(task, array_rows)
         connect_def = gen_connections(task)
 
         return self.GRAPH_HEADER_TEMPLATE.format(
@@ -1512,6 +2621,36 @@ int main(int argc, char ** argv)
         )
 
 
+# The program whose tasks are instrumented by forked worker processes.
+_forked_program: Program | None = None
+
+
+class _ReportDumper(yaml.Dumper):
+    """Writes reports shared by multiple parents in full instead of aliases."""
+
+    def ignore_aliases(self, data: object) -> bool:  # noqa: ARG002, PLR6301
+        return True
+
+
+def _instrument_in_forked_process(
+    name: str,
+    print_fifo_ops: bool,
+    coalesce_streams: bool,
+) -> tuple[Module, Module | None, dict[str, str]]:
+    """Instrument task `name` of the program inherited from the parent process.
+
+    Returns the interface of the modified module and FSM module, if any, of the
+    task, and the generated auxiliary RTL files.
+    """
+    program = _forked_program
+    assert program is not None
+    task = program.get_task(name)
+    program._instrument_upper_and_template_task(  # noqa: SLF001
+        task, print_fifo_ops, coalesce_streams
+    )
+    return task.module, getattr(task, "fsm_module", None), program.files
+
+
 def _redact(xo: zipfile.ZipFile, info: zipfile.ZipInfo) -> bytes:
     content = xo.read(info)
     if not info.filename.endswith(".xml"):
@@ -10,25 +10,39 @@ import os
 import os.path
 import re
 import subprocess
+import sys
 from collections import defaultdict
 from collections.abc import Sequence
+from concurrent import futures
 from pathlib import Path
 
 from tapa import __version__
 from tapa.cosim.common import AXI, Arg
 from tapa.cosim.config_preprocess import preprocess_config
+from tapa.cosim.incremental import (
+    hash_files,
+    invalidate,
+    is_up_to_date,
+    mark_up_to_date,
+)
+from tapa.cosim.memory_model import MemoryTiming, parse_memory_timing
 from tapa.cosim.templates import (
     get_axi_ram_inst,
     get_axi_ram_module,
+    get_axi_timing_model,
     get_axis,
     get_begin,
     get_dut,
     get_end,
+    get_port_stats,
     get_s_axi_control,
+    get_scalar_file,
     get_srl_fifo_template,
     get_test_signals,
 )
-from tapa.cosim.vivado import get_vivado_tcl
+from tapa.cosim.snapshot import get_snapshot, run_snapshot
+from tapa.cosim.verilator import build_and_run
+from tapa.cosim.vivado import SNAPSHOT_NAME, XSIM_DIR, get_vivado_tcl
 
 [logging.root.removeHandler(handler) for handler in logging.root.handlers]
 logging.basicConfig(
@@ -39,6 +53,8 @@ logging.basicConfig(
 
 _logger = logging.getLogger().getChild(__name__)
 
+_DEFAULT_NETTYPE = "`default_nettype wire\n"
+
 
 def parse_register_addr(ctrl_unit_path: str) -> dict[str, list[str]]:
     """
@@ -100,6 +116,11 @@ def get_cosim_tb(
     axi_list: list[AXI],
     args: Sequence[Arg],
     scalar_to_val: dict[str, str],
+    stream_batch_size: int,
+    port_stats_path: str,
+    port_trace_path: str,
+    runtime_args: bool = False,
+    scalar_path: str | None = None,
 ) -> str:
     """
     generate a lightweight testbench to test the HLS RTL
@@ -114,11 +135,15 @@ def get_cosim_tb(
 
     tb += get_s_axi_control() + "\n"
 
-    tb += get_axis(args) + "\n"
+    tb += get_axis(args, stream_batch_size) + "\n"
 
     tb += get_dut(top_name, args) + "\n"
 
-    tb += get_test_signals(arg_to_reg_addrs, scalar_to_val, args)
+    tb += get_port_stats(args, port_stats_path, port_trace_path) + "\n"
+
+    tb += get_test_signals(
+        arg_to_reg_addrs, scalar_to_val, args, runtime_args, scalar_path
+    )
 
     tb += get_end() + "\n"
 
@@ -132,66 +157,281 @@ def set_default_nettype(verilog_path: str) -> None:
     to wire to bypass this issue.
     """
     _logger.info("append `default_nettype wire to every RTL file")
-    for file in os.listdir(verilog_path):
-        if file.endswith((".v", ".sv")):
-            abs_path = os.path.join(verilog_path, file)
-            with open(abs_path, "r+", encoding="utf-8") as f:
-                content = f.read()
-                f.seek(0, 0)
-                f.write("`default_nettype wire\n" + content)
+    with futures.ThreadPoolExecutor() as executor:
+        for future in [
+            executor.submit(_set_default_nettype, os.path.join(verilog_path, file))
+            for file in os.listdir(verilog_path)
+            if file.endswith((".v", ".sv"))
+        ]:
+            future.result()
 
 
-def main() -> None:  # pylint: disable=too-many-locals
-    """Main entry point for the TAPA fast cosim tool."""
-    parser = argparse.ArgumentParser()
-    parser.add_argument("--config_path", type=str, required=True)
-    parser.add_argument("--tb_output_dir", type=str, required=True)
-    parser.add_argument("--part_num", type=str, required=False)
-    parser.add_argument("--launch_simulation", action="store_true")
-    parser.add_argument("--save_waveform", action="store_true")
-    parser.add_argument("--start_gui", action="store_true")
-    parser.add_argument("--setup_only", action="store_true")
-    args = parser.parse_args()
+def _set_default_nettype(path: str) -> None:
+    """Prepend `default_nettype wire to the RTL file at `path`."""
+    with open(path, "r+", encoding="utf-8") as f:
+        content = f.read()
+        # files are already patched if a previous extraction is reused
+        if content.startswith(_DEFAULT_NETTYPE):
+            return
+        f.seek(0, 0)
+        f.write(_DEFAULT_NETTYPE + content)
+
+
+def get_port_stats_path(tb_output_dir: str) -> str:
+    """Return where the testbench saves the traffic counters of each port."""
+    return os.path.abspath(f"{tb_output_dir}/port_stats.json")
+
+
+def get_port_trace_path(tb_output_dir: str) -> str:
+    """Return where the testbench saves the traffic of each port over time."""
+    return os.path.abspath(f"{tb_output_dir}/port_trace.csv")
+
+
+def get_scalar_path(tb_output_dir: str) -> str:
+    """Return where the testbench reads scalar values from."""
+    return os.path.abspath(f"{tb_output_dir}/scalars.hex")
 
-    _logger.info("TAPA fast cosim version: %s", __version__)
 
-    config = preprocess_config(args.config_path, args.tb_output_dir, args.part_num)
+def write_testbench(
+    config: dict,
+    tb_output_dir: str,
+    stream_batch_size: int,
+    runtime_args: bool = False,
+) -> None:
+    """Write the testbench RTL files for `config` into `tb_output_dir`.
 
+    If `runtime_args` is set, scalar values and shared memory objects are read
+    from plusargs instead of being baked into the testbench. Otherwise, scalar
+    values are written to a separate file, so that changing them alone does not
+    change the testbench RTL and the compiled simulation can be reused.
+    """
     top_name = config["top_name"]
     verilog_path = config["verilog_path"]
     top_path = f"{verilog_path}/{top_name}.v"
     ctrl_path = f"{verilog_path}/{top_name}_control_s_axi.v"
 
-    # add default nettype to all rtl
-    set_default_nettype(verilog_path)
-
     axi_list = parse_m_axi_interfaces(top_path)
+    scalar_path = None if runtime_args else get_scalar_path(tb_output_dir)
     tb = get_cosim_tb(
         top_name,
         ctrl_path,
         axi_list,
         config["args"],
         config["scalar_to_val"],
+        stream_batch_size,
+        get_port_stats_path(tb_output_dir),
+        get_port_trace_path(tb_output_dir),
+        runtime_args,
+        scalar_path,
     )
 
     # generate test bench RTL files
-    Path(args.tb_output_dir).mkdir(parents=True, exist_ok=True)
-    for bin_file in Path(args.tb_output_dir).glob("*.bin"):
+    Path(tb_output_dir).mkdir(parents=True, exist_ok=True)
+    for bin_file in Path(tb_output_dir).glob("*.bin"):
         bin_file.unlink()
-    with open(f"{args.tb_output_dir}/tb.sv", "w", encoding="utf-8") as fp:
+    for ram_file in Path(tb_output_dir).glob("axi_ram_*.*v"):
+        ram_file.unlink()
+    Path(f"{tb_output_dir}/axi_timing_model.sv").unlink(missing_ok=True)
+    with open(f"{tb_output_dir}/tb.sv", "w", encoding="utf-8") as fp:
         fp.write(tb)
-    with open(f"{args.tb_output_dir}/fifo_srl_tb.v", "w", encoding="utf-8") as fp:
+    with open(f"{tb_output_dir}/fifo_srl_tb.v", "w", encoding="utf-8") as fp:
         fp.write(get_srl_fifo_template())
+    if scalar_path is not None:
+        with open(scalar_path, "w", encoding="utf-8") as fp:
+            fp.write(
+                get_scalar_file(parse_register_addr(ctrl_path), config["scalar_to_val"])
+            )
+
+    timings = parse_memory_timing(
+        config.get("axi_ram_timing", ""), (axi.name for axi in axi_list)
+    )
+    if any(timing != MemoryTiming() for timing in timings.values()):
+        with open(
+            f"{tb_output_dir}/axi_timing_model.sv", "w", encoding="utf-8"
+        ) as fp:
+            fp.write(get_axi_timing_model())
 
     for axi in axi_list:
-        source_data_path = config["axi_to_data_file"][axi.name]
+        source_data_path = config["axi_to_data_file"].get(axi.name, "")
+        shm_path = config["axi_to_shm_file"].get(axi.name)
         c_array_size = config["axi_to_c_array_size"][axi.name]
-        ram_module = get_axi_ram_module(axi, source_data_path, c_array_size)
+        ram_module = get_axi_ram_module(
+            axi,
+            source_data_path,
+            c_array_size,
+            shm_path,
+            runtime_args,
+            timings[axi.name],
+        )
+        # AXI RAMs import DPI functions and must be SystemVerilog
         with open(
-            f"{args.tb_output_dir}/axi_ram_{axi.name}.v", "w", encoding="utf-8"
+            f"{tb_output_dir}/axi_ram_{axi.name}.sv", "w", encoding="utf-8"
         ) as fp:
             fp.write(ram_module)
 
+
+def get_dpi_args(config: dict) -> str:
+    """Return `TAPA_FAST_COSIM_DPI_ARGS` naming the stream of each argument."""
+    return ",".join(f"{k}:{v}" for k, v in config["axis_to_data_file"].items())
+
+
+def get_elaboration_key(config: dict, tb_output_dir: str, vivado_script: str) -> str:
+    """Return a key identifying the xsim snapshot Vivado would elaborate.
+
+    The key covers the RTL, the generated testbench, and the Vivado script.
+    """
+    tb_files = sorted(Path(tb_output_dir).glob("*.v"))
+    tb_files += sorted(Path(tb_output_dir).glob("*.sv"))
+    return hash_files([config["verilog_path"], *tb_files], vivado_script)
+
+
+def get_simulation_key(
+    config: dict, tb_output_dir: str, elaboration_key: str
+) -> str | None:
+    """Return a key identifying the simulation results, or None if unknown.
+
+    Simulation is deterministic given the snapshot, the scalar values, and the
+    input data, but
+    only data files can be compared across runs: streams exchange data with
+    the host as the simulation proceeds and shared memory is gone by then.
+    """
+    if config["axis_to_data_file"] or config["axi_to_shm_file"]:
+        return None
+    data_files = list(config["axi_to_data_file"].values())
+    if not all(os.path.exists(x.replace(".bin", "_out.bin")) for x in data_files):
+        return None
+    return hash_files([*data_files, get_scalar_path(tb_output_dir)], elaboration_key)
+
+
+def _memory_timing(spec: str) -> str:
+    """Validate `--axi_ram_timing` for argparse."""
+    try:
+        parse_memory_timing(spec)
+    except ValueError as e:
+        raise argparse.ArgumentTypeError(str(e)) from e
+    return spec
+
+
+def main() -> None:  # pylint: disable=too-many-locals,too-many-statements
+    """Main entry point for the TAPA fast cosim tool."""
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--config_path", type=str, required=True)
+    parser.add_argument("--tb_output_dir", type=str, required=True)
+    parser.add_argument("--part_num", type=str, required=False)
+    parser.add_argument("--launch_simulation", action="store_true")
+    parser.add_argument("--save_waveform", action="store_true")
+    parser.add_argument("--start_gui", action="store_true")
+    parser.add_argument("--setup_only", action="store_true")
+    parser.add_argument(
+        "--stream_batch_size",
+        type=int,
+        default=64,
+        help="maximum number of stream tokens exchanged with the host per DPI "
+        "call; 1 reproduces token-by-token exchange",
+    )
+    parser.add_argument(
+        "--snapshot_cache_dir",
+        type=str,
+        required=False,
+        help="compile the xsim snapshot once per XO into this directory and "
+        "simulate it with data-dependent values passed at runtime",
+    )
+    parser.add_argument(
+        "--simulator",
+        choices=("xsim", "verilator"),
+        default="xsim",
+        help="simulate with Vivado xsim or with Verilator",
+    )
+    parser.add_argument(
+        "--verilator_threads",
+        type=int,
+        default=1,
+        help="number of threads the Verilator model evaluates with",
+    )
+    parser.add_argument(
+        "--axi_ram_timing",
+        type=_memory_timing,
+        default="",
+        help="latency, bandwidth, and row buffer model of the memory behind "
+        "AXI RAMs, e.g., 'ddr4' or 'hbm,a:read_latency=200'; ideal by default",
+    )
+    parser.add_argument(
+        "--force_rebuild",
+        action="store_true",
+        help="rerun every stage even if its inputs are unchanged since the "
+        "last run in --tb_output_dir",
+    )
+    args = parser.parse_args()
+
+    _logger.info("TAPA fast cosim version: %s", __version__)
+
+    incremental = not args.force_rebuild
+    config = preprocess_config(
+        args.config_path, args.tb_output_dir, args.part_num, incremental
+    )
+
+    config["axi_ram_timing"] = args.axi_ram_timing
+    verilog_path = config["verilog_path"]
+    top_path = f"{verilog_path}/{config['top_name']}.v"
+
+    # add default nettype to all rtl
+    set_default_nettype(verilog_path)
+
+    if args.snapshot_cache_dir or args.simulator == "verilator":
+        missing = [
+            axi.name
+            for axi in parse_m_axi_interfaces(top_path)
+            if axi.name not in config["axi_to_shm_file"]
+        ]
+        if missing:
+            _logger.error(
+                "--snapshot_cache_dir and --simulator=verilator require buffers "
+                "in shared memory; missing for %s",
+                missing,
+            )
+            sys.exit(1)
+
+    if args.simulator == "verilator":
+        if args.snapshot_cache_dir or args.start_gui or args.save_waveform:
+            _logger.warning(
+                "--snapshot_cache_dir, --start_gui, and --save_waveform "
+                "are ignored by Verilator"
+            )
+        write_testbench(config, args.tb_output_dir, args.stream_batch_size)
+        build_and_run(
+            config,
+            args.tb_output_dir,
+            f"{args.tb_output_dir}/run",
+            args.verilator_threads,
+            os.environ | {"TAPA_FAST_COSIM_DPI_ARGS": get_dpi_args(config)},
+            setup_only=args.setup_only or not args.launch_simulation,
+            incremental=incremental,
+        )
+        return
+
+    if args.snapshot_cache_dir:
+        xsim_dir = get_snapshot(
+            config,
+            args.snapshot_cache_dir,
+            args.stream_batch_size,
+            lambda tb_dir: write_testbench(
+                config, tb_dir, args.stream_batch_size, runtime_args=True
+            ),
+        )
+        if args.setup_only or not args.launch_simulation:
+            return
+        run_snapshot(
+            config,
+            xsim_dir,
+            f"{args.tb_output_dir}/run",
+            os.environ | {"TAPA_FAST_COSIM_DPI_ARGS": get_dpi_args(config)},
+            get_port_stats_path(args.tb_output_dir),
+            get_port_trace_path(args.tb_output_dir),
+        )
+        return
+
+    write_testbench(config, args.tb_output_dir, args.stream_batch_size)
+
     # generate vivado script
     Path(f"{args.tb_output_dir}/run").mkdir(parents=True, exist_ok=True)
     if args.save_waveform:
@@ -220,24 +460,49 @@ def main() -> None:  # pylint: disable=too-many-locals
     if args.setup_only:
         _logger.info("User requested to only setup the cosim environment, exiting...")
         return
+    if not args.launch_simulation:
+        return
 
-    # launch simulation
-    mode = "gui" if args.start_gui else "batch"
-    command = ["vivado", "-mode", mode, "-source", "run_cosim.tcl"]
-    if args.launch_simulation:
+    run_dir = Path(f"{args.tb_output_dir}/run").resolve()
+    elaboration_stamp = run_dir / "elaborate.stamp"
+    simulation_stamp = run_dir / "simulate.stamp"
+    elaboration_key = get_elaboration_key(
+        config, args.tb_output_dir, "\n".join(vivado_script)
+    )
+    simulation_key = get_simulation_key(config, args.tb_output_dir, elaboration_key)
+    env = os.environ | {"TAPA_FAST_COSIM_DPI_ARGS": get_dpi_args(config)}
+
+    if (
+        incremental
+        and simulation_key is not None
+        and is_up_to_date(simulation_stamp, simulation_key)
+    ):
+        return
+    invalidate(simulation_stamp)
+
+    # waveforms and the GUI are set up by Vivado, so they always rerun it
+    if (
+        incremental
+        and not args.start_gui
+        and not args.save_waveform
+        and (run_dir / XSIM_DIR).is_dir()
+        and is_up_to_date(elaboration_stamp, elaboration_key)
+    ):
+        command = ["xsim", SNAPSHOT_NAME, "-R"]
+        _logger.info("Running xsim command: %s", command)
+        subprocess.run(command, cwd=run_dir / XSIM_DIR, check=True, env=env)
+    else:
+        invalidate(elaboration_stamp)
+        mode = "gui" if args.start_gui else "batch"
+        command = ["vivado", "-mode", mode, "-source", "run_cosim.tcl"]
         _logger.info("Running vivado command: %s", command)
-        subprocess.run(
-            command,
-            cwd=Path(f"{args.tb_output_dir}/run").resolve(),
-            check=True,
-            env=os.environ
-            | {
-                "TAPA_FAST_COSIM_DPI_ARGS": ",".join(
-                    f"{k}:{v}" for k, v in config["axis_to_data_file"].items()
-                )
-            },
-        )
+        subprocess.run(command, cwd=run_dir, check=True, env=env)
+        mark_up_to_date(elaboration_stamp, elaboration_key)
 
+    # outputs of the first run are known only now
+    simulation_key = get_simulation_key(config, args.tb_output_dir, elaboration_key)
+    if simulation_key is not None:
+        mark_up_to_date(simulation_stamp, simulation_key)
 
 if __name__ == "__main__":
     main()
@@ -58,4 +58,5 @@ class Arg(NamedTuple):
         return self.address_qualifier == 4
 
 
-MAX_AXI_BRAM_ADDR_WIDTH = 32
+# The AXI RAMs are accessed via DPI, so they take the full address of m_axi.
+AXI_RAM_ADDR_WIDTH = 64
@@ -13,10 +13,17 @@ import os
 import shutil
 import sys
 import zipfile
+from concurrent import futures
 from pathlib import Path
 from xml.etree import ElementTree as ET
 
 from tapa.cosim.common import Arg, Port
+from tapa.cosim.incremental import (
+    hash_files,
+    invalidate,
+    is_up_to_date,
+    mark_up_to_date,
+)
 
 _logger = logging.getLogger().getChild(__name__)
 
@@ -29,7 +36,7 @@ def _update_relative_path(config: dict, config_path: str) -> None:
     if not curr_path.startswith("/") and not curr_path.startswith("~"):
         config["xo_path"] = f"{config_dir}/{curr_path}"
 
-    for axi_name, curr_path in config["axi_to_data_file"].items():
+    for axi_name, curr_path in config.setdefault("axi_to_data_file", {}).items():
         if not curr_path.startswith("/") and not curr_path.startswith("~"):
             config["axi_to_data_file"][axi_name] = f"{config_dir}/{curr_path}"
 
@@ -79,18 +86,80 @@ def parse_part_num(xo_dir: str) -> str | None:
     return extract_part_from_xml_file(csynth_reports[0])
 
 
-def _parse_xo_update_config(config: dict, tb_output_dir: str) -> None:
+def _extract_member(xo_path: str, info: zipfile.ZipInfo, dst_dir: str) -> None:
+    """Extract `info` of the xo at `xo_path` to `dst_dir`.
+
+    Each call opens the xo by itself, so that members can be decompressed by
+    multiple threads.
+    """
+    with zipfile.ZipFile(xo_path, "r") as zip_ref:
+        zip_ref.extract(info, dst_dir)
+
+
+def _extract_xo(xo_path: str, dst_dir: str) -> None:
+    """Extract the xo at `xo_path` to `dst_dir` with a thread per CPU.
+
+    The members extracted to `dst_dir` are recorded with their CRC-32 in
+    `extract-xo.json`. Members of the same CRC-32 are kept instead of being
+    extracted again, since the files may be patched after extraction, e.g., by
+    `set_default_nettype`; the other recorded files are removed.
+    """
+    manifest_path = Path(dst_dir) / "extract-xo.json"
+    try:
+        extracted: dict[str, int] = json.loads(
+            manifest_path.read_text(encoding="utf-8")
+        )
+    except (FileNotFoundError, json.JSONDecodeError):
+        extracted = {}
+
+    with zipfile.ZipFile(xo_path, "r") as zip_ref:
+        infos = [x for x in zip_ref.infolist() if not x.is_dir()]
+    members = {info.filename: info.CRC for info in infos}
+    kept = {
+        name: crc
+        for name, crc in extracted.items()
+        if members.get(name) == crc and (Path(dst_dir) / name).is_file()
+    }
+    for name in extracted.keys() - kept.keys():
+        (Path(dst_dir) / name).unlink(missing_ok=True)
+    # Files extracted by an interrupted call are not recorded, and are thus
+    # extracted again by the next call.
+    manifest_path.write_text(json.dumps(kept), encoding="utf-8")
+
+    outdated = [info for info in infos if info.filename not in kept]
+    _logger.info("extracting %d of %d files in %s", len(outdated), len(infos), xo_path)
+    with futures.ThreadPoolExecutor() as executor:
+        for future in [
+            executor.submit(_extract_member, xo_path, info, dst_dir)
+            for info in outdated
+        ]:
+            future.result()
+
+    manifest_path.write_text(json.dumps(members), encoding="utf-8")
+
+
+def _parse_xo_update_config(
+    config: dict, tb_output_dir: str, incremental: bool
+) -> None:
     """
     Only supports TAPA xo. Vitis XO has different hierarchy and RTL coding style
+
+    If `incremental` is set, the xo is extracted again only if its content
+    changed since the last extraction, and then only the files that changed.
     """
     xo_path = config["xo_path"]
 
     tmp_path = f"{tb_output_dir}/tapa_fast_cosim_{os.getuid()}/"
-    shutil.rmtree(tmp_path, ignore_errors=True)
-    Path(tmp_path).mkdir(parents=True, exist_ok=True)
-    shutil.copy(xo_path, f"{tmp_path}/target.xo")
-    zip_ref = zipfile.ZipFile(f"{tmp_path}/target.xo", "r")
-    zip_ref.extractall(tmp_path)
+    stamp = Path(tmp_path) / "extract-xo.stamp"
+    key = hash_files([xo_path])
+    if not (incremental and is_up_to_date(stamp, key)):
+        if not incremental:
+            shutil.rmtree(tmp_path, ignore_errors=True)
+        invalidate(stamp)
+        Path(tmp_path).mkdir(parents=True, exist_ok=True)
+        shutil.copy(xo_path, f"{tmp_path}/target.xo")
+        _extract_xo(f"{tmp_path}/target.xo", tmp_path)
+        mark_up_to_date(stamp, key)
 
     # only supports tapa xo
     src_dirs = glob.glob(f"{tmp_path}/ip_repo/*/src")
@@ -140,10 +209,11 @@ def _parse_xo_update_config(config: dict, tb_output_dir: str) -> None:
     for entry in (
         "scalar_to_val",
         "axi_to_data_file",
+        "axi_to_shm_file",
         "axis_to_data_file",
         "axi_to_c_array_size",
     ):
-        config[entry] = change_id_to_name(config[entry] or {})
+        config[entry] = change_id_to_name(config.get(entry) or {})
 
     config["part_num"] = parse_part_num(tmp_path)
 
@@ -161,9 +231,16 @@ def _check_scalar_val_format(config: dict) -> None:
 
 
 def preprocess_config(
-    config_path: str, tb_output_dir: str, part_num: str | None
+    config_path: str,
+    tb_output_dir: str,
+    part_num: str | None,
+    incremental: bool = False,
 ) -> dict:
-    """Preprocess the config file."""
+    """Preprocess the config file.
+
+    If `incremental` is set, the xo extracted by a previous run into
+    `tb_output_dir` is reused if the xo is unchanged.
+    """
     with open(config_path, encoding="utf-8") as fp:
         config = json.load(fp)
 
@@ -172,7 +249,7 @@ def preprocess_config(
         config["scalar_to_val"] = {}
 
     _update_relative_path(config, config_path)
-    _parse_xo_update_config(config, tb_output_dir)
+    _parse_xo_update_config(config, tb_output_dir, incremental)
     _check_scalar_val_format(config)
 
     # overwrite part number if provided
@@ -0,0 +1,67 @@
+"""Skip fast cosim stages whose inputs are unchanged since the last run."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import hashlib
+import logging
+from collections.abc import Iterable
+from pathlib import Path
+
+_logger = logging.getLogger().getChild(__name__)
+
+
+def hash_files(paths: Iterable[Path | str], *extra: str) -> str:
+    """Return a digest of the names and contents of `paths` and of `extra`.
+
+    Directories are hashed recursively; missing paths are hashed as such, so
+    that creating them changes the digest.
+    """
+    files: list[Path] = []
+    for path in map(Path, paths):
+        if path.is_dir():
+            files += sorted(x for x in path.rglob("*") if x.is_file())
+        else:
+            files.append(path)
+
+    digest = hashlib.sha256()
+    for file in files:
+        digest.update(f"{file}\0".encode())
+        if not file.is_file():
+            digest.update(b"\1")
+            continue
+        digest.update(b"\0")
+        with open(file, "rb") as fp:
+            for chunk in iter(lambda: fp.read(1 << 20), b""):
+                digest.update(chunk)
+    for value in extra:
+        digest.update(f"{value}\0".encode())
+    return digest.hexdigest()
+
+
+def is_up_to_date(stamp: Path, key: str) -> bool:
+    """Return whether the stage recorded by `stamp` last completed for `key`."""
+    try:
+        up_to_date = stamp.read_text(encoding="utf-8") == key
+    except FileNotFoundError:
+        return False
+    if up_to_date:
+        _logger.info("%s is up to date; skipping", stamp.stem)
+    return up_to_date
+
+
+def invalidate(stamp: Path) -> None:
+    """Forget the stage recorded by `stamp`, before it is run again.
+
+    A stage interrupted midway thus never appears to be up to date.
+    """
+    stamp.unlink(missing_ok=True)
+
+
+def mark_up_to_date(stamp: Path, key: str) -> None:
+    """Record that the stage for `stamp` completed for `key`."""
+    stamp.parent.mkdir(parents=True, exist_ok=True)
+    stamp.write_text(key, encoding="utf-8")
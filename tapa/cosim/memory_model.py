@@ -0,0 +1,101 @@
+"""Timing models of the memory behind the AXI RAMs of the testbench."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+from collections.abc import Iterable
+from typing import NamedTuple
+
+
+class MemoryTiming(NamedTuple):
+    """Timing of the memory behind an AXI RAM, in kernel clock cycles.
+
+    Zero disables the bandwidth and outstanding limits and the row miss penalty.
+    """
+
+    read_latency: int = 0
+    write_latency: int = 0
+    bytes_per_cycle: int = 0
+    max_outstanding_reads: int = 0
+    max_outstanding_writes: int = 0
+    row_bytes: int = 0
+    banks: int = 1
+    row_miss_penalty: int = 0
+
+
+# Rough figures of one DDR4 channel and one HBM pseudo-channel of Alveo cards,
+# with the kernel clock at 300 MHz. Calibrate them against on-board runs.
+PRESETS = {
+    "ideal": MemoryTiming(),
+    "ddr4": MemoryTiming(
+        read_latency=80,
+        write_latency=40,
+        bytes_per_cycle=64,
+        max_outstanding_reads=32,
+        max_outstanding_writes=32,
+        row_bytes=8192,
+        banks=16,
+        row_miss_penalty=20,
+    ),
+    "hbm": MemoryTiming(
+        read_latency=100,
+        write_latency=50,
+        bytes_per_cycle=48,
+        max_outstanding_reads=64,
+        max_outstanding_writes=32,
+        row_bytes=1024,
+        banks=16,
+        row_miss_penalty=15,
+    ),
+}
+
+
+def parse_memory_timing(
+    spec: str, ports: Iterable[str] | None = None
+) -> dict[str, MemoryTiming]:
+    """Return the timing of each of `ports` specified by `spec`.
+
+    `spec` is a comma-separated list of presets in `PRESETS` and `field=value`
+    of `MemoryTiming`, applied in order. Each of them applies to all ports, or
+    to a single port if prefixed by `port:`, e.g., `hbm,a:read_latency=200`.
+    Ports are ideal unless specified otherwise.
+
+    If `ports` is `None`, `spec` is only validated and ports are not checked.
+    Raises ValueError if `spec` is invalid.
+    """
+    if ports is not None:
+        ports = tuple(ports)
+    timings: dict[str, MemoryTiming] = {}
+    default = PRESETS["ideal"]
+    for item in filter(None, (x.strip() for x in spec.split(","))):
+        port, _, setting = item.rpartition(":")
+        name, sep, value = setting.partition("=")
+        if sep:
+            if name not in MemoryTiming._fields:
+                msg = f"unknown memory timing field '{name}' in '{item}'"
+                raise ValueError(msg)
+            if not value.isdigit() or (name == "banks" and int(value) == 0):
+                msg = f"invalid memory timing value '{value}' in '{item}'"
+                raise ValueError(msg)
+            update = {name: int(value)}
+        elif setting in PRESETS:
+            update = PRESETS[setting]._asdict()
+        else:
+            msg = f"unknown memory timing preset '{setting}' in '{item}'"
+            raise ValueError(msg)
+
+        if not port:
+            default = default._replace(**update)
+            timings = {k: v._replace(**update) for k, v in timings.items()}
+        elif ports is None or port in ports:
+            timings[port] = timings.get(port, default)._replace(**update)
+        else:
+            msg = f"unknown port '{port}' in memory timing '{item}'"
+            raise ValueError(msg)
+
+    if ports is None:
+        return timings
+    return {port: timings.get(port, default) for port in ports}
@@ -0,0 +1,128 @@
+"""Reuse compiled xsim snapshots across fast cosim runs."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import fcntl
+import hashlib
+import logging
+import shutil
+import subprocess
+from collections.abc import Callable, Iterator
+from contextlib import contextmanager
+from pathlib import Path
+
+from tapa import __version__
+from tapa.cosim.vivado import SNAPSHOT_NAME, XSIM_DIR, get_vivado_tcl
+
+_logger = logging.getLogger().getChild(__name__)
+
+_HEX_PREFIX = "'h"
+
+
+def get_snapshot_key(config: dict, stream_batch_size: int) -> str:
+    """Return a key identifying the snapshot compiled for `config`.
+
+    The key covers everything baked into the snapshot: the XO content, the
+    TAPA version generating the testbench, the part, the batch size, and the
+    memory timing model.
+    Scalar values and buffers are passed at runtime and are not part of it.
+    """
+    digest = hashlib.sha256()
+    with open(config["xo_path"], "rb") as fp:
+        for chunk in iter(lambda: fp.read(1 << 20), b""):
+            digest.update(chunk)
+    digest.update(f"{__version__}:{config['part_num']}:{stream_batch_size}".encode())
+    digest.update(config.get("axi_ram_timing", "").encode())
+    return digest.hexdigest()
+
+
+@contextmanager
+def _locked(lock_path: Path) -> Iterator[None]:
+    """Hold an exclusive lock on `lock_path`, across processes."""
+    with open(lock_path, "w", encoding="utf-8") as fp:
+        fcntl.flock(fp, fcntl.LOCK_EX)
+        try:
+            yield
+        finally:
+            fcntl.flock(fp, fcntl.LOCK_UN)
+
+
+def get_snapshot(
+    config: dict,
+    cache_dir: str,
+    stream_batch_size: int,
+    write_testbench: Callable[[str], None],
+) -> Path:
+    """Return the xsim directory of the snapshot, compiling it if not cached.
+
+    `write_testbench` writes a testbench reading data-dependent values from
+    plusargs into the given directory. Concurrent callers compile the same
+    snapshot only once.
+    """
+    snapshot_dir = Path(cache_dir) / get_snapshot_key(config, stream_batch_size)
+    snapshot_dir.mkdir(parents=True, exist_ok=True)
+    run_dir = snapshot_dir / "run"
+    with _locked(snapshot_dir / "lock"):
+        if (snapshot_dir / "done").exists():
+            _logger.info("reusing xsim snapshot in %s", snapshot_dir)
+            return run_dir / XSIM_DIR
+
+        _logger.info("compiling xsim snapshot in %s", snapshot_dir)
+        write_testbench(str(snapshot_dir))
+        run_dir.mkdir(exist_ok=True)
+        vivado_script = get_vivado_tcl(
+            config,
+            str(snapshot_dir),
+            save_waveform=False,
+            start_gui=False,
+            elaborate_only=True,
+        )
+        with open(run_dir / "run_cosim.tcl", "w", encoding="utf-8") as fp:
+            fp.write("\n".join(vivado_script))
+        subprocess.run(
+            ["vivado", "-mode", "batch", "-source", "run_cosim.tcl"],
+            cwd=run_dir,
+            check=True,
+        )
+        (snapshot_dir / "done").touch()
+    return run_dir / XSIM_DIR
+
+
+def run_snapshot(
+    config: dict,
+    xsim_dir: Path,
+    run_dir: str,
+    env: dict[str, str],
+    port_stats_path: str,
+    port_trace_path: str,
+) -> None:
+    """Simulate the snapshot in `xsim_dir` with the data sets of `config`.
+
+    Traffic counters of each port are saved to `port_stats_path`, and their
+    samples over time to `port_trace_path`.
+
+    The snapshot is copied into `run_dir`, so that runs in different work
+    directories can proceed in parallel.
+    """
+    Path(run_dir).mkdir(parents=True, exist_ok=True)
+    shutil.copytree(xsim_dir, run_dir, dirs_exist_ok=True)
+
+    # scalar values are in the `'h<hex>` format of `scalar_to_val`
+    plusargs = [
+        f"scalar_{name}={val.removeprefix(_HEX_PREFIX)}"
+        for name, val in config["scalar_to_val"].items()
+    ]
+    plusargs += [
+        f"axi_ram_{name}={path}" for name, path in config["axi_to_shm_file"].items()
+    ]
+    plusargs.append(f"port_stats={port_stats_path}")
+    plusargs.append(f"port_trace={port_trace_path}")
+    command = ["xsim", SNAPSHOT_NAME, "-R"]
+    for plusarg in plusargs:
+        command += ["-testplusarg", plusarg]
+    _logger.info("Running xsim command: %s", command)
+    subprocess.run(command, cwd=run_dir, check=True, env=env)
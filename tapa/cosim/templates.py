@@ -6,19 +6,18 @@ RapidStream Contributor License Agreement.
 
 import logging
 import os
-import sys
 from collections.abc import Sequence
 
-from tapa.cosim.common import AXI, MAX_AXI_BRAM_ADDR_WIDTH, Arg
+from tapa.cosim.common import AXI, AXI_RAM_ADDR_WIDTH, Arg
+from tapa.cosim.memory_model import MemoryTiming
 
 _logger = logging.getLogger().getChild(__name__)
 
 
 def get_axi_ram_inst(axi_obj: AXI) -> str:
-    # FIXME: test if using addr_width = 64 will cause problem in simulation
     return f"""
   parameter AXI_RAM_{axi_obj.name.upper()}_DATA_WIDTH = {axi_obj.data_width};
-  parameter AXI_RAM_{axi_obj.name.upper()}_ADDR_WIDTH = {MAX_AXI_BRAM_ADDR_WIDTH};
+  parameter AXI_RAM_{axi_obj.name.upper()}_ADDR_WIDTH = {AXI_RAM_ADDR_WIDTH};
   parameter AXI_RAM_{axi_obj.name.upper()}_STRB_WIDTH =
       AXI_RAM_{axi_obj.name.upper()}_DATA_WIDTH/8;
   parameter AXI_RAM_{axi_obj.name.upper()}_ID_WIDTH = 8;
@@ -200,7 +199,12 @@ def get_s_axi_control() -> str:
 """
 
 
-def get_axis(args: Sequence[Arg]) -> str:
+def _get_axis_word_count(arg: Arg) -> int:
+    """Number of 32-bit words exchanged via DPI per token, including eot."""
+    return (arg.port.data_width + 1 + 31) // 32
+
+
+def get_axis(args: Sequence[Arg], stream_batch_size: int = 1) -> str:
     axis_args = [arg for arg in args if arg.is_stream]
 
     # create type alias for widths used for axis
@@ -216,23 +220,113 @@ def get_axis(args: Sequence[Arg]) -> str:
     for width in widths:
         lines.append(
             f"""
-    typedef logic unpacked_uint{width}_t[{width - 1}:0];
     typedef logic [{width - 1}:0] packed_uint{width}_t;
 """
         )
     for arg in axis_args:
+        word_count = _get_axis_word_count(arg)
         lines.append(
             f"""
   packed_uint{arg.port.data_width}_t axis_{arg.name}_tdata;
-  unpacked_uint{arg.port.data_width + 1}_t axis_{arg.name}_tdata_unpacked;
+  packed_uint{arg.port.data_width + 1}_t axis_{arg.name}_tdata_packed;
   logic axis_{arg.name}_tlast;
   logic axis_{arg.name}_tvalid;
   logic axis_{arg.name}_tready;
+
+  // tokens exchanged with the host in batches of up to {stream_batch_size}
+  packed_uint{arg.port.data_width + 1}_t axis_{arg.name}_buffer[$];
+  int unsigned axis_{arg.name}_words[{stream_batch_size * word_count}];
+  bit axis_{arg.name}_last_tready = 1'b0;
 """
         )
+        if arg.port.is_istream:
+            lines.append(_get_istream_task(arg, stream_batch_size))
+        elif arg.port.is_ostream:
+            lines.append(_get_ostream_task(arg, stream_batch_size))
     return "\n".join(lines)
 
 
+def _get_istream_task(arg: Arg, stream_batch_size: int) -> str:
+    """Presents the front token and refills the buffer when it runs empty."""
+    name = arg.name
+    width = arg.port.data_width + 1
+    word_count = _get_axis_word_count(arg)
+    return f"""
+  task automatic axis_{name}_step();
+    bit [{word_count * 32 - 1}:0] token;
+    int count;
+    if (axis_{name}_buffer.size() == 0) begin
+      count = tapa::istream_batch(axis_{name}_words, {width}, "{name}");
+      for (int i = 0; i < count; ++i) begin
+        for (int j = 0; j < {word_count}; ++j) begin
+          token[j * 32 +: 32] = axis_{name}_words[i * {word_count} + j];
+        end
+        axis_{name}_buffer.push_back(token[{width - 1}:0]);
+      end
+    end
+
+    if (axis_{name}_buffer.size() == 0) begin
+      // No data can be provided in this cycle.
+      axis_{name}_tdata_packed = 'x;
+      axis_{name}_tvalid = 1'b0;
+    end else begin
+      // If the downstream is ready to take data, the provided data will be
+      // consumed before the next clock edge.
+      axis_{name}_tdata_packed = axis_{name}_buffer[0];
+      axis_{name}_tvalid = 1'b1;
+      if (axis_{name}_tready) begin
+        void'(axis_{name}_buffer.pop_front());
+      end
+    end
+  endtask
+"""
+
+
+def _get_ostream_task(arg: Arg, stream_batch_size: int) -> str:
+    """Buffers consumed tokens and flushes them when full or idle."""
+    name = arg.name
+    width = arg.port.data_width + 1
+    word_count = _get_axis_word_count(arg)
+    return f"""
+  task automatic axis_{name}_flush();
+    bit [{word_count * 32 - 1}:0] token;
+    int count;
+    for (int i = 0; i < axis_{name}_buffer.size(); ++i) begin
+      token = axis_{name}_buffer[i];
+      for (int j = 0; j < {word_count}; ++j) begin
+        axis_{name}_words[i * {word_count} + j] = token[j * 32 +: 32];
+      end
+    end
+    count = tapa::ostream_batch(
+        axis_{name}_words, axis_{name}_buffer.size(), {width}, "{name}");
+    axis_{name}_buffer = axis_{name}_buffer[count:$];
+  endtask
+
+  task automatic axis_{name}_step();
+    if (axis_{name}_buffer.size() >= {stream_batch_size}) begin
+      axis_{name}_flush();
+    end
+
+    if (axis_{name}_buffer.size() >= {stream_batch_size}) begin
+      // No data can be read in the next cycle because we are full.
+      axis_{name}_tready = 1'b0;
+    end else begin
+      // If in the previous cycle we have indicated that we are not full, we
+      // shall consume data in this cycle if it is available.
+      if (axis_{name}_last_tready && axis_{name}_tvalid) begin
+        axis_{name}_buffer.push_back(axis_{name}_tdata_packed);
+      end
+      if (axis_{name}_buffer.size() >= {stream_batch_size} ||
+          (axis_{name}_buffer.size() > 0 && !axis_{name}_tvalid)) begin
+        axis_{name}_flush();
+      end
+      axis_{name}_tready = axis_{name}_buffer.size() < {stream_batch_size};
+    end
+    axis_{name}_last_tready = axis_{name}_tready;
+  endtask
+"""
+
+
 def get_dut(top_name: str, args: Sequence[Arg]) -> str:
     dut = f"""
   {top_name} dut (
@@ -323,7 +417,18 @@ def get_test_signals(
     arg_to_reg_addrs: dict[str, str],
     scalar_arg_to_val: dict[str, str],
     args: list[Arg],
+    runtime_scalars: bool = False,
+    scalar_file: str | None = None,
 ) -> str:
+    """Generate the stimulus of the testbench.
+
+    If `runtime_scalars` is set, scalar values are read from `+scalar_<name>=`
+    plusargs in hex when the simulation starts instead of being baked into the
+    testbench, so that one compiled snapshot serves any scalar values.
+    Otherwise, if `scalar_file` is set, they are read from that file, which
+    `get_scalar_file` formats, so that runs differing only in scalar values
+    reuse the elaborated testbench.
+    """
     dump_signal_init = "\n".join(
         f"    axi_ram_{arg.name}_dump_mem = 1'b0;" for arg in args if arg.is_mmap
     )
@@ -339,46 +444,41 @@ def get_test_signals(
     axis_{arg.name}_tready = 1'b0;
 """
         )
+        axis_dpi_calls.append(f"    axis_{arg.name}_step();")
         if arg.port.is_istream:
-            axis_dpi_calls.append(
-                f"""
-    tapa::istream(
-        axis_{arg.name}_tdata_unpacked,
-        axis_{arg.name}_tvalid,
-        axis_{arg.name}_tready,
-        "{arg.name}"
-    );
-"""
-            )
             axis_assignments.append(
                 f"""
     assign {{axis_{arg.name}_tlast, axis_{arg.name}_tdata}} =
-        packed_uint{arg.port.data_width + 1}_t'(axis_{arg.name}_tdata_unpacked);
+        axis_{arg.name}_tdata_packed;
 """
             )
         elif arg.port.is_ostream:
-            axis_dpi_calls.append(
-                f"""
-    tapa::ostream(
-        axis_{arg.name}_tdata_unpacked,
-        axis_{arg.name}_tready,
-        axis_{arg.name}_tvalid,
-        "{arg.name}"
-    );
-"""
-            )
             axis_assignments.append(
                 f"""
-    assign axis_{arg.name}_tdata_unpacked =
-        unpacked_uint{arg.port.data_width + 1}_t'
-            ({{axis_{arg.name}_tlast, axis_{arg.name}_tdata}});
+    assign axis_{arg.name}_tdata_packed =
+        {{axis_{arg.name}_tlast, axis_{arg.name}_tdata}};
 """
             )
         else:
             _logger.fatal("unexpected arg.port.mode: %s", arg.port.mode)
 
+    scalar_decls = []
+    scalar_plusargs = []
+    if runtime_scalars:
+        for arg in arg_to_reg_addrs:
+            scalar_decls.append(f"  reg [63:0] scalar_{arg} = 64'h0;")
+            scalar_plusargs.append(
+                f'    void\'($value$plusargs("scalar_{arg}=%h", scalar_{arg}));'
+            )
+    elif scalar_file is not None and arg_to_reg_addrs:
+        scalar_decls.append(
+            f"  reg [63:0] scalar_values [0:{len(arg_to_reg_addrs) - 1}];"
+        )
+        scalar_plusargs.append(f'    $readmemh("{scalar_file}", scalar_values);')
+
     newline = "\n"
     test = f"""
+{newline.join(scalar_decls)}
   parameter HALF_CLOCK_PERIOD = 2;
   parameter CLOCK_PERIOD = HALF_CLOCK_PERIOD * 2;
 
@@ -406,6 +506,7 @@ def get_test_signals(
 {newline.join(axis_signal_init)}
     s_axi_control_arvalid = 1'b0;
     ap_rst_n = 1'b0;
+{newline.join(scalar_plusargs)}
 
     #(CLOCK_PERIOD*1000);
     ap_rst_n = 1'b1;
@@ -413,8 +514,13 @@ def get_test_signals(
 
 """
 
-    for arg, addrs in arg_to_reg_addrs.items():
-        val = scalar_arg_to_val.get(arg, 0)
+    for i, (arg, addrs) in enumerate(arg_to_reg_addrs.items()):
+        if runtime_scalars:
+            val = f"scalar_{arg}"
+        elif scalar_file is not None:
+            val = f"scalar_values[{i}]"
+        else:
+            val = scalar_arg_to_val.get(arg, 0)
         test += (
             f"    s_axi_aw_write = 1; s_axi_aw_din = {addrs[0]}; "
             "s_axi_w_write = 1; "
@@ -434,6 +540,7 @@ def get_test_signals(
     s_axi_aw_din = 'h00;
     s_axi_w_write = 1;
     s_axi_w_din = 1;
+    stats_running = 1'b1;
     #CLOCK_PERIOD;
 
     // stop writing control signal
@@ -458,6 +565,7 @@ def get_test_signals(
       if (s_axi_control_rvalid) begin
         if (s_axi_control_rdata[1]) begin
 {dump_signals}
+          dump_port_stats();
           #(CLOCK_PERIOD*100)
           $finish;
         end
@@ -469,6 +577,174 @@ def get_test_signals(
     return test
 
 
+def get_scalar_file(
+    arg_to_reg_addrs: dict[str, list[str]], scalar_arg_to_val: dict[str, str]
+) -> str:
+    """Return the content of the `scalar_file` read by `get_test_signals`.
+
+    Values are in hex, one per line, in the order of `arg_to_reg_addrs`.
+    """
+    return "".join(
+        scalar_arg_to_val.get(arg, "0").removeprefix("'h") + "\n"
+        for arg in arg_to_reg_addrs
+    )
+
+
+def _get_port_counters(arg: Arg) -> dict[str, str]:
+    """Return the conditions incrementing each counter of `arg` per cycle."""
+    if arg.is_mmap:
+        axi = f"axi_{arg.name}"
+        return {
+            "read_bursts": f"{axi}_arvalid && {axi}_arready",
+            "read_beats": f"{axi}_rvalid && {axi}_rready",
+            "read_request_stall_cycles": f"{axi}_arvalid && !{axi}_arready",
+            "read_data_stall_cycles": f"{axi}_rvalid && !{axi}_rready",
+            "write_bursts": f"{axi}_awvalid && {axi}_awready",
+            "write_beats": f"{axi}_wvalid && {axi}_wready",
+            "write_request_stall_cycles": f"{axi}_awvalid && !{axi}_awready",
+            "write_data_stall_cycles": f"{axi}_wvalid && !{axi}_wready",
+        }
+    axis = f"axis_{arg.name}"
+    if arg.port.is_istream:
+        # the testbench presents no token only if the host has none
+        return {
+            "read_beats": f"{axis}_tvalid && {axis}_tready",
+            "read_data_stall_cycles": f"{axis}_tvalid && !{axis}_tready",
+            "host_empty_cycles": f"!{axis}_tvalid",
+        }
+    # the testbench is not ready only if the host cannot take its tokens
+    return {
+        "write_beats": f"{axis}_tvalid && {axis}_tready",
+        "write_data_stall_cycles": f"{axis}_tvalid && !{axis}_tready",
+        "host_full_cycles": f"!{axis}_tready",
+    }
+
+
+# cycles between samples of the port trace
+PORT_TRACE_INTERVAL = 1024
+
+
+def get_port_stats(
+    args: Sequence[Arg], port_stats_path: str, port_trace_path: str
+) -> str:
+    """Generate counters of the traffic on each mmap and stream port.
+
+    Counting starts when the kernel is started. Task `dump_port_stats` writes
+    the counters as JSON to `port_stats_path`, or to the path given by the
+    `+port_stats=` plusarg if set, and stops counting.
+
+    While counting, the beat counters are also sampled every
+    `PORT_TRACE_INTERVAL` cycles as CSV lines of `time_ns,port,read_beats,
+    write_beats` to `port_trace_path`, or to the path given by the
+    `+port_trace=` plusarg if set, so that the runtime can show the traffic of
+    each port over time.
+    """
+    decls = [
+        "  bit stats_running = 1'b0;",
+        "  longint unsigned stats_cycles = 0;",
+    ]
+    updates = ["      stats_cycles = stats_cycles + 1;"]
+    port_lines = []
+    for arg in args:
+        if not (arg.is_mmap or arg.is_stream):
+            continue
+        counters = _get_port_counters(arg)
+        fields = list(counters)
+        for counter, condition in counters.items():
+            decls.append(f"  longint unsigned stats_{arg.name}_{counter} = 0;")
+            updates.append(
+                f"      if ({condition}) stats_{arg.name}_{counter} = "
+                f"stats_{arg.name}_{counter} + 1;"
+            )
+        if arg.is_mmap:
+            # outstanding requests are bursts whose response is not back yet
+            axi = f"axi_{arg.name}"
+            for kind, request, response in (
+                ("reads", "ar", f"{axi}_rvalid && {axi}_rready && {axi}_rlast"),
+                ("writes", "aw", f"{axi}_bvalid && {axi}_bready"),
+            ):
+                var = f"stats_{arg.name}_outstanding_{kind}"
+                max_var = f"stats_{arg.name}_max_outstanding_{kind}"
+                decls.append(f"  longint {var} = 0;")
+                decls.append(f"  longint {max_var} = 0;")
+                updates.append(
+                    f"      {var} = {var} + "
+                    f"({axi}_{request}valid && {axi}_{request}ready) - ({response});"
+                )
+                updates.append(f"      if ({var} > {max_var}) {max_var} = {var};")
+                fields.append(f"max_outstanding_{kind}")
+        port_lines.append((arg.name, fields))
+
+    samples = []
+    for name, fields in port_lines:
+        beats = [
+            f"stats_{name}_{kind}_beats" if f"{kind}_beats" in fields else "0"
+            for kind in ("read", "write")
+        ]
+        samples.append(
+            f'        $fdisplay(trace_fd, "%0d,{name},%0d,%0d", $time, '
+            f"{', '.join(beats)});"
+        )
+
+    dumps = []
+    for i, (name, fields) in enumerate(port_lines):
+        comma = "," if i + 1 < len(port_lines) else ""
+        fmt = ", ".join(f'\\"{field}\\": %0d' for field in fields)
+        values = ", ".join(f"stats_{name}_{field}" for field in fields)
+        dumps.append(
+            f'    $fdisplay(fd, "    \\"{name}\\": {{{fmt}}}{comma}",\n'
+            f"              {values});"
+        )
+
+    newline = "\n"
+    return f"""
+{newline.join(decls)}
+
+  always @ (posedge ap_clk) begin
+    if (stats_running) begin
+{newline.join(updates)}
+    end
+  end
+
+  integer trace_fd = 0;
+  always @ (posedge ap_clk) begin
+    if (stats_running && stats_cycles % {PORT_TRACE_INTERVAL} == 1) begin
+      if (trace_fd == 0) begin
+        string trace_path = "{port_trace_path}";
+        void'($value$plusargs("port_trace=%s", trace_path));
+        trace_fd = $fopen(trace_path, "w");
+      end
+      if (trace_fd != 0) begin
+{newline.join(samples)}
+      end
+    end
+  end
+
+  task automatic dump_port_stats();
+    integer fd;
+    string path = "{port_stats_path}";
+    stats_running = 1'b0;
+    if (trace_fd != 0) begin
+      $fclose(trace_fd);
+      trace_fd = 0;
+    end
+    void'($value$plusargs("port_stats=%s", path));
+    fd = $fopen(path, "w");
+    if (fd == 0) begin
+      $display("failed to open %s; port statistics are not saved", path);
+      return;
+    end
+    $fdisplay(fd, "{{");
+    $fdisplay(fd, "  \\"cycles\\": %0d,", stats_cycles);
+    $fdisplay(fd, "  \\"ports\\": {{");
+{newline.join(dumps)}
+    $fdisplay(fd, "  }}");
+    $fdisplay(fd, "}}");
+    $fclose(fd);
+  endtask
+"""
+
+
 def get_begin() -> str:
     return """
 `timescale 1 ns / 1 ps
@@ -486,6 +762,20 @@ package tapa;
     input  logic  write,
     input  string id
   );
+  // Batched variants moving up to `$size(words) / ceil(width / 32)` tokens of
+  // `width` bits per call. Each token occupies whole 32-bit words, LSB first.
+  // Both return the number of tokens moved.
+  import "DPI-C" function int istream_batch(
+    output int unsigned words[],
+    input  int          width,
+    input  string       id
+  );
+  import "DPI-C" function int ostream_batch(
+    input  int unsigned words[],
+    input  int          count,
+    input  int          width,
+    input  string       id
+  );
 endpackage
 
 module test();
@@ -503,17 +793,255 @@ endmodule
 """
 
 
-def get_axi_ram_module(axi: AXI, input_data_path: str, c_array_size: int) -> str:
-    """Generate the AXI RAM module for cosimulation."""
-    if axi.data_width / 8 * c_array_size > 2**MAX_AXI_BRAM_ADDR_WIDTH:
-        _logger.error(
-            "The current cosim data size is larger than the template "
-            "threshold (32-bit address). Please reduce cosim data size."
-        )
-        sys.exit(1)
+def _get_axi_ram_file_decl(
+    input_data_path: str, output_data_path: str, size: int
+) -> str:
+    """Map the AXI RAM from data files via DPI.
+
+    The content of `input_data_path` is copied to `output_data_path` when the
+    simulation starts, which is then mapped and accessed in place. The RAM has
+    `size` bytes if `input_data_path` is empty, or else the size of the file.
+    """
+    return f"""
+import "DPI-C" function void axi_ram_map_file(
+  input string           path,
+  input string           data_path,
+  input longint unsigned size
+);
+import "DPI-C" function void axi_ram_flush(input string path);
+
+initial begin
+  axi_ram_map_file("{output_data_path}", "{input_data_path}", 64'd{size});
+end
+
+always @(posedge dump_mem) begin
+  axi_ram_flush("{output_data_path}");
+end
+"""
+
+
+def _get_axi_ram_shm_decl(plusarg_name: str | None) -> str:
+    """Declare the DPI functions accessing the AXI RAM in shared memory.
 
-    if input_data_path:
-        assert os.path.exists(input_data_path)
+    If `plusarg_name` is set, also declare `shm_path` read from the
+    `+axi_ram_<plusarg_name>=` plusarg.
+    """
+    decl = ""
+    if plusarg_name is not None:
+        decl = f"""
+string shm_path;
+initial begin
+  if (!$value$plusargs("axi_ram_{plusarg_name}=%s", shm_path)) begin
+    $fatal(1, "missing +axi_ram_{plusarg_name}=<shared memory object>");
+  end
+end
+"""
+    return decl + """
+import "DPI-C" function void axi_ram_read(
+  input  string           path,
+  input  longint unsigned offset,
+  output byte unsigned    data[]
+);
+import "DPI-C" function void axi_ram_write(
+  input  string           path,
+  input  longint unsigned offset,
+  input  byte unsigned    data[],
+  input  bit              strb[]
+);
+
+byte unsigned mem_rd_data[WORD_WIDTH];
+byte unsigned mem_wr_data[WORD_WIDTH];
+bit mem_wr_strb[WORD_WIDTH];
+integer j;
+"""
+
+
+# Ports of the AXI RAM, as (direction, width, name without `s_axi_`).
+_AXI_RAM_PORTS = (
+    ("input", "ID_WIDTH", "awid"),
+    ("input", "ADDR_WIDTH", "awaddr"),
+    ("input", "8", "awlen"),
+    ("input", "3", "awsize"),
+    ("input", "2", "awburst"),
+    ("input", "1", "awlock"),
+    ("input", "4", "awcache"),
+    ("input", "3", "awprot"),
+    ("input", "1", "awvalid"),
+    ("output", "1", "awready"),
+    ("input", "DATA_WIDTH", "wdata"),
+    ("input", "STRB_WIDTH", "wstrb"),
+    ("input", "1", "wlast"),
+    ("input", "1", "wvalid"),
+    ("output", "1", "wready"),
+    ("output", "ID_WIDTH", "bid"),
+    ("output", "2", "bresp"),
+    ("output", "1", "bvalid"),
+    ("input", "1", "bready"),
+    ("input", "ID_WIDTH", "arid"),
+    ("input", "ADDR_WIDTH", "araddr"),
+    ("input", "8", "arlen"),
+    ("input", "3", "arsize"),
+    ("input", "2", "arburst"),
+    ("input", "1", "arlock"),
+    ("input", "4", "arcache"),
+    ("input", "3", "arprot"),
+    ("input", "1", "arvalid"),
+    ("output", "1", "arready"),
+    ("output", "ID_WIDTH", "rid"),
+    ("output", "DATA_WIDTH", "rdata"),
+    ("output", "2", "rresp"),
+    ("output", "1", "rlast"),
+    ("output", "1", "rvalid"),
+    ("input", "1", "rready"),
+)
+
+# Ports of the AXI RAM driven through `axi_timing_model`.
+_AXI_TIMING_PORTS = frozenset((
+    *("arid", "araddr", "arlen", "arsize", "arburst", "arvalid", "arready"),
+    *("rvalid", "rready", "awvalid", "awready", "wvalid", "wready"),
+    *("bid", "bresp", "bvalid", "bready"),
+))
+
+
+def _get_axi_ram_timing_wrapper(axi: AXI, timing: MemoryTiming) -> str:
+    """Define the AXI RAM of `axi` as its `_core` behind `axi_timing_model`."""
+    newline = "\n"
+    ports = [
+        f"    {direction} wire [{width}-1:0] s_axi_{name},"
+        for direction, width, name in _AXI_RAM_PORTS
+    ]
+    wires = [
+        f"wire [{width}-1:0] ram_{name};"
+        for _, width, name in _AXI_RAM_PORTS
+        if name in _AXI_TIMING_PORTS
+    ]
+    core_ports = [
+        f"    .s_axi_{name}({'ram' if name in _AXI_TIMING_PORTS else 's_axi'}"
+        f"_{name}),"
+        for _, _, name in _AXI_RAM_PORTS
+    ]
+    timing_params = ",\n".join(
+        f"    .{field.upper()}({value})" for field, value in timing._asdict().items()
+    )
+    timing_ports = sorted(
+        f"    .{side}_axi_{name}({'ram' if side == 'm' else 's_axi'}_{name}),"
+        for name in _AXI_TIMING_PORTS
+        for side in ("s", "m")
+    )
+    return f"""
+module axi_ram_{axi.name} #
+(
+    parameter DATA_WIDTH = {axi.data_width},
+    parameter ADDR_WIDTH = {AXI_RAM_ADDR_WIDTH},
+    parameter STRB_WIDTH = (DATA_WIDTH/8),
+    parameter ID_WIDTH = 8,
+    parameter PIPELINE_OUTPUT = 0
+)
+(
+    input  wire dump_mem,
+    input  wire clk,
+    input  wire rst,
+{newline.join(ports)[:-1]}
+);
+
+{newline.join(wires)}
+
+axi_timing_model #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .ADDR_WIDTH(ADDR_WIDTH),
+    .ID_WIDTH(ID_WIDTH),
+{timing_params}
+) timing (
+    .clk(clk),
+    .rst(rst),
+    .s_axi_awaddr(s_axi_awaddr),
+    .s_axi_wlast(s_axi_wlast),
+    .m_axi_rlast(s_axi_rlast),
+{newline.join(timing_ports)[:-1]}
+);
+
+axi_ram_{axi.name}_core #(
+    .DATA_WIDTH(DATA_WIDTH),
+    .ADDR_WIDTH(ADDR_WIDTH),
+    .STRB_WIDTH(STRB_WIDTH),
+    .ID_WIDTH(ID_WIDTH),
+    .PIPELINE_OUTPUT(PIPELINE_OUTPUT)
+) core (
+    .dump_mem(dump_mem),
+    .clk(clk),
+    .rst(rst),
+{newline.join(core_ports)[:-1]}
+);
+
+endmodule
+"""
+
+
+def get_axi_ram_module(
+    axi: AXI,
+    input_data_path: str,
+    c_array_size: int,
+    shm_path: str | None = None,
+    runtime_shm_path: bool = False,
+    timing: MemoryTiming | None = None,
+) -> str:
+    """Generate the AXI RAM module for cosimulation.
+
+    Every beat accesses the memory content via DPI, which maps it from the host
+    so that only the pages accessed are brought into memory, and the RAM takes
+    no time to elaborate regardless of its size.
+
+    If `shm_path` is set, the memory content lives in the POSIX shared memory
+    object created by the host, so no data file is read or written. Otherwise,
+    the memory is copied from `input_data_path` to the corresponding
+    `_out.bin` file, which is mapped and updated in place.
+
+    If `runtime_shm_path` is set, the shared memory object is named by the
+    `+axi_ram_<name>=` plusarg when the simulation starts instead.
+
+    If `timing` is set and not ideal, the RAM is wrapped by `axi_timing_model`,
+    which `get_axi_timing_model` defines.
+    """
+    module_name = f"axi_ram_{axi.name}"
+    wrapper = ""
+    if timing is not None and timing != MemoryTiming():
+        wrapper = _get_axi_ram_timing_wrapper(axi, timing)
+        module_name += "_core"
+
+    if runtime_shm_path:
+        ram_path = "shm_path"
+    elif shm_path is not None:
+        ram_path = f'"{shm_path}"'
+    else:
+        output_data_path = input_data_path.replace(".bin", "_out.bin")
+        ram_path = f'"{output_data_path}"'
+
+    mem_decl = _get_axi_ram_shm_decl(axi.name if runtime_shm_path else None)
+    if shm_path is None and not runtime_shm_path:
+        if input_data_path:
+            assert os.path.exists(input_data_path)
+        mem_decl += _get_axi_ram_file_decl(
+            input_data_path, output_data_path, axi.data_width // 8 * c_array_size
+        )
+    mem_write = f"""
+    if (mem_wr_en) begin
+        for (i = 0; i < WORD_WIDTH; i = i + 1) begin
+            mem_wr_data[i] = s_axi_wdata[WORD_SIZE*i +: WORD_SIZE];
+            mem_wr_strb[i] = s_axi_wstrb[i];
+        end
+        axi_ram_write({ram_path}, longint'(write_addr_valid) * WORD_WIDTH,
+                      mem_wr_data, mem_wr_strb);
+    end
+"""
+    mem_read = f"""
+    if (mem_rd_en) begin
+        axi_ram_read({ram_path}, longint'(read_addr_valid) * WORD_WIDTH,
+                     mem_rd_data);
+        for (j = 0; j < WORD_WIDTH; j = j + 1) begin
+            s_axi_rdata_reg[WORD_SIZE*j +: WORD_SIZE] <= mem_rd_data[j];
+        end
+    end
+"""
 
     return f"""
 /*
@@ -549,12 +1077,12 @@ THE SOFTWARE.
 /*
  * AXI4 RAM
  */
-module axi_ram_{axi.name} #
+module {module_name} #
 (
     // Width of data bus in bits
     parameter DATA_WIDTH = {axi.data_width},
     // Width of address bus in bits
-    parameter ADDR_WIDTH = {MAX_AXI_BRAM_ADDR_WIDTH},
+    parameter ADDR_WIDTH = {AXI_RAM_ADDR_WIDTH},
     // Width of wstrb (width of data bus in words)
     parameter STRB_WIDTH = (DATA_WIDTH/8),
     // Width of ID signal
@@ -610,34 +1138,7 @@ parameter WORD_SIZE = DATA_WIDTH/WORD_WIDTH;
 
 //////////////////////////////////////////////////////////////////////
 
-reg [DATA_WIDTH-1:0] mem[(2**VALID_ADDR_WIDTH)-1:0];
-integer fp;
-integer read_size;
-reg [7:0] temp;
-
-integer i_rd, j_rd;
-initial begin
-  fp = $fopen("{input_data_path}", "rb");
-  for (i_rd = 0; i_rd < {c_array_size} ; i_rd = i_rd + 1) begin
-    for (j_rd = 0; j_rd < DATA_WIDTH / 8; j_rd = j_rd + 1) begin
-      $fread(temp, fp);
-      mem[i_rd][j_rd*8 +: 8] = temp;
-    end
-  end
-end
-
-integer i_wr, j_wr;
-always @* begin
-  if (dump_mem) begin
-    fp = $fopen("{input_data_path.replace(".bin", "_out.bin")}", "wb");
-    for (i_wr = 0; i_wr < {c_array_size}; i_wr = i_wr + 1) begin
-      for (j_wr = 0; j_wr < DATA_WIDTH / 8; j_wr = j_wr + 1) begin
-        $fwrite(fp, "%c", mem[i_wr][j_wr * 8 +: 8] );
-      end
-    end
-  end
-end
-
+{mem_decl}
 //////////////////////////////////////////////////////////////////////
 
 // bus width assertions
@@ -808,13 +1309,7 @@ always @(posedge clk) begin
     s_axi_bid_reg <= s_axi_bid_next;
     s_axi_bvalid_reg <= s_axi_bvalid_next;
 
-    for (i = 0; i < WORD_WIDTH; i = i + 1) begin
-        if (mem_wr_en & s_axi_wstrb[i]) begin
-            mem[write_addr_valid][WORD_SIZE*i +: WORD_SIZE] <=
-                s_axi_wdata[WORD_SIZE*i +: WORD_SIZE];
-        end
-    end
-
+{mem_write}
     if (rst) begin
         write_state_reg <= WRITE_STATE_IDLE;
 
@@ -901,10 +1396,7 @@ always @(posedge clk) begin
     s_axi_rlast_reg <= s_axi_rlast_next;
     s_axi_rvalid_reg <= s_axi_rvalid_next;
 
-    if (mem_rd_en) begin
-        s_axi_rdata_reg <= mem[read_addr_valid];
-    end
-
+{mem_read}
     if (!s_axi_rvalid_pipe_reg || s_axi_rready) begin
         s_axi_rid_pipe_reg <= s_axi_rid_reg;
         s_axi_rdata_pipe_reg <= s_axi_rdata_reg;
@@ -922,7 +1414,221 @@ always @(posedge clk) begin
 end
 
 endmodule
+{wrapper}
+"""
+
+
+def get_axi_timing_model() -> str:
+    """Define `axi_timing_model`, which delays and throttles an AXI RAM."""
+    return """`default_nettype none
+
+// Timing model of the memory behind an AXI RAM of the testbench, which is
+// between the kernel (`s_axi_*`) and the RAM (`m_axi_*`) that responds in a
+// couple of cycles. The model
+//
+//  - passes each read burst to the RAM `READ_LATENCY` cycles after accepting it,
+//  - returns each write response `WRITE_LATENCY` cycles after the last beat,
+//  - adds `ROW_MISS_PENALTY` cycles to bursts starting out of the open row of
+//    their bank, with `BANKS` banks interleaved every `ROW_BYTES` bytes,
+//  - passes read and write beats at `BYTES_PER_CYCLE` bytes per cycle in total,
+//  - accepts up to `MAX_OUTSTANDING_READS` read bursts and
+//    `MAX_OUTSTANDING_WRITES` write bursts whose response is not returned yet.
+//
+// Zero disables the limits and the penalty. Bursts are served in order.
+module axi_timing_model #(
+  parameter DATA_WIDTH             = 512,
+  parameter ADDR_WIDTH             = 64,
+  parameter ID_WIDTH               = 8,
+  parameter READ_LATENCY           = 0,
+  parameter WRITE_LATENCY          = 0,
+  parameter BYTES_PER_CYCLE        = 0,
+  parameter MAX_OUTSTANDING_READS  = 0,
+  parameter MAX_OUTSTANDING_WRITES = 0,
+  parameter ROW_BYTES              = 0,
+  parameter BANKS                  = 1,
+  parameter ROW_MISS_PENALTY       = 0
+) (
+  input wire clk,
+  input wire rst,
+
+  input  wire [ID_WIDTH-1:0]   s_axi_arid,
+  input  wire [ADDR_WIDTH-1:0] s_axi_araddr,
+  input  wire [7:0]            s_axi_arlen,
+  input  wire [2:0]            s_axi_arsize,
+  input  wire [1:0]            s_axi_arburst,
+  input  wire                  s_axi_arvalid,
+  output wire                  s_axi_arready,
+  output reg  [ID_WIDTH-1:0]   m_axi_arid,
+  output reg  [ADDR_WIDTH-1:0] m_axi_araddr,
+  output reg  [7:0]            m_axi_arlen,
+  output reg  [2:0]            m_axi_arsize,
+  output reg  [1:0]            m_axi_arburst,
+  output reg                   m_axi_arvalid,
+  input  wire                  m_axi_arready,
+
+  output wire s_axi_rvalid,
+  input  wire s_axi_rready,
+  input  wire m_axi_rvalid,
+  output wire m_axi_rready,
+  input  wire m_axi_rlast,
+
+  input  wire [ADDR_WIDTH-1:0] s_axi_awaddr,
+  input  wire                  s_axi_awvalid,
+  output wire                  s_axi_awready,
+  output wire                  m_axi_awvalid,
+  input  wire                  m_axi_awready,
+
+  input  wire s_axi_wvalid,
+  output wire s_axi_wready,
+  input  wire s_axi_wlast,
+  output wire m_axi_wvalid,
+  input  wire m_axi_wready,
+
+  output reg  [ID_WIDTH-1:0] s_axi_bid,
+  output reg  [1:0]          s_axi_bresp,
+  output reg                 s_axi_bvalid,
+  input  wire                s_axi_bready,
+  input  wire [ID_WIDTH-1:0] m_axi_bid,
+  input  wire [1:0]          m_axi_bresp,
+  input  wire                m_axi_bvalid,
+  output wire                m_axi_bready
+);
+
+  localparam longint unsigned BEAT_BYTES = DATA_WIDTH / 8;
+  localparam longint unsigned CREDIT_CAP = 2 * BEAT_BYTES;
+
+  typedef struct {
+    logic [ID_WIDTH-1:0]   id;
+    logic [ADDR_WIDTH-1:0] addr;
+    logic [7:0]            len;
+    logic [2:0]            size;
+    logic [1:0]            burst;
+    longint unsigned       release_cycle;
+  } read_t;
+
+  typedef struct {
+    logic [ID_WIDTH-1:0] id;
+    logic [1:0]          resp;
+    longint unsigned     release_cycle;
+  } response_t;
+
+  longint unsigned cycle;
+  longint unsigned credit;  // bytes that may be transferred
+  longint unsigned reads_outstanding;
+  longint unsigned writes_outstanding;
+
+  read_t           read_q[$];       // read bursts not passed to the RAM
+  response_t       response_q[$];   // write responses not returned
+  longint unsigned penalty_q[$];    // of write bursts without the last beat
+  longint unsigned release_q[$];    // of write bursts without RAM response
+  longint unsigned open_row[BANKS];
+
+  read_t           read;
+  response_t       response;
+  longint unsigned next_credit;
+
+  // Returns the row miss penalty of a burst at `addr`, and opens its row.
+  function automatic longint unsigned access_row(
+      input logic [ADDR_WIDTH-1:0] addr);
+    longint unsigned row = addr / (ROW_BYTES == 0 ? 1 : ROW_BYTES);
+    longint unsigned bank = row % BANKS;
+    if (ROW_BYTES == 0 || open_row[bank] == row / BANKS) return 0;
+    open_row[bank] = row / BANKS;
+    return ROW_MISS_PENALTY;
+  endfunction
+
+  wire read_credit = BYTES_PER_CYCLE == 0 || credit >= BEAT_BYTES;
+  // Reads take precedence over writes when the RAM has data to return.
+  wire write_credit = BYTES_PER_CYCLE == 0 ||
+      credit >= BEAT_BYTES * (m_axi_rvalid ? 2 : 1);
+  wire write_allowed = MAX_OUTSTANDING_WRITES == 0 ||
+      writes_outstanding < MAX_OUTSTANDING_WRITES;
+
+  assign s_axi_arready = MAX_OUTSTANDING_READS == 0 ||
+      reads_outstanding < MAX_OUTSTANDING_READS;
+  assign s_axi_rvalid  = m_axi_rvalid && read_credit;
+  assign m_axi_rready  = s_axi_rready && read_credit;
+  assign m_axi_awvalid = s_axi_awvalid && write_allowed;
+  assign s_axi_awready = m_axi_awready && write_allowed;
+  assign m_axi_wvalid  = s_axi_wvalid && write_credit;
+  assign s_axi_wready  = m_axi_wready && write_credit;
+  assign m_axi_bready  = 1'b1;
+
+  wire ar_fire = s_axi_arvalid && s_axi_arready;
+  wire r_fire  = s_axi_rvalid && s_axi_rready;
+  wire aw_fire = s_axi_awvalid && s_axi_awready;
+  wire w_fire  = s_axi_wvalid && s_axi_wready;
+  wire b_fire  = s_axi_bvalid && s_axi_bready;
+
+  always @(posedge clk) begin
+    if (rst) begin
+      read_q.delete();
+      response_q.delete();
+      penalty_q.delete();
+      release_q.delete();
+      foreach (open_row[i]) open_row[i] = '1;
+      cycle              <= 0;
+      credit             <= CREDIT_CAP;
+      reads_outstanding  <= 0;
+      writes_outstanding <= 0;
+      m_axi_arvalid      <= 1'b0;
+      s_axi_bvalid       <= 1'b0;
+    end else begin
+      // read bursts
+      if (m_axi_arvalid && m_axi_arready) void'(read_q.pop_front());
+      if (ar_fire) begin
+        read.id    = s_axi_arid;
+        read.addr  = s_axi_araddr;
+        read.len   = s_axi_arlen;
+        read.size  = s_axi_arsize;
+        read.burst = s_axi_arburst;
+        read.release_cycle = cycle + READ_LATENCY + access_row(s_axi_araddr);
+        read_q.push_back(read);
+      end
+      m_axi_arvalid <= read_q.size() != 0 &&
+                       read_q[0].release_cycle <= cycle + 1;
+      if (read_q.size() != 0) begin
+        m_axi_arid    <= read_q[0].id;
+        m_axi_araddr  <= read_q[0].addr;
+        m_axi_arlen   <= read_q[0].len;
+        m_axi_arsize  <= read_q[0].size;
+        m_axi_arburst <= read_q[0].burst;
+      end
+      reads_outstanding <= reads_outstanding + ar_fire - (r_fire && m_axi_rlast);
+
+      // write bursts
+      if (aw_fire) penalty_q.push_back(access_row(s_axi_awaddr));
+      if (w_fire && s_axi_wlast) begin
+        release_q.push_back(cycle + WRITE_LATENCY +
+                            (penalty_q.size() != 0 ? penalty_q.pop_front() : 0));
+      end
+      if (b_fire) void'(response_q.pop_front());
+      if (m_axi_bvalid) begin
+        response.id   = m_axi_bid;
+        response.resp = m_axi_bresp;
+        response.release_cycle =
+            release_q.size() != 0 ? release_q.pop_front() : cycle;
+        response_q.push_back(response);
+      end
+      s_axi_bvalid <= response_q.size() != 0 &&
+                      response_q[0].release_cycle <= cycle + 1;
+      if (response_q.size() != 0) begin
+        s_axi_bid   <= response_q[0].id;
+        s_axi_bresp <= response_q[0].resp;
+      end
+      writes_outstanding <= writes_outstanding + aw_fire - b_fire;
+
+      // bandwidth
+      next_credit = credit + BYTES_PER_CYCLE - BEAT_BYTES * (r_fire + w_fire);
+      credit <= BYTES_PER_CYCLE == 0 || next_credit > CREDIT_CAP ?
+                CREDIT_CAP : next_credit;
+      cycle  <= cycle + 1;
+    end
+  end
+
+endmodule  // axi_timing_model
 
+`default_nettype wire
 """
 
 
@@ -961,8 +1667,6 @@ module fifo_srl #(
   reg                     internal_empty_n;
   reg                     internal_full_n;
 
-  reg [DATA_WIDTH-1:0] mem [0:DEPTH-1];
-
   assign if_empty_n = internal_empty_n;
   assign if_full_n = internal_full_n;
   assign shift_reg_data = if_din;
@@ -972,7 +1676,6 @@ module fifo_srl #(
                                                       : {ADDR_WIDTH{1'b0}};
   assign shift_reg_ce = (if_write & if_write_ce) & internal_full_n;
 
-  assign shift_reg_q = mem[shift_reg_addr];
 
   always @(posedge clk) begin
     if (reset) begin
@@ -998,6 +1701,28 @@ module fifo_srl #(
     end
   end
 
+`ifdef TAPA_SIM_FIFO
+  // mem[k] of the shift register is ring[ring_ptr - 1 - k]
+  localparam RING_ADDR_WIDTH = DEPTH < 2 ? 1 : $clog2(DEPTH);
+
+  reg [DATA_WIDTH-1:0] ring [0:(1 << RING_ADDR_WIDTH)-1];
+  reg [RING_ADDR_WIDTH-1:0] ring_ptr = {RING_ADDR_WIDTH{1'b0}};
+  wire [RING_ADDR_WIDTH-1:0] ring_addr =
+    ring_ptr - 1'b1 - shift_reg_addr[RING_ADDR_WIDTH-1:0];
+
+  assign shift_reg_q = ring[ring_addr];
+
+  always @(posedge clk) begin
+    if (shift_reg_ce) begin
+      ring[ring_ptr] <= shift_reg_data;
+      ring_ptr <= ring_ptr + 1'b1;
+    end
+  end
+`else
+  reg [DATA_WIDTH-1:0] mem [0:DEPTH-1];
+
+  assign shift_reg_q = mem[shift_reg_addr];
+
   integer i;
   always @(posedge clk) begin
     if (shift_reg_ce) begin
@@ -1006,6 +1731,7 @@ module fifo_srl #(
       mem[0] <= shift_reg_data;
     end
   end
+`endif
 
 endmodule  // fifo_srl
 
@@ -0,0 +1,141 @@
+"""Build and run the cosimulation testbench with Verilator."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import logging
+import shutil
+import subprocess
+from pathlib import Path
+
+from tapa.common import paths
+from tapa.cosim.incremental import (
+    hash_files,
+    invalidate,
+    is_up_to_date,
+    mark_up_to_date,
+)
+from tapa.cosim.vivado import SIM_DEFINE
+
+_logger = logging.getLogger().getChild(__name__)
+
+# Verilator implements the standard `svdpi.h` ABI, so the DPI library built
+# for xsim 2024.2+ is loaded as is; the legacy RDI variant is not compatible.
+_DPI_LIBRARY = "tapa_fast_cosim_dpi_xv"
+_BINARY_NAME = "Vtest"
+
+
+def _get_rtl_files(verilog_path: str, tb_rtl_path: str) -> list[str]:
+    """Return the HLS RTL files followed by the testbench files."""
+    files = []
+    for pattern in ("*.v", "*.sv", "*/*.v", "*/*.sv"):
+        files += sorted(str(x) for x in Path(verilog_path).glob(pattern))
+    for pattern in ("*.v", "*.sv"):
+        files += sorted(str(x) for x in Path(tb_rtl_path).glob(pattern))
+    return files
+
+
+def get_verilator_command(
+    config: dict,
+    tb_rtl_path: str,
+    build_dir: str,
+    threads: int,
+) -> list[str]:
+    """Return the Verilator command building the cosim binary in `build_dir`.
+
+    The testbench is the one generated for xsim; Verilator's `--timing`
+    support runs its delays and event controls as is.
+    """
+    verilog_path = config["verilog_path"]
+    ip_files = [*Path(verilog_path).glob("*.xci"), *Path(verilog_path).glob("*/*.xci")]
+    if ip_files:
+        _logger.warning(
+            "Xilinx IPs are not simulated by Verilator; "
+            "use xsim if the design instantiates IP cores"
+        )
+
+    dpi_library_dir = paths.find_resource("tapa-fast-cosim-dpi-lib")
+    if dpi_library_dir is None:
+        msg = "DPI directory not found"
+        raise FileNotFoundError(msg)
+    _logger.info("DPI directory: %s", dpi_library_dir)
+
+    command = [
+        "verilator",
+        "--binary",
+        "--timing",
+        "--top-module",
+        "test",
+        "--Mdir",
+        build_dir,
+        "-o",
+        _BINARY_NAME,
+        "-j",
+        "0",
+        # HLS RTL and the testbench are not lint-clean by Verilator standards
+        "-Wno-fatal",
+        "-Wno-lint",
+        "-Wno-style",
+        f"+define+{SIM_DEFINE}",
+        # the DPI library calls back into `svdpi.h` functions in the binary
+        "-LDFLAGS",
+        f"-Wl,--export-dynamic -L{dpi_library_dir} "
+        f"-Wl,-rpath,{dpi_library_dir} -l{_DPI_LIBRARY}",
+    ]
+    if threads > 1:
+        command += ["--threads", str(threads)]
+    command += _get_rtl_files(verilog_path, tb_rtl_path)
+    return command
+
+
+def build_and_run(
+    config: dict,
+    tb_rtl_path: str,
+    run_dir: str,
+    threads: int,
+    env: dict[str, str],
+    setup_only: bool = False,
+    incremental: bool = False,
+) -> None:
+    """Build the Verilator binary under `run_dir` and run it there.
+
+    If `incremental` is set, the binary is rebuilt only if the RTL files or the
+    build command changed, e.g., not if only scalar values did.
+    """
+    run_path = Path(run_dir)
+    build_dir = run_path / "verilator"
+    build_dir.mkdir(parents=True, exist_ok=True)
+
+    command = get_verilator_command(config, tb_rtl_path, str(build_dir), threads)
+    with open(run_path / "build_verilator.sh", "w", encoding="utf-8") as fp:
+        fp.write(" ".join(f"'{x}'" for x in command) + "\n")
+    if setup_only:
+        _logger.info("User requested to only setup the cosim environment, exiting...")
+        return
+
+    build_stamp = build_dir / "build.stamp"
+    rtl_files = _get_rtl_files(config["verilog_path"], tb_rtl_path)
+    build_key = hash_files(rtl_files, *command)
+    if (
+        incremental
+        and (build_dir / _BINARY_NAME).is_file()
+        and is_up_to_date(build_stamp, build_key)
+    ):
+        _logger.info("Reusing Verilator binary: %s", build_dir / _BINARY_NAME)
+    else:
+        invalidate(build_stamp)
+        _logger.info("Running verilator command: %s", command)
+        subprocess.run(command, cwd=run_path, check=True)
+        mark_up_to_date(build_stamp, build_key)
+
+    # `$readmemh` in HLS RTL opens memory initialization files relative to cwd
+    verilog_path = Path(config["verilog_path"])
+    for dat in (*verilog_path.glob("*.dat"), *verilog_path.glob("*/*.dat")):
+        shutil.copy(dat, run_path)
+
+    binary = (build_dir / _BINARY_NAME).resolve()
+    _logger.info("Running simulation: %s", binary)
+    subprocess.run([str(binary)], cwd=run_path, check=True, env=env)
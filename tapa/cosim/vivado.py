@@ -14,6 +14,13 @@ from tapa.common import paths
 
 _logger = logging.getLogger().getChild(__name__)
 
+# Where Vivado elaborates the snapshot, relative to the `run` directory.
+XSIM_DIR = "vivado/tapa-fast-cosim.sim/sim_1/behav/xsim"
+SNAPSHOT_NAME = "test_behav"
+# Macro selecting the simulation models of the RTL, e.g., of `fifo_srl`, that
+# behave the same cycle for cycle but simulate faster.
+SIM_DEFINE = "TAPA_SIM_FIFO"
+
 
 def get_vivado_version() -> str:
     """Return the Vivado version."""
@@ -44,8 +51,13 @@ def get_vivado_tcl(
     tb_rtl_path: str,
     save_waveform: bool,
     start_gui: bool,
+    elaborate_only: bool = False,
 ) -> list[str]:
-    """Generate a Vivado TCL script for cosimulation."""
+    """Generate a Vivado TCL script for cosimulation.
+
+    If `elaborate_only` is set, the script stops after elaborating the xsim
+    snapshot so that it can be simulated later without Vivado.
+    """
     dpi_version = (
         "tapa_fast_cosim_dpi_xv"
         if get_vivado_version() >= "2024.2"
@@ -104,6 +116,7 @@ def get_vivado_tcl(
     script.append(r"add_files -fileset sim_1 -norecurse -scan_for_includes ${tb_files}")
 
     script.append("set_property top test [get_filesets sim_1]")
+    script.append(f"set_property verilog_define {{{SIM_DEFINE}}} [get_filesets sim_1]")
     script.append("set_property top_lib xil_defaultlib [get_filesets sim_1]")
 
     dpi_library_dir = paths.find_resource("tapa-fast-cosim-dpi-lib")
@@ -129,6 +142,11 @@ def get_vivado_tcl(
             r"-value {wave.wdb} -objects [get_filesets sim_1]"
         )
 
+    if elaborate_only:
+        script.append(r"launch_simulation -step compile")
+        script.append(r"launch_simulation -step elaborate")
+        return script
+
     script.append(r"launch_simulation")
     script.append(r"run all")
 
@@ -318,6 +318,8 @@ class Instance:
         ]
     ]:
         """Public handshake information tuples used for this instance."""
+        if self.task.is_free_running:
+            return
         if self.is_autorun:
             yield (Reg, Output, self.start.name)
         else:
@@ -409,10 +411,28 @@ class Port:
         self.width = obj["width"]
         self.chan_count = obj.get("chan_count")
         self.chan_size = obj.get("chan_size")
+        # Streams of a task with the same `lockstep` are transferred together.
+        self.lockstep = obj.get("lockstep")
+        # Tunables of the async_mmap hardware; None keeps the default.
+        self.max_outstanding: int | None = obj.get("max_outstanding")
+        self.max_burst_len: int | None = obj.get("max_burst_len")
+        self.buffer_size: int | None = obj.get("buffer_size")
+        self.reorder_buffer_size: int | None = obj.get("reorder_buffer_size")
 
     def __str__(self) -> str:
         return ", ".join(f"{k}: {v}" for k, v in self.__dict__.items())
 
+    @property
+    def id_width(self) -> int | None:
+        """Width of the AXI ID of an async_mmap with outstanding read bursts.
+
+        Each outstanding burst uses its own ID, so the number of IDs is
+        `max_outstanding` rounded up to a power of 2.
+        """
+        if self.max_outstanding is None or self.max_outstanding <= 1:
+            return None
+        return (self.max_outstanding - 1).bit_length()
+
     @property
     def is_istreams(self) -> bool:
         """If port is istreams."""
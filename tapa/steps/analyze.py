@@ -14,14 +14,21 @@ import re
 import shutil
 import subprocess
 import sys
+from concurrent import futures
 from pathlib import Path
 
 import click
 
+from tapa import __version__
+from tapa.common import build_trace
+from tapa.common.fifo_depth import infer_fifo_depths
 from tapa.common.graph import Graph as TapaGraph
 from tapa.common.paths import find_resource, get_tapa_cflags
+from tapa.common.step_manifest import get_file_key, get_key
+from tapa.common.task_fusion import report_task_chains
 from tapa.core import Program
 from tapa.steps.common import (
+    get_step_manifest,
     get_work_dir,
     is_pipelined,
     store_persistent_context,
@@ -82,12 +89,63 @@ _logger = logging.getLogger().getChild(__name__)
         "compatible interfaces"
     ),
 )
-def analyze(
+@click.option(
+    "--pch / --no-pch",
+    type=bool,
+    default=True,
+    help=(
+        "`--pch` (default) will precompile the TAPA and vendor headers once "
+        "per set of compiler flags and reuse them in later runs with the same "
+        "work directory; `--no-pch` will parse them from scratch every time"
+    ),
+)
+@click.option(
+    "fifo_depth_inference",
+    "--infer-fifo-depths",
+    type=click.Choice(["off", "report", "apply"], case_sensitive=False),
+    default="report",
+    help=(
+        "Estimate the FIFO depth each stream needs from the bursts of tokens "
+        "its producer and consumer transfer: `report` (default) logs FIFOs "
+        "whose declared depth differs, `apply` also uses the estimated depths, "
+        "and `off` skips the estimation"
+    ),
+)
+@click.option(
+    "--mmap-bus-width",
+    type=click.Choice(["0", "32", "64", "128", "256", "512", "1024"]),
+    default="0",
+    help=(
+        "Let HLS widen the m_axi ports of lower-level `tapa::mmap` arguments "
+        "up to this many bits when their accesses are sequential, and issue "
+        "long bursts with many outstanding requests on them; buffers must be "
+        "aligned to the bus width.  `0` (default) keeps the width of the "
+        "element type"
+    ),
+)
+@click.option(
+    "--specialize-constants / --no-specialize-constants",
+    type=bool,
+    default=False,
+    help=(
+        "Specialize each lower-level task on the scalar arguments that all "
+        "of its invocations pass the same compile-time constant to, so that "
+        "HLS propagates the constants into the task, and report ports that "
+        "tasks never use.  `--no-specialize-constants` (default) synthesizes "
+        "tasks for any argument values"
+    ),
+)
+@build_trace.traced("analyze")
+def analyze(  # noqa: PLR0913,PLR0917
     input_files: tuple[str, ...],
     top: str,
     cflags: tuple[str, ...],
     flatten_hierarchy: bool,
     vitis_mode: bool,
+    pch: bool,
+    fifo_depth_inference: str,
+    mmap_bus_width: str,
+    specialize_constants: bool,
 ) -> None:
     """Analyze TAPA program and store the program description."""
     tapacc = find_clang_binary("tapacc-binary")
@@ -100,17 +158,54 @@ def analyze(
     cflags += ("-std=c++14",)
 
     tapacc_cflags, system_cflags = find_tapacc_cflags(cflags)
-    flatten_files = run_flatten(
-        tapa_cpp, input_files, tapacc_cflags + system_cflags, work_dir
-    )
-    graph_dict = run_tapacc(
+    with build_trace.span("flatten", "analyze"):
+        flatten_files = run_flatten(
+            tapa_cpp, input_files, tapacc_cflags + system_cflags, work_dir
+        )
+
+    # Headers other than those of TAPA and the system are inlined by now.
+    manifest = get_step_manifest()
+    key = get_key(
+        __version__,
         tapacc,
-        flatten_files,
+        os.path.getmtime(tapacc),
         top,
         tapacc_cflags + system_cflags,
+        flatten_hierarchy,
         vitis_mode,
+        fifo_depth_inference,
+        mmap_bus_width,
+        specialize_constants,
+        get_file_key(flatten_files),
     )
+    if manifest is not None:
+        if manifest.is_done("analyze", key):
+            _logger.info("skipping analyze; the inputs are unchanged")
+            is_pipelined("analyze", True)
+            return
+        manifest.invalidate("analyze")
+
+    with build_trace.span("pch", "analyze"):
+        pch_path = (
+            get_pch(tapa_cpp, tapacc_cflags + system_cflags, work_dir)
+            if pch
+            else None
+        )
+    with build_trace.span("tapacc", "analyze"):
+        graph_dict = run_tapacc(
+            tapacc,
+            flatten_files,
+            top,
+            tapacc_cflags + system_cflags,
+            vitis_mode,
+            pch_path=pch_path,
+            mmap_bus_width=int(mmap_bus_width),
+            specialize_constants=specialize_constants,
+        )
     graph_dict["cflags"] = tapacc_cflags
+    if fifo_depth_inference != "off":
+        infer_fifo_depths(graph_dict, apply=fifo_depth_inference == "apply")
+    report_task_chains(graph_dict)
 
     # Flatten the graph if flatten_hierarchy is set
     tapa_graph = TapaGraph(None, graph_dict)
@@ -120,7 +215,12 @@ def analyze(
     store_tapa_program(Program(graph_dict, vitis_mode, work_dir))
 
     store_persistent_context("graph", graph_dict)
-    store_persistent_context("settings", {"vitis-mode": vitis_mode})
+    store_persistent_context(
+        "settings",
+        {"vitis-mode": vitis_mode, "mmap-bus-width": int(mmap_bus_width)},
+    )
+    if manifest is not None:
+        manifest.record("analyze", key, ["graph.json"])
 
     is_pipelined("analyze", True)
 
@@ -256,7 +356,8 @@ def run_flatten(
     """Flatten input files.
 
     Preprocess input C/C++ files so that all macros are expanded, and all
-    header files, excluding system and TAPA header files, are inlined.
+    header files, excluding system and TAPA header files, are inlined. Files
+    are preprocessed concurrently.
 
     Args:
     ----
@@ -281,44 +382,146 @@ def run_flatten(
         flatten_name = (
             "flatten-" + hash_val.hexdigest()[:8] + "-" + os.path.basename(file)
         )
-        flatten_path = os.path.join(flatten_folder, flatten_name)
-        flatten_files.append(flatten_path)
+        flatten_files.append(os.path.join(flatten_folder, flatten_name))
+
+    def flatten(file: str, flatten_path: str) -> None:
+        tapa_cpp_cmd = (
+            tapa_cpp,
+            "-x",
+            "c++",
+            "-E",
+            "-CC",
+            "-P",
+            "-fkeep-system-includes",
+            # FIXME: If we don't define __SYNTHESIS__, the generated code
+            #        may not be synthesizable if the user depends on this
+            #        synthesis-specific macros, as the macros will be
+            #        expanded by clang cpp.
+            "-D__SYNTHESIS__",
+            "-DAESL_SYN",
+            "-DAP_AUTOCC",
+            "-DTAPA_TARGET_DEVICE_",
+            "-DTAPA_TARGET_STUB_",
+            *cflags,
+            file,
+        )
+        flatten_code = run_and_check(tapa_cpp_cmd)
+        formated_code = clang_format(flatten_code)
 
         # Output flatten code to the file
         with open(flatten_path, "w", encoding="utf-8") as output_fp:
-            tapa_cpp_cmd = (
-                tapa_cpp,
-                "-x",
-                "c++",
-                "-E",
-                "-CC",
-                "-P",
-                "-fkeep-system-includes",
-                # FIXME: If we don't define __SYNTHESIS__, the generated code
-                #        may not be synthesizable if the user depends on this
-                #        synthesis-specific macros, as the macros will be
-                #        expanded by clang cpp.
-                "-D__SYNTHESIS__",
-                "-DAESL_SYN",
-                "-DAP_AUTOCC",
-                "-DTAPA_TARGET_DEVICE_",
-                "-DTAPA_TARGET_STUB_",
-                *cflags,
-                file,
-            )
-            flatten_code = run_and_check(tapa_cpp_cmd)
-            formated_code = clang_format(flatten_code)
             output_fp.write(formated_code)
 
+    # `run_and_check` exits on failure; the `SystemExit` raised in a worker is
+    # re-raised here when its result is collected.
+    with futures.ThreadPoolExecutor() as executor:
+        any(executor.map(flatten, files, flatten_files))
+
     return tuple(flatten_files)
 
 
-def run_tapacc(
+def _get_pch_dependencies(deps_path: Path) -> list[str]:
+    """Return the files listed in the Makefile-style dependency file."""
+    rules = deps_path.read_text(encoding="utf-8").replace("\\\n", " ")
+    _, _, prerequisites = rules.partition(": ")
+    return [
+        x.replace("\\ ", " ") for x in re.split(r"(?<!\\)\s+", prerequisites) if x
+    ]
+
+
+def _hash_pch_dependencies(deps_path: Path) -> str | None:
+    """Return a digest of the files a PCH was built from, or None if unknown."""
+    if not deps_path.is_file():
+        return None
+    digest = hashlib.sha256()
+    for dep in _get_pch_dependencies(deps_path):
+        digest.update(f"{dep}\0".encode())
+        try:
+            digest.update(Path(dep).read_bytes())
+        except FileNotFoundError:
+            return None
+    return digest.hexdigest()
+
+
+def get_pch(tapa_cpp: str, cflags: tuple[str, ...], work_dir: str) -> str | None:
+    """Return a precompiled `tapa.h` for `cflags`, building it if needed.
+
+    PCHs are cached in the work directory, keyed by `tapa-cpp` and `cflags`,
+    and rebuilt if the content of any header they were built from changed.
+    `tapa-cpp` and `tapacc` are built from the same clang, so the PCH is
+    compatible with `tapacc`.
+
+    Args:
+    ----
+      tapa_cpp: The path of the tapa-clang binary.
+      cflags: The CFLAGS that `tapacc` will be invoked with.
+      work_dir: Working directory of TAPA, for the cached PCHs.
+
+    Returns:
+    -------
+      The path of the PCH, or None if it cannot be built.
+
+    """
+    key = hashlib.sha256()
+    key.update(f"{tapa_cpp}\0{os.stat(tapa_cpp).st_mtime_ns}\0".encode())
+    for flag in cflags:
+        key.update(f"{flag}\0".encode())
+    pch_dir = Path(work_dir).absolute() / "pch" / key.hexdigest()[:16]
+    pch_path = pch_dir / "tapa.h.pch"
+    deps_path = pch_dir / "tapa.h.pch.d"
+    stamp_path = pch_dir / "tapa.h.pch.stamp"
+
+    digest = _hash_pch_dependencies(deps_path)
+    if (
+        pch_path.is_file()
+        and stamp_path.is_file()
+        and digest is not None
+        and stamp_path.read_text(encoding="utf-8") == digest
+    ):
+        _logger.info("reusing precompiled header `%s`", pch_path)
+        return str(pch_path)
+
+    pch_dir.mkdir(parents=True, exist_ok=True)
+    stamp_path.unlink(missing_ok=True)
+    prefix_path = pch_dir / "prefix.h"
+    prefix_path.write_text("#include <tapa.h>\n", encoding="utf-8")
+    pch_cmd = (
+        tapa_cpp,
+        "-x",
+        "c++-header",
+        *cflags,
+        "-DTAPA_TARGET_DEVICE_",
+        "-DTAPA_TARGET_STUB_",
+        "-fpch-validate-input-files-content",
+        "-MD",
+        "-MF",
+        str(deps_path),
+        "-o",
+        str(pch_path),
+        str(prefix_path),
+    )
+    _logger.info("precompiling headers into `%s`", pch_path)
+    proc = subprocess.run(pch_cmd, stderr=subprocess.PIPE, text=True, check=False)
+    digest = _hash_pch_dependencies(deps_path)
+    if proc.returncode != 0 or digest is None:
+        _logger.warning(
+            "failed to precompile headers; parsing them from scratch: %s",
+            proc.stderr,
+        )
+        return None
+    stamp_path.write_text(digest, encoding="utf-8")
+    return str(pch_path)
+
+
+def run_tapacc(  # noqa: PLR0913,PLR0917
     tapacc: str,
     files: tuple[str, ...],
     top: str,
     cflags: tuple[str, ...],
     vitis_mode: bool,
+    pch_path: str | None = None,
+    mmap_bus_width: int = 0,
+    specialize_constants: bool = False,
 ) -> dict:
     """Execute tapacc and return the program description.
 
@@ -328,6 +531,9 @@ def run_tapacc(
       files: C/C++ files to flatten.
       cflags: User specified CFLAGS with TAPA specific headers.
       vitis_mode: Insert Vitis compatible interfaces or not.
+      pch_path: Precompiled `tapa.h` built by `get_pch` for `cflags`, if any.
+      mmap_bus_width: Width to widen lower-level mmap ports to, or 0.
+      specialize_constants: Specialize lower-level tasks on constant scalars.
 
     Returns:
     -------
@@ -338,10 +544,17 @@ def run_tapacc(
         "-top",
         top,
         *(("-vitis",) if vitis_mode else ()),
+        *((f"-mmap-bus-width={mmap_bus_width}",) if mmap_bus_width else ()),
+        *(("-specialize-constants",) if specialize_constants else ()),
         "--",
         *cflags,
         "-DTAPA_TARGET_DEVICE_",
         "-DTAPA_TARGET_STUB_",
+        *(
+            ("-include-pch", pch_path, "-fpch-validate-input-files-content")
+            if pch_path
+            else ()
+        ),
     )
     tapacc_cmd = (tapacc, *files, *tapacc_args)
     quoted_cmd = " ".join(f'"{arg}"' if " " in arg else arg for arg in tapacc_cmd)
@@ -6,16 +6,22 @@ All rights reserved. The contributor(s) of this file has/have agreed to the
 RapidStream Contributor License Agreement.
 """
 
+import hashlib
 import json
 import logging
 import os
+import pickle
 
 import click
 
+from tapa.common.step_manifest import StepManifest
 from tapa.core import Program
 
 _logger = logging.getLogger().getChild(__name__)
 
+# Version of the pickled context cache; bump it if its layout changes.
+_CONTEXT_CACHE_VERSION = 1
+
 
 def forward_applicable(
     ctx: click.Context,
@@ -33,6 +39,19 @@ def get_work_dir() -> str:
     return click.get_current_context().obj["work-dir"]
 
 
+def get_step_manifest() -> StepManifest | None:
+    """Returns the step manifest of the work directory, or `None` if disabled.
+
+    Steps record the key of their inputs in the manifest, and skip themselves
+    if they were completed with the same key before, unless `--no-resume` is
+    given to `tapa`.
+    """
+    local_ctx = click.get_current_context().obj
+    if not local_ctx.get("resume", False):
+        return None
+    return StepManifest(get_work_dir())
+
+
 def is_pipelined(step: str, pipelined: bool | None = None) -> bool | None:
     """Gets or sets if a step is pipelined in this single run."""
     if pipelined is None:
@@ -63,8 +82,8 @@ def load_persistent_context(name: str) -> dict:
         _logger.info("loading TAPA graph from json `%s`.", json_file)
 
         try:
-            with open(json_file, encoding="utf-8") as input_fp:
-                obj = json.loads(input_fp.read())
+            with open(json_file, "rb") as input_fp:
+                content = input_fp.read()
         except FileNotFoundError:
             msg = (
                 f"Graph description {json_file} does not exist.  Either "
@@ -73,6 +92,11 @@ def load_persistent_context(name: str) -> dict:
             raise click.BadArgumentUsage(
                 msg,
             )
+        digest = hashlib.sha256(content).hexdigest()
+        obj = _load_context_cache(name, digest)
+        if obj is None:
+            obj = json.loads(content)
+            _store_context_cache(name, digest, obj)
         local_ctx[name] = obj
 
     return local_ctx[name]
@@ -115,8 +139,46 @@ def store_persistent_context(name: str, ctx: dict | None = None) -> None:
     json_file = os.path.join(get_work_dir(), f"{name}.json")
     _logger.info("writing TAPA %s to json `%s`.", name, json_file)
 
-    with open(json_file, "w", encoding="utf-8") as output_fp:
-        json.dump(local_ctx[name], output_fp)
+    content = json.dumps(local_ctx[name]).encode()
+    with open(json_file, "wb") as output_fp:
+        output_fp.write(content)
+    _store_context_cache(name, hashlib.sha256(content).hexdigest(), local_ctx[name])
+
+
+def _get_context_cache_path(name: str) -> str:
+    return os.path.join(get_work_dir(), f".{name}.pickle")
+
+
+def _load_context_cache(name: str, digest: str) -> dict | None:
+    """Load the context cached for the json file of `digest`, if valid.
+
+    Unpickling is much faster than parsing json for large graphs. The json file
+    remains the source of truth; the cache is ignored if it was made from a
+    different json file or by a different cache version.
+    """
+    try:
+        with open(_get_context_cache_path(name), "rb") as cache_fp:
+            version, cached_digest, obj = pickle.load(cache_fp)  # noqa: S301
+    except (OSError, pickle.UnpicklingError, EOFError, ValueError, TypeError):
+        return None
+    if (version, cached_digest) != (_CONTEXT_CACHE_VERSION, digest):
+        return None
+    _logger.debug("loaded TAPA %s from cache.", name)
+    return obj
+
+
+def _store_context_cache(name: str, digest: str, obj: dict) -> None:
+    cache_path = _get_context_cache_path(name)
+    try:
+        with open(f"{cache_path}.tmp", "wb") as cache_fp:
+            pickle.dump(
+                (_CONTEXT_CACHE_VERSION, digest, obj),
+                cache_fp,
+                protocol=pickle.HIGHEST_PROTOCOL,
+            )
+        os.replace(f"{cache_path}.tmp", cache_path)
+    except OSError as e:
+        _logger.debug("cannot cache TAPA %s: %s", name, e)
 
 
 def store_tapa_program(prog: Program) -> None:
@@ -15,7 +15,7 @@ from pathlib import Path
 
 import click
 
-from tapa.common.paths import get_tapa_cflags, get_tapa_ldflags
+from tapa.common.paths import find_resource, get_tapa_cflags, get_tapa_ldflags
 from tapa.util import get_xilinx_tool_path
 
 _logger = logging.getLogger().getChild(__name__)
@@ -28,14 +28,28 @@ _logger = logging.getLogger().getChild(__name__)
     type=click.Path(dir_okay=False, executable=True),
     help="Run the specified executable instead of `g++`.",
 )
+@click.option(
+    "--fast-ap-int",
+    is_flag=True,
+    help=(
+        "Use TAPA's host implementation of `ap_int.h`, which simulates "
+        "`ap_int` and `ap_uint` faster than the vendor headers.  Fixed-point "
+        "types are not provided."
+    ),
+)
 @click.argument("argv", nargs=-1, type=click.UNPROCESSED)
-def gcc(executable: str, argv: Iterable[str]) -> None:
+def gcc(executable: str, fast_ap_int: bool, argv: Iterable[str]) -> None:
     """Invoke `g++` with TAPA include and library paths.
 
     This is intended only for usage with pre-built binary installation.
     Developers building TAPA from source should compile binaries using `bazel`.
     """
     vendor_include_paths = []
+    if fast_ap_int:
+        # Precedes the vendor include path to shadow its `ap_int.h`.
+        vendor_include_paths.append(
+            find_resource("tapa-lib-include") / "tapa" / "host" / "ap_int"
+        )
     xilinx_hls_path = get_xilinx_tool_path()
     if xilinx_hls_path is not None:
         vendor_include_paths.append(Path(xilinx_hls_path) / "include")
@@ -9,6 +9,7 @@ RapidStream Contributor License Agreement.
 
 import click
 
+from tapa.common import build_trace
 from tapa.steps.common import (
     is_pipelined,
     load_persistent_context,
@@ -17,6 +18,7 @@ from tapa.steps.common import (
 
 
 @click.command()
+@build_trace.traced("link")
 def link() -> None:
     """Link the generated RTL."""
     settings = load_persistent_context("settings")
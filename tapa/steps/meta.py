@@ -9,6 +9,7 @@ RapidStream Contributor License Agreement.
 
 import click
 
+from tapa.common import build_trace
 from tapa.steps.analyze import analyze
 from tapa.steps.common import forward_applicable
 from tapa.steps.link import link
@@ -18,6 +19,7 @@ from tapa.steps.synth import synth
 
 @click.command("compile")
 @click.pass_context
+@build_trace.traced("compile")
 def compile_entry(ctx: click.Context, **kwargs: dict) -> None:
     """Compile a TAPA program to a hardware design."""
     forward_applicable(ctx, analyze, kwargs)
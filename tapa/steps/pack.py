@@ -6,13 +6,24 @@ All rights reserved. The contributor(s) of this file has/have agreed to the
 RapidStream Contributor License Agreement.
 """
 
+import fnmatch
 import logging
 import os
+from collections.abc import Mapping, Sequence
 from pathlib import Path
 
 import click
 
+from tapa.common import build_trace
+from tapa.common.hbm_binding import (
+    DEFAULT_CHANNEL_COUNT,
+    apply_traffic_hints,
+    bind_channels,
+    load_port_stats,
+)
+from tapa.core import Program
 from tapa.steps.common import is_pipelined, load_persistent_context, load_tapa_program
+from tapa.util import get_indexed_name, range_or_none
 
 _logger = logging.getLogger().getChild(__name__)
 
@@ -37,6 +48,7 @@ VITIS_COMMAND_BASIC = [
     "  --vivado.prop=run.impl_1.STEPS.ROUTE_DESIGN.ARGS.DIRECTIVE=$STRATEGY \\",
 ]
 CONFIG_OPTION = ['  --config "${CONFIG_FILE}" \\']
+REUSE_IMPL_OPTION = ['  "${INCREMENTAL_OPTIONS[@]}" \\']
 CLOCK_OPTION = ["  --kernel_frequency ${TARGET_FREQUENCY} \\"]
 NEWLINE = [""]
 
@@ -72,11 +84,85 @@ NEWLINE = [""]
     'Use [[tapa::target("non_synthesizable", "xilinx")]] to generate the'
     "template for the custom rtl",
 )
-def pack(
+@click.option(
+    "--incremental / --no-incremental",
+    type=bool,
+    default=True,
+    help=(
+        "Replace the RTL files in the previously packed .xo file instead of "
+        "running Vivado again if the kernel interface and the set of RTL files "
+        "are unchanged."
+    ),
+)
+@click.option(
+    "--hbm-bind / --no-hbm-bind",
+    type=bool,
+    default=False,
+    help=(
+        "Bind each mmap port of the top-level task to an HBM pseudo-channel in "
+        "the bitstream script, balancing the estimated traffic of the channels "
+        "and of the HBM stacks."
+    ),
+)
+@click.option(
+    "--hbm-port-stats",
+    type=click.Path(exists=True, dir_okay=False, path_type=Path),
+    help=(
+        "Estimate the traffic of mmap ports for `--hbm-bind` from the "
+        "`port_stats.json` written by fast cosim."
+    ),
+)
+@click.option(
+    "--hbm-traffic",
+    multiple=True,
+    metavar="PORT=WEIGHT",
+    help=(
+        "Set the estimated traffic of mmap ports matching the glob PORT for "
+        "`--hbm-bind`, overriding `--hbm-port-stats`. "
+        "Can be specified multiple times."
+    ),
+)
+@click.option(
+    "--hbm-channels",
+    type=click.IntRange(min=1),
+    default=DEFAULT_CHANNEL_COUNT,
+    show_default=True,
+    help="Number of HBM pseudo-channels of the platform for `--hbm-bind`.",
+)
+@click.option(
+    "--host-memory-port",
+    multiple=True,
+    metavar="PORT",
+    help=(
+        "Connect mmap ports matching the glob PORT of the top-level task to host "
+        "memory in the bitstream script, for `tapa::host_only_mmap` arguments. "
+        "Such ports are not bound to HBM. Can be specified multiple times."
+    ),
+)
+@click.option(
+    "--reuse-impl / --no-reuse-impl",
+    type=bool,
+    default=False,
+    help=(
+        "Make the bitstream script skip v++ if the xo file and the script are "
+        "unchanged since its last successful run, and otherwise start Vivado "
+        "from the routed checkpoint of that run with incremental "
+        "implementation."
+    ),
+)
+@build_trace.traced("pack")
+def pack(  # noqa: PLR0913,PLR0917
     output: str,
     bitstream_script: str | None,
     flow_type: str,
     custom_rtl: tuple[Path, ...],
+    incremental: bool,
+    hbm_bind: bool,
+    hbm_port_stats: Path | None,
+    hbm_traffic: tuple[str, ...],
+    hbm_channels: int,
+    host_memory_port: tuple[str, ...],
+    reuse_impl: bool,
 ) -> None:
     """Pack the generated RTL into a Xilinx object file."""
     program = load_tapa_program()
@@ -94,12 +180,19 @@ def pack(
             "you are not in Vitis mode, the generated RTL will not be packed."
         )
         return
+    program.clock_2_tasks = tuple(settings.get("clock-2-tasks", ()))
     if custom_rtl:
         templates_info = load_persistent_context("templates_info")
         program.replace_custom_rtl(custom_rtl, templates_info)
-    program.pack_rtl(output)
+    program.pack_rtl(output, incremental)
 
     if bitstream_script is not None:
+        host_ports = get_host_memory_ports(program, host_memory_port)
+        hbm_binding = None
+        if hbm_bind:
+            hbm_binding = get_hbm_binding(
+                program, hbm_port_stats, hbm_traffic, hbm_channels, host_ports
+            )
         with open(bitstream_script, "w", encoding="utf-8") as script:
             script.write(
                 get_vitis_script(
@@ -108,6 +201,12 @@ def pack(
                     settings.get("platform", None),
                     settings.get("clock-period", None),
                     settings.get("connectivity", None),
+                    settings.get("clock-2-period", None)
+                    if program.clock_2_tasks
+                    else None,
+                    hbm_binding,
+                    reuse_impl,
+                    host_ports,
                 )
             )
             _logger.info("generate the v++ script at %s", bitstream_script)
@@ -115,18 +214,89 @@ def pack(
     is_pipelined("pack", True)
 
 
-def get_vitis_script(
+def get_mmap_ports(program: Program) -> dict[str, int]:
+    """Return the width of each mmap port, or channel, of the top task."""
+    return {
+        get_indexed_name(port.name, i): port.width
+        for port in program.top_task.ports.values()
+        if port.cat.is_mmap
+        for i in range_or_none(port.chan_count)
+    }
+
+
+def get_host_memory_ports(program: Program, patterns: tuple[str, ...]) -> list[str]:
+    """Return the mmap ports of the top task that match any of `patterns`."""
+    ports = list(get_mmap_ports(program))
+    matched: set[str] = set()
+    for pattern in patterns:
+        matched_by_pattern = fnmatch.filter(ports, pattern)
+        if not matched_by_pattern:
+            msg = f"no mmap port matches host memory port '{pattern}'"
+            raise click.BadParameter(msg)
+        matched.update(matched_by_pattern)
+    return [port for port in ports if port in matched]
+
+
+def get_hbm_binding(
+    program: Program,
+    port_stats: Path | None,
+    hints: tuple[str, ...],
+    channel_count: int,
+    excluded_ports: Sequence[str] = (),
+) -> dict[str, int]:
+    """Return the HBM pseudo-channel bound to each mmap port of the top task.
+
+    Ports in `excluded_ports`, e.g., those in host memory, are not bound.
+    """
+    widths = {
+        port: width
+        for port, width in get_mmap_ports(program).items()
+        if port not in excluded_ports
+    }
+    traffic = {} if port_stats is None else load_port_stats(port_stats, widths)
+    try:
+        traffic = apply_traffic_hints(traffic, widths, hints)
+        binding = bind_channels(traffic, channel_count)
+    except ValueError as e:
+        raise click.BadParameter(str(e)) from e
+
+    loads = [0.0] * channel_count
+    for port, channel in binding.items():
+        loads[channel] += traffic[port]
+        _logger.info(
+            "bind mmap port %s (traffic: %g) to HBM[%d]", port, traffic[port], channel
+        )
+    if len(binding) > channel_count:
+        _logger.warning(
+            "%d mmap ports share %d HBM pseudo-channels", len(binding), channel_count
+        )
+    _logger.info("estimated traffic of the busiest HBM channel: %g", max(loads))
+    return binding
+
+
+def get_vitis_script(  # noqa: PLR0913,PLR0917
     top: str,
     output_file: str,
     platform: str,
     clock_period: str,
     connectivity: str | None,
+    clock_2_period: float | None = None,
+    hbm_binding: Mapping[str, int] | None = None,
+    reuse_impl: bool = False,
+    host_memory_ports: Sequence[str] = (),
 ) -> str:
-    """Generate v++ commands to run implementation."""
+    """Generate v++ commands to run implementation.
+
+    If `clock_2_period` is given, it is the target of the second kernel clock.
+    If `hbm_binding` is given, it maps mmap ports to their HBM pseudo-channels.
+    If `reuse_impl` is set, the script reuses the results of its last run; see
+    `get_reuse_impl_script`.
+    Mmap ports in `host_memory_ports` are connected to host memory.
+    """
     script = []
     script.append("#!/bin/bash")
 
-    vitis_command = VITIS_COMMAND_BASIC
+    vitis_command = list(VITIS_COMMAND_BASIC)
 
     script.extend(("TARGET=hw", "# TARGET=hw_emu", "# DEBUG=-g"))
     script += NEWLINE
@@ -150,7 +320,12 @@ def get_vitis_script(
     # if not specified in tapac, use platform default
     if clock_period:
         freq_mhz = round(1000 / float(clock_period))
-        script.append(f"TARGET_FREQUENCY={freq_mhz}")
+        if clock_2_period:
+            # v++ takes the frequencies of multiple kernel clocks by clock ID
+            freq_2_mhz = round(1000 / float(clock_2_period))
+            script.append(f"TARGET_FREQUENCY='0:{freq_mhz}|1:{freq_2_mhz}'")
+        else:
+            script.append(f"TARGET_FREQUENCY={freq_mhz}")
         vitis_command += CLOCK_OPTION
     else:
         script.append('>&2 echo "Using the default clock target of the platform."')
@@ -174,7 +349,66 @@ def get_vitis_script(
     script.append(r'PLACEMENT_STRATEGY="EarlyBlockPlacement"')
     script += NEWLINE
 
+    if hbm_binding:
+        vitis_command += [
+            f"  --connectivity.sp ${{TOP}}.{port}:HBM[{channel}] \\"
+            for port, channel in hbm_binding.items()
+        ]
+    vitis_command += [
+        f"  --connectivity.sp ${{TOP}}.{port}:HOST[0] \\" for port in host_memory_ports
+    ]
+
+    if reuse_impl:
+        script += get_reuse_impl_script()
+        vitis_command += REUSE_IMPL_OPTION
+
     script += vitis_command
     script += NEWLINE
 
+    if reuse_impl:
+        script += get_save_impl_script()
+
     return "\n".join(script)
+
+
+def get_reuse_impl_script() -> list[str]:
+    """Return the lines that reuse the last run of the bitstream script.
+
+    The run is keyed by the digest of the script, the xo file, and the
+    connectivity configuration. If the key is unchanged and the xclbin file is
+    still there, the script exits without running v++. Otherwise, Vivado
+    starts from the routed checkpoint of the last run, if any, so that only the
+    parts of the design that changed are placed and routed again.
+    """
+    return [
+        r'REFERENCE_DIR="${OUTPUT_DIR}/reference"',
+        'LINK_KEY="$(cat "$0" "${XO}" ${CONFIG_FILE:+"${CONFIG_FILE}"} \\',
+        "  | sha256sum | cut -d' ' -f1)\"",
+        r'if [ -f "${OUTPUT_DIR}/${TOP}_${PLATFORM}.xclbin" ] &&',
+        r'  [ "$(cat "${REFERENCE_DIR}/key" 2>/dev/null)" = "${LINK_KEY}" ]; then',
+        r'  echo "Reusing ${OUTPUT_DIR}/${TOP}_${PLATFORM}.xclbin: inputs unchanged."',
+        r"  exit 0",
+        r"fi",
+        r"INCREMENTAL_OPTIONS=()",
+        r'if [ -f "${REFERENCE_DIR}/routed.dcp" ]; then',
+        r"  INCREMENTAL_OPTIONS=(--vivado.prop",
+        r'    "run.impl_1.INCREMENTAL_CHECKPOINT=${REFERENCE_DIR}/routed.dcp")',
+        r"fi",
+        *NEWLINE,
+    ]
+
+
+def get_save_impl_script() -> list[str]:
+    """Return the lines that save the routed checkpoint of a successful run."""
+    return [
+        r"STATUS=$?",
+        r'if [ "${STATUS}" -ne 0 ]; then exit "${STATUS}"; fi',
+        'ROUTED_DCP="$(find "${OUTPUT_DIR}/${TOP}_${PLATFORM}.temp" \\',
+        "  -path '*/impl_1/*_routed.dcp' | head -n 1)\"",
+        r'if [ -n "${ROUTED_DCP}" ]; then',
+        r'  mkdir -p "${REFERENCE_DIR}"',
+        r'  cp "${ROUTED_DCP}" "${REFERENCE_DIR}/routed.dcp"',
+        r'  echo "${LINK_KEY}" >"${REFERENCE_DIR}/key"',
+        r"fi",
+        *NEWLINE,
+    ]
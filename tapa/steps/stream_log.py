@@ -0,0 +1,98 @@
+"""Decode and compare stream logs generated by TAPA software simulation."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import itertools
+import logging
+import sys
+from collections.abc import Iterator
+from pathlib import Path
+
+import click
+
+from tapa.common.stream_log import (
+    bits_equal,
+    is_binary_log,
+    read_binary_log,
+    read_bits_dump,
+)
+
+_logger = logging.getLogger().getChild(__name__)
+
+
+def _read_bits(path: Path) -> Iterator[str]:
+    """Yields tokens of a binary log or a text dump in the bits format."""
+    if is_binary_log(path):
+        with path.open("rb") as file:
+            yield from (token.to_bits() for token in read_binary_log(file))
+    else:
+        with path.open(encoding="utf-8") as file:
+            yield from read_bits_dump(file)
+
+
+@click.command("stream-log")
+@click.argument(
+    "log",
+    type=click.Path(exists=True, dir_okay=False, path_type=Path),
+)
+@click.option(
+    "--format",
+    "output_format",
+    type=click.Choice(["hex", "bits"]),
+    default="hex",
+    help="Print values in hex like text stream logs, or as cosim stream bits.",
+)
+@click.option(
+    "--diff",
+    "other",
+    metavar="FILE",
+    type=click.Path(exists=True, dir_okay=False, path_type=Path),
+    help="Compare with another binary log or a cosim stream dump, "
+    "which has one token in the bits format per line.",
+)
+@click.option(
+    "--max-mismatches",
+    default=10,
+    show_default=True,
+    help="Maximum number of mismatches to print with `--diff`.",
+)
+def stream_log(
+    log: Path,
+    output_format: str,
+    other: Path | None,
+    max_mismatches: int,
+) -> None:
+    """Decode a binary stream log, or compare it with `--diff`.
+
+    Binary stream logs are generated by software simulation with
+    `TAPA_STREAM_LOG_FORMAT=binary` or `TAPA_STREAM_LOG_FORMAT=compressed`, and
+    `TAPA_STREAM_LOG_DIR` set.
+    """
+    if other is None:
+        with log.open("rb") as file:
+            for token in read_binary_log(file):
+                sys.stdout.write(
+                    (token.to_hex() if output_format == "hex" else token.to_bits())
+                    + "\n"
+                )
+        return
+
+    mismatches = 0
+    count = 0
+    for count, (lhs, rhs) in enumerate(
+        itertools.zip_longest(_read_bits(log), _read_bits(other)), start=1
+    ):
+        if lhs is not None and rhs is not None and bits_equal(lhs, rhs):
+            continue
+        mismatches += 1
+        if mismatches <= max_mismatches:
+            _logger.error("token #%d differs: %s vs %s", count - 1, lhs, rhs)
+
+    if mismatches:
+        _logger.error("%d of %d tokens differ", mismatches, count)
+        sys.exit(1)
+    _logger.info("all %d tokens match", count)
@@ -0,0 +1,183 @@
+"""Compile variants of a design over a grid of parameters."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import io
+import logging
+import os
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+
+import click
+
+from tapa.common.sweep import (
+    get_cflags,
+    get_variant_name,
+    get_variant_result,
+    get_variants,
+    parse_grid,
+    write_results,
+)
+from tapa.steps.common import get_work_dir
+from tapa.steps.meta import compile_entry
+
+_logger = logging.getLogger().getChild(__name__)
+
+
+def _get_tapa_command() -> list[str]:
+    """Return the command that started this process, without its arguments.
+
+    It is, e.g., `python -m tapa` or the path of a packaged `tapa` binary.
+    """
+    return sys.orig_argv[: len(sys.orig_argv) - len(sys.argv) + 1]
+
+
+def _get_compile_args(kwargs: dict) -> list[str]:
+    """Return the `tapa compile` arguments that give `kwargs` back."""
+    args: list[str] = []
+    for param in compile_entry.params:
+        if not isinstance(param, click.Option):
+            continue
+        value = kwargs.get(param.name)
+        if param.is_flag and param.secondary_opts:
+            args.append(param.opts[0] if value else param.secondary_opts[0])
+        elif param.is_flag:
+            if value:
+                args.append(param.opts[0])
+        elif value is None:
+            continue
+        else:
+            for item in value if param.multiple else [value]:
+                items = item if isinstance(item, tuple) else (item,)
+                args.extend([param.opts[0], *map(str, items)])
+    return args
+
+
+@click.command("sweep")
+@click.option(
+    "--param",
+    "params",
+    metavar="NAME=V1,V2,...",
+    multiple=True,
+    required=True,
+    help=(
+        "Values of a parameter, which is defined as a macro by `-DNAME=V` for "
+        "each variant.  Variants cover all combinations of the parameters.  "
+        "May appear many times."
+    ),
+)
+@click.option(
+    "--parallel-variants",
+    type=click.IntRange(min=1),
+    default=2,
+    show_default=True,
+    help=(
+        "Number of variants compiled at the same time.  Each variant runs up "
+        "to `--jobs` HLS jobs itself."
+    ),
+)
+@click.option(
+    "--cosim-command",
+    metavar="CMD",
+    default=None,
+    help=(
+        "Shell command that cosimulates a compiled variant, e.g., "
+        "`./vadd --bitstream={xo} --xosim_work_dir={cosim_dir}`.  `{xo}` and "
+        "`{cosim_dir}` are replaced for each variant, and the kernel cycles "
+        "are read from the port statistics in `{cosim_dir}`."
+    ),
+)
+@click.pass_context
+def sweep(
+    ctx: click.Context,
+    params: tuple[str, ...],
+    parallel_variants: int,
+    cosim_command: str | None,
+    **kwargs: dict,
+) -> None:
+    """Compile a variant of the design for each combination of parameters.
+
+    Each variant is compiled by `tapa compile` with the other options in its
+    own work directory, `sweep/<variant>` in the work directory.  The HLS
+    cache is shared by all variants, so tasks that do not depend on the
+    parameters are synthesized once.  The area, Fmax, and cosimulated cycles
+    of all variants are tabulated in `sweep/results.csv`.
+    """
+    try:
+        variants = get_variants(parse_grid(params))
+    except ValueError as e:
+        raise click.BadParameter(str(e), param_hint="--param") from e
+
+    sweep_dir = Path(get_work_dir(), "sweep").resolve()
+    if kwargs.get("hls_cache_dir") is None:
+        kwargs["hls_cache_dir"] = str(sweep_dir / "hls-cache")
+    output_name = Path(kwargs["output"]).name
+    tapa_args = _get_tapa_command()
+    parent_params = ctx.parent.params if ctx.parent is not None else {}
+    tapa_args += ["-v"] * parent_params.get("verbose", 0)
+    tapa_args += ["-q"] * parent_params.get("quiet", 0)
+
+    def run(variant: dict[str, str]) -> dict[str, object]:
+        name = get_variant_name(variant)
+        work_dir = sweep_dir / name
+        work_dir.mkdir(parents=True, exist_ok=True)
+        xo = work_dir / output_name
+        variant_kwargs = {
+            **kwargs,
+            "cflags": (*kwargs["cflags"], *get_cflags(variant)),
+            "output": str(xo),
+        }
+        if kwargs.get("bitstream_script"):
+            script_name = Path(kwargs["bitstream_script"]).name
+            variant_kwargs["bitstream_script"] = str(work_dir / script_name)
+        command = [
+            *tapa_args,
+            "--work-dir",
+            str(work_dir),
+            "compile",
+            *_get_compile_args(variant_kwargs),
+        ]
+
+        _logger.info("compiling variant %s", name)
+        with open(work_dir / "sweep.log", "wb") as log:
+            status = "compiled"
+            if subprocess.run(command, stdout=log, stderr=log, check=False).returncode:
+                status = "compile failed"
+            cosim_dir = None
+            if status == "compiled" and cosim_command is not None:
+                _logger.info("cosimulating variant %s", name)
+                cosim_dir = work_dir / "cosim"
+                if subprocess.run(
+                    cosim_command.format(xo=xo, cosim_dir=cosim_dir),
+                    shell=True,  # noqa: S602
+                    stdout=log,
+                    stderr=log,
+                    check=False,
+                ).returncode:
+                    status = "cosim failed"
+        if status != "compiled":
+            _logger.error("%s for variant %s; see %s", status, name, log.name)
+        return {"status": status, **get_variant_result(work_dir, cosim_dir)}
+
+    with ThreadPoolExecutor(max_workers=parallel_variants) as executor:
+        results = list(executor.map(run, variants))
+
+    table = io.StringIO()
+    write_results(table, variants, results)
+    with open(sweep_dir / "results.csv", "w", encoding="utf-8") as fp:
+        fp.write(table.getvalue())
+    _logger.info(
+        "results of %d variants written to %s:\n%s",
+        len(variants),
+        os.path.join(sweep_dir, "results.csv"),
+        table.getvalue(),
+    )
+
+
+sweep.params.extend(compile_entry.params)
@@ -6,18 +6,53 @@ All rights reserved. The contributor(s) of this file has/have agreed to the
 RapidStream Contributor License Agreement.
 """
 
+import json
+import logging
 from typing import NoReturn
 
 import click
 
+from tapa import __version__
+from tapa.common import build_trace
+from tapa.common.fifo_impl import MEM_STYLES
+from tapa.common.floorplan import get_slots
+from tapa.common.step_manifest import get_file_key, get_key
 from tapa.backend.xilinx import parse_device_info
 from tapa.steps.common import (
+    get_step_manifest,
     is_pipelined,
     load_persistent_context,
     load_tapa_program,
     store_persistent_context,
 )
 
+_logger = logging.getLogger().getChild(__name__)
+
+# Options of `synth` that only affect how the results are produced.
+_OPTIONS_NOT_AFFECTING_RESULTS = frozenset(
+    {
+        "jobs",
+        "keep_hls_work_dir",
+        "skip_hls_based_on_mtime",
+        "skip_hls_based_on_content",
+        "hls_cache_dir",
+        "hls_launchers",
+        "hls_memory_budget",
+    }
+)
+
+# Outputs of `synth` in the work directory, which must be intact to skip it.
+# `settings.json` is excluded as later steps update it.
+_OUTPUTS = (
+    "graph.json",
+    "templates_info.json",
+    "report.json",
+    "floorplan.json",
+    "floorplan.xdc",
+    "hdl",
+    "template",
+)
+
 
 @click.command()
 @click.option(
@@ -54,6 +89,57 @@ from tapa.steps.common import (
         "This can lead to incorrect results; use at your own risk."
     ),
 )
+@click.option(
+    "--skip-hls-based-on-content / --no-skip-hls-based-on-content",
+    type=bool,
+    default=True,
+    help=(
+        "Skip HLS if an output tarball exists and was generated from the same "
+        "task C++ code, headers, and HLS settings."
+    ),
+)
+@click.option(
+    "--hls-cache-dir",
+    type=click.Path(file_okay=False),
+    envvar="TAPA_HLS_CACHE_DIR",
+    default=None,
+    help=(
+        "Directory of HLS results keyed by the task C++ code, headers, and HLS "
+        "settings.  Tasks found in it are not synthesized again.  It may be "
+        "shared across work directories and machines, e.g., over NFS.  "
+        "Defaults to $TAPA_HLS_CACHE_DIR."
+    ),
+)
+@click.option(
+    "--hls-launcher",
+    "hls_launchers",
+    type=str,
+    multiple=True,
+    help=(
+        "Command prefix to launch each HLS run with, e.g., `ssh host` or "
+        "`srun --mem=16G`, so HLS runs on other hosts that share the work "
+        "directory.  May be repeated; each launcher runs one HLS job at a "
+        "time, and `--jobs` defaults to the number of launchers."
+    ),
+)
+@click.option(
+    "--hls-memory-budget",
+    type=click.FloatRange(min=0, min_open=True),
+    default=None,
+    help=(
+        "Memory in GiB that concurrent local HLS jobs may use, estimated from "
+        "their previous runs.  Defaults to the available memory."
+    ),
+)
+@click.option(
+    "--dedup-hls / --no-dedup-hls",
+    type=bool,
+    default=True,
+    help=(
+        "Synthesize tasks whose C++ code only differs in the task name once, "
+        "and rename the RTL for the others."
+    ),
+)
 @click.option(
     "--other-hls-configs",
     type=str,
@@ -73,12 +159,150 @@ from tapa.steps.common import (
     default=False,
     help="Print all FIFO operations in cosim.",
 )
+@click.option(
+    "--coalesce-streams / --no-coalesce-streams",
+    type=bool,
+    default=False,
+    help=(
+        "Share one wide FIFO among streams between the same pair of tasks "
+        "if both tasks always transfer them together."
+    ),
+)
+@click.option(
+    "--free-running-detached / --no-free-running-detached",
+    type=bool,
+    default=False,
+    help=(
+        "Synthesize detached tasks that only take streams and constants with "
+        "`ap_ctrl_none`, which run as soon as the kernel is out of reset "
+        "without start logic."
+    ),
+)
+@click.option(
+    "--low-latency-control / --no-low-latency-control",
+    type=bool,
+    default=False,
+    help=(
+        "Finish upper-level tasks one cycle earlier after their children are "
+        "done, at the cost of a longer combinational path in their FSMs."
+    ),
+)
+@click.option(
+    "--axi-crossbar-radix",
+    type=click.Choice(["0", "2", "4", "8", "16"]),
+    default="0",
+    help=(
+        "Connect mmaps shared by more tasks than this via a tree of crossbars "
+        "with at most this many tasks each, which closes timing more easily "
+        "than one large crossbar.  `0` (default) always uses one crossbar."
+    ),
+)
+@click.option(
+    "--axi-crossbar-stages",
+    type=click.IntRange(min=0),
+    default=1,
+    help="Number of register stages between levels of crossbar trees.",
+)
+@click.option(
+    "--m-axi-stages",
+    "m_axi_stages",
+    type=str,
+    multiple=True,
+    help=(
+        "Pipeline an m_axi port of the top task with AXI register stages, given "
+        "as `PORT=STAGES`.  By default, ports placed in `--floorplan` get one "
+        "stage per relay level to their farthest user.  Can be repeated."
+    ),
+)
+@click.option(
+    "--fifo-impl",
+    "fifo_impls",
+    type=str,
+    multiple=True,
+    help=(
+        "Implement the FIFO of a stream in `srl`, `lutram`, `bram`, or `uram`, "
+        "given as `STREAM=IMPL`, where `STREAM` is the stream name optionally "
+        "qualified by its task as `Task.stream`.  Other FIFOs are implemented "
+        "in the memory that costs the fewest resources.  Can be repeated."
+    ),
+)
+@click.option(
+    "--clock-2-task",
+    "clock_2_tasks",
+    type=str,
+    multiple=True,
+    help=(
+        "Run the instances of this task in the top-level task on the second "
+        "kernel clock `ap_clk_2`.  Streams between the clocks use asynchronous "
+        "FIFOs.  Can be repeated."
+    ),
+)
+@click.option(
+    "--clock-2-period",
+    type=click.FloatRange(min=0, min_open=True),
+    default=None,
+    help=(
+        "Target clock period in nanoseconds of the tasks on `ap_clk_2`.  "
+        "Defaults to the clock period of the other tasks."
+    ),
+)
+@click.option(
+    "--floorplan",
+    type=click.Path(exists=True, dir_okay=False),
+    default=None,
+    help=(
+        "JSON file that maps task instances of the top task, e.g., `Add_0`, to "
+        "slots, e.g., `SLOT_X0Y1`.  FIFOs between slots are replaced with relay "
+        "stations pipelined by the distance."
+    ),
+)
+@click.option(
+    "--auto-floorplan",
+    metavar="COLUMNSxROWS",
+    default=None,
+    help=(
+        "Partition the task instances of the top task into a grid of slots, "
+        "e.g., `1x3` for three SLRs, by their HLS area, keeping wide streams "
+        "within a slot.  Instances in `--floorplan` keep their slots.  The "
+        "result is saved as `floorplan.json` and as Vivado pblocks in "
+        "`floorplan.xdc` in the work directory."
+    ),
+)
+@click.option(
+    "--floorplan-max-util",
+    type=click.FloatRange(min=0, max=1, min_open=True),
+    default=0.7,
+    show_default=True,
+    help="Fraction of the resources of each slot that `--auto-floorplan` uses.",
+)
+@click.option(
+    "--hw-counter",
+    "hw_counters",
+    type=str,
+    multiple=True,
+    help=(
+        "Count full, empty, and transfer cycles of the streams, and beats and "
+        "stall cycles of the mmaps, of the top-level task whose names match "
+        "this glob pattern, e.g., `*` for all, in synthesizable counters read "
+        "through `s_axi_control`.  Can be repeated."
+    ),
+)
 @click.option(
     "--flow-type",
     type=click.Choice(["hls", "aie"], case_sensitive=False),
     default="hls",
     help="Flow Option: 'hls' for FPGA Fabric steps, 'aie' for Versal AIE steps.",
 )
+@click.option(
+    "--aie-array-rows",
+    type=click.IntRange(min=1),
+    default=None,
+    help=(
+        "Number of rows of the AIE array.  If specified, AIE kernels are "
+        "constrained to tiles such that connected kernels are adjacent."
+    ),
+)
+@build_trace.traced("synth")
 def synth(  # noqa: PLR0913,PLR0917
     part_num: str | None,
     platform: str | None,
@@ -86,12 +310,59 @@ def synth(  # noqa: PLR0913,PLR0917
     jobs: int | None,
     keep_hls_work_dir: bool,
     skip_hls_based_on_mtime: bool,
+    skip_hls_based_on_content: bool,
+    hls_cache_dir: str | None,
+    hls_launchers: tuple[str, ...],
+    hls_memory_budget: float | None,
+    dedup_hls: bool,
     other_hls_configs: str,
     enable_synth_util: bool,
     print_fifo_ops: bool,
+    coalesce_streams: bool,
+    free_running_detached: bool,
+    low_latency_control: bool,
+    axi_crossbar_radix: str,
+    axi_crossbar_stages: int,
+    m_axi_stages: tuple[str, ...],
+    fifo_impls: tuple[str, ...],
+    clock_2_tasks: tuple[str, ...],
+    clock_2_period: float | None,
+    floorplan: str | None,
+    auto_floorplan: str | None,
+    floorplan_max_util: float,
+    hw_counters: tuple[str, ...],
     flow_type: str,
+    aie_array_rows: int | None,
 ) -> None:
     """Synthesize the TAPA program into RTL code."""
+    # Options that change the results, which must be taken before other locals.
+    options = {
+        name: value
+        for name, value in locals().items()
+        if name not in _OPTIONS_NOT_AFFECTING_RESULTS
+    }
+    if auto_floorplan is not None:
+        try:
+            get_slots(auto_floorplan)
+        except ValueError as e:
+            raise click.BadParameter(str(e), param_hint="--auto-floorplan") from e
+    manifest = get_step_manifest()
+    analyze_key = manifest.get_key("analyze") if manifest is not None else None
+    key = None
+    if manifest is not None and analyze_key is not None:
+        key = get_key(
+            __version__,
+            analyze_key,
+            options,
+            get_file_key([floorplan]) if floorplan is not None else None,
+        )
+        if manifest.is_done("synth", key):
+            _logger.info("skipping synth; the inputs are unchanged")
+            is_pipelined("synth", True)
+            return
+    if manifest is not None:
+        manifest.invalidate("synth")
+
     program = load_tapa_program()
     settings = load_persistent_context("settings")
 
@@ -105,7 +376,24 @@ def synth(  # noqa: PLR0913,PLR0917
     settings["platform"] = platform
     settings["clock_period"] = clock_period
 
+    for task_name in clock_2_tasks:
+        if task_name not in {task.name for task in program.tasks}:
+            msg = f"--clock-2-task: task '{task_name}' not found"
+            raise click.BadParameter(msg)
+    program.clock_2_tasks = clock_2_tasks
+    program.clock_2_period = clock_2_period
+    settings["clock-2-tasks"] = list(clock_2_tasks)
+    settings["clock-2-period"] = clock_2_period
+
+    # Widened m_axi ports assume aligned buffers, as in the Vitis kernel flow
+    mmap_bus_width = settings.get("mmap-bus-width", 0)
+    if mmap_bus_width:
+        other_hls_configs += (
+            f"\nconfig_interface -m_axi_alignment_byte_size {mmap_bus_width // 8}"
+        )
+
     # Generate RTL code
+    program.free_running_detached = free_running_detached
     program.run_hls_or_aie(
         clock_period,
         part_num,
@@ -115,20 +403,75 @@ def synth(  # noqa: PLR0913,PLR0917
         keep_hls_work_dir=keep_hls_work_dir,
         flow_type=flow_type,
         platform=platform,
+        skip_based_on_content=skip_hls_based_on_content,
+        aie_array_rows=aie_array_rows,
+        hls_cache_dir=hls_cache_dir,
+        hls_launchers=hls_launchers,
+        hls_memory_budget=hls_memory_budget and int(hls_memory_budget * (1 << 30)),
+        dedup_hls=dedup_hls,
     )
     if flow_type != "aie":
-        program.generate_task_rtl(print_fifo_ops)
+        program.crossbar_radix = int(axi_crossbar_radix)
+        program.crossbar_stages = axi_crossbar_stages
+        program.m_axi_stages = parse_m_axi_stages(m_axi_stages)
+        program.fifo_impls = parse_fifo_impls(fifo_impls)
+        program.low_latency_control = low_latency_control
+        program.hw_counters = hw_counters
+        if floorplan is not None:
+            with open(floorplan, encoding="utf-8") as fp:
+                program.floorplan = json.load(fp)
+        program.generate_task_rtl(print_fifo_ops, coalesce_streams)
+        if auto_floorplan is not None:
+            try:
+                program.partition_floorplan(auto_floorplan, floorplan_max_util)
+            except ValueError as e:
+                raise click.BadParameter(str(e), param_hint="--auto-floorplan") from e
+        if mmap_bus_width:
+            program.update_graph_port_widths(load_persistent_context("graph"))
+            store_persistent_context("graph")
         if enable_synth_util:
             program.generate_post_synth_util(part_num, jobs)
-        program.generate_top_rtl(print_fifo_ops)
+        program.generate_top_rtl(print_fifo_ops, coalesce_streams)
 
         settings["synthed"] = True
         store_persistent_context("settings")
         store_persistent_context("templates_info", program.get_rtl_templates_info())
+        if manifest is not None and key is not None:
+            manifest.record("synth", key, _OUTPUTS)
 
         is_pipelined("synth", True)
 
 
+def parse_fifo_impls(fifo_impls: tuple[str, ...]) -> dict[str, str]:
+    """Parse `--fifo-impl` options into a dict from streams to implementations."""
+    result = {}
+    for fifo_impl in fifo_impls:
+        stream, _, impl = fifo_impl.partition("=")
+        if not stream or impl not in MEM_STYLES:
+            msg = (
+                f"invalid --fifo-impl '{fifo_impl}', expected `STREAM=IMPL` where "
+                f"`IMPL` is one of {', '.join(MEM_STYLES)}"
+            )
+            raise click.BadParameter(msg)
+        result[stream] = impl
+    return result
+
+
+def parse_m_axi_stages(m_axi_stages: tuple[str, ...]) -> dict[str, int]:
+    """Parse `--m-axi-stages` options into a dict from ports to stages."""
+    result = {}
+    for m_axi_stage in m_axi_stages:
+        port, _, stages = m_axi_stage.partition("=")
+        if not port or not stages.isdigit():
+            msg = (
+                f"invalid --m-axi-stages '{m_axi_stage}', expected `PORT=STAGES` "
+                "where `STAGES` is a non-negative integer"
+            )
+            raise click.BadParameter(msg)
+        result[port] = int(stages)
+    return result
+
+
 def get_device_info(
     part_num: str | None,
     platform: str | None,
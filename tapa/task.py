@@ -32,6 +32,10 @@ from tapa.instance import Instance, Port
 from tapa.util import get_addr_width, get_indexed_name, range_or_none
 from tapa.verilog.ast_utils import make_port_arg
 from tapa.verilog.axi_xbar import generate as axi_xbar_generate
+from tapa.verilog.axi_xbar import (
+    generate_register_slice as axi_xbar_generate_register_slice,
+)
+from tapa.verilog.axi_xbar import generate_tree as axi_xbar_generate_tree
 from tapa.verilog.util import wire_name
 from tapa.verilog.xilinx.axis import (
     AXIS_CONSTANTS,
@@ -55,6 +59,11 @@ from tapa.verilog.xilinx.module import Module
 
 _logger = logging.getLogger().getChild(__name__)
 
+# Suffix of the m_axi wires between a crossbar and the registers of its port.
+_M_AXI_SLICE_SUFFIX = "__slice"
+# Suffix of the m_axi wires between the upsizer of a child and the crossbar.
+_M_AXI_UPSIZER_SUFFIX = "__upsized"
+
 
 class MMapConnection(NamedTuple):
     id_width: int
@@ -143,6 +152,8 @@ class Task:  # noqa: PLR0904
         self._self_area = {}
         self._total_area = {}
         self._clock_period = decimal.Decimal(0)
+        # Whether the FSM finishes in the cycle its last child is done.
+        self.low_latency_control = False
 
     @property
     def is_upper(self) -> bool:
@@ -152,6 +163,22 @@ class Task:  # noqa: PLR0904
     def is_lower(self) -> bool:
         return self.level == Task.Level.LOWER
 
+    @property
+    def is_free_running(self) -> bool:
+        """Whether this task is synthesized without the block-level handshake."""
+        ports = self.module.ports
+        return self.is_lower and HANDSHAKE_CLK in ports and HANDSHAKE_START not in ports
+
+    @property
+    def control_latency(self) -> dict[str, int]:
+        """Cycles that the FSM of this upper-level task adds to an invocation.
+
+        `start` counts from `ap_start` of this task to `ap_start` of its
+        children, and `done` from the last `ap_done` of its children to
+        `ap_done` of this task.
+        """
+        return {"start": 1, "done": 1 if self.low_latency_control else 2}
+
     @property
     def instances(self) -> tuple[Instance, ...]:
         if self._instances is not None:
@@ -296,23 +323,59 @@ class Task:  # noqa: PLR0904
 
     @property
     def report(self) -> dict[str, dict]:
+        return self._get_report({})
+
+    def _get_report(self, reports: dict[str, dict]) -> dict[str, dict]:
+        """Return the report of this task.
+
+        Reports of tasks are memoized in `reports` by task name, so that each
+        task shared by many instances is only reported once.
+        """
+        report = reports.get(self.name)
+        if report is not None:
+            return report
+
+        # Children are reported first, and their clock periods and areas are
+        # taken from their reports instead of being recomputed recursively.
+        child_reports = {
+            task.name: task._get_report(reports)  # noqa: SLF001
+            for task in {instance.task for instance in self.instances}
+        }
+
+        clock_period = self.clock_period if self.is_lower else self._clock_period
+        for child_report in child_reports.values():
+            clock_period = max(
+                clock_period,
+                decimal.Decimal(child_report["performance"]["clock_period"]),
+            )
         performance = {
             "source": "hls",
-            "clock_period": str(self.clock_period),
+            "clock_period": str(clock_period),
         }
 
+        if self._total_area:
+            total_area = self._total_area
+        else:
+            total_area = dict(self.self_area)
+            for instance in self.instances:
+                child_area = child_reports[instance.task.name]["area"]["total"]
+                for key in total_area:
+                    total_area[key] += child_area[key]
         area = {
             "source": "synth" if self._total_area else "hls",
-            "total": self.total_area,
+            "total": total_area,
         }
 
         if self.is_upper:
+            performance["control_latency"] = self.control_latency
             performance["critical_path"] = {}
             area["breakdown"] = {}
             for instance in self.instances:
-                task_report = instance.task.report
+                task_report = child_reports[instance.task.name]
 
-                if self.clock_period == instance.task.clock_period:
+                if clock_period == decimal.Decimal(
+                    task_report["performance"]["clock_period"]
+                ):
                     performance["critical_path"].setdefault(
                         instance.task.name,
                         task_report["performance"],
@@ -323,18 +386,79 @@ class Task:  # noqa: PLR0904
                     {"count": 0, "area": task_report["area"]},
                 )["count"] += 1
 
-        return {
+        reports[self.name] = report = {
             "schema": __version__,
             "name": self.name,
             "performance": performance,
             "area": area,
         }
+        return report
 
     def get_id_width(self, port: str) -> int | None:
         if port in self.mmaps:
             return self.mmaps[port].id_width or None
+        if port in self.ports and self.ports[port].cat.is_async_mmap:
+            return self.ports[port].id_width
         return None
 
+    def get_m_axi_data_width(self, port: str) -> int:
+        """Return the data width of the m_axi interface of mmap `port`.
+
+        HLS may widen the m_axi port of a lower-level task beyond the width of
+        the element type; see `update_mmap_widths` for upper-level tasks.
+        """
+        if self.is_lower:
+            width = self.module.get_m_axi_data_width(port)
+            if width is not None:
+                return width
+        return self.ports[port].width
+
+    def update_mmap_widths(self) -> None:
+        """Set the width of mmap ports to that of the m_axi ports of children.
+
+        This must be called after the children are updated.  Children sharing
+        an mmap port may have different widths, in which case the port takes
+        the widest and the narrower children are upsized by `add_m_axi`.
+        """
+        for arg_name, mmap in self.mmaps.items():
+            widths = {
+                arg.instance.task.get_m_axi_data_width(arg.port) for arg in mmap.args
+            }
+            width = max(widths)
+            if len(widths) > 1:
+                if any(
+                    w % 8 or width % w or (width // w) & (width // w - 1)
+                    for w in widths
+                ):
+                    msg = (
+                        f"ports connected to '{self.name}.{arg_name}' have m_axi "
+                        f"data widths {sorted(widths)}, which must be whole bytes "
+                        "and power-of-2 fractions of the widest to be upsized"
+                    )
+                    raise ValueError(msg)
+                _logger.info(
+                    "ports connected to '%s.%s' have m_axi data widths %s; the "
+                    "narrower ones are upsized to %d bits",
+                    self.name,
+                    arg_name,
+                    sorted(widths),
+                    width,
+                )
+            port = self.ports[arg_name]
+            if width == port.width:
+                continue
+            if mmap.chan_count is not None:
+                msg = f"cannot widen the m_axi ports of hmap '{self.name}.{arg_name}'"
+                raise ValueError(msg)
+            _logger.info(
+                "m_axi port '%s.%s' is widened from %d to %d bits",
+                self.name,
+                arg_name,
+                port.width,
+                width,
+            )
+            port.width = width
+
     def get_thread_count(self, port: str) -> int:
         if port in self.mmaps:
             return self.mmaps[port].thread_count
@@ -355,12 +479,23 @@ class Task:  # noqa: PLR0904
             msg = f"{fifo_name} is not {direction} any task"
             raise ValueError(msg)
         task_name, task_idx = self.fifos[fifo_name][direction]
+        arg_name = self.get_fifo_end_name(fifo_name, direction)
         for port, arg in self.tasks[task_name][task_idx]["args"].items():
-            if arg["cat"] == self._DIR2CAT[direction] and arg["arg"] == fifo_name:
+            if arg["cat"] == self._DIR2CAT[direction] and arg["arg"] == arg_name:
                 return task_name, task_idx, port
         msg = f"task {self.name} has inconsistent metadata"
         raise ValueError(msg)
 
+    def get_fifo_end_name(self, fifo_name: str, direction: str) -> str:
+        """Get the name of the wires at the `direction` end of a given FIFO.
+
+        The lanes of a broadcast stream share the wires of their producer, which
+        are named after the broadcast stream.
+        """
+        if direction == "produced_by":
+            return self.fifos[fifo_name].get("broadcast", fifo_name)
+        return fifo_name
+
     def get_fifo_directions(self, fifo_name: str) -> list[str]:
         return [
             direction
@@ -479,7 +614,21 @@ class Task:  # noqa: PLR0904
         self,
         width_table: dict[str, int],
         files: dict[str, str],
+        crossbar_radix: int = 0,
+        crossbar_stages: int = 1,
+        register_stages: dict[str, int] | None = None,
     ) -> None:
+        """Add m_axi ports and the crossbars of mmaps shared by children.
+
+        If `crossbar_radix` is non-zero, mmaps shared by more than that many
+        children are connected via a tree of crossbars with up to that many
+        slaves each, with `crossbar_stages` register stages between levels;
+        see `tapa.verilog.axi_xbar.generate_tree`.
+
+        Each m_axi port in `register_stages` is pipelined by that many stages
+        of AXI registers between the port and its crossbar or its only child,
+        which are then connected through wires as if the mmap were shared.
+        """
         for arg_name, mmap in self.mmaps.items():  # noqa: PLR1702
             m_axi_id_width, m_axi_thread_count, args, chan_count, chan_size = mmap
             # add m_axi ports to the arg list
@@ -489,6 +638,26 @@ class Task:  # noqa: PLR0904
                     data_width=width_table[arg_name],
                     id_width=m_axi_id_width or None,
                 )
+
+            # pipeline m_axi ports if necessary
+            stages = (register_stages or {}).get(arg_name, 0)
+            if stages:
+                for arg in args:
+                    arg.shared = True
+                for idx in range_or_none(chan_count):
+                    name = get_indexed_name(arg_name, idx)
+                    self._add_m_axi_register_slice(
+                        src=(
+                            args[0].mmap_name
+                            if len(args) == 1 and chan_count is None
+                            else f"{name}{_M_AXI_SLICE_SUFFIX}"
+                        ),
+                        dst=name,
+                        stages=stages,
+                        data_width=width_table[arg_name],
+                        id_width=m_axi_id_width or 1,
+                        files=files,
+                    )
             if len(args) == 1 and chan_count is None:
                 continue
 
@@ -511,7 +680,8 @@ class Task:  # noqa: PLR0904
                 for axi_chan, axi_ports in M_AXI_PORTS.items():
                     for axi_port, direction in axi_ports:
                         name = get_indexed_name(arg_name, idx)
-                        axi_arg_name = f"{M_AXI_PREFIX}{name}_{axi_chan}{axi_port}"
+                        upstream = f"{name}{_M_AXI_SLICE_SUFFIX}" if stages else name
+                        axi_arg_name = f"{M_AXI_PREFIX}{upstream}_{axi_chan}{axi_port}"
                         axi_arg_name_raw = axi_arg_name
                         if idx is not None and axi_port == "ADDR":
                             # set mmap offset for hmap
@@ -556,21 +726,39 @@ class Task:  # noqa: PLR0904
             for idx, arg in enumerate(args):
                 wires = []
                 id_width = arg.instance.task.get_id_width(arg.port)
+                arg_width = arg.instance.task.get_m_axi_data_width(arg.port)
+                upstream = arg.mmap_name
+                if arg_width < width_table[arg_name]:
+                    # upsize narrower children before the crossbar
+                    upstream = f"{arg.mmap_name}{_M_AXI_UPSIZER_SUFFIX}"
+                    self._add_m_axi_wires(
+                        upstream, width_table[arg_name], id_width or 1
+                    )
+                    self._add_m_axi_adapter(
+                        "axi_upsizer",
+                        arg.mmap_name,
+                        upstream,
+                        {
+                            "AddrWidth": 64,
+                            "SDataWidth": arg_width,
+                            "MDataWidth": width_table[arg_name],
+                            "IdWidth": id_width or 1,
+                        },
+                    )
                 for axi_chan, axi_ports in M_AXI_PORTS.items():
                     for axi_port, direction in axi_ports:
-                        wire_name = (
-                            f"{M_AXI_PREFIX}{arg.mmap_name}_{axi_chan}{axi_port}"
-                        )
                         wires.append(
                             Wire(
-                                name=wire_name,
+                                name=f"{M_AXI_PREFIX}{arg.mmap_name}_"
+                                f"{axi_chan}{axi_port}",
                                 width=get_m_axi_port_width(
                                     port=axi_port,
-                                    data_width=width_table[arg_name],
+                                    data_width=arg_width,
                                     id_width=id_width,
                                 ),
                             ),
                         )
+                        wire_name = f"{M_AXI_PREFIX}{upstream}_{axi_chan}{axi_port}"
                         if axi_port == "ID":
                             id_width = id_width or 1
                             if id_width != s_axi_id_width and direction == "output":
@@ -588,7 +776,18 @@ class Task:  # noqa: PLR0904
 
             data_width = max(width_table[arg_name], 32)
             assert data_width in {32, 64, 128, 256, 512, 1024}
-            module_name = f"axi_crossbar_{len(args)}x{chan_count or 1}"
+            if crossbar_radix and len(args) > crossbar_radix:
+                module_name = f"axi_crossbar_tree_{len(args)}x{chan_count or 1}"
+                if f"{module_name}.v" not in files:
+                    for name, content in axi_xbar_generate_tree(
+                        ports=(len(args), chan_count or 1),
+                        name=module_name,
+                        radix=crossbar_radix,
+                        pipeline_stages=crossbar_stages,
+                    ).items():
+                        files.setdefault(name, content)
+            else:
+                module_name = f"axi_crossbar_{len(args)}x{chan_count or 1}"
             if f"{module_name}.v" not in files:
                 files[f"{module_name}.v"] = axi_xbar_generate(
                     ports=(len(args), chan_count or 1),
@@ -623,6 +822,81 @@ class Task:  # noqa: PLR0904
                 params=paramargs,
             )
 
+    def _add_m_axi_wires(self, name: str, data_width: int, id_width: int) -> None:
+        """Declare the m_axi wires of `name`."""
+        self.module.add_signals(
+            Wire(
+                name=f"{M_AXI_PREFIX}{name}_{axi_chan}{axi_port}",
+                width=get_m_axi_port_width(
+                    port=axi_port, data_width=data_width, id_width=id_width
+                ),
+            )
+            for axi_chan, axi_ports in M_AXI_PORTS.items()
+            for axi_port, _ in axi_ports
+        )
+
+    def _add_m_axi_adapter(
+        self, module_name: str, src: str, dst: str, params: dict[str, int]
+    ) -> None:
+        """Instantiate `module_name` from the m_axi of `src` to that of `dst`.
+
+        The module has `s_axi_*` and `m_axi_*` ports named like those of the
+        crossbars, and is named after `dst`.
+        """
+        portargs = [
+            make_port_arg(port="clk", arg=HANDSHAKE_CLK),
+            make_port_arg(port="rst", arg=HANDSHAKE_RST),
+        ]
+        for axi_chan, axi_ports in M_AXI_PORTS.items():
+            for axi_port, _ in axi_ports:
+                signal = f"{axi_chan.lower()}{axi_port.lower()}"
+                for prefix, name in (("s", src), ("m", dst)):
+                    portargs.append(
+                        make_port_arg(
+                            port=f"{prefix}_axi_{signal}",
+                            arg=f"{M_AXI_PREFIX}{name}_{axi_chan}{axi_port}",
+                        ),
+                    )
+        self.module.add_instance(
+            module_name=module_name,
+            instance_name=f"{module_name}__{dst}",
+            ports=portargs,
+            params=[ParamArg(k, Constant(v)) for k, v in params.items()],
+        )
+
+    def _add_m_axi_register_slice(  # noqa: PLR0913
+        self,
+        *,
+        src: str,
+        dst: str,
+        stages: int,
+        data_width: int,
+        id_width: int,
+        files: dict[str, str],
+    ) -> None:
+        """Register the m_axi wires of `src` by `stages` stages to `dst`.
+
+        The wires of `src` are declared, and `dst` is the m_axi port.
+        """
+        module_name = f"axi_register_slice_{stages}"
+        if f"{module_name}.v" not in files:
+            files[f"{module_name}.v"] = axi_xbar_generate_register_slice(
+                name=module_name, stages=stages
+            )
+        self._add_m_axi_wires(src, data_width, id_width)
+        self._add_m_axi_adapter(
+            module_name,
+            src,
+            dst,
+            {"DATA_WIDTH": data_width, "ADDR_WIDTH": 64, "ID_WIDTH": id_width},
+        )
+        _logger.info(
+            "pipelining m_axi port %s.%s with %d register stages",
+            self.name,
+            dst,
+            stages,
+        )
+
     def add_rs_pragmas_to_fsm(self) -> None:
         """Add RapidStream pragmas to the FSM module."""
         port_map_str = " ".join(
@@ -638,6 +912,8 @@ class Task:  # noqa: PLR0904
             f"ap-ctrl {port_map_str}{scalar_pragma}",
         ]
         for instance in self.instances:
+            if instance.task.is_free_running:
+                continue
             port_list = [HANDSHAKE_START]
             if not instance.is_autorun:
                 port_list.extend(HANDSHAKE_OUTPUT_PORTS)
@@ -426,3 +426,347 @@ endmodule
     )
 
     return t.render(m=m, n=n, cm=cm, cn=cn, name=name)
+
+
+# AXI signals between a master and a slave as (name, width, from master).
+_AXI_SIGNALS = (
+    ("awid", "ID", True),
+    ("awaddr", "ADDR_WIDTH", True),
+    ("awlen", "8", True),
+    ("awsize", "3", True),
+    ("awburst", "2", True),
+    ("awlock", "1", True),
+    ("awcache", "4", True),
+    ("awprot", "3", True),
+    ("awqos", "4", True),
+    ("awvalid", "1", True),
+    ("awready", "1", False),
+    ("wdata", "DATA_WIDTH", True),
+    ("wstrb", "STRB_WIDTH", True),
+    ("wlast", "1", True),
+    ("wvalid", "1", True),
+    ("wready", "1", False),
+    ("bid", "ID", False),
+    ("bresp", "2", False),
+    ("bvalid", "1", False),
+    ("bready", "1", True),
+    ("arid", "ID", True),
+    ("araddr", "ADDR_WIDTH", True),
+    ("arlen", "8", True),
+    ("arsize", "3", True),
+    ("arburst", "2", True),
+    ("arlock", "1", True),
+    ("arcache", "4", True),
+    ("arprot", "3", True),
+    ("arqos", "4", True),
+    ("arvalid", "1", True),
+    ("arready", "1", False),
+    ("rid", "ID", False),
+    ("rdata", "DATA_WIDTH", False),
+    ("rresp", "2", False),
+    ("rlast", "1", False),
+    ("rvalid", "1", False),
+    ("rready", "1", True),
+)
+
+
+# Register modules and the AXI channels they register.
+_REGISTER_CHANNELS = (("rd", ("ar", "r")), ("wr", ("aw", "w", "b")))
+
+
+def _get_channel(signal: str) -> str:
+    """Returns the AXI channel of `signal`, e.g., `ar` for `arvalid`."""
+    return signal[:2] if signal.startswith(("ar", "aw")) else signal[0]
+
+
+def _get_vector(width: str) -> str:
+    """Returns the range of a Verilog vector of `width` bits, if not a bit."""
+    if width == "1":
+        return ""
+    if width.isdigit():
+        return f"[{int(width) - 1}:0] "
+    return f"[{width}-1:0] "
+
+
+def _get_register_stage(name: str, src: str, dst: str, id_width: str) -> list[str]:
+    """Returns a stage of `axi_register_rd` and `axi_register_wr` named `name`.
+
+    The stage registers all channels from the signals prefixed with `src` to
+    those prefixed with `dst`, e.g., `s_axi_` and `m_axi_`, with skid buffers.
+    """
+    lines = []
+    for channel, prefixes in _REGISTER_CHANNELS:
+        lines.append('(* keep_hierarchy = "yes" *)')
+        lines.append(f"axi_register_{channel} #(")
+        lines.append("    .DATA_WIDTH(DATA_WIDTH),")
+        lines.append("    .ADDR_WIDTH(ADDR_WIDTH),")
+        lines.append(f"    .ID_WIDTH({id_width}),")
+        regs = [f"{p.upper()}_REG_TYPE" for p in prefixes]
+        lines.extend(f"    .{reg}(2)," for reg in regs)
+        lines[-1] = lines[-1].rstrip(",")
+        lines.append(f") {name}_{channel} (")
+        lines.extend(["    .clk(clk),", "    .rst(rst),"])
+        lines.append(f"    .s_axi_{prefixes[0]}region(4'd0),")
+        for sig, _, _ in _AXI_SIGNALS:
+            if _get_channel(sig) in prefixes:
+                lines.append(f"    .s_axi_{sig}({src}{sig}),")
+                lines.append(f"    .m_axi_{sig}({dst}{sig}),")
+        lines[-1] = lines[-1].rstrip(",")
+        lines.append(");")
+    return lines
+
+
+def generate_register_slice(name: str, stages: int) -> str:
+    """Generates `stages` stages of AXI registers from a slave to a master.
+
+    The module has the `DATA_WIDTH`, `ADDR_WIDTH`, and `ID_WIDTH` parameters,
+    and `s_axi_*` and `m_axi_*` ports named like those of the crossbars, so
+    that `Task.add_m_axi` may pipeline long paths to m_axi ports with it.
+    """
+    if stages < 1:
+        msg = f"an AXI register slice needs at least 1 stage, got {stages}"
+        raise ValueError(msg)
+    lines = [
+        "`timescale 1ns / 1ps",
+        "`default_nettype none",
+        "",
+        f"// AXI register slice with {stages} stages",
+        f"module {name} #(",
+        "    parameter DATA_WIDTH = 32,",
+        "    parameter ADDR_WIDTH = 32,",
+        "    parameter STRB_WIDTH = (DATA_WIDTH/8),",
+        "    parameter ID_WIDTH = 8",
+        ") (",
+        "    input  wire clk,",
+        "    input  wire rst,",
+    ]
+    for prefix, is_master in (("s", False), ("m", True)):
+        for sig, sig_width, from_master in _AXI_SIGNALS:
+            direction = "output" if from_master == is_master else "input "
+            vec = _get_vector("ID_WIDTH" if sig_width == "ID" else sig_width)
+            lines.append(f"    {direction} wire {vec}{prefix}_axi_{sig},")
+    lines[-1] = lines[-1].rstrip(",")
+    lines.extend([");", ""])
+
+    for stage in range(1, stages):
+        lines.extend(
+            f"wire {_get_vector('ID_WIDTH' if w == 'ID' else w)}r{stage}_axi_{sig};"
+            for sig, w, _ in _AXI_SIGNALS
+        )
+    for stage in range(1, stages + 1):
+        src = "s_axi_" if stage == 1 else f"r{stage - 1}_axi_"
+        dst = "m_axi_" if stage == stages else f"r{stage}_axi_"
+        lines.extend(_get_register_stage(f"stage{stage}", src, dst, "ID_WIDTH"))
+    lines.extend(["", "endmodule", "", "`default_nettype wire", ""])
+    return "\n".join(lines)
+
+
+def plan_tree(slave_count: int, radix: int) -> list[list[list[int]]]:
+    """Returns the groups of a crossbar tree for `slave_count` slaves.
+
+    Each level concentrates groups of up to `radix` links of the previous level
+    into one link, where level 0 has the slaves, until at most `radix` links
+    are left for the final crossbar.  Group `g` of level `l` lists the indices
+    of its links in level `l - 1` and is link `g` of level `l`.
+    """
+    if radix < 2 or radix & (radix - 1):  # noqa: PLR2004
+        msg = f"crossbar radix must be a power of 2 greater than 1, got {radix}"
+        raise ValueError(msg)
+    levels = []
+    count = slave_count
+    while count > radix:
+        levels.append(
+            [list(range(i, min(i + radix, count))) for i in range(0, count, radix)]
+        )
+        count = len(levels[-1])
+    return levels
+
+
+def generate_tree(  # noqa: C901,PLR0912,PLR0914,PLR0915
+    ports: tuple[int, int],
+    name: str,
+    radix: int = 4,
+    pipeline_stages: int = 1,
+) -> dict[str, str]:
+    """Generates a tree of small AXI crossbars for many slaves and few masters.
+
+    The tree has the parameters and ports of the wrapper from `generate` that
+    `Task.add_m_axi` uses, but the slaves are concentrated by levels of
+    crossbars with up to `radix` slaves and one master before the final
+    crossbar to the masters.  The links between levels are registered by
+    `pipeline_stages` stages of `axi_register_rd` and `axi_register_wr`.
+    Each crossbar keeps its hierarchy so that it may be placed near the
+    slaves it serves.  Since `radix` is a power of 2, the tree adds exactly
+    $clog2(S_COUNT) bits to the ID like the flat crossbar does.
+
+    Returns a dict mapping names of the files to generate to their contents.
+    """
+    m, n = ports
+    levels = plan_tree(m, radix)
+    files: dict[str, str] = {}
+    bits = (radix - 1).bit_length()
+
+    def link(level: int, idx: int) -> str:
+        return f"s{idx:02d}" if level == 0 else f"l{level}_{idx:02d}"
+
+    def registered_link(level: int, idx: int) -> str:
+        if level == 0 or pipeline_stages == 0:
+            return link(level, idx)
+        return f"{link(level, idx)}_r{pipeline_stages}"
+
+    def id_width(level: int) -> str:
+        return f"S_ID_WIDTH+{bits * level}" if level else "S_ID_WIDTH"
+
+    def width(signal_width: str, level: int) -> str:
+        if signal_width == "ID":
+            signal_width = id_width(level)
+        return _get_vector(signal_width)
+
+    def params_of(level: int, idx: int) -> tuple[str, str]:
+        if level == 0:
+            return f"S{idx:02d}_THREADS", f"S{idx:02d}_ACCEPT"
+        return f"L{level}_{idx:02d}_THREADS", f"L{level}_{idx:02d}_ISSUE"
+
+    def crossbar(
+        module_name: str,
+        instance_name: str,
+        params: list[tuple[str, str]],
+        slaves: list[str],
+        masters: list[str],
+    ) -> list[str]:
+        lines = ["(* keep_hierarchy = \"yes\" *)", f"{module_name} #("]
+        lines.extend(f"    .{k}({v})," for k, v in params)
+        lines[-1] = lines[-1].rstrip(",")
+        lines.extend([f") {instance_name} (", "    .clk(clk),", "    .rst(rst),"])
+        for prefix, wires in (("s", slaves), ("m", masters)):
+            for idx, wire in enumerate(wires):
+                lines.extend(
+                    f"    .{prefix}{idx:02d}_axi_{sig}({wire}_axi_{sig}),"
+                    for sig, _, _ in _AXI_SIGNALS
+                )
+        lines[-1] = lines[-1].rstrip(",")
+        lines.append(");")
+        return lines
+
+    lines = [
+        "`timescale 1ns / 1ps",
+        "`default_nettype none",
+        "",
+        f"// AXI {m}x{n} crossbar as a tree of crossbars with up to {radix} slaves",
+        f"module {name} #(",
+        "    parameter DATA_WIDTH = 32,",
+        "    parameter ADDR_WIDTH = 32,",
+        "    parameter STRB_WIDTH = (DATA_WIDTH/8),",
+        "    parameter S_ID_WIDTH = 8,",
+        f"    parameter M_ID_WIDTH = S_ID_WIDTH+{(m - 1).bit_length()},",
+    ]
+    for p in range(m):
+        lines.extend(
+            [
+                f"    parameter S{p:02d}_THREADS = 2,",
+                f"    parameter S{p:02d}_ACCEPT = 16,",
+            ]
+        )
+    for p in range(n):
+        lines.extend(
+            [
+                f"    parameter M{p:02d}_BASE_ADDR = 0,",
+                f"    parameter M{p:02d}_ADDR_WIDTH = 24,",
+                f"    parameter M{p:02d}_ISSUE = 4,",
+            ]
+        )
+    lines[-1] = lines[-1].rstrip(",")
+    lines.extend([") (", "    input  wire clk,", "    input  wire rst,"])
+    for prefix, count, id_param, is_master in (
+        ("s", m, "S_ID_WIDTH", False),
+        ("m", n, "M_ID_WIDTH", True),
+    ):
+        for p in range(count):
+            for sig, sig_width, from_master in _AXI_SIGNALS:
+                direction = "output" if from_master == is_master else "input "
+                vec = _get_vector(id_param if sig_width == "ID" else sig_width)
+                lines.append(f"    {direction} wire {vec}{prefix}{p:02d}_axi_{sig},")
+    lines[-1] = lines[-1].rstrip(",")
+    lines.extend([");", ""])
+
+    for level, groups in enumerate(levels, start=1):
+        for g, group in enumerate(groups):
+            threads, issue = f"L{level}_{g:02d}_THREADS", f"L{level}_{g:02d}_ISSUE"
+            members = [params_of(level - 1, i) for i in group]
+            lines.append(f"localparam {threads} = {'+'.join(t for t, _ in members)};")
+            lines.append(f"localparam {issue} = {'+'.join(a for _, a in members)};")
+            for stage in range(pipeline_stages + 1):
+                wire = link(level, g) + (f"_r{stage}" if stage else "")
+                lines.extend(
+                    f"wire {width(sig_width, level)}{wire}_axi_{sig};"
+                    for sig, sig_width, _ in _AXI_SIGNALS
+                )
+    lines.append("")
+
+    for level, groups in enumerate(levels, start=1):
+        for g, group in enumerate(groups):
+            slaves = [registered_link(level - 1, i) for i in group]
+            master = link(level, g)
+            if len(group) == 1:
+                # a single link only needs a wider ID
+                for sig, _, from_master in _AXI_SIGNALS:
+                    dst, src = master, slaves[0]
+                    if not from_master:
+                        dst, src = src, dst
+                    lines.append(f"assign {dst}_axi_{sig} = {src}_axi_{sig};")
+            else:
+                module_name = f"axi_crossbar_{len(group)}x1"
+                files.setdefault(
+                    f"{module_name}.v", generate((len(group), 1), module_name)
+                )
+                params = [
+                    ("DATA_WIDTH", "DATA_WIDTH"),
+                    ("ADDR_WIDTH", "ADDR_WIDTH"),
+                    ("S_ID_WIDTH", id_width(level - 1)),
+                    ("M_ID_WIDTH", id_width(level)),
+                ]
+                for idx, i in enumerate(group):
+                    threads, accept = params_of(level - 1, i)
+                    params.append((f"S{idx:02d}_THREADS", threads))
+                    params.append((f"S{idx:02d}_ACCEPT", accept))
+                params.append(("M00_ADDR_WIDTH", "ADDR_WIDTH"))
+                params.append(("M00_ISSUE", f"L{level}_{g:02d}_ISSUE"))
+                instance_name = f"level{level}_{g:02d}"
+                lines.extend(
+                    crossbar(module_name, instance_name, params, slaves, [master])
+                )
+            for stage in range(1, pipeline_stages + 1):
+                src = master if stage == 1 else f"{master}_r{stage - 1}"
+                dst = f"{master}_r{stage}"
+                lines.extend(
+                    _get_register_stage(
+                        dst, f"{src}_axi_", f"{dst}_axi_", id_width(level)
+                    )
+                )
+            lines.append("")
+
+    top = len(levels)
+    slaves = [registered_link(top, i) for i in range(len(levels[-1]) if levels else m)]
+    module_name = f"axi_crossbar_{len(slaves)}x{n}"
+    files.setdefault(f"{module_name}.v", generate((len(slaves), n), module_name))
+    params = [
+        ("DATA_WIDTH", "DATA_WIDTH"),
+        ("ADDR_WIDTH", "ADDR_WIDTH"),
+        ("S_ID_WIDTH", id_width(top)),
+        ("M_ID_WIDTH", "M_ID_WIDTH"),
+    ]
+    for idx in range(len(slaves)):
+        threads, accept = params_of(top, idx)
+        params.append((f"S{idx:02d}_THREADS", threads))
+        params.append((f"S{idx:02d}_ACCEPT", accept))
+    for p in range(n):
+        params.extend(
+            (f"M{p:02d}_{param}", f"M{p:02d}_{param}")
+            for param in ("BASE_ADDR", "ADDR_WIDTH", "ISSUE")
+        )
+    masters = [f"m{p:02d}" for p in range(n)]
+    lines.extend(crossbar(module_name, "root", params, slaves, masters))
+    lines.extend(["", "endmodule", "", "`default_nettype wire", ""])
+
+    files[f"{name}.v"] = "\n".join(lines)
+    return files
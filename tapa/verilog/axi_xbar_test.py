@@ -0,0 +1,75 @@
+"""Unit tests for tapa.verilog.axi_xbar."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import pytest
+
+from tapa.verilog.axi_xbar import generate_register_slice, generate_tree, plan_tree
+
+
+def test_plan_tree() -> None:
+    assert not plan_tree(4, radix=4)
+    assert plan_tree(6, radix=4) == [[[0, 1, 2, 3], [4, 5]]]
+    assert plan_tree(17, radix=4) == [
+        [[0, 1, 2, 3], [4, 5, 6, 7], [8, 9, 10, 11], [12, 13, 14, 15], [16]],
+        [[0, 1, 2, 3], [4]],
+    ]
+
+
+def test_plan_tree_rejects_invalid_radix() -> None:
+    with pytest.raises(ValueError, match="power of 2"):
+        plan_tree(8, radix=3)
+
+
+@pytest.mark.parametrize("radix", [2, 4, 8])
+def test_plan_tree_adds_as_many_id_bits_as_flat_crossbar(radix: int) -> None:
+    bits = (radix - 1).bit_length()
+    for count in range(radix + 1, 100):
+        levels = plan_tree(count, radix)
+        root_bits = (len(levels[-1]) - 1).bit_length()
+        assert bits * len(levels) + root_bits == (count - 1).bit_length()
+
+
+def test_generate_tree() -> None:
+    files = generate_tree((6, 2), name="axi_crossbar_tree_6x2", pipeline_stages=2)
+
+    assert set(files) == {
+        "axi_crossbar_4x1.v",
+        "axi_crossbar_2x1.v",
+        "axi_crossbar_2x2.v",
+        "axi_crossbar_tree_6x2.v",
+    }
+    code = files["axi_crossbar_tree_6x2.v"]
+    assert "module axi_crossbar_tree_6x2 #(" in code
+    assert ") level1_00 (" in code
+    assert ") level1_01 (" in code
+    assert ") root (" in code
+    assert ".M_ID_WIDTH(S_ID_WIDTH+2)" in code
+    assert ".S_ID_WIDTH(S_ID_WIDTH+2)" in code
+    assert code.count("axi_register_rd #(") == 4
+    assert code.count("axi_register_wr #(") == 4
+    assert ".s00_axi_arid(l1_00_r2_axi_arid)" in code
+
+
+def test_generate_register_slice() -> None:
+    code = generate_register_slice("axi_register_slice_3", stages=3)
+
+    assert "module axi_register_slice_3 #(" in code
+    assert "input  wire [ID_WIDTH-1:0] s_axi_arid," in code
+    assert "output wire [ID_WIDTH-1:0] m_axi_arid," in code
+    assert code.count("axi_register_rd #(") == 3
+    assert code.count("axi_register_wr #(") == 3
+    assert ".s_axi_araddr(s_axi_araddr)" in code
+    assert ".m_axi_araddr(r1_axi_araddr)" in code
+    assert ".s_axi_araddr(r2_axi_araddr)" in code
+    assert ".m_axi_araddr(m_axi_araddr)" in code
+    assert ") stage3_wr (" in code
+
+
+def test_generate_register_slice_rejects_no_stages() -> None:
+    with pytest.raises(ValueError, match="at least 1 stage"):
+        generate_register_slice("axi_register_slice_0", stages=0)
@@ -11,11 +11,15 @@ RapidStream Contributor License Agreement.
 """
 
 import copy
+import hashlib
+import io
+import json
 import logging
 import os
 import shutil
 import sys
 import tempfile
+import zipfile
 from collections.abc import Iterable, Iterator
 from typing import TYPE_CHECKING, BinaryIO, TextIO
 
@@ -46,6 +50,8 @@ def generate_handshake_ports(
 ) -> Iterator[PortArg]:
     yield make_port_arg(port=HANDSHAKE_CLK, arg=CLK)
     yield make_port_arg(port=HANDSHAKE_RST_N, arg=rst)
+    if instance.task.is_free_running:
+        return
     yield make_port_arg(port=HANDSHAKE_START, arg=instance.start)
     for port in HANDSHAKE_OUTPUT_PORTS:
         yield make_port_arg(
@@ -54,12 +60,14 @@ def generate_handshake_ports(
         )
 
 
-def pack(
+def pack(  # noqa: PLR0913,PLR0917
     top_name: str,
     rtl_dir: str,
     ports: "Iterable[Port]",
     part_num: str,
     output_file: str | BinaryIO,
+    cache_dir: str | None = None,
+    clock_2_ports: "Iterable[str]" = (),
 ) -> None:
     """Create a .xo file that archives all generated RTL files.
 
@@ -68,6 +76,12 @@ def pack(
 
     The .xo file is essentially a zip file, you could check the contents by
     unzip it.
+
+    If `cache_dir` is given, the .xo file packaged by Vivado is kept there. The
+    next time, if only the contents of RTL files changed, that .xo file is
+    patched with the new RTL files instead of running Vivado again.
+
+    The m_axi interfaces of `clock_2_ports` are associated with `ap_clk_2`.
     """
     port_list = []
     _logger.debug("RTL ports of %s:", top_name)
@@ -77,6 +91,39 @@ def pack(
             port_i.name = get_indexed_name(port.name, i)
             _logger.debug("  %s", port_i)
             port_list.append(port_i)
+    kernel_xml = io.StringIO()
+    print_kernel_xml(name=top_name, ports=port_list, kernel_xml=kernel_xml)
+    m_axi_names = {
+        port.name: {
+            "HAS_BURST": "0",
+            "SUPPORTS_NARROW_BURST": "0",
+        }
+        for port in port_list
+        if port.cat.is_mmap
+    }
+    clock_2_m_axi_names = [
+        get_indexed_name(port.name, i)
+        for port in ports
+        if port.name in clock_2_ports
+        for i in range_or_none(port.chan_count)
+    ]
+
+    cached_xo = None
+    key = ""
+    if cache_dir is not None:
+        cached_xo = os.path.join(cache_dir, f"{top_name}.xo")
+        key = _get_pack_key(
+            top_name,
+            rtl_dir,
+            kernel_xml.getvalue(),
+            m_axi_names,
+            part_num,
+            clock_2_m_axi_names,
+        )
+        if _patch_xo(cached_xo, key, rtl_dir, output_file):
+            _logger.info("patched RTL files into the previously packed xo file")
+            return
+
     if isinstance(output_file, str):
         xo_file = output_file
     else:
@@ -87,25 +134,24 @@ def pack(
         suffix="_kernel.xml",
         encoding="utf-8",
     ) as kernel_xml_obj:
-        print_kernel_xml(name=top_name, ports=port_list, kernel_xml=kernel_xml_obj)
+        kernel_xml_obj.write(kernel_xml.getvalue())
         kernel_xml_obj.flush()
         with PackageXo(
             xo_file=xo_file,
             top_name=top_name,
             kernel_xml=kernel_xml_obj.name,
             hdl_dir=rtl_dir,
-            m_axi_names={
-                port.name: {
-                    "HAS_BURST": "0",
-                    "SUPPORTS_NARROW_BURST": "0",
-                }
-                for port in port_list
-                if port.cat.is_mmap
-            },
+            m_axi_names=m_axi_names,
             part_num=part_num,
+            clock_2_m_axi_names=clock_2_m_axi_names,
         ) as proc:
             stdout, stderr = proc.communicate()
         if proc.returncode == 0 and os.path.exists(xo_file):
+            if cached_xo is not None:
+                os.makedirs(os.path.dirname(cached_xo), exist_ok=True)
+                shutil.copyfile(xo_file, cached_xo)
+                with open(f"{cached_xo}.sha256", "w", encoding="utf-8") as key_fp:
+                    key_fp.write(key)
             if not isinstance(output_file, str):
                 with open(xo_file, "rb") as xo_obj:
                     shutil.copyfileobj(xo_obj, output_file)
@@ -116,6 +162,94 @@ def pack(
         os.remove(xo_file)
 
 
+def _get_rtl_files(rtl_dir: str) -> dict[str, str]:
+    """Return the paths of files in `rtl_dir` relative to it, keyed by path."""
+    return {
+        os.path.relpath(os.path.join(root, filename), rtl_dir): os.path.join(
+            root, filename
+        )
+        for root, _, filenames in os.walk(rtl_dir)
+        for filename in filenames
+    }
+
+
+def _get_pack_key(
+    top_name: str,
+    rtl_dir: str,
+    kernel_xml: str,
+    m_axi_names: dict[str, dict[str, str]],
+    part_num: str,
+    clock_2_m_axi_names: list[str],
+) -> str:
+    """Return a digest of everything Vivado packaging depends on but RTL contents.
+
+    This covers the kernel interface, the set of RTL files, and the contents of
+    Tcl scripts, which are sourced when packaging.
+    """
+    digest = hashlib.sha256()
+    for item in (
+        top_name,
+        kernel_xml,
+        json.dumps(m_axi_names),
+        part_num,
+        json.dumps(clock_2_m_axi_names),
+    ):
+        digest.update(f"{item}\0".encode())
+    for relpath, path in sorted(_get_rtl_files(rtl_dir).items()):
+        digest.update(f"{relpath}\0".encode())
+        if relpath.endswith(".tcl"):
+            with open(path, "rb") as fp:
+                digest.update(fp.read())
+    return digest.hexdigest()
+
+
+def _patch_xo(
+    cached_xo: str,
+    key: str,
+    rtl_dir: str,
+    output_file: str | BinaryIO,
+) -> bool:
+    """Write `cached_xo` with RTL files replaced from `rtl_dir` to `output_file`.
+
+    Returns False without writing anything if `cached_xo` was not packaged with
+    the same `key`, or if an RTL file cannot be found in it.
+    """
+    try:
+        with open(f"{cached_xo}.sha256", encoding="utf-8") as key_fp:
+            if key_fp.read() != key:
+                return False
+        cached = zipfile.ZipFile(cached_xo)
+    except (OSError, zipfile.BadZipFile):
+        return False
+
+    # Vivado copies RTL files into the `src` directory of the packaged IP.
+    rtl_paths = [
+        path
+        for relpath, path in _get_rtl_files(rtl_dir).items()
+        if not relpath.endswith(".tcl")
+    ]
+    rtl_files = {os.path.basename(path): path for path in rtl_paths}
+    with cached:
+        if len(rtl_files) != len(rtl_paths):
+            return False  # RTL files cannot be matched by name
+        patched = {
+            info.filename: rtl_files[os.path.basename(info.filename)]
+            for info in cached.infolist()
+            if "src" in info.filename.split("/")[:-1]
+            and os.path.basename(info.filename) in rtl_files
+        }
+        if set(patched.values()) != set(rtl_files.values()):
+            return False
+        with zipfile.ZipFile(output_file, "w") as output:
+            for info in cached.infolist():
+                if info.filename in patched:
+                    with open(patched[info.filename], "rb") as fp:
+                        output.writestr(info, fp.read())
+                else:
+                    output.writestr(info, cached.read(info))
+    return True
+
+
 def print_kernel_xml(name: str, ports: "Iterable[Port]", kernel_xml: TextIO) -> None:
     """Generate kernel.xml file.
 
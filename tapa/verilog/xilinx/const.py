@@ -125,6 +125,10 @@ HANDSHAKE_DONE = "ap_done"
 HANDSHAKE_IDLE = "ap_idle"
 HANDSHAKE_READY = "ap_ready"
 
+# the second kernel clock and its reset, as named by Vitis
+HANDSHAKE_CLK_2 = "ap_clk_2"
+HANDSHAKE_RST_N_2 = "ap_rst_n_2"
+
 HANDSHAKE_INPUT_PORTS = (
     HANDSHAKE_CLK,
     HANDSHAKE_RST_N,
@@ -149,6 +153,9 @@ CLK = Identifier(HANDSHAKE_CLK)
 RST_N = Identifier(HANDSHAKE_RST_N)
 RST = Unot(RST_N)
 CLK_SENS_LIST = SensList((Sens(CLK, type=SENS_TYPE),))
+CLK_2 = Identifier(HANDSHAKE_CLK_2)
+RST_N_2 = Identifier(f"{HANDSHAKE_RST_N_2}_sync")  # synchronized to `ap_clk_2`
+RST_2 = Unot(RST_N_2)
 ALL_SENS_LIST = SensList((Sens(None, type="all"),))
 STATE = Identifier("tapa_state")
 
@@ -4,18 +4,20 @@ All rights reserved. The contributor(s) of this file has/have agreed to the
 RapidStream Contributor License Agreement.
 """
 
+import functools
 import itertools
 import logging
 import os.path
 import re
 import tempfile
-from collections.abc import Callable, Iterable, Iterator
+from collections.abc import Callable, Iterable, Iterator, Mapping
 from typing import get_args
 
 from pyverilog.ast_code_generator.codegen import ASTCodeGenerator
 from pyverilog.vparser.ast import (
     Always,
     Assign,
+    Concat,
     Constant,
     Decl,
     Description,
@@ -25,24 +27,30 @@ from pyverilog.vparser.ast import (
     Input,
     Instance,
     InstanceList,
+    IntConst,
     Ioport,
     Lvalue,
+    Minus,
     ModuleDef,
     Node,
     Output,
     ParamArg,
     Parameter,
     Paramlist,
+    Plus,
     Port,
     PortArg,
     Portlist,
     Pragma,
     Reg,
+    Rvalue,
     Source,
+    StringConst,
+    Times,
     Unot,
     Wire,
 )
-from pyverilog.vparser.parser import VerilogCodeParser
+from pyverilog.vparser.parser import VerilogCodeParser, VerilogParser
 
 from tapa.backend.xilinx import M_AXI_PREFIX
 from tapa.verilog.ast_utils import make_port_arg, make_pragma
@@ -86,6 +94,44 @@ __all__ = [
 # vitis hls generated port infixes
 FIFO_INFIXES = ("_V", "_r", "_s", "")
 
+# Verilog integer constants, e.g., `512`, `32'd512`, and `10'h1ff`.
+_INT_CONST_PATTERN = re.compile(r"(?:\d*'[sS]?([bodhBODH]))?([0-9a-fA-F_]+)")
+
+# Compiler directives that the parser handles without the preprocessor.
+_PARSER_DIRECTIVES = ("`timescale",)
+
+
+def _is_preprocessed(text: str) -> bool:
+    """Return whether `text` is unchanged by preprocessing, e.g., HLS output."""
+    return all(
+        line.lstrip().startswith(_PARSER_DIRECTIVES)
+        for line in text.splitlines()
+        if "`" in line
+    )
+
+
+@functools.cache
+def _get_parser() -> tuple[VerilogParser, tempfile.TemporaryDirectory]:
+    """Return the parser of this process and the directory of its tables.
+
+    Building a parser generates the parsing tables, which takes longer than
+    parsing a typical module, so the parser is reused for all modules.
+    """
+    output_dir = tempfile.TemporaryDirectory(prefix="pyverilog-")
+    return VerilogParser(outputdir=output_dir.name, debug=False), output_dir
+
+
+def _parse_preprocessed(text: str) -> tuple[Source, tuple[Directive, ...]]:
+    """Parse `text` that needs no preprocessing without running the preprocessor.
+
+    This avoids spawning the preprocessor and rebuilding the parser per module.
+    """
+    parser, _ = _get_parser()
+    # The lexer accumulates the directives of all parsed texts.
+    num_directives = len(parser.get_directives())
+    ast = parser.parse(text)
+    return ast, parser.get_directives()[num_directives:]
+
 
 class Module:  # noqa: PLR0904  # TODO: refactor this class
     """AST and helpers for a verilog module.
@@ -155,14 +201,23 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
                 for idx, file in enumerate(files):
                     new_files.append(gen_trimmed_file(file, idx))
                 files = new_files
-            codeparser = VerilogCodeParser(
-                files,
-                preprocess_output=os.path.join(output_dir, "preprocess.output"),
-                outputdir=output_dir,
-                debug=False,
-            )
-            self.ast: Source = codeparser.parse()
-            self.directives: tuple[Directive, ...] = codeparser.get_directives()
+            texts = []
+            for file in files:
+                with open(file, encoding="utf-8") as fp:
+                    texts.append(fp.read())
+            self.ast: Source
+            self.directives: tuple[Directive, ...]
+            if all(map(_is_preprocessed, texts)):
+                self.ast, self.directives = _parse_preprocessed("\n".join(texts))
+            else:
+                codeparser = VerilogCodeParser(
+                    files,
+                    preprocess_output=os.path.join(output_dir, "preprocess.output"),
+                    outputdir=output_dir,
+                    debug=False,
+                )
+                self.ast = codeparser.parse()
+                self.directives = codeparser.get_directives()
         self._handshake_output_ports = {}
         self._calculate_indices()
 
@@ -284,7 +339,7 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
             )
 
             if STREAM_PORT_DIRECTION[suffix] == "input":
-                # peek port
+                # peek port, which tapacc omits if the task never peeks
                 if port in ignore_peek_fifos:
                     continue
                 match = match_array_name(port)
@@ -292,11 +347,12 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
                     peek_port = f"{port}_peek"
                 else:
                     peek_port = f"{match[0]}_peek[{match[1]}]"
+                try:
+                    peek_port_name = self.get_port_of(peek_port, suffix).name
+                except Module.NoMatchingPortError:
+                    continue
                 assert arg_name
-                yield make_port_arg(
-                    port=self.get_port_of(peek_port, suffix).name,
-                    arg=arg_name,
-                )
+                yield make_port_arg(port=peek_port_name, arg=arg_name)
 
     def generate_ostream_ports(
         self,
@@ -333,6 +389,27 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
             directive for _, directive in self.directives
         ) + ASTCodeGenerator().visit(self.ast)
 
+    def get_interface(self) -> "Module":
+        """Return a module with only the parameters and IO ports of this one.
+
+        The body of a module may take much more memory than its interface, which
+        is all that the modules instantiating it need.
+        """
+        module = Module(name=self.name)
+        module_def = module._module_def  # noqa: SLF001
+        module_def.paramlist = Paramlist(self._module_def.paramlist.params)
+        module_def.portlist = Portlist(self._module_def.portlist.ports)
+        module_def.items = tuple(
+            item
+            for item in self._module_def.items
+            if isinstance(item, Decl)
+            and any(
+                isinstance(x, Input | Output | Inout | Parameter) for x in item.list
+            )
+        )
+        module._calculate_indices()  # noqa: SLF001
+        return module
+
     def get_template_code(self) -> str:
         module = None
         # Find the module definition
@@ -564,6 +641,25 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
 
         self._filter(func, "instance")
 
+    def connect_instance_ports(
+        self, instance_name: str, ports: Mapping[str, str | Node]
+    ) -> "Module":
+        """Connect `ports` of instance `instance_name` to other arguments."""
+        for item in self._module_def.items:
+            if not isinstance(item, InstanceList):
+                continue
+            for instance in item.instances:
+                if instance.name == instance_name:
+                    instance.portlist = tuple(
+                        make_port_arg(x.portname, ports[x.portname])
+                        if x.portname in ports
+                        else x
+                        for x in instance.portlist
+                    )
+                    return self
+        msg = f"instance {instance_name} not found in {self.name}"
+        raise ValueError(msg)
+
     def add_rs_pragmas(self) -> "Module":
         """Add RapidStream pragmas for existing ports.
 
@@ -598,11 +694,30 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
         rst: Node,
         width: Constant,
         depth: int,
+        level: int = 0,
+        mem_style: str = "auto",
+        clk: Node = CLK,
+        read_clk: Node | None = None,
     ) -> "Module":
+        """Add a FIFO, or a relay station of `level` pipeline levels if nonzero.
+
+        Relay stations have the same ports as FIFOs and reserve the almost-full
+        margin that their pipeline levels need on top of `depth`. `mem_style`
+        is the Vivado `ram_style` of the FIFO memory, which relay stations pick
+        on their own.
+
+        If `read_clk` is given, the FIFO is an asynchronous FIFO that is written
+        on `clk` and read on `read_clk`, and `level` and `mem_style` are ignored.
+        `rst` must be synchronous to `clk`.
+        """
         name = sanitize_array_name(name)
 
         def ports() -> Iterator[PortArg]:
-            yield make_port_arg(port="clk", arg=CLK)
+            if read_clk is None:
+                yield make_port_arg(port="clk", arg=clk)
+            else:
+                yield make_port_arg(port="wr_clk", arg=clk)
+                yield make_port_arg(port="rd_clk", arg=read_clk)
             yield make_port_arg(port="reset", arg=rst)
             for port_name, arg_suffix in zip(FIFO_READ_PORTS, ISTREAM_SUFFIXES):
                 yield make_port_arg(port=port_name, arg=wire_name(name, arg_suffix))
@@ -612,12 +727,116 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
                 yield make_port_arg(port=port_name, arg=wire_name(name, arg_suffix))
             yield make_port_arg(port=FIFO_WRITE_PORTS[-1], arg=TRUE)
 
-        module_name = "fifo"
+        module_name = "relay_station" if level else "fifo"
+        if read_clk is not None:
+            module_name, level, mem_style = "fifo_async", 0, "auto"
+        params = (
+            ParamArg(paramname="DATA_WIDTH", argname=width),
+            ParamArg(
+                paramname="ADDR_WIDTH",
+                argname=Constant(max(1, (depth - 1).bit_length())),
+            ),
+            ParamArg(paramname="DEPTH", argname=Constant(depth)),
+        )
+        if level:
+            params += (ParamArg(paramname="LEVEL", argname=Constant(level)),)
+        elif mem_style != "auto":
+            params += (
+                ParamArg(paramname="MEM_STYLE", argname=StringConst(mem_style)),
+            )
         return self.add_instance(
             module_name=module_name,
             instance_name=name,
             ports=ports(),
+            params=params,
+        )
+
+    def add_coalesced_fifo_instance(
+        self,
+        name: str,
+        rst: Node,
+        lanes: dict[str, int],
+        depth: int,
+    ) -> "Module":
+        """Add a FIFO shared by the streams in `lanes`, mapped to their widths.
+
+        The first lane occupies the least significant bits of the data bus.
+        """
+        lane_names = [sanitize_array_name(lane) for lane in lanes]
+        offsets = list(itertools.accumulate(lanes.values(), initial=0))
+
+        def concat(suffix: str) -> Concat:
+            return Concat(
+                tuple(Identifier(wire_name(x, suffix)) for x in reversed(lane_names))
+            )
+
+        def ports() -> Iterator[PortArg]:
+            yield make_port_arg(port="clk", arg=CLK)
+            yield make_port_arg(port="reset", arg=rst)
+            for port_name, arg_suffix in zip(FIFO_READ_PORTS, ISTREAM_SUFFIXES):
+                yield make_port_arg(port=port_name, arg=concat(arg_suffix))
+            yield make_port_arg(port=FIFO_READ_PORTS[-1], arg=TRUE)
+            for port_name, arg_suffix in zip(FIFO_WRITE_PORTS, OSTREAM_SUFFIXES):
+                yield make_port_arg(port=port_name, arg=concat(arg_suffix))
+            yield make_port_arg(port=FIFO_WRITE_PORTS[-1], arg=TRUE)
+
+        return self.add_instance(
+            module_name="fifo_coalesced",
+            instance_name=name,
+            ports=ports(),
+            params=(
+                ParamArg(paramname="LANES", argname=Constant(len(lanes))),
+                ParamArg(paramname="DATA_WIDTH", argname=Constant(offsets[-1])),
+                ParamArg(
+                    paramname="ADDR_WIDTH",
+                    argname=Constant(max(1, (depth - 1).bit_length())),
+                ),
+                ParamArg(paramname="DEPTH", argname=Constant(depth)),
+                ParamArg(
+                    paramname="LANE_OFFSET",
+                    argname=Concat(
+                        tuple(IntConst(f"32'd{x}") for x in reversed(offsets[:-1]))
+                    ),
+                ),
+            ),
+        )
+
+    def add_broadcast_fifo_instance(  # noqa: PLR0913,PLR0917
+        self,
+        name: str,
+        rst: Node,
+        lanes: Iterable[str],
+        width: Node,
+        depth: int,
+        clk: Node = CLK,
+    ) -> "Module":
+        """Add a FIFO written through `name` and read by each of `lanes`.
+
+        The first lane occupies the least significant bits of the read ports.
+        """
+        lane_names = [sanitize_array_name(lane) for lane in lanes]
+
+        def concat(suffix: str) -> Concat:
+            return Concat(
+                tuple(Identifier(wire_name(x, suffix)) for x in reversed(lane_names))
+            )
+
+        def ports() -> Iterator[PortArg]:
+            yield make_port_arg(port="clk", arg=clk)
+            yield make_port_arg(port="reset", arg=rst)
+            for port_name, arg_suffix in zip(FIFO_READ_PORTS, ISTREAM_SUFFIXES):
+                yield make_port_arg(port=port_name, arg=concat(arg_suffix))
+            yield make_port_arg(port=FIFO_READ_PORTS[-1], arg=TRUE)
+            for port_name, arg_suffix in zip(FIFO_WRITE_PORTS, OSTREAM_SUFFIXES):
+                yield make_port_arg(port=port_name, arg=wire_name(name, arg_suffix))
+            yield make_port_arg(port=FIFO_WRITE_PORTS[-1], arg=TRUE)
+
+        return self.add_instance(
+            module_name="fifo_broadcast",
+            instance_name=f"{name}_broadcast",
+            ports=ports(),
             params=(
+                ParamArg(paramname="CONSUMERS", argname=Constant(len(lane_names))),
                 ParamArg(paramname="DATA_WIDTH", argname=width),
                 ParamArg(
                     paramname="ADDR_WIDTH",
@@ -637,7 +856,16 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
         buffer_size: int | None = None,
         max_wait_time: int = 3,
         max_burst_len: int | None = None,
+        id_width: int | None = None,
+        reorder_buffer_size: int | None = None,
     ) -> "Module":
+        """Instantiate an async_mmap for the mmap `name`.
+
+        `max_burst_len` is the AXI burst length, i.e., beats minus 1. If
+        `id_width` is set, read bursts are issued with up to 2**`id_width`
+        distinct IDs, and the read data are reordered in a buffer of
+        `reorder_buffer_size` beats, by default enough for all of them.
+        """
         paramargs = [
             ParamArg(paramname="DataWidth", argname=Constant(data_width)),
             ParamArg(
@@ -678,6 +906,9 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
         if max_burst_len is None:
             # 1KB burst length
             max_burst_len = max(0, 8192 // data_width - 1)
+        if not 0 <= max_burst_len <= 255:  # noqa: PLR2004
+            msg = f"async_mmap burst length must be within [1, 256]: {name}"
+            raise ValueError(msg)
         paramargs.extend(
             (
                 ParamArg(paramname="BurstLenWidth", argname=Constant(9)),
@@ -685,6 +916,28 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
             ),
         )
 
+        if id_width is not None:
+            if reorder_buffer_size is None:
+                reorder_buffer_size = (max_burst_len + 1) << id_width
+            # Round up to a power of 2 that holds at least one burst.
+            reorder_buffer_size_log = (
+                max(reorder_buffer_size, max_burst_len + 1) - 1
+            ).bit_length()
+            paramargs.extend(
+                (
+                    ParamArg(paramname="IdWidth", argname=Constant(id_width)),
+                    ParamArg(paramname="EnableReorder", argname=Constant(1)),
+                    ParamArg(
+                        paramname="ReorderBufferSize",
+                        argname=Constant(1 << reorder_buffer_size_log),
+                    ),
+                    ParamArg(
+                        paramname="ReorderBufferSizeLog",
+                        argname=Constant(reorder_buffer_size_log),
+                    ),
+                ),
+            )
+
         for channel, ports in M_AXI_PORTS.items():
             for port, _direction in ports:
                 portargs.append(
@@ -721,6 +974,46 @@ class Module:  # noqa: PLR0904  # TODO: refactor this class
                 return port_name
         return None
 
+    def get_m_axi_data_width(self, name: str) -> int | None:
+        """Return the data width of m_axi port `name`, or None if not found.
+
+        HLS declares the width of m_axi data ports with module parameters,
+        which are resolved to the values they are declared with.
+        """
+        port = self.ports.get(f"{M_AXI_PREFIX}{name}_RDATA")
+        if port is None or port.width is None:
+            return None
+        return self._eval_int(port.width.msb) - self._eval_int(port.width.lsb) + 1
+
+    def set_param_value(self, name: str, value: int) -> int:
+        """Set parameter `name` to `value` and return its previous value."""
+        param = self.params[name]
+        old_value = self._eval_int(param.value)
+        param.value = Rvalue(Constant(value))
+        return old_value
+
+    def _eval_int(self, node: Node) -> int:
+        """Evaluate constant integer expression `node` in this module."""
+        if isinstance(node, Rvalue):
+            return self._eval_int(node.var)
+        if isinstance(node, Constant):
+            match = _INT_CONST_PATTERN.fullmatch(str(node.value))
+            if match is None:
+                msg = f"unsupported integer constant `{node.value}`"
+                raise ValueError(msg)
+            base = {"b": 2, "o": 8, "d": 10, "h": 16}[(match[1] or "d").lower()]
+            return int(match[2].replace("_", ""), base)
+        if isinstance(node, Identifier) and node.name in self.params:
+            return self._eval_int(self.params[node.name].value)
+        if isinstance(node, Plus):
+            return self._eval_int(node.left) + self._eval_int(node.right)
+        if isinstance(node, Minus):
+            return self._eval_int(node.left) - self._eval_int(node.right)
+        if isinstance(node, Times):
+            return self._eval_int(node.left) * self._eval_int(node.right)
+        msg = f"`{ASTCodeGenerator().visit(node)}` is not a constant in {self.name}"
+        raise ValueError(msg)
+
     def add_m_axi(
         self,
         name: str,
@@ -9,7 +9,9 @@ RapidStream Contributor License Agreement.
 from pathlib import Path
 
 import pytest
+from pyverilog.vparser.ast import Constant, Identifier
 
+from tapa.verilog.xilinx.const import RST
 from tapa.verilog.xilinx.module import Module
 
 _TESTDATA_PATH = (Path(__file__).parent / "testdata").resolve()
@@ -91,6 +93,14 @@ def test_lower_level_task_module() -> None:
 
     assert module.find_port(prefix="istream", suffix="_dout") == "istream_s_dout"
 
+    # Streams that are never peeked have no peek ports.
+    module.del_ports(["istream_peek_empty_n", "istream_peek_read"])
+    assert [x.portname for x in module.generate_istream_ports("istream", "arg")] == [
+        "istream_s_dout",
+        "istream_s_empty_n",
+        "istream_s_read",
+    ]
+
 
 def test_upper_level_task_module() -> None:
     module = Module(
@@ -106,6 +116,18 @@ def test_upper_level_task_module() -> None:
     assert module.params == {}
 
 
+def test_get_interface() -> None:
+    module = Module(files=[str(_TESTDATA_PATH / "UpperLevelTask.v")])
+    interface = module.get_interface()
+
+    assert interface.name == module.name
+    assert list(interface.ports) == list(module.ports)
+    assert list(interface.params) == list(module.params)
+    assert not interface.signals
+    assert "always" not in interface.code
+    assert "assign" not in interface.code
+
+
 def test_add_m_axi() -> None:
     module = Module(name="foo")
 
@@ -135,3 +157,116 @@ def test_add_m_axi() -> None:
             "m_axi_bar_BVALID",
         }
     )
+
+
+def test_get_m_axi_data_width(tmp_path: Path) -> None:
+    rtl = tmp_path / "foo.v"
+    rtl.write_text(
+        """
+module foo #(
+  parameter C_M_AXI_BAR_DATA_WIDTH = 512
+) (
+  input wire [C_M_AXI_BAR_DATA_WIDTH - 1:0] m_axi_bar_RDATA,
+  input wire [31:0] m_axi_baz_RDATA
+);
+endmodule
+""",
+        encoding="utf-8",
+    )
+    module = Module(files=[str(rtl)])
+
+    assert module.get_m_axi_data_width("bar") == 512
+    assert module.get_m_axi_data_width("baz") == 32
+    assert module.get_m_axi_data_width("qux") is None
+
+    module.add_m_axi(name="qux", data_width=256)
+
+    assert module.get_m_axi_data_width("qux") == 256
+
+
+def test_add_async_mmap_instance_with_reorder() -> None:
+    module = Module(name="foo")
+    module.add_async_mmap_instance(
+        name="bar",
+        tags=["read_addr", "read_data"],
+        rst=RST,
+        data_width=512,
+        max_burst_len=15,
+        id_width=3,
+    )
+
+    code = "".join(module.code.split())
+    assert ".MaxBurstLen(15)" in code
+    assert ".IdWidth(3)" in code
+    assert ".EnableReorder(1)" in code
+    assert ".ReorderBufferSize(128)" in code
+    assert ".ReorderBufferSizeLog(7)" in code
+
+
+def test_add_async_mmap_instance_rejects_long_bursts() -> None:
+    module = Module(name="foo")
+    with pytest.raises(ValueError, match="burst length"):
+        module.add_async_mmap_instance(
+            name="bar",
+            tags=["read_addr", "read_data"],
+            rst=RST,
+            data_width=32,
+            max_burst_len=256,
+        )
+
+
+def test_add_fifo_instance_with_level() -> None:
+    module = Module(name="foo")
+    module.add_fifo_instance(name="bar", rst=RST, width=Constant(32), depth=2, level=3)
+
+    code = "".join(module.code.split())
+    assert "relay_station#(" in code
+    assert ".LEVEL(3)" in code
+    assert ".DEPTH(2)" in code
+
+
+def test_add_fifo_instance_with_mem_style() -> None:
+    module = Module(name="foo")
+    module.add_fifo_instance(
+        name="bar", rst=RST, width=Constant(512), depth=32, mem_style="shiftreg"
+    )
+
+    code = "".join(module.code.split())
+    assert "fifo#(" in code
+    assert '.MEM_STYLE("shiftreg")' in code
+
+
+def test_add_fifo_instance_with_read_clk() -> None:
+    module = Module(name="foo")
+    module.add_fifo_instance(
+        name="bar",
+        rst=RST,
+        width=Constant(32),
+        depth=2,
+        level=3,
+        read_clk=Identifier("ap_clk_2"),
+    )
+
+    code = "".join(module.code.split())
+    assert "fifo_async#(" in code
+    assert ".rd_clk(ap_clk_2)" in code
+    assert ".LEVEL(" not in code
+
+
+def test_connect_instance_ports() -> None:
+    module = Module(name="foo")
+    module.add_fifo_instance(name="bar", rst=RST, width=Constant(32), depth=2)
+    module.connect_instance_ports("bar", {"if_din": "baz"})
+
+    code = "".join(module.code.split())
+    assert ".if_din(baz)" in code
+    assert ".if_dout(bar__dout)" in code
+    with pytest.raises(ValueError, match="instance qux not found"):
+        module.connect_instance_ports("qux", {})
+
+
+def test_set_param_value() -> None:
+    module = Module(files=[str(_TESTDATA_PATH / "UpperLevelTask.v")])
+
+    assert module.set_param_value("ap_ST_fsm_state2", 4) == 2
+    assert "ap_ST_fsm_state2=4;" in "".join(module.code.split())
@@ -4,19 +4,60 @@
 
 #include "stream.h"
 
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "clang/AST/AST.h"
 
+using std::map;
+using std::set;
+using std::string;
+using std::unordered_map;
 using std::vector;
 
+using clang::AbstractConditionalOperator;
+using clang::ArraySubscriptExpr;
+using clang::ASTContext;
+using clang::BinaryOperator;
+using clang::BreakStmt;
 using clang::ClassTemplateSpecializationDecl;
+using clang::CompoundAssignOperator;
+using clang::CompoundStmt;
+using clang::ContinueStmt;
+using clang::CXXForRangeStmt;
 using clang::CXXMemberCallExpr;
+using clang::CXXOperatorCallExpr;
+using clang::CXXThrowExpr;
+using clang::DeclRefExpr;
+using clang::DeclStmt;
+using clang::DoStmt;
+using clang::Expr;
+using clang::ForStmt;
+using clang::GotoStmt;
+using clang::IfStmt;
+using clang::LabelStmt;
+using clang::LambdaExpr;
 using clang::QualType;
+using clang::ReturnStmt;
 using clang::Stmt;
+using clang::SwitchCase;
+using clang::SwitchStmt;
 using clang::Type;
+using clang::UnaryOperator;
+using clang::ValueDecl;
+using clang::VarDecl;
+using clang::WhileStmt;
 
 using llvm::dyn_cast;
+using llvm::dyn_cast_or_null;
 
 // Given a Stmt, find all tapa::istream and tapa::ostream operations via DFS and
 // update stream_ops.
@@ -53,6 +94,404 @@ vector<const CXXMemberCallExpr*> GetTapaStreamOps(const Stmt* stmt) {
   return stream_ops;
 }
 
+vector<const CXXMemberCallExpr*> GetTapaStreamsVecOps(const Stmt* stmt) {
+  static const auto* const kVecOps = new set<string>{
+      "read_vec",
+      "try_read_vec",
+      "write_vec",
+      "try_write_vec",
+  };
+  vector<const CXXMemberCallExpr*> ops;
+  if (stmt == nullptr) return ops;
+  if (const auto op = dyn_cast<CXXMemberCallExpr>(stmt);
+      op != nullptr && IsTapaType(op->getRecordDecl(), "(i|o)?streams") &&
+      kVecOps->count(op->getMethodDecl()->getNameAsString()) > 0) {
+    ops.push_back(op);
+  }
+  for (const auto child : stmt->children()) {
+    const auto child_ops = GetTapaStreamsVecOps(child);
+    ops.insert(ops.end(), child_ops.begin(), child_ops.end());
+  }
+  return ops;
+}
+
+namespace {
+
+// Streams accessed by a statement, and the number of tokens transferred if it
+// accesses a single stream a bounded number of times.
+struct StreamOpSummary {
+  set<string> streams;
+  int64_t count = 0;  // -1 if unknown.
+
+  bool IsBounded() const { return streams.size() == 1 && count >= 0; }
+};
+
+// Returns the summary of `first` followed by `second`.
+StreamOpSummary Concat(StreamOpSummary first, const StreamOpSummary& second) {
+  const bool is_bounded = first.count >= 0 && second.count >= 0;
+  first.streams.insert(second.streams.begin(), second.streams.end());
+  first.count = is_bounded && first.streams.size() <= 1
+                    ? first.count + second.count
+                    : -1;
+  return first;
+}
+
+// Returns the name of the stream a transfer is called on, or "" if the stream
+// is not a variable, e.g., an element of `tapa::istreams`.
+string GetStreamName(const CXXMemberCallExpr* op) {
+  const auto stream = dyn_cast<DeclRefExpr>(
+      op->getImplicitObjectArgument()->IgnoreParenImpCasts());
+  return stream == nullptr ? "" : stream->getDecl()->getNameAsString();
+}
+
+bool IsTransfer(const CXXMemberCallExpr* op) {
+  static const auto* const kTransfers = new set<string>{
+      "read", "try_read", "write", "try_write", "open", "try_open", "close",
+      "try_close",
+  };
+  return IsStreamInterface(op->getRecordDecl()) &&
+         kTransfers->count(op->getMethodDecl()->getNameAsString()) > 0;
+}
+
+const ValueDecl* GetVar(const Expr* expr) {
+  const auto ref = dyn_cast_or_null<DeclRefExpr>(expr->IgnoreParenImpCasts());
+  return ref == nullptr ? nullptr : ref->getDecl();
+}
+
+// Returns the trip count of loops like `for (int i = begin; i < end; ++i)`
+// with constant `begin` and `end`, or -1.
+int64_t GetConstantTripCount(const ForStmt* loop, const ASTContext& context) {
+  const ValueDecl* var = nullptr;
+  const Expr* begin = nullptr;
+  if (const auto init = dyn_cast_or_null<DeclStmt>(loop->getInit())) {
+    if (init->isSingleDecl()) {
+      if (const auto decl = dyn_cast<VarDecl>(init->getSingleDecl())) {
+        var = decl;
+        begin = decl->getInit();
+      }
+    }
+  } else if (const auto assign =
+                 dyn_cast_or_null<BinaryOperator>(loop->getInit())) {
+    if (assign->getOpcode() == BinaryOperator::Opcode::BO_Assign) {
+      var = GetVar(assign->getLHS());
+      begin = assign->getRHS();
+    }
+  }
+  if (var == nullptr || begin == nullptr) return -1;
+
+  const auto cond = dyn_cast_or_null<BinaryOperator>(loop->getCond());
+  if (cond == nullptr || GetVar(cond->getLHS()) != var) return -1;
+
+  bool is_unit_step = false;
+  if (const auto inc = dyn_cast_or_null<UnaryOperator>(loop->getInc())) {
+    is_unit_step = inc->isIncrementOp() && GetVar(inc->getSubExpr()) == var;
+  } else if (const auto inc =
+                 dyn_cast_or_null<CompoundAssignOperator>(loop->getInc())) {
+    Expr::EvalResult step;
+    is_unit_step = inc->getOpcode() == BinaryOperator::Opcode::BO_AddAssign &&
+                   GetVar(inc->getLHS()) == var &&
+                   inc->getRHS()->EvaluateAsInt(step, context) &&
+                   step.Val.getInt() == 1;
+  }
+  if (!is_unit_step) return -1;
+
+  Expr::EvalResult begin_val;
+  Expr::EvalResult end_val;
+  if (!begin->EvaluateAsInt(begin_val, context) ||
+      !cond->getRHS()->EvaluateAsInt(end_val, context)) {
+    return -1;
+  }
+  int64_t trip_count = end_val.Val.getInt().getExtValue() -
+                       begin_val.Val.getInt().getExtValue();
+  switch (cond->getOpcode()) {
+    case BinaryOperator::Opcode::BO_LT:
+    case BinaryOperator::Opcode::BO_NE:
+      break;
+    case BinaryOperator::Opcode::BO_LE:
+      ++trip_count;
+      break;
+    default:
+      return -1;
+  }
+  return std::max<int64_t>(trip_count, 0);
+}
+
+// Records the tokens transferred by `summary` in `bursts` if bounded.
+void RecordBurst(const StreamOpSummary& summary,
+                 unordered_map<string, int64_t>& bursts) {
+  if (summary.IsBounded() && summary.count > 0 &&
+      !summary.streams.begin()->empty()) {
+    auto& burst = bursts[*summary.streams.begin()];
+    burst = std::max(burst, summary.count);
+  }
+}
+
+StreamOpSummary SummarizeStreamOps(const Stmt* stmt, const ASTContext& context,
+                                   unordered_map<string, int64_t>& bursts) {
+  StreamOpSummary summary;
+  if (stmt == nullptr) {
+    return summary;
+  }
+
+  if (const auto block = dyn_cast<CompoundStmt>(stmt)) {
+    // Consecutive statements accessing the same single stream form a burst.
+    StreamOpSummary burst;
+    for (const auto child : block->body()) {
+      const StreamOpSummary child_summary =
+          SummarizeStreamOps(child, context, bursts);
+      summary = Concat(std::move(summary), child_summary);
+      if (child_summary.streams.empty()) continue;
+      if (child_summary.IsBounded() && burst.IsBounded() &&
+          burst.streams == child_summary.streams) {
+        burst.count += child_summary.count;
+      } else {
+        RecordBurst(burst, bursts);
+        burst = child_summary;
+      }
+    }
+    RecordBurst(burst, bursts);
+    return summary;
+  }
+
+  if (llvm::isa<ForStmt, WhileStmt, DoStmt>(stmt)) {
+    for (const auto child : stmt->children()) {
+      summary = Concat(std::move(summary),
+                       SummarizeStreamOps(child, context, bursts));
+    }
+    const auto loop = dyn_cast<ForStmt>(stmt);
+    const int64_t trip_count =
+        loop == nullptr ? -1 : GetConstantTripCount(loop, context);
+    if (trip_count < 0 || !summary.IsBounded() ||
+        (trip_count > 0 &&
+         summary.count > std::numeric_limits<int64_t>::max() / trip_count)) {
+      summary.count = -1;
+    } else {
+      summary.count *= trip_count;
+    }
+    return summary;
+  }
+
+  for (const auto child : stmt->children()) {
+    summary =
+        Concat(std::move(summary), SummarizeStreamOps(child, context, bursts));
+  }
+  if (const auto op = dyn_cast<CXXMemberCallExpr>(stmt);
+      op != nullptr && IsTransfer(op)) {
+    summary = Concat(std::move(summary), {{GetStreamName(op)}, 1});
+  }
+  return summary;
+}
+
+}  // namespace
+
+unordered_map<string, int64_t> GetTapaStreamBursts(const Stmt* body,
+                                                   const ASTContext& context) {
+  unordered_map<string, int64_t> bursts;
+  RecordBurst(SummarizeStreamOps(body, context, bursts), bursts);
+  return bursts;
+}
+
+namespace {
+
+// A blocking stream operation, and the innermost statement list or branch that
+// executes it. Operations with the same `scope` run equally often.
+struct StreamAccess {
+  const Stmt* scope;
+  unsigned index;  // Index of the statement in `scope` that contains it.
+  string method;
+};
+
+bool IsLockstepCandidate(const CXXMemberCallExpr* op) {
+  if (!IsStreamInterface(op->getRecordDecl())) return false;
+  const string method = op->getMethodDecl()->getNameAsString();
+  if (method == "write") return op->getNumArgs() == 1;
+  return (method == "read" || method == "open" || method == "close") &&
+         op->getNumArgs() == 0;
+}
+
+// Returns whether control may enter or leave `stmt` other than sequentially.
+bool HasJumpOrLabel(const Stmt* stmt) {
+  if (stmt == nullptr) return false;
+  if (llvm::isa<BreakStmt, ContinueStmt, CXXThrowExpr, GotoStmt, LabelStmt,
+                ReturnStmt, SwitchCase>(stmt)) {
+    return true;
+  }
+  return std::any_of(stmt->child_begin(), stmt->child_end(), HasJumpOrLabel);
+}
+
+// Collects blocking operations on streams referenced by name in `stmt`, and
+// the streams referenced in any other way.
+void CollectStreamAccesses(const Stmt* stmt, const Stmt* scope, unsigned index,
+                           map<string, vector<StreamAccess>>& accesses,
+                           set<string>& others) {
+  if (stmt == nullptr) return;
+
+  if (const auto block = dyn_cast<CompoundStmt>(stmt)) {
+    unsigned child_index = 0;
+    for (const auto child : block->body()) {
+      CollectStreamAccesses(child, block, child_index++, accesses, others);
+    }
+    return;
+  }
+
+  // Each branch of a conditional and the body of a loop is a separate scope.
+  const auto binary = dyn_cast<BinaryOperator>(stmt);
+  if (llvm::isa<AbstractConditionalOperator, CXXForRangeStmt, DoStmt, ForStmt,
+                IfStmt, LambdaExpr, SwitchStmt, WhileStmt>(stmt) ||
+      (binary != nullptr && binary->isLogicalOp())) {
+    for (const auto child : stmt->children()) {
+      CollectStreamAccesses(child, child, 0, accesses, others);
+    }
+    return;
+  }
+
+  if (const auto op = dyn_cast<CXXMemberCallExpr>(stmt);
+      op != nullptr && IsLockstepCandidate(op)) {
+    if (const string name = GetStreamName(op); !name.empty()) {
+      accesses[name].push_back(
+          {scope, index, op->getMethodDecl()->getNameAsString()});
+      for (const auto arg : op->arguments()) {
+        CollectStreamAccesses(arg, scope, index, accesses, others);
+      }
+      return;
+    }
+  }
+
+  if (const auto ref = dyn_cast<DeclRefExpr>(stmt)) {
+    others.insert(ref->getDecl()->getNameAsString());
+  }
+  for (const auto child : stmt->children()) {
+    CollectStreamAccesses(child, scope, index, accesses, others);
+  }
+}
+
+using StreamAccesses = map<string, vector<StreamAccess>>::value_type;
+
+// Returns whether no jump or label separates the accesses of `group` that
+// share a scope.
+bool IsStraightLine(const vector<const StreamAccesses*>& group) {
+  for (size_t i = 0; i < group.front()->second.size(); ++i) {
+    const auto block = dyn_cast<CompoundStmt>(group.front()->second[i].scope);
+    if (block == nullptr) continue;
+    unsigned first = std::numeric_limits<unsigned>::max();
+    unsigned last = 0;
+    for (const auto stream : group) {
+      first = std::min(first, stream->second[i].index);
+      last = std::max(last, stream->second[i].index);
+    }
+    for (unsigned j = first; j < last; ++j) {
+      if (HasJumpOrLabel(block->body_begin()[j])) return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+vector<vector<string>> GetTapaLockstepStreams(const Stmt* body) {
+  map<string, vector<StreamAccess>> accesses;
+  set<string> others;
+  CollectStreamAccesses(body, body, 0, accesses, others);
+
+  // Streams accessed in the same scopes in the same order, at most once per
+  // scope, transfer tokens in lockstep.
+  map<vector<std::pair<const Stmt*, string>>, vector<const StreamAccesses*>>
+      groups;
+  for (const auto& stream : accesses) {
+    if (others.count(stream.first) > 0) continue;
+    vector<std::pair<const Stmt*, string>> signature;
+    set<const Stmt*> scopes;
+    for (const auto& access : stream.second) {
+      signature.emplace_back(access.scope, access.method);
+      scopes.insert(access.scope);
+    }
+    if (scopes.size() == stream.second.size()) {
+      groups[signature].push_back(&stream);
+    }
+  }
+
+  vector<vector<string>> lockstep_streams;
+  for (const auto& [signature, group] : groups) {
+    if (group.size() > 1 && IsStraightLine(group)) {
+      auto& names = lockstep_streams.emplace_back();
+      for (const auto stream : group) names.push_back(stream->first);
+    }
+  }
+  return lockstep_streams;
+}
+
+namespace {
+
+// Methods of `tapa::istream` and `tapa::istreams` that never access the peek
+// port of the stream.
+bool IsNonPeekingMethod(const string& method) {
+  static const auto* const kMethods = new set<string>{
+      "empty",
+      "try_read",
+      "read",
+      "read_n",
+      "read_transaction",
+      "try_open",
+      "open",
+      "try_read_vec",
+      "read_vec",
+  };
+  return kMethods->count(method) > 0;
+}
+
+// Returns the variable `expr` refers to as a stream, i.e., `var` in `var` or
+// `var[i]`, or null.
+const ValueDecl* GetStreamVar(const Expr* expr) {
+  expr = expr->IgnoreImplicit()->IgnoreParens()->IgnoreImplicit();
+  if (const auto subscript = dyn_cast<ArraySubscriptExpr>(expr)) {
+    expr = subscript->getBase();
+  } else if (const auto op = dyn_cast<CXXOperatorCallExpr>(expr);
+             op != nullptr && op->getOperator() == clang::OO_Subscript) {
+    expr = op->getArg(0);
+  }
+  expr = expr->IgnoreImplicit()->IgnoreParens()->IgnoreImplicit();
+  if (const auto ref = dyn_cast<DeclRefExpr>(expr)) return ref->getDecl();
+  return nullptr;
+}
+
+// Counts references to `var` in `stmt`, and those that call a non-peeking
+// method on it.
+void CountStreamUses(const Stmt* stmt, const ValueDecl* var, int& uses,
+                     int& non_peeking_uses) {
+  if (stmt == nullptr) return;
+  if (const auto op = dyn_cast<CXXMemberCallExpr>(stmt);
+      op != nullptr && op->getMethodDecl() != nullptr &&
+      IsNonPeekingMethod(op->getMethodDecl()->getNameAsString()) &&
+      GetStreamVar(op->getImplicitObjectArgument()) == var) {
+    ++non_peeking_uses;
+  }
+  if (const auto ref = dyn_cast<DeclRefExpr>(stmt);
+      ref != nullptr && ref->getDecl() == var) {
+    ++uses;
+  }
+  for (const auto child : stmt->children()) {
+    CountStreamUses(child, var, uses, non_peeking_uses);
+  }
+}
+
+}  // namespace
+
+bool IsStreamPeeked(const clang::ParmVarDecl* param) {
+  const auto func = dyn_cast<clang::FunctionDecl>(param->getDeclContext());
+  const clang::FunctionDecl* definition = nullptr;
+  if (func == nullptr || !func->hasBody(definition)) return true;
+
+  // The body refers to the parameters of the definition, which may not be the
+  // declaration `param` belongs to.
+  const unsigned index = param->getFunctionScopeIndex();
+  if (index >= definition->getNumParams()) return true;
+  int uses = 0;
+  int non_peeking_uses = 0;
+  CountStreamUses(definition->getBody(), definition->getParamDecl(index), uses,
+                  non_peeking_uses);
+  return uses > non_peeking_uses;
+}
+
 const ClassTemplateSpecializationDecl* GetTapaStreamDecl(const Type* type) {
   if (type != nullptr) {
     if (const auto record = type->getAsRecordDecl()) {
@@ -90,3 +529,17 @@ const ClassTemplateSpecializationDecl* GetTapaStreamsDecl(
   return GetTapaStreamsDecl(
       qual_type.getUnqualifiedType().getCanonicalType().getTypePtr());
 }
+
+const ClassTemplateSpecializationDecl* GetTapaBroadcastStreamDecl(
+    const QualType& qual_type) {
+  const auto type =
+      qual_type.getUnqualifiedType().getCanonicalType().getTypePtr();
+  if (const auto record = type->getAsRecordDecl()) {
+    if (const auto decl = dyn_cast<ClassTemplateSpecializationDecl>(record)) {
+      if (IsTapaType(decl, "broadcast_stream")) {
+        return decl;
+      }
+    }
+  }
+  return nullptr;
+}
@@ -29,9 +29,35 @@ const clang::ClassTemplateSpecializationDecl* GetTapaStreamsDecl(
     const clang::Type* type);
 const clang::ClassTemplateSpecializationDecl* GetTapaStreamsDecl(
     const clang::QualType& qual_type);
+const clang::ClassTemplateSpecializationDecl* GetTapaBroadcastStreamDecl(
+    const clang::QualType& qual_type);
 std::vector<const clang::CXXMemberCallExpr*> GetTapaStreamOps(
     const clang::Stmt* stmt);
 
+// Returns calls of `read_vec`, `try_read_vec`, `write_vec`, and
+// `try_write_vec` on `tapa::istreams` and `tapa::ostreams` in `stmt`.
+std::vector<const clang::CXXMemberCallExpr*> GetTapaStreamsVecOps(
+    const clang::Stmt* stmt);
+
+// Returns, for each stream accessed by name in `body`, the largest number of
+// tokens transferred on it without any transfer on other streams in between,
+// if that number is statically bounded. Loops count as their constant trip
+// count times the tokens transferred per iteration.
+std::unordered_map<std::string, int64_t> GetTapaStreamBursts(
+    const clang::Stmt* body, const clang::ASTContext& context);
+
+// Returns groups of streams accessed by name in `body` that always transfer
+// tokens together: each stream in a group is only accessed by blocking
+// operations, which appear in the same statement lists in the same order, at
+// most once per list, with no jumps in between.
+std::vector<std::vector<std::string>> GetTapaLockstepStreams(
+    const clang::Stmt* body);
+
+// Returns whether the leaf task that has `param`, a `tapa::istream` or
+// `tapa::istreams` parameter, may peek it. Streams passed to other functions
+// are assumed to be peeked.
+bool IsStreamPeeked(const clang::ParmVarDecl* param);
+
 template <typename T>
 inline bool IsStreamInterface(T obj) {
   return IsTapaType(obj, "(i|o)stream");
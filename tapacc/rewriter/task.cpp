@@ -4,6 +4,8 @@
 
 #include "task.h"
 
+#include <algorithm>
+#include <iterator>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -25,6 +27,7 @@ using std::unordered_map;
 using std::vector;
 
 using clang::CharSourceRange;
+using clang::ClassTemplateSpecializationDecl;
 using clang::CXXBindTemporaryExpr;
 using clang::CXXMemberCallExpr;
 using clang::CXXMethodDecl;
@@ -252,6 +255,26 @@ bool Visitor::VisitAttributedStmt(clang::AttributedStmt* stmt) {
   return clang::RecursiveASTVisitor<Visitor>::VisitAttributedStmt(stmt);
 }
 
+// Add the non-default tunables in the `tapa::async_mmap_config` of an
+// async_mmap `param` to its port `metadata`.
+static void AddAsyncMmapConfig(const clang::ParmVarDecl* param,
+                               json& metadata) {
+  const auto* decl = llvm::dyn_cast_or_null<ClassTemplateSpecializationDecl>(
+      param->getType().getNonReferenceType()->getAsRecordDecl());
+  if (decl == nullptr || decl->getTemplateArgs().size() < 2) return;
+  const auto* config = llvm::dyn_cast_or_null<ClassTemplateSpecializationDecl>(
+      decl->getTemplateArgs()[1].getAsType()->getAsRecordDecl());
+  if (config == nullptr) return;
+  const auto& args = config->getTemplateArgs();
+  const char* keys[] = {"max_outstanding", "max_burst_len", "buffer_size",
+                        "reorder_buffer_size"};
+  for (size_t i = 0; i < std::size(keys) && i < args.size(); ++i) {
+    if (int64_t value = args[i].getAsIntegral().getExtValue(); value != 0) {
+      metadata[keys[i]] = value;
+    }
+  }
+}
+
 void Visitor::ProcessTaskPorts(const FunctionDecl* func,
                                nlohmann::json& metadata) {
   for (const auto param : func->parameters()) {
@@ -267,12 +290,14 @@ void Visitor::ProcessTaskPorts(const FunctionDecl* func,
       } else {
         cat = "mmap";
       }
-      metadata["ports"].push_back(
-          {{"name", name},
-           {"cat", cat},
-           {"width",
-            GetTypeWidth(GetTemplateArg(param->getType(), 0)->getAsType())},
-           {"type", GetMmapElemType(param) + "*"}});
+      json port = {
+          {"name", name},
+          {"cat", cat},
+          {"width",
+           GetTypeWidth(GetTemplateArg(param->getType(), 0)->getAsType())},
+          {"type", GetMmapElemType(param) + "*"}};
+      if (cat == "async_mmap") AddAsyncMmapConfig(param, port);
+      metadata["ports"].push_back(port);
     };
     // TODO: extend to support streams as well
     auto add_stream_meta = [&](const string& name) {
@@ -353,6 +378,19 @@ void Visitor::ProcessUpperLevelTask(const ExprWithCleanups* task,
             metadata["fifos"][var_name]["depth"] = fifo_depth;
             fifo_decls[var_name] = var_decl;
           }
+        } else if (auto decl =
+                       GetTapaBroadcastStreamDecl(var_decl->getType())) {
+          // Each consumer reads a lane of the broadcast stream, and its
+          // producer writes all lanes at once.
+          const auto args = decl->getTemplateArgs().asArray();
+          const uint64_t fifo_depth = *args[2].getAsIntegral().getRawData();
+          const string broadcast_name = var_decl->getNameAsString();
+          for (int i = 0; i < GetArraySize(decl); ++i) {
+            const string var_name = ArrayNameAt(broadcast_name, i);
+            metadata["fifos"][var_name]["depth"] = fifo_depth;
+            metadata["fifos"][var_name]["broadcast"] = broadcast_name;
+            fifo_decls[var_name] = var_decl;
+          }
         }
       }
     }
@@ -396,7 +434,7 @@ void Visitor::ProcessUpperLevelTask(const ExprWithCleanups* task,
     string task_name;
     auto get_name = [&](const string& name, uint64_t i,
                         const DeclRefExpr* decl_ref) -> string {
-      if (IsTapaType(decl_ref, "(mmaps|(i|o)?streams)")) {
+      if (IsTapaType(decl_ref, "(mmaps|(i|o)?streams|broadcast_stream)")) {
         const auto ts_type =
             decl_ref->getType()->getAs<TemplateSpecializationType>();
         assert(ts_type != nullptr);
@@ -555,11 +593,19 @@ void Visitor::ProcessUpperLevelTask(const ExprWithCleanups* task,
               register_arg(arg);
             } else if (IsTapaType(param, "ostream")) {
               param_cat = "ostream";
-              // vector invocation can map ostreams to ostream
-              auto arg =
-                  get_name(arg_name, ostreams_access_pos[arg_name]++, decl_ref);
-              register_producer(arg);
-              register_arg(arg);
+              if (IsTapaType(decl_ref, "broadcast_stream")) {
+                // the producer of a broadcast stream writes all of its lanes
+                for (int i = 0; i < GetArraySize(decl_ref->getType()); ++i) {
+                  register_producer(ArrayNameAt(arg_name, i));
+                }
+                register_arg();
+              } else {
+                // vector invocation can map ostreams to ostream
+                auto arg = get_name(arg_name, ostreams_access_pos[arg_name]++,
+                                    decl_ref);
+                register_producer(arg);
+                register_arg(arg);
+              }
             } else if (IsTapaType(param, "istreams")) {
               param_cat = "istream";
               for (int i = 0; i < GetArraySize(param); ++i) {
@@ -648,6 +694,30 @@ void Visitor::ProcessLowerLevelTask(const FunctionDecl* func) {
 
   auto& metadata = GetMetadata();
   ProcessTaskPorts(func, metadata);
+
+  // Record how many tokens each stream port may transfer in a row, which is
+  // how many its FIFO must hold for the task to move on to other ports.
+  const auto bursts = GetTapaStreamBursts(func->getBody(), context_);
+  for (auto& port : metadata["ports"]) {
+    if (port["cat"] != "istream" && port["cat"] != "ostream") continue;
+    if (auto burst = bursts.find(port["name"].get<string>());
+        burst != bursts.end()) {
+      port["burst"] = burst->second;
+    }
+  }
+
+  // Streams in the same lockstep group may share a FIFO with their peers.
+  const auto lockstep_streams = GetTapaLockstepStreams(func->getBody());
+  for (size_t group = 0; group < lockstep_streams.size(); ++group) {
+    for (auto& port : metadata["ports"]) {
+      if ((port["cat"] == "istream" || port["cat"] == "ostream") &&
+          std::count(lockstep_streams[group].begin(),
+                     lockstep_streams[group].end(),
+                     port["name"].get<string>()) > 0) {
+        port["lockstep"] = group;
+      }
+    }
+  }
 }
 
 void Visitor::ProcessOtherFunc(const FunctionDecl* func) {
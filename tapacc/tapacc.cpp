@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <regex>
 #include <set>
 #include <string>
@@ -18,6 +19,8 @@
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Tooling.h"
 
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "nlohmann/json.hpp"
@@ -43,13 +46,17 @@ using clang::ASTContext;
 using clang::ASTFrontendAction;
 using clang::CompilerInstance;
 using clang::FunctionDecl;
+using clang::ParmVarDecl;
+using clang::RewriteBuffer;
 using clang::Rewriter;
 using clang::StringRef;
 using clang::tooling::ClangTool;
 using clang::tooling::CommonOptionsParser;
 using clang::tooling::newFrontendActionFactory;
 
+using llvm::hardware_concurrency;
 using llvm::raw_string_ostream;
+using llvm::ThreadPool;
 using llvm::cl::NumOccurrencesFlag;
 using llvm::cl::OptionCategory;
 using llvm::cl::ValueExpected;
@@ -61,6 +68,9 @@ namespace internal {
 
 const string* top_name;
 bool vitis_mode = true;
+unsigned jobs = 0;
+unsigned mmap_bus_width = 0;
+bool specialize_constants = false;
 
 class Consumer : public ASTConsumer {
  public:
@@ -130,16 +140,34 @@ class Consumer : public ASTConsumer {
     for (auto task : tapa_tasks_) {
       visitor_.VisitTask(task);
     }
-    unordered_map<const FunctionDecl*, string> code_table;
+    if (specialize_constants) SpecializeLowerLevelTasks(context);
+
+    // Each task is emitted as a full copy of the rewritten translation unit,
+    // which dominates the run time of designs with many tasks. The rewriters
+    // are independent of each other and are only read from here on, so they
+    // are serialized concurrently. The traversals above stay sequential since
+    // `ASTContext` is not thread-safe.
+    vector<const RewriteBuffer*> buffers;
+    for (auto task : tapa_tasks_) {
+      buffers.push_back(&rewriters_[task].getEditBuffer(
+          context.getSourceManager().getMainFileID()));
+    }
+    vector<string> code_table(buffers.size());
+    ThreadPool pool(hardware_concurrency(jobs));
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      pool.async([buffer = buffers[i], &task_code = code_table[i]] {
+        raw_string_ostream oss{task_code};
+        buffer->write(oss);
+        oss.flush();
+      });
+    }
+    pool.wait();
+
     json code;
+    size_t task_index = 0;
     for (auto task : tapa_tasks_) {
       auto task_name = task->getNameAsString();
-      raw_string_ostream oss{code_table[task]};
-      rewriters_[task]
-          .getEditBuffer(rewriters_[task].getSourceMgr().getMainFileID())
-          .write(oss);
-      oss.flush();
-      code["tasks"][task_name]["code"] = code_table[task];
+      code["tasks"][task_name]["code"] = std::move(code_table[task_index++]);
       // if a task is non-synthesizable, it is a lower-level task.
       bool is_upper = GetTapaTask(task->getBody()) != nullptr &&
                       !IsTaskNonSynthesizable(task);
@@ -151,6 +179,86 @@ class Consumer : public ASTConsumer {
   }
 
  private:
+  // Specializes each lower-level task on its scalar parameters that every
+  // invocation passes the same compile-time constant to, by assigning the
+  // constant to the parameter at the beginning of the task, so that HLS
+  // propagates it through the body, e.g., into loop trip counts. The ports
+  // are kept, so the interfaces and connections of tasks do not change.
+  // Ports that the task never uses are reported.
+  void SpecializeLowerLevelTasks(ASTContext& context) {
+    // Constant passed to each scalar port of each task, or `nullopt` if some
+    // invocation passes something else.
+    unordered_map<string, unordered_map<string, std::optional<string>>>
+        constants;
+    for (auto task : tapa_tasks_) {
+      const json& metadata = metadata_[task];
+      if (!metadata.contains("tasks")) continue;
+      for (const auto& [child_name, instances] : metadata["tasks"].items()) {
+        for (const auto& instance : instances) {
+          if (!instance.contains("args")) continue;
+          for (const auto& [port, arg] : instance["args"].items()) {
+            if (arg["cat"] != "scalar") continue;
+            std::optional<string> value;
+            if (const string name = arg["arg"]; name.rfind("64'd", 0) == 0) {
+              value = name.substr(4);
+            }
+            auto [it, is_new] = constants[child_name].try_emplace(port, value);
+            if (!is_new && it->second != value) it->second = std::nullopt;
+          }
+        }
+      }
+    }
+
+    auto& diagnostics = context.getDiagnostics();
+    static const auto specialized_id = diagnostics.getCustomDiagID(
+        clang::DiagnosticsEngine::Remark,
+        "task '%0' is specialized on '%1' = %2");
+    static const auto unused_id = diagnostics.getCustomDiagID(
+        clang::DiagnosticsEngine::Remark,
+        "port '%0' of task '%1' is never used");
+    for (auto task : tapa_tasks_) {
+      const string task_name = task->getNameAsString();
+      const bool is_lower = GetTapaTask(task->getBody()) == nullptr ||
+                            IsTaskNonSynthesizable(task);
+      if (task_name == *top_name || !is_lower) continue;
+      const auto task_constants = constants.find(task_name);
+      for (const ParmVarDecl* param : task->parameters()) {
+        const string name = param->getNameAsString();
+        if (!param->isReferenced()) {
+          auto diagnostics_builder =
+              diagnostics.Report(param->getLocation(), unused_id);
+          diagnostics_builder.AddString(name);
+          diagnostics_builder.AddString(task_name);
+          continue;
+        }
+        if (task_constants == constants.end()) continue;
+        const auto constant = task_constants->second.find(name);
+        if (constant == task_constants->second.end() ||
+            !constant->second.has_value()) {
+          continue;
+        }
+        // Only parameters that can be assigned to are specialized.
+        const auto type = param->getType();
+        if (type->isReferenceType() || type.isConstQualified() ||
+            !type->isIntegralOrEnumerationType()) {
+          continue;
+        }
+        rewriters_[task].InsertTextAfterToken(
+            task->getBody()->getBeginLoc(),
+            "\n" + name + " = static_cast<decltype(" + name + ")>(" +
+                *constant->second + "ULL);\n");
+        for (auto& port : metadata_[task]["ports"]) {
+          if (port["name"] == name) port["constant"] = *constant->second;
+        }
+        auto diagnostics_builder =
+            diagnostics.Report(param->getLocation(), specialized_id);
+        diagnostics_builder.AddString(task_name);
+        diagnostics_builder.AddString(name);
+        diagnostics_builder.AddString(*constant->second);
+      }
+    }
+  }
+
   Visitor visitor_;
   vector<const FunctionDecl*>& funcs_;
   set<const FunctionDecl*>& tapa_tasks_;
@@ -181,6 +289,23 @@ static llvm::cl::opt<string> tapa_opt_top_name(
 static llvm::cl::opt<bool> tapa_opt_vitis_mode(
     "vitis", llvm::cl::desc("Enable Vitis mode"),
     llvm::cl::cat(tapa_option_category));
+static llvm::cl::opt<unsigned> tapa_opt_jobs(
+    "jobs",
+    llvm::cl::desc("Number of threads emitting the rewritten code of tasks; "
+                   "0 uses all hardware threads"),
+    llvm::cl::init(0), llvm::cl::cat(tapa_option_category));
+static llvm::cl::opt<unsigned> tapa_opt_mmap_bus_width(
+    "mmap-bus-width",
+    llvm::cl::desc("Let HLS widen the m_axi ports of lower-level mmaps up to "
+                   "this many bits and burst on them; 0 keeps the width of "
+                   "the element type"),
+    llvm::cl::init(0), llvm::cl::cat(tapa_option_category));
+static llvm::cl::opt<bool> tapa_opt_specialize_constants(
+    "specialize-constants",
+    llvm::cl::desc("Specialize lower-level tasks on scalar arguments that all "
+                   "invocations pass the same constant to, and report ports "
+                   "that are never used"),
+    llvm::cl::cat(tapa_option_category));
 
 int main(int argc, const char** argv) {
   auto expected_parser =
@@ -190,6 +315,10 @@ int main(int argc, const char** argv) {
   string top_name{tapa_opt_top_name.getValue()};
   tapa::internal::top_name = &top_name;
   tapa::internal::vitis_mode = tapa_opt_vitis_mode.getValue();
+  tapa::internal::jobs = tapa_opt_jobs.getValue();
+  tapa::internal::mmap_bus_width = tapa_opt_mmap_bus_width.getValue();
+  tapa::internal::specialize_constants =
+      tapa_opt_specialize_constants.getValue();
   int ret = tool.run(newFrontendActionFactory<tapa::internal::Action>().get());
   return ret;
 }
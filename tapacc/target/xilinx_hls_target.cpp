@@ -8,6 +8,7 @@
 #include "../rewriter/stream.h"
 #include "../rewriter/type.h"
 
+#include <algorithm>
 #include <cctype>
 #include <string>
 
@@ -20,6 +21,7 @@ namespace tapa {
 namespace internal {
 
 extern bool vitis_mode;
+extern unsigned mmap_bus_width;
 
 static void AddDummyStreamRW(ADD_FOR_PARAMS_ARGS_DEF, bool qdma) {
   auto param_name = param->getNameAsString();
@@ -205,16 +207,22 @@ void XilinxHLSTarget::AddCodeForLowerLevelStream(ADD_FOR_PARAMS_ARGS_DEF) {
     names.push_back(name);
   }
 
+  // Peek ports of streams the task never peeks are left unused, so that HLS
+  // removes them.
+  const bool is_peeked =
+      IsTapaType(param, "istreams?") && IsStreamPeeked(param);
   for (const auto& name : names) {
     const auto fifo_var = GetFifoVar(name);
     add_pragma({"HLS interface ap_fifo port =", fifo_var});
     add_pragma({"HLS aggregate variable =", fifo_var, "bit"});
     if (IsTapaType(param, "istreams?")) {
-      const auto peek_var = GetPeekVar(name);
-      add_pragma({"HLS interface ap_fifo port =", peek_var});
-      add_pragma({"HLS aggregate variable =", peek_var, "bit"});
+      if (is_peeked) {
+        const auto peek_var = GetPeekVar(name);
+        add_pragma({"HLS interface ap_fifo port =", peek_var});
+        add_pragma({"HLS aggregate variable =", peek_var, "bit"});
+      }
       add_line("void(" + name + "._.empty());");
-      add_line("void(" + name + "._peek.empty());");
+      if (is_peeked) add_line("void(" + name + "._peek.empty());");
     } else {
       add_line("void(" + name + "._.full());");
     }
@@ -262,8 +270,22 @@ void XilinxHLSTarget::AddCodeForLowerLevelMmap(ADD_FOR_PARAMS_ARGS_DEF) {
   }
 
   const auto name = param->getNameAsString();
-  add_pragma(
-      {"HLS interface m_axi port =", name, "offset = direct bundle =", name});
+  if (mmap_bus_width == 0) {
+    add_pragma(
+        {"HLS interface m_axi port =", name, "offset = direct bundle =", name});
+    return;
+  }
+
+  // Let HLS widen sequential accesses to the bus width, and make bursts as
+  // long as an AXI burst may be without crossing a 4 KiB boundary.
+  const auto width = std::to_string(mmap_bus_width);
+  const auto burst_len =
+      std::to_string(std::min(256u, 4096 * 8 / mmap_bus_width));
+  add_pragma({"HLS interface m_axi port =", name, "offset = direct bundle =",
+              name, "max_widen_bitwidth =", width,
+              "max_read_burst_length =", burst_len,
+              "max_write_burst_length =", burst_len,
+              "num_read_outstanding = 16 num_write_outstanding = 16"});
 }
 
 void XilinxHLSTarget::RewriteTopLevelFunc(REWRITE_FUNC_ARGS_DEF) {
@@ -319,16 +341,42 @@ static void RewriteStreamDefinitions(REWRITE_FUNC_ARGS_DEF) {
   }
 }
 
+// Arrays of streams have no member functions in HLS, so calls like
+// `in_q.read_vec(...)` are rewritten to `tapa::internal::read_vec(in_q, ...)`,
+// which accesses all FIFOs of the array in parallel.
+static void RewriteStreamsVecOps(REWRITE_FUNC_ARGS_DEF) {
+  for (const auto op : GetTapaStreamsVecOps(func->getBody())) {
+    const auto member = llvm::dyn_cast<clang::MemberExpr>(op->getCallee());
+    if (member == nullptr || member->getOperatorLoc().isMacroID()) continue;
+    rewriter.InsertTextBefore(member->getBase()->getBeginLoc(),
+                              "tapa::internal::" +
+                                  op->getMethodDecl()->getNameAsString() +
+                                  (member->isArrow() ? "(*" : "("));
+    if (op->getNumArgs() == 0) {
+      rewriter.ReplaceText(clang::CharSourceRange::getTokenRange(
+                               member->getOperatorLoc(), op->getRParenLoc()),
+                           ")");
+    } else {
+      rewriter.ReplaceText(
+          clang::CharSourceRange::getCharRange(member->getOperatorLoc(),
+                                               op->getArg(0)->getBeginLoc()),
+          ", ");
+    }
+  }
+}
+
 void XilinxHLSTarget::RewriteLowerLevelFunc(REWRITE_FUNC_ARGS_DEF) {
   auto lines = GenerateCodeForLowerLevelFunc(func);
   rewriter.InsertTextAfterToken(func->getBody()->getBeginLoc(),
                                 llvm::join(lines, "\n"));
   RewriteStreamDefinitions(REWRITE_FUNC_ARGS);
+  RewriteStreamsVecOps(REWRITE_FUNC_ARGS);
 }
 
 void XilinxHLSTarget::RewriteOtherFunc(REWRITE_FUNC_ARGS_DEF) {
   BaseTarget::RewriteOtherFunc(REWRITE_FUNC_ARGS);
   RewriteStreamDefinitions(REWRITE_FUNC_ARGS);
+  RewriteStreamsVecOps(REWRITE_FUNC_ARGS);
 }
 
 void XilinxHLSTarget::RewriteTopLevelFuncArguments(REWRITE_FUNC_ARGS_DEF) {
@@ -29,10 +29,12 @@ int main(int argc, char* argv[]) {
     }
   }
 
-  tapa::invoke(Bandwidth, FLAGS_bitstream,
-               tapa::read_write_mmaps<float, kBankCount>(chan)
-                   .vectorized<Elem::length>(),
-               n, flags);
+  int64_t kernel_time_ns =
+      tapa::invoke(Bandwidth, FLAGS_bitstream,
+                   tapa::read_write_mmaps<float, kBankCount>(chan)
+                       .vectorized<Elem::length>(),
+                   n, flags);
+  LOG(INFO) << "kernel time: " << kernel_time_ns * 1e-9 << " s";
 
   if (!((flags & kRead) && (flags & kWrite))) return 0;
 
@@ -0,0 +1,184 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+// Characterizes the memory bandwidth of a platform with the `Bandwidth`
+// kernel. Sweeps the number of elements per bank, access patterns,
+// directions, and active banks, and prints the kernel time and GB/s of each
+// configuration as CSV. With a bitstream, also prints the throughput of
+// migrating the buffers between host and device.
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "bandwidth.h"
+
+template <typename T>
+using vector = std::vector<T, tapa::aligned_allocator<T>>;
+
+DEFINE_string(bitstream, "", "path to bitstream file, run csim if empty");
+DEFINE_string(sizes, "1024,65536,1048576",
+              "comma-separated numbers of elements per bank");
+DEFINE_string(patterns, "sequential,strided,random",
+              "comma-separated access patterns");
+DEFINE_string(directions, "read,write,copy", "comma-separated directions");
+DEFINE_uint64(stride, 64, "stride in elements of the strided pattern");
+DEFINE_bool(per_bank, true, "also run with each bank active alone");
+DEFINE_int32(runs, 3, "runs of each configuration; the fastest is reported");
+
+namespace {
+
+using Channels = vector<float>[kBankCount];
+
+// Result of running the kernel once.
+struct Timing {
+  double kernel_s = std::numeric_limits<double>::infinity();
+  double load_gbps = 0;
+  double store_gbps = 0;
+};
+
+std::vector<std::string> Split(const std::string& list) {
+  std::vector<std::string> items;
+  std::istringstream is(list);
+  for (std::string item; std::getline(is, item, ',');) {
+    if (!item.empty()) items.push_back(item);
+  }
+  return items;
+}
+
+uint64_t PatternFlags(const std::string& pattern) {
+  CHECK_LT(FLAGS_stride, 1 << 16) << "stride must fit in 16 bits";
+  const std::map<std::string, uint64_t> flags = {
+      {"sequential", 0},
+      {"strided", kStrided | FLAGS_stride << kStrideShift},
+      {"random", kRandom},
+  };
+  auto it = flags.find(pattern);
+  CHECK(it != flags.end()) << "unknown pattern '" << pattern << "'";
+  return it->second;
+}
+
+uint64_t DirectionFlags(const std::string& direction) {
+  const std::map<std::string, uint64_t> flags = {
+      {"read", kRead},
+      {"write", kWrite},
+      {"copy", kRead | kWrite},
+  };
+  auto it = flags.find(direction);
+  CHECK(it != flags.end()) << "unknown direction '" << direction << "'";
+  return it->second;
+}
+
+// Returns the active bank of `banks` with a single bit set, or "all" if zero.
+std::string BankName(uint64_t banks) {
+  return banks == 0 ? "all" : std::to_string(__builtin_ctzll(banks));
+}
+
+template <size_t... Is>
+void Invoke(fpga::Instance& instance, Channels& chan, uint64_t n,
+            uint64_t flags, std::index_sequence<Is...>) {
+  instance.Invoke(
+      fpga::ReadWrite(reinterpret_cast<Elem*>(chan[Is].data()), n)..., n,
+      flags);
+}
+
+// Runs the kernel on the first `n` elements of each bank `FLAGS_runs` times
+// and returns the fastest run. `instance` is null for software simulation.
+Timing Run(fpga::Instance* instance, Channels& chan, uint64_t n,
+           uint64_t flags) {
+  Timing best;
+  for (int i = 0; i < FLAGS_runs; ++i) {
+    Timing timing;
+    if (instance == nullptr) {
+      timing.kernel_s =
+          tapa::invoke(Bandwidth, "",
+                       tapa::read_write_mmaps<float, kBankCount>(chan)
+                           .vectorized<Elem::length>(),
+                       n, flags) *
+          1e-9;
+    } else {
+      Invoke(*instance, chan, n, flags,
+             std::make_index_sequence<kBankCount>{});
+      timing.kernel_s = instance->ComputeTimeSeconds();
+      timing.load_gbps = instance->LoadThroughputGbps();
+      timing.store_gbps = instance->StoreThroughputGbps();
+    }
+    if (timing.kernel_s < best.kernel_s) best = timing;
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  std::vector<uint64_t> sizes;
+  for (const auto& size : Split(FLAGS_sizes)) {
+    sizes.push_back(std::stoull(size));
+  }
+  CHECK(!sizes.empty()) << "no sizes to sweep";
+  const uint64_t max_size = *std::max_element(sizes.begin(), sizes.end());
+
+  Channels chan;
+  for (int64_t i = 0; i < kBankCount; ++i) {
+    chan[i].resize(max_size * Elem::length);
+    for (int64_t j = 0; j < max_size * Elem::length; ++j) {
+      chan[i][j] = i ^ j;
+    }
+  }
+
+  std::unique_ptr<fpga::Instance> instance;
+  if (!FLAGS_bitstream.empty()) {
+    instance = std::make_unique<fpga::Instance>(FLAGS_bitstream);
+  }
+
+  // Active banks of each run as a mask; zero means all banks.
+  std::vector<uint64_t> bank_masks;
+  if (FLAGS_per_bank) {
+    for (int i = 0; i < kBankCount; ++i) bank_masks.push_back(1 << i);
+  }
+  bank_masks.push_back(0);
+
+  std::cout << "pattern,direction,elem_bytes,size,banks,kernel_s,gbps\n";
+  for (const auto& pattern : Split(FLAGS_patterns)) {
+    for (const auto& direction : Split(FLAGS_directions)) {
+      const uint64_t flags = PatternFlags(pattern) | DirectionFlags(direction);
+      const int passes = (flags & kRead ? 1 : 0) + (flags & kWrite ? 1 : 0);
+      for (uint64_t n : sizes) {
+        for (uint64_t banks : bank_masks) {
+          const Timing timing =
+              Run(instance.get(), chan, n, flags | banks << kBankMaskShift);
+          const int active = banks == 0 ? kBankCount : 1;
+          const double bytes = double(n) * sizeof(Elem) * passes * active;
+          std::cout << pattern << "," << direction << "," << sizeof(Elem)
+                    << "," << n << "," << BankName(banks) << ","
+                    << timing.kernel_s << ","
+                    << bytes / timing.kernel_s * 1e-9 << std::endl;
+        }
+      }
+    }
+  }
+
+  if (instance == nullptr) return 0;
+
+  // The kernel returns immediately without read or write, which leaves the
+  // migration of all banks to and from the device.
+  std::cout << "\nsize,load_gbps,store_gbps\n";
+  for (uint64_t n : sizes) {
+    const Timing timing = Run(instance.get(), chan, n, /*flags=*/0);
+    std::cout << n << "," << timing.load_gbps << "," << timing.store_gbps
+              << std::endl;
+  }
+  return 0;
+}
@@ -5,10 +5,14 @@
 #include "bandwidth.h"
 #include "lfsr.h"
 
-void Copy(tapa::async_mmap<Elem>& mem, uint64_t n, uint64_t flags) {
+void Copy(int bank, tapa::async_mmap<Elem>& mem, uint64_t n, uint64_t flags) {
   const bool random = flags & kRandom;
-  const bool read = flags & kRead;
-  const bool write = flags & kWrite;
+  const bool strided = flags & kStrided;
+  const uint64_t banks = (flags >> kBankMaskShift) & ((1 << kBankCount) - 1);
+  const bool active = banks == 0 || (banks >> bank & 1);
+  const bool read = active && (flags & kRead);
+  const bool write = active && (flags & kWrite);
+  const uint64_t stride = (flags >> kStrideShift) & 0xffffu;
 
   if (!read && !write) return;
 
@@ -20,8 +24,18 @@ void Copy(tapa::async_mmap<Elem>& mem, uint64_t n, uint64_t flags) {
     }
   }
 
+  // Strided addresses wrap around within the largest power of two <= n.
+  uint64_t wrap = n;
+  [[tapa::unroll]]  //
+  for (int i = 1; i < 64; i <<= 1) {
+    wrap |= wrap >> i;
+  }
+  wrap >>= 1;
+
   Lfsr<16> lfsr_rd = 0xbeefu;
   Lfsr<16> lfsr_wr = 0xbeefu;
+  uint64_t stride_rd = 0;
+  uint64_t stride_wr = 0;
   Elem elem;
 
   [[tapa::pipeline(1)]]  //
@@ -29,8 +43,12 @@ void Copy(tapa::async_mmap<Elem>& mem, uint64_t n, uint64_t flags) {
        write ? (i_wr_resp < n) : (i_rd_resp < n);) {
     bool can_read = !mem.read_data.empty();
     bool can_write = !mem.write_addr.full() && !mem.write_data.full();
-    int64_t read_addr = random ? uint64_t(lfsr_rd & mask) : i_rd_req;
-    int64_t write_addr = random ? uint64_t(lfsr_wr & mask) : i_wr_req;
+    int64_t read_addr = random    ? uint64_t(lfsr_rd & mask)
+                        : strided ? stride_rd & wrap
+                                  : i_rd_req;
+    int64_t write_addr = random    ? uint64_t(lfsr_wr & mask)
+                         : strided ? stride_wr & wrap
+                                   : i_wr_req;
 
     if (read
         // `i_rd_req < i_rd_resp + 50` is required for Vitis cosim on some
@@ -40,6 +58,7 @@ void Copy(tapa::async_mmap<Elem>& mem, uint64_t n, uint64_t flags) {
         mem.read_addr.try_write(read_addr)) {
       ++i_rd_req;
       ++lfsr_rd;
+      stride_rd += stride;
       VLOG(3) << "RD REQ [" << std::setw(5) << read_addr << "]";
     }
 
@@ -54,6 +73,7 @@ void Copy(tapa::async_mmap<Elem>& mem, uint64_t n, uint64_t flags) {
       mem.write_data.write(elem);
       ++i_wr_req;
       ++lfsr_wr;
+      stride_wr += stride;
       VLOG(3) << "WR REQ [" << std::setw(5) << write_addr << "]";
     }
 
@@ -65,5 +85,6 @@ void Copy(tapa::async_mmap<Elem>& mem, uint64_t n, uint64_t flags) {
 }
 
 void Bandwidth(tapa::mmaps<Elem, kBankCount> chan, uint64_t n, uint64_t flags) {
-  tapa::task().invoke<tapa::join, kBankCount>(Copy, chan, n, flags);
+  tapa::task().invoke<tapa::join, kBankCount>(Copy, tapa::seq(), chan, n,
+                                              flags);
 }
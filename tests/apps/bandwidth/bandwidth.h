@@ -9,11 +9,25 @@
 
 #include <tapa.h>
 
-using Elem = tapa::vec_t<float, 16>;
+// Build with `-DBANDWIDTH_ELEM_LENGTH=<n>` to access memory in other widths.
+#ifndef BANDWIDTH_ELEM_LENGTH
+#define BANDWIDTH_ELEM_LENGTH 16
+#endif  // BANDWIDTH_ELEM_LENGTH
+
+using Elem = tapa::vec_t<float, BANDWIDTH_ELEM_LENGTH>;
 constexpr int kBankCount = 4;
 
+// Bits of `flags`. Addresses are sequential unless `kRandom` or `kStrided`.
 constexpr uint64_t kRandom = 1 << 0;
 constexpr uint64_t kRead = 1 << 1;
 constexpr uint64_t kWrite = 1 << 2;
+constexpr uint64_t kStrided = 1 << 3;
+
+// Bits [8, 8 + kBankCount) of `flags` select the active banks; all banks are
+// active if none is selected.
+constexpr int kBankMaskShift = 8;
+
+// Bits [16, 32) of `flags` are the stride in elements if `kStrided`.
+constexpr int kStrideShift = 16;
 
 void Bandwidth(tapa::mmaps<Elem, kBankCount> chan, uint64_t n, uint64_t flags);
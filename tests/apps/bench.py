@@ -0,0 +1,305 @@
+"""Benchmark the apps in csim, fast cosim, and on board.
+
+Each app runs at several sizes in each selected mode. The median wall time,
+kernel time, achieved bandwidth, and peak memory usage of each run are saved
+as JSON, and compared against a baseline saved earlier if given.
+
+Usage with Bazel, after sourcing the Vitis settings for fast cosim:
+
+    bazel run //tests/apps:bench -- --output $PWD/bench.json
+    bazel run //tests/apps:bench-xosim -- --baseline $PWD/bench.json
+"""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import json
+import logging
+import os
+import re
+import statistics
+import subprocess
+import sys
+import time
+from collections.abc import Callable, Sequence
+from typing import NamedTuple
+
+import click
+
+_logger = logging.getLogger(__name__)
+
+_KERNEL_TIME_PATTERN = re.compile(r"kernel time: (\S+) s")
+
+# Time metrics shorter than this are too noisy to compare.
+_MIN_COMPARED_SECONDS = 0.01
+
+
+class App(NamedTuple):
+    """Arguments of an app in each mode, and its bytes accessed per run."""
+
+    # Mode to list of arguments; `{key}` is replaced by the `--data` files.
+    sizes: dict[str, list[list[str]]]
+
+    # Bytes read and written by the kernel given the arguments, if known.
+    bytes_accessed: Callable[[list[str]], int] | None = None
+
+
+def _same_sizes(*sizes: list[str]) -> dict[str, list[list[str]]]:
+    return dict.fromkeys(("csim", "xosim", "hw"), list(sizes))
+
+
+APPS = {
+    "bandwidth": App(
+        sizes={
+            "csim": [["65536"], ["1048576"]],
+            "xosim": [["1024"], ["8192"]],
+            "hw": [["1048576"], ["16777216"]],
+        },
+        # 4 banks of 16 floats per element, read and written with flags=6
+        bytes_accessed=lambda args: 2 * 4 * 64 * int(args[0]),
+    ),
+    "cannon": App(
+        sizes=_same_sizes([]),
+        bytes_accessed=lambda args: 3 * 32 * 32 * 4,
+    ),
+    "gemv": App(
+        sizes=_same_sizes([]),
+        bytes_accessed=lambda args: (2048 * 2048 + 2 * 2048) * 4,
+    ),
+    "graph": App(sizes=_same_sizes(["{graph_edges}"])),
+    "jacobi": App(
+        sizes={
+            "csim": [["100"], ["10000"]],
+            "xosim": [["100"], ["1000"]],
+            "hw": [["10000"], ["100000"]],
+        },
+        bytes_accessed=lambda args: 2 * int(args[0]) * 100 * 4,
+    ),
+    "network": App(
+        sizes=_same_sizes([]),
+        bytes_accessed=lambda args: 2 * (1 << 15) * 8,
+    ),
+    "vadd": App(
+        sizes={
+            "csim": [["65536"], ["1048576"], ["16777216"]],
+            "xosim": [["1000"], ["65536"]],
+            "hw": [["1048576"], ["67108864"]],
+        },
+        bytes_accessed=lambda args: 3 * 4 * int(args[0]),
+    ),
+}
+
+
+def _parse_pairs(pairs: Sequence[str], option: str) -> dict[str, str]:
+    result = {}
+    for pair in pairs:
+        key, sep, value = pair.partition("=")
+        if not sep:
+            msg = f"expect KEY=VALUE; got '{pair}'"
+            raise click.BadParameter(msg, param_hint=option)
+        result[key] = value
+    return result
+
+
+def _run_once(command: list[str]) -> dict:
+    """Run `command` once and return its measurements."""
+    start = time.monotonic()
+    with subprocess.Popen(
+        command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True
+    ) as proc:
+        assert proc.stdout is not None
+        output = proc.stdout.read()
+        # `wait4` also accounts for the simulators the host waited for.
+        _, status, rusage = os.wait4(proc.pid, 0)
+        proc.returncode = os.waitstatus_to_exitcode(status)
+    wall_s = time.monotonic() - start
+
+    match = _KERNEL_TIME_PATTERN.search(output)
+    passed = proc.returncode == 0 and "PASS!" in output
+    if not passed:
+        _logger.error("%s failed:\n%s", command, output[-4096:])
+    return {
+        "wall_s": wall_s,
+        "kernel_s": float(match[1]) if match else None,
+        "max_rss_mib": rusage.ru_maxrss / 1024,
+        "passed": passed,
+    }
+
+
+def _median(values: list[float | None]) -> float | None:
+    known = [x for x in values if x is not None]
+    return statistics.median(known) if known else None
+
+
+def run_benchmark(  # noqa: PLR0913,PLR0917
+    app_name: str,
+    app: App,
+    mode: str,
+    command: list[str],
+    args: list[str],
+    runs: int,
+) -> dict:
+    """Run `command` with `args` for `runs` times and return the medians."""
+    _logger.info("benchmarking %s in %s: %s", app_name, mode, args)
+    results = [_run_once(command + args) for _ in range(runs)]
+    kernel_s = _median([x["kernel_s"] for x in results])
+    gbps = None
+    if app.bytes_accessed is not None and kernel_s:
+        gbps = app.bytes_accessed(args) / kernel_s / 1e9
+    return {
+        "app": app_name,
+        "mode": mode,
+        "args": args,
+        "runs": runs,
+        "wall_s": _median([x["wall_s"] for x in results]),
+        "kernel_s": kernel_s,
+        "gbps": gbps,
+        "max_rss_mib": max(x["max_rss_mib"] for x in results),
+        "passed": all(x["passed"] for x in results),
+    }
+
+
+def _key(result: dict) -> tuple[str, str, str]:
+    return result["app"], result["mode"], " ".join(result["args"])
+
+
+def compare(results: list[dict], baseline: list[dict], threshold: float) -> int:
+    """Log results worse than `baseline` by `threshold`; return their count."""
+    baseline_by_key = {_key(x): x for x in baseline}
+    regressions = 0
+    for result in results:
+        base = baseline_by_key.get(_key(result))
+        if base is None:
+            continue
+        if base["passed"] and not result["passed"]:
+            _logger.error("%s: now fails", _key(result))
+            regressions += 1
+        for metric, higher_is_better in (
+            ("wall_s", False),
+            ("kernel_s", False),
+            ("gbps", True),
+            ("max_rss_mib", False),
+        ):
+            old, new = base.get(metric), result.get(metric)
+            if not old or new is None:
+                continue
+            if metric.endswith("_s") and max(old, new) < _MIN_COMPARED_SECONDS:
+                continue
+            change = (new - old) / old
+            if higher_is_better:
+                change = -change
+            if change > threshold:
+                _logger.error(
+                    "%s: %s regressed by %.1f%% (%.4g -> %.4g)",
+                    _key(result),
+                    metric,
+                    change * 100,
+                    old,
+                    new,
+                )
+                regressions += 1
+    return regressions
+
+
+@click.command()
+@click.option(
+    "--host",
+    "hosts",
+    multiple=True,
+    help="NAME=PATH of the host binary of an app; only these apps run.",
+)
+@click.option("--xo", "xos", multiple=True, help="NAME=PATH of an app's XO.")
+@click.option(
+    "--xclbin", "xclbins", multiple=True, help="NAME=PATH of an app's xclbin."
+)
+@click.option(
+    "--data", "data", multiple=True, help="KEY=PATH of a data file of an app."
+)
+@click.option(
+    "--mode",
+    "modes",
+    type=click.Choice(["csim", "xosim", "hw"]),
+    multiple=True,
+    default=["csim"],
+    show_default=True,
+    help="Modes to run in; `xosim` needs `--xo`, and `hw` needs `--xclbin`.",
+)
+@click.option("--xosim-executable", help="Path to `tapa-fast-cosim`.")
+@click.option("--runs", type=click.IntRange(min=1), default=3, show_default=True)
+@click.option(
+    "--output",
+    type=click.Path(dir_okay=False, writable=True),
+    help="Save the results as JSON to this file.",
+)
+@click.option(
+    "--baseline",
+    type=click.Path(exists=True, dir_okay=False),
+    help="Compare the results against those saved by `--output` earlier.",
+)
+@click.option(
+    "--threshold",
+    type=float,
+    default=0.1,
+    show_default=True,
+    help="Relative change considered a regression.",
+)
+def main(  # noqa: PLR0913,PLR0917
+    hosts: tuple[str, ...],
+    xos: tuple[str, ...],
+    xclbins: tuple[str, ...],
+    data: tuple[str, ...],
+    modes: tuple[str, ...],
+    xosim_executable: str | None,
+    runs: int,
+    output: str | None,
+    baseline: str | None,
+    threshold: float,
+) -> None:
+    """Benchmark the apps and optionally compare against a baseline."""
+    logging.basicConfig(level=logging.INFO, format="%(levelname)s: %(message)s")
+    host_paths = _parse_pairs(hosts, "--host")
+    bitstreams = {
+        "xosim": _parse_pairs(xos, "--xo"),
+        "hw": _parse_pairs(xclbins, "--xclbin"),
+    }
+    data_paths = _parse_pairs(data, "--data")
+
+    results = []
+    for app_name, host in host_paths.items():
+        app = APPS[app_name]
+        for mode in modes:
+            command = [host]
+            if mode != "csim":
+                bitstream = bitstreams[mode].get(app_name)
+                if bitstream is None:
+                    _logger.warning("skipping %s in %s: no bitstream", app_name, mode)
+                    continue
+                command.append(f"--bitstream={bitstream}")
+            if mode == "xosim" and xosim_executable:
+                command.append(f"--xosim_executable={xosim_executable}")
+            for args in app.sizes[mode]:
+                args = [x.format(**data_paths) for x in args]  # noqa: PLW2901
+                results.append(
+                    run_benchmark(app_name, app, mode, command, args, runs)
+                )
+
+    for result in results:
+        click.echo(json.dumps(result))
+    if output is not None:
+        with open(output, "w", encoding="utf-8") as fp:
+            json.dump(results, fp, indent=2)
+
+    failed = not all(x["passed"] for x in results)
+    if baseline is not None:
+        with open(baseline, encoding="utf-8") as fp:
+            regressions = compare(results, json.load(fp), threshold)
+        _logger.info("%d regressions against %s", regressions, baseline)
+        failed |= regressions > 0
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()  # pylint: disable=no-value-parameter
@@ -0,0 +1,45 @@
+#!/bin/bash
+# Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+# All rights reserved. The contributor(s) of this file has/have agreed to the
+# RapidStream Contributor License Agreement.
+
+# Compares the software simulation time of a TAPA host program under each
+# execution engine selected by TAPA_ENGINE.
+#
+# Usage: benchmark-engines.sh [-n RUNS] HOST_BINARY [ARGS...]
+#
+# The hybrid engine runs the tasks listed in TAPA_THREAD_TASKS on dedicated
+# threads; set it in the environment, e.g., TAPA_THREAD_TASKS=Add,Mmap2Stream.
+# Example for all apps, after building them with `tapa g++`:
+#
+#   for app in vadd jacobi cannon network gemv graph; do
+#     (cd $app && ../benchmark-engines.sh ./$app-host)
+#   done
+
+set -e
+
+runs=5
+if [[ "$1" == "-n" ]]; then
+  runs="$2"
+  shift 2
+fi
+if [[ $# -eq 0 ]]; then
+  echo "usage: $0 [-n RUNS] HOST_BINARY [ARGS...]" >&2
+  exit 1
+fi
+
+printf "%-10s %12s %12s\n" engine median_ms min_ms
+for engine in coroutine thread hybrid; do
+  times=()
+  for ((i = 0; i < runs; i++)); do
+    start=$(date +%s%N)
+    TAPA_ENGINE="${engine}" "$@" >/dev/null 2>&1 || {
+      echo "$* failed with TAPA_ENGINE=${engine}" >&2
+      exit 1
+    }
+    times+=($((($(date +%s%N) - start) / 1000000)))
+  done
+  sorted=($(printf "%s\n" "${times[@]}" | sort -n))
+  printf "%-10s %12s %12s\n" "${engine}" "${sorted[$((runs / 2))]}" \
+    "${sorted[0]}"
+done
@@ -104,12 +104,14 @@ int main(int argc, char* argv[]) {
     VLOG(10) << e.src << " -> " << e.dst;
   }
   VLOG(10) << "updates: " << updates.size();
-  tapa::invoke(Graph, FLAGS_bitstream, num_partitions,
-               tapa::read_only_mmap<const Vid>(num_vertices),
-               tapa::read_only_mmap<const Eid>(num_edges),
-               tapa::read_write_mmap<VertexAttr>(vertices),
-               tapa::read_only_mmap<const Edge>(edges),
-               tapa::write_only_mmap<Update>(updates));
+  int64_t kernel_time_ns =
+      tapa::invoke(Graph, FLAGS_bitstream, num_partitions,
+                   tapa::read_only_mmap<const Vid>(num_vertices),
+                   tapa::read_only_mmap<const Eid>(num_edges),
+                   tapa::read_write_mmap<VertexAttr>(vertices),
+                   tapa::read_only_mmap<const Edge>(edges),
+                   tapa::write_only_mmap<Update>(updates));
+  clog << "kernel time: " << kernel_time_ns * 1e-9 << " s" << endl;
   GraphBaseline(base_vid, vertices_baseline, edges);
   VLOG(10) << "vertices: ";
   for (auto v : vertices) {
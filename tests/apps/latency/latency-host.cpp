@@ -0,0 +1,58 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <frt.h>
+#include <gflags/gflags.h>
+
+#include "latency.h"
+
+using std::clog;
+using std::endl;
+using std::vector;
+
+DEFINE_string(bitstream, "", "path to bitstream file, run csim if empty");
+
+// Measures the host-side latency of invoking a kernel that does almost
+// nothing. With a bitstream, each iteration only updates the scalar argument
+// and relaunches the program, so the measured time is the launch overhead.
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags=*/true);
+
+  const uint64_t n = argc > 1 ? atoll(argv[1]) : 1000;
+  vector<uint64_t> out(1);
+  uint64_t num_errors = 0;
+
+  using clock = std::chrono::steady_clock;
+  auto tic = clock::now();
+  if (FLAGS_bitstream.empty()) {
+    for (uint64_t i = 0; i < n; ++i) {
+      tapa::invoke(Latency, FLAGS_bitstream,
+                   tapa::write_only_mmap<uint64_t>(out), i);
+      num_errors += out[0] != i;
+    }
+  } else {
+    fpga::Instance instance(FLAGS_bitstream);
+    instance.SetArg(0, fpga::ReadOnly(out.data(), out.size()));
+    for (uint64_t i = 0; i < n; ++i) {
+      instance.SetArg(1, i);
+      instance.Relaunch();
+      num_errors += out[0] != i;
+    }
+  }
+  const std::chrono::duration<double, std::micro> elapsed = clock::now() - tic;
+  clog << "launch latency: " << elapsed.count() / n << " us over " << n
+       << " invocations" << endl;
+
+  if (num_errors == 0) {
+    clog << "PASS!" << endl;
+  } else {
+    clog << num_errors << " invocations returned wrong values" << endl;
+    clog << "FAIL!" << endl;
+  }
+  return num_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,11 @@
+// Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+// All rights reserved. The contributor(s) of this file has/have agreed to the
+// RapidStream Contributor License Agreement.
+
+#include "latency.h"
+
+void Echo(uint64_t value, tapa::mmap<uint64_t> out) { out[0] = value; }
+
+void Latency(tapa::mmap<uint64_t> out, uint64_t value) {
+  tapa::task().invoke(Echo, value, out);
+}
@@ -0,0 +1,287 @@
+"""Keep a history of the QoR and run time of the regression designs.
+
+Each record of the history holds the metrics of one commit, keyed by
+`<design>/<metric>`, and is appended as a line of JSON to the history file,
+which CI can keep as an artifact or commit to the repository.  `compare`
+flags metrics of the latest record that are worse than the records before
+it by more than their usual noise.
+"""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import json
+import logging
+import statistics
+import subprocess
+import time
+from collections import defaultdict
+from dataclasses import dataclass
+from os import environ
+from pathlib import Path
+
+import click
+
+_logger = logging.getLogger(__name__)
+
+GITHUB_JOB_SUMMARY = environ.get("GITHUB_STEP_SUMMARY", "/tmp/github-job-summary")
+
+# Suffixes of metrics that are better when higher; others are better lower.
+_HIGHER_IS_BETTER = ("fmax_mhz", "per_s")
+
+
+def load_history(path: Path) -> list[dict]:
+    """Return the records in the history file at `path`, oldest first."""
+    if not path.exists():
+        return []
+    with open(path, encoding="utf-8") as fp:
+        return [json.loads(line) for line in fp if line.strip()]
+
+
+def append_record(path: Path, record: dict) -> None:
+    """Append `record` to the history file at `path`."""
+    path.parent.mkdir(parents=True, exist_ok=True)
+    with open(path, "a", encoding="utf-8") as fp:
+        fp.write(json.dumps(record, sort_keys=True) + "\n")
+
+
+def _split_named_path(value: str) -> tuple[str, Path]:
+    name, sep, path = value.partition("=")
+    if not sep:
+        msg = f"expected NAME=PATH, got '{value}'"
+        raise click.BadParameter(msg)
+    return name, Path(path)
+
+
+def get_regression_metrics(report: Path) -> dict[str, float]:
+    """Return the metrics in a report written by `run_regression.py --report`.
+
+    Designs that failed are left out, so that they do not skew the history.
+    """
+    with open(report, encoding="utf-8") as fp:
+        results = json.load(fp)
+    metrics = {}
+    for result in results:
+        if not result["passed"]:
+            _logger.warning("skipping %s, which failed", result["test"])
+            continue
+        for key in ("wall_time_s", "cpu_time_s", "peak_memory_bytes"):
+            metrics[f"{result['test']}/{key}"] = float(result[key])
+    return metrics
+
+
+def get_build_trace_metrics(name: str, trace: Path) -> dict[str, float]:
+    """Return the wall time and peak memory of each step in a build trace."""
+    with open(trace, encoding="utf-8") as fp:
+        events = json.load(fp)["traceEvents"]
+    metrics: dict[str, float] = defaultdict(float)
+    for event in events:
+        if event.get("cat") != "step":
+            continue
+        step = event["name"]
+        metrics[f"{name}/{step}_time_s"] += event["dur"] / 1e6
+        peak = float(event.get("args", {}).get("peak_memory", 0))
+        key = f"{name}/{step}_peak_memory_bytes"
+        metrics[key] = max(metrics[key], peak)
+    return dict(metrics)
+
+
+def get_qor_metrics(name: str, qor: Path) -> dict[str, float]:
+    """Return the metrics of each solution in a `report_qor.py --json` file."""
+    with open(qor, encoding="utf-8") as fp:
+        solutions = json.load(fp)
+    return {
+        f"{name}/{solution}/{key}": float(value)
+        for solution, values in solutions.items()
+        for key, value in values.items()
+    }
+
+
+def get_port_stats_metrics(name: str, port_stats: Path) -> dict[str, float]:
+    """Return the cycle count in a `port_stats.json` written by fast cosim."""
+    with open(port_stats, encoding="utf-8") as fp:
+        return {f"{name}/cosim_cycles": float(json.load(fp)["cycles"])}
+
+
+@dataclass
+class Regression:
+    metric: str
+    value: float
+    mean: float
+    stdev: float
+    samples: int
+
+    def __str__(self) -> str:
+        change = (self.value - self.mean) / self.mean if self.mean else 0
+        return (
+            f"{self.metric}: {self.value:g} vs. {self.mean:g} "
+            f"(stdev {self.stdev:g} over {self.samples} runs, {change:+.1%})"
+        )
+
+
+def find_regressions(
+    history: list[dict], window: int, sigma: float, min_change: float
+) -> list[Regression]:
+    """Return the metrics of the last record that regressed.
+
+    A metric regresses if it is worse than the mean of its last `window`
+    values before by more than `sigma` standard deviations of those values and
+    by more than `min_change` of the mean, so that neither noisy metrics nor
+    stable metrics with tiny changes are flagged.
+    """
+    if not history:
+        return []
+    *previous, latest = history
+    regressions = []
+    for metric, value in sorted(latest["metrics"].items()):
+        samples = [
+            record["metrics"][metric]
+            for record in previous
+            if metric in record["metrics"]
+        ][-window:]
+        if not samples:
+            continue
+        mean = statistics.fmean(samples)
+        stdev = statistics.stdev(samples) if len(samples) > 1 else 0.0
+        delta = value - mean
+        if metric.endswith(_HIGHER_IS_BETTER):
+            delta = -delta
+        if delta > sigma * stdev and delta > min_change * abs(mean):
+            regressions.append(Regression(metric, value, mean, stdev, len(samples)))
+    return regressions
+
+
+@click.group()
+def qor_history() -> None:
+    """Record and compare the QoR history of the regression designs."""
+
+
+@qor_history.command()
+@click.option(
+    "--history",
+    type=click.Path(dir_okay=False, path_type=Path),
+    required=True,
+    help="History file to append the record to.",
+)
+@click.option(
+    "--commit",
+    default=lambda: environ.get("GITHUB_SHA")
+    or subprocess.check_output(["git", "rev-parse", "HEAD"], text=True).strip(),
+    help="Commit of the record.  Defaults to the commit checked out.",
+)
+@click.option(
+    "--regression-report",
+    type=click.Path(exists=True, dir_okay=False, path_type=Path),
+    multiple=True,
+    help="Report written by `run_regression.py --report`.",
+)
+@click.option(
+    "--build-trace",
+    multiple=True,
+    metavar="NAME=PATH",
+    help="`build_trace.json` of a `tapa` run, recorded as the time per step.",
+)
+@click.option(
+    "--qor",
+    multiple=True,
+    metavar="NAME=PATH",
+    help="QoR written by `report_qor.py --json`.",
+)
+@click.option(
+    "--port-stats",
+    multiple=True,
+    metavar="NAME=PATH",
+    help="`port_stats.json` of a fast cosim run, recorded as its cycle count.",
+)
+@click.option(
+    "--metric",
+    multiple=True,
+    metavar="NAME=VALUE",
+    help="Any other metric, e.g., the csim wall time of an app.",
+)
+def record(  # noqa: PLR0913,PLR0917
+    history: Path,
+    commit: str,
+    regression_report: tuple[Path, ...],
+    build_trace: tuple[str, ...],
+    qor: tuple[str, ...],
+    port_stats: tuple[str, ...],
+    metric: tuple[str, ...],
+) -> None:
+    """Append the metrics of a commit to the history."""
+    metrics: dict[str, float] = {}
+    for report in regression_report:
+        metrics.update(get_regression_metrics(report))
+    for value in build_trace:
+        metrics.update(get_build_trace_metrics(*_split_named_path(value)))
+    for value in qor:
+        metrics.update(get_qor_metrics(*_split_named_path(value)))
+    for value in port_stats:
+        metrics.update(get_port_stats_metrics(*_split_named_path(value)))
+    for value in metric:
+        name, path = _split_named_path(value)
+        try:
+            metrics[name] = float(str(path))
+        except ValueError as e:
+            msg = f"expected NAME=VALUE, got '{value}'"
+            raise click.BadParameter(msg, param_hint="--metric") from e
+    if not metrics:
+        msg = "no metrics to record"
+        raise click.UsageError(msg)
+    append_record(
+        history, {"commit": commit, "timestamp": int(time.time()), "metrics": metrics}
+    )
+    _logger.info("recorded %d metrics of %s to %s", len(metrics), commit, history)
+
+
+@qor_history.command()
+@click.option(
+    "--history",
+    type=click.Path(exists=True, dir_okay=False, path_type=Path),
+    required=True,
+    help="History file whose last record is compared with the ones before.",
+)
+@click.option(
+    "--window",
+    type=click.IntRange(min=1),
+    default=10,
+    show_default=True,
+    help="Number of previous values of each metric to compare with.",
+)
+@click.option(
+    "--sigma",
+    type=click.FloatRange(min=0),
+    default=3.0,
+    show_default=True,
+    help="Standard deviations a metric must worsen by to be flagged.",
+)
+@click.option(
+    "--min-change",
+    type=click.FloatRange(min=0),
+    default=0.05,
+    show_default=True,
+    help="Fraction of its mean a metric must worsen by to be flagged.",
+)
+def compare(history: Path, window: int, sigma: float, min_change: float) -> None:
+    """Fail if the last record of the history regressed."""
+    records = load_history(history)
+    regressions = find_regressions(records, window, sigma, min_change)
+    with open(GITHUB_JOB_SUMMARY, "a", encoding="utf-8") as summary:
+        summary.write(f"\n\n## QoR history of {records[-1]['commit']}\n\n")
+        for regression in regressions:
+            summary.write(f"- Regressed {regression}\n")
+            _logger.error("regressed %s", regression)
+        if not regressions:
+            summary.write("No regression.\n")
+            _logger.info("no regression in %d metrics", len(records[-1]["metrics"]))
+    if regressions:
+        msg = f"{len(regressions)} metrics regressed"
+        raise click.ClickException(msg)
+
+
+if __name__ == "__main__":
+    logging.basicConfig(level=logging.INFO)
+    qor_history()  # pylint: disable=E1120
@@ -4,9 +4,11 @@ All rights reserved. The contributor(s) of this file has/have agreed to the
 RapidStream Contributor License Agreement.
 """
 
+import json
 import logging
 from glob import glob
 from os import environ
+from pathlib import Path
 
 import click
 
@@ -22,13 +24,27 @@ GITHUB_JOB_SUMMARY = environ.get("GITHUB_STEP_SUMMARY", "/tmp/github-job-summary
     help="The path to a (set of) run(s).",
     required=True,
 )
-def report_qor(run_dir: str) -> None:
+@click.option(
+    "--json",
+    "json_path",
+    type=click.Path(dir_okay=False),
+    help="Also write the QoRs of each solution to this JSON file, e.g., for "
+    "`qor_history.py record --qor`.",
+)
+def report_qor(run_dir: str, json_path: str | None) -> None:
     """Report the QoRs of an implemented design."""
-    report_freq(run_dir)
+    qor = report_freq(run_dir)
+    if json_path is not None:
+        with open(json_path, "w", encoding="utf-8") as json_f:
+            json.dump(qor, json_f, indent=2)
 
 
-def report_freq(run_dir: str) -> None:
-    """Report the Fmax of an implemented design."""
+def report_freq(run_dir: str) -> dict[str, dict[str, float]]:
+    """Report the Fmax of an implemented design.
+
+    Returns the Fmax of each solution in MHz, keyed by the solution name.
+    """
+    qor: dict[str, dict[str, float]] = {}
 
     _logger.warning("Regression metrics are stored in %s", GITHUB_JOB_SUMMARY)
 
@@ -98,6 +114,9 @@ def report_freq(run_dir: str) -> None:
             fmax = 1000 / ((1000 / target) - wns)
             log_f.write(f"Fmax: {fmax:.2f}\n")
             _logger.warning("Fmax: %.2f", fmax)
+            qor[Path(sol_dir).name] = {"fmax_mhz": fmax}
+
+    return qor
 
 
 if __name__ == "__main__":
@@ -0,0 +1,168 @@
+"""Run the regression designs concurrently and report their time and memory."""
+
+__copyright__ = """
+Copyright (c) 2024 RapidStream Design Automation, Inc. and contributors.
+All rights reserved. The contributor(s) of this file has/have agreed to the
+RapidStream Contributor License Agreement.
+"""
+
+import json
+import logging
+import os
+import subprocess
+import time
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+
+import click
+from psutil import virtual_memory
+
+from tapa.common.hls_memory import MemoryBudget, MemoryHistory, PeakMemoryMonitor
+
+_logger = logging.getLogger(__name__)
+
+REGRESSION_DIR = Path(__file__).resolve().parent.parent / "regression"
+
+# Script of each flow, relative to the directory of a regression design.
+_FLOW_SCRIPTS = {
+    "tapa": Path("tapa", "run_tapa.sh"),
+    "rapidstream": Path("rapidstream", "run_rs.sh"),
+}
+
+
+def find_tests(flow: str) -> dict[str, Path]:
+    """Return the scripts of `flow`, keyed by the design, e.g., `serpens-32ch`."""
+    script = _FLOW_SCRIPTS[flow]
+    return {
+        str(path.parent.parent.relative_to(REGRESSION_DIR)): path
+        for path in sorted(REGRESSION_DIR.glob(f"**/{script}"))
+    }
+
+
+@click.command()
+@click.argument("tests", nargs=-1)
+@click.option(
+    "--flow",
+    type=click.Choice(list(_FLOW_SCRIPTS)),
+    default="tapa",
+    help="Run `tapa/run_tapa.sh` or `rapidstream/run_rs.sh` of each design.",
+)
+@click.option(
+    "--jobs",
+    type=click.IntRange(min=1),
+    default=os.cpu_count(),
+    help="Maximum number of designs that run at the same time.",
+)
+@click.option(
+    "--memory-budget",
+    type=click.FloatRange(min=0, min_open=True),
+    default=None,
+    help=(
+        "Memory in GiB that concurrent designs may use, estimated from their "
+        "previous runs.  Defaults to the available memory."
+    ),
+)
+@click.option(
+    "--hls-cache-dir",
+    type=click.Path(file_okay=False, resolve_path=True),
+    default=str(REGRESSION_DIR / ".hls-cache"),
+    help=(
+        "HLS cache shared by all designs as `TAPA_HLS_CACHE_DIR`, so that tasks "
+        "that several designs have in common are synthesized once.  The peak "
+        "memory of each design is also kept there for the next runs."
+    ),
+)
+@click.option(
+    "--report",
+    type=click.Path(dir_okay=False, writable=True),
+    default=None,
+    help="Write the time and resource usage of each design to this JSON file.",
+)
+def run_regression(  # noqa: PLR0913,PLR0917
+    tests: tuple[str, ...],
+    flow: str,
+    jobs: int,
+    memory_budget: float | None,
+    hls_cache_dir: str,
+    report: str | None,
+) -> None:
+    """Run the regression designs TESTS, or all of them, as one set of jobs.
+
+    Each design runs its script in its own directory, with its output logged
+    to `regression.log` there.  Designs start as soon as a job slot is free
+    and their memory usage, estimated from their last run, fits in the budget.
+    """
+    all_tests = find_tests(flow)
+    unknown = sorted(set(tests) - set(all_tests))
+    if unknown:
+        msg = f"unknown tests: {', '.join(unknown)}; choose from {list(all_tests)}"
+        raise click.BadParameter(msg, param_hint="TESTS")
+    scripts = {test: all_tests[test] for test in tests or all_tests}
+
+    Path(hls_cache_dir).mkdir(parents=True, exist_ok=True)
+    env = {**os.environ, "TAPA_HLS_CACHE_DIR": hls_cache_dir}
+    budget = MemoryBudget(
+        int(memory_budget * (1 << 30)) if memory_budget else virtual_memory().available
+    )
+    history = MemoryHistory(Path(hls_cache_dir, f"regression-{flow}-memory.json"))
+
+    def run(test: str) -> dict:
+        script = scripts[test]
+        log_path = script.parent / "regression.log"
+        with budget.reserve(history.estimate(test)):
+            _logger.info("running %s", test)
+            start = time.monotonic()
+            with (
+                open(log_path, "wb") as log,
+                subprocess.Popen(
+                    ["bash", script.name],
+                    cwd=script.parent,
+                    env=env,
+                    stdout=log,
+                    stderr=subprocess.STDOUT,
+                ) as proc,
+                PeakMemoryMonitor(proc.pid) as monitor,
+            ):
+                returncode = proc.wait()
+            wall_time = time.monotonic() - start
+        if monitor.peak > 0:  # Not sampled if the script exits right away.
+            history.update(test, monitor.peak)
+        result = {
+            "test": test,
+            "passed": returncode == 0,
+            "wall_time_s": round(wall_time, 1),
+            "cpu_time_s": round(monitor.cpu_time, 1),
+            "peak_memory_bytes": monitor.peak,
+            "log": str(log_path),
+        }
+        if returncode == 0:
+            _logger.info("%s passed in %.0f s", test, wall_time)
+        else:
+            _logger.error("%s failed; see %s", test, log_path)
+        return result
+
+    with ThreadPoolExecutor(max_workers=jobs) as executor:
+        results = list(executor.map(run, scripts))
+
+    for result in results:
+        _logger.info(
+            "%-40s %s %8.0f s wall %8.0f s cpu %6.1f GiB",
+            result["test"],
+            "PASS" if result["passed"] else "FAIL",
+            result["wall_time_s"],
+            result["cpu_time_s"],
+            result["peak_memory_bytes"] / (1 << 30),
+        )
+    if report is not None:
+        with open(report, "w", encoding="utf-8") as report_f:
+            json.dump(results, report_f, indent=2)
+
+    failed = [result["test"] for result in results if not result["passed"]]
+    if failed:
+        msg = f"failed tests: {', '.join(failed)}"
+        raise click.ClickException(msg)
+
+
+if __name__ == "__main__":
+    logging.basicConfig(level=logging.INFO)
+    run_regression()  # pylint: disable=E1120